@@ -121,6 +121,8 @@ class GeneratorBase:
     self.test_helpers = []   # $ {test_deps} \setminus {test_progs} $
     self.bdb_test_deps = []  # BDB-dependent items to build for the tests
     self.bdb_test_progs = [] # Subset of the above to actually execute
+    self.serf_test_deps = []  # Serf-dependent items to build for the tests
+    self.serf_test_progs = [] # Subset of the above to actually execute
     self.target_dirs = []    # Directories in which files are built
     self.manpages = []       # Manpages
 
@@ -676,6 +678,10 @@ class TargetExe(TargetLinked):
       self.gen_obj.bdb_test_deps.append(self.filename)
       if self.testing != 'skip':
         self.gen_obj.bdb_test_progs.append(self.filename)
+    elif self.install == 'serf-test':
+      self.gen_obj.serf_test_deps.append(self.filename)
+      if self.testing != 'skip':
+        self.gen_obj.serf_test_progs.append(self.filename)
 
     self.gen_obj.manpages.extend(self.manpages.split())
 
@@ -147,6 +147,8 @@ class Generator(gen_base.GeneratorBase):
     # deps = all, progs = not including those marked "testing = skip"
     data.bdb_test_deps = self.bdb_test_deps + self.bdb_scripts
     data.bdb_test_progs = self.bdb_test_progs + self.bdb_scripts
+    data.serf_test_deps = self.serf_test_deps
+    data.serf_test_progs = self.serf_test_progs
     data.test_deps = self.test_deps + self.scripts
     data.test_progs = self.test_progs + self.scripts
     data.test_helpers = self.test_helpers
@@ -407,7 +409,7 @@ class Generator(gen_base.GeneratorBase):
                           fullname=file.filename, dirname=dirname,
                           name=name, filename=fname, when=file.when)
 
-      if area != 'test' and area != 'bdb-test':
+      if area != 'test' and area != 'bdb-test' and area != 'serf-test':
         data.areas.append(ezt_area)
 
         area_var = area.replace('-', '_')
@@ -201,9 +201,11 @@ class WinGeneratorBase(gen_win_dependencies.GenDependenciesBase):
       install_targets = [x for x in install_targets if not (isinstance(x, gen_base.TargetExe)
                                                             and x.install == 'bdb-test')]
 
-    # Drop the ra_serf target if we don't have serf
+    # Drop the ra_serf target and tests if we don't have serf
     if 'serf' not in self._libraries:
       install_targets = [x for x in install_targets if x.name != 'libsvn_ra_serf']
+      install_targets = [x for x in install_targets if not (isinstance(x, gen_base.TargetExe)
+                                                            and x.install == 'serf-test')]
 
     # Drop the swig targets if we don't have swig or language support
     install_targets = [x for x in install_targets
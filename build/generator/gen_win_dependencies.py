@@ -120,6 +120,7 @@ class GenDependenciesBase(gen_base.GeneratorBase):
         'ruby',
         'java_sdk',
         'openssl',
+        'libcrypto',
         'apr_memcache',
 
         # So optional, we don't even have any code to detect them on Windows
@@ -888,12 +889,19 @@ class GenDependenciesBase(gen_base.GeneratorBase):
       libssl = 'ssleay32'
       versuffix = ''
 
+    # The svns:// support in ra_svn needs the OpenSSL 1.1.0 API
+    if version >= (1, 1, 0):
+      defines = ['SVN_HAVE_OPENSSL']
+    else:
+      defines = []
+
     self._libraries['openssl'] = SVNCommonLibrary('openssl', inc_dir, lib_dir,
                                                   '%s.lib' % (libssl,),
                                                   openssl_version,
                                                   dll_name='%s%s.dll' %
                                                       (libssl, versuffix),
-                                                  dll_dir=bin_dir)
+                                                  dll_dir=bin_dir,
+                                                  defines=defines)
 
     self._libraries['libcrypto'] = SVNCommonLibrary('openssl', inc_dir, lib_dir,
                                                     '%s.lib' % (libcrypto,),
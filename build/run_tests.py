@@ -27,6 +27,7 @@
             [--verbose] [--log-to-stdout] [--cleanup] [--bin=<path>]
             [--parallel | --parallel=<n>] [--global-scheduler]
             [--url=<base-url>] [--http-library=<http-library>] [--enable-sasl]
+            [--http-protocol=<http/1.1|h2>]
             [--fs-type=<fs-type>] [--fsfs-packing] [--fsfs-sharding=<n>]
             [--list] [--milestone-filter=<regex>] [--mode-filter=<type>]
             [--server-minor-version=<version>] [--http-proxy=<host>:<port>]
@@ -241,6 +242,8 @@ class TestHarness:
       cmdline.append('--fs-type=%s' % self.opts.fs_type)
     if self.opts.http_library is not None:
       cmdline.append('--http-library=%s' % self.opts.http_library)
+    if self.opts.http_protocol is not None:
+      cmdline.append('--http-protocol=%s' % self.opts.http_protocol)
     if self.opts.fsfs_sharding is not None:
       cmdline.append('--fsfs-sharding=%d' % self.opts.fsfs_sharding)
     if self.opts.fsfs_packing is not None:
@@ -985,6 +988,8 @@ def create_parser():
                     help='Run tests from all scripts together')
   parser.add_option('--http-library', action='store',
                     help="Make svn use this DAV library (neon or serf)")
+  parser.add_option('--http-protocol', action='store',
+                    help="Make svn talk this HTTP protocol (http/1.1 or h2)")
   parser.add_option('--bin', action='store', dest='svn_bin',
                     help='Use the svn binaries installed in this path')
   parser.add_option('--fsfs-sharding', action='store', type='int',
@@ -29,6 +29,8 @@
 
 #include <httpd.h>
 
+#include "svn_types.h"
+
 #ifdef __cplusplus
 extern "C" {
 #endif /* __cplusplus */
@@ -54,6 +56,28 @@ typedef int (*authz_svn__subreq_bypass_func_t)(request_rec *r,
                                               const char *repos_path,
                                               const char *repos_name);
 
+/** Provider name for batch subrequest bypass */
+#define AUTHZ_SVN__SUBREQ_BYPASS_BATCH_PROV_NAME \
+          "mod_authz_svn_subreq_bypass_batch"
+/** Provider version for batch subrequest bypass */
+#define AUTHZ_SVN__SUBREQ_BYPASS_BATCH_PROV_VER "00.00a"
+/** Provider to allow mod_dav_svn to check GET access to multiple paths
+ * at once, e.g. to all entries of a directory.
+ *
+ * Like #authz_svn__subreq_bypass_func_t but checks all paths in
+ * @a repos_paths (an array of <tt>const char *</tt>) and sets the i-th
+ * element of @a allowed to @c TRUE if access is granted to the i-th path.
+ * @a allowed must provide room for @a repos_paths->nelts elements.
+ *
+ * Returns @c OK if the paths could be checked and @c HTTP_FORBIDDEN if
+ * they could not, in which case the contents of @a allowed are undefined.
+ */
+typedef int (*authz_svn__subreq_bypass_batch_func_t)(
+                                       request_rec *r,
+                                       const apr_array_header_t *repos_paths,
+                                       const char *repos_name,
+                                       svn_boolean_t *allowed);
+
 #ifdef __cplusplus
 }
 #endif /* __cplusplus */
@@ -55,6 +55,23 @@ extern "C" {
 #define SVN_DAV__OLD_VALUE "old-value"
 #define SVN_DAV__OLD_VALUE__ABSENT "absent"
 
+/** Name of the update-report request element with which a client asks
+    for binary (non-base64) txdelta transmission in send-all mode.  */
+#define SVN_DAV__BINARY_TXDELTA "binary-txdelta"
+
+/** Content type of an update report response that carries binary
+    txdeltas.  A server that honors SVN_DAV__BINARY_TXDELTA sends this
+    instead of text/xml, since the body is no longer a valid XML
+    document.  */
+#define SVN_DAV__FRAMED_REPORT_MIME_TYPE "application/vnd.svn-framed-report"
+
+/** In a framed update report, raw svndiff data for the open S:txdelta
+    element is sent inline as frames: this marker byte (which can never
+    occur in an XML document), a 4-byte big-endian payload length, and
+    the payload itself.  */
+#define SVN_DAV__BINARY_FRAME_MARKER '\0'
+#define SVN_DAV__BINARY_FRAME_HEADER_LEN 5
+
 /** Helper typedef for svn_ra_change_rev_prop2() implementation. */
 typedef struct svn_dav__two_props_t {
   const svn_string_t *const *old_value_p;
@@ -27,9 +27,11 @@
 
 #include <apr_pools.h>
 #include <apr_tables.h>
+#include <apr_hash.h>
 
 #include "svn_types.h"
 #include "svn_io.h"
+#include "svn_diff.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -148,6 +150,128 @@ svn_diff_hunk__create_deletes_single_line(svn_diff_hunk_t **hunk,
 svn_linenum_t
 svn_diff_hunk__get_fuzz_penalty(const svn_diff_hunk_t *hunk);
 
+
+/* The revision responsible for a chunk of blamed lines. */
+typedef struct svn_diff__blame_rev_t
+{
+  svn_revnum_t revision; /* the revision number */
+  apr_hash_t *rev_props; /* the revision properties */
+  /* Used for merge reporting. */
+  const char *path;      /* the absolute repository path */
+} svn_diff__blame_rev_t;
+
+/* One chunk of blame: the lines from token START up to the START of
+ * NEXT, attributed to REV.  REV may be NULL. */
+typedef struct svn_diff__blame_chunk_t
+{
+  const svn_diff__blame_rev_t *rev; /* the responsible revision */
+  apr_off_t start;                  /* the starting diff-token (line) */
+  struct svn_diff__blame_chunk_t *next; /* the next chunk */
+} svn_diff__blame_chunk_t;
+
+/* A chain of blame chunks, covering all lines of one fulltext. */
+typedef struct svn_diff__blame_chain_t
+{
+  svn_diff__blame_chunk_t *blame; /* linked list of blame chunks */
+  svn_diff__blame_chunk_t *avail; /* linked list of free blame chunks */
+  apr_pool_t *pool;               /* Allocate members from this pool. */
+} svn_diff__blame_chain_t;
+
+/* Return a new, empty blame chain allocated in RESULT_POOL. */
+svn_diff__blame_chain_t *
+svn_diff__blame_chain_create(apr_pool_t *result_pool);
+
+/* Return a blame chunk of CHAIN associated with REV for a change starting
+ * at token START.  The chunk is not linked into CHAIN yet. */
+svn_diff__blame_chunk_t *
+svn_diff__blame_chunk_create(svn_diff__blame_chain_t *chain,
+                             const svn_diff__blame_rev_t *rev,
+                             apr_off_t start);
+
+/* Update CHAIN with DIFF, the diff between the fulltext CHAIN describes
+ * and its successor, attributing all modified lines to REV. */
+svn_error_t *
+svn_diff__blame_chain_apply(svn_diff__blame_chain_t *chain,
+                            svn_diff_t *diff,
+                            const svn_diff__blame_rev_t *rev,
+                            svn_cancel_func_t cancel_func,
+                            void *cancel_baton);
+
+/* Add the blame for the changes between LAST_FILE and CUR_FILE to CHAIN,
+ * attributing them to REV.  If LAST_FILE is NULL, CHAIN must be empty and
+ * every line of CUR_FILE gets attributed to REV.
+ *
+ * Compare the files using DIFF_OPTIONS.  Use SCRATCH_POOL for temporary
+ * allocations.
+ */
+svn_error_t *
+svn_diff__blame_chain_add_file(svn_diff__blame_chain_t *chain,
+                               const svn_diff__blame_rev_t *rev,
+                               const char *last_file,
+                               const char *cur_file,
+                               const svn_diff_file_options_t *diff_options,
+                               svn_cancel_func_t cancel_func,
+                               void *cancel_baton,
+                               apr_pool_t *scratch_pool);
+
+/* The blame of a single line of history, built from subsequent fulltexts.
+ * This is what servers use to annotate a file for their clients. */
+typedef struct svn_diff__file_blame_t svn_diff__file_blame_t;
+
+/* Callback type used with svn_diff__file_blame_report().  It gets invoked
+ * for every line, in ascending order of LINE_NO, which starts at 0.
+ * LINE is the line contents without line terminator.  REVISION and
+ * REV_PROPS describe the revision that last changed the line; REVISION is
+ * SVN_INVALID_REVNUM and REV_PROPS is NULL if that is not known.
+ */
+typedef svn_error_t *(*svn_diff__blame_line_func_t)(void *baton,
+                                                    apr_int64_t line_no,
+                                                    svn_revnum_t revision,
+                                                    apr_hash_t *rev_props,
+                                                    const char *line,
+                                                    apr_pool_t *scratch_pool);
+
+/* Return a new, empty file blame in *BLAME, allocated in RESULT_POOL.
+ * The fulltexts added to it will be compared using DIFF_OPTIONS, which
+ * may be NULL for the defaults.
+ */
+svn_error_t *
+svn_diff__file_blame_create(svn_diff__file_blame_t **blame,
+                            const svn_diff_file_options_t *diff_options,
+                            svn_cancel_func_t cancel_func,
+                            void *cancel_baton,
+                            apr_pool_t *result_pool);
+
+/* Add the next fulltext of the file to the svn_diff__file_blame_t BATON.
+ * FILENAME contains the fulltext created by REVISION with REV_PROPS.  All
+ * lines changed since the previous fulltext get attributed to REVISION,
+ * which may be SVN_INVALID_REVNUM for changes that shall not be blamed
+ * on anyone.
+ *
+ * FILENAME must remain available until the next fulltext has been added
+ * or, for the last one, until svn_diff__file_blame_report() returns.
+ *
+ * Use SCRATCH_POOL for temporary allocations.  This has the signature of
+ * svn_repos__fulltext_func_t.
+ */
+svn_error_t *
+svn_diff__file_blame_add(void *baton,
+                         svn_revnum_t revision,
+                         apr_hash_t *rev_props,
+                         const char *filename,
+                         apr_pool_t *scratch_pool);
+
+/* Report the lines of the last fulltext added to BLAME, together with the
+ * revisions responsible for them, to RECEIVER with RECEIVER_BATON.  The
+ * line endings are normalized.  Report nothing if no fulltext has been
+ * added.  Use SCRATCH_POOL for temporary allocations.
+ */
+svn_error_t *
+svn_diff__file_blame_report(svn_diff__file_blame_t *blame,
+                            svn_diff__blame_line_func_t receiver,
+                            void *receiver_baton,
+                            apr_pool_t *scratch_pool);
+
 #ifdef __cplusplus
 }
 #endif /* __cplusplus */
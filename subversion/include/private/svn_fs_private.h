@@ -211,6 +211,35 @@ svn_fs__get_deleted_node(svn_fs_root_t **node_root,
                          apr_pool_t *result_pool,
                          apr_pool_t *scratch_pool);
 
+/**
+ * Give direct access to the delta turning the contents of the file at
+ * @a source_path under @a source_root into those of the file at
+ * @a target_path under @a target_root, e.g. to forward it to a client
+ * without decoding and re-encoding it.
+ *
+ * If the back-end stores the target contents as svndiff data against
+ * exactly the source contents, set @a *file to a new handle for the file
+ * containing that data and return its position and length (including the
+ * svndiff header) in @a *offset and @a *length, and the svndiff format
+ * version in @a *svndiff_version.  Otherwise, set @a *file to NULL and
+ * leave the other outputs untouched.
+ *
+ * @a *file is open for reading only; its file position is unspecified.
+ * It gets closed when @a result_pool is cleaned up.  Use @a scratch_pool
+ * for temporaries.
+ */
+svn_error_t *
+svn_fs__open_stored_delta(apr_file_t **file,
+                          apr_off_t *offset,
+                          svn_filesize_t *length,
+                          int *svndiff_version,
+                          svn_fs_root_t *source_root,
+                          const char *source_path,
+                          svn_fs_root_t *target_root,
+                          const char *target_path,
+                          apr_pool_t *result_pool,
+                          apr_pool_t *scratch_pool);
+
 
 /** @} */
 
@@ -135,6 +135,34 @@ svn_stream__from_aprfile(apr_file_t *file,
                          svn_boolean_t truncate_on_seek,
                          apr_pool_t *pool);
 
+/* Return a stream that passes all data read from or written to STREAM
+   through unchanged while calculating COUNT checksums of the kinds given
+   in KINDS over it.  All checksums and the byte count are updated in a
+   single pass over each buffer, so this replaces stacking several
+   svn_stream_checksummed2() streams plus a size counting wrapper.
+
+   When the stream is closed, *CHECKSUMS[i] is set to the resulting
+   checksum of kind KINDS[i] and, if SIZE is not NULL, *SIZE to the number
+   of bytes that passed through.  The KINDS and CHECKSUMS arrays are copied
+   and need not outlive this call, while the locations CHECKSUMS[i] and
+   SIZE point to must remain valid until the stream has been closed.
+
+   Data should either be read or written; mixing both directions will
+   produce checksums over the combined data.  If READ_ALL is TRUE, all
+   remaining data will be read from STREAM (and checksummed) when the
+   returned stream is closed.  STREAM gets closed along with the returned
+   stream.  The latter supports reset if STREAM does.
+
+   Allocate the stream and the resulting checksums in POOL. */
+svn_stream_t *
+svn_stream__checksummed(svn_stream_t *stream,
+                        svn_checksum_t **checksums[],
+                        const svn_checksum_kind_t kinds[],
+                        int count,
+                        svn_filesize_t *size,
+                        svn_boolean_t read_all,
+                        apr_pool_t *pool);
+
 #if defined(WIN32)
 
 /* ### Move to something like io.h or subr.h, to avoid making it
@@ -264,6 +264,15 @@ svn_log__list(const char *path, svn_revnum_t revision,
               apr_array_header_t *patterns, svn_depth_t depth,
               apr_uint32_t dirent_fields, apr_pool_t *pool);
 
+/**
+ * Return a log string for a blame action.
+ *
+ * @since New in 1.12.
+ */
+const char *
+svn_log__blame(const char *path, svn_revnum_t start, svn_revnum_t end,
+               apr_pool_t *pool);
+
 #ifdef __cplusplus
 }
 #endif /* __cplusplus */
@@ -82,6 +82,19 @@ svn_object_pool__create(svn_object_pool__t **object_pool,
                         svn_boolean_t thread_safe,
                         apr_pool_t *pool);
 
+/* Like svn_object_pool__create but instead of dropping unused objects
+ * whenever they make up about half of the pool, keep up to MAX_UNUSED of
+ * them and evict the least recently used ones first.  This makes sense
+ * for objects that are expensive to create and are likely to be asked
+ * for again after their last reference got released.  A MAX_UNUSED of 0
+ * selects the default behavior.
+ */
+svn_error_t *
+svn_object_pool__create2(svn_object_pool__t **object_pool,
+                         svn_boolean_t thread_safe,
+                         apr_size_t max_unused,
+                         apr_pool_t *pool);
+
 /* Return a pool to allocate the new object.
  */
 apr_pool_t *
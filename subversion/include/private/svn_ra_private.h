@@ -154,6 +154,60 @@ svn_ra__release_operational_lock(svn_ra_session_t *session,
                                  const svn_string_t *mylocktoken,
                                  apr_pool_t *scratch_pool);
 
+
+/*** Batched node retrieval ***/
+
+/** One node to fetch with svn_ra__get_nodes().
+ *
+ * @since New in 1.12.
+ */
+typedef struct svn_ra__node_request_t
+{
+  /** The path of the node, relative to the session URL. */
+  const char *path;
+
+  /** The kind of the node, either #svn_node_dir or #svn_node_file. */
+  svn_node_kind_t kind;
+
+  /** Set to the entries of the directory, if requested. */
+  apr_hash_t *dirents;
+
+  /** Set to the properties of the node, if requested. */
+  apr_hash_t *props;
+
+} svn_ra__node_request_t;
+
+/** Fetch the properties (if @a want_props is TRUE) and, for directories,
+ * the entries (if @a want_dirents is TRUE) of each node in @a requests,
+ * an array of #svn_ra__node_request_t *, in @a revision.  Entries contain
+ * at least the fields in @a dirent_fields.
+ *
+ * This is equivalent to calling svn_ra_get_dir2() or svn_ra_get_file()
+ * for each request in turn, but RA layers that can do so will submit the
+ * requests without waiting for each response.  All requests are processed
+ * even if some of them fail; the results of failed requests are left NULL
+ * and the error of the first failed request is returned.
+ *
+ * An error that leaves @a session unusable, such as a broken ra_svn
+ * connection, ends the processing right away.  The ra_svn layer returns
+ * those as #SVN_ERR_RA_SVN_CONNECTION_CLOSED, #SVN_ERR_RA_SVN_IO_ERROR or
+ * #SVN_ERR_RA_SVN_MALFORMED_DATA.
+ *
+ * @a revision must be a valid revision number.  Allocate the results in
+ * @a result_pool and use @a scratch_pool for temporary allocations.
+ *
+ * @since New in 1.12.
+ */
+svn_error_t *
+svn_ra__get_nodes(svn_ra_session_t *session,
+                  apr_array_header_t *requests,
+                  svn_revnum_t revision,
+                  svn_boolean_t want_dirents,
+                  svn_boolean_t want_props,
+                  apr_uint32_t dirent_fields,
+                  apr_pool_t *result_pool,
+                  apr_pool_t *scratch_pool);
+
 /** Register CALLBACKS to be used with the Ev2 shims in RA_SESSION. */
 svn_error_t *
 svn_ra__register_editor_shim_callbacks(svn_ra_session_t *ra_session,
@@ -146,6 +146,38 @@ svn_ra_svn__set_shim_callbacks(svn_ra_svn_conn_t *conn,
 apr_pool_t *
 svn_ra_svn__get_pool(svn_ra_svn_conn_t *conn);
 
+/**
+ * Server-side TLS configuration, shared by all connections that a server
+ * accepts.
+ */
+typedef struct svn_ra_svn__tls_server_t svn_ra_svn__tls_server_t;
+
+/**
+ * Load the PEM encoded certificate chain from @a cert_file and the
+ * matching private key from @a key_file and return a TLS server
+ * configuration using them in @a *server.  The server will issue
+ * session tickets that any connection accepted with @a *server, including
+ * those handled by forked processes, can resume.  Allocate the result
+ * in @a result_pool.
+ *
+ * Return #SVN_ERR_UNSUPPORTED_FEATURE if TLS support is not available.
+ */
+svn_error_t *
+svn_ra_svn__tls_server_create(svn_ra_svn__tls_server_t **server,
+                              const char *cert_file,
+                              const char *key_file,
+                              apr_pool_t *result_pool);
+
+/**
+ * Perform the server side of a TLS handshake on the freshly created
+ * connection @a conn and encrypt all further traffic on it, using the
+ * configuration in @a server.  Use @a scratch_pool for temporaries.
+ */
+svn_error_t *
+svn_ra_svn__tls_accept(svn_ra_svn_conn_t *conn,
+                       svn_ra_svn__tls_server_t *server,
+                       apr_pool_t *scratch_pool);
+
 /**
  * @defgroup ra_svn_deprecated ra_svn low-level functions
  * @{
@@ -335,6 +367,17 @@ svn_ra_svn__read_tuple(svn_ra_svn_conn_t *conn,
                        apr_pool_t *pool,
                        const char *fmt, ...);
 
+/** Like svn_ra_svn__read_tuple(), but strings that have been received
+ * completely into the connection's read buffer are referenced in place
+ * instead of being copied into @a pool.  Such strings remain valid only
+ * until the next read from @a conn, so this must only be used when the
+ * parsed values are not needed beyond that point.
+ */
+svn_error_t *
+svn_ra_svn__read_tuple_transient(svn_ra_svn_conn_t *conn,
+                                 apr_pool_t *pool,
+                                 const char *fmt, ...);
+
 /** Parse an array of @c svn_ra_svn__item_t structures as a list of
  * properties, storing the properties in a hash table.
  *
@@ -773,6 +816,10 @@ svn_ra_svn__write_cmd_get_file(svn_ra_svn_conn_t *conn,
 /** Send a "update" command over connection @a conn.
  * Use @a pool for allocations.
  *
+ * If @a text_deltas is FALSE, ask the server to omit file contents from
+ * the editor drive.  Only do that if the server announced the
+ * #SVN_RA_SVN_CAP_SKELTA capability.
+ *
  * @see #svn_ra_do_update3 for a description.
  */
 svn_error_t *
@@ -783,7 +830,8 @@ svn_ra_svn__write_cmd_update(svn_ra_svn_conn_t *conn,
                              svn_boolean_t recurse,
                              svn_depth_t depth,
                              svn_boolean_t send_copyfrom_args,
-                             svn_boolean_t ignore_ancestry);
+                             svn_boolean_t ignore_ancestry,
+                             svn_boolean_t text_deltas);
 
 /** Send a "switch" command over connection @a conn.
  * Use @a pool for allocations.
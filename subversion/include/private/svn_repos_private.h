@@ -176,6 +176,28 @@ svn_repos__get_logs_compat(svn_repos_t *repos,
                            void *receiver_baton,
                            apr_pool_t *pool);
 
+/**
+ * Bring the log index of the repository filesystem @a fs up to date with
+ * all revisions in @a fs.  If there is no log index yet, create one if
+ * @a create is TRUE and do nothing otherwise.  If @a max_revisions is
+ * positive, add no more than that many revisions to the index and leave
+ * the rest to a later call.
+ *
+ * The log index speeds up walking the history of individual paths, e.g.
+ * for svn_repos_get_logs5() and svn_repos_history2().  Once created, it is
+ * updated automatically by svn_repos_fs_commit_txn().
+ *
+ * Use @a cancel_func and @a cancel_baton for cancellation, and
+ * @a scratch_pool for temporary allocations.
+ */
+svn_error_t *
+svn_repos__log_index_sync(svn_fs_t *fs,
+                          svn_boolean_t create,
+                          int max_revisions,
+                          svn_cancel_func_t cancel_func,
+                          void *cancel_baton,
+                          apr_pool_t *scratch_pool);
+
 /**
  * @defgroup svn_config_pool Configuration object pool API
  * @{
@@ -228,6 +250,112 @@ svn_repos__config_pool_get(svn_config_t **cfg,
 
 /** @} */
 
+/* Settings for the process-wide authz caches.
+ */
+typedef struct svn_repos__authz_cache_config_t
+{
+  /* Directory in which compiled authz models get stored, so that other
+   * processes and later instances of this one don't need to parse the
+   * same authz rules again.  Files in there are named after the checksum
+   * of the authz rules they were compiled from.  NULL disables the
+   * on-disk cache. */
+  const char *cache_dir;
+
+  /* Number of per-user filtered rule trees to keep even if they are
+   * currently not in use.  0 selects the default. */
+  apr_size_t filtered_tree_count;
+} svn_repos__authz_cache_config_t;
+
+/* Set the authz cache configuration to a copy of SETTINGS.
+ * SETTINGS->CACHE_DIR must remain valid as long as the authz caches get
+ * used.  The FILTERED_TREE_COUNT only has an effect if this is being
+ * called before svn_repos_authz_initialize().
+ */
+void
+svn_repos__authz_cache_config_set(
+  const svn_repos__authz_cache_config_t *settings);
+
+/* Like svn_repos_authz_check_access() but check REQUIRED_ACCESS for all
+ * PATHS (an array of const char * repository paths, elements may be NULL)
+ * at once and set ACCESS_GRANTED[i] for the i-th element of PATHS.
+ * ACCESS_GRANTED must provide room for PATHS->NELTS elements.
+ *
+ * The user's rules get filtered at most once and the paths are being
+ * looked up in sorted order, such that all entries of a directory share
+ * a single walk down to their parent.  Use SCRATCH_POOL for temporary
+ * allocations.
+ */
+svn_error_t *
+svn_repos__authz_check_access_many(svn_authz_t *authz,
+                                   const char *repos_name,
+                                   const apr_array_header_t *paths,
+                                   const char *user,
+                                   svn_repos_authz_access_t required_access,
+                                   svn_boolean_t *access_granted,
+                                   apr_pool_t *scratch_pool);
+
+/* Batch version of svn_repos_authz_func_t: For each const char * path in
+ * PATHS, set ALLOWED[i] to TRUE iff the i-th path in ROOT is readable.
+ * ALLOWED provides room for PATHS->NELTS elements.  BATON is the same as
+ * for the per-path callback.  Use SCRATCH_POOL for temporary allocations.
+ */
+typedef svn_error_t *
+(*svn_repos__authz_batch_func_t)(svn_boolean_t *allowed,
+                                 svn_fs_root_t *root,
+                                 const apr_array_header_t *paths,
+                                 void *baton,
+                                 apr_pool_t *scratch_pool);
+
+/* Header of an authz read baton that supports batch lookups.
+ *
+ * Servers that put this structure at the start of their authz read baton
+ * and pass svn_repos__authz_batch_read_func() as authz read function
+ * allow update reports, svn_repos_list() and log to check whole sets of
+ * paths with a single call to BATCH_FUNC.  Both callbacks receive the
+ * pointer to the enclosing baton.
+ */
+typedef struct svn_repos__authz_batch_baton_t
+{
+  /* Per-path authz read callback. */
+  svn_repos_authz_func_t read_func;
+
+  /* Callback checking multiple paths at once. */
+  svn_repos__authz_batch_func_t batch_func;
+} svn_repos__authz_batch_baton_t;
+
+/* Implements svn_repos_authz_func_t by forwarding to the READ_FUNC in
+ * BATON, which must point to a svn_repos__authz_batch_baton_t.
+ */
+svn_error_t *
+svn_repos__authz_batch_read_func(svn_boolean_t *allowed,
+                                 svn_fs_root_t *root,
+                                 const char *path,
+                                 void *baton,
+                                 apr_pool_t *pool);
+
+/* The maximum number of delta threads a single report will use. */
+#define SVN_REPOS__MAX_DELTA_THREADS 16
+
+/* Let the report REPORT_BATON, as returned by svn_repos_begin_report3(),
+ * calculate file text deltas on up to THREADS worker threads ahead of
+ * the editor drive.  The editor is still being driven from the calling
+ * thread and in the same order as before.  Values below 2 disable the
+ * prefetching, which is also the default.  THREADS is capped at
+ * #SVN_REPOS__MAX_DELTA_THREADS, and all reports of the process together
+ * use a limited number of threads and FS instances; reports that find
+ * none available calculate their deltas inline.
+ *
+ * If text deltas are not requested, the workers read the target
+ * fulltexts instead, so that the FS caches can serve them when the
+ * client fetches them.  Has no effect if APR has been built without
+ * thread support.
+ *
+ * This must be called before svn_repos_finish_report().
+ */
+void
+svn_repos__report_set_delta_threads(void *report_baton,
+                                    int threads);
+
 /* Adjust mergeinfo paths and revisions in ways that are useful when loading
  * a dump stream.
  *
@@ -388,6 +516,52 @@ svn_repos__get_dump_editor(const svn_delta_editor_t **editor,
                            const char *update_anchor_relpath,
                            apr_pool_t *pool);
 
+/* Callback type used with svn_repos__get_blame_fulltexts().  FILENAME
+ * contains the fulltext of the file in REVISION, which has REV_PROPS.
+ * Use SCRATCH_POOL for temporary allocations.
+ */
+typedef svn_error_t *(*svn_repos__fulltext_func_t)(void *baton,
+                                                   svn_revnum_t revision,
+                                                   apr_hash_t *rev_props,
+                                                   const char *filename,
+                                                   apr_pool_t *scratch_pool);
+
+/* Reconstruct the fulltexts needed to blame PATH in REPOS between
+ * revisions START and END and pass them to FULLTEXT_FUNC with
+ * FULLTEXT_BATON, oldest first.
+ *
+ * The revisions of PATH are retrieved through svn_repos_get_file_revs2()
+ * without merged revisions, passing AUTHZ_READ_FUNC and AUTHZ_READ_BATON
+ * along.  Only revisions that changed the contents get reported.  The
+ * fulltext that START modified is reported first, with REVISION set to
+ * SVN_INVALID_REVNUM and REV_PROPS set to NULL.
+ *
+ * Every file remains available until the next invocation of FULLTEXT_FUNC
+ * has returned.  The last one remains available until RESULT_POOL gets
+ * cleaned up.
+ *
+ * If START or END is SVN_INVALID_REVNUM, it defaults to the youngest
+ * revision.  If START is younger than END, return
+ * SVN_ERR_UNSUPPORTED_FEATURE.  Check CANCEL_FUNC with CANCEL_BATON
+ * regularly.  Use SCRATCH_POOL for temporary allocations.
+ *
+ * This does not depend on libsvn_diff.  Servers pass
+ * svn_diff__file_blame_add() as FULLTEXT_FUNC.
+ */
+svn_error_t *
+svn_repos__get_blame_fulltexts(svn_repos_t *repos,
+                               const char *path,
+                               svn_revnum_t start,
+                               svn_revnum_t end,
+                               svn_repos_authz_func_t authz_read_func,
+                               void *authz_read_baton,
+                               svn_repos__fulltext_func_t fulltext_func,
+                               void *fulltext_baton,
+                               svn_cancel_func_t cancel_func,
+                               void *cancel_baton,
+                               apr_pool_t *result_pool,
+                               apr_pool_t *scratch_pool);
+
 #ifdef __cplusplus
 }
 #endif /* __cplusplus */
@@ -117,6 +117,14 @@ typedef struct svn_config_t svn_config_t;
 #define SVN_CONFIG_OPTION_SERF_LOG_COMPONENTS       "serf-log-components"
 /** @since New in 1.9. */
 #define SVN_CONFIG_OPTION_SERF_LOG_LEVEL            "serf-log-level"
+/** @since New in 1.12. */
+#define SVN_CONFIG_OPTION_SVN_MAX_CONNECTIONS       "svn-max-connections"
+/** @since New in 1.12. */
+#define SVN_CONFIG_OPTION_HTTP_PROTOCOL             "http-protocol"
+/** @since New in 1.12. */
+#define SVN_CONFIG_OPTION_HTTP_CONTENT_CACHE        "http-content-cache"
+/** @since New in 1.12. */
+#define SVN_CONFIG_OPTION_HTTP_CONTENT_CACHE_SIZE   "http-content-cache-size"
 
 
 #define SVN_CONFIG_CATEGORY_CONFIG          "config"
@@ -161,6 +169,12 @@ typedef struct svn_config_t svn_config_t;
 #define SVN_CONFIG_OPTION_MEMORY_CACHE_SIZE         "memory-cache-size"
 /** @since New in 1.9. */
 #define SVN_CONFIG_OPTION_DIFF_IGNORE_CONTENT_TYPE  "diff-ignore-content-type"
+/** @since New in 1.12. */
+#define SVN_CONFIG_OPTION_BLAME_DIFF_THREADS        "blame-diff-threads"
+/** @since New in 1.12. */
+#define SVN_CONFIG_OPTION_BLAME_CACHE               "blame-cache"
+/** @since New in 1.12. */
+#define SVN_CONFIG_OPTION_SERVER_SIDE_BLAME         "server-side-blame"
 #define SVN_CONFIG_SECTION_TUNNELS              "tunnels"
 #define SVN_CONFIG_SECTION_AUTO_PROPS           "auto-props"
 /** @since New in 1.8. */
@@ -191,6 +205,8 @@ typedef struct svn_config_t svn_config_t;
 #define SVN_CONFIG_OPTION_FORCE_USERNAME_CASE       "force-username-case"
 /** @since New in 1.8. */
 #define SVN_CONFIG_OPTION_HOOKS_ENV                 "hooks-env"
+/** @since New in 1.12. */
+#define SVN_CONFIG_OPTION_ALLOW_BLAME               "allow-blame"
 /** @since New in 1.5. */
 #define SVN_CONFIG_SECTION_SASL                 "sasl"
 /** @since New in 1.5. */
@@ -235,6 +251,10 @@ typedef struct svn_config_t svn_config_t;
 #define SVN_CONFIG_DEFAULT_OPTION_STORE_SSL_CLIENT_CERT_PP_PLAINTEXT \
                                                              SVN_CONFIG_ASK
 #define SVN_CONFIG_DEFAULT_OPTION_HTTP_MAX_CONNECTIONS       4
+/** @since New in 1.12. */
+#define SVN_CONFIG_DEFAULT_OPTION_SVN_MAX_CONNECTIONS        1
+/** @since New in 1.12. */
+#define SVN_CONFIG_DEFAULT_OPTION_HTTP_CONTENT_CACHE_SIZE    1024
 
 /** Read configuration information from the standard sources and merge it
  * into the hash @a *cfg_hash.  If @a config_dir is not NULL it specifies a
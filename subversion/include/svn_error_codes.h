@@ -1592,6 +1592,11 @@ SVN_ERROR_START
              SVN_ERR_RA_SVN_CATEGORY_START + 10,
              "Server response too long")
 
+  /** @since New in 1.12  */
+  SVN_ERRDEF(SVN_ERR_RA_SVN_TLS_CERT_UNTRUSTED,
+             SVN_ERR_RA_SVN_CATEGORY_START + 11,
+             "Server TLS certificate untrusted")
+
   /* libsvn_auth errors */
 
        /* this error can be used when an auth provider doesn't have
@@ -2339,6 +2339,27 @@ svn_fs_dir_optimal_order(apr_array_header_t **ordered_p,
                          apr_pool_t *result_pool,
                          apr_pool_t *scratch_pool);
 
+/** Tell the filesystem that the nodes at @a paths (an array of
+ * <tt>const char *</tt>) in @a root are about to be read.  The filesystem
+ * may then fetch all their node revisions and, if @a dir_entries and
+ * @a proplists are set, their directory listings and property lists in
+ * one batch, in the order in which they are stored on disk.  The data
+ * ends up in the filesystem's caches, turning random I/O during the
+ * subsequent node-by-node access into sequential reads.
+ *
+ * This is merely a hint.  Paths that don't exist are ignored and
+ * back-ends may not do anything at all.  Use @a scratch_pool for
+ * temporary allocations.
+ *
+ * @since New in 1.12.
+ */
+svn_error_t *
+svn_fs_prefetch_nodes(svn_fs_root_t *root,
+                      const apr_array_header_t *paths,
+                      svn_boolean_t dir_entries,
+                      svn_boolean_t proplists,
+                      apr_pool_t *scratch_pool);
+
 /** Create a new directory named @a path in @a root.  The new directory has
  * no entries, and no properties.  @a root must be the root of a transaction,
  * not a revision.
@@ -37,6 +37,7 @@
 #include "svn_types.h"
 #include "svn_string.h"
 #include "svn_delta.h"
+#include "svn_diff.h"
 #include "svn_auth.h"
 #include "svn_mergeinfo.h"
 
@@ -1889,6 +1890,62 @@ svn_ra_get_file_revs(svn_ra_session_t *session,
                      void *handler_baton,
                      apr_pool_t *pool);
 
+/**
+ * Callback type to be used with svn_ra_blame().  It will be invoked
+ * once for every line of the blamed file, in ascending order of
+ * @a line_no, which starts at 0.
+ *
+ * @a line is the contents of the line without its line terminator.
+ * @a revision and @a rev_props describe the revision that last changed
+ * the line.  If the line has not been changed within the blamed revision
+ * range, @a revision will be #SVN_INVALID_REVNUM and @a rev_props will
+ * be @c NULL.
+ *
+ * @a baton is the user-provided receiver baton.  @a scratch_pool may be
+ * used for temporary allocations.
+ *
+ * @since New in 1.12.
+ */
+typedef svn_error_t *(*svn_ra_blame_receiver_t)(void *baton,
+                                               apr_int64_t line_no,
+                                               svn_revnum_t revision,
+                                               apr_hash_t *rev_props,
+                                               const char *line,
+                                               apr_pool_t *scratch_pool);
+
+/**
+ * Let the server calculate the blame information for the file @a path
+ * between revisions @a start and @a end and invoke @a receiver with
+ * @a receiver_baton for each line of @a path in @a end.  @a path is
+ * relative to the @a session's URL.
+ *
+ * The result is the same as if the blame had been calculated from the
+ * data returned by svn_ra_get_file_revs2() with @a include_merged_revisions
+ * set to FALSE and one revision before @a start, comparing the fulltexts
+ * as specified by @a diff_options.  Only the @c ignore_space and
+ * @c ignore_eol_style members of @a diff_options are used.  @a start must
+ * not be younger than @a end.
+ *
+ * If the server doesn't support the 'blame' command or has it disabled,
+ * return #SVN_ERR_UNSUPPORTED_FEATURE in preference to any other error
+ * that might otherwise be returned.  The local repository access layer
+ * never supports it, because the client can calculate the blame just as
+ * well in that case.
+ *
+ * Use @a scratch_pool for temporary memory allocation.
+ *
+ * @since New in 1.12.
+ */
+svn_error_t *
+svn_ra_blame(svn_ra_session_t *session,
+             const char *path,
+             svn_revnum_t start,
+             svn_revnum_t end,
+             const svn_diff_file_options_t *diff_options,
+             svn_ra_blame_receiver_t receiver,
+             void *receiver_baton,
+             apr_pool_t *scratch_pool);
+
 /**
  * Lock each path in @a path_revs, which is a hash whose keys are the
  * paths to be locked, and whose values are the corresponding base
@@ -2239,6 +2296,13 @@ svn_ra_has_capability(svn_ra_session_t *session,
  */
 #define SVN_RA_CAPABILITY_LIST "list"
 
+/**
+ * The capability of a server to calculate blame information itself.
+ *
+ * @since New in 1.12.
+ */
+#define SVN_RA_CAPABILITY_BLAME "blame"
+
 
 /*       *** PLEASE READ THIS IF YOU ADD A NEW CAPABILITY ***
  *
@@ -22,6 +22,8 @@
  */
 
 #include <apr_pools.h>
+#include <apr_thread_pool.h>
+#include <apr_thread_cond.h>
 
 #include "client.h"
 
@@ -36,43 +38,77 @@
 #include "svn_props.h"
 #include "svn_hash.h"
 #include "svn_sorts.h"
+#include "svn_config.h"
+#include "svn_checksum.h"
 
+#include "private/svn_diff_private.h"
+#include "private/svn_mutex.h"
+#include "private/svn_skel.h"
 #include "private/svn_wc_private.h"
 
 #include "svn_private_config.h"
 
 #include <assert.h>
 
-/* The metadata associated with a particular revision. */
-struct rev
+/* A diff between two subsequent fulltexts of the file being blamed.
+   The diff itself gets computed by a worker thread, while the result is
+   applied to the blame chain in the main thread, in submission order. */
+typedef struct diff_job_t
 {
-  svn_revnum_t revision; /* the revision number */
-  apr_hash_t *rev_props; /* the revision properties */
-  /* Used for merge reporting. */
-  const char *path;      /* the absolute repository path */
-};
+  /* The files to compare.  LAST_FILE is NULL for the first fulltext. */
+  const char *last_file;
+  const char *cur_file;
 
-/* One chunk of blame */
-struct blame
-{
-  const struct rev *rev;    /* the responsible revision */
-  apr_off_t start;          /* the starting diff-token (line) */
-  struct blame *next;       /* the next chunk */
-};
+  /* The revision responsible for the changes. */
+  svn_diff__blame_rev_t *rev;
+
+  /* Owns CUR_FILE and this structure.  It must survive until the next
+     job, which uses CUR_FILE as its LAST_FILE, has been retired. */
+  apr_pool_t *file_pool;
+
+  /* Private, thread-safe pool used by the worker for DIFF.  NULL if no
+     diff needs to be calculated. */
+  apr_pool_t *diff_pool;
+
+  /* Results of the worker. */
+  svn_diff_t *diff;
+  svn_error_t *result;
 
-/* A chain of blame chunks */
-struct blame_chain
+  /* Set once DIFF and RESULT are valid.  Protected by the queue's MUTEX. */
+  svn_boolean_t done;
+
+  /* The queue this job belongs to and the next job in it. */
+  struct diff_queue_t *queue;
+  struct diff_job_t *next;
+} diff_job_t;
+
+/* FIFO of diff jobs that have been handed to worker threads. */
+typedef struct diff_queue_t
 {
-  struct blame *blame;      /* linked list of blame chunks */
-  struct blame *avail;      /* linked list of free blame chunks */
-  struct apr_pool_t *pool;  /* Allocate members from this pool. */
-};
+#if APR_HAS_THREADS
+  /* Runs the diff calculations.  Allocated in THREAD_POOL_POOL, which is
+     safe to use from any thread. */
+  apr_thread_pool_t *thread_pool;
+  apr_pool_t *thread_pool_pool;
 
-/* The baton use for the diff output routine. */
-struct diff_baton {
-  struct blame_chain *chain;
-  const struct rev *rev;
-};
+  /* Synchronize the DONE flags of all jobs. */
+  svn_mutex__t *mutex;
+  apr_thread_cond_t *cond;
+#endif
+
+  const svn_diff_file_options_t *diff_options;
+
+  /* Number of jobs that may be queued before we block on the oldest. */
+  int max_pending;
+  int pending;
+
+  /* Oldest and youngest pending jobs.  Both NULL if the queue is empty. */
+  diff_job_t *first;
+  diff_job_t *last;
+
+  /* The FILE_POOL of the job most recently retired. */
+  apr_pool_t *retired_file_pool;
+} diff_queue_t;
 
 /* The baton used for a file revision. Lives the entire operation */
 struct file_rev_baton {
@@ -83,8 +119,8 @@ struct file_rev_baton {
   const svn_diff_file_options_t *diff_options;
   /* name of file containing the previous revision of the file */
   const char *last_filename;
-  struct rev *last_rev;   /* the rev of the last modification */
-  struct blame_chain *chain;      /* the original blame chain. */
+  svn_diff__blame_rev_t *last_rev;   /* the rev of the last modification */
+  svn_diff__blame_chain_t *chain;      /* the original blame chain. */
   const char *repos_root_url;    /* To construct a url */
   apr_pool_t *mainpool;  /* lives during the whole sequence of calls */
   apr_pool_t *lastpool;  /* pool used during previous call */
@@ -92,7 +128,7 @@ struct file_rev_baton {
 
   /* These are used for tracking merged revisions. */
   svn_boolean_t include_merged_revisions;
-  struct blame_chain *merged_chain;  /* the merged blame chain. */
+  svn_diff__blame_chain_t *merged_chain;  /* the merged blame chain. */
   /* name of file containing the previous merged revision of the file */
   const char *last_original_filename;
   /* pools for files which may need to persist for more than one rev. */
@@ -106,6 +142,22 @@ struct file_rev_baton {
      happens when we move to the previous revision */
   svn_revnum_t last_revnum;
   apr_hash_t *last_props;
+
+  /* If not NULL, diffs get calculated asynchronously through this
+     queue instead of inline. */
+  diff_queue_t *diff_queue;
+
+  /* Revision number and repository path of the last revision with
+     content changes, as reported by get_file_revs. */
+  svn_revnum_t last_file_revnum;
+  const char *last_file_path;
+
+  /* If TRUE, CHAIN has been restored from the blame cache and is valid
+     for the contents of the first revision reported by get_file_revs.
+     That revision must match SEED_REVNUM and SEED_PATH. */
+  svn_boolean_t seeded;
+  svn_revnum_t seed_revnum;
+  const char *seed_path;
 };
 
 /* The baton used by the txdelta window handler. Allocated per revision */
@@ -116,204 +168,245 @@ struct delta_baton {
   struct file_rev_baton *file_rev_baton;
   svn_stream_t *source_stream;  /* the delta source */
   const char *filename;
+  apr_pool_t *filepool; /* the pool owning FILENAME, if private to it */
   svn_boolean_t is_merged_revision;
-  struct rev *rev;     /* the rev struct for the current revision */
+  svn_diff__blame_rev_t *rev;     /* the rev struct for the current revision */
 };
 
 
 
 
-/* Return a blame chunk associated with REV for a change starting
-   at token START, and allocated in CHAIN->mainpool. */
-static struct blame *
-blame_create(struct blame_chain *chain,
-             const struct rev *rev,
-             apr_off_t start)
+#if APR_HAS_THREADS
+
+/* Thread-pool task calculating the diff for the diff_job_t given as
+   DATA. */
+static void * APR_THREAD_FUNC
+diff_task(apr_thread_t *tid,
+          void *data)
 {
-  struct blame *blame;
-  if (chain->avail)
+  diff_job_t *job = data;
+  diff_queue_t *queue = job->queue;
+  svn_error_t *err;
+
+  job->result = svn_error_trace(svn_diff_file_diff_2(&job->diff,
+                                                     job->last_file,
+                                                     job->cur_file,
+                                                     queue->diff_options,
+                                                     job->diff_pool));
+
+  /* Tell the main thread that we are done.  There is no way to report
+     errors in the synchronization itself, but those would make the main
+     thread fail when waiting for us anyway. */
+  err = svn_mutex__lock(queue->mutex);
+  if (!err)
     {
-      blame = chain->avail;
-      chain->avail = blame->next;
+      job->done = TRUE;
+      apr_thread_cond_broadcast(queue->cond);
+      err = svn_mutex__unlock(queue->mutex, SVN_NO_ERROR);
     }
-  else
-    blame = apr_palloc(chain->pool, sizeof(*blame));
-  blame->rev = rev;
-  blame->start = start;
-  blame->next = NULL;
-  return blame;
+  svn_error_clear(err);
+
+  return NULL;
 }
 
-/* Destroy a blame chunk. */
-static void
-blame_destroy(struct blame_chain *chain,
-              struct blame *blame)
+/* Pool pre-cleanup for the diff_queue_t given as DATA.  Destroying the
+   thread pool waits for all running diff tasks, so the files they access
+   must still exist at that point.  Afterwards, release the private pools
+   of all jobs that have not been retired, e.g. because of an error. */
+static apr_status_t
+diff_queue_cleanup(void *data)
 {
-  blame->next = chain->avail;
-  chain->avail = blame;
+  diff_queue_t *queue = data;
+  diff_job_t *job;
+  apr_status_t status;
+
+  status = apr_thread_pool_destroy(queue->thread_pool);
+
+  for (job = queue->first; job; job = job->next)
+    if (job->diff_pool)
+      {
+        svn_pool_destroy(job->diff_pool);
+        job->diff_pool = NULL;
+      }
+
+  svn_pool_destroy(queue->thread_pool_pool);
+
+  return status;
 }
 
-/* Return the blame chunk that contains token OFF, starting the search at
-   BLAME. */
-static struct blame *
-blame_find(struct blame *blame, apr_off_t off)
+#endif
+
+/* Set *QUEUE to a new diff queue using up to THREADS worker threads and
+   DIFF_OPTIONS, or to NULL if diffs should be calculated inline.
+   Allocate the queue in RESULT_POOL; the workers get stopped when that
+   pool gets cleaned up. */
+static svn_error_t *
+diff_queue_create(diff_queue_t **queue,
+                  int threads,
+                  const svn_diff_file_options_t *diff_options,
+                  apr_pool_t *result_pool)
 {
-  struct blame *prev = NULL;
-  while (blame)
+#if APR_HAS_THREADS
+  apr_status_t status;
+
+  if (threads > 1)
     {
-      if (blame->start > off) break;
-      prev = blame;
-      blame = blame->next;
+      *queue = apr_pcalloc(result_pool, sizeof(**queue));
+      (*queue)->diff_options = diff_options;
+
+      /* Keep every worker busy without letting diffs pile up in memory. */
+      (*queue)->max_pending = 2 * threads;
+
+      SVN_ERR(svn_mutex__init(&(*queue)->mutex, TRUE, result_pool));
+      status = apr_thread_cond_create(&(*queue)->cond, result_pool);
+      if (status)
+        return svn_error_wrap_apr(status,
+                                  _("Can't create condition variable"));
+
+      /* The thread-pool must be allocated from a thread-safe pool. */
+      (*queue)->thread_pool_pool = svn_pool_create(NULL);
+      status = apr_thread_pool_create(&(*queue)->thread_pool, 0, threads,
+                                      (*queue)->thread_pool_pool);
+      if (status)
+        {
+          svn_pool_destroy((*queue)->thread_pool_pool);
+          return svn_error_wrap_apr(status,
+                                    _("Can't create blame thread pool"));
+        }
+
+      apr_pool_pre_cleanup_register(result_pool, *queue,
+                                    diff_queue_cleanup);
+      return SVN_NO_ERROR;
     }
-  return prev;
+#endif
+
+  *queue = NULL;
+  return SVN_NO_ERROR;
 }
 
-/* Shift the start-point of BLAME and all subsequence blame-chunks
-   by ADJUST tokens */
-static void
-blame_adjust(struct blame *blame, apr_off_t adjust)
+/* Retire the oldest job in QUEUE:  Wait for its diff to become available
+   and apply it to CHAIN.  Release the file no longer needed afterwards. */
+static svn_error_t *
+diff_queue_retire(diff_queue_t *queue,
+                  svn_diff__blame_chain_t *chain,
+                  svn_cancel_func_t cancel_func,
+                  void *cancel_baton)
 {
-  while (blame)
+  diff_job_t *job = queue->first;
+  svn_error_t *err;
+
+#if APR_HAS_THREADS
+  SVN_ERR(svn_mutex__lock(queue->mutex));
+  while (!job->done)
     {
-      blame->start += adjust;
-      blame = blame->next;
+      apr_status_t status = apr_thread_cond_wait(queue->cond,
+                                                 svn_mutex__get(queue->mutex));
+      if (status)
+        return svn_error_trace(
+                 svn_mutex__unlock(queue->mutex,
+                                   svn_error_wrap_apr(status,
+                                        _("Can't wait for diff task"))));
     }
-}
+  SVN_ERR(svn_mutex__unlock(queue->mutex, SVN_NO_ERROR));
+#endif
 
-/* Delete the blame associated with the region from token START to
-   START + LENGTH */
-static svn_error_t *
-blame_delete_range(struct blame_chain *chain,
-                   apr_off_t start,
-                   apr_off_t length)
-{
-  struct blame *first = blame_find(chain->blame, start);
-  struct blame *last = blame_find(chain->blame, start + length);
-  struct blame *tail = last->next;
+  queue->first = job->next;
+  if (!queue->first)
+    queue->last = NULL;
+  queue->pending--;
 
-  if (first != last)
+  err = job->result;
+  if (!err && job->diff)
     {
-      struct blame *walk = first->next;
-      while (walk != last)
-        {
-          struct blame *next = walk->next;
-          blame_destroy(chain, walk);
-          walk = next;
-        }
-      first->next = last;
-      last->start = start;
-      if (first->start == start)
-        {
-          *first = *last;
-          blame_destroy(chain, last);
-          last = first;
-        }
+      err = svn_diff__blame_chain_apply(chain, job->diff, job->rev,
+                                        cancel_func, cancel_baton);
+    }
+  else if (!err && !chain->blame)
+    {
+      /* First fulltext and nothing restored from the cache. */
+      chain->blame = svn_diff__blame_chunk_create(chain, job->rev, 0);
     }
 
-  if (tail && tail->start == last->start + length)
+  if (job->diff_pool)
     {
-      *last = *tail;
-      blame_destroy(chain, tail);
-      tail = last->next;
+      svn_pool_destroy(job->diff_pool);
+      job->diff_pool = NULL;
     }
 
-  blame_adjust(tail, -length);
+  /* The previous fulltext has now been compared against all its
+     successors. */
+  if (queue->retired_file_pool)
+    svn_pool_destroy(queue->retired_file_pool);
+  queue->retired_file_pool = job->file_pool;
 
-  return SVN_NO_ERROR;
+  return svn_error_trace(err);
 }
 
-/* Insert a chunk of blame associated with REV starting
-   at token START and continuing for LENGTH tokens */
+/* Queue the diff between LAST_FILE and CUR_FILE, attributed to REV, in
+   QUEUE.  FILE_POOL owns CUR_FILE.  If too many diffs are pending, apply
+   the oldest ones to CHAIN first. */
 static svn_error_t *
-blame_insert_range(struct blame_chain *chain,
-                   const struct rev *rev,
-                   apr_off_t start,
-                   apr_off_t length)
+diff_queue_push(diff_queue_t *queue,
+                const char *last_file,
+                const char *cur_file,
+                svn_diff__blame_rev_t *rev,
+                apr_pool_t *file_pool,
+                svn_diff__blame_chain_t *chain,
+                svn_cancel_func_t cancel_func,
+                void *cancel_baton)
 {
-  struct blame *head = chain->blame;
-  struct blame *point = blame_find(head, start);
-  struct blame *insert;
+  diff_job_t *job = apr_pcalloc(file_pool, sizeof(*job));
+
+  job->last_file = last_file;
+  job->cur_file = cur_file;
+  job->rev = rev;
+  job->file_pool = file_pool;
+  job->queue = queue;
 
-  if (point->start == start)
+#if APR_HAS_THREADS
+  if (last_file)
     {
-      insert = blame_create(chain, point->rev, point->start + length);
-      point->rev = rev;
-      insert->next = point->next;
-      point->next = insert;
+      apr_status_t status;
+
+      /* Workers need a pool of their own that is safe to use from any
+         thread. */
+      job->diff_pool = svn_pool_create(NULL);
+      status = apr_thread_pool_push(queue->thread_pool, diff_task, job,
+                                    0, NULL);
+      if (status)
+        {
+          job->result = svn_error_wrap_apr(status, _("Can't push task"));
+          job->done = TRUE;
+        }
     }
   else
+#endif
     {
-      struct blame *middle;
-      middle = blame_create(chain, rev, start);
-      insert = blame_create(chain, point->rev, start + length);
-      middle->next = insert;
-      insert->next = point->next;
-      point->next = middle;
+      job->done = TRUE;
     }
-  blame_adjust(insert->next, length);
-
-  return SVN_NO_ERROR;
-}
-
-/* Callback for diff between subsequent revisions */
-static svn_error_t *
-output_diff_modified(void *baton,
-                     apr_off_t original_start,
-                     apr_off_t original_length,
-                     apr_off_t modified_start,
-                     apr_off_t modified_length,
-                     apr_off_t latest_start,
-                     apr_off_t latest_length)
-{
-  struct diff_baton *db = baton;
 
-  if (original_length)
-    SVN_ERR(blame_delete_range(db->chain, modified_start, original_length));
+  if (queue->last)
+    queue->last->next = job;
+  else
+    queue->first = job;
+  queue->last = job;
+  queue->pending++;
 
-  if (modified_length)
-    SVN_ERR(blame_insert_range(db->chain, db->rev, modified_start,
-                               modified_length));
+  while (queue->pending > queue->max_pending)
+    SVN_ERR(diff_queue_retire(queue, chain, cancel_func, cancel_baton));
 
   return SVN_NO_ERROR;
 }
 
-static const svn_diff_output_fns_t output_fns = {
-        NULL,
-        output_diff_modified
-};
-
-/* Add the blame for the diffs between LAST_FILE and CUR_FILE to CHAIN,
-   for revision REV.  LAST_FILE may be NULL in which
-   case blame is added for every line of CUR_FILE. */
+/* Apply all pending diffs in QUEUE to CHAIN. */
 static svn_error_t *
-add_file_blame(const char *last_file,
-               const char *cur_file,
-               struct blame_chain *chain,
-               struct rev *rev,
-               const svn_diff_file_options_t *diff_options,
-               svn_cancel_func_t cancel_func,
-               void *cancel_baton,
-               apr_pool_t *pool)
+diff_queue_flush(diff_queue_t *queue,
+                 svn_diff__blame_chain_t *chain,
+                 svn_cancel_func_t cancel_func,
+                 void *cancel_baton)
 {
-  if (!last_file)
-    {
-      SVN_ERR_ASSERT(chain->blame == NULL);
-      chain->blame = blame_create(chain, rev, 0);
-    }
-  else
-    {
-      svn_diff_t *diff;
-      struct diff_baton diff_baton;
-
-      diff_baton.chain = chain;
-      diff_baton.rev = rev;
-
-      /* We have a previous file.  Get the diff and adjust blame info. */
-      SVN_ERR(svn_diff_file_diff_2(&diff, last_file, cur_file,
-                                   diff_options, pool));
-      SVN_ERR(svn_diff_output2(diff, &diff_baton, &output_fns,
-                               cancel_func, cancel_baton));
-    }
+  while (queue->first)
+    SVN_ERR(diff_queue_retire(queue, chain, cancel_func, cancel_baton));
 
   return SVN_NO_ERROR;
 }
@@ -325,7 +418,7 @@ update_blame(void *baton)
 {
   struct delta_baton *dbaton = baton;
   struct file_rev_baton *frb = dbaton->file_rev_baton;
-  struct blame_chain *chain;
+  svn_diff__blame_chain_t *chain;
 
   /* Close the source file used for the delta.
      It is important to do this early, since otherwise, they will be deleted
@@ -342,11 +435,24 @@ update_blame(void *baton)
     chain = frb->chain;
 
   /* Process this file. */
-  SVN_ERR(add_file_blame(frb->last_filename,
-                         dbaton->filename, chain, dbaton->rev,
-                         frb->diff_options,
-                         frb->ctx->cancel_func, frb->ctx->cancel_baton,
-                         frb->currpool));
+  if (frb->diff_queue)
+    SVN_ERR(diff_queue_push(frb->diff_queue, frb->last_filename,
+                            dbaton->filename, dbaton->rev, dbaton->filepool,
+                            chain,
+                            frb->ctx->cancel_func, frb->ctx->cancel_baton));
+  else if (!frb->last_filename && chain->blame)
+    {
+      /* CHAIN has been restored from the blame cache and already
+         describes this fulltext. */
+    }
+  else
+    SVN_ERR(svn_diff__blame_chain_add_file(chain, dbaton->rev,
+                                           frb->last_filename,
+                                           dbaton->filename,
+                                           frb->diff_options,
+                                           frb->ctx->cancel_func,
+                                           frb->ctx->cancel_baton,
+                                           frb->currpool));
 
   /* If we are including merged revisions, and the current revision is not a
      merged one, we need to add its blame info to the chain for the original
@@ -355,11 +461,13 @@ update_blame(void *baton)
     {
       apr_pool_t *tmppool;
 
-      SVN_ERR(add_file_blame(frb->last_original_filename,
-                             dbaton->filename, frb->chain, dbaton->rev,
-                             frb->diff_options,
-                             frb->ctx->cancel_func, frb->ctx->cancel_baton,
-                             frb->currpool));
+      SVN_ERR(svn_diff__blame_chain_add_file(frb->chain, dbaton->rev,
+                                             frb->last_original_filename,
+                                             dbaton->filename,
+                                             frb->diff_options,
+                                             frb->ctx->cancel_func,
+                                             frb->ctx->cancel_baton,
+                                             frb->currpool));
 
       /* This filename could be around for a while, potentially, so
          use the longer lifetime pool, and switch it with the previous one*/
@@ -441,6 +549,14 @@ file_rev_handler(void *baton, const char *path, svn_revnum_t revnum,
   /* Clear the current pool. */
   svn_pool_clear(frb->currpool);
 
+  /* A blame restored from the cache is only valid if it describes the
+     first revision we get. */
+  if (frb->seeded && !frb->last_filename)
+    {
+      if (revnum != frb->seed_revnum || strcmp(path, frb->seed_path) != 0)
+        return svn_error_create(SVN_ERR_CEASE_INVOCATION, NULL, NULL);
+    }
+
   if (frb->check_mime_type)
     {
       apr_hash_t *props = svn_prop_array_to_hash(prop_diffs, frb->currpool);
@@ -503,7 +619,14 @@ file_rev_handler(void *baton, const char *path, svn_revnum_t revnum,
     delta_baton->source_stream = NULL;
   last_stream = svn_stream_disown(delta_baton->source_stream, pool);
 
-  if (frb->include_merged_revisions && !merged_revision)
+  if (frb->diff_queue)
+    {
+      /* The file has to stay around until the diff queue is done with
+         it, so it can't live in the rotating pools. */
+      filepool = svn_pool_create(frb->mainpool);
+      delta_baton->filepool = filepool;
+    }
+  else if (frb->include_merged_revisions && !merged_revision)
     filepool = frb->filepool;
   else
     filepool = frb->currpool;
@@ -517,7 +640,7 @@ file_rev_handler(void *baton, const char *path, svn_revnum_t revnum,
   delta_baton->is_merged_revision = merged_revision;
 
   /* Create the rev structure. */
-  delta_baton->rev = apr_pcalloc(frb->mainpool, sizeof(struct rev));
+  delta_baton->rev = apr_pcalloc(frb->mainpool, sizeof(*delta_baton->rev));
 
   if (frb->backwards)
     {
@@ -565,6 +688,9 @@ file_rev_handler(void *baton, const char *path, svn_revnum_t revnum,
 
   /* Keep last revision for postprocessing after all changes */
   frb->last_rev = delta_baton->rev;
+  frb->last_file_revnum = revnum;
+  if (!frb->last_file_path || strcmp(frb->last_file_path, path) != 0)
+    frb->last_file_path = apr_pstrdup(frb->mainpool, path);
 
   /* Handle all delta - even if it is empty.
      We must do the latter to "merge" blame info from other branches. */
@@ -596,11 +722,11 @@ file_rev_handler(void *baton, const char *path, svn_revnum_t revnum,
    same starting value.  Both CHAIN_ORIG and CHAIN_MERGED should not be
    NULL.  */
 static void
-normalize_blames(struct blame_chain *chain,
-                 struct blame_chain *chain_merged,
+normalize_blames(svn_diff__blame_chain_t *chain,
+                 svn_diff__blame_chain_t *chain_merged,
                  apr_pool_t *pool)
 {
-  struct blame *walk, *walk_merged;
+  svn_diff__blame_chunk_t *walk, *walk_merged;
 
   /* Walk over the CHAIN's blame chunks and CHAIN_MERGED's blame chunks,
      creating new chunks as needed. */
@@ -614,7 +740,8 @@ normalize_blames(struct blame_chain *chain,
       if (walk->next->start < walk_merged->next->start)
         {
           /* insert a new chunk in CHAIN_MERGED. */
-          struct blame *tmp = blame_create(chain_merged, walk_merged->rev,
+          svn_diff__blame_chunk_t *tmp
+            = svn_diff__blame_chunk_create(chain_merged, walk_merged->rev,
                                            walk->next->start);
           tmp->next = walk_merged->next;
           walk_merged->next = tmp;
@@ -623,7 +750,8 @@ normalize_blames(struct blame_chain *chain,
       if (walk->next->start > walk_merged->next->start)
         {
           /* insert a new chunk in CHAIN. */
-          struct blame *tmp = blame_create(chain, walk->rev,
+          svn_diff__blame_chunk_t *tmp
+            = svn_diff__blame_chunk_create(chain, walk->rev,
                                            walk_merged->next->start);
           tmp->next = walk->next;
           walk->next = tmp;
@@ -635,7 +763,8 @@ normalize_blames(struct blame_chain *chain,
      to CHAIN_MERGED until its length matches that of CHAIN. */
   while (walk->next != NULL)
     {
-      struct blame *tmp = blame_create(chain_merged, walk_merged->rev,
+      svn_diff__blame_chunk_t *tmp
+        = svn_diff__blame_chunk_create(chain_merged, walk_merged->rev,
                                        walk->next->start);
       walk_merged->next = tmp;
 
@@ -646,7 +775,8 @@ normalize_blames(struct blame_chain *chain,
   /* Same as above, only extend CHAIN to match CHAIN_MERGED. */
   while (walk_merged->next != NULL)
     {
-      struct blame *tmp = blame_create(chain, walk->rev,
+      svn_diff__blame_chunk_t *tmp
+        = svn_diff__blame_chunk_create(chain, walk->rev,
                                        walk_merged->next->start);
       walk->next = tmp;
 
@@ -655,6 +785,304 @@ normalize_blames(struct blame_chain *chain,
     }
 }
 
+/* Version tag of the blame cache file format. */
+#define BLAME_CACHE_FORMAT "blame-cache-1"
+
+/* Set *CACHE_PATH to the file caching blame results for REPOS_RELPATH in
+   the repository with UUID, blamed from START_REVNUM with DIFF_OPTIONS,
+   or to NULL if there is no place to cache results.  The peg revision is
+   stored in the file itself, such that a later blame of the same path can
+   continue from there.  Use CTX to find the configuration area. */
+static svn_error_t *
+blame_cache_path(const char **cache_path,
+                 const char *uuid,
+                 const char *repos_relpath,
+                 svn_revnum_t start_revnum,
+                 const svn_diff_file_options_t *diff_options,
+                 svn_client_ctx_t *ctx,
+                 apr_pool_t *result_pool,
+                 apr_pool_t *scratch_pool)
+{
+  const char *config_dir = NULL;
+  const char *cache_dir;
+  const char *key;
+  svn_checksum_t *checksum;
+
+  if (ctx->auth_baton)
+    config_dir = svn_auth_get_parameter(ctx->auth_baton,
+                                        SVN_AUTH_PARAM_CONFIG_DIR);
+
+  SVN_ERR(svn_config_get_user_config_path(&cache_dir, config_dir,
+                                          "blame-cache", scratch_pool));
+  if (!cache_dir)
+    {
+      *cache_path = NULL;
+      return SVN_NO_ERROR;
+    }
+
+  key = apr_psprintf(scratch_pool, "%s\n%s\n%ld\n%d %d",
+                     uuid, repos_relpath, start_revnum,
+                     (int)diff_options->ignore_space,
+                     (int)diff_options->ignore_eol_style);
+  SVN_ERR(svn_checksum(&checksum, svn_checksum_md5, key, strlen(key),
+                       scratch_pool));
+
+  *cache_path = svn_dirent_join(cache_dir,
+                                svn_checksum_to_cstring(checksum,
+                                                        scratch_pool),
+                                result_pool);
+
+  return SVN_NO_ERROR;
+}
+
+/* Parse SKEL as a revision number and return it in *REVNUM. */
+static svn_error_t *
+parse_revnum(svn_revnum_t *revnum,
+             const svn_skel_t *skel,
+             apr_pool_t *scratch_pool)
+{
+  apr_int64_t value;
+
+  if (!skel->is_atom)
+    return svn_error_create(SVN_ERR_MALFORMED_FILE, NULL, NULL);
+
+  SVN_ERR(svn_skel__parse_int(&value, skel, scratch_pool));
+  *revnum = (svn_revnum_t)value;
+
+  return SVN_NO_ERROR;
+}
+
+/* Parse the blame cache CONTENTS.  Set *PEG_REVNUM, *SEED_REVNUM and
+   *SEED_PATH to the revision the cached blame was made for and to the
+   last file revision it covers.  Append the cached blame chunks to the
+   empty CHAIN.  Return SVN_ERR_MALFORMED_FILE if CONTENTS cannot be
+   parsed.  Allocate the results in RESULT_POOL. */
+static svn_error_t *
+parse_blame_cache(svn_revnum_t *peg_revnum,
+                  svn_revnum_t *seed_revnum,
+                  const char **seed_path,
+                  svn_diff__blame_chain_t *chain,
+                  const svn_stringbuf_t *contents,
+                  apr_pool_t *result_pool,
+                  apr_pool_t *scratch_pool)
+{
+  svn_skel_t *skel, *elt;
+  apr_hash_t *revs = apr_hash_make(scratch_pool);
+  svn_diff__blame_chunk_t *last = NULL;
+
+  /* (FORMAT PEG SEED-REV SEED-PATH (REV PROPS ...) (START REV ...)) */
+  skel = svn_skel__parse(contents->data, contents->len, scratch_pool);
+  if (!skel || skel->is_atom || svn_skel__list_length(skel) != 6
+      || !svn_skel__matches_atom(skel->children, BLAME_CACHE_FORMAT))
+    return svn_error_create(SVN_ERR_MALFORMED_FILE, NULL, NULL);
+
+  elt = skel->children->next;
+  SVN_ERR(parse_revnum(peg_revnum, elt, scratch_pool));
+  elt = elt->next;
+  SVN_ERR(parse_revnum(seed_revnum, elt, scratch_pool));
+  elt = elt->next;
+  if (!elt->is_atom)
+    return svn_error_create(SVN_ERR_MALFORMED_FILE, NULL, NULL);
+  *seed_path = apr_pstrmemdup(result_pool, elt->data, elt->len);
+
+  /* The revisions referenced by the blame chunks. */
+  elt = elt->next;
+  if (elt->is_atom || svn_skel__list_length(elt) % 2)
+    return svn_error_create(SVN_ERR_MALFORMED_FILE, NULL, NULL);
+
+  for (elt = elt->children; elt; elt = elt->next->next)
+    {
+      svn_diff__blame_rev_t *rev = apr_pcalloc(result_pool, sizeof(*rev));
+
+      SVN_ERR(parse_revnum(&rev->revision, elt, scratch_pool));
+      SVN_ERR(svn_skel__parse_proplist(&rev->rev_props, elt->next,
+                                       result_pool));
+      apr_hash_set(revs, &rev->revision, sizeof(rev->revision), rev);
+    }
+
+  /* The blame chunks themselves. */
+  elt = skel->children->next->next->next->next->next;
+  if (elt->is_atom || svn_skel__list_length(elt) % 2
+      || !elt->children)
+    return svn_error_create(SVN_ERR_MALFORMED_FILE, NULL, NULL);
+
+  for (elt = elt->children; elt; elt = elt->next->next)
+    {
+      apr_int64_t start;
+      svn_revnum_t revnum;
+      svn_diff__blame_rev_t *rev;
+      svn_diff__blame_chunk_t *blame;
+
+      if (!elt->is_atom)
+        return svn_error_create(SVN_ERR_MALFORMED_FILE, NULL, NULL);
+      SVN_ERR(svn_skel__parse_int(&start, elt, scratch_pool));
+      SVN_ERR(parse_revnum(&revnum, elt->next, scratch_pool));
+
+      rev = apr_hash_get(revs, &revnum, sizeof(revnum));
+      if (!rev)
+        return svn_error_create(SVN_ERR_MALFORMED_FILE, NULL, NULL);
+
+      blame = svn_diff__blame_chunk_create(chain, rev, (apr_off_t)start);
+      if (last)
+        last->next = blame;
+      else
+        chain->blame = blame;
+      last = blame;
+    }
+
+  return SVN_NO_ERROR;
+}
+
+/* Try to restore FRB->CHAIN from the blame cache file CACHE_PATH.  If
+   successful, set FRB->SEEDED and the FRB->SEED_* members and set
+   *PEG_REVNUM to the revision the cached blame was made for.  Otherwise,
+   leave FRB->CHAIN empty and set *PEG_REVNUM to SVN_INVALID_REVNUM.
+   A missing or malformed cache file is not an error.
+
+   Allocate the chain in FRB->CHAIN->POOL. */
+static svn_error_t *
+blame_cache_read(svn_revnum_t *peg_revnum,
+                 struct file_rev_baton *frb,
+                 const char *cache_path,
+                 apr_pool_t *scratch_pool)
+{
+  svn_stringbuf_t *contents;
+  svn_error_t *err;
+
+  *peg_revnum = SVN_INVALID_REVNUM;
+
+  err = svn_stringbuf_from_file2(&contents, cache_path, scratch_pool);
+  if (!err)
+    err = parse_blame_cache(peg_revnum, &frb->seed_revnum, &frb->seed_path,
+                            frb->chain, contents, frb->chain->pool,
+                            scratch_pool);
+
+  if (err)
+    {
+      /* The cache is merely an optimization. */
+      svn_error_clear(err);
+      *peg_revnum = SVN_INVALID_REVNUM;
+      frb->chain->blame = NULL;
+      frb->chain->avail = NULL;
+    }
+  else
+    {
+      frb->seeded = TRUE;
+    }
+
+  return SVN_NO_ERROR;
+}
+
+/* Store the blame information collected in FRB for PEG_REVNUM in the
+   blame cache file CACHE_PATH.  Failures to do so are ignored.  Use
+   SCRATCH_POOL for temporary allocations. */
+static void
+blame_cache_write(const char *cache_path,
+                  svn_revnum_t peg_revnum,
+                  const struct file_rev_baton *frb,
+                  apr_pool_t *scratch_pool)
+{
+  svn_skel_t *skel = svn_skel__make_empty_list(scratch_pool);
+  svn_skel_t *revs_skel = svn_skel__make_empty_list(scratch_pool);
+  svn_skel_t *chunks_skel = svn_skel__make_empty_list(scratch_pool);
+  apr_array_header_t *chunks
+    = apr_array_make(scratch_pool, 16, sizeof(svn_diff__blame_chunk_t *));
+  apr_hash_t *revs = apr_hash_make(scratch_pool);
+  apr_hash_index_t *hi;
+  svn_stringbuf_t *contents;
+  svn_diff__blame_chunk_t *walk;
+  svn_error_t *err;
+  int i;
+
+  for (walk = frb->chain->blame; walk; walk = walk->next)
+    {
+      /* Local modifications are never cached. */
+      if (!walk->rev)
+        return;
+
+      APR_ARRAY_PUSH(chunks, svn_diff__blame_chunk_t *) = walk;
+      apr_hash_set(revs, &walk->rev->revision, sizeof(svn_revnum_t),
+                   walk->rev);
+    }
+
+  for (hi = apr_hash_first(scratch_pool, revs); hi; hi = apr_hash_next(hi))
+    {
+      const svn_diff__blame_rev_t *rev = apr_hash_this_val(hi);
+      svn_skel_t *props_skel;
+
+      err = svn_skel__unparse_proplist(&props_skel,
+                                       rev->rev_props
+                                         ? rev->rev_props
+                                         : apr_hash_make(scratch_pool),
+                                       scratch_pool);
+      if (err)
+        {
+          svn_error_clear(err);
+          return;
+        }
+
+      svn_skel__prepend(props_skel, revs_skel);
+      svn_skel__prepend_int(rev->revision, revs_skel, scratch_pool);
+    }
+
+  for (i = chunks->nelts - 1; i >= 0; --i)
+    {
+      walk = APR_ARRAY_IDX(chunks, i, svn_diff__blame_chunk_t *);
+      svn_skel__prepend_int(walk->rev->revision, chunks_skel, scratch_pool);
+      svn_skel__prepend_int(walk->start, chunks_skel, scratch_pool);
+    }
+
+  svn_skel__prepend(chunks_skel, skel);
+  svn_skel__prepend(revs_skel, skel);
+  svn_skel__prepend_str(frb->last_file_path, skel, scratch_pool);
+  svn_skel__prepend_int(frb->last_file_revnum, skel, scratch_pool);
+  svn_skel__prepend_int(peg_revnum, skel, scratch_pool);
+  svn_skel__prepend_str(BLAME_CACHE_FORMAT, skel, scratch_pool);
+
+  contents = svn_skel__unparse(skel, scratch_pool);
+
+  err = svn_io_make_dir_recursively(svn_dirent_dirname(cache_path,
+                                                       scratch_pool),
+                                    scratch_pool);
+  if (!err)
+    err = svn_io_write_atomic2(cache_path, contents->data, contents->len,
+                               NULL, FALSE, scratch_pool);
+
+  svn_error_clear(err);
+}
+
+/* Baton for server_blame_receiver. */
+struct server_blame_baton
+{
+  svn_revnum_t start_rev, end_rev;
+  svn_client_blame_receiver3_t receiver;
+  void *receiver_baton;
+  svn_client_ctx_t *ctx;
+};
+
+/* Forward a line annotated by the server to the client's receiver.
+
+   Implements svn_ra_blame_receiver_t. */
+static svn_error_t *
+server_blame_receiver(void *baton,
+                      apr_int64_t line_no,
+                      svn_revnum_t revision,
+                      apr_hash_t *rev_props,
+                      const char *line,
+                      apr_pool_t *scratch_pool)
+{
+  struct server_blame_baton *sbb = baton;
+
+  if (sbb->ctx->cancel_func)
+    SVN_ERR(sbb->ctx->cancel_func(sbb->ctx->cancel_baton));
+
+  return svn_error_trace(sbb->receiver(sbb->receiver_baton,
+                                       sbb->start_rev, sbb->end_rev,
+                                       line_no, revision, rev_props,
+                                       SVN_INVALID_REVNUM, NULL, NULL,
+                                       line, FALSE, scratch_pool));
+}
+
 svn_error_t *
 svn_client_blame5(const char *target,
                   const svn_opt_revision_t *peg_revision,
@@ -671,11 +1099,24 @@ svn_client_blame5(const char *target,
   struct file_rev_baton frb;
   svn_ra_session_t *ra_session;
   svn_revnum_t start_revnum, end_revnum;
-  struct blame *walk, *walk_merged = NULL;
+  svn_diff__blame_chunk_t *walk, *walk_merged = NULL;
   apr_pool_t *iterpool;
   svn_stream_t *last_stream;
   svn_stream_t *stream;
   const char *target_abspath_or_url;
+  const char *repos_uuid;
+  const char *repos_relpath;
+  const char *session_url;
+  svn_config_t *cfg = ctx->config
+                      ? svn_hash_gets(ctx->config, SVN_CONFIG_CATEGORY_CONFIG)
+                      : NULL;
+  apr_int64_t diff_threads;
+  svn_boolean_t use_cache;
+  svn_boolean_t server_side_blame;
+  const char *cache_path = NULL;
+  svn_revnum_t cached_peg_revnum = SVN_INVALID_REVNUM;
+  svn_revnum_t fetch_start;
+  svn_error_t *err;
 
   if (start->kind == svn_opt_revision_unspecified
       || end->kind == svn_opt_revision_unspecified)
@@ -714,6 +1155,10 @@ svn_client_blame5(const char *target,
 
     /* Make the session point to the real URL. */
     SVN_ERR(svn_ra_reparent(ra_session, loc->url, pool));
+    session_url = loc->url;
+    repos_uuid = loc->repos_uuid;
+    repos_relpath = svn_uri_skip_ancestor(loc->repos_root_url, loc->url,
+                                          pool);
   }
 
   /* We check the mime-type of the yougest revision before getting all
@@ -776,21 +1221,69 @@ svn_client_blame5(const char *target,
   frb.last_filename = NULL;
   frb.last_rev = NULL;
   frb.last_original_filename = NULL;
-  frb.chain = apr_palloc(pool, sizeof(*frb.chain));
-  frb.chain->blame = NULL;
-  frb.chain->avail = NULL;
-  frb.chain->pool = pool;
+  frb.chain = svn_diff__blame_chain_create(pool);
   if (include_merged_revisions)
-    {
-      frb.merged_chain = apr_palloc(pool, sizeof(*frb.merged_chain));
-      frb.merged_chain->blame = NULL;
-      frb.merged_chain->avail = NULL;
-      frb.merged_chain->pool = pool;
-    }
+    frb.merged_chain = svn_diff__blame_chain_create(pool);
   frb.backwards = (frb.start_rev > frb.end_rev);
   frb.last_revnum = SVN_INVALID_REVNUM;
   frb.last_props = NULL;
   frb.check_mime_type = (frb.backwards && !ignore_mime_type);
+  frb.last_file_revnum = SVN_INVALID_REVNUM;
+  frb.last_file_path = NULL;
+  frb.seeded = FALSE;
+  frb.seed_revnum = SVN_INVALID_REVNUM;
+  frb.seed_path = NULL;
+
+  /* Diffs between subsequent revisions may be calculated by worker threads
+     while we keep reconstructing fulltexts.  The extra chain for merged
+     revisions needs two diffs per revision, so we don't do that there. */
+  SVN_ERR(svn_config_get_int64(cfg, &diff_threads,
+                               SVN_CONFIG_SECTION_MISCELLANY,
+                               SVN_CONFIG_OPTION_BLAME_DIFF_THREADS, 1));
+  if (include_merged_revisions)
+    diff_threads = 1;
+  SVN_ERR(diff_queue_create(&frb.diff_queue, (int)MIN(diff_threads, 64),
+                            diff_options, pool));
+
+  /* Previous blame results can be reused as long as we only move forward
+     in history and don't need local modifications or merge info. */
+  SVN_ERR(svn_config_get_bool(cfg, &use_cache,
+                              SVN_CONFIG_SECTION_MISCELLANY,
+                              SVN_CONFIG_OPTION_BLAME_CACHE, FALSE));
+  use_cache = use_cache
+              && !frb.backwards
+              && !include_merged_revisions
+              && end->kind != svn_opt_revision_working;
+
+  /* Unless the user asked for the local blame machinery, i.e. a blame
+     cache to update or parallel diffs, let a capable server annotate the
+     lines, so we don't have to fetch every file revision. */
+  SVN_ERR(svn_config_get_bool(cfg, &server_side_blame,
+                              SVN_CONFIG_SECTION_MISCELLANY,
+                              SVN_CONFIG_OPTION_SERVER_SIDE_BLAME, TRUE));
+  if (server_side_blame
+      && !use_cache
+      && diff_threads <= 1
+      && !frb.backwards
+      && !include_merged_revisions
+      && end->kind != svn_opt_revision_working)
+    {
+      struct server_blame_baton sbb;
+
+      sbb.start_rev = start_revnum;
+      sbb.end_rev = end_revnum;
+      sbb.receiver = receiver;
+      sbb.receiver_baton = receiver_baton;
+      sbb.ctx = ctx;
+
+      err = svn_ra_blame(ra_session, "", start_revnum, end_revnum,
+                         diff_options, server_blame_receiver, &sbb, pool);
+      if (!err || err->apr_err != SVN_ERR_UNSUPPORTED_FEATURE)
+        return svn_error_trace(err);
+
+      /* Old server.  Calculate the blame ourselves. */
+      svn_error_clear(err);
+    }
 
   SVN_ERR(svn_ra_get_repos_root2(ra_session, &frb.repos_root_url, pool));
 
@@ -806,16 +1299,65 @@ svn_client_blame5(const char *target,
       frb.prevfilepool = svn_pool_create(pool);
     }
 
+  if (use_cache)
+    {
+      SVN_ERR(blame_cache_path(&cache_path, repos_uuid, repos_relpath,
+                               start_revnum, diff_options, ctx,
+                               pool, pool));
+      if (cache_path)
+        SVN_ERR(blame_cache_read(&cached_peg_revnum, &frb, cache_path,
+                                 pool));
+
+      /* We can't go back in time. */
+      if (frb.seeded && cached_peg_revnum > end_revnum)
+        {
+          frb.seeded = FALSE;
+          frb.chain->blame = NULL;
+          frb.chain->avail = NULL;
+          cached_peg_revnum = SVN_INVALID_REVNUM;
+        }
+    }
+
   /* Collect all blame information.
      We need to ensure that we get one revision before the start_rev,
      if available so that we can know what was actually changed in the start
-     revision. */
-  SVN_ERR(svn_ra_get_file_revs2(ra_session, "",
-                                frb.backwards ? start_revnum
-                                              : MAX(0, start_revnum-1),
-                                end_revnum,
-                                include_merged_revisions,
-                                file_rev_handler, &frb, pool));
+     revision.  With a cached blame, we only need to process the revisions
+     after its peg revision. */
+  if (frb.seeded)
+    fetch_start = cached_peg_revnum;
+  else
+    fetch_start = frb.backwards ? start_revnum : MAX(0, start_revnum-1);
+
+  err = svn_ra_get_file_revs2(ra_session, "", fetch_start, end_revnum,
+                              include_merged_revisions,
+                              file_rev_handler, &frb, pool);
+
+  if (frb.seeded && svn_error_find_cause(err, SVN_ERR_CEASE_INVOCATION))
+    {
+      /* The cached blame belongs to a different line of history.
+         Start from scratch.  The aborted request may have left unread
+         data on the connection, so don't reuse the session for this. */
+      svn_error_clear(err);
+      frb.seeded = FALSE;
+      frb.chain->blame = NULL;
+      frb.chain->avail = NULL;
+
+      SVN_ERR(svn_client__open_ra_session_internal(&ra_session, NULL,
+                                                   session_url, NULL, NULL,
+                                                   FALSE, FALSE, ctx,
+                                                   pool, pool));
+      err = svn_ra_get_file_revs2(ra_session, "", MAX(0, start_revnum-1),
+                                  end_revnum, include_merged_revisions,
+                                  file_rev_handler, &frb, pool);
+    }
+  SVN_ERR(err);
+
+  if (frb.diff_queue)
+    SVN_ERR(diff_queue_flush(frb.diff_queue, frb.chain,
+                             ctx->cancel_func, ctx->cancel_baton));
+
+  if (cache_path)
+    blame_cache_write(cache_path, end_revnum, &frb, pool);
 
   if (end->kind == svn_opt_revision_working)
     {
@@ -869,9 +1411,11 @@ svn_client_blame5(const char *target,
           SVN_ERR(svn_stream_copy3(wcfile, tempfile, ctx->cancel_func,
                                    ctx->cancel_baton, pool));
 
-          SVN_ERR(add_file_blame(frb.last_filename, temppath, frb.chain, NULL,
-                                 frb.diff_options,
-                                 ctx->cancel_func, ctx->cancel_baton, pool));
+          SVN_ERR(svn_diff__blame_chain_add_file(frb.chain, NULL,
+                                                 frb.last_filename, temppath,
+                                                 frb.diff_options,
+                                                 ctx->cancel_func,
+                                                 ctx->cancel_baton, pool));
 
           frb.last_filename = temppath;
         }
@@ -901,7 +1445,8 @@ svn_client_blame5(const char *target,
          the most recently changed revision.  ### Is this really what we want
          to do here?  Do the sematics of copy change? */
       if (!frb.chain->blame)
-        frb.chain->blame = blame_create(frb.chain, frb.last_rev, 0);
+        frb.chain->blame = svn_diff__blame_chunk_create(frb.chain,
+                                                        frb.last_rev, 0);
 
       normalize_blames(frb.chain, frb.merged_chain, pool);
       walk_merged = frb.merged_chain->blame;
@@ -238,6 +238,32 @@ svn_client__calc_youngest_common_ancestor(svn_client__pathrev_t **ancestor_p,
                                           apr_pool_t *result_pool,
                                           apr_pool_t *scratch_pool);
 
+/* Fetch the children of DIR, a path relative to the URL of RA_SESSION,
+   in REVISION in one batch using svn_ra__get_nodes().  DIRENTS maps the
+   names of DIR's children to svn_dirent_t *; only children of kind KIND
+   are fetched, or children of any kind if KIND is svn_node_unknown.
+   WANT_DIRENTS, WANT_PROPS and DIRENT_FIELDS are passed through.
+
+   Set *PREFETCHED to a hash mapping the names of the children that were
+   fetched successfully to their svn_ra__node_request_t *.  Failures are
+   not reported: the caller should fetch any child missing from the hash
+   on its own, and deal with the error then.
+
+   Allocate *PREFETCHED in RESULT_POOL and use SCRATCH_POOL for temporary
+   allocations. */
+svn_error_t *
+svn_client__prefetch_children(apr_hash_t **prefetched,
+                              svn_ra_session_t *ra_session,
+                              const char *dir,
+                              apr_hash_t *dirents,
+                              svn_node_kind_t kind,
+                              svn_revnum_t revision,
+                              svn_boolean_t want_dirents,
+                              svn_boolean_t want_props,
+                              apr_uint32_t dirent_fields,
+                              apr_pool_t *result_pool,
+                              apr_pool_t *scratch_pool);
+
 /* Ensure that RA_SESSION's session URL matches SESSION_URL,
    reparenting that session if necessary.
    Store the previous session URL in *OLD_SESSION_URL (so that if the
@@ -36,6 +36,7 @@
 
 #include "svn_private_config.h"
 #include "private/svn_fspath.h"
+#include "private/svn_ra_private.h"
 #include "private/svn_sorts_private.h"
 #include "private/svn_wc_private.h"
 
@@ -180,11 +181,14 @@ build_info_from_dirent(svn_client_info2_t **info,
    svn_depth_files, then invoke RECEIVER on file children of DIR but
    not on subdirectories; if svn_depth_infinity, recurse fully.
    DIR is a relpath, relative to the root of RA_SESSION.
+
+   DIRENTS are DIR's entries, if the caller already fetched them, or NULL.
 */
 static svn_error_t *
 push_dir_info(svn_ra_session_t *ra_session,
               const svn_client__pathrev_t *pathrev,
               const char *dir,
+              apr_hash_t *dirents,
               svn_client_info_receiver2_t receiver,
               void *receiver_baton,
               svn_depth_t depth,
@@ -192,14 +196,25 @@ push_dir_info(svn_ra_session_t *ra_session,
               apr_hash_t *locks,
               apr_pool_t *pool)
 {
-  apr_hash_t *tmpdirents;
+  apr_hash_t *prefetched;
   apr_hash_index_t *hi;
   apr_pool_t *subpool = svn_pool_create(pool);
 
-  SVN_ERR(svn_ra_get_dir2(ra_session, &tmpdirents, NULL, NULL,
-                          dir, pathrev->rev, DIRENT_FIELDS, pool));
+  if (!dirents)
+    SVN_ERR(svn_ra_get_dir2(ra_session, &dirents, NULL, NULL,
+                            dir, pathrev->rev, DIRENT_FIELDS, pool));
+
+  /* Fetch the entries of all subdirectories at once rather than one
+     round trip at a time. */
+  if (depth == svn_depth_infinity)
+    SVN_ERR(svn_client__prefetch_children(&prefetched, ra_session, dir,
+                                          dirents, svn_node_dir,
+                                          pathrev->rev, TRUE, FALSE,
+                                          DIRENT_FIELDS, pool, pool));
+  else
+    prefetched = NULL;
 
-  for (hi = apr_hash_first(pool, tmpdirents); hi; hi = apr_hash_next(hi))
+  for (hi = apr_hash_first(pool, dirents); hi; hi = apr_hash_next(hi))
     {
       const char *path, *fs_path;
       svn_lock_t *lock;
@@ -230,7 +245,10 @@ push_dir_info(svn_ra_session_t *ra_session,
 
       if (depth == svn_depth_infinity && the_ent->kind == svn_node_dir)
         {
+          svn_ra__node_request_t *request = svn_hash_gets(prefetched, name);
+
           SVN_ERR(push_dir_info(ra_session, child_pathrev, path,
+                                request ? request->dirents : NULL,
                                 receiver, receiver_baton,
                                 depth, ctx, locks, subpool));
         }
@@ -453,7 +471,7 @@ svn_client_info4(const char *abspath_or_url,
       else
         locks = apr_hash_make(pool); /* use an empty hash */
 
-      SVN_ERR(push_dir_info(ra_session, pathrev, "",
+      SVN_ERR(push_dir_info(ra_session, pathrev, "", NULL,
                             receiver, receiver_baton,
                             depth, ctx, locks, pool));
     }
@@ -108,12 +108,16 @@ match_patterns(const char *s,
    EXTERNAL_PARENT_URL and EXTERNAL_TARGET are set when external items
    are listed, otherwise both are set to NULL by the caller.
 
+   If the caller already fetched DIR's entries (and properties, if
+   EXTERNALS is non-NULL), PREFETCHED holds them; otherwise it is NULL.
+
    Use SCRATCH_BUFFER for temporary string contents.
 */
 static svn_error_t *
 get_dir_contents(apr_uint32_t dirent_fields,
                  const char *dir,
                  svn_revnum_t rev,
+                 const svn_ra__node_request_t *prefetched,
                  svn_ra_session_t *ra_session,
                  apr_hash_t *locks,
                  const char *fs_path,
@@ -130,6 +134,7 @@ get_dir_contents(apr_uint32_t dirent_fields,
                  apr_pool_t *scratch_pool)
 {
   apr_hash_t *tmpdirents;
+  apr_hash_t *prefetched_children = NULL;
   apr_pool_t *iterpool = svn_pool_create(scratch_pool);
   apr_array_header_t *array;
   svn_error_t *err;
@@ -140,19 +145,27 @@ get_dir_contents(apr_uint32_t dirent_fields,
   if (depth == svn_depth_empty)
     return SVN_NO_ERROR;
 
-  /* Get the directory's entries. If externals hash is non-NULL, get its
-     properties also. Ignore any not-authorized errors.  */
-  err = svn_ra_get_dir2(ra_session, &tmpdirents, NULL,
-                        externals ? &prop_hash : NULL,
-                        dir, rev, dirent_fields, scratch_pool);
-
-  if (err && ((err->apr_err == SVN_ERR_RA_NOT_AUTHORIZED) ||
-              (err->apr_err == SVN_ERR_RA_DAV_FORBIDDEN)))
+  if (prefetched)
     {
-      svn_error_clear(err);
-      return SVN_NO_ERROR;
+      tmpdirents = prefetched->dirents;
+      prop_hash = prefetched->props;
+    }
+  else
+    {
+      /* Get the directory's entries. If externals hash is non-NULL, get
+         its properties also. Ignore any not-authorized errors.  */
+      err = svn_ra_get_dir2(ra_session, &tmpdirents, NULL,
+                            externals ? &prop_hash : NULL,
+                            dir, rev, dirent_fields, scratch_pool);
+
+      if (err && ((err->apr_err == SVN_ERR_RA_NOT_AUTHORIZED) ||
+                  (err->apr_err == SVN_ERR_RA_DAV_FORBIDDEN)))
+        {
+          svn_error_clear(err);
+          return SVN_NO_ERROR;
+        }
+      SVN_ERR(err);
     }
-  SVN_ERR(err);
 
  /* Locks will often be empty.  Prevent pointless lookups in that case. */
  if (locks && apr_hash_count(locks) == 0)
@@ -175,6 +188,15 @@ get_dir_contents(apr_uint32_t dirent_fields,
   if (ctx->cancel_func)
     SVN_ERR(ctx->cancel_func(ctx->cancel_baton));
 
+  /* Fetch the contents of all subdirectories at once rather than one
+     round trip at a time. */
+  if (depth == svn_depth_infinity)
+    SVN_ERR(svn_client__prefetch_children(&prefetched_children, ra_session,
+                                          dir, tmpdirents, svn_node_dir, rev,
+                                          TRUE, externals != NULL,
+                                          dirent_fields, scratch_pool,
+                                          scratch_pool));
+
   /* Sort the hash, so we can call the callback in a "deterministic" order. */
   array = svn_sort__hash(tmpdirents, svn_sort_compare_items_lexically,
                          scratch_pool);
@@ -207,8 +229,10 @@ get_dir_contents(apr_uint32_t dirent_fields,
       /* If externals is non-NULL, populate the externals hash table
          recursively for all directory entries. */
       if (depth == svn_depth_infinity && the_ent->kind == svn_node_dir)
-        SVN_ERR(get_dir_contents(dirent_fields, path, rev, ra_session,
-                                 locks, fs_path, patterns, depth, ctx,
+        SVN_ERR(get_dir_contents(dirent_fields, path, rev,
+                                 svn_hash_gets(prefetched_children,
+                                               item->key),
+                                 ra_session, locks, fs_path, patterns, depth, ctx,
                                  externals, external_parent_url,
                                  external_target, list_func, baton,
                                  scratch_buffer, result_pool, iterpool));
@@ -405,7 +429,8 @@ list_internal(const char *path_or_url,
       && (depth == svn_depth_files
           || depth == svn_depth_immediates
           || depth == svn_depth_infinity))
-    SVN_ERR(get_dir_contents(dirent_fields, "", loc->rev, ra_session, locks,
+    SVN_ERR(get_dir_contents(dirent_fields, "", loc->rev, NULL,
+                             ra_session, locks,
                              fs_path, patterns, depth, ctx, externals,
                              external_parent_url, external_target, list_func,
                              baton, &scratch_buffer, pool, pool));
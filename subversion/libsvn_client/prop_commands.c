@@ -527,18 +527,22 @@ svn_client_revprop_set2(const char *propname,
   return SVN_NO_ERROR;
 }
 
-svn_error_t *
-svn_client__remote_propget(apr_hash_t *props,
-                           apr_array_header_t **inherited_props,
-                           const char *propname,
-                           const char *target_prefix,
-                           const char *target_relative,
-                           svn_node_kind_t kind,
-                           svn_revnum_t revnum,
-                           svn_ra_session_t *ra_session,
-                           svn_depth_t depth,
-                           apr_pool_t *result_pool,
-                           apr_pool_t *scratch_pool)
+/* Like svn_client__remote_propget(), but if the caller already fetched
+ * the properties (and, if DEPTH requires them, the entries) of the target,
+ * PREFETCHED holds them; otherwise it is NULL. */
+static svn_error_t *
+remote_propget(apr_hash_t *props,
+               apr_array_header_t **inherited_props,
+               const char *propname,
+               const char *target_prefix,
+               const char *target_relative,
+               svn_node_kind_t kind,
+               svn_revnum_t revnum,
+               const svn_ra__node_request_t *prefetched,
+               svn_ra_session_t *ra_session,
+               svn_depth_t depth,
+               apr_pool_t *result_pool,
+               apr_pool_t *scratch_pool)
 {
   apr_hash_t *dirents;
   apr_hash_t *prop_hash = NULL;
@@ -547,7 +551,12 @@ svn_client__remote_propget(apr_hash_t *props,
     svn_path_url_add_component2(target_prefix, target_relative,
                                 scratch_pool);
 
-  if (kind == svn_node_dir)
+  if (prefetched)
+    {
+      dirents = prefetched->dirents;
+      prop_hash = prefetched->props;
+    }
+  else if (kind == svn_node_dir)
     {
       SVN_ERR(svn_ra_get_dir2(ra_session,
                               (depth >= svn_depth_files ? &dirents : NULL),
@@ -628,8 +637,17 @@ svn_client__remote_propget(apr_hash_t *props,
       && apr_hash_count(dirents) > 0)
     {
       apr_hash_index_t *hi;
+      apr_hash_t *prefetched_children;
       apr_pool_t *iterpool = svn_pool_create(scratch_pool);
 
+      /* Fetch the children's properties at once rather than one round
+         trip at a time. */
+      SVN_ERR(svn_client__prefetch_children(
+                &prefetched_children, ra_session, target_relative, dirents,
+                depth == svn_depth_files ? svn_node_file : svn_node_unknown,
+                revnum, depth == svn_depth_infinity, TRUE, SVN_DIRENT_KIND,
+                scratch_pool, scratch_pool));
+
       for (hi = apr_hash_first(scratch_pool, dirents);
            hi;
            hi = apr_hash_next(hi))
@@ -650,15 +668,17 @@ svn_client__remote_propget(apr_hash_t *props,
           new_target_relative = svn_relpath_join(target_relative, this_name,
                                                  iterpool);
 
-          SVN_ERR(svn_client__remote_propget(props, NULL,
-                                             propname,
-                                             target_prefix,
-                                             new_target_relative,
-                                             this_ent->kind,
-                                             revnum,
-                                             ra_session,
-                                             depth_below_here,
-                                             result_pool, iterpool));
+          SVN_ERR(remote_propget(props, NULL,
+                                 propname,
+                                 target_prefix,
+                                 new_target_relative,
+                                 this_ent->kind,
+                                 revnum,
+                                 svn_hash_gets(prefetched_children,
+                                               this_name),
+                                 ra_session,
+                                 depth_below_here,
+                                 result_pool, iterpool));
         }
 
       svn_pool_destroy(iterpool);
@@ -667,6 +687,25 @@ svn_client__remote_propget(apr_hash_t *props,
   return SVN_NO_ERROR;
 }
 
+svn_error_t *
+svn_client__remote_propget(apr_hash_t *props,
+                           apr_array_header_t **inherited_props,
+                           const char *propname,
+                           const char *target_prefix,
+                           const char *target_relative,
+                           svn_node_kind_t kind,
+                           svn_revnum_t revnum,
+                           svn_ra_session_t *ra_session,
+                           svn_depth_t depth,
+                           apr_pool_t *result_pool,
+                           apr_pool_t *scratch_pool)
+{
+  return svn_error_trace(remote_propget(props, inherited_props, propname,
+                                        target_prefix, target_relative,
+                                        kind, revnum, NULL, ra_session,
+                                        depth, result_pool, scratch_pool));
+}
+
 /* Baton for recursive_propget_receiver(). */
 struct recursive_propget_receiver_baton
 {
@@ -42,6 +42,7 @@
 #include "svn_private_config.h"
 #include "private/svn_wc_private.h"
 #include "private/svn_client_private.h"
+#include "private/svn_ra_private.h"
 #include "private/svn_sorts_private.h"
 
 
@@ -1047,6 +1048,83 @@ svn_client__get_youngest_common_ancestor(svn_client__pathrev_t **ancestor_p,
   return SVN_NO_ERROR;
 }
 
+svn_error_t *
+svn_client__prefetch_children(apr_hash_t **prefetched,
+                              svn_ra_session_t *ra_session,
+                              const char *dir,
+                              apr_hash_t *dirents,
+                              svn_node_kind_t kind,
+                              svn_revnum_t revision,
+                              svn_boolean_t want_dirents,
+                              svn_boolean_t want_props,
+                              apr_uint32_t dirent_fields,
+                              apr_pool_t *result_pool,
+                              apr_pool_t *scratch_pool)
+{
+  apr_array_header_t *requests;
+  apr_array_header_t *names;
+  apr_hash_index_t *hi;
+  svn_error_t *err;
+  int i;
+
+  *prefetched = apr_hash_make(result_pool);
+
+  requests = apr_array_make(scratch_pool, apr_hash_count(dirents),
+                            sizeof(svn_ra__node_request_t *));
+  names = apr_array_make(scratch_pool, apr_hash_count(dirents),
+                         sizeof(const char *));
+  for (hi = apr_hash_first(scratch_pool, dirents); hi; hi = apr_hash_next(hi))
+    {
+      const char *name = apr_hash_this_key(hi);
+      const svn_dirent_t *dirent = apr_hash_this_val(hi);
+      svn_ra__node_request_t *request;
+
+      if (dirent->kind != svn_node_dir && dirent->kind != svn_node_file)
+        continue;
+      if (kind != svn_node_unknown && dirent->kind != kind)
+        continue;
+
+      request = apr_pcalloc(result_pool, sizeof(*request));
+      request->path = svn_relpath_join(dir, name, result_pool);
+      request->kind = dirent->kind;
+      APR_ARRAY_PUSH(requests, svn_ra__node_request_t *) = request;
+      APR_ARRAY_PUSH(names, const char *) = name;
+    }
+
+  /* Fetching a single node individually is just as fast. */
+  if (requests->nelts < 2)
+    return SVN_NO_ERROR;
+
+  /* Any node that failed has no results and will simply be fetched again
+     by the caller, who will then get to see the error.  That doesn't
+     work if the session itself is broken, though. */
+  err = svn_ra__get_nodes(ra_session, requests, revision, want_dirents,
+                          want_props, dirent_fields, result_pool,
+                          scratch_pool);
+  if (err && (err->apr_err == SVN_ERR_RA_SVN_CONNECTION_CLOSED
+              || err->apr_err == SVN_ERR_RA_SVN_IO_ERROR
+              || err->apr_err == SVN_ERR_RA_SVN_MALFORMED_DATA))
+    return svn_error_trace(err);
+  svn_error_clear(err);
+
+  for (i = 0; i < requests->nelts; i++)
+    {
+      svn_ra__node_request_t *request
+        = APR_ARRAY_IDX(requests, i, svn_ra__node_request_t *);
+
+      if ((want_dirents && request->kind == svn_node_dir && !request->dirents)
+          || (want_props && !request->props))
+        continue;
+
+      svn_hash_sets(*prefetched,
+                    apr_pstrdup(result_pool, APR_ARRAY_IDX(names, i,
+                                                           const char *)),
+                    request);
+    }
+
+  return SVN_NO_ERROR;
+}
+
 struct ra_ev2_baton {
   /* The working copy context, from the client context.  */
   svn_wc_context_t *wc_ctx;
@@ -0,0 +1,378 @@
+/*
+ * blame.c :  attributing the lines of a file to revisions
+ *
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ */
+
+#include <apr.h>
+#include <apr_pools.h>
+#include <apr_hash.h>
+
+#include "svn_error.h"
+#include "svn_io.h"
+#include "svn_pools.h"
+#include "svn_props.h"
+#include "svn_subst.h"
+#include "svn_types.h"
+#include "svn_diff.h"
+
+#include "private/svn_diff_private.h"
+#include "svn_private_config.h"
+
+/* The baton use for the diff output routine. */
+struct diff_baton {
+  svn_diff__blame_chain_t *chain;
+  const svn_diff__blame_rev_t *rev;
+};
+
+/* The state of a single line of history being blamed.  Lives for the
+   whole operation. */
+struct svn_diff__file_blame_t
+{
+  svn_diff__blame_chain_t *chain;
+  const svn_diff_file_options_t *diff_options;
+
+  /* Name of the file containing the last fulltext added, or NULL. */
+  const char *last_filename;
+
+  /* Revisions we have seen, mapping svn_revnum_t to
+     svn_diff__blame_rev_t *. */
+  apr_hash_t *revs;
+
+  svn_cancel_func_t cancel_func;
+  void *cancel_baton;
+
+  apr_pool_t *pool;
+};
+
+
+svn_diff__blame_chain_t *
+svn_diff__blame_chain_create(apr_pool_t *result_pool)
+{
+  svn_diff__blame_chain_t *chain = apr_palloc(result_pool, sizeof(*chain));
+
+  chain->blame = NULL;
+  chain->avail = NULL;
+  chain->pool = result_pool;
+
+  return chain;
+}
+
+svn_diff__blame_chunk_t *
+svn_diff__blame_chunk_create(svn_diff__blame_chain_t *chain,
+                             const svn_diff__blame_rev_t *rev,
+                             apr_off_t start)
+{
+  svn_diff__blame_chunk_t *blame;
+  if (chain->avail)
+    {
+      blame = chain->avail;
+      chain->avail = blame->next;
+    }
+  else
+    blame = apr_palloc(chain->pool, sizeof(*blame));
+  blame->rev = rev;
+  blame->start = start;
+  blame->next = NULL;
+  return blame;
+}
+
+/* Destroy a blame chunk. */
+static void
+blame_destroy(svn_diff__blame_chain_t *chain,
+              svn_diff__blame_chunk_t *blame)
+{
+  blame->next = chain->avail;
+  chain->avail = blame;
+}
+
+/* Return the blame chunk that contains token OFF, starting the search at
+   BLAME. */
+static svn_diff__blame_chunk_t *
+blame_find(svn_diff__blame_chunk_t *blame, apr_off_t off)
+{
+  svn_diff__blame_chunk_t *prev = NULL;
+  while (blame)
+    {
+      if (blame->start > off) break;
+      prev = blame;
+      blame = blame->next;
+    }
+  return prev;
+}
+
+/* Shift the start-point of BLAME and all subsequence blame-chunks
+   by ADJUST tokens */
+static void
+blame_adjust(svn_diff__blame_chunk_t *blame, apr_off_t adjust)
+{
+  while (blame)
+    {
+      blame->start += adjust;
+      blame = blame->next;
+    }
+}
+
+/* Delete the blame associated with the region from token START to
+   START + LENGTH */
+static void
+blame_delete_range(svn_diff__blame_chain_t *chain,
+                   apr_off_t start,
+                   apr_off_t length)
+{
+  svn_diff__blame_chunk_t *first = blame_find(chain->blame, start);
+  svn_diff__blame_chunk_t *last = blame_find(chain->blame, start + length);
+  svn_diff__blame_chunk_t *tail = last->next;
+
+  if (first != last)
+    {
+      svn_diff__blame_chunk_t *walk = first->next;
+      while (walk != last)
+        {
+          svn_diff__blame_chunk_t *next = walk->next;
+          blame_destroy(chain, walk);
+          walk = next;
+        }
+      first->next = last;
+      last->start = start;
+      if (first->start == start)
+        {
+          *first = *last;
+          blame_destroy(chain, last);
+          last = first;
+        }
+    }
+
+  if (tail && tail->start == last->start + length)
+    {
+      *last = *tail;
+      blame_destroy(chain, tail);
+      tail = last->next;
+    }
+
+  blame_adjust(tail, -length);
+}
+
+/* Insert a chunk of blame associated with REV starting
+   at token START and continuing for LENGTH tokens */
+static void
+blame_insert_range(svn_diff__blame_chain_t *chain,
+                   const svn_diff__blame_rev_t *rev,
+                   apr_off_t start,
+                   apr_off_t length)
+{
+  svn_diff__blame_chunk_t *point = blame_find(chain->blame, start);
+  svn_diff__blame_chunk_t *insert;
+
+  if (point->start == start)
+    {
+      insert = svn_diff__blame_chunk_create(chain, point->rev,
+                                            point->start + length);
+      point->rev = rev;
+      insert->next = point->next;
+      point->next = insert;
+    }
+  else
+    {
+      svn_diff__blame_chunk_t *middle;
+      middle = svn_diff__blame_chunk_create(chain, rev, start);
+      insert = svn_diff__blame_chunk_create(chain, point->rev,
+                                            start + length);
+      middle->next = insert;
+      insert->next = point->next;
+      point->next = middle;
+    }
+  blame_adjust(insert->next, length);
+}
+
+/* Callback for diff between subsequent revisions */
+static svn_error_t *
+output_diff_modified(void *baton,
+                     apr_off_t original_start,
+                     apr_off_t original_length,
+                     apr_off_t modified_start,
+                     apr_off_t modified_length,
+                     apr_off_t latest_start,
+                     apr_off_t latest_length)
+{
+  struct diff_baton *db = baton;
+
+  if (original_length)
+    blame_delete_range(db->chain, modified_start, original_length);
+
+  if (modified_length)
+    blame_insert_range(db->chain, db->rev, modified_start, modified_length);
+
+  return SVN_NO_ERROR;
+}
+
+static const svn_diff_output_fns_t output_fns = {
+        NULL,
+        output_diff_modified
+};
+
+svn_error_t *
+svn_diff__blame_chain_apply(svn_diff__blame_chain_t *chain,
+                            svn_diff_t *diff,
+                            const svn_diff__blame_rev_t *rev,
+                            svn_cancel_func_t cancel_func,
+                            void *cancel_baton)
+{
+  struct diff_baton diff_baton;
+
+  diff_baton.chain = chain;
+  diff_baton.rev = rev;
+
+  return svn_error_trace(svn_diff_output2(diff, &diff_baton, &output_fns,
+                                          cancel_func, cancel_baton));
+}
+
+svn_error_t *
+svn_diff__blame_chain_add_file(svn_diff__blame_chain_t *chain,
+                               const svn_diff__blame_rev_t *rev,
+                               const char *last_file,
+                               const char *cur_file,
+                               const svn_diff_file_options_t *diff_options,
+                               svn_cancel_func_t cancel_func,
+                               void *cancel_baton,
+                               apr_pool_t *scratch_pool)
+{
+  if (!last_file)
+    {
+      SVN_ERR_ASSERT(chain->blame == NULL);
+      chain->blame = svn_diff__blame_chunk_create(chain, rev, 0);
+    }
+  else
+    {
+      svn_diff_t *diff;
+
+      /* We have a previous file.  Get the diff and adjust blame info. */
+      SVN_ERR(svn_diff_file_diff_2(&diff, last_file, cur_file,
+                                   diff_options, scratch_pool));
+      SVN_ERR(svn_diff__blame_chain_apply(chain, diff, rev,
+                                          cancel_func, cancel_baton));
+    }
+
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_diff__file_blame_create(svn_diff__file_blame_t **blame,
+                            const svn_diff_file_options_t *diff_options,
+                            svn_cancel_func_t cancel_func,
+                            void *cancel_baton,
+                            apr_pool_t *result_pool)
+{
+  svn_diff__file_blame_t *fb = apr_pcalloc(result_pool, sizeof(*fb));
+
+  fb->chain = svn_diff__blame_chain_create(result_pool);
+  fb->diff_options = diff_options
+                   ? diff_options
+                   : svn_diff_file_options_create(result_pool);
+  fb->revs = apr_hash_make(result_pool);
+  fb->cancel_func = cancel_func;
+  fb->cancel_baton = cancel_baton;
+  fb->pool = result_pool;
+
+  *blame = fb;
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_diff__file_blame_add(void *baton,
+                         svn_revnum_t revision,
+                         apr_hash_t *rev_props,
+                         const char *filename,
+                         apr_pool_t *scratch_pool)
+{
+  svn_diff__file_blame_t *fb = baton;
+  svn_diff__blame_rev_t *rev = NULL;
+
+  if (SVN_IS_VALID_REVNUM(revision))
+    {
+      rev = apr_hash_get(fb->revs, &revision, sizeof(revision));
+      if (!rev)
+        {
+          rev = apr_pcalloc(fb->pool, sizeof(*rev));
+          rev->revision = revision;
+          rev->rev_props = rev_props ? svn_prop_hash_dup(rev_props, fb->pool)
+                                     : apr_hash_make(fb->pool);
+          apr_hash_set(fb->revs, &rev->revision, sizeof(rev->revision), rev);
+        }
+    }
+
+  SVN_ERR(svn_diff__blame_chain_add_file(fb->chain, rev, fb->last_filename,
+                                         filename, fb->diff_options,
+                                         fb->cancel_func, fb->cancel_baton,
+                                         scratch_pool));
+
+  fb->last_filename = apr_pstrdup(fb->pool, filename);
+
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_diff__file_blame_report(svn_diff__file_blame_t *blame,
+                            svn_diff__blame_line_func_t receiver,
+                            void *receiver_baton,
+                            apr_pool_t *scratch_pool)
+{
+  svn_diff__blame_chunk_t *walk;
+  svn_stream_t *stream;
+  apr_pool_t *iterpool;
+
+  if (!blame->last_filename)
+    return SVN_NO_ERROR;
+
+  SVN_ERR(svn_stream_open_readonly(&stream, blame->last_filename,
+                                   scratch_pool, scratch_pool));
+  stream = svn_subst_stream_translated(stream, "\n", TRUE, NULL, FALSE,
+                                       scratch_pool);
+
+  iterpool = svn_pool_create(scratch_pool);
+  for (walk = blame->chain->blame; walk; walk = walk->next)
+    {
+      apr_off_t line_no;
+
+      for (line_no = walk->start;
+           !walk->next || line_no < walk->next->start;
+           ++line_no)
+        {
+          svn_boolean_t eof;
+          svn_stringbuf_t *sb;
+
+          svn_pool_clear(iterpool);
+          SVN_ERR(svn_stream_readline(stream, &sb, "\n", &eof, iterpool));
+          if (blame->cancel_func)
+            SVN_ERR(blame->cancel_func(blame->cancel_baton));
+          if (!eof || sb->len)
+            SVN_ERR(receiver(receiver_baton, line_no,
+                             walk->rev ? walk->rev->revision
+                                       : SVN_INVALID_REVNUM,
+                             walk->rev ? walk->rev->rev_props : NULL,
+                             sb->data, iterpool));
+          if (eof)
+            break;
+        }
+    }
+  svn_pool_destroy(iterpool);
+
+  return svn_error_trace(svn_stream_close(stream));
+}
@@ -1475,6 +1475,23 @@ svn_fs_dir_optimal_order(apr_array_header_t **ordered_p,
                                                          scratch_pool));
 }
 
+svn_error_t *
+svn_fs_prefetch_nodes(svn_fs_root_t *root,
+                      const apr_array_header_t *paths,
+                      svn_boolean_t dir_entries,
+                      svn_boolean_t proplists,
+                      apr_pool_t *scratch_pool)
+{
+  /* This is merely a hint, so back-ends may not implement it. */
+  if (root->vtable->prefetch_nodes == NULL)
+    return SVN_NO_ERROR;
+
+  return svn_error_trace(root->vtable->prefetch_nodes(root, paths,
+                                                      dir_entries,
+                                                      proplists,
+                                                      scratch_pool));
+}
+
 svn_error_t *
 svn_fs_make_dir(svn_fs_root_t *root, const char *path, apr_pool_t *pool)
 {
@@ -1564,6 +1581,33 @@ svn_fs_try_process_file_contents(svn_boolean_t *success,
                          processor, baton, pool));
 }
 
+svn_error_t *
+svn_fs__open_stored_delta(apr_file_t **file,
+                          apr_off_t *offset,
+                          svn_filesize_t *length,
+                          int *svndiff_version,
+                          svn_fs_root_t *source_root,
+                          const char *source_path,
+                          svn_fs_root_t *target_root,
+                          const char *target_path,
+                          apr_pool_t *result_pool,
+                          apr_pool_t *scratch_pool)
+{
+  /* Back-ends that don't store svndiff data don't implement this. */
+  if (target_root->vtable->open_stored_delta == NULL
+      || source_root->vtable != target_root->vtable)
+    {
+      *file = NULL;
+      return SVN_NO_ERROR;
+    }
+
+  return svn_error_trace(target_root->vtable->open_stored_delta(
+                           file, offset, length, svndiff_version,
+                           source_root, source_path,
+                           target_root, target_path,
+                           result_pool, scratch_pool));
+}
+
 svn_error_t *
 svn_fs_make_file(svn_fs_root_t *root, const char *path, apr_pool_t *pool)
 {
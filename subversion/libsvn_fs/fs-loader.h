@@ -427,6 +427,25 @@ typedef struct root_vtable_t
                                 svn_fs_mergeinfo_receiver_t receiver,
                                 void *baton,
                                 apr_pool_t *scratch_pool);
+
+  /* Prefetching.  May be NULL. */
+  svn_error_t *(*prefetch_nodes)(svn_fs_root_t *root,
+                                 const apr_array_header_t *paths,
+                                 svn_boolean_t dir_entries,
+                                 svn_boolean_t proplists,
+                                 apr_pool_t *scratch_pool);
+
+  /* Direct access to stored deltas.  May be NULL. */
+  svn_error_t *(*open_stored_delta)(apr_file_t **file,
+                                    apr_off_t *offset,
+                                    svn_filesize_t *length,
+                                    int *svndiff_version,
+                                    svn_fs_root_t *source_root,
+                                    const char *source_path,
+                                    svn_fs_root_t *target_root,
+                                    const char *target_path,
+                                    apr_pool_t *result_pool,
+                                    apr_pool_t *scratch_pool);
 } root_vtable_t;
 
 
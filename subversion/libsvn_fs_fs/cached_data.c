@@ -2210,6 +2210,51 @@ rep_read_contents(void *baton,
   return SVN_NO_ERROR;
 }
 
+/* BATON is of type `rep_read_baton'; skip the next LEN bytes of the
+   representation.  This is a SKIP_FN for svn_stream_t.
+
+   As long as we serve the data from the fulltext cache, skipping is
+   just a matter of moving the read position within the cached text.
+   Should a later lookup fail, skip_contents() will make the window
+   stream catch up.  Otherwise, we have to reconstruct and drop the
+   data to keep the checksum calculation going. */
+static svn_error_t *
+rep_read_skip(void *baton,
+              apr_size_t len)
+{
+  struct rep_read_baton *rb = baton;
+
+  if (rb->fulltext_cache && !rb->rs_list)
+    {
+      svn_filesize_t remaining = rb->rep.expanded_size
+                               - rb->fulltext_delivered;
+
+      rb->fulltext_delivered += MIN((svn_filesize_t)len, remaining);
+    }
+  else
+    {
+      apr_pool_t *subpool = svn_pool_create(rb->pool);
+      char *buffer = apr_palloc(subpool, SVN__STREAM_CHUNK_SIZE);
+
+      while (len > 0)
+        {
+          apr_size_t to_read = MIN(len, SVN__STREAM_CHUNK_SIZE);
+          apr_size_t requested = to_read;
+
+          SVN_ERR(rep_read_contents(rb, buffer, &to_read));
+          len -= to_read;
+
+          /* Short read means EOF. */
+          if (to_read < requested)
+            break;
+        }
+
+      svn_pool_destroy(subpool);
+    }
+
+  return SVN_NO_ERROR;
+}
+
 svn_error_t *
 svn_fs_fs__get_contents(svn_stream_t **contents_p,
                         svn_fs_t *fs,
@@ -2253,6 +2298,7 @@ svn_fs_fs__get_contents(svn_stream_t **contents_p,
       *contents_p = svn_stream_create(rb, pool);
       svn_stream_set_read2(*contents_p, NULL /* only full read support */,
                            rep_read_contents);
+      svn_stream_set_skip(*contents_p, rep_read_skip);
       svn_stream_set_close(*contents_p, rep_read_contents_close);
     }
 
@@ -2381,6 +2427,66 @@ cache_access_wrapper(void **out,
   return SVN_NO_ERROR;
 }
 
+svn_error_t *
+svn_fs_fs__get_stored_delta(apr_file_t **file,
+                            apr_off_t *offset,
+                            svn_filesize_t *length,
+                            int *svndiff_version,
+                            svn_fs_t *fs,
+                            node_revision_t *source,
+                            node_revision_t *target,
+                            apr_pool_t *result_pool,
+                            apr_pool_t *scratch_pool)
+{
+  representation_t *rep = target->data_rep;
+  representation_t *base_rep = source->data_rep;
+  svn_fs_fs__revision_file_t *rev_file;
+  svn_fs_fs__rep_header_t *header;
+  apr_off_t rep_offset;
+  char magic[4];
+
+  *file = NULL;
+
+  /* Reps in a transaction may still change.  Empty files have no rep. */
+  if (!rep || !base_rep
+      || svn_fs_fs__id_txn_used(&rep->txn_id)
+      || svn_fs_fs__id_txn_used(&base_rep->txn_id))
+    return SVN_NO_ERROR;
+
+  SVN_ERR(svn_fs_fs__ensure_revision_exists(rep->revision, fs,
+                                            scratch_pool));
+  SVN_ERR(svn_fs_fs__open_pack_or_rev_file(&rev_file, fs, rep->revision,
+                                           result_pool, scratch_pool));
+  SVN_ERR(svn_fs_fs__item_offset(&rep_offset, fs, rev_file, rep->revision,
+                                 NULL, rep->item_index, scratch_pool));
+  SVN_ERR(aligned_seek(fs, rev_file->file, NULL, rep_offset, scratch_pool));
+  SVN_ERR(svn_fs_fs__read_rep_header(&header, rev_file->stream,
+                                     scratch_pool, scratch_pool));
+
+  /* Only a delta against exactly SOURCE's rep will do. */
+  if (header->type != svn_fs_fs__rep_delta
+      || header->base_revision != base_rep->revision
+      || header->base_item_index != base_rep->item_index
+      || rep->size < (svn_filesize_t)sizeof(magic))
+    return svn_error_trace(svn_fs_fs__close_revision_file(rev_file));
+
+  /* The svndiff data starts with "SVN" and the format version. */
+  rep_offset += header->header_size;
+  SVN_ERR(aligned_seek(fs, rev_file->file, NULL, rep_offset, scratch_pool));
+  SVN_ERR(svn_io_file_read_full2(rev_file->file, magic, sizeof(magic),
+                                 NULL, NULL, scratch_pool));
+  if (memcmp(magic, "SVN", 3) != 0)
+    return svn_error_create(SVN_ERR_FS_CORRUPT, NULL,
+                            _("Malformed svndiff data in representation"));
+
+  *file = rev_file->file;
+  *offset = rep_offset;
+  *length = rep->size;
+  *svndiff_version = magic[3];
+
+  return SVN_NO_ERROR;
+}
+
 svn_error_t *
 svn_fs_fs__try_process_file_contents(svn_boolean_t *success,
                                      svn_fs_t *fs,
@@ -119,6 +119,26 @@ svn_fs_fs__try_process_file_contents(svn_boolean_t *success,
                                      void* baton,
                                      apr_pool_t *pool);
 
+/* If the text representation of node-revision TARGET as seen in
+   filesystem FS is stored as an svndiff delta against the text
+   representation of node-revision SOURCE, set *FILE to a handle for the
+   revision or pack file containing it and return the position and length
+   of the svndiff data (including its header) within it in *OFFSET and
+   *LENGTH, and the svndiff format version in *SVNDIFF_VERSION.
+   Otherwise, set *FILE to NULL.  Allocate *FILE in RESULT_POOL and use
+   SCRATCH_POOL for temporaries.
+ */
+svn_error_t *
+svn_fs_fs__get_stored_delta(apr_file_t **file,
+                            apr_off_t *offset,
+                            svn_filesize_t *length,
+                            int *svndiff_version,
+                            svn_fs_t *fs,
+                            node_revision_t *source,
+                            node_revision_t *target,
+                            apr_pool_t *result_pool,
+                            apr_pool_t *scratch_pool);
+
 /* Set *STREAM_P to a delta stream turning the contents of the file SOURCE into
    the contents of the file TARGET, allocated in POOL.
    If SOURCE is null, the empty string will be used. */
@@ -1002,6 +1002,38 @@ svn_fs_fs__dag_get_file_delta_stream(svn_txdelta_stream_t **stream_p,
 }
 
 
+svn_error_t *
+svn_fs_fs__dag_get_stored_delta(apr_file_t **file,
+                                apr_off_t *offset,
+                                svn_filesize_t *length,
+                                int *svndiff_version,
+                                dag_node_t *source,
+                                dag_node_t *target,
+                                apr_pool_t *result_pool,
+                                apr_pool_t *scratch_pool)
+{
+  node_revision_t *src_noderev;
+  node_revision_t *tgt_noderev;
+
+  /* Make sure our nodes are files. */
+  if (source->kind != svn_node_file || target->kind != svn_node_file)
+    return svn_error_createf
+      (SVN_ERR_FS_NOT_FILE, NULL,
+       "Attempted to get textual contents of a *non*-file node");
+
+  SVN_ERR(get_node_revision(&src_noderev, source));
+  SVN_ERR(get_node_revision(&tgt_noderev, target));
+
+  return svn_error_trace(svn_fs_fs__get_stored_delta(file, offset, length,
+                                                     svndiff_version,
+                                                     target->fs,
+                                                     src_noderev,
+                                                     tgt_noderev,
+                                                     result_pool,
+                                                     scratch_pool));
+}
+
+
 svn_error_t *
 svn_fs_fs__dag_try_process_file_contents(svn_boolean_t *success,
                                          dag_node_t *node,
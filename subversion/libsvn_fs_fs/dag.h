@@ -284,7 +284,6 @@ svn_error_t *svn_fs_fs__dag_dir_entries(apr_array_header_t **entries_p,
    RESULT_POOL.  Temporary data will be used in SCRATCH_POOL.
    Otherwise, the *DIRENT will be set to NULL.
  */
-/* ### This function is currently only called from dag.c. */
 svn_error_t * svn_fs_fs__dag_dir_entry(svn_fs_dirent_t **dirent,
                                        dag_node_t *node,
                                        const char* name,
@@ -427,6 +426,25 @@ svn_fs_fs__dag_try_process_file_contents(svn_boolean_t *success,
                                          apr_pool_t *pool);
 
 
+/* If the contents of the file TARGET are stored as an svndiff delta
+   against the contents of the file SOURCE, set *FILE to a handle for the
+   revision or pack file containing it and return the position, length
+   and format version of the svndiff data in *OFFSET, *LENGTH and
+   *SVNDIFF_VERSION.  Otherwise, set *FILE to NULL.
+
+   Allocate *FILE in RESULT_POOL and use SCRATCH_POOL for temporaries.
+ */
+svn_error_t *
+svn_fs_fs__dag_get_stored_delta(apr_file_t **file,
+                                apr_off_t *offset,
+                                svn_filesize_t *length,
+                                int *svndiff_version,
+                                dag_node_t *source,
+                                dag_node_t *target,
+                                apr_pool_t *result_pool,
+                                apr_pool_t *scratch_pool);
+
+
 /* Set *STREAM_P to a delta stream that will turn the contents of SOURCE into
    the contents of TARGET, allocated in POOL.  If SOURCE is null, the empty
    string will be used.
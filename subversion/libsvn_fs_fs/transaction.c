@@ -45,6 +45,7 @@
 
 #include "private/svn_fs_util.h"
 #include "private/svn_fspath.h"
+#include "private/svn_io_private.h"
 #include "private/svn_sorts_private.h"
 #include "private/svn_subr_private.h"
 #include "private/svn_string_private.h"
@@ -1914,7 +1915,7 @@ struct rep_write_baton
   svn_stream_t *rep_stream;
 
   /* A stream from the delta combiner.  Data written here gets
-     deltified, then eventually written to rep_stream. */
+     checksummed and deltified, then eventually written to rep_stream. */
   svn_stream_t *delta_stream;
 
   /* Where is this representation header stored. */
@@ -1923,7 +1924,8 @@ struct rep_write_baton
   /* Start of the actual data. */
   apr_off_t delta_start;
 
-  /* How many bytes have been written to this rep already. */
+  /* How many bytes have been written to this rep.  Only valid after
+     DELTA_STREAM has been closed. */
   svn_filesize_t rep_size;
 
   /* The node revision for which we're writing out info. */
@@ -1935,8 +1937,9 @@ struct rep_write_baton
      writing to it. */
   void *lockcookie;
 
-  svn_checksum_ctx_t *md5_checksum_ctx;
-  svn_checksum_ctx_t *sha1_checksum_ctx;
+  /* MD5 and SHA1 of the contents.  Set when DELTA_STREAM gets closed. */
+  svn_checksum_t *md5_checksum;
+  svn_checksum_t *sha1_checksum;
 
   /* calculate a modified FNV-1a checksum of the on-disk representation */
   svn_checksum_ctx_t *fnv1a_checksum_ctx;
@@ -1958,15 +1961,7 @@ rep_write_contents(void *baton,
 {
   struct rep_write_baton *b = baton;
 
-  SVN_ERR(svn_checksum_update(b->md5_checksum_ctx, data, *len));
-  SVN_ERR(svn_checksum_update(b->sha1_checksum_ctx, data, *len));
-  b->rep_size += *len;
-
-  /* If we are writing a delta, use that stream. */
-  if (b->delta_stream)
-    return svn_stream_write(b->delta_stream, data, len);
-  else
-    return svn_stream_write(b->rep_stream, data, len);
+  return svn_stream_write(b->delta_stream, data, len);
 }
 
 /* Set *SPANNED to the number of shards touched when walking WALK steps on
@@ -2205,12 +2200,12 @@ rep_write_get_baton(struct rep_write_baton **wb_p,
   svn_txdelta_window_handler_t wh;
   void *whb;
   svn_fs_fs__rep_header_t header = { 0 };
+  svn_checksum_t **checksums[2];
+  const svn_checksum_kind_t kinds[2] = { svn_checksum_md5,
+                                         svn_checksum_sha1 };
 
   b = apr_pcalloc(pool, sizeof(*b));
 
-  b->sha1_checksum_ctx = svn_checksum_ctx_create(svn_checksum_sha1, pool);
-  b->md5_checksum_ctx = svn_checksum_ctx_create(svn_checksum_md5, pool);
-
   b->fs = fs;
   b->result_pool = pool;
   b->scratch_pool = svn_pool_create(pool);
@@ -2264,6 +2259,13 @@ rep_write_get_baton(struct rep_write_baton **wb_p,
   b->delta_stream = svn_txdelta_target_push(wh, whb, source,
                                             b->scratch_pool);
 
+  /* Calculate both digests and the expanded size in a single pass. */
+  checksums[0] = &b->md5_checksum;
+  checksums[1] = &b->sha1_checksum;
+  b->delta_stream = svn_stream__checksummed(b->delta_stream, checksums, kinds,
+                                            2, &b->rep_size, FALSE,
+                                            b->scratch_pool);
+
   *wb_p = b;
 
   return SVN_NO_ERROR;
@@ -2483,28 +2485,18 @@ get_shared_rep(representation_t **old_rep,
   return SVN_NO_ERROR;
 }
 
-/* Copy the hash sum calculation results from MD5_CTX, SHA1_CTX into REP.
- * SHA1 results are only be set if SHA1_CTX is not NULL.
- * Use POOL for allocations.
+/* Copy the hash sum calculation results MD5, SHA1 into REP.
+ * SHA1 results are only be set if SHA1 is not NULL.
  */
-static svn_error_t *
+static void
 digests_final(representation_t *rep,
-              const svn_checksum_ctx_t *md5_ctx,
-              const svn_checksum_ctx_t *sha1_ctx,
-              apr_pool_t *pool)
+              const svn_checksum_t *md5,
+              const svn_checksum_t *sha1)
 {
-  svn_checksum_t *checksum;
-
-  SVN_ERR(svn_checksum_final(&checksum, md5_ctx, pool));
-  memcpy(rep->md5_digest, checksum->digest, svn_checksum_size(checksum));
-  rep->has_sha1 = sha1_ctx != NULL;
+  memcpy(rep->md5_digest, md5->digest, svn_checksum_size(md5));
+  rep->has_sha1 = sha1 != NULL;
   if (rep->has_sha1)
-    {
-      SVN_ERR(svn_checksum_final(&checksum, sha1_ctx, pool));
-      memcpy(rep->sha1_digest, checksum->digest, svn_checksum_size(checksum));
-    }
-
-  return SVN_NO_ERROR;
+    memcpy(rep->sha1_digest, sha1->digest, svn_checksum_size(sha1));
 }
 
 /* Close handler for the representation write stream.  BATON is a
@@ -2521,9 +2513,8 @@ rep_write_contents_close(void *baton)
   rep = apr_pcalloc(b->result_pool, sizeof(*rep));
 
   /* Close our delta stream so the last bits of svndiff are written
-     out. */
-  if (b->delta_stream)
-    SVN_ERR(svn_stream_close(b->delta_stream));
+     out and the digests get finalized. */
+  SVN_ERR(svn_stream_close(b->delta_stream));
 
   /* Determine the length of the svndiff data. */
   SVN_ERR(svn_io_file_get_offset(&offset, b->file, b->scratch_pool));
@@ -2535,9 +2526,8 @@ rep_write_contents_close(void *baton)
   SVN_ERR(set_uniquifier(b->fs, rep, b->scratch_pool));
   rep->revision = SVN_INVALID_REVNUM;
 
-  /* Finalize the checksum. */
-  SVN_ERR(digests_final(rep, b->md5_checksum_ctx, b->sha1_checksum_ctx,
-                        b->result_pool));
+  /* Store the checksums. */
+  digests_final(rep, b->md5_checksum, b->sha1_checksum);
 
   /* Check and see if we already have a representation somewhere that's
      identical to the one we just wrote out. */
@@ -2706,37 +2696,40 @@ svn_fs_fs__set_proplist(svn_fs_t *fs,
   return SVN_NO_ERROR;
 }
 
-/* This baton is used by the stream created for write_container_rep. */
-struct write_container_baton
+/* Digests and size of a container representation, as calculated by
+   the stream returned from container_checksummed_stream(). */
+typedef struct container_digests_t
 {
-  svn_stream_t *stream;
-
-  apr_size_t size;
-
-  svn_checksum_ctx_t *md5_ctx;
+  svn_checksum_t *md5;
 
   /* SHA1 calculation is optional. If not needed, this will be NULL. */
-  svn_checksum_ctx_t *sha1_ctx;
-};
-
-/* The handler for the write_container_rep stream.  BATON is a
-   write_container_baton, DATA has the data to write and *LEN is the number
-   of bytes to write. */
-static svn_error_t *
-write_container_handler(void *baton,
-                        const char *data,
-                        apr_size_t *len)
-{
-  struct write_container_baton *whb = baton;
-
-  SVN_ERR(svn_checksum_update(whb->md5_ctx, data, *len));
-  if (whb->sha1_ctx)
-    SVN_ERR(svn_checksum_update(whb->sha1_ctx, data, *len));
+  svn_checksum_t *sha1;
 
-  SVN_ERR(svn_stream_write(whb->stream, data, len));
-  whb->size += *len;
+  svn_filesize_t size;
+} container_digests_t;
 
-  return SVN_NO_ERROR;
+/* Return a stream wrapping STREAM that records MD5, size and - unless
+   ITEM_TYPE is a directory representation - SHA1 of the data written to
+   it in *DIGESTS once it is closed.  Allocate it in POOL. */
+static svn_stream_t *
+container_checksummed_stream(container_digests_t *digests,
+                             svn_stream_t *stream,
+                             apr_uint32_t item_type,
+                             apr_pool_t *pool)
+{
+  svn_checksum_t **checksums[2];
+  const svn_checksum_kind_t kinds[2] = { svn_checksum_md5,
+                                         svn_checksum_sha1 };
+
+  checksums[0] = &digests->md5;
+  checksums[1] = &digests->sha1;
+  digests->sha1 = NULL;
+  digests->size = 0;
+
+  return svn_stream__checksummed(stream, checksums, kinds,
+                                 item_type == SVN_FS_FS__ITEM_TYPE_DIR_REP
+                                   ? 1 : 2,
+                                 &digests->size, FALSE, pool);
 }
 
 /* Callback function type.  Write the data provided by BATON into STREAM. */
@@ -2793,39 +2786,37 @@ write_container_rep(representation_t *rep,
                     apr_uint32_t item_type,
                     apr_pool_t *scratch_pool)
 {
+  svn_stream_t *file_stream;
   svn_stream_t *stream;
-  struct write_container_baton *whb;
+  container_digests_t digests;
   svn_checksum_ctx_t *fnv1a_checksum_ctx;
   apr_off_t offset = 0;
 
   SVN_ERR(svn_io_file_get_offset(&offset, file, scratch_pool));
 
-  whb = apr_pcalloc(scratch_pool, sizeof(*whb));
-
-  whb->stream = svn_stream_from_aprfile2(file, TRUE, scratch_pool);
+  file_stream = svn_stream_from_aprfile2(file, TRUE, scratch_pool);
   if (svn_fs_fs__use_log_addressing(fs))
-    whb->stream = fnv1a_wrap_stream(&fnv1a_checksum_ctx, whb->stream,
+    file_stream = fnv1a_wrap_stream(&fnv1a_checksum_ctx, file_stream,
                                     scratch_pool);
   else
     fnv1a_checksum_ctx = NULL;
-  whb->size = 0;
-  whb->md5_ctx = svn_checksum_ctx_create(svn_checksum_md5, scratch_pool);
-  if (item_type != SVN_FS_FS__ITEM_TYPE_DIR_REP)
-    whb->sha1_ctx = svn_checksum_ctx_create(svn_checksum_sha1, scratch_pool);
 
-  stream = svn_stream_create(whb, scratch_pool);
-  svn_stream_set_write(stream, write_container_handler);
+  stream = container_checksummed_stream(&digests,
+                                        svn_stream_disown(file_stream,
+                                                          scratch_pool),
+                                        item_type, scratch_pool);
 
-  SVN_ERR(svn_stream_puts(whb->stream, "PLAIN\n"));
+  SVN_ERR(svn_stream_puts(file_stream, "PLAIN\n"));
 
   SVN_ERR(writer(stream, collection, scratch_pool));
+  SVN_ERR(svn_stream_close(stream));
 
   /* Store the results. */
-  SVN_ERR(digests_final(rep, whb->md5_ctx, whb->sha1_ctx, scratch_pool));
+  digests_final(rep, digests.md5, digests.sha1);
 
   /* Update size info. */
-  rep->expanded_size = whb->size;
-  rep->size = whb->size;
+  rep->expanded_size = digests.size;
+  rep->size = digests.size;
 
   /* Check and see if we already have a representation somewhere that's
      identical to the one we just wrote out. */
@@ -2847,7 +2838,7 @@ write_container_rep(representation_t *rep,
     }
 
   /* Write out our cosmetic end marker. */
-  SVN_ERR(svn_stream_puts(whb->stream, "ENDREP\n"));
+  SVN_ERR(svn_stream_puts(file_stream, "ENDREP\n"));
 
   SVN_ERR(allocate_item_index(&rep->item_index, fs, &rep->txn_id,
                               offset, scratch_pool));
@@ -2914,7 +2905,7 @@ write_container_delta_rep(representation_t *rep,
   apr_off_t delta_start = 0;
   apr_off_t offset = 0;
 
-  struct write_container_baton *whb;
+  container_digests_t digests;
   svn_boolean_t is_props = (item_type == SVN_FS_FS__ITEM_TYPE_FILE_PROPS)
                         || (item_type == SVN_FS_FS__ITEM_TYPE_DIR_PROPS);
 
@@ -2949,28 +2940,21 @@ write_container_delta_rep(representation_t *rep,
   /* Prepare to write the svndiff data. */
   txdelta_to_svndiff(&diff_wh, &diff_whb, file_stream, fs, scratch_pool);
 
-  whb = apr_pcalloc(scratch_pool, sizeof(*whb));
-  whb->stream = svn_txdelta_target_push(diff_wh, diff_whb, source,
+  stream = svn_txdelta_target_push(diff_wh, diff_whb, source, scratch_pool);
+  stream = container_checksummed_stream(&digests, stream, item_type,
                                         scratch_pool);
-  whb->size = 0;
-  whb->md5_ctx = svn_checksum_ctx_create(svn_checksum_md5, scratch_pool);
-  if (item_type != SVN_FS_FS__ITEM_TYPE_DIR_REP)
-    whb->sha1_ctx = svn_checksum_ctx_create(svn_checksum_sha1, scratch_pool);
 
   /* serialize the hash */
-  stream = svn_stream_create(whb, scratch_pool);
-  svn_stream_set_write(stream, write_container_handler);
-
   SVN_ERR(writer(stream, collection, scratch_pool));
-  SVN_ERR(svn_stream_close(whb->stream));
+  SVN_ERR(svn_stream_close(stream));
 
   /* Store the results. */
-  SVN_ERR(digests_final(rep, whb->md5_ctx, whb->sha1_ctx, scratch_pool));
+  digests_final(rep, digests.md5, digests.sha1);
 
   /* Update size info. */
   SVN_ERR(svn_io_file_get_offset(&rep_end, file, scratch_pool));
   rep->size = rep_end - delta_start;
-  rep->expanded_size = whb->size;
+  rep->expanded_size = digests.size;
 
   /* Check and see if we already have a representation somewhere that's
      identical to the one we just wrote out. */
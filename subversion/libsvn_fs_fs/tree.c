@@ -58,6 +58,7 @@
 #include "tree.h"
 #include "fs_fs.h"
 #include "id.h"
+#include "index.h"
 #include "pack.h"
 #include "temp_serializer.h"
 #include "transaction.h"
@@ -65,6 +66,7 @@
 
 #include "private/svn_mergeinfo_private.h"
 #include "private/svn_subr_private.h"
+#include "private/svn_sorts_private.h"
 #include "private/svn_fs_util.h"
 #include "private/svn_fspath.h"
 #include "../libsvn_fs/fs-loader.h"
@@ -2963,6 +2965,45 @@ fs_try_process_file_contents(svn_boolean_t *success,
 /* --- End machinery for svn_fs_try_process_file_contents() ---  */
 
 
+/* --- Machinery for svn_fs__open_stored_delta() ---  */
+
+static svn_error_t *
+fs_open_stored_delta(apr_file_t **file,
+                     apr_off_t *offset,
+                     svn_filesize_t *length,
+                     int *svndiff_version,
+                     svn_fs_root_t *source_root,
+                     const char *source_path,
+                     svn_fs_root_t *target_root,
+                     const char *target_path,
+                     apr_pool_t *result_pool,
+                     apr_pool_t *scratch_pool)
+{
+  dag_node_t *source_node, *target_node;
+
+  /* Transaction contents may change under our feet. */
+  if (source_root->is_txn_root || target_root->is_txn_root
+      || source_root->fs != target_root->fs)
+    {
+      *file = NULL;
+      return SVN_NO_ERROR;
+    }
+
+  SVN_ERR(get_dag(&source_node, source_root, source_path, scratch_pool));
+  SVN_ERR(get_dag(&target_node, target_root, target_path, scratch_pool));
+
+  return svn_error_trace(svn_fs_fs__dag_get_stored_delta(file, offset,
+                                                         length,
+                                                         svndiff_version,
+                                                         source_node,
+                                                         target_node,
+                                                         result_pool,
+                                                         scratch_pool));
+}
+
+/* --- End machinery for svn_fs__open_stored_delta() ---  */
+
+
 /* --- Machinery for svn_fs_apply_textdelta() ---  */
 
 
@@ -4544,6 +4585,252 @@ fs_get_mergeinfo(svn_fs_root_t *root,
 }
 
 
+/* Prefetching.  */
+
+/* A node revision or representation to be read by fs_prefetch_nodes(). */
+typedef struct prefetch_item_t
+{
+  /* Location of the item within the repository. */
+  svn_revnum_t revision;
+  apr_uint64_t item_index;
+
+  /* First revision stored in the rev / pack file containing the item and
+     the item's offset within that file. */
+  svn_revnum_t file_rev;
+  apr_off_t offset;
+
+  /* The node revision the item belongs to.  NODEREV is NULL until that
+     has been read. */
+  const svn_fs_id_t *id;
+  node_revision_t *noderev;
+
+  /* For representations: TRUE for the property list, FALSE for the
+     directory contents. */
+  svn_boolean_t is_proplist;
+} prefetch_item_t;
+
+/* Sort function ordering prefetch_item_t * by file and offset. */
+static int
+compare_prefetch_items(const void *a,
+                       const void *b)
+{
+  const prefetch_item_t *lhs = *(const prefetch_item_t * const *)a;
+  const prefetch_item_t *rhs = *(const prefetch_item_t * const *)b;
+
+  if (lhs->file_rev != rhs->file_rev)
+    return lhs->file_rev < rhs->file_rev ? -1 : 1;
+  if (lhs->offset != rhs->offset)
+    return lhs->offset < rhs->offset ? -1 : 1;
+
+  return 0;
+}
+
+/* Sort the prefetch_item_t * in ITEMS by the position of the respective
+   items in the rev and pack files of FS.  Use SCRATCH_POOL for temporary
+   allocations. */
+static svn_error_t *
+sort_by_location(apr_array_header_t *items,
+                 svn_fs_t *fs,
+                 apr_pool_t *scratch_pool)
+{
+  svn_fs_fs__revision_file_t *rev_file = NULL;
+  apr_pool_t *iterpool = svn_pool_create(scratch_pool);
+  int i;
+
+  /* Group by file first, so we need to open each of them only once. */
+  for (i = 0; i < items->nelts; ++i)
+    {
+      prefetch_item_t *item = APR_ARRAY_IDX(items, i, prefetch_item_t *);
+
+      item->file_rev = svn_fs_fs__is_packed_rev(fs, item->revision)
+                     ? svn_fs_fs__packed_base_rev(fs, item->revision)
+                     : item->revision;
+      item->offset = 0;
+    }
+  svn_sort__array(items, compare_prefetch_items);
+
+  /* Physical addressing doesn't require the file to be open. */
+  for (i = 0; i < items->nelts; ++i)
+    {
+      prefetch_item_t *item = APR_ARRAY_IDX(items, i, prefetch_item_t *);
+
+      if (svn_fs_fs__use_log_addressing(fs)
+          && (!rev_file || rev_file->start_revision != item->file_rev))
+        {
+          if (rev_file)
+            SVN_ERR(svn_fs_fs__close_revision_file(rev_file));
+
+          svn_pool_clear(iterpool);
+          SVN_ERR(svn_fs_fs__open_pack_or_rev_file(&rev_file, fs,
+                                                   item->revision,
+                                                   iterpool, iterpool));
+        }
+
+      SVN_ERR(svn_fs_fs__item_offset(&item->offset, fs, rev_file,
+                                     item->revision, NULL, item->item_index,
+                                     scratch_pool));
+    }
+
+  if (rev_file)
+    SVN_ERR(svn_fs_fs__close_revision_file(rev_file));
+  svn_pool_destroy(iterpool);
+
+  svn_sort__array(items, compare_prefetch_items);
+
+  return SVN_NO_ERROR;
+}
+
+/* Add the representation REP of node ITEM->NODEREV to REPS, unless it
+   is still part of a transaction.  IS_PROPLIST tells what REP is.
+   Allocate the new entry in RESULT_POOL. */
+static void
+add_prefetch_rep(apr_array_header_t *reps,
+                 prefetch_item_t *item,
+                 representation_t *rep,
+                 svn_boolean_t is_proplist,
+                 apr_pool_t *result_pool)
+{
+  prefetch_item_t *rep_item;
+
+  if (!rep || svn_fs_fs__id_txn_used(&rep->txn_id))
+    return;
+
+  rep_item = apr_pcalloc(result_pool, sizeof(*rep_item));
+  rep_item->revision = rep->revision;
+  rep_item->item_index = rep->item_index;
+  rep_item->id = item->id;
+  rep_item->noderev = item->noderev;
+  rep_item->is_proplist = is_proplist;
+
+  APR_ARRAY_PUSH(reps, prefetch_item_t *) = rep_item;
+}
+
+/* Implements svn_fs_prefetch_nodes.
+
+   We look up the node IDs in the parent directories, which the caller
+   usually has just read, and then read all node revisions and after that
+   all requested representations in the order they are stored on disk.
+   Everything read ends up in the FS caches, where the caller's
+   subsequent requests will find it. */
+static svn_error_t *
+fs_prefetch_nodes(svn_fs_root_t *root,
+                  const apr_array_header_t *paths,
+                  svn_boolean_t dir_entries,
+                  svn_boolean_t proplists,
+                  apr_pool_t *scratch_pool)
+{
+  svn_fs_t *fs = root->fs;
+  apr_array_header_t *nodes
+    = apr_array_make(scratch_pool, paths->nelts, sizeof(prefetch_item_t *));
+  apr_array_header_t *reps
+    = apr_array_make(scratch_pool, paths->nelts, sizeof(prefetch_item_t *));
+  apr_pool_t *iterpool = svn_pool_create(scratch_pool);
+  int i;
+
+  for (i = 0; i < paths->nelts; ++i)
+    {
+      const char *path;
+      const svn_fs_id_t *id;
+      const svn_fs_fs__id_part_t *rev_item;
+      prefetch_item_t *item;
+      dag_node_t *node;
+      svn_error_t *err;
+
+      svn_pool_clear(iterpool);
+      path = svn_fs__canonicalize_abspath(APR_ARRAY_IDX(paths, i,
+                                                        const char *),
+                                          iterpool);
+
+      /* Don't touch the node itself, only its parent. */
+      if (svn_fspath__is_root(path, strlen(path)))
+        {
+          SVN_ERR(get_dag(&node, root, path, iterpool));
+          id = svn_fs_fs__dag_get_id(node);
+        }
+      else
+        {
+          svn_fs_dirent_t *dirent;
+
+          err = get_dag(&node, root, svn_fspath__dirname(path, iterpool),
+                        iterpool);
+          if (err && (err->apr_err == SVN_ERR_FS_NOT_FOUND
+                      || err->apr_err == SVN_ERR_FS_NOT_DIRECTORY))
+            {
+              svn_error_clear(err);
+              continue;
+            }
+          SVN_ERR(err);
+
+          if (svn_fs_fs__dag_node_kind(node) != svn_node_dir)
+            continue;
+
+          SVN_ERR(svn_fs_fs__dag_dir_entry(&dirent, node,
+                                           svn_fspath__basename(path, NULL),
+                                           iterpool, iterpool));
+          if (!dirent)
+            continue;
+
+          id = dirent->id;
+        }
+
+      /* Mutable nodes are not cached and cheap to read anyway. */
+      if (svn_fs_fs__id_is_txn(id))
+        continue;
+
+      rev_item = svn_fs_fs__id_rev_item(id);
+      item = apr_pcalloc(scratch_pool, sizeof(*item));
+      item->revision = rev_item->revision;
+      item->item_index = rev_item->number;
+      item->id = svn_fs_fs__id_copy(id, scratch_pool);
+
+      APR_ARRAY_PUSH(nodes, prefetch_item_t *) = item;
+    }
+
+  /* Read the node revisions in storage order. */
+  SVN_ERR(sort_by_location(nodes, fs, scratch_pool));
+  for (i = 0; i < nodes->nelts; ++i)
+    {
+      prefetch_item_t *item = APR_ARRAY_IDX(nodes, i, prefetch_item_t *);
+
+      svn_pool_clear(iterpool);
+      SVN_ERR(svn_fs_fs__get_node_revision(&item->noderev, fs, item->id,
+                                           scratch_pool, iterpool));
+
+      if (dir_entries && item->noderev->kind == svn_node_dir)
+        add_prefetch_rep(reps, item, item->noderev->data_rep, FALSE,
+                         scratch_pool);
+      if (proplists)
+        add_prefetch_rep(reps, item, item->noderev->prop_rep, TRUE,
+                         scratch_pool);
+    }
+
+  /* Now, read the requested representations in storage order. */
+  SVN_ERR(sort_by_location(reps, fs, scratch_pool));
+  for (i = 0; i < reps->nelts; ++i)
+    {
+      prefetch_item_t *item = APR_ARRAY_IDX(reps, i, prefetch_item_t *);
+
+      svn_pool_clear(iterpool);
+      if (item->is_proplist)
+        {
+          apr_hash_t *proplist;
+          SVN_ERR(svn_fs_fs__get_proplist(&proplist, fs, item->noderev,
+                                          iterpool));
+        }
+      else
+        {
+          apr_array_header_t *entries;
+          SVN_ERR(svn_fs_fs__rep_contents_dir(&entries, fs, item->noderev,
+                                              iterpool, iterpool));
+        }
+    }
+
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
+
+
 /* The vtable associated with root objects. */
 static root_vtable_t root_vtable = {
   fs_paths_changed,
@@ -4579,6 +4866,8 @@ static root_vtable_t root_vtable = {
   fs_get_file_delta_stream,
   fs_merge,
   fs_get_mergeinfo,
+  fs_prefetch_nodes,
+  fs_open_stored_delta,
 };
 
 /* Construct a new root object in FS, allocated from POOL.  */
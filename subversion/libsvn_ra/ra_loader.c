@@ -65,7 +65,11 @@
  * (Currently, this applies to the https scheme, which is only
  * available if SSL is supported.) */
 static const char * const dav_schemes[] = { "http", "https", NULL };
+#ifdef SVN_HAVE_OPENSSL
+static const char * const svn_schemes[] = { "svn", "svns", NULL };
+#else
 static const char * const svn_schemes[] = { "svn", NULL };
+#endif
 static const char * const local_schemes[] = { "file", NULL };
 
 static const struct ra_lib_defn {
@@ -668,6 +672,95 @@ svn_ra_list(svn_ra_session_t *session,
                                scratch_pool);
 }
 
+svn_error_t *
+svn_ra_blame(svn_ra_session_t *session,
+             const char *path,
+             svn_revnum_t start,
+             svn_revnum_t end,
+             const svn_diff_file_options_t *diff_options,
+             svn_ra_blame_receiver_t receiver,
+             void *receiver_baton,
+             apr_pool_t *scratch_pool)
+{
+  SVN_ERR_ASSERT(svn_relpath_is_canonical(path));
+  SVN_ERR_ASSERT(SVN_IS_VALID_REVNUM(start) && SVN_IS_VALID_REVNUM(end));
+  SVN_ERR_ASSERT(start <= end);
+  if (!session->vtable->blame)
+    return svn_error_create(SVN_ERR_UNSUPPORTED_FEATURE, NULL, NULL);
+
+  SVN_ERR(svn_ra__assert_capable_server(session, SVN_RA_CAPABILITY_BLAME,
+                                        NULL, scratch_pool));
+
+  return session->vtable->blame(session, path, start, end, diff_options,
+                                receiver, receiver_baton, scratch_pool);
+}
+
+svn_error_t *
+svn_ra__get_nodes(svn_ra_session_t *session,
+                  apr_array_header_t *requests,
+                  svn_revnum_t revision,
+                  svn_boolean_t want_dirents,
+                  svn_boolean_t want_props,
+                  apr_uint32_t dirent_fields,
+                  apr_pool_t *result_pool,
+                  apr_pool_t *scratch_pool)
+{
+  svn_error_t *err = SVN_NO_ERROR;
+  int i;
+
+  SVN_ERR_ASSERT(SVN_IS_VALID_REVNUM(revision));
+  for (i = 0; i < requests->nelts; i++)
+    {
+      svn_ra__node_request_t *request
+        = APR_ARRAY_IDX(requests, i, svn_ra__node_request_t *);
+
+      SVN_ERR_ASSERT(svn_relpath_is_canonical(request->path));
+      SVN_ERR_ASSERT(request->kind == svn_node_dir
+                     || request->kind == svn_node_file);
+      request->dirents = NULL;
+      request->props = NULL;
+    }
+
+  if (session->vtable->get_nodes)
+    return session->vtable->get_nodes(session, requests, revision,
+                                      want_dirents, want_props, dirent_fields,
+                                      result_pool, scratch_pool);
+
+  for (i = 0; i < requests->nelts; i++)
+    {
+      svn_ra__node_request_t *request
+        = APR_ARRAY_IDX(requests, i, svn_ra__node_request_t *);
+      apr_hash_t *dirents = NULL, *props = NULL;
+      svn_error_t *request_err;
+
+      if (request->kind == svn_node_dir)
+        request_err = session->vtable->get_dir(session,
+                                               want_dirents ? &dirents : NULL,
+                                               NULL,
+                                               want_props ? &props : NULL,
+                                               request->path, revision,
+                                               dirent_fields, result_pool);
+      else
+        request_err = session->vtable->get_file(session, request->path,
+                                                revision, NULL, NULL,
+                                                want_props ? &props : NULL,
+                                                result_pool);
+
+      /* Report the first error, like a plain sequence of calls would. */
+      if (request_err && err)
+        svn_error_clear(request_err);
+      else if (request_err)
+        err = request_err;
+      else
+        {
+          request->dirents = dirents;
+          request->props = props;
+        }
+    }
+
+  return svn_error_trace(err);
+}
+
 svn_error_t *svn_ra_get_mergeinfo(svn_ra_session_t *session,
                                   svn_mergeinfo_catalog_t *catalog,
                                   const apr_array_header_t *paths,
@@ -343,6 +343,27 @@ typedef struct svn_ra__vtable_t {
                        void *receiver_baton,
                        apr_pool_t *scratch_pool);
 
+  /* See svn_ra_blame(). */
+  svn_error_t *(*blame)(svn_ra_session_t *session,
+                        const char *path,
+                        svn_revnum_t start,
+                        svn_revnum_t end,
+                        const svn_diff_file_options_t *diff_options,
+                        svn_ra_blame_receiver_t receiver,
+                        void *receiver_baton,
+                        apr_pool_t *scratch_pool);
+
+  /* See svn_ra__get_nodes().  May be NULL, in which case the nodes are
+     fetched one by one. */
+  svn_error_t *(*get_nodes)(svn_ra_session_t *session,
+                            apr_array_header_t *requests,
+                            svn_revnum_t revision,
+                            svn_boolean_t want_dirents,
+                            svn_boolean_t want_props,
+                            apr_uint32_t dirent_fields,
+                            apr_pool_t *result_pool,
+                            apr_pool_t *scratch_pool);
+
   /* Experimental support below here */
 
   /* See svn_ra__register_editor_shim_callbacks() */
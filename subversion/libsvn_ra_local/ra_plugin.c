@@ -1685,6 +1685,12 @@ svn_ra_local__has_capability(svn_ra_session_t *session,
                                        SVN_REPOS_CAPABILITY_MERGEINFO,
                                        pool));
     }
+  else if (strcmp(capability, SVN_RA_CAPABILITY_BLAME) == 0)
+    {
+      /* The client has the same local access to all file revisions that
+         the repository layer has, so it can calculate the blame itself. */
+      *has = FALSE;
+    }
   else  /* Don't know any other capabilities, so error. */
     {
       return svn_error_createf
@@ -1914,6 +1920,8 @@ static const svn_ra__vtable_t ra_local_vtable =
   svn_ra_local__get_inherited_props,
   NULL /* set_svn_ra_open */,
   svn_ra_local__list ,
+  NULL /* blame */,
+  NULL /* get_nodes */,
   svn_ra_local__register_editor_shim_callbacks,
   svn_ra_local__get_commit_ev2,
   NULL /* replay_range_ev2 */
@@ -0,0 +1,151 @@
+/*
+ * binframe.c: Splitting binary txdelta frames out of update reports.
+ *
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ */
+
+
+#include <string.h>
+
+#include <apr_pools.h>
+
+#include "svn_types.h"
+#include "svn_error.h"
+#include "svn_ctype.h"
+#include "svn_sorts.h"
+
+#include "svn_private_config.h"
+#include "private/svn_dav_protocol.h"
+
+#include "binframe.h"
+
+struct svn_ra_serf__binframe_parser_t
+{
+  svn_ra_serf__binframe_data_t xml_func;
+  svn_ra_serf__binframe_data_t payload_func;
+  void *baton;
+
+  /* The frame header being read, and how much of it we have. */
+  unsigned char header[SVN_DAV__BINARY_FRAME_HEADER_LEN];
+  apr_size_t header_len;
+
+  /* Payload bytes left in the current frame. */
+  apr_size_t frame_remaining;
+};
+
+svn_ra_serf__binframe_parser_t *
+svn_ra_serf__binframe_parser_create(svn_ra_serf__binframe_data_t xml_func,
+                                    svn_ra_serf__binframe_data_t payload_func,
+                                    void *baton,
+                                    apr_pool_t *result_pool)
+{
+  svn_ra_serf__binframe_parser_t *parser;
+
+  parser = apr_pcalloc(result_pool, sizeof(*parser));
+  parser->xml_func = xml_func;
+  parser->payload_func = payload_func;
+  parser->baton = baton;
+
+  return parser;
+}
+
+svn_error_t *
+svn_ra_serf__binframe_parse(svn_ra_serf__binframe_parser_t *parser,
+                            const char *data,
+                            apr_size_t len)
+{
+  while (len > 0)
+    {
+      apr_size_t n;
+
+      if (parser->frame_remaining > 0)
+        {
+          n = MIN(len, parser->frame_remaining);
+          SVN_ERR(parser->payload_func(parser->baton, data, n));
+          parser->frame_remaining -= n;
+        }
+      else if (parser->header_len > 0)
+        {
+          n = MIN(len, sizeof(parser->header) - parser->header_len);
+          memcpy(parser->header + parser->header_len, data, n);
+          parser->header_len += n;
+
+          if (parser->header_len == sizeof(parser->header))
+            {
+              const unsigned char *h = parser->header;
+
+              parser->frame_remaining = ((apr_size_t)h[1] << 24)
+                                        | ((apr_size_t)h[2] << 16)
+                                        | ((apr_size_t)h[3] << 8)
+                                        | (apr_size_t)h[4];
+              parser->header_len = 0;
+            }
+        }
+      else
+        {
+          const char *marker = memchr(data, SVN_DAV__BINARY_FRAME_MARKER,
+                                      len);
+
+          n = marker ? (apr_size_t)(marker - data) : len;
+          if (n > 0)
+            SVN_ERR(parser->xml_func(parser->baton, data, n));
+
+          if (marker)
+            {
+              parser->header[0] = SVN_DAV__BINARY_FRAME_MARKER;
+              parser->header_len = 1;
+              n++;
+            }
+        }
+
+      data += n;
+      len -= n;
+    }
+
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_ra_serf__binframe_finish(svn_ra_serf__binframe_parser_t *parser)
+{
+  if (parser->header_len > 0 || parser->frame_remaining > 0)
+    return svn_error_create(SVN_ERR_RA_DAV_MALFORMED_DATA, NULL,
+                            _("Truncated binary data in update report"));
+
+  return SVN_NO_ERROR;
+}
+
+svn_boolean_t
+svn_ra_serf__binframe_content_type_p(const char *content_type)
+{
+  static const char mime_type[] = SVN_DAV__FRAMED_REPORT_MIME_TYPE;
+  apr_size_t i;
+
+  if (!content_type)
+    return FALSE;
+
+  /* Media types are case-insensitive and may carry parameters. */
+  for (i = 0; i < sizeof(mime_type) - 1; i++)
+    if (svn_ctype_casecmp(content_type[i], mime_type[i]) != 0)
+      return FALSE;
+
+  return (content_type[i] == '\0' || content_type[i] == ';'
+          || svn_ctype_isspace(content_type[i]));
+}
@@ -0,0 +1,86 @@
+/*
+ * binframe.h: Splitting binary txdelta frames out of update reports.
+ *
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ */
+
+
+#ifndef SVN_LIBSVN_RA_SERF_BINFRAME_H
+#define SVN_LIBSVN_RA_SERF_BINFRAME_H
+
+#include <apr_pools.h>
+
+#include "svn_types.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/* Parser for the body of an update report sent as
+ * SVN_DAV__FRAMED_REPORT_MIME_TYPE.  Such a body is XML text interrupted
+ * by binary frames, each of which is the SVN_DAV__BINARY_FRAME_MARKER
+ * byte, a 4-byte big-endian payload length and the payload.
+ */
+typedef struct svn_ra_serf__binframe_parser_t svn_ra_serf__binframe_parser_t;
+
+/* Callback that receives LEN bytes of DATA from the parser.  BATON is
+ * the baton passed to svn_ra_serf__binframe_parser_create().
+ */
+typedef svn_error_t *
+(*svn_ra_serf__binframe_data_t)(void *baton,
+                                const char *data,
+                                apr_size_t len);
+
+/* Create a parser in RESULT_POOL that passes the XML text it finds to
+ * XML_FUNC and the frame payloads to PAYLOAD_FUNC, both with BATON.
+ * Each is called as soon as data is available, so a frame's payload is
+ * delivered only after all XML that precedes it.
+ */
+svn_ra_serf__binframe_parser_t *
+svn_ra_serf__binframe_parser_create(svn_ra_serf__binframe_data_t xml_func,
+                                    svn_ra_serf__binframe_data_t payload_func,
+                                    void *baton,
+                                    apr_pool_t *result_pool);
+
+/* Parse the next LEN bytes of DATA with PARSER.  Frames and their
+ * headers may be split across calls at any byte.
+ */
+svn_error_t *
+svn_ra_serf__binframe_parse(svn_ra_serf__binframe_parser_t *parser,
+                            const char *data,
+                            apr_size_t len);
+
+/* Tell PARSER that the body is complete.  Return
+ * SVN_ERR_RA_DAV_MALFORMED_DATA if it ended within a frame.
+ */
+svn_error_t *
+svn_ra_serf__binframe_finish(svn_ra_serf__binframe_parser_t *parser);
+
+/* Return TRUE if CONTENT_TYPE, the value of a Content-Type header that
+ * may be NULL, is SVN_DAV__FRAMED_REPORT_MIME_TYPE.
+ */
+svn_boolean_t
+svn_ra_serf__binframe_content_type_p(const char *content_type);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* SVN_LIBSVN_RA_SERF_BINFRAME_H */
@@ -21,10 +21,15 @@
  * ====================================================================
  */
 
+#include <string.h>
+
 #include <apr_pools.h>
+#include <apr_strings.h>
 
 #include "svn_hash.h"
 #include "svn_dirent_uri.h"
+#include "svn_io.h"
+#include "svn_string.h"
 #include "svn_types.h"
 #include "svn_pools.h"
 
@@ -50,6 +55,9 @@ struct svn_ra_serf__blncache_t
    * structures. (Allocated from the same pool as 'revnum_to_bc'.)
    */
   apr_hash_t *baseline_info;
+
+  /* The file the cache is stored in, or NULL if it is not persistent. */
+  const char *persist_path;
 };
 
 
@@ -105,8 +113,147 @@ svn_ra_serf__blncache_create(svn_ra_serf__blncache_t **blncache_p,
   return SVN_NO_ERROR;
 }
 
+/* Maximum number of entries we keep in memory, and in the cache file. */
 #define MAX_CACHE_SIZE 1000
 
+/* Return TRUE if URL can be stored in a line of the cache file. */
+static svn_boolean_t
+url_storable_p(const char *url)
+{
+  return *url && !strpbrk(url, " \t\r\n");
+}
+
+/* Append the entry for REVISION, BC_URL and BASELINE_URL (which may be
+ * NULL) to BLNCACHE's persist_path, as a line "REVISION BC_URL" or
+ * "REVISION BC_URL BASELINE_URL".  The line is written with a single
+ * append, so sessions sharing the file don't garble each other's lines.
+ */
+static svn_error_t *
+append_cache_entry(svn_ra_serf__blncache_t *blncache,
+                   const char *baseline_url,
+                   svn_revnum_t revision,
+                   const char *bc_url,
+                   apr_pool_t *scratch_pool)
+{
+  apr_file_t *file;
+  const char *line;
+
+  if (!url_storable_p(bc_url)
+      || (baseline_url && !url_storable_p(baseline_url)))
+    return SVN_NO_ERROR;
+
+  if (baseline_url)
+    line = apr_psprintf(scratch_pool, "%ld %s %s\n",
+                        revision, bc_url, baseline_url);
+  else
+    line = apr_psprintf(scratch_pool, "%ld %s\n", revision, bc_url);
+
+  SVN_ERR(svn_io_file_open(&file, blncache->persist_path,
+                           APR_WRITE | APR_CREATE | APR_APPEND,
+                           APR_OS_DEFAULT, scratch_pool));
+  SVN_ERR(svn_io_file_write_full(file, line, strlen(line), NULL,
+                                 scratch_pool));
+  return svn_error_trace(svn_io_file_close(file, scratch_pool));
+}
+
+/* Add the entry stored in LINE of the cache file to BLNCACHE.  Lines
+ * that we can't parse, e.g. because a session was interrupted while
+ * writing them, are ignored.
+ */
+static void
+load_cache_entry(svn_ra_serf__blncache_t *blncache,
+                 const char *line)
+{
+  apr_pool_t *cache_pool = apr_hash_pool_get(blncache->revnum_to_bc);
+  svn_revnum_t revision;
+  const char *bc_url;
+  const char *baseline_url;
+  svn_error_t *err;
+
+  err = svn_revnum_parse(&revision, line, &bc_url);
+  if (err)
+    {
+      svn_error_clear(err);
+      return;
+    }
+  if (*bc_url != ' ' || !SVN_IS_VALID_REVNUM(revision))
+    return;
+
+  bc_url++;
+  baseline_url = strchr(bc_url, ' ');
+  if (baseline_url)
+    {
+      bc_url = apr_pstrmemdup(cache_pool, bc_url, baseline_url - bc_url);
+      baseline_url++;
+      if (!url_storable_p(bc_url) || !url_storable_p(baseline_url))
+        return;
+
+      hash_set_copy(blncache->baseline_info, baseline_url,
+                    APR_HASH_KEY_STRING,
+                    baseline_info_make(bc_url, revision, cache_pool));
+    }
+  else if (!url_storable_p(bc_url))
+    return;
+
+  hash_set_copy(blncache->revnum_to_bc, &revision, sizeof(revision),
+                apr_pstrdup(cache_pool, bc_url));
+}
+
+/* Add the entries stored in BLNCACHE's persist_path to BLNCACHE.  If the
+ * file has grown beyond MAX_CACHE_SIZE lines, e.g. because several
+ * sessions added the same entries, remove it and leave BLNCACHE empty.
+ */
+static svn_error_t *
+read_cache_file(svn_ra_serf__blncache_t *blncache,
+                apr_pool_t *scratch_pool)
+{
+  apr_pool_t *iterpool = svn_pool_create(scratch_pool);
+  svn_stream_t *stream;
+  int lines = 0;
+  svn_error_t *err;
+
+  err = svn_stream_open_readonly(&stream, blncache->persist_path,
+                                 scratch_pool, iterpool);
+  if (err && APR_STATUS_IS_ENOENT(err->apr_err))
+    {
+      svn_error_clear(err);
+      svn_pool_destroy(iterpool);
+      return SVN_NO_ERROR;
+    }
+  SVN_ERR(err);
+
+  while (lines <= MAX_CACHE_SIZE)
+    {
+      svn_stringbuf_t *line;
+      svn_boolean_t eof;
+
+      svn_pool_clear(iterpool);
+      SVN_ERR(svn_stream_readline(stream, &line, "\n", &eof, iterpool));
+      if (eof)
+        break;
+
+      load_cache_entry(blncache, line->data);
+      lines++;
+    }
+  svn_pool_destroy(iterpool);
+
+  SVN_ERR(svn_stream_close(stream));
+
+  if (lines > MAX_CACHE_SIZE)
+    {
+      apr_pool_t *cache_pool = apr_hash_pool_get(blncache->revnum_to_bc);
+
+      svn_pool_clear(cache_pool);
+      blncache->revnum_to_bc = apr_hash_make(cache_pool);
+      blncache->baseline_info = apr_hash_make(cache_pool);
+
+      SVN_ERR(svn_io_remove_file2(blncache->persist_path, TRUE,
+                                  scratch_pool));
+    }
+
+  return SVN_NO_ERROR;
+}
+
 svn_error_t *
 svn_ra_serf__blncache_set(svn_ra_serf__blncache_t *blncache,
                           const char *baseline_url,
@@ -118,6 +265,13 @@ svn_ra_serf__blncache_set(svn_ra_serf__blncache_t *blncache,
     {
       apr_pool_t *cache_pool = apr_hash_pool_get(blncache->revnum_to_bc);
 
+      /* Don't append entries we already have to the cache file. */
+      if (blncache->persist_path
+          && apr_hash_get(blncache->revnum_to_bc, &revision, sizeof(revision))
+          && (!baseline_url
+              || svn_hash_gets(blncache->baseline_info, baseline_url)))
+        return SVN_NO_ERROR;
+
       /* If the caches are too big, delete and recreate 'em and move along. */
       if (MAX_CACHE_SIZE < (apr_hash_count(blncache->baseline_info)
                             + apr_hash_count(blncache->revnum_to_bc)))
@@ -125,6 +279,12 @@ svn_ra_serf__blncache_set(svn_ra_serf__blncache_t *blncache,
           svn_pool_clear(cache_pool);
           blncache->revnum_to_bc = apr_hash_make(cache_pool);
           blncache->baseline_info = apr_hash_make(cache_pool);
+
+          /* Start the file over as well, so that it doesn't grow
+             without bounds. */
+          if (blncache->persist_path)
+            svn_error_clear(svn_io_remove_file2(blncache->persist_path,
+                                                TRUE, scratch_pool));
         }
 
       hash_set_copy(blncache->revnum_to_bc, &revision, sizeof(revision),
@@ -136,6 +296,12 @@ svn_ra_serf__blncache_set(svn_ra_serf__blncache_t *blncache,
                         APR_HASH_KEY_STRING,
                         baseline_info_make(bc_url, revision, cache_pool));
         }
+
+      /* The file is just a cache; another session will simply have to ask
+         the server again if we fail to write it. */
+      if (blncache->persist_path)
+        svn_error_clear(append_cache_entry(blncache, baseline_url, revision,
+                                           bc_url, scratch_pool));
     }
 
   return SVN_NO_ERROR;
@@ -177,3 +343,32 @@ svn_ra_serf__blncache_get_baseline_info(const char **bc_url_p,
   return SVN_NO_ERROR;
 }
 
+svn_error_t *
+svn_ra_serf__blncache_persist(svn_ra_serf__blncache_t *blncache,
+                              const char *path,
+                              apr_pool_t *scratch_pool)
+{
+  apr_pool_t *cache_pool = apr_hash_pool_get(blncache->revnum_to_bc);
+  svn_error_t *err;
+
+  if (blncache->persist_path && strcmp(blncache->persist_path, path) == 0)
+    return SVN_NO_ERROR;
+
+  /* The path must survive clearing CACHE_POOL. */
+  blncache->persist_path = apr_pstrdup(apr_pool_parent_get(cache_pool), path);
+
+  err = svn_io_make_dir_recursively(svn_dirent_dirname(path, scratch_pool),
+                                    scratch_pool);
+  if (!err)
+    err = read_cache_file(blncache, scratch_pool);
+
+  if (err)
+    {
+      /* Without a usable file, the cache just works like a transient
+         one. */
+      svn_error_clear(err);
+      blncache->persist_path = NULL;
+    }
+
+  return SVN_NO_ERROR;
+}
@@ -83,6 +83,19 @@ svn_ra_serf__blncache_get_baseline_info(const char **bc_url_p,
                                         const char *baseline_url,
                                         apr_pool_t *pool);
 
+/* Make BLNCACHE persistent in the file PATH: load the entries stored
+ * there, and from now on append each new entry to PATH.  Baseline
+ * information never changes once a revision exists, so the file may be
+ * shared by all sessions to the same repository.  The file is started
+ * over when it holds more entries than the cache keeps in memory.  If
+ * PATH can't be read, BLNCACHE stays transient; failures to write it
+ * are ignored.
+ */
+svn_error_t *
+svn_ra_serf__blncache_persist(svn_ra_serf__blncache_t *blncache,
+                              const char *path,
+                              apr_pool_t *scratch_pool);
+
 #ifdef __cplusplus
 }
 #endif /* __cplusplus */
@@ -0,0 +1,380 @@
+/*
+ * contentcache.c: on-disk cache of file contents fetched over DAV.
+ *
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ */
+
+
+#include <string.h>
+
+#include <apr_pools.h>
+#include <apr_hash.h>
+#include <apr_strings.h>
+#include <apr_file_io.h>
+
+#include "svn_types.h"
+#include "svn_pools.h"
+#include "svn_dirent_uri.h"
+#include "svn_error.h"
+#include "svn_io.h"
+
+#include "private/svn_sorts_private.h"
+
+#include "contentcache.h"
+
+/* Name of the directory below the cache root where entries are written
+ * before they are moved into place. */
+#define TMP_DIR "tmp"
+
+/* Once a cache grows beyond its size limit, remove entries until it
+ * holds at most this percentage of the limit, so that it doesn't need
+ * to be trimmed again after the next few additions. */
+#define TRIM_TARGET_PERCENT 75
+
+struct svn_ra_serf__content_cache_t
+{
+  /* The cache root. */
+  const char *dir;
+
+  /* Size limit in bytes, or 0. */
+  apr_uint64_t max_size;
+
+  /* Bytes that we added since we last trimmed the cache.  Scanning the
+   * cache is expensive, so we do that only when we may have pushed it
+   * over the limit.  Starts out at MAX_SIZE, since other sessions may
+   * have filled the cache. */
+  apr_uint64_t added_since_trim;
+};
+
+/* Baton for the streams returned by svn_ra_serf__content_cache_put(). */
+typedef struct put_baton_t
+{
+  svn_ra_serf__content_cache_t *cache;
+
+  /* The temporary file we write to, and its path. */
+  svn_stream_t *tmp_stream;
+  const char *tmp_path;
+
+  /* Where the entry goes, and the checksum it should have. */
+  const char *entry_dir;
+  const char *entry_path;
+  const svn_checksum_t *sha1;
+
+  /* Checksum and size of the data written so far. */
+  svn_checksum_ctx_t *checksum_ctx;
+  apr_uint64_t size;
+
+  /* TRUE once the temporary file has been moved into place or removed. */
+  svn_boolean_t done;
+
+  apr_pool_t *pool;
+} put_baton_t;
+
+/* A cache entry found by trim_cache(). */
+typedef struct entry_t
+{
+  const char *path;
+  svn_filesize_t size;
+  apr_time_t mtime;
+} entry_t;
+
+
+/* Set *DIR_P and *PATH_P to the directory and path of the entry for
+ * SHA1 in CACHE_DIR.  Entries are spread over 256 subdirectories by the
+ * first two hex digits of the checksum. */
+static void
+entry_location(const char **dir_p,
+               const char **path_p,
+               const char *cache_dir,
+               const svn_checksum_t *sha1,
+               apr_pool_t *result_pool)
+{
+  const char *hex = svn_checksum_to_cstring_display(sha1, result_pool);
+
+  *dir_p = svn_dirent_join(cache_dir, apr_pstrmemdup(result_pool, hex, 2),
+                           result_pool);
+  *path_p = svn_dirent_join(*dir_p, hex, result_pool);
+}
+
+
+/* Sort entry_t * by ascending modification time.  Implements the
+ * comparison function of svn_sort__array(). */
+static int
+compare_entry_mtime(const void *a, const void *b)
+{
+  const entry_t *entry_a = *(const entry_t *const *)a;
+  const entry_t *entry_b = *(const entry_t *const *)b;
+
+  if (entry_a->mtime < entry_b->mtime)
+    return -1;
+  else if (entry_a->mtime > entry_b->mtime)
+    return 1;
+  else
+    return 0;
+}
+
+
+/* If the entries in CACHE exceed its size limit, remove the least
+ * recently used ones until they take up TRIM_TARGET_PERCENT of it.
+ * Entries that other processes remove meanwhile are skipped. */
+static svn_error_t *
+trim_cache(svn_ra_serf__content_cache_t *cache,
+           apr_pool_t *scratch_pool)
+{
+  apr_array_header_t *entries = apr_array_make(scratch_pool, 256,
+                                               sizeof(entry_t *));
+  apr_uint64_t total = 0;
+  apr_hash_t *subdirs;
+  apr_hash_index_t *hi;
+  int i;
+
+  SVN_ERR(svn_io_get_dirents3(&subdirs, cache->dir, TRUE,
+                              scratch_pool, scratch_pool));
+
+  for (hi = apr_hash_first(scratch_pool, subdirs); hi; hi = apr_hash_next(hi))
+    {
+      const char *name = apr_hash_this_key(hi);
+      const svn_io_dirent2_t *dirent = apr_hash_this_val(hi);
+      const char *subdir;
+      apr_hash_t *files;
+      apr_hash_index_t *fhi;
+      svn_error_t *err;
+
+      if (dirent->kind != svn_node_dir || strcmp(name, TMP_DIR) == 0)
+        continue;
+
+      subdir = svn_dirent_join(cache->dir, name, scratch_pool);
+      err = svn_io_get_dirents3(&files, subdir, FALSE,
+                                scratch_pool, scratch_pool);
+      if (err && APR_STATUS_IS_ENOENT(err->apr_err))
+        {
+          svn_error_clear(err);
+          continue;
+        }
+      SVN_ERR(err);
+
+      for (fhi = apr_hash_first(scratch_pool, files); fhi;
+           fhi = apr_hash_next(fhi))
+        {
+          const svn_io_dirent2_t *file = apr_hash_this_val(fhi);
+          entry_t *entry;
+
+          if (file->kind != svn_node_file)
+            continue;
+
+          entry = apr_palloc(scratch_pool, sizeof(*entry));
+          entry->path = svn_dirent_join(subdir, apr_hash_this_key(fhi),
+                                        scratch_pool);
+          entry->size = file->filesize;
+          entry->mtime = file->mtime;
+          APR_ARRAY_PUSH(entries, entry_t *) = entry;
+
+          total += file->filesize;
+        }
+    }
+
+  if (total <= cache->max_size)
+    return SVN_NO_ERROR;
+
+  svn_sort__array(entries, compare_entry_mtime);
+
+  for (i = 0;
+       i < entries->nelts
+         && total > cache->max_size / 100 * TRIM_TARGET_PERCENT;
+       i++)
+    {
+      const entry_t *entry = APR_ARRAY_IDX(entries, i, const entry_t *);
+
+      SVN_ERR(svn_io_remove_file2(entry->path, TRUE, scratch_pool));
+      total -= entry->size;
+    }
+
+  return SVN_NO_ERROR;
+}
+
+
+/* Pool cleanup handler that removes the temporary file of an unfinished
+ * entry.  Registered before the file is opened, so it runs after the file
+ * has been closed. */
+static apr_status_t
+put_cleanup(void *baton)
+{
+  put_baton_t *pb = baton;
+
+  if (!pb->done && pb->tmp_path)
+    (void) apr_file_remove(pb->tmp_path, pb->pool);
+
+  return APR_SUCCESS;
+}
+
+
+/* Implements svn_write_fn_t. */
+static svn_error_t *
+put_write(void *baton, const char *data, apr_size_t *len)
+{
+  put_baton_t *pb = baton;
+
+  SVN_ERR(svn_checksum_update(pb->checksum_ctx, data, *len));
+  SVN_ERR(svn_stream_write(pb->tmp_stream, data, len));
+  pb->size += *len;
+
+  return SVN_NO_ERROR;
+}
+
+
+/* Implements svn_close_fn_t. */
+static svn_error_t *
+put_close(void *baton)
+{
+  put_baton_t *pb = baton;
+  svn_ra_serf__content_cache_t *cache = pb->cache;
+  svn_checksum_t *actual;
+
+  SVN_ERR(svn_stream_close(pb->tmp_stream));
+  SVN_ERR(svn_checksum_final(&actual, pb->checksum_ctx, pb->pool));
+
+  if (!svn_checksum_match(actual, pb->sha1))
+    {
+      SVN_ERR(svn_io_remove_file2(pb->tmp_path, TRUE, pb->pool));
+      pb->done = TRUE;
+      return SVN_NO_ERROR;
+    }
+
+  SVN_ERR(svn_io_make_dir_recursively(pb->entry_dir, pb->pool));
+
+  /* Another process may have added the same entry meanwhile; it has
+     the same content, so just replace it. */
+  SVN_ERR(svn_io_file_rename2(pb->tmp_path, pb->entry_path, FALSE,
+                              pb->pool));
+  pb->done = TRUE;
+
+  cache->added_since_trim += pb->size;
+  if (cache->max_size
+      && cache->added_since_trim
+           >= cache->max_size / 100 * (100 - TRIM_TARGET_PERCENT))
+    {
+      cache->added_since_trim = 0;
+      SVN_ERR(trim_cache(cache, pb->pool));
+    }
+
+  return SVN_NO_ERROR;
+}
+
+
+void
+svn_ra_serf__content_cache_create(svn_ra_serf__content_cache_t **cache_p,
+                                  const char *cache_dir,
+                                  apr_uint64_t max_size,
+                                  apr_pool_t *result_pool)
+{
+  svn_ra_serf__content_cache_t *cache = apr_pcalloc(result_pool,
+                                                    sizeof(*cache));
+
+  cache->dir = apr_pstrdup(result_pool, cache_dir);
+  cache->max_size = max_size;
+  cache->added_since_trim = max_size;
+
+  *cache_p = cache;
+}
+
+
+svn_error_t *
+svn_ra_serf__content_cache_get(svn_stream_t **contents_p,
+                               svn_ra_serf__content_cache_t *cache,
+                               const svn_checksum_t *sha1,
+                               apr_pool_t *result_pool,
+                               apr_pool_t *scratch_pool)
+{
+  const char *entry_dir;
+  const char *entry_path;
+  svn_checksum_t *actual;
+  svn_error_t *err;
+
+  entry_location(&entry_dir, &entry_path, cache->dir, sha1, scratch_pool);
+
+  /* The entry may have been damaged on disk.  We have to know before we
+     pass on any of it, since the caller can't take it back. */
+  err = svn_io_file_checksum2(&actual, entry_path, svn_checksum_sha1,
+                              scratch_pool);
+  if (err && APR_STATUS_IS_ENOENT(err->apr_err))
+    {
+      svn_error_clear(err);
+      *contents_p = NULL;
+      return SVN_NO_ERROR;
+    }
+  SVN_ERR(err);
+
+  if (!svn_checksum_match(actual, sha1))
+    {
+      SVN_ERR(svn_io_remove_file2(entry_path, TRUE, scratch_pool));
+      *contents_p = NULL;
+      return SVN_NO_ERROR;
+    }
+
+  /* Mark the entry as recently used for trim_cache().  The cache may be
+     shared read-only, so don't insist. */
+  svn_error_clear(svn_io_set_file_affected_time(apr_time_now(), entry_path,
+                                                scratch_pool));
+
+  err = svn_stream_open_readonly(contents_p, entry_path,
+                                 result_pool, scratch_pool);
+  if (err && APR_STATUS_IS_ENOENT(err->apr_err))
+    {
+      /* Trimmed by another process just now. */
+      svn_error_clear(err);
+      *contents_p = NULL;
+      return SVN_NO_ERROR;
+    }
+
+  return svn_error_trace(err);
+}
+
+
+svn_error_t *
+svn_ra_serf__content_cache_put(svn_stream_t **stream_p,
+                               svn_ra_serf__content_cache_t *cache,
+                               const svn_checksum_t *sha1,
+                               apr_pool_t *result_pool,
+                               apr_pool_t *scratch_pool)
+{
+  put_baton_t *pb = apr_pcalloc(result_pool, sizeof(*pb));
+  const char *tmp_dir = svn_dirent_join(cache->dir, TMP_DIR, scratch_pool);
+
+  pb->cache = cache;
+  pb->pool = result_pool;
+  pb->sha1 = svn_checksum_dup(sha1, result_pool);
+  pb->checksum_ctx = svn_checksum_ctx_create(svn_checksum_sha1, result_pool);
+  entry_location(&pb->entry_dir, &pb->entry_path, cache->dir, sha1,
+                 result_pool);
+
+  apr_pool_cleanup_register(result_pool, pb, put_cleanup,
+                            apr_pool_cleanup_null);
+
+  SVN_ERR(svn_io_make_dir_recursively(tmp_dir, scratch_pool));
+  SVN_ERR(svn_stream_open_unique(&pb->tmp_stream, &pb->tmp_path, tmp_dir,
+                                 svn_io_file_del_none,
+                                 result_pool, scratch_pool));
+
+  *stream_p = svn_stream_create(pb, result_pool);
+  svn_stream_set_write(*stream_p, put_write);
+  svn_stream_set_close(*stream_p, put_close);
+
+  return SVN_NO_ERROR;
+}
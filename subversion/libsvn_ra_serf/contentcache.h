@@ -0,0 +1,90 @@
+/*
+ * contentcache.h: on-disk cache of file contents fetched over DAV.
+ *
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ */
+
+#ifndef SVN_LIBSVN_RA_SERF_CONTENTCACHE_H
+#define SVN_LIBSVN_RA_SERF_CONTENTCACHE_H
+
+#include <apr_pools.h>
+
+#include "svn_types.h"
+#include "svn_checksum.h"
+#include "svn_io.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/* Content cache.  File fulltexts are stored below a directory shared by
+ * all sessions (and processes) that are configured to use it, keyed by
+ * their SHA-1 checksum.  Since the key is derived from the content, an
+ * entry never goes stale, and a file we know the checksum of can be
+ * taken from the cache without asking the server at all.
+ *
+ * Entries are verified against their checksum before they are used, and
+ * the least recently used ones are removed when the cache grows beyond
+ * its size limit.
+ */
+typedef struct svn_ra_serf__content_cache_t svn_ra_serf__content_cache_t;
+
+/* Set *CACHE_P to a content cache in CACHE_DIR that holds at most
+ * MAX_SIZE bytes, or any amount if MAX_SIZE is 0.  The directory is
+ * created on demand.  Allocate the cache in RESULT_POOL.
+ */
+void
+svn_ra_serf__content_cache_create(svn_ra_serf__content_cache_t **cache_p,
+                                  const char *cache_dir,
+                                  apr_uint64_t max_size,
+                                  apr_pool_t *result_pool);
+
+/* Set *CONTENTS_P to a readable stream for the cached fulltext with
+ * checksum SHA1 in CACHE, or to NULL if there is no such entry.  An
+ * entry that doesn't match SHA1 is removed and reported as missing, so
+ * that the caller fetches the fulltext and adds it again.  Allocate the
+ * stream in RESULT_POOL.
+ */
+svn_error_t *
+svn_ra_serf__content_cache_get(svn_stream_t **contents_p,
+                               svn_ra_serf__content_cache_t *cache,
+                               const svn_checksum_t *sha1,
+                               apr_pool_t *result_pool,
+                               apr_pool_t *scratch_pool);
+
+/* Set *STREAM_P to a writable stream that adds the fulltext written to
+ * it to CACHE under the checksum SHA1.  The entry is added when the
+ * stream is closed, and only if the data written has that checksum.  If
+ * the stream is not closed before RESULT_POOL is cleared (e.g. because
+ * the transfer failed), nothing is added.  Closing the stream may remove
+ * other entries to keep CACHE within its size limit.
+ */
+svn_error_t *
+svn_ra_serf__content_cache_put(svn_stream_t **stream_p,
+                               svn_ra_serf__content_cache_t *cache,
+                               const svn_checksum_t *sha1,
+                               apr_pool_t *result_pool,
+                               apr_pool_t *scratch_pool);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* SVN_LIBSVN_RA_SERF_CONTENTCACHE_H */
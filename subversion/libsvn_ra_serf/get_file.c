@@ -88,7 +88,14 @@ headers_fetch(serf_bucket_t *headers,
 {
   stream_ctx_t *fetch_ctx = baton;
 
-  if (fetch_ctx->session->using_compression != svn_tristate_false)
+  /* Continue where our connection died, instead of fetching (and
+     skipping) all the data we already have once more. */
+  if (fetch_ctx->aborted_read)
+    {
+      svn_ra_serf__setup_resume_range(headers, fetch_ctx->aborted_read_size,
+                                      pool);
+    }
+  else if (fetch_ctx->session->using_compression != svn_tristate_false)
     {
       serf_bucket_headers_setn(headers, "Accept-Encoding", "gzip");
     }
@@ -123,6 +130,9 @@ cancel_fetch(serf_request_t *request,
               fetch_ctx->aborted_read_size = fetch_ctx->read_size;
             }
           fetch_ctx->read_size = 0;
+
+          /* The retried request may resume, so check its headers. */
+          fetch_ctx->read_headers = FALSE;
         }
 
       return SVN_NO_ERROR;
@@ -187,6 +197,60 @@ try_get_wc_contents(svn_boolean_t *found_p,
   return SVN_NO_ERROR;
 }
 
+/* Helper svn_ra_serf__get_file(). Like try_get_wc_contents(), but uses
+ * the content cache of SESSION, if any. If the contents are not cached,
+ * sets *CACHE_STREAM_P to a stream that adds them to the cache when
+ * fetched, or to NULL.
+ *
+ * Errors from the cache are not fatal, as we can always fetch from the
+ * server instead.
+ */
+static svn_error_t *
+try_get_cached_contents(svn_boolean_t *found_p,
+                        svn_stream_t **cache_stream_p,
+                        svn_ra_serf__session_t *session,
+                        const char *sha1_checksum_prop,
+                        svn_stream_t *dst_stream,
+                        apr_pool_t *pool)
+{
+  svn_checksum_t *checksum;
+  svn_stream_t *cached_contents;
+  svn_error_t *err;
+
+  *found_p = FALSE;
+  *cache_stream_p = NULL;
+
+  if (!session->content_cache || sha1_checksum_prop == NULL)
+    return SVN_NO_ERROR;
+
+  SVN_ERR(svn_checksum_parse_hex(&checksum, svn_checksum_sha1,
+                                 sha1_checksum_prop, pool));
+
+  err = svn_ra_serf__content_cache_get(&cached_contents,
+                                       session->content_cache,
+                                       checksum, pool, pool);
+  if (!err && cached_contents)
+    {
+      SVN_ERR(svn_stream_copy3(cached_contents,
+                               svn_stream_disown(dst_stream, pool),
+                               NULL, NULL, pool));
+      *found_p = TRUE;
+      return SVN_NO_ERROR;
+    }
+  svn_error_clear(err);
+
+  err = svn_ra_serf__content_cache_put(cache_stream_p,
+                                       session->content_cache,
+                                       checksum, pool, pool);
+  if (err)
+    {
+      svn_error_clear(err);
+      *cache_stream_p = NULL;
+    }
+
+  return SVN_NO_ERROR;
+}
+
 /* -----------------------------------------------------------------------
    svn_ra_get_file() specific */
 
@@ -200,8 +264,25 @@ handle_stream(serf_request_t *request,
   stream_ctx_t *fetch_ctx = handler_baton;
   apr_status_t status;
 
-  if (fetch_ctx->handler->sline.code != 200)
-    return svn_error_trace(svn_ra_serf__unexpected_status(fetch_ctx->handler));
+  if (!fetch_ctx->read_headers)
+    {
+      if (fetch_ctx->handler->sline.code != 200
+          && (fetch_ctx->handler->sline.code != 206
+              || !fetch_ctx->aborted_read))
+        return svn_error_trace(
+                    svn_ra_serf__unexpected_status(fetch_ctx->handler));
+
+      if (fetch_ctx->handler->sline.code == 206)
+        {
+          /* The server resumed the transfer for us. */
+          SVN_ERR(svn_ra_serf__check_resume_range(
+                                    response, fetch_ctx->aborted_read_size));
+          fetch_ctx->read_size = fetch_ctx->aborted_read_size;
+          fetch_ctx->aborted_read = FALSE;
+        }
+
+      fetch_ctx->read_headers = TRUE;
+    }
 
   while (1)
     {
@@ -353,7 +434,8 @@ svn_ra_serf__get_file(svn_ra_session_t *ra_session,
 
   if (props)
       which_props = all_props;
-  else if (stream && session->wc_callbacks->get_wc_contents)
+  else if (stream && (session->wc_callbacks->get_wc_contents
+                      || session->content_cache))
       which_props = type_and_checksum_props;
   else
       which_props = check_path_props;
@@ -384,9 +466,16 @@ svn_ra_serf__get_file(svn_ra_session_t *ra_session,
   if (stream)
     {
       svn_boolean_t found;
+      svn_stream_t *cache_stream = NULL;
+
       SVN_ERR(try_get_wc_contents(&found, session, fb.sha1_checksum, stream,
                                   scratch_pool));
 
+      if (!found)
+        SVN_ERR(try_get_cached_contents(&found, &cache_stream, session,
+                                        fb.sha1_checksum, stream,
+                                        scratch_pool));
+
       /* No contents found in the WC, let's fetch from server. */
       if (!found)
         {
@@ -395,7 +484,12 @@ svn_ra_serf__get_file(svn_ra_session_t *ra_session,
 
           /* Create the fetch context. */
           stream_ctx = apr_pcalloc(scratch_pool, sizeof(*stream_ctx));
-          stream_ctx->result_stream = stream;
+          if (cache_stream)
+            stream_ctx->result_stream =
+              svn_stream_tee(svn_stream_disown(stream, scratch_pool),
+                             cache_stream, scratch_pool);
+          else
+            stream_ctx->result_stream = stream;
           stream_ctx->session = session;
 
           handler = svn_ra_serf__create_handler(session, scratch_pool);
@@ -419,8 +513,12 @@ svn_ra_serf__get_file(svn_ra_session_t *ra_session,
 
           SVN_ERR(svn_ra_serf__context_run_one(handler, scratch_pool));
 
-          if (handler->sline.code != 200)
+          if (handler->sline.code != 200 && handler->sline.code != 206)
             return svn_error_trace(svn_ra_serf__unexpected_status(handler));
+
+          /* Adds the fulltext to the cache. */
+          if (cache_stream)
+            svn_error_clear(svn_stream_close(cache_stream));
         }
     }
 
@@ -42,6 +42,7 @@
 #include "private/svn_editor.h"
 
 #include "blncache.h"
+#include "contentcache.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -82,6 +83,15 @@ typedef struct svn_ra_serf__connection_t {
 
   svn_ra_serf__session_t *session;
 
+  /* Statistics used to schedule requests over the session's connections.
+     SRTT is the smoothed time between writing a request and receiving
+     its response headers; 0 if not measured yet.  BYTES_RECEIVED and
+     TRANSFER_TIME are totals over the bodies of the responses that
+     their request handlers chose to account for.  */
+  apr_interval_time_t srtt;
+  apr_uint64_t bytes_received;
+  apr_interval_time_t transfer_time;
+
 } svn_ra_serf__connection_t;
 
 /** Maximum value we'll allow for the http-max-connections config option.
@@ -144,6 +154,9 @@ struct svn_ra_serf__session_t {
      requests may come in any order */
   svn_boolean_t http20;
 
+  /* Should we try to talk http/2 to the server (http-protocol=h2)?  */
+  svn_boolean_t use_http2;
+
   /* Should we use Transfer-Encoding: chunked for HTTP/1.1 servers. */
   svn_boolean_t using_chunked_requests;
 
@@ -243,6 +256,10 @@ struct svn_ra_serf__session_t {
 
   svn_ra_serf__blncache_t *blncache;
 
+  /* The on-disk content cache shared between sessions, or NULL if not
+     configured. See contentcache.h. */
+  svn_ra_serf__content_cache_t *content_cache;
+
   /* Trisate flag that indicates user preference for using bulk updates
      (svn_tristate_true) with all the properties and content in the
      update-report response. If svn_tristate_false, request a skelta
@@ -525,6 +542,15 @@ typedef struct svn_ra_serf__handler_t {
   /* Internal flag to indicate we've parsed the headers.  */
   svn_boolean_t reading_body;
 
+  /* HTTP/2 stream weight (1..256) for this request, relative to the other
+     requests on its connection.  0 leaves the protocol default.  */
+  apr_uint16_t priority;
+
+  /* When the request was last set up for writing and when its response
+     headers arrived.  Maintained by the core handler.  */
+  apr_time_t sent_time;
+  apr_time_t response_time;
+
   /* When this flag will be set, the core handler will discard any unread
      portion of the response body. The registered response handler will
      no longer be called.  */
@@ -1113,6 +1139,17 @@ svn_ra_serf__discover_vcc(const char **vcc_url,
                           svn_ra_serf__session_t *session,
                           apr_pool_t *scratch_pool);
 
+/* Make the baseline cache of @a SESSION persistent in the user's
+ * configuration area, once the repository UUID and root URL are known.
+ * Servers with HTTP v2 support don't need the cache, so this does
+ * nothing for them.  Calling it again for the same repository is a
+ * no-op.
+ *
+ * All temporary allocations will be made in @a SCRATCH_POOL. */
+svn_error_t *
+svn_ra_serf__persist_baseline_cache(svn_ra_serf__session_t *session,
+                                    apr_pool_t *scratch_pool);
+
 /* Set @a REPORT_TARGET to the URI of the resource at which generic
  * (path-agnostic) REPORTs should be aimed for @a SESSION.
  *
@@ -1443,6 +1480,17 @@ svn_ra_serf__list(svn_ra_session_t *ra_session,
                   void *receiver_baton,
                   apr_pool_t *scratch_pool);
 
+/* Implements svn_ra__vtable_t.blame(). */
+svn_error_t *
+svn_ra_serf__blame(svn_ra_session_t *ra_session,
+                   const char *path,
+                   svn_revnum_t start,
+                   svn_revnum_t end,
+                   const svn_diff_file_options_t *diff_options,
+                   svn_ra_blame_receiver_t receiver,
+                   void *receiver_baton,
+                   apr_pool_t *scratch_pool);
+
 /* Request a mergeinfo-report from the URL attached to SESSION,
    and fill in the MERGEINFO hash with the results.
 
@@ -1599,6 +1647,19 @@ void
 svn_ra_serf__setup_svndiff_accept_encoding(serf_bucket_t *headers,
                                            svn_ra_serf__session_t *session);
 
+/* Setup the "Range" header of a GET request that resumes an interrupted
+   fetch of a fulltext at OFFSET.  Allocate the value in POOL. */
+void
+svn_ra_serf__setup_resume_range(serf_bucket_t *headers,
+                                apr_off_t offset,
+                                apr_pool_t *pool);
+
+/* Verify that the 206 (Partial Content) RESPONSE to a request set up with
+   svn_ra_serf__setup_resume_range() starts at OFFSET. */
+svn_error_t *
+svn_ra_serf__check_resume_range(serf_bucket_t *response,
+                                apr_off_t offset);
+
 svn_boolean_t
 svn_ra_serf__is_low_latency_connection(svn_ra_serf__session_t *session);
 
@@ -0,0 +1,312 @@
+/*
+ * scheduler.c: Scheduling update requests over the session's connections.
+ *
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ */
+
+#include <string.h>
+
+#include <apr_time.h>
+
+#include "svn_types.h"
+#include "svn_sorts.h"
+
+#include "scheduler.h"
+
+/* Until we know the latency and throughput of our connections, we resume
+   parsing the REPORT response when fewer than REQUEST_COUNT_TO_RESUME
+   requests are outstanding.  Afterwards, svn_ra_serf__scheduler_adapt()
+   keeps the limit at the number of requests needed to keep all active
+   connections busy, within REQUEST_COUNT_MIN and REQUEST_COUNT_MAX.
+
+   With http/2, all requests share the session's first connection without
+   blocking each other, so we keep REQUEST_COUNT_HTTP2 of them in
+   flight. */
+#define REQUEST_COUNT_TO_RESUME 40
+#define REQUEST_COUNT_MIN 16
+#define REQUEST_COUNT_MAX 400
+#define REQUEST_COUNT_HTTP2 256
+
+/* We measure the total throughput over intervals of at least
+   SAMPLE_INTERVAL and at least SAMPLE_RTTS times the largest connection
+   latency.  An additional connection must raise it by at least
+   CONN_GAIN_PERCENT to be kept; otherwise we don't try again for
+   GROW_BACKOFF_SAMPLES intervals. */
+#define SAMPLE_INTERVAL apr_time_from_msec(250)
+#define SAMPLE_RTTS 4
+#define CONN_GAIN_PERCENT 10
+#define GROW_BACKOFF_SAMPLES 8
+
+/* Number of outstanding requests per connection as long as we have
+   not measured the connection yet, and the upper limit for the number
+   of requests we queue on a single connection. */
+#define REQS_PER_CONN 8
+#define MAX_PIPELINE_DEPTH 32
+
+/* Return the total number of response bytes received by the connections
+   of SESS. */
+static apr_uint64_t
+total_bytes_received(const svn_ra_serf__session_t *sess)
+{
+  apr_uint64_t bytes = 0;
+  int i;
+
+  for (i = 0; i < sess->num_conns; i++)
+    bytes += sess->conns[i]->bytes_received;
+
+  return bytes;
+}
+
+void
+svn_ra_serf__scheduler_init(svn_ra_serf__scheduler_t *sched,
+                            const svn_ra_serf__session_t *sess,
+                            apr_time_t now)
+{
+  memset(sched, 0, sizeof(*sched));
+
+  if (sess->http20)
+    {
+      sched->active_conns = 1;
+      sched->resume_count = REQUEST_COUNT_HTTP2;
+    }
+  else
+    {
+      sched->active_conns = sess->num_conns;
+      sched->resume_count = REQUEST_COUNT_TO_RESUME;
+    }
+
+  sched->cur_conn = 1;
+  sched->sample_start = now;
+  sched->sample_bytes = total_bytes_received(sess);
+  sched->sample_busy = TRUE;
+}
+
+unsigned int
+svn_ra_serf__scheduler_pipeline_depth(const svn_ra_serf__scheduler_t *sched,
+                                      const svn_ra_serf__session_t *sess,
+                                      const svn_ra_serf__connection_t *conn)
+{
+  apr_interval_time_t rtt = conn->srtt ? conn->srtt : sess->conn_latency;
+  double rate, avg_size, depth;
+
+  if (rtt <= 0 || conn->transfer_time <= 0 || !sched->fetches_done)
+    return REQS_PER_CONN;
+
+  rate = (double)conn->bytes_received / conn->transfer_time;
+  avg_size = (double)sched->bytes_fetched / sched->fetches_done;
+  depth = 1 + rate * rtt / (avg_size > 1 ? avg_size : 1);
+
+  if (depth < 2)
+    return 2;
+  else if (depth > MAX_PIPELINE_DEPTH)
+    return MAX_PIPELINE_DEPTH;
+  else
+    return (unsigned int)depth;
+}
+
+/* On a high latency link, this ends up with more connections and deeper
+   pipelines; once the bandwidth is saturated, further connections only
+   split it and get dropped again. */
+void
+svn_ra_serf__scheduler_adapt(svn_ra_serf__scheduler_t *sched,
+                             const svn_ra_serf__session_t *sess,
+                             unsigned int outstanding,
+                             apr_time_t now)
+{
+  unsigned int depth_sum = 0;
+  apr_interval_time_t max_rtt = 0;
+  int i;
+
+  /* One multiplexed connection is all we need. */
+  if (sess->http20)
+    {
+      sched->resume_count = REQUEST_COUNT_HTTP2;
+      return;
+    }
+
+  for (i = 1; i < sched->active_conns; i++)
+    {
+      depth_sum += svn_ra_serf__scheduler_pipeline_depth(sched, sess,
+                                                         sess->conns[i]);
+      if (sess->conns[i]->srtt > max_rtt)
+        max_rtt = sess->conns[i]->srtt;
+    }
+
+  /* Only samples taken while all connections had enough work tell us
+     what the link can do. */
+  if (outstanding < depth_sum)
+    sched->sample_busy = FALSE;
+
+  if (now - sched->sample_start >= SAMPLE_INTERVAL
+      && now - sched->sample_start >= SAMPLE_RTTS * max_rtt)
+    {
+      apr_uint64_t bytes = total_bytes_received(sess);
+      double rate;
+
+      rate = (double)(bytes - sched->sample_bytes)
+             / (now - sched->sample_start);
+
+      if (sched->sample_busy)
+        {
+          if (sched->active_conns <= sched->best_conns)
+            {
+              /* Follow changes in the link speed. */
+              sched->best_rate = rate;
+              sched->best_conns = sched->active_conns;
+            }
+          else if (rate * 100 >= sched->best_rate * (100 + CONN_GAIN_PERCENT))
+            {
+              sched->best_rate = rate;
+              sched->best_conns = sched->active_conns;
+            }
+          else
+            {
+              /* The last connection(s) didn't pay off.  Stop using them,
+                 they will still finish their queued requests. */
+              sched->active_conns = MAX(sched->best_conns, 2);
+              sched->grow_backoff = GROW_BACKOFF_SAMPLES;
+            }
+        }
+
+      if (sched->grow_backoff)
+        sched->grow_backoff--;
+
+      sched->sample_start = now;
+      sched->sample_bytes = bytes;
+      sched->sample_busy = TRUE;
+
+      sched->resume_count = MAX(2 * depth_sum, REQUEST_COUNT_MIN);
+      sched->resume_count = MIN(sched->resume_count, REQUEST_COUNT_MAX);
+    }
+
+  /* Add a connection if the others are saturated and the last one we
+     added was worth it. */
+  if (sched->active_conns < sess->max_connections
+      && sched->active_conns <= sched->best_conns
+      && !sched->grow_backoff
+      && outstanding > depth_sum)
+    {
+      sched->active_conns++;
+
+      /* Judge the new connection by a fresh sample. */
+      sched->sample_start = now;
+      sched->sample_bytes = total_bytes_received(sess);
+      sched->sample_busy = TRUE;
+    }
+}
+
+int
+svn_ra_serf__scheduler_pick(svn_ra_serf__scheduler_t *sched,
+                            const svn_ra_serf__session_t *sess,
+                            const unsigned int *pending,
+                            int first_conn,
+                            svn_boolean_t bulk)
+{
+  int conn_idx;
+
+  /* With http/2, the REPORT response doesn't hold up other requests on
+     its connection. */
+  if (sess->http20)
+    return 0;
+
+  /* If there's only one available auxiliary connection to use, don't bother
+     doing all the cur_conn math -- just return that one connection.  */
+  if (sched->active_conns - first_conn == 1)
+    {
+      conn_idx = first_conn;
+    }
+  else if (pending)
+    {
+      /* Often one connection is slower than others, e.g. because the server
+         process/thread has to do more work for the particular set of requests.
+         In the worst case, when RESUME_COUNT requests are queued on such a
+         slow connection, ra_serf will completely stop sending requests.
+
+         The method used here selects the connection with the least amount of
+         pending requests, thereby giving more work to lightly loaded server
+         processes.  Small requests prefer connections with the fewest
+         fulltexts queued, so that they don't wait for large transfers and
+         the editor keeps getting fed.
+       */
+      int i;
+      apr_uint64_t min = APR_UINT64_MAX;
+
+      conn_idx = first_conn;
+      for (i = first_conn; i < sched->active_conns; i++)
+        {
+          apr_uint64_t cost = pending[i];
+
+          if (!bulk)
+            cost += (apr_uint64_t)sched->bulk_pending[i] << 32;
+
+          if (cost < min)
+            {
+              min = cost;
+              conn_idx = i;
+            }
+        }
+    }
+  else
+    {
+      /* We don't know how many requests are pending per connection, so just
+         cycle them.  Small requests still avoid connections with more
+         fulltexts queued than the next one. */
+      if (sched->cur_conn < first_conn
+          || sched->cur_conn >= sched->active_conns)
+        sched->cur_conn = first_conn;
+
+      conn_idx = sched->cur_conn;
+      sched->cur_conn++;
+      if (sched->cur_conn >= sched->active_conns)
+        sched->cur_conn = first_conn;
+
+      if (!bulk && sched->bulk_pending[sched->cur_conn]
+                     < sched->bulk_pending[conn_idx])
+        conn_idx = sched->cur_conn;
+    }
+
+  return conn_idx;
+}
+
+void
+svn_ra_serf__scheduler_fetch_started(svn_ra_serf__scheduler_t *sched,
+                                     int conn_idx,
+                                     svn_boolean_t bulk)
+{
+  if (bulk)
+    sched->bulk_pending[conn_idx]++;
+}
+
+void
+svn_ra_serf__scheduler_fetch_done(svn_ra_serf__scheduler_t *sched,
+                                  svn_ra_serf__connection_t *conn,
+                                  int conn_idx,
+                                  svn_boolean_t bulk,
+                                  apr_uint64_t bytes,
+                                  apr_interval_time_t transfer_time)
+{
+  conn->bytes_received += bytes;
+  conn->transfer_time += transfer_time;
+  sched->bytes_fetched += bytes;
+  sched->fetches_done++;
+
+  if (bulk)
+    sched->bulk_pending[conn_idx]--;
+}
@@ -0,0 +1,149 @@
+/*
+ * scheduler.h: Scheduling update requests over the session's connections.
+ *
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ */
+
+#ifndef SVN_LIBSVN_RA_SERF_SCHEDULER_H
+#define SVN_LIBSVN_RA_SERF_SCHEDULER_H
+
+#include <apr_time.h>
+
+#include "svn_types.h"
+
+#include "ra_serf.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/* Scheduling state of the GET and PROPFIND requests of an update report.
+
+   The scheduler tracks the throughput of the session's connections.  It
+   sizes the pipeline of each connection to its bandwidth-delay product
+   and adds a connection whenever all active ones are saturated, as long
+   as the previous addition made the transfer faster.  Connections that
+   don't pay off stop getting new requests and drain.
+
+   The structure is owned by the caller; it contains no pointers. */
+typedef struct svn_ra_serf__scheduler_t
+{
+  /* Number of connections that get new GET and PROPFIND requests.  The
+     remaining ones of SESS->NUM_CONNS only finish what they have got. */
+  int active_conns;
+
+  /* Number of pending fulltext GET requests per connection. */
+  unsigned int bulk_pending[SVN_RA_SERF__MAX_CONNECTIONS_LIMIT];
+
+  /* Totals over all completed GET requests. */
+  apr_uint64_t bytes_fetched;
+  apr_uint64_t fetches_done;
+
+  /* Continue parsing the REPORT response while there are fewer
+     outstanding requests than this. */
+  unsigned int resume_count;
+
+  /* Next connection to use if we don't know how many requests each
+     connection has pending. */
+  int cur_conn;
+
+  /* State of the throughput measurement.  The current sample started at
+     SAMPLE_START when the connections had received SAMPLE_BYTES.
+     SAMPLE_BUSY is cleared when not all active connections had enough
+     work during the sample.  BEST_RATE, in bytes per microsecond, has
+     been achieved with BEST_CONNS connections. */
+  apr_time_t sample_start;
+  apr_uint64_t sample_bytes;
+  svn_boolean_t sample_busy;
+  double best_rate;
+  int best_conns;
+  int grow_backoff;
+} svn_ra_serf__scheduler_t;
+
+/* Initialize SCHED for a report over SESS, starting at time NOW.  All
+ * connections that SESS has open start out active.
+ */
+void
+svn_ra_serf__scheduler_init(svn_ra_serf__scheduler_t *sched,
+                            const svn_ra_serf__session_t *sess,
+                            apr_time_t now);
+
+/* Return the number of requests that CONN of SESS needs to have
+ * outstanding to stay busy while waiting for responses, i.e. its
+ * bandwidth-delay product expressed in average GET responses of SCHED.
+ */
+unsigned int
+svn_ra_serf__scheduler_pipeline_depth(const svn_ra_serf__scheduler_t *sched,
+                                      const svn_ra_serf__session_t *sess,
+                                      const svn_ra_serf__connection_t *conn);
+
+/* Grow or shrink the set of active connections of SCHED at time NOW,
+ * depending on the throughput that additional connections of SESS gained
+ * us while OUTSTANDING requests were pending, and recalculate
+ * SCHED->RESUME_COUNT.
+ *
+ * If SCHED->ACTIVE_CONNS exceeds SESS->NUM_CONNS afterwards, the caller
+ * must open another connection before scheduling further requests.
+ */
+void
+svn_ra_serf__scheduler_adapt(svn_ra_serf__scheduler_t *sched,
+                             const svn_ra_serf__session_t *sess,
+                             unsigned int outstanding,
+                             apr_time_t now);
+
+/* Return the index of the connection of SESS that SCHED selects for the
+ * next request, starting with connection FIRST_CONN.  PENDING holds the
+ * number of requests queued on each connection, or is NULL if that is
+ * not known.  BULK is set for fulltext GET requests, which may take long
+ * to complete.  Other requests are steered away from connections busy
+ * with those.
+ */
+int
+svn_ra_serf__scheduler_pick(svn_ra_serf__scheduler_t *sched,
+                            const svn_ra_serf__session_t *sess,
+                            const unsigned int *pending,
+                            int first_conn,
+                            svn_boolean_t bulk);
+
+/* Record in SCHED that a GET request has been queued on the connection
+ * CONN_IDX.  BULK is the same as for svn_ra_serf__scheduler_pick().
+ */
+void
+svn_ra_serf__scheduler_fetch_started(svn_ra_serf__scheduler_t *sched,
+                                     int conn_idx,
+                                     svn_boolean_t bulk);
+
+/* Record in SCHED and in CONN, the connection CONN_IDX, that a GET
+ * request queued by svn_ra_serf__scheduler_fetch_started() completed
+ * after receiving BYTES of response body in TRANSFER_TIME.
+ */
+void
+svn_ra_serf__scheduler_fetch_done(svn_ra_serf__scheduler_t *sched,
+                                  svn_ra_serf__connection_t *conn,
+                                  int conn_idx,
+                                  svn_boolean_t bulk,
+                                  apr_uint64_t bytes,
+                                  apr_interval_time_t transfer_time);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* SVN_LIBSVN_RA_SERF_SCHEDULER_H */
@@ -162,6 +162,9 @@ load_config(svn_ra_serf__session_t *session,
   const char *port_str = NULL;
   const char *timeout_str = NULL;
   const char *exceptions;
+  const char *http_protocol;
+  const char *content_cache_dir;
+  apr_int64_t content_cache_size;
   apr_port_t proxy_port;
   svn_tristate_t chunked_requests;
 #if SERF_VERSION_AT_LEAST(1, 4, 0) && !defined(SVN_SERF_NO_LOGGING)
@@ -251,6 +254,18 @@ load_config(svn_ra_serf__session_t *session,
                                   SVN_CONFIG_OPTION_HTTP_CHUNKED_REQUESTS,
                                   "auto", svn_tristate_unknown));
 
+  /* Which HTTP protocol version should we talk. */
+  svn_config_get(config, &http_protocol, SVN_CONFIG_SECTION_GLOBAL,
+                 SVN_CONFIG_OPTION_HTTP_PROTOCOL, NULL);
+
+  /* Where should we cache fetched file contents, and how much. */
+  svn_config_get(config, &content_cache_dir, SVN_CONFIG_SECTION_GLOBAL,
+                 SVN_CONFIG_OPTION_HTTP_CONTENT_CACHE, NULL);
+  SVN_ERR(svn_config_get_int64(config, &content_cache_size,
+                               SVN_CONFIG_SECTION_GLOBAL,
+                               SVN_CONFIG_OPTION_HTTP_CONTENT_CACHE_SIZE,
+                               SVN_CONFIG_DEFAULT_OPTION_HTTP_CONTENT_CACHE_SIZE));
+
 #if SERF_VERSION_AT_LEAST(1, 4, 0) && !defined(SVN_SERF_NO_LOGGING)
   SVN_ERR(svn_config_get_int64(config, &log_components,
                                SVN_CONFIG_SECTION_GLOBAL,
@@ -318,6 +333,16 @@ load_config(svn_ra_serf__session_t *session,
                                       SVN_CONFIG_OPTION_HTTP_CHUNKED_REQUESTS,
                                       "auto", chunked_requests));
 
+      svn_config_get(config, &http_protocol, server_group,
+                     SVN_CONFIG_OPTION_HTTP_PROTOCOL, http_protocol);
+
+      svn_config_get(config, &content_cache_dir, server_group,
+                     SVN_CONFIG_OPTION_HTTP_CONTENT_CACHE, content_cache_dir);
+      SVN_ERR(svn_config_get_int64(config, &content_cache_size,
+                                   server_group,
+                                   SVN_CONFIG_OPTION_HTTP_CONTENT_CACHE_SIZE,
+                                   content_cache_size));
+
 #if SERF_VERSION_AT_LEAST(1, 4, 0) && !defined(SVN_SERF_NO_LOGGING)
       SVN_ERR(svn_config_get_int64(config, &log_components,
                                    server_group,
@@ -349,6 +374,37 @@ load_config(svn_ra_serf__session_t *session,
     }
 #endif
 
+  if (!http_protocol || svn_cstring_casecmp(http_protocol, "http/1.1") == 0)
+    session->use_http2 = FALSE;
+  else if (svn_cstring_casecmp(http_protocol, "h2") == 0)
+    {
+      /* Older serf versions can't do http/2; silently stay with http/1.1
+         like for the other serf specific options. */
+#if SERF_VERSION_AT_LEAST(1, 4, 0)
+      session->use_http2 = TRUE;
+#else
+      session->use_http2 = FALSE;
+#endif
+    }
+  else
+    return svn_error_createf(SVN_ERR_BAD_CONFIG_VALUE, NULL,
+                             _("Invalid config: unknown %s '%s'"),
+                             SVN_CONFIG_OPTION_HTTP_PROTOCOL, http_protocol);
+
+  if (content_cache_size < 0)
+    return svn_error_createf(SVN_ERR_BAD_CONFIG_VALUE, NULL,
+                             _("Invalid config: negative %s"),
+                             SVN_CONFIG_OPTION_HTTP_CONTENT_CACHE_SIZE);
+
+  if (content_cache_dir && *content_cache_dir)
+    svn_ra_serf__content_cache_create(
+      &session->content_cache,
+      svn_dirent_internal_style(content_cache_dir, result_pool),
+      (apr_uint64_t)content_cache_size * 1024 * 1024,
+      result_pool);
+  else
+    session->content_cache = NULL;
+
   /* Don't allow the http-max-connections value to be larger than our
      compiled-in limit, or to be too small to operate.  Broken
      functionality and angry administrators are equally undesirable. */
@@ -472,6 +528,49 @@ get_user_agent_string(apr_pool_t *pool)
                       major, minor, patch);
 }
 
+/* Name of the directory in the user's configuration area that holds the
+   persistent baseline caches. */
+#define BASELINE_CACHE_DIR "ra_serf-baselines"
+
+/* The cache file is named after the repository UUID and root URL, so
+   mirrors sharing a UUID don't mix. */
+svn_error_t *
+svn_ra_serf__persist_baseline_cache(svn_ra_serf__session_t *session,
+                                    apr_pool_t *scratch_pool)
+{
+  const char *config_dir;
+  const char *cache_dir;
+  const char *repos_id;
+  const char *cache_path;
+  svn_checksum_t *key;
+
+  /* HTTPv2 servers let us construct baseline collection URLs directly. */
+  if (SVN_RA_SERF__HAVE_HTTPV2_SUPPORT(session)
+      || !session->uuid || !session->repos_root_str)
+    return SVN_NO_ERROR;
+
+  config_dir = session->auth_baton
+                 ? svn_auth_get_parameter(session->auth_baton,
+                                          SVN_AUTH_PARAM_CONFIG_DIR)
+                 : NULL;
+  SVN_ERR(svn_config_get_user_config_path(&cache_dir, config_dir,
+                                          BASELINE_CACHE_DIR, scratch_pool));
+  if (!cache_dir)
+    return SVN_NO_ERROR;
+
+  repos_id = apr_pstrcat(scratch_pool, session->uuid, " ",
+                         session->repos_root_str, SVN_VA_NULL);
+  SVN_ERR(svn_checksum(&key, svn_checksum_md5, repos_id, strlen(repos_id),
+                       scratch_pool));
+  cache_path = svn_dirent_join(cache_dir,
+                               svn_checksum_to_cstring(key, scratch_pool),
+                               scratch_pool);
+
+  return svn_error_trace(svn_ra_serf__blncache_persist(session->blncache,
+                                                       cache_path,
+                                                       scratch_pool));
+}
+
 /* Implements svn_ra__vtable_t.open_session(). */
 static svn_error_t *
 svn_ra_serf__open(svn_ra_session_t *session,
@@ -643,6 +742,7 @@ ra_serf_dup_session(svn_ra_session_t *new_session,
   /* using_compression */
   /* http10 */
   /* http20 */
+  /* use_http2 */
   /* using_chunked_requests */
   /* detect_chunking */
 
@@ -734,6 +834,7 @@ ra_serf_dup_session(svn_ra_session_t *new_session,
   /* ### Can we copy this? */
   SVN_ERR(svn_ra_serf__blncache_create(&new_sess->blncache,
                                        new_sess->pool));
+  SVN_ERR(svn_ra_serf__persist_baseline_cache(new_sess, scratch_pool));
 
   if (new_sess->server_allows_bulk)
     new_sess->server_allows_bulk = apr_pstrdup(result_pool,
@@ -1064,6 +1165,8 @@ static const svn_ra__vtable_t serf_vtable = {
   svn_ra_serf__get_inherited_props,
   NULL /* set_svn_ra_open */,
   svn_ra_serf__list,
+  svn_ra_serf__blame,
+  NULL /* get_nodes */,
   svn_ra_serf__register_editor_shim_callbacks,
   NULL /* commit_ev2 */,
   NULL /* replay_range_ev2 */
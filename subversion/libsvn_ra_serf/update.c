@@ -40,13 +40,18 @@
 #include "svn_path.h"
 #include "svn_base64.h"
 #include "svn_props.h"
+#include "svn_sorts.h"
 
 #include "svn_private_config.h"
+#include "private/svn_dav_protocol.h"
+#include "private/svn_debug.h"
 #include "private/svn_dep_compat.h"
 #include "private/svn_fspath.h"
 #include "private/svn_string_private.h"
 
 #include "ra_serf.h"
+#include "binframe.h"
+#include "scheduler.h"
 #include "../libsvn_ra/ra_loader.h"
 
 
@@ -251,9 +256,16 @@ static const svn_ra_serf__xml_transition_t update_ttable[] = {
    can make the measurements quite imprecise.
 
    We measure outstanding requests as the sum of NUM_ACTIVE_FETCHES and
-   NUM_ACTIVE_PROPFINDS in the report_context_t structure.  */
+   NUM_ACTIVE_PROPFINDS in the report_context_t structure, and resume
+   once there are fewer than the RESUME_COUNT of its scheduler.  */
 #define REQUEST_COUNT_TO_PAUSE 50
-#define REQUEST_COUNT_TO_RESUME 40
+
+/* With http/2, all requests share the session's first connection without
+   blocking each other.  The server interleaves the responses by stream
+   weight: the REPORT response and small requests get HTTP2_WEIGHT_HIGH,
+   fulltexts get HTTP2_WEIGHT_BULK. */
+#define HTTP2_WEIGHT_HIGH 256
+#define HTTP2_WEIGHT_BULK 16
 
 #define SPILLBUF_BLOCKSIZE 4096
 #define SPILLBUF_MAXBUFFSIZE 131072
@@ -379,15 +391,28 @@ typedef struct fetch_ctx_t {
   svn_boolean_t aborted_read;
   apr_off_t aborted_read_size;
 
+  /* Set when a fulltext transfer was aborted, to ask the server to
+     resume it at ABORTED_READ_SIZE rather than to send it all again. */
+  svn_boolean_t resume;
+
   /* This is the amount of data that we have read so far. */
   apr_off_t read_size;
 
   /* If we're writing this file to a stream, this will be non-NULL. */
   svn_stream_t *result_stream;
 
+  /* If we're adding the fulltext to the content cache, the stream to
+     write it to. */
+  svn_stream_t *cache_stream;
+
   /* The base-rev header  */
   const char *delta_base;
 
+  /* Index of the connection in the session that we scheduled this fetch
+     on, and whether the scheduler counts it as a fulltext. */
+  int conn_idx;
+  svn_boolean_t bulk;
+
 } fetch_ctx_t;
 
 /*
@@ -422,6 +447,11 @@ struct report_context_t {
   /* Is the server sending everything in one response? */
   svn_boolean_t send_all_mode;
 
+  /* Did we ask the server for binary framed txdeltas, and did it send
+     the report as SVN_DAV__FRAMED_REPORT_MIME_TYPE? */
+  svn_boolean_t binary_txdelta_requested;
+  svn_boolean_t binary_txdelta;
+
   /* Is the server including properties inline for newly added
      files/dirs? */
   svn_boolean_t add_props_included;
@@ -445,6 +475,9 @@ struct report_context_t {
   /* number of pending PROPFIND requests */
   unsigned int num_active_propfinds;
 
+  /* Scheduling of the GET and PROPFIND requests over the connections. */
+  svn_ra_serf__scheduler_t sched;
+
   /* Are we done parsing the REPORT response? */
   svn_boolean_t done;
 
@@ -544,53 +577,62 @@ create_file_baton(file_baton_t **new_file,
   return SVN_NO_ERROR;
 }
 
-/** Minimum nr. of outstanding requests needed before a new connection is
- *  opened. */
-#define REQS_PER_CONN 8
-
-/** This function creates a new connection for this serf session, but only
- * if the number of NUM_ACTIVE_REQS > REQS_PER_CONN or if there currently is
- * only one main connection open.
+/** This function creates a new connection for this serf session.
  */
 static svn_error_t *
-open_connection_if_needed(svn_ra_serf__session_t *sess, int num_active_reqs)
+open_connection(svn_ra_serf__session_t *sess)
 {
-  /* For each REQS_PER_CONN outstanding requests open a new connection, with
-   * a minimum of 1 extra connection. */
-  if (sess->num_conns == 1 ||
-      ((num_active_reqs / REQS_PER_CONN) > sess->num_conns))
-    {
-      int cur = sess->num_conns;
-      apr_status_t status;
+  int cur = sess->num_conns;
+  apr_status_t status;
 
-      sess->conns[cur] = apr_pcalloc(sess->pool, sizeof(*sess->conns[cur]));
-      sess->conns[cur]->bkt_alloc = serf_bucket_allocator_create(sess->pool,
-                                                                 NULL, NULL);
-      sess->conns[cur]->last_status_code = -1;
-      sess->conns[cur]->session = sess;
-      status = serf_connection_create2(&sess->conns[cur]->conn,
-                                       sess->context,
-                                       sess->session_url,
-                                       svn_ra_serf__conn_setup,
-                                       sess->conns[cur],
-                                       svn_ra_serf__conn_closed,
-                                       sess->conns[cur],
-                                       sess->pool);
-      if (status)
-        return svn_ra_serf__wrap_err(status, NULL);
+  sess->conns[cur] = apr_pcalloc(sess->pool, sizeof(*sess->conns[cur]));
+  sess->conns[cur]->bkt_alloc = serf_bucket_allocator_create(sess->pool,
+                                                             NULL, NULL);
+  sess->conns[cur]->last_status_code = -1;
+  sess->conns[cur]->session = sess;
+  status = serf_connection_create2(&sess->conns[cur]->conn,
+                                   sess->context,
+                                   sess->session_url,
+                                   svn_ra_serf__conn_setup,
+                                   sess->conns[cur],
+                                   svn_ra_serf__conn_closed,
+                                   sess->conns[cur],
+                                   sess->pool);
+  if (status)
+    return svn_ra_serf__wrap_err(status, NULL);
 
-      sess->num_conns++;
-    }
+  sess->num_conns++;
 
   return SVN_NO_ERROR;
 }
 
-/* Returns best connection for fetching files/properties. */
-static svn_ra_serf__connection_t *
-get_best_connection(report_context_t *ctx)
+/* Open or retire extra connections for the report CTX, depending on how
+   they perform. */
+static svn_error_t *
+adapt_connections(report_context_t *ctx)
+{
+  svn_ra_serf__scheduler_adapt(&ctx->sched, ctx->sess,
+                               ctx->num_active_fetches
+                               + ctx->num_active_propfinds,
+                               apr_time_now());
+
+  if (ctx->sched.active_conns > ctx->sess->num_conns)
+    SVN_ERR(open_connection(ctx->sess));
+
+  return SVN_NO_ERROR;
+}
+
+/* Returns the index of the best connection for fetching files/properties.
+   BULK is set for fulltext GET requests, which may take long to complete. */
+static int
+get_best_connection(report_context_t *ctx,
+                    svn_boolean_t bulk)
 {
-  svn_ra_serf__connection_t *conn;
   int first_conn = 1;
+#if SERF_VERSION_AT_LEAST(1, 4, 0)
+  unsigned int pending[SVN_RA_SERF__MAX_CONNECTIONS_LIMIT];
+  int i;
+#endif
 
   /* Skip the first connection if the REPORT response hasn't been completely
      received yet or if we're being told to limit our connections to
@@ -608,50 +650,19 @@ get_best_connection(report_context_t *ctx)
   if (ctx->report_received && (ctx->sess->max_connections > 2))
     first_conn = 0;
 
-  /* If there's only one available auxiliary connection to use, don't bother
-     doing all the cur_conn math -- just return that one connection.  */
-  if (ctx->sess->num_conns - first_conn == 1)
-    {
-      conn = ctx->sess->conns[first_conn];
-    }
-  else
-    {
 #if SERF_VERSION_AT_LEAST(1, 4, 0)
-      /* Often one connection is slower than others, e.g. because the server
-         process/thread has to do more work for the particular set of requests.
-         In the worst case, when REQUEST_COUNT_TO_RESUME requests are queued
-         on such a slow connection, ra_serf will completely stop sending
-         requests.
-
-         The method used here selects the connection with the least amount of
-         pending requests, thereby giving more work to lightly loaded server
-         processes.
-       */
-      int i, best_conn = first_conn;
-      unsigned int min = INT_MAX;
-      for (i = first_conn; i < ctx->sess->num_conns; i++)
-        {
-          serf_connection_t *sc = ctx->sess->conns[i]->conn;
-          unsigned int pending = serf_connection_pending_requests(sc);
-          if (pending < min)
-            {
-              min = pending;
-              best_conn = i;
-            }
-        }
-      conn = ctx->sess->conns[best_conn];
+  for (i = first_conn; i < ctx->sched.active_conns; i++)
+    pending[i] = serf_connection_pending_requests(ctx->sess->conns[i]->conn);
+
+  return svn_ra_serf__scheduler_pick(&ctx->sched, ctx->sess, pending,
+                                     first_conn, bulk);
 #else
-    /* We don't know how many requests are pending per connection, so just
-       cycle them. */
-      conn = ctx->sess->conns[ctx->sess->cur_conn];
-      ctx->sess->cur_conn++;
-      if (ctx->sess->cur_conn >= ctx->sess->num_conns)
-        ctx->sess->cur_conn = first_conn;
+  /* We don't know how many requests are pending per connection. */
+  return svn_ra_serf__scheduler_pick(&ctx->sched, ctx->sess, NULL,
+                                     first_conn, bulk);
 #endif
-    }
-  return conn;
 }
-
+
 /** Helpers to open and close directories */
 
 static svn_error_t*
@@ -792,8 +803,15 @@ headers_fetch(serf_bucket_t *headers,
 {
   fetch_ctx_t *fetch_ctx = baton;
 
+  /* Resume an interrupted fulltext.  The delta base doesn't matter any
+     more: we already decided for a fulltext. */
+  if (fetch_ctx->resume)
+    {
+      svn_ra_serf__setup_resume_range(headers, fetch_ctx->aborted_read_size,
+                                      pool);
+    }
   /* note that we have old VC URL */
-  if (fetch_ctx->delta_base)
+  else if (fetch_ctx->delta_base)
     {
       serf_bucket_headers_setn(headers, SVN_DAV_DELTA_BASE_HEADER,
                                fetch_ctx->delta_base);
@@ -834,6 +852,14 @@ cancel_fetch(serf_request_t *request,
               fetch_ctx->aborted_read_size = fetch_ctx->read_size;
             }
           fetch_ctx->read_size = 0;
+
+          /* svndiff data can't be resumed, but a fulltext can.  Check
+             the headers of the retried request for that. */
+          if (fetch_ctx->aborted_read && !fetch_ctx->result_stream)
+            {
+              fetch_ctx->resume = TRUE;
+              fetch_ctx->read_headers = FALSE;
+            }
         }
 
       return SVN_NO_ERROR;
@@ -957,6 +983,17 @@ handle_fetch(serf_request_t *request,
   /* ### new field. make sure we didn't miss some initialization.  */
   SVN_ERR_ASSERT(fetch_ctx->handler != NULL);
 
+  if (!fetch_ctx->read_headers && fetch_ctx->resume
+      && fetch_ctx->handler->sline.code == 206)
+    {
+      /* The server resumed the fulltext for us. */
+      SVN_ERR(svn_ra_serf__check_resume_range(response,
+                                              fetch_ctx->aborted_read_size));
+      fetch_ctx->read_size = fetch_ctx->aborted_read_size;
+      fetch_ctx->aborted_read = FALSE;
+      fetch_ctx->read_headers = TRUE;
+    }
+
   if (!fetch_ctx->read_headers)
     {
       serf_bucket_t *hdrs;
@@ -1002,6 +1039,26 @@ handle_fetch(serf_request_t *request,
       else
         {
           fetch_ctx->result_stream = NULL;
+
+          /* We get the fulltext; keep a copy if we know its checksum.
+             The cache is an optimization, so just skip it on errors. */
+          if (file->final_sha1_checksum
+              && fetch_ctx->session->content_cache
+              && !fetch_ctx->cache_stream)
+            {
+              svn_error_t *err;
+
+              err = svn_ra_serf__content_cache_put(
+                                    &fetch_ctx->cache_stream,
+                                    fetch_ctx->session->content_cache,
+                                    file->final_sha1_checksum,
+                                    file->pool, pool);
+              if (err)
+                {
+                  svn_error_clear(err);
+                  fetch_ctx->cache_stream = NULL;
+                }
+            }
         }
 
       fetch_ctx->read_headers = TRUE;
@@ -1069,6 +1126,21 @@ handle_fetch(serf_request_t *request,
 
           /* write to the file located in the info. */
           SVN_ERR(file->txdelta(&delta_window, file->txdelta_baton));
+
+          if (fetch_ctx->cache_stream)
+            {
+              apr_size_t written = len;
+              svn_error_t *err = svn_stream_write(fetch_ctx->cache_stream,
+                                                  data, &written);
+
+              /* Give up on caching; the pool cleanup removes the
+                 partial entry. */
+              if (err)
+                {
+                  svn_error_clear(err);
+                  fetch_ctx->cache_stream = NULL;
+                }
+            }
         }
 
       if (APR_STATUS_IS_EOF(status))
@@ -1077,6 +1149,12 @@ handle_fetch(serf_request_t *request,
             SVN_ERR(svn_stream_close(fetch_ctx->result_stream));
           else
             SVN_ERR(file->txdelta(NULL, file->txdelta_baton));
+
+          if (fetch_ctx->cache_stream)
+            {
+              svn_error_clear(svn_stream_close(fetch_ctx->cache_stream));
+              fetch_ctx->cache_stream = NULL;
+            }
         }
 
       /* Report EOF, EEAGAIN and other special errors to serf */
@@ -1180,16 +1258,24 @@ file_fetch_done(serf_request_t *request,
 {
   fetch_ctx_t *fetch_ctx = baton;
   file_baton_t *file = fetch_ctx->file;
+  report_context_t *ctx = file->parent_dir->ctx;
   svn_ra_serf__handler_t *handler = fetch_ctx->handler;
 
   if (handler->server_error)
       return svn_error_trace(svn_ra_serf__server_error_create(handler,
                                                               scratch_pool));
 
-  if (handler->sline.code != 200)
+  if (handler->sline.code != 200
+      && (handler->sline.code != 206 || !fetch_ctx->resume))
     return svn_error_trace(svn_ra_serf__unexpected_status(handler));
 
-  file->parent_dir->ctx->num_active_fetches--;
+  ctx->num_active_fetches--;
+
+  /* Account the transfer to the connection, for scheduling. */
+  svn_ra_serf__scheduler_fetch_done(&ctx->sched, handler->conn,
+                                    fetch_ctx->conn_idx, fetch_ctx->bulk,
+                                    fetch_ctx->read_size,
+                                    apr_time_now() - handler->response_time);
 
   file->fetch_file = FALSE;
 
@@ -1212,16 +1298,11 @@ fetch_for_file(file_baton_t *file,
                apr_pool_t *scratch_pool)
 {
   report_context_t *ctx = file->parent_dir->ctx;
-  svn_ra_serf__connection_t *conn;
+  svn_ra_serf__connection_t *conn = NULL;
   svn_ra_serf__handler_t *handler;
 
-  /* Open extra connections if we have enough requests to send. */
-  if (ctx->sess->num_conns < ctx->sess->max_connections)
-    SVN_ERR(open_connection_if_needed(ctx->sess, ctx->num_active_fetches +
-                                                 ctx->num_active_propfinds));
-
-  /* What connection should we go on? */
-  conn = get_best_connection(ctx);
+  /* Open or retire extra connections, depending on how they perform. */
+  SVN_ERR(adapt_connections(ctx));
 
   /* Note that we (still) use conn for both requests.. Should we send
      them out on different connections? */
@@ -1266,6 +1347,31 @@ fetch_for_file(file_baton_t *file,
             }
         }
 
+      if (file->fetch_file
+          && file->final_sha1_checksum
+          && ctx->sess->content_cache)
+        {
+          svn_error_t *err;
+          svn_stream_t *cached_contents = NULL;
+
+          err = svn_ra_serf__content_cache_get(&cached_contents,
+                                               ctx->sess->content_cache,
+                                               file->final_sha1_checksum,
+                                               scratch_pool, scratch_pool);
+
+          if (err || !cached_contents)
+            svn_error_clear(err); /* Just fetch it from the server */
+          else
+            {
+              SVN_ERR(svn_txdelta_send_stream(cached_contents,
+                                              file->txdelta,
+                                              file->txdelta_baton,
+                                              NULL, scratch_pool));
+              SVN_ERR(svn_stream_close(cached_contents));
+              file->fetch_file = FALSE;
+            }
+        }
+
       if (file->fetch_file)
         {
           fetch_ctx_t *fetch_ctx;
@@ -1324,12 +1430,23 @@ fetch_for_file(file_baton_t *file,
                                         : NULL;
             }
 
+          /* What connection should we go on?  Deltas are usually small,
+             fulltexts of added files may be arbitrarily large. */
+          fetch_ctx->bulk = (fetch_ctx->delta_base == NULL);
+          fetch_ctx->conn_idx = get_best_connection(ctx, fetch_ctx->bulk);
+          conn = ctx->sess->conns[fetch_ctx->conn_idx];
+          svn_ra_serf__scheduler_fetch_started(&ctx->sched,
+                                               fetch_ctx->conn_idx,
+                                               fetch_ctx->bulk);
+
           handler = svn_ra_serf__create_handler(ctx->sess, file->pool);
 
           handler->method = "GET";
           handler->path = file->url;
 
           handler->conn = conn; /* Explicit scheduling */
+          handler->priority = fetch_ctx->bulk ? HTTP2_WEIGHT_BULK
+                                              : HTTP2_WEIGHT_HIGH;
 
           handler->custom_accept_encoding = TRUE;
           handler->no_dav_headers = TRUE;
@@ -1362,7 +1479,10 @@ fetch_for_file(file_baton_t *file,
                                                    all_props,
                                                    set_file_props, file,
                                                    file->pool));
+      if (!conn)
+        conn = ctx->sess->conns[get_best_connection(ctx, FALSE)];
       file->propfind_handler->conn = conn; /* Explicit scheduling */
+      file->propfind_handler->priority = HTTP2_WEIGHT_HIGH;
 
       file->propfind_handler->done_delegate = file_props_done;
       file->propfind_handler->done_delegate_baton = file;
@@ -1443,13 +1563,11 @@ fetch_for_dir(dir_baton_t *dir,
   report_context_t *ctx = dir->ctx;
   svn_ra_serf__connection_t *conn;
 
-  /* Open extra connections if we have enough requests to send. */
-  if (ctx->sess->num_conns < ctx->sess->max_connections)
-    SVN_ERR(open_connection_if_needed(ctx->sess, ctx->num_active_fetches +
-                                                 ctx->num_active_propfinds));
+  /* Open or retire extra connections, depending on how they perform. */
+  SVN_ERR(adapt_connections(ctx));
 
   /* What connection should we go on? */
-  conn = get_best_connection(ctx);
+  conn = ctx->sess->conns[get_best_connection(ctx, FALSE)];
 
   /* If needed, create the PROPFIND to retrieve the file's properties. */
   if (dir->fetch_props)
@@ -1462,6 +1580,7 @@ fetch_for_dir(dir_baton_t *dir,
                                                    dir->pool));
 
       dir->propfind_handler->conn = conn;
+      dir->propfind_handler->priority = HTTP2_WEIGHT_HIGH;
       dir->propfind_handler->done_delegate = dir_props_done;
       dir->propfind_handler->done_delegate_baton = dir;
 
@@ -1665,7 +1784,13 @@ update_opened(svn_ra_serf__xml_estate_t *xes,
                                                   TRUE /* error early close*/,
                                                   file->pool);
 
-              file->txdelta_stream = svn_base64_decode(decoder, file->pool);
+              /* Binary svndiff data arrives through
+                 binary_frame_handler() rather than as cdata. */
+              if (ctx->binary_txdelta)
+                file->txdelta_stream = decoder;
+              else
+                file->txdelta_stream = svn_base64_decode(decoder,
+                                                         file->pool);
             }
         }
         break;
@@ -2034,7 +2159,7 @@ update_cdata(svn_ra_serf__xml_estate_t *xes,
   report_context_t *ctx = baton;
 
   if (current_state == TXDELTA && ctx->cur_file
-      && ctx->cur_file->txdelta_stream)
+      && ctx->cur_file->txdelta_stream && !ctx->binary_txdelta)
     {
       SVN_ERR(svn_stream_write(ctx->cur_file->txdelta_stream, data, &len));
     }
@@ -2173,6 +2298,163 @@ setup_update_report_headers(serf_bucket_t *headers,
   return SVN_NO_ERROR;
 }
 
+/* Baton for binary_frame_handler and framed_report_handler */
+typedef struct binary_frame_baton_t
+{
+  report_context_t *report;
+  serf_bucket_alloc_t *alloc;
+  svn_ra_serf__binframe_parser_t *parser;
+
+  /* The request and scratch pool of the running binary_frame_handler
+     call, for binframe_xml(). */
+  serf_request_t *request;
+  apr_pool_t *scratch_pool;
+
+  /* The handler that parses the XML, and the one that
+     framed_report_handler passes the response to. */
+  svn_ra_serf__response_handler_t inner_handler;
+  void *inner_handler_baton;
+  svn_ra_serf__response_handler_t outer_handler;
+  void *outer_handler_baton;
+
+  /* Has framed_report_handler looked at the response headers yet? */
+  svn_boolean_t type_checked;
+} binary_frame_baton_t;
+
+/* Pass the XML text in DATA/LEN to FB->INNER_HANDLER, finishing the
+   document when AT_EOF. */
+static svn_error_t *
+feed_xml(binary_frame_baton_t *fb,
+         const char *data,
+         apr_size_t len,
+         svn_boolean_t at_eof)
+{
+  serf_bucket_t *tmp_bucket;
+  svn_error_t *err;
+
+  if (at_eof)
+    tmp_bucket = serf_bucket_simple_create(data, len, NULL, NULL, fb->alloc);
+  else
+    tmp_bucket = svn_ra_serf__create_bucket_with_eagain(data, len,
+                                                        fb->alloc);
+
+  err = fb->inner_handler(fb->request, tmp_bucket, fb->inner_handler_baton,
+                          fb->scratch_pool);
+  serf_bucket_destroy(tmp_bucket);
+
+  if (!at_eof && err && APR_STATUS_IS_EAGAIN(err->apr_err))
+    {
+      /* The parser consumed everything we gave it */
+      svn_error_clear(err);
+      return SVN_NO_ERROR;
+    }
+
+  return svn_error_trace(err);
+}
+
+/* Implements svn_ra_serf__binframe_data_t for the XML of the report. */
+static svn_error_t *
+binframe_xml(void *baton,
+             const char *data,
+             apr_size_t len)
+{
+  return svn_error_trace(feed_xml(baton, data, len, FALSE));
+}
+
+/* Implements svn_ra_serf__binframe_data_t for the svndiff data of the
+   file whose S:txdelta element is open. */
+static svn_error_t *
+binframe_payload(void *baton,
+                 const char *data,
+                 apr_size_t len)
+{
+  binary_frame_baton_t *fb = baton;
+  report_context_t *ctx = fb->report;
+
+  if (!ctx->cur_file)
+    return svn_error_create(SVN_ERR_RA_DAV_MALFORMED_DATA, NULL,
+                            _("Unexpected binary data in update report"));
+
+  if (ctx->cur_file->txdelta_stream)
+    SVN_ERR(svn_stream_write(ctx->cur_file->txdelta_stream, data, &len));
+
+  return SVN_NO_ERROR;
+}
+
+/* Response handler that notes whether the server sent the report as
+   SVN_DAV__FRAMED_REPORT_MIME_TYPE, before anything reads the body, and
+   then passes RESPONSE on to FB->OUTER_HANDLER. */
+static svn_error_t *
+framed_report_handler(serf_request_t *request,
+                      serf_bucket_t *response,
+                      void *handler_baton,
+                      apr_pool_t *scratch_pool)
+{
+  binary_frame_baton_t *fb = handler_baton;
+
+  if (!fb->type_checked)
+    {
+      serf_bucket_t *hdrs = serf_bucket_response_get_headers(response);
+
+      fb->report->binary_txdelta = svn_ra_serf__binframe_content_type_p(
+                                     serf_bucket_headers_get(hdrs,
+                                                             "Content-Type"));
+      fb->type_checked = TRUE;
+    }
+
+  return svn_error_trace(fb->outer_handler(request, response,
+                                           fb->outer_handler_baton,
+                                           scratch_pool));
+}
+
+/* Response handler for a report that may contain binary txdelta frames
+   (see SVN_DAV__BINARY_FRAME_MARKER).  Strips the frames out of the
+   XML, passing the XML on to the inner (parsing) handler and writing
+   the svndiff payload to the txdelta stream of the file whose
+   S:txdelta element is open. */
+static svn_error_t *
+binary_frame_handler(serf_request_t *request,
+                     serf_bucket_t *response,
+                     void *handler_baton,
+                     apr_pool_t *scratch_pool)
+{
+  binary_frame_baton_t *fb = handler_baton;
+
+  /* A plain XML response, e.g. from a server that doesn't support
+     binary txdeltas or an error. */
+  if (!fb->report->binary_txdelta)
+    return svn_error_trace(fb->inner_handler(request, response,
+                                             fb->inner_handler_baton,
+                                             scratch_pool));
+
+  fb->request = request;
+  fb->scratch_pool = scratch_pool;
+
+  while (1)
+    {
+      apr_status_t status;
+      const char *data;
+      apr_size_t len;
+
+      status = serf_bucket_read(response, PARSE_CHUNK_SIZE, &data, &len);
+      if (SERF_BUCKET_READ_ERROR(status))
+        return svn_ra_serf__wrap_err(status, NULL);
+
+      SVN_ERR(svn_ra_serf__binframe_parse(fb->parser, data, len));
+
+      if (APR_STATUS_IS_EOF(status))
+        {
+          SVN_ERR(svn_ra_serf__binframe_finish(fb->parser));
+
+          return svn_error_trace(feed_xml(fb, "", 0, TRUE));
+        }
+      else if (status)
+        return svn_ra_serf__wrap_err(status, NULL);
+    }
+
+  /* NOTREACHED */
+}
+
 /* Baton for update_delay_handler */
 typedef struct update_delay_baton_t
 {
@@ -2251,7 +2533,7 @@ update_delay_handler(serf_request_t *request,
         }
 
       while ((udb->report->num_active_fetches + udb->report->num_active_propfinds)
-                 < REQUEST_COUNT_TO_RESUME)
+                 < udb->report->sched.resume_count)
         {
           const char *data;
           apr_size_t len;
@@ -2335,7 +2617,7 @@ process_pending(update_delay_baton_t *udb,
   serf_bucket_alloc_t *alloc = NULL;
 
   while ((udb->report->num_active_fetches + udb->report->num_active_propfinds)
-            < REQUEST_COUNT_TO_RESUME)
+            < udb->report->sched.resume_count)
     {
       const char *data;
       apr_size_t len;
@@ -2394,6 +2676,26 @@ process_editor_report(report_context_t *ctx,
   apr_pool_t *iterpool = svn_pool_create(scratch_pool);
   apr_interval_time_t waittime_left = sess->timeout;
   update_delay_baton_t *ud;
+  binary_frame_baton_t *fb = NULL;
+  int i;
+
+  /* If we asked for binary txdeltas, separate them from the XML before
+     it reaches the parser. */
+  if (ctx->binary_txdelta_requested)
+    {
+      fb = apr_pcalloc(scratch_pool, sizeof(*fb));
+
+      fb->report = ctx;
+      fb->alloc = serf_bucket_allocator_create(scratch_pool, NULL, NULL);
+      fb->parser = svn_ra_serf__binframe_parser_create(binframe_xml,
+                                                       binframe_payload,
+                                                       fb, scratch_pool);
+      fb->inner_handler = handler->response_handler;
+      fb->inner_handler_baton = handler->response_baton;
+
+      handler->response_handler = binary_frame_handler;
+      handler->response_baton = fb;
+    }
 
   /* Now wrap the response handler with delay support to avoid sending
      out too many requests at once */
@@ -2406,10 +2708,24 @@ process_editor_report(report_context_t *ctx,
   handler->response_handler = update_delay_handler;
   handler->response_baton = ud;
 
-  /* Open the first extra connection. */
-  SVN_ERR(open_connection_if_needed(sess, 0));
+  /* The delay handler may pass on the body in pieces of its own, so look
+     at the content type of the actual response before it does. */
+  if (fb)
+    {
+      fb->outer_handler = handler->response_handler;
+      fb->outer_handler_baton = handler->response_baton;
+
+      handler->response_handler = framed_report_handler;
+      handler->response_baton = fb;
+    }
+
+  /* Open the first extra connection.  Connections that an earlier
+     report on this session opened start out active as well.  With
+     http/2 everything goes over the first connection. */
+  if (!sess->http20 && sess->num_conns == 1)
+    SVN_ERR(open_connection(sess));
 
-  sess->cur_conn = 1;
+  svn_ra_serf__scheduler_init(&ctx->sched, sess, apr_time_now());
 
   /* Note that we may have no active GET or PROPFIND requests, yet the
      processing has not been completed. This could be from a delay on the
@@ -2422,7 +2738,6 @@ process_editor_report(report_context_t *ctx,
          || !ctx->done)
     {
       svn_error_t *err;
-      int i;
 
       svn_pool_clear(iterpool);
 
@@ -2495,6 +2810,7 @@ finish_report(void *report_baton,
   handler->method = "REPORT";
   handler->path = report_target;
   handler->body_type = "text/xml";
+  handler->priority = HTTP2_WEIGHT_HIGH;
   handler->custom_accept_encoding = TRUE;
   handler->header_delegate = setup_update_report_headers;
   handler->header_delegate_baton = report;
@@ -2678,6 +2994,12 @@ make_update_reporter(svn_ra_session_t *ra_session,
                             "S:update-report",
                             "xmlns:S", SVN_XML_NAMESPACE, "send-all", "true",
                             SVN_VA_NULL);
+
+      /* Servers that understand this send svndiff data as binary frames
+         instead of base64 cdata; others ignore it. */
+      make_simple_xml_tag(&buf, "S:" SVN_DAV__BINARY_TXDELTA, "yes",
+                          scratch_pool);
+      report->binary_txdelta_requested = TRUE;
     }
   else
     {
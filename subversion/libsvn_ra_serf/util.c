@@ -28,6 +28,7 @@
 #define APR_WANT_STRFUNC
 #include <apr.h>
 #include <apr_want.h>
+#include <apr_strings.h>
 
 #include <serf.h>
 #include <serf_bucket_types.h>
@@ -480,7 +481,21 @@ load_authorities(svn_ra_serf__connection_t *conn, const char *authorities,
   return SVN_NO_ERROR;
 }
 
-#if SERF_VERSION_AT_LEAST(1, 4, 0) && defined(SVN__SERF_TEST_HTTP2)
+#if SERF_VERSION_AT_LEAST(1, 4, 0)
+/* Switch CONN to http/2 framing. */
+static void
+use_http2_framing(svn_ra_serf__connection_t *conn)
+{
+  serf_connection_set_framing_type(conn->conn,
+                                   SERF_CONNECTION_FRAMING_TYPE_HTTP2);
+
+  /* Disable generating content-length headers. */
+  conn->session->http10 = FALSE;
+  conn->session->http20 = TRUE;
+  conn->session->using_chunked_requests = TRUE;
+  conn->session->detect_chunking = FALSE;
+}
+
 /* Implements serf_ssl_protocol_result_cb_t */
 static apr_status_t
 conn_negotiate_protocol(void *data,
@@ -490,15 +505,7 @@ conn_negotiate_protocol(void *data,
 
   if (!strcmp(protocol, "h2"))
     {
-      serf_connection_set_framing_type(
-            conn->conn,
-            SERF_CONNECTION_FRAMING_TYPE_HTTP2);
-
-      /* Disable generating content-length headers. */
-      conn->session->http10 = FALSE;
-      conn->session->http20 = TRUE;
-      conn->session->using_chunked_requests = TRUE;
-      conn->session->detect_chunking = FALSE;
+      use_http2_framing(conn);
     }
   else
     {
@@ -557,10 +564,14 @@ conn_setup(apr_socket_t *sock,
               SVN_ERR(load_authorities(conn, conn->session->ssl_authorities,
                                        conn->session->pool));
             }
-#if SERF_VERSION_AT_LEAST(1, 4, 0) && defined(SVN__SERF_TEST_HTTP2)
-          if (APR_SUCCESS ==
-                serf_ssl_negotiate_protocol(conn->ssl_context, "h2,http/1.1",
-                                            conn_negotiate_protocol, conn))
+#if SERF_VERSION_AT_LEAST(1, 4, 0)
+          /* Offer http/2 via ALPN.  Until the handshake tells us what the
+             server picked, serf must not write any requests. */
+          if (conn->session->use_http2
+              && APR_SUCCESS ==
+                   serf_ssl_negotiate_protocol(conn->ssl_context,
+                                               "h2,http/1.1",
+                                               conn_negotiate_protocol, conn))
             {
                 serf_connection_set_framing_type(
                             conn->conn,
@@ -577,6 +588,14 @@ conn_setup(apr_socket_t *sock,
                                                       conn->bkt_alloc);
         }
     }
+#if SERF_VERSION_AT_LEAST(1, 4, 0)
+  else if (conn->session->use_http2)
+    {
+      /* Without TLS there is nothing to negotiate with; the user told us
+         the server talks http/2 ("prior knowledge"). */
+      use_http2_framing(conn);
+    }
+#endif
 
   return SVN_NO_ERROR;
 }
@@ -1446,6 +1465,20 @@ handle_response(serf_request_t *request,
   /* Stop processing the above, on every packet arrival.  */
   handler->reading_body = TRUE;
 
+  /* Feed the connection's latency estimate, weighting the new sample
+     like TCP does. */
+  handler->response_time = apr_time_now();
+  if (handler->sent_time && handler->response_time > handler->sent_time)
+    {
+      apr_interval_time_t sample = handler->response_time
+                                   - handler->sent_time;
+
+      if (handler->conn->srtt)
+        handler->conn->srtt = (7 * handler->conn->srtt + sample) / 8;
+      else
+        handler->conn->srtt = sample;
+    }
+
  process_body:
 
   /* A client cert file password was obtained and worked (any HTTP
@@ -1647,6 +1680,8 @@ setup_request_cb(serf_request_t *request,
   *s_handler = handle_response_cb;
   *s_handler_baton = handler;
 
+  handler->sent_time = apr_time_now();
+
   err = svn_error_trace(setup_request(request, handler, req_bkt,
                                       request_pool, scratch_pool));
 
@@ -1657,6 +1692,8 @@ setup_request_cb(serf_request_t *request,
 void
 svn_ra_serf__request_create(svn_ra_serf__handler_t *handler)
 {
+  serf_request_t *request;
+
   SVN_ERR_ASSERT_NO_RETURN(handler->handler_pool != NULL
                            && !handler->scheduled);
 
@@ -1680,8 +1717,19 @@ svn_ra_serf__request_create(svn_ra_serf__handler_t *handler)
 
      ### I fixed a request leak in serf in r2258 on auth failures.
    */
-  (void) serf_connection_request_create(handler->conn->conn,
-                                        setup_request_cb, handler);
+  request = serf_connection_request_create(handler->conn->conn,
+                                           setup_request_cb, handler);
+
+#if SERF_VERSION_AT_LEAST(1, 4, 0)
+  /* Let the server send the responses that matter most first.
+     ### A request that serf recreates behind our back (see above) falls
+     ### back to the default weight. */
+  if (handler->priority && handler->session->http20)
+    serf_connection_request_prioritize(request, NULL, handler->priority,
+                                       FALSE);
+#else
+  (void) request;
+#endif
 }
 
 
@@ -1788,7 +1836,10 @@ svn_ra_serf__discover_vcc(const char **vcc_url,
       session->uuid = apr_pstrdup(session->pool, uuid);
     }
 
-  return SVN_NO_ERROR;
+  /* Now that we know which repository we talk to, baselines looked up by
+     earlier sessions can save us the PROPFINDs. */
+  return svn_error_trace(svn_ra_serf__persist_baseline_cache(session,
+                                                             scratch_pool));
 }
 
 svn_error_t *
@@ -2079,6 +2130,38 @@ svn_ra_serf__setup_svndiff_accept_encoding(serf_bucket_t *headers,
     }
 }
 
+void
+svn_ra_serf__setup_resume_range(serf_bucket_t *headers,
+                                apr_off_t offset,
+                                apr_pool_t *pool)
+{
+  /* Byte ranges refer to the encoded entity, so we ask for the identity
+     encoding to be able to count in fulltext offsets. */
+  serf_bucket_headers_setn(headers, "Accept-Encoding", "identity");
+  serf_bucket_headers_set(headers, "Range",
+                          apr_psprintf(pool, "bytes=%" APR_OFF_T_FMT "-",
+                                       offset));
+}
+
+svn_error_t *
+svn_ra_serf__check_resume_range(serf_bucket_t *response,
+                                apr_off_t offset)
+{
+  serf_bucket_t *hdrs = serf_bucket_response_get_headers(response);
+  const char *val = serf_bucket_headers_get(hdrs, "Content-Range");
+  apr_off_t start;
+  char *endp;
+
+  if (val && strncmp(val, "bytes ", 6) == 0
+      && !apr_strtoff(&start, val + 6, &endp, 10)
+      && *endp == '-' && start == offset)
+    return SVN_NO_ERROR;
+
+  return svn_error_createf(SVN_ERR_RA_DAV_REQUEST_FAILED, NULL,
+                           _("GET request returned unexpected range: %s"),
+                           val ? val : "(none)");
+}
+
 svn_boolean_t
 svn_ra_serf__is_low_latency_connection(svn_ra_serf__session_t *session)
 {
@@ -35,6 +35,7 @@
 #include "svn_config.h"
 #include "svn_delta.h"
 #include "svn_path.h"
+#include "svn_sorts.h"
 
 #include "svn_private_config.h"
 #include "private/svn_string_private.h"
@@ -45,6 +46,9 @@
 /* Read/write chunks of this size into the spillbuf.  */
 #define PARSE_CHUNK_SIZE 8000
 
+/* Keep at most this many cleared state pools around for reuse.  */
+#define MAX_FREE_STATE_POOLS 32
+
 
 struct svn_ra_serf__xml_context_t {
   /* Current state information.  */
@@ -59,6 +63,16 @@ struct svn_ra_serf__xml_context_t {
   /* The transition table.  */
   const svn_ra_serf__xml_transition_t *ttable;
 
+  /* TTABLE indexed by FROM_STATE: for each state up to MAX_STATE, a
+     NULL-terminated list of the transitions leaving it, in table order.
+     Saves scanning the whole table for every element of large reports. */
+  const svn_ra_serf__xml_transition_t ***transitions;
+  int max_state;
+
+  /* Cleared state pools (apr_pool_t *) ready for reuse, so that reports
+     with many elements don't create and destroy a subpool per element. */
+  apr_array_header_t *free_pools;
+
   /* The callback information.  */
   svn_ra_serf__xml_opened_t opened_cb;
   svn_ra_serf__xml_closed_t closed_cb;
@@ -113,6 +127,9 @@ struct svn_ra_serf__xml_estate_t {
   /* A pool may be constructed for this state.  */
   apr_pool_t *state_pool;
 
+  /* Did STATE_POOL come from the context's FREE_POOLS?  */
+  svn_boolean_t recycle_pool;
+
   /* The namespaces extent for this state/element. This will start with
      the parent's NS_LIST, and we will push new namespaces into our
      local list. The parent will be unaffected by our locally-scoped data. */
@@ -519,6 +536,40 @@ svn_ra_serf__xml_context_done(svn_ra_serf__xml_context_t *xmlctx)
   return SVN_NO_ERROR;
 }
 
+/* Build XMLCTX->TRANSITIONS from XMLCTX->TTABLE, allocated in POOL. */
+static void
+index_transitions(svn_ra_serf__xml_context_t *xmlctx,
+                  apr_pool_t *pool)
+{
+  const svn_ra_serf__xml_transition_t *scan;
+  int *counts;
+  int i;
+
+  xmlctx->max_state = XML_STATE_INITIAL;
+  for (scan = xmlctx->ttable; scan->ns != NULL; ++scan)
+    xmlctx->max_state = MAX(xmlctx->max_state, scan->from_state);
+
+  counts = apr_pcalloc(pool, (xmlctx->max_state + 1) * sizeof(*counts));
+  for (scan = xmlctx->ttable; scan->ns != NULL; ++scan)
+    counts[scan->from_state]++;
+
+  xmlctx->transitions = apr_palloc(pool, (xmlctx->max_state + 1)
+                                           * sizeof(*xmlctx->transitions));
+  for (i = 0; i <= xmlctx->max_state; i++)
+    {
+      xmlctx->transitions[i] = apr_palloc(pool, (counts[i] + 1)
+                                            * sizeof(**xmlctx->transitions));
+      counts[i] = 0;
+    }
+
+  for (scan = xmlctx->ttable; scan->ns != NULL; ++scan)
+    xmlctx->transitions[scan->from_state][counts[scan->from_state]++] = scan;
+
+  for (i = 0; i <= xmlctx->max_state; i++)
+    xmlctx->transitions[i][counts[i]] = NULL;
+}
+
+
 svn_ra_serf__xml_context_t *
 svn_ra_serf__xml_context_create(
   const svn_ra_serf__xml_transition_t *ttable,
@@ -538,6 +589,9 @@ svn_ra_serf__xml_context_create(
   xmlctx->cdata_cb = cdata_cb;
   xmlctx->baton = baton;
   xmlctx->scratch_pool = svn_pool_create(result_pool);
+  xmlctx->free_pools = apr_array_make(result_pool, MAX_FREE_STATE_POOLS,
+                                      sizeof(apr_pool_t *));
+  index_transitions(xmlctx, result_pool);
 
   xes = apr_pcalloc(result_pool, sizeof(*xes));
   /* XES->STATE == 0  */
@@ -638,7 +692,8 @@ xml_cb_start(svn_ra_serf__xml_context_t *xmlctx,
 {
   svn_ra_serf__xml_estate_t *current = xmlctx->current;
   svn_ra_serf__dav_props_t elemname;
-  const svn_ra_serf__xml_transition_t *scan;
+  const svn_ra_serf__xml_transition_t *const *trans;
+  const svn_ra_serf__xml_transition_t *scan = NULL;
   apr_pool_t *new_pool;
   svn_ra_serf__xml_estate_t *new_xes;
 
@@ -656,21 +711,25 @@ xml_cb_start(svn_ra_serf__xml_context_t *xmlctx,
 
   expand_ns(&elemname, current->ns_list, raw_name);
 
-  for (scan = xmlctx->ttable; scan->ns != NULL; ++scan)
-    {
-      if (scan->from_state != current->state)
-        continue;
-
-      /* Wildcard tag match.  */
-      if (*scan->name == '*')
-        break;
-
-      /* Found a specific transition.  */
-      if (strcmp(elemname.name, scan->name) == 0
-          && strcmp(elemname.xmlns, scan->ns) == 0)
-        break;
-    }
-  if (scan->ns == NULL)
+  if (current->state <= xmlctx->max_state)
+    for (trans = xmlctx->transitions[current->state]; *trans; ++trans)
+      {
+        /* Wildcard tag match.  */
+        if (*(*trans)->name == '*')
+          {
+            scan = *trans;
+            break;
+          }
+
+        /* Found a specific transition.  */
+        if (strcmp(elemname.name, (*trans)->name) == 0
+            && strcmp(elemname.xmlns, (*trans)->ns) == 0)
+          {
+            scan = *trans;
+            break;
+          }
+      }
+  if (scan == NULL)
     {
       if (current->state == XML_STATE_INITIAL)
         {
@@ -701,11 +760,18 @@ xml_cb_start(svn_ra_serf__xml_context_t *xmlctx,
   new_pool = xes_pool(current);
   if (scan->collect_cdata || scan->collect_attrs[0])
     {
-      new_pool = svn_pool_create(new_pool);
+      /* Every state pool is released before its parent's, so a pool
+         reused from an earlier sibling serves just as well as a new
+         subpool of the parent.  */
+      if (xmlctx->free_pools->nelts > 0)
+        new_pool = *(apr_pool_t **)apr_array_pop(xmlctx->free_pools);
+      else
+        new_pool = svn_pool_create(xmlctx->free_pools->pool);
 
       /* Prep the new state.  */
       new_xes = apr_pcalloc(new_pool, sizeof(*new_xes));
       new_xes->state_pool = new_pool;
+      new_xes->recycle_pool = TRUE;
 
       /* If we're supposed to collect cdata, then set up a buffer for
          this. The existence of this buffer will instruct our cdata
@@ -828,7 +894,13 @@ xml_cb_end(svn_ra_serf__xml_context_t *xmlctx,
   /* If there is a STATE_POOL, then toss it. This will get rid of as much
      memory as possible. Potentially the XES (if we didn't create a pool
      right away, then XES may be in a parent pool).  */
-  if (xes->state_pool)
+  if (xes->recycle_pool
+      && xmlctx->free_pools->nelts < MAX_FREE_STATE_POOLS)
+    {
+      svn_pool_clear(xes->state_pool);
+      APR_ARRAY_PUSH(xmlctx->free_pools, apr_pool_t *) = xes->state_pool;
+    }
+  else if (xes->state_pool)
     svn_pool_destroy(xes->state_pool);
 
   return SVN_NO_ERROR;
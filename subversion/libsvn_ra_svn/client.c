@@ -239,6 +239,26 @@ svn_error_t *svn_ra_svn__auth_response(svn_ra_svn_conn_t *conn,
   return svn_error_trace(svn_ra_svn__write_tuple(conn, pool, "w(?c)", mech, mech_arg));
 }
 
+/* Authenticate with the server of SESS if the MECHLIST and REALM it sent
+   in an auth request ask for it. */
+static svn_error_t *answer_auth_request(svn_ra_svn__session_baton_t *sess,
+                                        svn_ra_svn__list_t *mechlist,
+                                        const char *realm,
+                                        apr_pool_t *pool)
+{
+  if (mechlist->nelts == 0)
+    return SVN_NO_ERROR;
+  SVN_ERR(DO_AUTH(sess, mechlist, realm, pool));
+
+  /* Unless we got in anonymously, the server now has a user name for us
+     and won't start another authentication exchange on this connection. */
+  if (svn_ra_svn__find_mech(mechlist, "EXTERNAL")
+      || !svn_ra_svn__find_mech(mechlist, "ANONYMOUS"))
+    sess->authenticated = TRUE;
+
+  return SVN_NO_ERROR;
+}
+
 static svn_error_t *handle_auth_request(svn_ra_svn__session_baton_t *sess,
                                         apr_pool_t *pool)
 {
@@ -247,9 +267,7 @@ static svn_error_t *handle_auth_request(svn_ra_svn__session_baton_t *sess,
   const char *realm;
 
   SVN_ERR(svn_ra_svn__read_cmd_response(conn, pool, "lc", &mechlist, &realm));
-  if (mechlist->nelts == 0)
-    return SVN_NO_ERROR;
-  return DO_AUTH(sess, mechlist, realm, pool);
+  return svn_error_trace(answer_auth_request(sess, mechlist, realm, pool));
 }
 
 /* --- REPORTER IMPLEMENTATION --- */
@@ -604,6 +622,77 @@ static apr_status_t close_tunnel_cleanup(void *baton)
   return APR_SUCCESS; /* ignored */
 }
 
+/* Set *MAX_CONNECTIONS to the svn-max-connections value from the
+   "servers" configuration in CONFIG, honoring the server group recorded
+   in AUTH_BATON.  Clamp the result to 1 .. SVN_RA_SVN__MAX_CONNECTIONS.
+   CONFIG and AUTH_BATON may be NULL.
+ */
+static svn_error_t *
+get_max_connections(int *max_connections,
+                    apr_hash_t *config,
+                    svn_auth_baton_t *auth_baton)
+{
+  svn_config_t *cfg;
+  const char *server_group;
+  apr_int64_t value;
+
+  cfg = config ? svn_hash_gets(config, SVN_CONFIG_CATEGORY_SERVERS) : NULL;
+  SVN_ERR(svn_config_get_int64(cfg, &value, SVN_CONFIG_SECTION_GLOBAL,
+                               SVN_CONFIG_OPTION_SVN_MAX_CONNECTIONS,
+                               SVN_CONFIG_DEFAULT_OPTION_SVN_MAX_CONNECTIONS));
+
+  server_group = svn_auth_get_parameter(auth_baton,
+                                        SVN_AUTH_PARAM_SERVER_GROUP);
+  if (server_group)
+    SVN_ERR(svn_config_get_int64(cfg, &value, server_group,
+                                 SVN_CONFIG_OPTION_SVN_MAX_CONNECTIONS,
+                                 value));
+
+  if (value < 1)
+    value = 1;
+  else if (value > SVN_RA_SVN__MAX_CONNECTIONS)
+    value = SVN_RA_SVN__MAX_CONNECTIONS;
+
+  *max_connections = (int)value;
+  return SVN_NO_ERROR;
+}
+
+/* Set *AUTHORITIES and *TRUST_DEFAULT_CA to the ssl-authority-files and
+   ssl-trust-default-ca values from the "servers" configuration in CONFIG,
+   honoring the server group recorded in AUTH_BATON.  *AUTHORITIES will
+   be NULL if no authority files are configured.  CONFIG and AUTH_BATON
+   may be NULL.
+ */
+static svn_error_t *
+get_tls_authorities(const char **authorities,
+                    svn_boolean_t *trust_default_ca,
+                    apr_hash_t *config,
+                    svn_auth_baton_t *auth_baton)
+{
+  svn_config_t *cfg;
+  const char *server_group;
+
+  cfg = config ? svn_hash_gets(config, SVN_CONFIG_CATEGORY_SERVERS) : NULL;
+  svn_config_get(cfg, authorities, SVN_CONFIG_SECTION_GLOBAL,
+                 SVN_CONFIG_OPTION_SSL_AUTHORITY_FILES, NULL);
+  SVN_ERR(svn_config_get_bool(cfg, trust_default_ca,
+                              SVN_CONFIG_SECTION_GLOBAL,
+                              SVN_CONFIG_OPTION_SSL_TRUST_DEFAULT_CA, TRUE));
+
+  server_group = svn_auth_get_parameter(auth_baton,
+                                        SVN_AUTH_PARAM_SERVER_GROUP);
+  if (server_group)
+    {
+      svn_config_get(cfg, authorities, server_group,
+                     SVN_CONFIG_OPTION_SSL_AUTHORITY_FILES, *authorities);
+      SVN_ERR(svn_config_get_bool(cfg, trust_default_ca, server_group,
+                                  SVN_CONFIG_OPTION_SSL_TRUST_DEFAULT_CA,
+                                  *trust_default_ca));
+    }
+
+  return SVN_NO_ERROR;
+}
+
 /* Open a session to URL, returning it in *SESS_P, allocating it in POOL.
    URI is a parsed version of URL.  CALLBACKS and CALLBACKS_BATON
    are provided by the caller of ra_svn_open. If TUNNEL_NAME is not NULL,
@@ -642,6 +731,7 @@ static svn_error_t *open_session(svn_ra_svn__session_baton_t **sess_p,
   sess->is_tunneled = (tunnel_name != NULL);
   sess->parent = parent;
   sess->user = uri->user;
+  sess->authenticated = FALSE;
   sess->hostname = uri->hostname;
   sess->tunnel_name = tunnel_name;
   sess->tunnel_argv = tunnel_argv;
@@ -655,6 +745,8 @@ static svn_error_t *open_session(svn_ra_svn__session_baton_t **sess_p,
   else
     sess->config = NULL;
 
+  SVN_ERR(get_max_connections(&sess->max_connections, config, auth_baton));
+
   if (tunnel_name)
     {
       sess->realm_prefix = apr_psprintf(pool, "<svn+%s://%s:%d>",
@@ -689,15 +781,30 @@ static svn_error_t *open_session(svn_ra_svn__session_baton_t **sess_p,
     }
   else
     {
-      sess->realm_prefix = apr_psprintf(pool, "<svn://%s:%d>", uri->hostname,
-                                        uri->port ? uri->port : SVN_RA_SVN_PORT);
+      svn_boolean_t use_tls = (strncasecmp(url, "svns:", 5) == 0);
+      int port = uri->port ? uri->port : SVN_RA_SVN_PORT;
 
-      SVN_ERR(make_connection(uri->hostname,
-                              uri->port ? uri->port : SVN_RA_SVN_PORT,
-                              &sock, pool));
+      sess->realm_prefix = apr_psprintf(pool, "<%s://%s:%d>",
+                                        use_tls ? "svns" : "svn",
+                                        uri->hostname, port);
+
+      SVN_ERR(make_connection(uri->hostname, port, &sock, pool));
       conn = svn_ra_svn_create_conn5(sock, NULL, NULL,
                                      SVN_DELTA_COMPRESSION_LEVEL_DEFAULT,
                                      0, 0, 0, 0, pool);
+
+      /* For svns://, everything including the greeting is encrypted. */
+      if (use_tls)
+        {
+          const char *authorities;
+          svn_boolean_t trust_default_ca;
+
+          SVN_ERR(get_tls_authorities(&authorities, &trust_default_ca,
+                                      config, auth_baton));
+          SVN_ERR(svn_ra_svn__tls_connect(conn, sess, uri->hostname, port,
+                                          authorities, trust_default_ca,
+                                          scratch_pool));
+        }
     }
 
   /* Build the useragent string, querying the client for any
@@ -806,7 +913,11 @@ static const char *ra_svn_get_description(apr_pool_t *pool)
 static const char * const *
 ra_svn_get_schemes(apr_pool_t *pool)
 {
+#ifdef SVN_HAVE_OPENSSL
+  static const char *schemes[] = { "svn", "svns", NULL };
+#else
   static const char *schemes[] = { "svn", NULL };
+#endif
 
   return schemes;
 }
@@ -921,6 +1032,36 @@ static svn_error_t *ra_svn_dup_session(svn_ra_session_t *new_session,
   return SVN_NO_ERROR;
 }
 
+svn_error_t *
+svn_ra_svn__open_fetch_session(svn_ra_session_t **fetch_session,
+                               svn_ra_session_t *session,
+                               apr_pool_t *result_pool,
+                               apr_pool_t *scratch_pool)
+{
+  svn_ra_svn__session_baton_t *sess = session->priv;
+  svn_ra_callbacks2_t *callbacks;
+  svn_ra_session_t *new_session;
+
+  /* Progress notifications are not expected to come from other threads. */
+  callbacks = apr_pmemdup(result_pool, sess->callbacks,
+                          sizeof(*sess->callbacks));
+  callbacks->progress_func = NULL;
+
+  new_session = apr_pcalloc(result_pool, sizeof(*new_session));
+  new_session->vtable = session->vtable;
+  new_session->cancel_func = session->cancel_func;
+  new_session->cancel_baton = session->cancel_baton;
+  new_session->pool = result_pool;
+
+  SVN_ERR(ra_svn_open(new_session, NULL, sess->parent->client_url->data,
+                      callbacks, sess->callbacks_baton,
+                      sess->auth_baton, sess->config,
+                      result_pool, scratch_pool));
+
+  *fetch_session = new_session;
+  return SVN_NO_ERROR;
+}
+
 /* Send the "reparent to URL" command to the server for RA_SESSION and
    update the session state.  Use SCRATCH_POOL for tempoaries.
  */
@@ -1539,23 +1680,21 @@ send_dirent_fields(svn_ra_svn_conn_t *conn,
   return SVN_NO_ERROR;
 }
 
-static svn_error_t *ra_svn_get_dir(svn_ra_session_t *session,
-                                   apr_hash_t **dirents,
-                                   svn_revnum_t *fetched_rev,
-                                   apr_hash_t **props,
-                                   const char *path,
-                                   svn_revnum_t rev,
-                                   apr_uint32_t dirent_fields,
-                                   apr_pool_t *pool)
+/* Write a get-dir command for PATH in REV to CONN, asking for the
+ * directory's properties if WANT_PROPS is set and for its entries with
+ * DIRENT_FIELDS if WANT_CONTENTS is set.  Use POOL for temporary
+ * allocations. */
+static svn_error_t *
+write_cmd_get_dir(svn_ra_svn_conn_t *conn,
+                  const char *path,
+                  svn_revnum_t rev,
+                  svn_boolean_t want_props,
+                  svn_boolean_t want_contents,
+                  apr_uint32_t dirent_fields,
+                  apr_pool_t *pool)
 {
-  svn_ra_svn__session_baton_t *sess_baton = session->priv;
-  svn_ra_svn_conn_t *conn = sess_baton->conn;
-  svn_ra_svn__list_t *proplist, *dirlist;
-  int i;
-
-  path = reparent_path(session, path, pool);
   SVN_ERR(svn_ra_svn__write_tuple(conn, pool, "w(c(?r)bb(!", "get-dir", path,
-                                  rev, (props != NULL), (dirents != NULL)));
+                                  rev, want_props, want_contents));
   SVN_ERR(send_dirent_fields(conn, dirent_fields, pool));
 
   /* Always send the, nominally optional, want-iprops as "false" to
@@ -1563,12 +1702,21 @@ static svn_error_t *ra_svn_get_dir(svn_ra_session_t *session,
      to see "true" if it is omitted. */
   SVN_ERR(svn_ra_svn__write_tuple(conn, pool, "!)b)", FALSE));
 
-  SVN_ERR(handle_auth_request(sess_baton, pool));
-  SVN_ERR(svn_ra_svn__read_cmd_response(conn, pool, "rll", &rev, &proplist,
-                                        &dirlist));
+  return SVN_NO_ERROR;
+}
+
+/* Interpret the PROPLIST and DIRLIST of a successful get-dir response.
+ * Set *DIRENTS and *PROPS, each of which may be NULL, as described for
+ * svn_ra_get_dir2().  Allocate them in POOL. */
+static svn_error_t *
+parse_get_dir_response(apr_hash_t **dirents,
+                       apr_hash_t **props,
+                       const svn_ra_svn__list_t *proplist,
+                       const svn_ra_svn__list_t *dirlist,
+                       apr_pool_t *pool)
+{
+  int i;
 
-  if (fetched_rev)
-    *fetched_rev = rev;
   if (props)
     SVN_ERR(svn_ra_svn__parse_proplist(proplist, pool, props));
 
@@ -1625,6 +1773,33 @@ static svn_error_t *ra_svn_get_dir(svn_ra_session_t *session,
   return SVN_NO_ERROR;
 }
 
+static svn_error_t *ra_svn_get_dir(svn_ra_session_t *session,
+                                   apr_hash_t **dirents,
+                                   svn_revnum_t *fetched_rev,
+                                   apr_hash_t **props,
+                                   const char *path,
+                                   svn_revnum_t rev,
+                                   apr_uint32_t dirent_fields,
+                                   apr_pool_t *pool)
+{
+  svn_ra_svn__session_baton_t *sess_baton = session->priv;
+  svn_ra_svn_conn_t *conn = sess_baton->conn;
+  svn_ra_svn__list_t *proplist, *dirlist;
+
+  path = reparent_path(session, path, pool);
+  SVN_ERR(write_cmd_get_dir(conn, path, rev, (props != NULL),
+                            (dirents != NULL), dirent_fields, pool));
+  SVN_ERR(handle_auth_request(sess_baton, pool));
+  SVN_ERR(svn_ra_svn__read_cmd_response(conn, pool, "rll", &rev, &proplist,
+                                        &dirlist));
+
+  if (fetched_rev)
+    *fetched_rev = rev;
+
+  return svn_error_trace(parse_get_dir_response(dirents, props, proplist,
+                                                dirlist, pool));
+}
+
 /* Converts a apr_uint64_t with values TRUE, FALSE or
    SVN_RA_SVN_UNSPECIFIED_NUMBER as provided by svn_ra_svn__parse_tuple
    to a svn_tristate_t */
@@ -1717,14 +1892,30 @@ static svn_error_t *ra_svn_update(svn_ra_session_t *session,
   svn_ra_svn__session_baton_t *sess_baton = session->priv;
   svn_ra_svn_conn_t *conn = sess_baton->conn;
   svn_boolean_t recurse = DEPTH_TO_RECURSE(depth);
+  svn_boolean_t fetch_in_parallel = FALSE;
 
   /* Callbacks may assume that all data is relative the sessions's URL. */
   SVN_ERR(ensure_exact_server_parent(session, scratch_pool));
 
+#if APR_HAS_THREADS
+  /* If we may use additional connections, let the server send only the
+     tree structure and fetch the file contents alongside. */
+  if (sess_baton->max_connections > 1
+      && svn_ra_svn_has_capability(conn, SVN_RA_SVN_CAP_SKELTA))
+    {
+      SVN_ERR(svn_ra_svn__get_fetching_editor(&update_editor, &update_baton,
+                                              update_editor, update_baton,
+                                              session,
+                                              sess_baton->max_connections,
+                                              pool));
+      fetch_in_parallel = TRUE;
+    }
+#endif
+
   /* Tell the server we want to start an update. */
   SVN_ERR(svn_ra_svn__write_cmd_update(conn, pool, rev, target, recurse,
                                        depth, send_copyfrom_args,
-                                       ignore_ancestry));
+                                       ignore_ancestry, !fetch_in_parallel));
   SVN_ERR(handle_auth_request(sess_baton, pool));
 
   /* Fetch a reporter for the caller to drive.  The reporter will drive
@@ -3073,6 +3264,7 @@ ra_svn_has_capability(svn_ra_session_t *session,
       {SVN_RA_CAPABILITY_GET_FILE_REVS_REVERSE,
                                        SVN_RA_SVN_CAP_GET_FILE_REVS_REVERSE},
       {SVN_RA_CAPABILITY_LIST, SVN_RA_SVN_CAP_LIST},
+      {SVN_RA_CAPABILITY_BLAME, SVN_RA_SVN_CAP_BLAME},
 
       {NULL, NULL} /* End of list marker */
   };
@@ -3242,6 +3434,289 @@ ra_svn_list(svn_ra_session_t *session,
   return SVN_NO_ERROR;
 }
 
+static svn_error_t *
+ra_svn_blame(svn_ra_session_t *session,
+             const char *path,
+             svn_revnum_t start,
+             svn_revnum_t end,
+             const svn_diff_file_options_t *diff_options,
+             svn_ra_blame_receiver_t receiver,
+             void *receiver_baton,
+             apr_pool_t *scratch_pool)
+{
+  svn_ra_svn__session_baton_t *sess_baton = session->priv;
+  svn_ra_svn_conn_t *conn = sess_baton->conn;
+  apr_pool_t *iterpool = svn_pool_create(scratch_pool);
+  const char *ignore_space_word = "none";
+  svn_boolean_t ignore_eol_style = FALSE;
+  apr_hash_t *rev_props_cache = apr_hash_make(scratch_pool);
+  apr_int64_t line_no;
+
+  if (diff_options)
+    {
+      if (diff_options->ignore_space == svn_diff_file_ignore_space_change)
+        ignore_space_word = "change";
+      else if (diff_options->ignore_space == svn_diff_file_ignore_space_all)
+        ignore_space_word = "all";
+      ignore_eol_style = diff_options->ignore_eol_style;
+    }
+
+  path = reparent_path(session, path, scratch_pool);
+
+  SVN_ERR(svn_ra_svn__write_tuple(conn, scratch_pool, "w(c(?r)(?r)wb)",
+                                  "blame", path, start, end,
+                                  ignore_space_word, ignore_eol_style));
+
+  /* Handle auth request by server */
+  SVN_ERR(handle_auth_request(sess_baton, scratch_pool));
+
+  /* Read and process the annotated lines. */
+  for (line_no = 0; ; ++line_no)
+    {
+      svn_ra_svn__item_t *item;
+      svn_ra_svn__list_t *proplist;
+      const char *line;
+      svn_revnum_t rev;
+      apr_hash_t *rev_props = NULL;
+
+      svn_pool_clear(iterpool);
+
+      /* Read the next line or bail out on "done", respectively */
+      SVN_ERR(svn_ra_svn__read_item(conn, iterpool, &item));
+      if (is_done_response(item))
+        break;
+      if (item->kind != SVN_RA_SVN_LIST)
+        return svn_error_create(SVN_ERR_RA_SVN_MALFORMED_DATA, NULL,
+                                _("Blame entry not a list"));
+      SVN_ERR(svn_ra_svn__parse_tuple(&item->u.list, "c(?r)l",
+                                      &line, &rev, &proplist));
+
+      /* The revprops are only sent with the first line of each revision. */
+      if (SVN_IS_VALID_REVNUM(rev))
+        {
+          rev_props = apr_hash_get(rev_props_cache, &rev, sizeof(rev));
+          if (!rev_props)
+            {
+              svn_revnum_t *key = apr_pmemdup(scratch_pool, &rev,
+                                              sizeof(rev));
+
+              SVN_ERR(svn_ra_svn__parse_proplist(proplist, iterpool,
+                                                 &rev_props));
+              rev_props = svn_prop_hash_dup(rev_props, scratch_pool);
+              apr_hash_set(rev_props_cache, key, sizeof(*key), rev_props);
+            }
+        }
+
+      SVN_ERR(receiver(receiver_baton, line_no, rev, rev_props, line,
+                       iterpool));
+    }
+  svn_pool_destroy(iterpool);
+
+  /* Read the actual command response. */
+  SVN_ERR(svn_ra_svn__read_cmd_response(conn, scratch_pool, ""));
+  return SVN_NO_ERROR;
+}
+
+/* The maximum number of commands that ra_svn_get_nodes() has in flight.
+ * These commands are small, so bounding their number keeps them within
+ * the socket buffers: we can never block on sending a command while the
+ * server blocks on sending us a response. */
+#define MAX_PIPELINED_COMMANDS 16
+
+/* Return TRUE if ERR is one of the errors that ra_svn_get_nodes() uses
+ * to report that the connection is no longer in a known state. */
+static svn_boolean_t
+is_connection_error(const svn_error_t *err)
+{
+  return err->apr_err == SVN_ERR_RA_SVN_CONNECTION_CLOSED
+      || err->apr_err == SVN_ERR_RA_SVN_IO_ERROR
+      || err->apr_err == SVN_ERR_RA_SVN_MALFORMED_DATA;
+}
+
+/* Read a command response from the connection of SESS like
+ * svn_ra_svn__read_cmd_response() and set *PARAMS to its parameters.
+ * If the server reports that the command failed, return its error
+ * wrapped in SVN_ERR_RA_SVN_CMD_ERR; the response has been read
+ * completely then.  Any other error leaves the connection in an unknown
+ * state.  Allocate *PARAMS in POOL. */
+static svn_error_t *
+read_node_cmd_response(svn_ra_svn__list_t **params,
+                       svn_ra_svn__session_baton_t *sess,
+                       apr_pool_t *pool)
+{
+  const char *status;
+
+  SVN_ERR(svn_ra_svn__read_tuple(sess->conn, pool, "wl", &status, params));
+  if (strcmp(status, "success") == 0)
+    return SVN_NO_ERROR;
+  else if (strcmp(status, "failure") == 0)
+    return svn_error_create(SVN_ERR_RA_SVN_CMD_ERR,
+                            svn_ra_svn__handle_failure_status(*params),
+                            NULL);
+
+  return svn_error_createf(SVN_ERR_RA_SVN_MALFORMED_DATA, NULL,
+                           _("Unknown status '%s' in command response"),
+                           status);
+}
+
+/* Write the get-dir or get-file command for REQUEST in REVISION to the
+ * connection of SESSION.  Use POOL for temporary allocations. */
+static svn_error_t *
+write_node_request(svn_ra_session_t *session,
+                   const svn_ra__node_request_t *request,
+                   svn_revnum_t revision,
+                   svn_boolean_t want_dirents,
+                   svn_boolean_t want_props,
+                   apr_uint32_t dirent_fields,
+                   apr_pool_t *pool)
+{
+  svn_ra_svn__session_baton_t *sess_baton = session->priv;
+  const char *path = reparent_path(session, request->path, pool);
+
+  if (request->kind == svn_node_dir)
+    return svn_error_trace(write_cmd_get_dir(sess_baton->conn, path,
+                                             revision, want_props,
+                                             want_dirents, dirent_fields,
+                                             pool));
+
+  return svn_error_trace(svn_ra_svn__write_cmd_get_file(sess_baton->conn,
+                                                        pool, path, revision,
+                                                        want_props, FALSE));
+}
+
+/* Read the response to the command written by write_node_request() for
+ * REQUEST from the connection of SESS and store the results in REQUEST.
+ * PIPELINED tells whether other commands are queued behind this one; an
+ * authentication exchange at this point would consume those commands as
+ * its responses, so it is treated as fatal.  Errors are returned as for
+ * read_node_cmd_response().  Allocate the results in RESULT_POOL and use
+ * SCRATCH_POOL for temporary allocations. */
+static svn_error_t *
+read_node_response(svn_ra__node_request_t *request,
+                   svn_ra_svn__session_baton_t *sess,
+                   svn_boolean_t pipelined,
+                   svn_boolean_t want_dirents,
+                   svn_boolean_t want_props,
+                   apr_pool_t *result_pool,
+                   apr_pool_t *scratch_pool)
+{
+  apr_hash_t *dirents = NULL;
+  apr_hash_t *props = NULL;
+  svn_ra_svn__list_t *params, *mechlist, *proplist, *dirlist;
+  const char *realm;
+  svn_revnum_t rev;
+
+  SVN_ERR(read_node_cmd_response(&params, sess, scratch_pool));
+  SVN_ERR(svn_ra_svn__parse_tuple(params, "lc", &mechlist, &realm));
+  if (pipelined && mechlist->nelts != 0)
+    return svn_error_create(SVN_ERR_RA_SVN_MALFORMED_DATA, NULL,
+                            _("Unexpected authentication request for a "
+                              "pipelined command"));
+  SVN_ERR(answer_auth_request(sess, mechlist, realm, scratch_pool));
+
+  SVN_ERR(read_node_cmd_response(&params, sess, result_pool));
+  if (request->kind == svn_node_dir)
+    {
+      SVN_ERR(svn_ra_svn__parse_tuple(params, "rll", &rev, &proplist,
+                                      &dirlist));
+      SVN_ERR(parse_get_dir_response(want_dirents ? &dirents : NULL,
+                                     want_props ? &props : NULL,
+                                     proplist, dirlist, result_pool));
+    }
+  else
+    {
+      const char *expected_digest;
+
+      SVN_ERR(svn_ra_svn__parse_tuple(params, "(?c)rl", &expected_digest,
+                                      &rev, &proplist));
+      if (want_props)
+        SVN_ERR(svn_ra_svn__parse_proplist(proplist, result_pool, &props));
+    }
+
+  request->dirents = dirents;
+  request->props = props;
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+ra_svn_get_nodes(svn_ra_session_t *session,
+                 apr_array_header_t *requests,
+                 svn_revnum_t revision,
+                 svn_boolean_t want_dirents,
+                 svn_boolean_t want_props,
+                 apr_uint32_t dirent_fields,
+                 apr_pool_t *result_pool,
+                 apr_pool_t *scratch_pool)
+{
+  svn_ra_svn__session_baton_t *sess_baton = session->priv;
+  /* Unless the server already knows who we are, it may want to
+     authenticate us in the middle of any of these commands.  Send them
+     one at a time then. */
+  svn_boolean_t pipelined = sess_baton->authenticated;
+  int max_in_flight = pipelined ? MAX_PIPELINED_COMMANDS : 1;
+  int sent = 0, received = 0;
+  svn_error_t *err = SVN_NO_ERROR;
+  apr_pool_t *iterpool = svn_pool_create(scratch_pool);
+
+  while (received < requests->nelts)
+    {
+      svn_ra__node_request_t *request;
+      svn_error_t *request_err;
+
+      svn_pool_clear(iterpool);
+
+      /* Top up the pipeline.  The commands sit in the write buffer until
+         we read the next response, which flushes them in one go. */
+      while (sent < requests->nelts && sent - received < max_in_flight)
+        {
+          request = APR_ARRAY_IDX(requests, sent, svn_ra__node_request_t *);
+          request_err = write_node_request(session, request, revision,
+                                           want_dirents, want_props,
+                                           dirent_fields, iterpool);
+          if (request_err)
+            {
+              if (!is_connection_error(request_err))
+                request_err = svn_error_create(SVN_ERR_RA_SVN_IO_ERROR,
+                                               request_err, NULL);
+              return svn_error_compose_create(request_err, err);
+            }
+
+          sent++;
+        }
+
+      /* Responses arrive in the order the commands were sent.  A command
+         that the server reports as failed doesn't affect the ones queued
+         behind it.  Anything else leaves the responses to those unread, so
+         make sure the caller recognizes the connection as broken. */
+      request = APR_ARRAY_IDX(requests, received, svn_ra__node_request_t *);
+      request_err = read_node_response(request, sess_baton,
+                                       pipelined && sent - received > 1,
+                                       want_dirents, want_props,
+                                       result_pool, iterpool);
+      received++;
+
+      if (request_err && request_err->apr_err != SVN_ERR_RA_SVN_CMD_ERR)
+        {
+          if (!is_connection_error(request_err))
+            request_err = svn_error_create(SVN_ERR_RA_SVN_IO_ERROR,
+                                           request_err, NULL);
+          return svn_error_compose_create(request_err, err);
+        }
+      else if (request_err && err)
+        svn_error_clear(request_err);
+      else if (request_err)
+        {
+          err = svn_error_dup(
+                  svn_ra_svn__locate_real_error_child(request_err));
+          svn_error_clear(request_err);
+        }
+    }
+
+  svn_pool_destroy(iterpool);
+  return svn_error_trace(err);
+}
+
 static const svn_ra__vtable_t ra_svn_vtable = {
   svn_ra_svn_version,
   ra_svn_get_description,
@@ -3282,6 +3757,8 @@ static const svn_ra__vtable_t ra_svn_vtable = {
   ra_svn_get_inherited_props,
   NULL /* ra_set_svn_ra_open */,
   ra_svn_list,
+  ra_svn_blame,
+  ra_svn_get_nodes,
   ra_svn_register_editor_shim_callbacks,
   NULL /* commit_ev2 */,
   NULL /* replay_range_ev2 */
@@ -1107,7 +1107,10 @@ svn_error_t *svn_ra_svn_drive_editor2(svn_ra_svn_conn_t *conn,
       if (editor)
         {
           cmd_handler_t handler;
-          SVN_ERR(svn_ra_svn__read_tuple(conn, subpool, "wl", &cmd, &params));
+          /* The handlers don't read from CONN and editor parameters need
+             not outlive the respective call, so avoid copying them. */
+          SVN_ERR(svn_ra_svn__read_tuple_transient(conn, subpool, "wl",
+                                                   &cmd, &params));
           handler = cmd_lookup(cmd);
 
           if (handler)
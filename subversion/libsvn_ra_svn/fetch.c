@@ -0,0 +1,933 @@
+/*
+ * fetch.c :  Fetching file contents for an update over parallel connections
+ *
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ */
+
+
+
+#include <apr_general.h>
+#include <apr_strings.h>
+
+#include "svn_types.h"
+#include "svn_string.h"
+#include "svn_error.h"
+#include "svn_delta.h"
+#include "svn_pools.h"
+#include "svn_private_config.h"
+
+#include "private/svn_subr_private.h"
+
+#include "ra_svn.h"
+
+#if APR_HAS_THREADS
+
+#include <apr_thread_pool.h>
+#include <apr_thread_cond.h>
+
+#include "private/svn_mutex.h"
+
+#include "../libsvn_ra/ra_loader.h"
+
+/*
+ * A plain ra_svn update sends the whole tree, file contents included,
+ * over a single connection.  For a skelta update, the server omits the
+ * file contents and we fetch them with get-file over additional
+ * sessions, one per worker thread, while the main session keeps
+ * reading the editor drive.
+ *
+ * The editor below records every call it receives in a FIFO and replays
+ * that FIFO to the wrapped editor as soon as possible.  An apply_textdelta
+ * call blocks the replay until its contents have been fetched.  Thus, the
+ * wrapped editor sees the very same sequence of calls that a plain update
+ * would produce, except that file contents arrive as deltas against the
+ * empty stream.
+ */
+
+/* Number of fetches per worker that may be pending before the editor
+   waits for the oldest one. */
+#define PENDING_PER_WORKER 4
+
+/* Fetched contents beyond this size get spilled to disk. */
+#define SPILL_SIZE (256 * 1024)
+
+/* Kinds of recorded editor operations. */
+typedef enum op_kind_t
+{
+  op_set_target_revision,
+  op_open_root,
+  op_delete_entry,
+  op_add_directory,
+  op_open_directory,
+  op_change_dir_prop,
+  op_close_directory,
+  op_absent_directory,
+  op_add_file,
+  op_open_file,
+  op_apply_textdelta,
+  op_change_file_prop,
+  op_close_file,
+  op_absent_file
+} op_kind_t;
+
+typedef struct edit_baton_t edit_baton_t;
+
+/* Baton for directories and files. */
+typedef struct node_baton_t
+{
+  edit_baton_t *eb;
+
+  /* Path of the node relative to the session URL. */
+  const char *path;
+
+  /* The wrapped editor's baton.  Valid once the op opening this node has
+     been replayed. */
+  void *wrapped_baton;
+
+  /* Owns all ops recorded for this node, the node itself and the pools
+     of all its sub-nodes.  Destroyed after replaying the node's close. */
+  apr_pool_t *pool;
+} node_baton_t;
+
+/* Contents of one file to fetch. */
+typedef struct fetch_job_t
+{
+  const char *path;
+  svn_revnum_t revision;
+
+  /* Receives the file contents. */
+  svn_spillbuf_t *contents;
+
+  /* Result of the fetch. */
+  svn_error_t *err;
+
+  /* Set once CONTENTS and ERR are valid.  Protected by the edit baton's
+     MUTEX. */
+  svn_boolean_t done;
+
+  edit_baton_t *eb;
+
+  /* Private, thread-safe pool owning this structure. */
+  apr_pool_t *pool;
+} fetch_job_t;
+
+/* A recorded editor operation. */
+typedef struct op_t
+{
+  op_kind_t kind;
+
+  /* The node opened, closed or modified by this op.  NULL for ops that
+     only refer to their PARENT. */
+  node_baton_t *node;
+
+  /* Parent directory for delete, add, open and absent ops. */
+  node_baton_t *parent;
+
+  /* Arguments, depending on KIND. */
+  const char *path;
+  const char *name;
+  const svn_string_t *value;
+  const char *copyfrom_path;
+  svn_revnum_t revision;
+  const char *checksum;
+
+  /* The contents to send for op_apply_textdelta. */
+  fetch_job_t *job;
+
+  struct op_t *next;
+} op_t;
+
+struct edit_baton_t
+{
+  const svn_delta_editor_t *wrapped_editor;
+  void *wrapped_baton;
+
+  /* The session driving the edit and the revision being updated to. */
+  svn_ra_session_t *session;
+  svn_revnum_t target_revision;
+
+  /* Recorded but not yet replayed ops.  Both NULL if none. */
+  op_t *first;
+  op_t *last;
+
+  /* Number of fetch jobs in the FIFO and the limit for it. */
+  int pending;
+  int max_pending;
+
+  /* Maximum number of additional sessions. */
+  int max_workers;
+
+  /* Set once we tried to open the fetch sessions. */
+  svn_boolean_t sessions_opened;
+
+  /* If set, fetch all contents through this session on the main thread
+     instead of using workers. */
+  svn_ra_session_t *sync_session;
+
+  /* Sessions not currently used by a worker.  Protected by MUTEX. */
+  svn_ra_session_t **idle_sessions;
+  int idle_count;
+
+  /* Runs the fetches.  Allocated in a thread-safe pool of its own. */
+  apr_thread_pool_t *thread_pool;
+  apr_pool_t *thread_pool_pool;
+
+  /* Synchronize the DONE flags of all jobs and IDLE_SESSIONS. */
+  svn_mutex__t *mutex;
+  apr_thread_cond_t *cond;
+
+  /* Owns the fetch sessions. */
+  apr_pool_t *sessions_pool;
+
+  /* For temporaries during replay. */
+  apr_pool_t *iterpool;
+
+  apr_pool_t *pool;
+};
+
+/* Pool pre-cleanup for the edit baton given as DATA.  Stop all workers
+   and release the contents that have not been replayed. */
+static apr_status_t
+fetch_cleanup(void *data)
+{
+  edit_baton_t *eb = data;
+  op_t *op;
+
+  /* This waits for all running fetches. */
+  if (eb->thread_pool)
+    {
+      apr_thread_pool_destroy(eb->thread_pool);
+      svn_pool_destroy(eb->thread_pool_pool);
+      eb->thread_pool = NULL;
+    }
+
+  for (op = eb->first; op; op = op->next)
+    if (op->job)
+      {
+        svn_error_clear(op->job->err);
+        svn_pool_destroy(op->job->pool);
+      }
+
+  eb->first = NULL;
+  eb->last = NULL;
+
+  return APR_SUCCESS;
+}
+
+/* Fetch the contents of JOB through SESSION. */
+static svn_error_t *
+fetch_file(svn_ra_session_t *session,
+           fetch_job_t *job)
+{
+  svn_stream_t *stream = svn_stream__from_spillbuf(job->contents, job->pool);
+
+  return svn_error_trace(session->vtable->get_file(session, job->path,
+                                                   job->revision, stream,
+                                                   NULL, NULL, job->pool));
+}
+
+/* Thread-pool task fetching the fetch_job_t given as DATA through one of
+   the idle sessions. */
+static void * APR_THREAD_FUNC
+fetch_task(apr_thread_t *tid,
+           void *data)
+{
+  fetch_job_t *job = data;
+  edit_baton_t *eb = job->eb;
+  svn_ra_session_t *session = NULL;
+  svn_error_t *err;
+
+  /* There are as many sessions as threads, so one of them is idle. */
+  err = svn_mutex__lock(eb->mutex);
+  if (!err)
+    {
+      session = eb->idle_sessions[--eb->idle_count];
+      err = svn_mutex__unlock(eb->mutex, SVN_NO_ERROR);
+    }
+
+  job->err = err ? err : fetch_file(session, job);
+
+  /* Tell the main thread that we are done.  There is no way to report
+     errors in the synchronization itself, but those would make the main
+     thread fail when waiting for us anyway. */
+  err = svn_mutex__lock(eb->mutex);
+  if (!err)
+    {
+      if (session)
+        eb->idle_sessions[eb->idle_count++] = session;
+
+      job->done = TRUE;
+      apr_thread_cond_broadcast(eb->cond);
+      err = svn_mutex__unlock(eb->mutex, SVN_NO_ERROR);
+    }
+  svn_error_clear(err);
+
+  return NULL;
+}
+
+/* Open the additional sessions for EB and start the workers.  Fall back
+   to fetching synchronously if workers could not handle authentication
+   requests. */
+static svn_error_t *
+open_fetch_sessions(edit_baton_t *eb,
+                    apr_pool_t *scratch_pool)
+{
+  svn_ra_svn__session_baton_t *sess = eb->session->priv;
+  apr_status_t status;
+  int i;
+
+  eb->sessions_opened = TRUE;
+  eb->idle_sessions = apr_palloc(eb->sessions_pool,
+                                 eb->max_workers
+                                   * sizeof(*eb->idle_sessions));
+
+  for (i = 0; i < eb->max_workers; i++)
+    {
+      svn_ra_session_t *fetch_session;
+      svn_ra_svn__session_baton_t *fetch_sess;
+      svn_error_t *err;
+
+      err = svn_ra_svn__open_fetch_session(&fetch_session, eb->session,
+                                           eb->sessions_pool, scratch_pool);
+
+      /* Make do with the sessions we already have, e.g. if the server
+         limits the number of connections per client. */
+      if (err && i > 0)
+        {
+          svn_error_clear(err);
+          break;
+        }
+      SVN_ERR(err);
+
+      /* Once we authenticated, the server may restrict what anonymous
+         users can read.  A session that is still anonymous may then be
+         asked to authenticate in the middle of a get-file, which would
+         involve prompting the user from a worker thread. */
+      fetch_sess = fetch_session->priv;
+      if (sess->authenticated && !fetch_sess->authenticated)
+        {
+          if (i == 0)
+            eb->sync_session = fetch_session;
+
+          break;
+        }
+
+      eb->idle_sessions[eb->idle_count++] = fetch_session;
+    }
+
+  if (eb->idle_count == 0)
+    return SVN_NO_ERROR;
+
+  eb->max_pending = PENDING_PER_WORKER * eb->idle_count;
+
+  SVN_ERR(svn_mutex__init(&eb->mutex, TRUE, eb->pool));
+  status = apr_thread_cond_create(&eb->cond, eb->pool);
+  if (status)
+    return svn_error_wrap_apr(status, _("Can't create condition variable"));
+
+  /* The thread-pool must be allocated from a thread-safe pool. */
+  eb->thread_pool_pool = svn_pool_create(NULL);
+  status = apr_thread_pool_create(&eb->thread_pool, 0, eb->idle_count,
+                                  eb->thread_pool_pool);
+  if (status)
+    {
+      svn_pool_destroy(eb->thread_pool_pool);
+      return svn_error_wrap_apr(status, _("Can't create fetch thread pool"));
+    }
+
+  return SVN_NO_ERROR;
+}
+
+/* Set *JOB to a new job fetching PATH in EB's target revision and start
+   it, unless it has to be run synchronously, in which case it will be
+   done upon return. */
+static svn_error_t *
+start_fetch(fetch_job_t **job,
+            edit_baton_t *eb,
+            const char *path,
+            apr_pool_t *scratch_pool)
+{
+  apr_pool_t *job_pool;
+
+  SVN_ERR_ASSERT(SVN_IS_VALID_REVNUM(eb->target_revision));
+
+  if (!eb->sessions_opened)
+    SVN_ERR(open_fetch_sessions(eb, scratch_pool));
+
+  /* Workers need a pool of their own that is safe to use from any
+     thread. */
+  job_pool = svn_pool_create(NULL);
+  *job = apr_pcalloc(job_pool, sizeof(**job));
+  (*job)->path = apr_pstrdup(job_pool, path);
+  (*job)->revision = eb->target_revision;
+  (*job)->contents = svn_spillbuf__create(SVN__STREAM_CHUNK_SIZE, SPILL_SIZE,
+                                          job_pool);
+  (*job)->eb = eb;
+  (*job)->pool = job_pool;
+
+  if (eb->thread_pool)
+    {
+      apr_status_t status = apr_thread_pool_push(eb->thread_pool, fetch_task,
+                                                 *job, 0, NULL);
+      if (status)
+        {
+          (*job)->err = svn_error_wrap_apr(status, _("Can't push task"));
+          (*job)->done = TRUE;
+        }
+    }
+  else
+    {
+      (*job)->err = fetch_file(eb->sync_session, *job);
+      (*job)->done = TRUE;
+    }
+
+  return SVN_NO_ERROR;
+}
+
+/* Set *DONE to whether JOB has finished.  If WAIT is set, wait for it. */
+static svn_error_t *
+check_job(svn_boolean_t *done,
+          edit_baton_t *eb,
+          fetch_job_t *job,
+          svn_boolean_t wait)
+{
+  /* Synchronous jobs don't need synchronization. */
+  if (!eb->thread_pool)
+    {
+      *done = job->done;
+      return SVN_NO_ERROR;
+    }
+
+  SVN_ERR(svn_mutex__lock(eb->mutex));
+  while (wait && !job->done)
+    {
+      apr_status_t status = apr_thread_cond_wait(eb->cond,
+                                                 svn_mutex__get(eb->mutex));
+      if (status)
+        return svn_error_trace(
+                 svn_mutex__unlock(eb->mutex,
+                                   svn_error_wrap_apr(status,
+                                        _("Can't wait for fetch task"))));
+    }
+  *done = job->done;
+
+  return svn_error_trace(svn_mutex__unlock(eb->mutex, SVN_NO_ERROR));
+}
+
+/* Send the contents fetched by OP's job to the wrapped editor and release
+   them. */
+static svn_error_t *
+replay_contents(edit_baton_t *eb,
+                op_t *op)
+{
+  fetch_job_t *job = op->job;
+  svn_txdelta_window_handler_t handler;
+  void *handler_baton;
+  svn_error_t *err = job->err;
+
+  if (!err)
+    err = eb->wrapped_editor->apply_textdelta(op->node->wrapped_baton,
+                                              op->checksum, op->node->pool,
+                                              &handler, &handler_baton);
+  if (!err)
+    err = svn_txdelta_send_stream(svn_stream__from_spillbuf(job->contents,
+                                                            job->pool),
+                                  handler, handler_baton, NULL, job->pool);
+
+  svn_pool_destroy(job->pool);
+
+  return svn_error_trace(err);
+}
+
+/* Forward OP to the wrapped editor of EB.  OP must already have been
+   removed from EB's FIFO. */
+static svn_error_t *
+replay_op(edit_baton_t *eb,
+          op_t *op)
+{
+  const svn_delta_editor_t *editor = eb->wrapped_editor;
+  node_baton_t *node = op->node;
+  apr_pool_t *scratch_pool = eb->iterpool;
+
+  svn_pool_clear(scratch_pool);
+  switch (op->kind)
+    {
+      case op_set_target_revision:
+        return svn_error_trace(editor->set_target_revision(eb->wrapped_baton,
+                                                           op->revision,
+                                                           scratch_pool));
+
+      case op_open_root:
+        return svn_error_trace(editor->open_root(eb->wrapped_baton,
+                                                 op->revision, node->pool,
+                                                 &node->wrapped_baton));
+
+      case op_delete_entry:
+        return svn_error_trace(editor->delete_entry(op->path, op->revision,
+                                                    op->parent->wrapped_baton,
+                                                    scratch_pool));
+
+      case op_add_directory:
+        return svn_error_trace(editor->add_directory(op->path,
+                                                     op->parent->wrapped_baton,
+                                                     op->copyfrom_path,
+                                                     op->revision,
+                                                     node->pool,
+                                                     &node->wrapped_baton));
+
+      case op_open_directory:
+        return svn_error_trace(editor->open_directory(op->path,
+                                                      op->parent->wrapped_baton,
+                                                      op->revision,
+                                                      node->pool,
+                                                      &node->wrapped_baton));
+
+      case op_change_dir_prop:
+        return svn_error_trace(editor->change_dir_prop(node->wrapped_baton,
+                                                       op->name, op->value,
+                                                       scratch_pool));
+
+      case op_close_directory:
+        SVN_ERR(editor->close_directory(node->wrapped_baton, scratch_pool));
+        svn_pool_destroy(node->pool);
+        return SVN_NO_ERROR;
+
+      case op_absent_directory:
+        return svn_error_trace(editor->absent_directory(
+                                 op->path, op->parent->wrapped_baton,
+                                 scratch_pool));
+
+      case op_add_file:
+        return svn_error_trace(editor->add_file(op->path,
+                                                op->parent->wrapped_baton,
+                                                op->copyfrom_path,
+                                                op->revision,
+                                                node->pool,
+                                                &node->wrapped_baton));
+
+      case op_open_file:
+        return svn_error_trace(editor->open_file(op->path,
+                                                 op->parent->wrapped_baton,
+                                                 op->revision,
+                                                 node->pool,
+                                                 &node->wrapped_baton));
+
+      case op_apply_textdelta:
+        return svn_error_trace(replay_contents(eb, op));
+
+      case op_change_file_prop:
+        return svn_error_trace(editor->change_file_prop(node->wrapped_baton,
+                                                        op->name, op->value,
+                                                        scratch_pool));
+
+      case op_close_file:
+        SVN_ERR(editor->close_file(node->wrapped_baton, op->checksum,
+                                   scratch_pool));
+        svn_pool_destroy(node->pool);
+        return SVN_NO_ERROR;
+
+      case op_absent_file:
+        return svn_error_trace(editor->absent_file(op->path,
+                                                   op->parent->wrapped_baton,
+                                                   scratch_pool));
+
+      default:
+        SVN_ERR_MALFUNCTION();
+    }
+}
+
+/* Replay the recorded ops of EB in order, up to the first fetch that has
+   not finished yet.  Wait for fetches to finish while more than
+   MAX_PENDING of them are queued. */
+static svn_error_t *
+drain_queue(edit_baton_t *eb,
+            int max_pending)
+{
+  while (eb->first)
+    {
+      op_t *op = eb->first;
+
+      if (op->job)
+        {
+          svn_boolean_t done;
+
+          SVN_ERR(check_job(&done, eb, op->job, eb->pending > max_pending));
+          if (!done)
+            break;
+
+          eb->pending--;
+        }
+
+      eb->first = op->next;
+      if (!eb->first)
+        eb->last = NULL;
+
+      SVN_ERR(replay_op(eb, op));
+    }
+
+  return SVN_NO_ERROR;
+}
+
+/* Return a new op of KIND for NODE and PARENT, allocated in POOL. */
+static op_t *
+make_op(op_kind_t kind,
+        node_baton_t *node,
+        node_baton_t *parent,
+        apr_pool_t *pool)
+{
+  op_t *op = apr_pcalloc(pool, sizeof(*op));
+
+  op->kind = kind;
+  op->node = node;
+  op->parent = parent;
+  op->revision = SVN_INVALID_REVNUM;
+
+  return op;
+}
+
+/* Append OP to EB's FIFO and replay as much of it as we can. */
+static svn_error_t *
+queue_op(edit_baton_t *eb,
+         op_t *op)
+{
+  if (eb->last)
+    eb->last->next = op;
+  else
+    eb->first = op;
+  eb->last = op;
+
+  if (op->job)
+    eb->pending++;
+
+  return svn_error_trace(drain_queue(eb, eb->max_pending));
+}
+
+/* Return a new node baton for PATH in EB, with a new sub-pool of
+   PARENT_POOL. */
+static node_baton_t *
+make_node(edit_baton_t *eb,
+          const char *path,
+          apr_pool_t *parent_pool)
+{
+  apr_pool_t *pool = svn_pool_create(parent_pool);
+  node_baton_t *node = apr_pcalloc(pool, sizeof(*node));
+
+  node->eb = eb;
+  node->path = apr_pstrdup(pool, path);
+  node->pool = pool;
+
+  return node;
+}
+
+static svn_error_t *
+set_target_revision(void *edit_baton,
+                    svn_revnum_t target_revision,
+                    apr_pool_t *pool)
+{
+  edit_baton_t *eb = edit_baton;
+  op_t *op = make_op(op_set_target_revision, NULL, NULL, eb->pool);
+
+  eb->target_revision = target_revision;
+  op->revision = target_revision;
+
+  return svn_error_trace(queue_op(eb, op));
+}
+
+static svn_error_t *
+open_root(void *edit_baton,
+          svn_revnum_t base_revision,
+          apr_pool_t *dir_pool,
+          void **root_baton)
+{
+  edit_baton_t *eb = edit_baton;
+  node_baton_t *node = make_node(eb, "", eb->pool);
+  op_t *op = make_op(op_open_root, node, NULL, node->pool);
+
+  op->revision = base_revision;
+  *root_baton = node;
+
+  return svn_error_trace(queue_op(eb, op));
+}
+
+static svn_error_t *
+delete_entry(const char *path,
+             svn_revnum_t revision,
+             void *parent_baton,
+             apr_pool_t *pool)
+{
+  node_baton_t *parent = parent_baton;
+  op_t *op = make_op(op_delete_entry, NULL, parent, parent->pool);
+
+  op->path = apr_pstrdup(parent->pool, path);
+  op->revision = revision;
+
+  return svn_error_trace(queue_op(parent->eb, op));
+}
+
+/* Common implementation of add_directory, open_directory, add_file and
+   open_file. */
+static svn_error_t *
+open_node(op_kind_t kind,
+          const char *path,
+          node_baton_t *parent,
+          const char *copyfrom_path,
+          svn_revnum_t revision,
+          void **baton)
+{
+  node_baton_t *node = make_node(parent->eb, path, parent->pool);
+  op_t *op = make_op(kind, node, parent, node->pool);
+
+  op->path = node->path;
+  op->copyfrom_path = apr_pstrdup(node->pool, copyfrom_path);
+  op->revision = revision;
+  *baton = node;
+
+  return svn_error_trace(queue_op(parent->eb, op));
+}
+
+static svn_error_t *
+add_directory(const char *path,
+              void *parent_baton,
+              const char *copyfrom_path,
+              svn_revnum_t copyfrom_revision,
+              apr_pool_t *dir_pool,
+              void **child_baton)
+{
+  return svn_error_trace(open_node(op_add_directory, path, parent_baton,
+                                   copyfrom_path, copyfrom_revision,
+                                   child_baton));
+}
+
+static svn_error_t *
+open_directory(const char *path,
+               void *parent_baton,
+               svn_revnum_t base_revision,
+               apr_pool_t *dir_pool,
+               void **child_baton)
+{
+  return svn_error_trace(open_node(op_open_directory, path, parent_baton,
+                                   NULL, base_revision, child_baton));
+}
+
+/* Common implementation of change_dir_prop and change_file_prop. */
+static svn_error_t *
+change_prop(op_kind_t kind,
+            node_baton_t *node,
+            const char *name,
+            const svn_string_t *value)
+{
+  op_t *op = make_op(kind, node, NULL, node->pool);
+
+  op->name = apr_pstrdup(node->pool, name);
+  op->value = value ? svn_string_dup(value, node->pool) : NULL;
+
+  return svn_error_trace(queue_op(node->eb, op));
+}
+
+static svn_error_t *
+change_dir_prop(void *dir_baton,
+                const char *name,
+                const svn_string_t *value,
+                apr_pool_t *pool)
+{
+  return svn_error_trace(change_prop(op_change_dir_prop, dir_baton,
+                                     name, value));
+}
+
+static svn_error_t *
+close_directory(void *dir_baton,
+                apr_pool_t *pool)
+{
+  node_baton_t *node = dir_baton;
+
+  return svn_error_trace(queue_op(node->eb,
+                                  make_op(op_close_directory, node, NULL,
+                                          node->pool)));
+}
+
+/* Common implementation of absent_directory and absent_file. */
+static svn_error_t *
+absent_node(op_kind_t kind,
+            const char *path,
+            node_baton_t *parent)
+{
+  op_t *op = make_op(kind, NULL, parent, parent->pool);
+
+  op->path = apr_pstrdup(parent->pool, path);
+
+  return svn_error_trace(queue_op(parent->eb, op));
+}
+
+static svn_error_t *
+absent_directory(const char *path,
+                 void *parent_baton,
+                 apr_pool_t *pool)
+{
+  return svn_error_trace(absent_node(op_absent_directory, path,
+                                     parent_baton));
+}
+
+static svn_error_t *
+add_file(const char *path,
+         void *parent_baton,
+         const char *copyfrom_path,
+         svn_revnum_t copyfrom_revision,
+         apr_pool_t *file_pool,
+         void **file_baton)
+{
+  return svn_error_trace(open_node(op_add_file, path, parent_baton,
+                                   copyfrom_path, copyfrom_revision,
+                                   file_baton));
+}
+
+static svn_error_t *
+open_file(const char *path,
+          void *parent_baton,
+          svn_revnum_t base_revision,
+          apr_pool_t *file_pool,
+          void **file_baton)
+{
+  return svn_error_trace(open_node(op_open_file, path, parent_baton,
+                                   NULL, base_revision, file_baton));
+}
+
+static svn_error_t *
+apply_textdelta(void *file_baton,
+                const char *base_checksum,
+                apr_pool_t *pool,
+                svn_txdelta_window_handler_t *handler,
+                void **handler_baton)
+{
+  node_baton_t *node = file_baton;
+  op_t *op = make_op(op_apply_textdelta, node, NULL, node->pool);
+
+  op->checksum = apr_pstrdup(node->pool, base_checksum);
+  SVN_ERR(start_fetch(&op->job, node->eb, node->path, pool));
+
+  /* The server does not send any content. */
+  *handler = svn_delta_noop_window_handler;
+  *handler_baton = NULL;
+
+  return svn_error_trace(queue_op(node->eb, op));
+}
+
+static svn_error_t *
+change_file_prop(void *file_baton,
+                 const char *name,
+                 const svn_string_t *value,
+                 apr_pool_t *pool)
+{
+  return svn_error_trace(change_prop(op_change_file_prop, file_baton,
+                                     name, value));
+}
+
+static svn_error_t *
+close_file(void *file_baton,
+           const char *text_checksum,
+           apr_pool_t *pool)
+{
+  node_baton_t *node = file_baton;
+  op_t *op = make_op(op_close_file, node, NULL, node->pool);
+
+  op->checksum = apr_pstrdup(node->pool, text_checksum);
+
+  return svn_error_trace(queue_op(node->eb, op));
+}
+
+static svn_error_t *
+absent_file(const char *path,
+            void *parent_baton,
+            apr_pool_t *pool)
+{
+  return svn_error_trace(absent_node(op_absent_file, path, parent_baton));
+}
+
+static svn_error_t *
+close_edit(void *edit_baton,
+           apr_pool_t *pool)
+{
+  edit_baton_t *eb = edit_baton;
+
+  SVN_ERR(drain_queue(eb, 0));
+
+  return svn_error_trace(eb->wrapped_editor->close_edit(eb->wrapped_baton,
+                                                        pool));
+}
+
+static svn_error_t *
+abort_edit(void *edit_baton,
+           apr_pool_t *pool)
+{
+  edit_baton_t *eb = edit_baton;
+
+  return svn_error_trace(eb->wrapped_editor->abort_edit(eb->wrapped_baton,
+                                                        pool));
+}
+
+svn_error_t *
+svn_ra_svn__get_fetching_editor(const svn_delta_editor_t **editor,
+                                void **edit_baton,
+                                const svn_delta_editor_t *wrapped_editor,
+                                void *wrapped_baton,
+                                svn_ra_session_t *session,
+                                int max_connections,
+                                apr_pool_t *pool)
+{
+  svn_delta_editor_t *fetching_editor = svn_delta_default_editor(pool);
+  edit_baton_t *eb = apr_pcalloc(pool, sizeof(*eb));
+
+  SVN_ERR_ASSERT(max_connections > 1);
+
+  eb->wrapped_editor = wrapped_editor;
+  eb->wrapped_baton = wrapped_baton;
+  eb->session = session;
+  eb->target_revision = SVN_INVALID_REVNUM;
+  eb->max_workers = max_connections - 1;
+  eb->max_pending = PENDING_PER_WORKER * eb->max_workers;
+  eb->sessions_pool = svn_pool_create(pool);
+  eb->iterpool = svn_pool_create(pool);
+  eb->pool = pool;
+
+  apr_pool_pre_cleanup_register(pool, eb, fetch_cleanup);
+
+  fetching_editor->set_target_revision = set_target_revision;
+  fetching_editor->open_root = open_root;
+  fetching_editor->delete_entry = delete_entry;
+  fetching_editor->add_directory = add_directory;
+  fetching_editor->open_directory = open_directory;
+  fetching_editor->change_dir_prop = change_dir_prop;
+  fetching_editor->close_directory = close_directory;
+  fetching_editor->absent_directory = absent_directory;
+  fetching_editor->add_file = add_file;
+  fetching_editor->open_file = open_file;
+  fetching_editor->apply_textdelta = apply_textdelta;
+  fetching_editor->change_file_prop = change_file_prop;
+  fetching_editor->close_file = close_file;
+  fetching_editor->absent_file = absent_file;
+  fetching_editor->close_edit = close_edit;
+  fetching_editor->abort_edit = abort_edit;
+
+  *editor = fetching_editor;
+  *edit_baton = eb;
+
+  return SVN_NO_ERROR;
+}
+
+#endif /* APR_HAS_THREADS */
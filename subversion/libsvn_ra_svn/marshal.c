@@ -202,6 +202,7 @@ svn_ra_svn_conn_t *svn_ra_svn_create_conn5(apr_socket_t *sock,
   conn->session = NULL;
   conn->read_ptr = conn->read_buf;
   conn->read_end = conn->read_buf;
+  conn->read_inplace = FALSE;
   conn->write_pos = 0;
   conn->written_since_error_check = 0;
   conn->error_check_interval = error_check_interval;
@@ -363,29 +364,42 @@ check_io_limits(svn_ra_svn_conn_t *conn)
   return SVN_NO_ERROR;
 }
 
-/* Write data to socket or output file as appropriate. */
-static svn_error_t *writebuf_output(svn_ra_svn_conn_t *conn, apr_pool_t *pool,
-                                    const char *data, apr_size_t len)
+/* Write the NVEC buffers in VEC to socket or output file as appropriate.
+ * The contents of VEC will be modified. */
+static svn_error_t *writebuf_outputv(svn_ra_svn_conn_t *conn,
+                                     apr_pool_t *pool,
+                                     struct iovec *vec,
+                                     int nvec)
 {
-  const char *end = data + len;
+  apr_size_t len = 0;
   apr_size_t count;
+  int i;
   apr_pool_t *subpool = NULL;
   svn_ra_svn__session_baton_t *session = conn->session;
 
+  for (i = 0; i < nvec; ++i)
+    len += vec[i].iov_len;
+
   /* Limit the size of the response, if a limit has been configured.
    * This is to limit the server load in case users e.g. accidentally ran
    * an export on the root folder. */
   conn->current_out += len;
   SVN_ERR(check_io_limits(conn));
 
-  while (data < end)
+  while (nvec > 0)
     {
-      count = end - data;
+      /* Skip anything that has been sent already. */
+      if (vec->iov_len == 0)
+        {
+          ++vec;
+          --nvec;
+          continue;
+        }
 
       if (session && session->callbacks && session->callbacks->cancel_func)
         SVN_ERR((session->callbacks->cancel_func)(session->callbacks_baton));
 
-      SVN_ERR(svn_ra_svn__stream_write(conn->stream, data, &count));
+      SVN_ERR(svn_ra_svn__stream_writev(conn->stream, vec, nvec, &count));
       if (count == 0)
         {
           if (!subpool)
@@ -394,7 +408,6 @@ static svn_error_t *writebuf_output(svn_ra_svn_conn_t *conn, apr_pool_t *pool,
             svn_pool_clear(subpool);
           SVN_ERR(conn->block_handler(conn, subpool, conn->block_baton));
         }
-      data += count;
 
       if (session)
         {
@@ -405,6 +418,19 @@ static svn_error_t *writebuf_output(svn_ra_svn_conn_t *conn, apr_pool_t *pool,
             (cb->progress_func)(session->bytes_written + session->bytes_read,
                                 -1, cb->progress_baton, subpool);
         }
+
+      /* Advance past the data that has been written. */
+      for (; count > 0 && nvec > 0; ++vec, --nvec)
+        {
+          if (count < vec->iov_len)
+            {
+              vec->iov_base = (char *)vec->iov_base + count;
+              vec->iov_len -= count;
+              break;
+            }
+
+          count -= vec->iov_len;
+        }
     }
 
   conn->written_since_error_check += len;
@@ -416,6 +442,18 @@ static svn_error_t *writebuf_output(svn_ra_svn_conn_t *conn, apr_pool_t *pool,
   return SVN_NO_ERROR;
 }
 
+/* Write data to socket or output file as appropriate. */
+static svn_error_t *writebuf_output(svn_ra_svn_conn_t *conn, apr_pool_t *pool,
+                                    const char *data, apr_size_t len)
+{
+  struct iovec vec;
+
+  vec.iov_base = (void *)data;
+  vec.iov_len = len;
+
+  return svn_error_trace(writebuf_outputv(conn, pool, &vec, 1));
+}
+
 /* Write data from the write buffer out to the socket. */
 static svn_error_t *writebuf_flush(svn_ra_svn_conn_t *conn, apr_pool_t *pool)
 {
@@ -430,13 +468,20 @@ static svn_error_t *writebuf_flush(svn_ra_svn_conn_t *conn, apr_pool_t *pool)
 static svn_error_t *writebuf_write(svn_ra_svn_conn_t *conn, apr_pool_t *pool,
                                    const char *data, apr_size_t len)
 {
-  /* data >= 8k is sent immediately */
+  /* data >= 8k is sent immediately, together with whatever is still
+     in the buffer, using a single gathering write. */
   if (len >= sizeof(conn->write_buf) / 2)
     {
-      if (conn->write_pos > 0)
-        SVN_ERR(writebuf_flush(conn, pool));
+      struct iovec vec[2];
 
-      return writebuf_output(conn, pool, data, len);
+      vec[0].iov_base = conn->write_buf;
+      vec[0].iov_len = conn->write_pos;
+      vec[1].iov_base = (void *)data;
+      vec[1].iov_len = len;
+
+      /* Clear conn->write_pos first in case the block handler does a read. */
+      conn->write_pos = 0;
+      return svn_error_trace(writebuf_outputv(conn, pool, vec, 2));
     }
 
   /* ensure room for the data to add */
@@ -1331,8 +1376,24 @@ static svn_error_t *read_item(svn_ra_svn_conn_t *conn, apr_pool_t *pool,
       if (c == ':')
         {
           /* It's a string. */
-          SVN_ERR(read_string(conn, pool, item, val));
-          SVN_ERR(readbuf_getchar(conn, pool, &c));
+          if (   conn->read_inplace
+              && val < (apr_uint64_t)(conn->read_end - conn->read_ptr))
+            {
+              /* The string and its separator are in the read buffer.
+               * Reference the string in place and replace the separator
+               * with the terminating NUL. */
+              item->kind = SVN_RA_SVN_STRING;
+              item->u.string.data = conn->read_ptr;
+              item->u.string.len = (apr_size_t)val;
+              conn->read_ptr += val;
+              c = *conn->read_ptr;
+              *conn->read_ptr++ = '\0';
+            }
+          else
+            {
+              SVN_ERR(read_string(conn, pool, item, val));
+              SVN_ERR(readbuf_getchar(conn, pool, &c));
+            }
         }
       else
         {
@@ -1749,6 +1810,93 @@ svn_ra_svn__read_tuple(svn_ra_svn_conn_t *conn,
   return err;
 }
 
+/* Return TRUE if the read buffer of CONN contains the remainder of a
+ * list, whose opening parenthesis has already been read, including the
+ * whitespace following its closing parenthesis.  Reading that list will
+ * then not require the read buffer to be refilled.  Return FALSE if the
+ * data is incomplete or malformed. */
+static svn_boolean_t
+list_is_buffered(svn_ra_svn_conn_t *conn)
+{
+  const char *p = conn->read_ptr;
+  const char *end = conn->read_end;
+  int level = 1;
+
+  while (p < end)
+    {
+      char c = *p;
+      if (svn_iswhitespace(c) || svn_ctype_isalpha(c) || c == '-')
+        {
+          ++p;
+        }
+      else if (c == '(')
+        {
+          ++level;
+          ++p;
+        }
+      else if (c == ')')
+        {
+          if (--level == 0)
+            return p + 1 < end;
+          ++p;
+        }
+      else if (svn_ctype_isdigit(c))
+        {
+          apr_uint64_t val = 0;
+          while (p < end && svn_ctype_isdigit(*p))
+            {
+              if (val >= APR_UINT64_MAX / 10)
+                return FALSE;
+              val = val * 10 + (*p - '0');
+              ++p;
+            }
+
+          /* Skip string contents. */
+          if (p < end && *p == ':')
+            {
+              ++p;
+              if (val >= (apr_uint64_t)(end - p))
+                return FALSE;
+              p += val;
+            }
+        }
+      else
+        {
+          return FALSE;
+        }
+    }
+
+  return FALSE;
+}
+
+svn_error_t *
+svn_ra_svn__read_tuple_transient(svn_ra_svn_conn_t *conn,
+                                 apr_pool_t *pool,
+                                 const char *fmt, ...)
+{
+  va_list ap;
+  svn_ra_svn__item_t *item;
+  svn_error_t *err;
+  char c;
+
+  /* Strings may only reference the read buffer if reading the tuple does
+   * not cause it to be refilled. */
+  item = apr_palloc(pool, sizeof(*item));
+  SVN_ERR(readbuf_getchar_skip_whitespace(conn, pool, &c));
+  conn->read_inplace = (c == '(') && list_is_buffered(conn);
+  err = read_item(conn, pool, item, c, 0);
+  conn->read_inplace = FALSE;
+  SVN_ERR(err);
+
+  if (item->kind != SVN_RA_SVN_LIST)
+    return svn_error_create(SVN_ERR_RA_SVN_MALFORMED_DATA, NULL,
+                            _("Malformed network data"));
+  va_start(ap, fmt);
+  err = vparse_tuple(&item->u.list, &fmt, &ap);
+  va_end(ap);
+  return err;
+}
+
 svn_error_t *
 svn_ra_svn__read_command_only(svn_ra_svn_conn_t *conn,
                               apr_pool_t *pool,
@@ -2463,7 +2611,8 @@ svn_ra_svn__write_cmd_update(svn_ra_svn_conn_t *conn,
                              svn_boolean_t recurse,
                              svn_depth_t depth,
                              svn_boolean_t send_copyfrom_args,
-                             svn_boolean_t ignore_ancestry)
+                             svn_boolean_t ignore_ancestry,
+                             svn_boolean_t text_deltas)
 {
   SVN_ERR(writebuf_write_literal(conn, pool, "( update ( "));
   SVN_ERR(write_tuple_start_list(conn, pool));
@@ -2474,6 +2623,7 @@ svn_ra_svn__write_cmd_update(svn_ra_svn_conn_t *conn,
   SVN_ERR(write_tuple_depth(conn, pool, depth));
   SVN_ERR(write_tuple_boolean(conn, pool, send_copyfrom_args));
   SVN_ERR(write_tuple_boolean(conn, pool, ignore_ancestry));
+  SVN_ERR(write_tuple_boolean(conn, pool, text_deltas));
   SVN_ERR(writebuf_write_literal(conn, pool, ") ) "));
 
   return SVN_NO_ERROR;
@@ -67,6 +67,9 @@ typedef svn_error_t *(*ra_svn_block_handler_t)(svn_ra_svn_conn_t *conn,
 #define SVN_RA_SVN__READBUF_SIZE (4 * SVN_RA_SVN__PAGE_SIZE)
 #define SVN_RA_SVN__WRITEBUF_SIZE (4 * SVN_RA_SVN__PAGE_SIZE)
 
+/* Upper limit for the svn-max-connections configuration value. */
+#define SVN_RA_SVN__MAX_CONNECTIONS 8
+
 /* Create forward reference */
 typedef struct svn_ra_svn__session_baton_t svn_ra_svn__session_baton_t;
 
@@ -81,6 +84,10 @@ struct svn_ra_svn_conn_st {
   char *read_end;
   apr_size_t write_pos;
 
+  /* If set, strings found completely within READ_BUF are not copied but
+   * referenced in place.  See svn_ra_svn__read_tuple_transient(). */
+  svn_boolean_t read_inplace;
+
   svn_ra_svn__stream_t *stream;
   svn_ra_svn__session_baton_t *session;
 #ifdef SVN_HAVE_SASL
@@ -150,6 +157,8 @@ struct svn_ra_svn__session_baton_t {
   svn_auth_baton_t *auth_baton;
   svn_ra_svn__parent_t *parent;
   const char *user;
+  svn_boolean_t authenticated; /* The server knows who we are and will not
+                                  ask us to authenticate again. */
   const char *hostname; /* The remote hostname. */
   const char *realm_prefix;
   const char *tunnel_name;
@@ -160,6 +169,8 @@ struct svn_ra_svn__session_baton_t {
   apr_off_t bytes_read, bytes_written; /* apr_off_t's because that's what
                                           the callback interface uses */
   const char *useragent;
+  int max_connections; /* Upper limit for connections used by an update,
+                          including this one.  See svn-max-connections. */
 };
 
 /* Set a callback for blocked writes on conn.  This handler may
@@ -222,6 +233,16 @@ svn_ra_svn__stream_t *svn_ra_svn__stream_create(svn_stream_t *in_stream,
 svn_error_t *svn_ra_svn__stream_write(svn_ra_svn__stream_t *stream,
                                       const char *data, apr_size_t *len);
 
+/* Write the NVEC buffers in VEC to STREAM, in order, returning the total
+ * number of bytes written in *LEN.  Socket streams send all buffers with a
+ * single system call; other streams may write less than the total.
+ */
+svn_error_t *
+svn_ra_svn__stream_writev(svn_ra_svn__stream_t *stream,
+                          const struct iovec *vec,
+                          int nvec,
+                          apr_size_t *len);
+
 /* Read *LEN bytes from STREAM into DATA, returning the number of bytes
  * read in *LEN.
  */
@@ -275,6 +296,57 @@ svn_boolean_t svn_ra_svn__find_mech(const svn_ra_svn__list_t *mechlist,
 /* Initialize the SASL library. */
 svn_error_t *svn_ra_svn__sasl_init(void);
 
+/* Perform the client side of a TLS handshake with HOSTNAME:PORT on the
+ * freshly created connection CONN of SESS and encrypt all further traffic
+ * on it.  Resume an earlier TLS session with the same server if possible.
+ *
+ * AUTHORITIES is a ';' separated list of CA certificate files to trust
+ * in addition to the system's default CAs, or NULL.  The latter are only
+ * trusted if TRUST_DEFAULT_CA is set.  Certificates that fail validation
+ * are presented to the SVN_AUTH_CRED_SSL_SERVER_TRUST providers of SESS.
+ * Use SCRATCH_POOL for temporaries.
+ */
+svn_error_t *
+svn_ra_svn__tls_connect(svn_ra_svn_conn_t *conn,
+                        svn_ra_svn__session_baton_t *sess,
+                        const char *hostname,
+                        int port,
+                        const char *authorities,
+                        svn_boolean_t trust_default_ca,
+                        apr_pool_t *scratch_pool);
+
+/* Open another session to the URL of SESSION, using the same callbacks,
+ * credentials and configuration, and return it in *FETCH_SESSION.  The
+ * new session does not report progress, so that it may be used from a
+ * worker thread.  Allocate it in RESULT_POOL.
+ */
+svn_error_t *
+svn_ra_svn__open_fetch_session(svn_ra_session_t **fetch_session,
+                               svn_ra_session_t *session,
+                               apr_pool_t *result_pool,
+                               apr_pool_t *scratch_pool);
+
+#if APR_HAS_THREADS
+/* Return in *EDITOR and *EDIT_BATON an editor that forwards a skelta
+ * update drive to WRAPPED_EDITOR / WRAPPED_BATON, fetching the contents
+ * of every file for which it receives apply_textdelta through up to
+ * MAX_CONNECTIONS - 1 additional sessions to the URL of SESSION.
+ * Those fetches run on worker threads while the drive continues; the
+ * wrapped editor still sees all calls in their original order, with the
+ * file contents sent as deltas against the empty stream.
+ *
+ * Allocate the editor in POOL.  The workers stop when POOL gets cleaned up.
+ */
+svn_error_t *
+svn_ra_svn__get_fetching_editor(const svn_delta_editor_t **editor,
+                                void **edit_baton,
+                                const svn_delta_editor_t *wrapped_editor,
+                                void *wrapped_baton,
+                                svn_ra_session_t *session,
+                                int max_connections,
+                                apr_pool_t *pool);
+#endif
+
 
 #ifdef __cplusplus
 }
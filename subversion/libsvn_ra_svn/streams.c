@@ -42,6 +42,9 @@ struct svn_ra_svn__stream_st {
   svn_stream_t *out_stream;
   void *timeout_baton;
   ra_svn_timeout_fn_t timeout_fn;
+
+  /* The socket that OUT_STREAM writes to unmodified, if any. */
+  apr_socket_t *sock;
 };
 
 typedef struct sock_baton_t {
@@ -167,6 +170,7 @@ svn_ra_svn__stream_from_sock(apr_socket_t *sock,
 {
   sock_baton_t *b = apr_palloc(result_pool, sizeof(*b));
   svn_stream_t *sock_stream;
+  svn_ra_svn__stream_t *s;
 
   b->sock = sock;
   b->pool = svn_pool_create(result_pool);
@@ -177,8 +181,11 @@ svn_ra_svn__stream_from_sock(apr_socket_t *sock,
   svn_stream_set_write(sock_stream, sock_write_cb);
   svn_stream_set_data_available(sock_stream, sock_pending_cb);
 
-  return svn_ra_svn__stream_create(sock_stream, sock_stream,
-                                   b, sock_timeout_cb, result_pool);
+  s = svn_ra_svn__stream_create(sock_stream, sock_stream,
+                                b, sock_timeout_cb, result_pool);
+  s->sock = sock;
+
+  return s;
 }
 
 svn_ra_svn__stream_t *
@@ -193,6 +200,7 @@ svn_ra_svn__stream_create(svn_stream_t *in_stream,
   s->out_stream = out_stream;
   s->timeout_baton = timeout_baton;
   s->timeout_fn = timeout_cb;
+  s->sock = NULL;
   return s;
 }
 
@@ -203,6 +211,41 @@ svn_ra_svn__stream_write(svn_ra_svn__stream_t *stream,
   return svn_error_trace(svn_stream_write(stream->out_stream, data, len));
 }
 
+svn_error_t *
+svn_ra_svn__stream_writev(svn_ra_svn__stream_t *stream,
+                          const struct iovec *vec,
+                          int nvec,
+                          apr_size_t *len)
+{
+  if (stream->sock)
+    {
+      apr_status_t status = apr_socket_sendv(stream->sock, vec, nvec, len);
+      if (status)
+        return svn_error_wrap_apr(status, _("Can't write to connection"));
+
+      return SVN_NO_ERROR;
+    }
+
+  /* Generic streams can't gather.  Write the first non-empty vector and
+     let the caller come back for the rest. */
+  while (nvec > 0 && vec->iov_len == 0)
+    {
+      ++vec;
+      --nvec;
+    }
+
+  if (nvec == 0)
+    {
+      *len = 0;
+      return SVN_NO_ERROR;
+    }
+
+  *len = vec->iov_len;
+  return svn_error_trace(svn_stream_write(stream->out_stream,
+                                          (const char *)vec->iov_base,
+                                          len));
+}
+
 svn_error_t *
 svn_ra_svn__stream_read(svn_ra_svn__stream_t *stream, char *data,
                         apr_size_t *len)
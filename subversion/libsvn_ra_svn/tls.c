@@ -0,0 +1,1020 @@
+/*
+ * tls.c :  TLS transport layer for ra_svn connections, based on OpenSSL
+ *
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ */
+
+#include "svn_private_config.h"
+
+#define APR_WANT_STRFUNC
+#include <apr_want.h>
+#include <apr_general.h>
+#include <apr_strings.h>
+
+#include "svn_types.h"
+#include "svn_string.h"
+#include "svn_error.h"
+#include "svn_pools.h"
+#include "svn_ra.h"
+#include "svn_ra_svn.h"
+
+#include "ra_svn.h"
+
+#ifdef SVN_HAVE_OPENSSL
+
+#include <limits.h>
+
+#include <openssl/bio.h>
+#include <openssl/err.h>
+#include <openssl/ssl.h>
+#include <openssl/x509v3.h>
+
+#include "svn_hash.h"
+#include "svn_auth.h"
+#include "svn_base64.h"
+#include "svn_dirent_uri.h"
+#include "svn_utf.h"
+
+#include "private/svn_atomic.h"
+#include "private/svn_mutex.h"
+#include "private/svn_subr_private.h"
+
+/* Process-wide TLS state.  It is set up once by init_tls() and released
+   along with SESSION_POOL when APR terminates. */
+
+/* BIO method that passes TLS records through an svn_ra_svn__stream_t. */
+static BIO_METHOD *stream_bio_method = NULL;
+
+/* Index of the tls_baton_t in the ex_data of our SSL objects. */
+static int baton_index = -1;
+
+/* Client context shared by all client connections, so that a session
+   negotiated by one connection can be resumed by the next one. */
+static SSL_CTX *client_ctx = NULL;
+
+/* Resumable client sessions (SSL_SESSION *) whose server certificate
+   has been accepted, keyed by server and trust settings.  Keys are
+   allocated in SESSION_POOL and access is serialized by SESSION_MUTEX. */
+static apr_hash_t *client_sessions = NULL;
+static apr_pool_t *session_pool = NULL;
+static svn_mutex__t *session_mutex = NULL;
+
+/* Init flag for the state above. */
+static volatile svn_atomic_t tls_init_state = 0;
+
+struct svn_ra_svn__tls_server_t
+{
+  SSL_CTX *ctx;
+};
+
+/* Per-connection TLS state. */
+typedef struct tls_baton_t
+{
+  /* The stream that the encrypted data travels through. */
+  svn_ra_svn__stream_t *stream;
+
+  /* The TLS connection object. */
+  SSL *ssl;
+
+  /* An error raised by STREAM within a BIO callback.  It will be
+     returned by the function that called into OpenSSL. */
+  svn_error_t *error;
+
+  /* Client only: key of this connection in CLIENT_SESSIONS. */
+  const char *session_key;
+
+  /* Client only: SVN_AUTH_SSL_* flags for the certificate verification
+     failures reported during the handshake. */
+  apr_uint32_t failures;
+
+  /* Client only: set once the server certificate has been accepted.
+     Until then, new sessions are kept in PENDING_SESSION instead of
+     CLIENT_SESSIONS, so that no other connection can skip the check by
+     resuming them. */
+  svn_boolean_t verified;
+  SSL_SESSION *pending_session;
+} tls_baton_t;
+
+/* Return an error for the OpenSSL function that failed with RESULT on
+   the connection described by B.  MESSAGE describes the operation. */
+static svn_error_t *
+tls_error(tls_baton_t *b,
+          int result,
+          const char *message)
+{
+  svn_error_t *err = b->error;
+  int ssl_error = SSL_get_error(b->ssl, result);
+  unsigned long code = ERR_get_error();
+
+  ERR_clear_error();
+  b->error = SVN_NO_ERROR;
+  if (err)
+    return svn_error_quick_wrap(err, message);
+
+  if (code)
+    {
+      char buffer[256];
+      ERR_error_string_n(code, buffer, sizeof(buffer));
+      return svn_error_createf(SVN_ERR_RA_SVN_IO_ERROR, NULL, "%s: %s",
+                               message, buffer);
+    }
+
+  return svn_error_createf(SVN_ERR_RA_SVN_IO_ERROR, NULL,
+                           _("%s: TLS error %d"), message, ssl_error);
+}
+
+/* Return an error for a failed OpenSSL library call that is not related
+   to a specific connection.  MESSAGE describes the operation. */
+static svn_error_t *
+openssl_error(apr_status_t apr_err,
+              const char *message)
+{
+  unsigned long code = ERR_get_error();
+  char buffer[256];
+
+  ERR_clear_error();
+  if (!code)
+    return svn_error_create(apr_err, NULL, message);
+
+  ERR_error_string_n(code, buffer, sizeof(buffer));
+  return svn_error_createf(apr_err, NULL, "%s: %s", message, buffer);
+}
+
+/* BIO methods forwarding to tls_baton_t.STREAM. */
+
+static int
+stream_bio_write(BIO *bio,
+                 const char *data,
+                 int len)
+{
+  tls_baton_t *b = BIO_get_data(bio);
+  apr_size_t count = len;
+
+  BIO_clear_retry_flags(bio);
+  if (b->error)
+    return -1;
+
+  b->error = svn_ra_svn__stream_write(b->stream, data, &count);
+  if (b->error)
+    return -1;
+
+  /* A non-blocking write that could not make any progress. */
+  if (count == 0)
+    {
+      BIO_set_retry_write(bio);
+      return -1;
+    }
+
+  return (int)count;
+}
+
+static int
+stream_bio_read(BIO *bio,
+                char *data,
+                int len)
+{
+  tls_baton_t *b = BIO_get_data(bio);
+  apr_size_t count = len;
+
+  BIO_clear_retry_flags(bio);
+  if (b->error)
+    return -1;
+
+  b->error = svn_ra_svn__stream_read(b->stream, data, &count);
+  if (b->error)
+    return -1;
+
+  return (int)count;
+}
+
+static long
+stream_bio_ctrl(BIO *bio,
+                int cmd,
+                long num,
+                void *ptr)
+{
+  /* We don't buffer, so there is never anything to flush. */
+  return cmd == BIO_CTRL_FLUSH ? 1 : 0;
+}
+
+static int
+stream_bio_create(BIO *bio)
+{
+  BIO_set_init(bio, 1);
+  return 1;
+}
+
+static int
+stream_bio_destroy(BIO *bio)
+{
+  return 1;
+}
+
+/* Return the SVN_AUTH_SSL_* flag for the X509_V_ERR_* code ERROR. */
+static apr_uint32_t
+verify_error_to_failure(long error)
+{
+  switch (error)
+    {
+      case X509_V_OK:
+        return 0;
+
+      case X509_V_ERR_CERT_NOT_YET_VALID:
+        return SVN_AUTH_SSL_NOTYETVALID;
+
+      case X509_V_ERR_CERT_HAS_EXPIRED:
+        return SVN_AUTH_SSL_EXPIRED;
+
+      case X509_V_ERR_DEPTH_ZERO_SELF_SIGNED_CERT:
+      case X509_V_ERR_SELF_SIGNED_CERT_IN_CHAIN:
+      case X509_V_ERR_UNABLE_TO_GET_ISSUER_CERT:
+      case X509_V_ERR_UNABLE_TO_GET_ISSUER_CERT_LOCALLY:
+      case X509_V_ERR_UNABLE_TO_VERIFY_LEAF_SIGNATURE:
+      case X509_V_ERR_CERT_UNTRUSTED:
+        return SVN_AUTH_SSL_UNKNOWNCA;
+
+      default:
+        return SVN_AUTH_SSL_OTHER;
+    }
+}
+
+/* Implements SSL_verify_cb for client connections.  Record all failures
+   in the connection's baton and let the handshake complete.  Whether the
+   certificate will be accepted is decided afterwards. */
+static int
+verify_cb(int preverify_ok,
+          X509_STORE_CTX *store_ctx)
+{
+  SSL *ssl = X509_STORE_CTX_get_ex_data(store_ctx,
+                                        SSL_get_ex_data_X509_STORE_CTX_idx());
+  tls_baton_t *b = SSL_get_ex_data(ssl, baton_index);
+
+  if (!preverify_ok)
+    b->failures
+      |= verify_error_to_failure(X509_STORE_CTX_get_error(store_ctx));
+
+  return 1;
+}
+
+/* Make SESSION the one to resume for the server of B, taking over the
+   reference to it.  SESSION_MUTEX must be held. */
+static void
+cache_session(tls_baton_t *b,
+              SSL_SESSION *session)
+{
+  /* Updating an existing entry keeps the original key. */
+  SSL_SESSION *old_session = svn_hash_gets(client_sessions, b->session_key);
+  if (old_session)
+    {
+      SSL_SESSION_free(old_session);
+      svn_hash_sets(client_sessions, b->session_key, session);
+    }
+  else
+    {
+      svn_hash_sets(client_sessions,
+                    apr_pstrdup(session_pool, b->session_key), session);
+    }
+}
+
+/* Make the session that the connection B received during the handshake
+   the one to resume for its server.  SESSION_MUTEX must be held. */
+static svn_error_t *
+cache_pending_session(tls_baton_t *b)
+{
+  if (b->pending_session)
+    {
+      cache_session(b, b->pending_session);
+      b->pending_session = NULL;
+    }
+
+  return SVN_NO_ERROR;
+}
+
+/* Forget any session to resume for the server of B.  SESSION_MUTEX must
+   be held. */
+static svn_error_t *
+uncache_session(tls_baton_t *b)
+{
+  SSL_SESSION *session = svn_hash_gets(client_sessions, b->session_key);
+  if (session)
+    {
+      SSL_SESSION_free(session);
+      svn_hash_sets(client_sessions, b->session_key, NULL);
+    }
+
+  return SVN_NO_ERROR;
+}
+
+/* Called by OpenSSL whenever a client connection receives a new session
+   that may be resumed later.  Make it the one to use for the connection's
+   server once the server's certificate has been accepted.  Return 1 if we
+   took over the reference to SESSION. */
+static int
+new_session_cb(SSL *ssl,
+               SSL_SESSION *session)
+{
+  tls_baton_t *b = SSL_get_ex_data(ssl, baton_index);
+  svn_error_t *err;
+
+  if (!b || !b->session_key)
+    return 0;
+
+  /* With TLS 1.2, this gets called during the handshake, i.e. before
+     check_server_cert() had a chance to reject the certificate. */
+  if (!b->verified)
+    {
+      if (b->pending_session)
+        SSL_SESSION_free(b->pending_session);
+      b->pending_session = session;
+      return 1;
+    }
+
+  err = svn_mutex__lock(session_mutex);
+  if (err)
+    {
+      svn_error_clear(err);
+      return 0;
+    }
+
+  cache_session(b, session);
+
+  svn_error_clear(svn_mutex__unlock(session_mutex, SVN_NO_ERROR));
+  return 1;
+}
+
+/* Pool cleanup function releasing the process-wide TLS state.  DATA is
+   not used. */
+static apr_status_t
+cleanup_tls_state(void *data)
+{
+  apr_hash_index_t *hi;
+
+  for (hi = apr_hash_first(NULL, client_sessions); hi; hi = apr_hash_next(hi))
+    SSL_SESSION_free(apr_hash_this_val(hi));
+  client_sessions = NULL;
+
+  SSL_CTX_free(client_ctx);
+  client_ctx = NULL;
+
+  BIO_meth_free(stream_bio_method);
+  stream_bio_method = NULL;
+
+  return APR_SUCCESS;
+}
+
+/* svn_atomic__init_once callback setting up the process-wide TLS state.
+   BATON and POOL are not used. */
+static svn_error_t *
+init_tls(void *baton,
+         apr_pool_t *pool)
+{
+  if (!OPENSSL_init_ssl(OPENSSL_INIT_LOAD_SSL_STRINGS
+                        | OPENSSL_INIT_LOAD_CRYPTO_STRINGS, NULL))
+    return openssl_error(SVN_ERR_RA_SVN_IO_ERROR,
+                         _("Can't initialize OpenSSL"));
+
+  stream_bio_method = BIO_meth_new(BIO_get_new_index() | BIO_TYPE_SOURCE_SINK,
+                                   "svn_ra_svn stream");
+  if (!stream_bio_method)
+    return openssl_error(SVN_ERR_RA_SVN_IO_ERROR,
+                         _("Can't initialize OpenSSL"));
+
+  BIO_meth_set_write(stream_bio_method, stream_bio_write);
+  BIO_meth_set_read(stream_bio_method, stream_bio_read);
+  BIO_meth_set_ctrl(stream_bio_method, stream_bio_ctrl);
+  BIO_meth_set_create(stream_bio_method, stream_bio_create);
+  BIO_meth_set_destroy(stream_bio_method, stream_bio_destroy);
+
+  baton_index = SSL_get_ex_new_index(0, NULL, NULL, NULL, NULL);
+
+  /* The session cache outlives any caller-provided pool. */
+  session_pool = svn_pool_create(NULL);
+  client_sessions = svn_hash__make(session_pool);
+  SVN_ERR(svn_mutex__init(&session_mutex, TRUE, session_pool));
+  apr_pool_cleanup_register(session_pool, NULL, cleanup_tls_state,
+                            apr_pool_cleanup_null);
+
+  client_ctx = SSL_CTX_new(TLS_client_method());
+  if (!client_ctx)
+    return openssl_error(SVN_ERR_RA_SVN_IO_ERROR,
+                         _("Can't create TLS context"));
+
+  SSL_CTX_set_min_proto_version(client_ctx, TLS1_2_VERSION);
+  SSL_CTX_set_mode(client_ctx, SSL_MODE_ENABLE_PARTIAL_WRITE
+                               | SSL_MODE_ACCEPT_MOVING_WRITE_BUFFER);
+  SSL_CTX_set_default_verify_paths(client_ctx);
+  SSL_CTX_set_verify(client_ctx, SSL_VERIFY_PEER, verify_cb);
+  SSL_CTX_set_session_cache_mode(client_ctx,
+                                 SSL_SESS_CACHE_CLIENT
+                                 | SSL_SESS_CACHE_NO_INTERNAL_STORE);
+  SSL_CTX_sess_set_new_cb(client_ctx, new_session_cb);
+
+  return SVN_NO_ERROR;
+}
+
+/* Functions to implement a TLS encrypted svn_ra_svn__stream_t. */
+
+/* Implements svn_read_fn_t. */
+static svn_error_t *
+tls_read_cb(void *baton,
+            char *buffer,
+            apr_size_t *len)
+{
+  tls_baton_t *b = baton;
+  int result = SSL_read(b->ssl, buffer, *len > INT_MAX ? INT_MAX : (int)*len);
+
+  if (result > 0)
+    {
+      *len = result;
+      return SVN_NO_ERROR;
+    }
+
+  /* Orderly shutdown by the peer. */
+  if (SSL_get_error(b->ssl, result) == SSL_ERROR_ZERO_RETURN)
+    {
+      *len = 0;
+      return SVN_NO_ERROR;
+    }
+
+  return svn_error_trace(tls_error(b, result,
+                                   _("Can't read from connection")));
+}
+
+/* Implements svn_write_fn_t. */
+static svn_error_t *
+tls_write_cb(void *baton,
+             const char *buffer,
+             apr_size_t *len)
+{
+  tls_baton_t *b = baton;
+  int result = SSL_write(b->ssl, buffer,
+                         *len > INT_MAX ? INT_MAX : (int)*len);
+
+  if (result > 0)
+    {
+      *len = result;
+      return SVN_NO_ERROR;
+    }
+
+  /* The underlying stream would block.  OpenSSL expects us to retry
+     with the same data, which is what the caller will do. */
+  if (!b->error && SSL_get_error(b->ssl, result) == SSL_ERROR_WANT_WRITE)
+    {
+      *len = 0;
+      return SVN_NO_ERROR;
+    }
+
+  return svn_error_trace(tls_error(b, result,
+                                   _("Can't write to connection")));
+}
+
+/* Implements ra_svn_timeout_fn_t. */
+static void
+tls_timeout_cb(void *baton,
+               apr_interval_time_t interval)
+{
+  tls_baton_t *b = baton;
+  svn_ra_svn__stream_timeout(b->stream, interval);
+}
+
+/* Implements svn_stream_data_available_fn_t. */
+static svn_error_t *
+tls_data_available_cb(void *baton,
+                      svn_boolean_t *data_available)
+{
+  tls_baton_t *b = baton;
+
+  /* Decrypted data may already be waiting inside OpenSSL. */
+  if (SSL_pending(b->ssl) > 0)
+    {
+      *data_available = TRUE;
+      return SVN_NO_ERROR;
+    }
+
+  return svn_error_trace(svn_ra_svn__stream_data_available(b->stream,
+                                                           data_available));
+}
+
+/* Pool cleanup function releasing the OpenSSL objects of the
+   tls_baton_t DATA. */
+static apr_status_t
+cleanup_ssl(void *data)
+{
+  tls_baton_t *b = data;
+
+  if (b->pending_session)
+    SSL_SESSION_free(b->pending_session);
+  SSL_free(b->ssl);
+
+  return APR_SUCCESS;
+}
+
+/* Return a new TLS baton in *B for CONN, using context CTX.  The
+   encrypted data will pass through the current stream of CONN. */
+static svn_error_t *
+create_tls_baton(tls_baton_t **b,
+                 svn_ra_svn_conn_t *conn,
+                 SSL_CTX *ctx)
+{
+  BIO *bio;
+
+  /* Any data that has been exchanged in plain text would get lost. */
+  SVN_ERR_ASSERT(conn->read_ptr == conn->read_end && conn->write_pos == 0);
+
+  *b = apr_pcalloc(conn->pool, sizeof(**b));
+  (*b)->stream = conn->stream;
+
+  (*b)->ssl = SSL_new(ctx);
+  if (!(*b)->ssl)
+    return openssl_error(SVN_ERR_RA_SVN_IO_ERROR,
+                         _("Can't create TLS connection"));
+  apr_pool_cleanup_register(conn->pool, *b, cleanup_ssl,
+                            apr_pool_cleanup_null);
+
+  /* SSL_free() will release BIO as well. */
+  bio = BIO_new(stream_bio_method);
+  if (!bio)
+    return openssl_error(SVN_ERR_RA_SVN_IO_ERROR,
+                         _("Can't create TLS connection"));
+  BIO_set_data(bio, *b);
+  SSL_set_bio((*b)->ssl, bio, bio);
+  SSL_set_ex_data((*b)->ssl, baton_index, *b);
+
+  return SVN_NO_ERROR;
+}
+
+/* Make all further traffic on CONN go through the TLS connection B. */
+static void
+install_tls_stream(svn_ra_svn_conn_t *conn,
+                   tls_baton_t *b)
+{
+  svn_stream_t *tls_in = svn_stream_create(b, conn->pool);
+  svn_stream_t *tls_out = svn_stream_create(b, conn->pool);
+
+  svn_stream_set_read2(tls_in, tls_read_cb, NULL /* use default */);
+  svn_stream_set_data_available(tls_in, tls_data_available_cb);
+  svn_stream_set_write(tls_out, tls_write_cb);
+
+  conn->stream = svn_ra_svn__stream_create(tls_in, tls_out, b,
+                                           tls_timeout_cb, conn->pool);
+}
+
+svn_error_t *
+svn_ra_svn__tls_server_create(svn_ra_svn__tls_server_t **server,
+                              const char *cert_file,
+                              const char *key_file,
+                              apr_pool_t *result_pool)
+{
+  svn_ra_svn__tls_server_t *result;
+  const char *cert_file_native;
+  const char *key_file_native;
+
+  SVN_ERR(svn_atomic__init_once(&tls_init_state, init_tls, NULL,
+                                result_pool));
+  SVN_ERR(svn_utf_cstring_from_utf8(&cert_file_native,
+                                    svn_dirent_local_style(cert_file,
+                                                           result_pool),
+                                    result_pool));
+  SVN_ERR(svn_utf_cstring_from_utf8(&key_file_native,
+                                    svn_dirent_local_style(key_file,
+                                                           result_pool),
+                                    result_pool));
+
+  result = apr_pcalloc(result_pool, sizeof(*result));
+  result->ctx = SSL_CTX_new(TLS_server_method());
+  if (!result->ctx)
+    return openssl_error(SVN_ERR_RA_SVN_IO_ERROR,
+                         _("Can't create TLS context"));
+  apr_pool_cleanup_register(result_pool, result->ctx,
+                            (apr_status_t (*)(void *))SSL_CTX_free,
+                            apr_pool_cleanup_null);
+
+  SSL_CTX_set_min_proto_version(result->ctx, TLS1_2_VERSION);
+  SSL_CTX_set_mode(result->ctx, SSL_MODE_ENABLE_PARTIAL_WRITE
+                                | SSL_MODE_ACCEPT_MOVING_WRITE_BUFFER);
+
+  if (SSL_CTX_use_certificate_chain_file(result->ctx,
+                                         cert_file_native) != 1)
+    return openssl_error(SVN_ERR_BAD_CONFIG_VALUE,
+                         apr_psprintf(result_pool,
+                                      _("Can't load TLS certificate '%s'"),
+                                      svn_dirent_local_style(cert_file,
+                                                             result_pool)));
+
+  if (SSL_CTX_use_PrivateKey_file(result->ctx, key_file_native,
+                                  SSL_FILETYPE_PEM) != 1
+      || SSL_CTX_check_private_key(result->ctx) != 1)
+    return openssl_error(SVN_ERR_BAD_CONFIG_VALUE,
+                         apr_psprintf(result_pool,
+                                      _("Can't load TLS private key '%s'"),
+                                      svn_dirent_local_style(key_file,
+                                                             result_pool)));
+
+  /* Session tickets are enabled by default.  Their keys get created
+     along with the context, i.e. before svnserve forks any connection
+     handlers, so every process will accept every other one's tickets. */
+  SSL_CTX_set_session_id_context(result->ctx,
+                                 (const unsigned char *)"svnserve", 8);
+  SSL_CTX_set_session_cache_mode(result->ctx, SSL_SESS_CACHE_SERVER);
+
+  *server = result;
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_ra_svn__tls_accept(svn_ra_svn_conn_t *conn,
+                       svn_ra_svn__tls_server_t *server,
+                       apr_pool_t *scratch_pool)
+{
+  tls_baton_t *b;
+  int result;
+
+  SVN_ERR(create_tls_baton(&b, conn, server->ctx));
+
+  result = SSL_accept(b->ssl);
+  if (result != 1)
+    return svn_error_trace(tls_error(b, result, _("TLS handshake failed")));
+
+  install_tls_stream(conn, b);
+  return SVN_NO_ERROR;
+}
+
+/* Use the CA certificates listed in AUTHORITIES and, if TRUST_DEFAULT_CA
+   is set, the system's default CAs to verify the server of B. */
+static svn_error_t *
+set_authorities(tls_baton_t *b,
+                const char *authorities,
+                svn_boolean_t trust_default_ca,
+                apr_pool_t *scratch_pool)
+{
+  X509_STORE *store = X509_STORE_new();
+  svn_error_t *err = SVN_NO_ERROR;
+
+  if (!store)
+    return openssl_error(SVN_ERR_RA_SVN_IO_ERROR,
+                         _("Can't create certificate store"));
+
+  if (trust_default_ca)
+    X509_STORE_set_default_paths(store);
+
+  if (authorities)
+    {
+      apr_array_header_t *files = svn_cstring_split(authorities, ";",
+                                                    TRUE, scratch_pool);
+      int i;
+
+      for (i = 0; i < files->nelts && !err; ++i)
+        {
+          const char *file = APR_ARRAY_IDX(files, i, const char *);
+          const char *file_native;
+
+          err = svn_utf_cstring_from_utf8(&file_native, file, scratch_pool);
+          if (!err && X509_STORE_load_locations(store, file_native, NULL) != 1)
+            err = openssl_error(SVN_ERR_BAD_CONFIG_VALUE,
+                                apr_psprintf(scratch_pool,
+                                             _("Invalid config: unable to "
+                                               "load certificate file '%s'"),
+                                             svn_dirent_local_style(
+                                                 file, scratch_pool)));
+        }
+    }
+
+  /* B's SSL object takes its own reference. */
+  if (!err && SSL_set1_verify_cert_store(b->ssl, store) != 1)
+    err = openssl_error(SVN_ERR_RA_SVN_IO_ERROR,
+                        _("Can't create certificate store"));
+
+  X509_STORE_free(store);
+  return svn_error_trace(err);
+}
+
+/* If a TLS session with the server of B is known, resume it. */
+static svn_error_t *
+resume_session(tls_baton_t *b)
+{
+  SSL_SESSION *session = svn_hash_gets(client_sessions, b->session_key);
+
+  /* Failure is not fatal; we simply do a full handshake. */
+  if (session && SSL_set_session(b->ssl, session) != 1)
+    ERR_clear_error();
+
+  return SVN_NO_ERROR;
+}
+
+/* Return the contents of memory BIO as a string allocated in POOL. */
+static const char *
+bio_to_cstring(BIO *bio,
+               apr_pool_t *pool)
+{
+  char *data;
+  long len = BIO_get_mem_data(bio, &data);
+
+  return len > 0 ? apr_pstrmemdup(pool, data, len) : "";
+}
+
+/* Fill CERT_INFO with a description of CERT, allocated in POOL. */
+static void
+get_cert_info(svn_auth_ssl_server_cert_info_t *cert_info,
+              X509 *cert,
+              apr_pool_t *pool)
+{
+  BIO *bio;
+  char name[256];
+  unsigned char md[EVP_MAX_MD_SIZE];
+  unsigned int md_len = 0;
+  unsigned char *der = NULL;
+  int der_len;
+  svn_stringbuf_t *fingerprint = svn_stringbuf_create_empty(pool);
+  unsigned int i;
+
+  if (X509_NAME_get_text_by_NID(X509_get_subject_name(cert),
+                                NID_commonName, name, sizeof(name)) > 0)
+    cert_info->hostname = apr_pstrdup(pool, name);
+  else
+    cert_info->hostname = "";
+
+  if (X509_digest(cert, EVP_sha1(), md, &md_len) == 1)
+    for (i = 0; i < md_len; ++i)
+      svn_stringbuf_appendcstr(fingerprint,
+                               apr_psprintf(pool, i ? ":%02X" : "%02X",
+                                            md[i]));
+  cert_info->fingerprint = md_len ? fingerprint->data : "<unknown>";
+
+  bio = BIO_new(BIO_s_mem());
+  if (bio && ASN1_TIME_print(bio, X509_get0_notBefore(cert)))
+    cert_info->valid_from = bio_to_cstring(bio, pool);
+  else
+    cert_info->valid_from = "[invalid date]";
+  BIO_free(bio);
+
+  bio = BIO_new(BIO_s_mem());
+  if (bio && ASN1_TIME_print(bio, X509_get0_notAfter(cert)))
+    cert_info->valid_until = bio_to_cstring(bio, pool);
+  else
+    cert_info->valid_until = "[invalid date]";
+  BIO_free(bio);
+
+  bio = BIO_new(BIO_s_mem());
+  if (bio && X509_NAME_print_ex(bio, X509_get_issuer_name(cert), 0,
+                                XN_FLAG_ONELINE & ~ASN1_STRFLGS_ESC_MSB) >= 0)
+    cert_info->issuer_dname = bio_to_cstring(bio, pool);
+  else
+    cert_info->issuer_dname = "";
+  BIO_free(bio);
+
+  der_len = i2d_X509(cert, &der);
+  if (der_len > 0)
+    {
+      cert_info->ascii_cert
+        = svn_base64_encode_string2(svn_string_ncreate((const char *)der,
+                                                       der_len, pool),
+                                    FALSE, pool)->data;
+      OPENSSL_free(der);
+    }
+  else
+    {
+      cert_info->ascii_cert = "";
+    }
+}
+
+/* Append REASON to ERRMSG, counting the number of REASONS so far. */
+static void
+append_reason(svn_stringbuf_t *errmsg,
+              const char *reason,
+              int *reasons)
+{
+  if (*reasons < 1)
+    svn_stringbuf_appendcstr(errmsg, _(": "));
+  else
+    svn_stringbuf_appendcstr(errmsg, _(", "));
+  svn_stringbuf_appendcstr(errmsg, reason);
+  (*reasons)++;
+}
+
+/* Check the certificate that the server of B presented for
+   HOSTNAME:PORT and ask the SVN_AUTH_CRED_SSL_SERVER_TRUST providers of
+   SESS whether to accept it despite any failures. */
+static svn_error_t *
+check_server_cert(tls_baton_t *b,
+                  svn_ra_svn__session_baton_t *sess,
+                  const char *hostname,
+                  int port,
+                  apr_pool_t *scratch_pool)
+{
+  X509 *cert = SSL_get_peer_certificate(b->ssl);
+  apr_uint32_t failures = b->failures;
+  svn_auth_ssl_server_cert_info_t cert_info;
+  svn_auth_iterstate_t *state;
+  void *creds = NULL;
+  svn_error_t *err;
+
+  if (!cert)
+    return svn_error_create(SVN_ERR_RA_SVN_TLS_CERT_UNTRUSTED, NULL,
+                            _("Server did not present a TLS certificate"));
+
+  /* A resumed handshake does not verify the certificate again, so
+     verify_cb() has not been called.  The session still carries the
+     result of the original verification, though. */
+  if (SSL_session_reused(b->ssl))
+    failures |= verify_error_to_failure(SSL_get_verify_result(b->ssl));
+
+  if (   X509_check_host(cert, hostname, 0, 0, NULL) != 1
+      && X509_check_ip_asc(cert, hostname, 0) != 1)
+    failures |= SVN_AUTH_SSL_CNMISMATCH;
+
+  if (!failures)
+    {
+      X509_free(cert);
+      return SVN_NO_ERROR;
+    }
+
+  get_cert_info(&cert_info, cert, scratch_pool);
+  X509_free(cert);
+
+  if (sess->auth_baton)
+    {
+      /* Use the same realm format as ra_serf does for https://. */
+      const char *realmstring = apr_psprintf(scratch_pool, "svns://%s:%d",
+                                             hostname, port);
+
+      svn_auth_set_parameter(sess->auth_baton,
+                             SVN_AUTH_PARAM_SSL_SERVER_FAILURES, &failures);
+      svn_auth_set_parameter(sess->auth_baton,
+                             SVN_AUTH_PARAM_SSL_SERVER_CERT_INFO, &cert_info);
+
+      err = svn_auth_first_credentials(&creds, &state,
+                                       SVN_AUTH_CRED_SSL_SERVER_TRUST,
+                                       realmstring, sess->auth_baton,
+                                       scratch_pool);
+      while (!err && creds)
+        {
+          const svn_auth_cred_ssl_server_trust_t *server_creds = creds;
+
+          failures &= ~server_creds->accepted_failures;
+          err = svn_auth_save_credentials(state, scratch_pool);
+          if (err || !failures)
+            break;
+
+          err = svn_auth_next_credentials(&creds, state, scratch_pool);
+        }
+
+      svn_auth_set_parameter(sess->auth_baton,
+                             SVN_AUTH_PARAM_SSL_SERVER_CERT_INFO, NULL);
+      svn_auth_set_parameter(sess->auth_baton,
+                             SVN_AUTH_PARAM_SSL_SERVER_FAILURES, NULL);
+      SVN_ERR(err);
+    }
+
+  /* Are there non accepted failures left? */
+  if (failures)
+    {
+      svn_stringbuf_t *errmsg;
+      int reasons = 0;
+
+      errmsg = svn_stringbuf_create(
+                 _("Server TLS certificate verification failed"),
+                 scratch_pool);
+
+      if (failures & SVN_AUTH_SSL_NOTYETVALID)
+        append_reason(errmsg, _("certificate is not yet valid"), &reasons);
+
+      if (failures & SVN_AUTH_SSL_EXPIRED)
+        append_reason(errmsg, _("certificate has expired"), &reasons);
+
+      if (failures & SVN_AUTH_SSL_CNMISMATCH)
+        append_reason(errmsg,
+                      _("certificate issued for a different hostname"),
+                      &reasons);
+
+      if (failures & SVN_AUTH_SSL_UNKNOWNCA)
+        append_reason(errmsg, _("issuer is not trusted"), &reasons);
+
+      if (failures & SVN_AUTH_SSL_OTHER)
+        append_reason(errmsg, _("and other reason(s)"), &reasons);
+
+      return svn_error_create(SVN_ERR_RA_SVN_TLS_CERT_UNTRUSTED, NULL,
+                              errmsg->data);
+    }
+
+  return SVN_NO_ERROR;
+}
+
+/* Return TRUE if HOSTNAME is an IP address rather than a DNS name. */
+static svn_boolean_t
+is_ip_address(const char *hostname)
+{
+  return strchr(hostname, ':') != NULL
+      || strspn(hostname, "0123456789.") == strlen(hostname);
+}
+
+svn_error_t *
+svn_ra_svn__tls_connect(svn_ra_svn_conn_t *conn,
+                        svn_ra_svn__session_baton_t *sess,
+                        const char *hostname,
+                        int port,
+                        const char *authorities,
+                        svn_boolean_t trust_default_ca,
+                        apr_pool_t *scratch_pool)
+{
+  tls_baton_t *b;
+  int result;
+  svn_error_t *err;
+
+  SVN_ERR(svn_atomic__init_once(&tls_init_state, init_tls, NULL,
+                                scratch_pool));
+  SVN_ERR(create_tls_baton(&b, conn, client_ctx));
+
+  /* Sessions verified against other CAs must not be resumed. */
+  b->session_key = apr_psprintf(conn->pool, "%s:%d %d %s", hostname, port,
+                                trust_default_ca,
+                                authorities ? authorities : "");
+
+  if (authorities || !trust_default_ca)
+    SVN_ERR(set_authorities(b, authorities, trust_default_ca,
+                            scratch_pool));
+
+  /* Server Name Indication is only defined for DNS names. */
+  if (!is_ip_address(hostname))
+    SSL_set_tlsext_host_name(b->ssl, hostname);
+
+  SVN_MUTEX__WITH_LOCK(session_mutex, resume_session(b));
+
+  result = SSL_connect(b->ssl);
+  if (result != 1)
+    return svn_error_trace(tls_error(b, result, _("TLS handshake failed")));
+
+  err = check_server_cert(b, sess, hostname, port, scratch_pool);
+  if (err)
+    {
+      /* Don't offer a rejected session again. */
+      if (SSL_session_reused(b->ssl))
+        {
+          svn_error_t *lock_err = svn_mutex__lock(session_mutex);
+          if (!lock_err)
+            lock_err = svn_mutex__unlock(session_mutex, uncache_session(b));
+          err = svn_error_compose_create(err, lock_err);
+        }
+
+      return svn_error_trace(err);
+    }
+
+  /* Now, the sessions of this connection may be resumed by others. */
+  b->verified = TRUE;
+  SVN_MUTEX__WITH_LOCK(session_mutex, cache_pending_session(b));
+
+  install_tls_stream(conn, b);
+  return SVN_NO_ERROR;
+}
+
+#else /* SVN_HAVE_OPENSSL */
+
+svn_error_t *
+svn_ra_svn__tls_server_create(svn_ra_svn__tls_server_t **server,
+                              const char *cert_file,
+                              const char *key_file,
+                              apr_pool_t *result_pool)
+{
+  return svn_error_create(SVN_ERR_UNSUPPORTED_FEATURE, NULL,
+                          _("TLS support is not available"));
+}
+
+svn_error_t *
+svn_ra_svn__tls_accept(svn_ra_svn_conn_t *conn,
+                       svn_ra_svn__tls_server_t *server,
+                       apr_pool_t *scratch_pool)
+{
+  return svn_error_create(SVN_ERR_UNSUPPORTED_FEATURE, NULL,
+                          _("TLS support is not available"));
+}
+
+svn_error_t *
+svn_ra_svn__tls_connect(svn_ra_svn_conn_t *conn,
+                        svn_ra_svn__session_baton_t *sess,
+                        const char *hostname,
+                        int port,
+                        const char *authorities,
+                        svn_boolean_t trust_default_ca,
+                        apr_pool_t *scratch_pool)
+{
+  return svn_error_create(SVN_ERR_UNSUPPORTED_FEATURE, NULL,
+                          _("TLS support is not available"));
+}
+
+#endif /* SVN_HAVE_OPENSSL */
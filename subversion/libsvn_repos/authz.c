@@ -23,6 +23,8 @@
 
 /*** Includes. ***/
 
+#include <string.h>
+
 #include <apr_pools.h>
 #include <apr_file_io.h>
 #include <apr_fnmatch.h>
@@ -34,7 +36,9 @@
 #include "svn_path.h"
 #include "svn_repos.h"
 #include "svn_config.h"
+#include "svn_checksum.h"
 #include "svn_ctype.h"
+#include "svn_io.h"
 #include "private/svn_atomic.h"
 #include "private/svn_fspath.h"
 #include "private/svn_repos_private.h"
@@ -123,13 +127,22 @@ combine_right_limits(limited_rights_t *target,
 
 /*** Authz cache access. ***/
 
+/* Number of unused filtered authz instances to keep around if the cache
+ * configuration does not specify otherwise.  Filtering is expensive for
+ * large rule sets and users tend to come back soon. */
+#define DEFAULT_FILTERED_TREE_COUNT 1024
+
 /* All authz instances currently in use as well as all filtered authz
- * instances in use will be cached here.
+ * instances in use will be cached here.  Recently used filtered instances
+ * will be kept even if no longer in use.
  * Both caches will be instantiated at most once. */
 static svn_object_pool__t *authz_pool = NULL;
 static svn_object_pool__t *filtered_pool = NULL;
 static svn_atomic_t authz_pool_initialized = FALSE;
 
+/* Current settings, see svn_repos__authz_cache_config_set(). */
+static svn_repos__authz_cache_config_t cache_config = { NULL, 0 };
+
 /* Implements svn_atomic__err_init_func_t. */
 static svn_error_t *
 synchronized_authz_initialize(void *baton, apr_pool_t *pool)
@@ -141,7 +154,11 @@ synchronized_authz_initialize(void *baton, apr_pool_t *pool)
 #endif
 
   SVN_ERR(svn_object_pool__create(&authz_pool, multi_threaded, pool));
-  SVN_ERR(svn_object_pool__create(&filtered_pool, multi_threaded, pool));
+  SVN_ERR(svn_object_pool__create2(&filtered_pool, multi_threaded,
+                                   cache_config.filtered_tree_count
+                                     ? cache_config.filtered_tree_count
+                                     : DEFAULT_FILTERED_TREE_COUNT,
+                                   pool));
 
   return SVN_NO_ERROR;
 }
@@ -155,6 +172,13 @@ svn_repos_authz_initialize(apr_pool_t *pool)
                                                NULL, pool));
 }
 
+void
+svn_repos__authz_cache_config_set(
+  const svn_repos__authz_cache_config_t *settings)
+{
+  cache_config = *settings;
+}
+
 /* Return a combination of AUTHZ_KEY and GROUPS_KEY, allocated in RESULT_POOL.
  * GROUPS_KEY may be NULL.  This is the key for the AUTHZ_POOL.
  */
@@ -214,6 +238,158 @@ construct_filtered_key(const char *repos_name,
   return result;
 }
 
+
+/*** On-disk cache of compiled authz models. ***/
+
+/* Return the path of the file in the on-disk cache that holds the model
+ * identified by AUTHZ_ID, allocated in RESULT_POOL.  Return NULL if the
+ * on-disk cache is disabled. */
+static const char *
+compiled_authz_path(const svn_membuf_t *authz_id,
+                    apr_pool_t *result_pool)
+{
+  static const char hex[] = "0123456789abcdef";
+  const unsigned char *data = authz_id->data;
+  char *name;
+  apr_size_t i;
+
+  if (!cache_config.cache_dir)
+    return NULL;
+
+  name = apr_palloc(result_pool, 2 * authz_id->size + 1);
+  for (i = 0; i < authz_id->size; ++i)
+    {
+      name[2 * i] = hex[data[i] >> 4];
+      name[2 * i + 1] = hex[data[i] & 0xf];
+    }
+  name[2 * authz_id->size] = '\0';
+
+  return svn_dirent_join(cache_config.cache_dir,
+                         apr_pstrcat(result_pool, "authz-", name, ".bin",
+                                     SVN_VA_NULL),
+                         result_pool);
+}
+
+/* Cache files end with a checksum of this kind over the serialized
+ * model.  The file name only identifies the authz rules, this guards
+ * against files that got damaged on disk. */
+#define COMPILED_AUTHZ_CHECKSUM svn_checksum_fnv1a_32x4
+
+/* Load the compiled authz model from the on-disk cache file at PATH and
+ * return it in *AUTHZ_P, allocated in RESULT_POOL.  Set *AUTHZ_P to NULL
+ * if there is no such file.  Remove the file if it is corrupt, so that it
+ * will be replaced.  Use SCRATCH_POOL for temporary allocations.
+ */
+static svn_error_t *
+read_compiled_authz(authz_full_t **authz_p,
+                    const char *path,
+                    apr_pool_t *result_pool,
+                    apr_pool_t *scratch_pool)
+{
+  svn_stringbuf_t *contents;
+  svn_checksum_t *expected;
+  svn_checksum_t *actual;
+  svn_error_t *err;
+
+  *authz_p = NULL;
+  err = svn_stringbuf_from_file2(&contents, path, scratch_pool);
+  if (err && APR_STATUS_IS_ENOENT(err->apr_err))
+    {
+      svn_error_clear(err);
+      return SVN_NO_ERROR;
+    }
+  SVN_ERR(err);
+
+  /* Split off the trailing checksum and verify it. */
+  expected = svn_checksum_create(COMPILED_AUTHZ_CHECKSUM, scratch_pool);
+  if (contents->len < svn_checksum_size(expected))
+    return svn_error_trace(svn_io_remove_file2(path, TRUE, scratch_pool));
+
+  contents->len -= svn_checksum_size(expected);
+  memcpy((unsigned char *)expected->digest, contents->data + contents->len,
+         svn_checksum_size(expected));
+  contents->data[contents->len] = '\0';
+
+  SVN_ERR(svn_checksum(&actual, COMPILED_AUTHZ_CHECKSUM, contents->data,
+                       contents->len, scratch_pool));
+  if (!svn_checksum_match(expected, actual))
+    return svn_error_trace(svn_io_remove_file2(path, TRUE, scratch_pool));
+
+  err = svn_authz__deserialize(authz_p,
+                               svn_stream_from_stringbuf(contents,
+                                                         scratch_pool),
+                               result_pool, scratch_pool);
+  if (err)
+    {
+      *authz_p = NULL;
+      return svn_error_compose_create(err, svn_io_remove_file2(path, TRUE,
+                                                               scratch_pool));
+    }
+
+  return SVN_NO_ERROR;
+}
+
+/* Store AUTHZ in the on-disk cache file at PATH.
+ * Use SCRATCH_POOL for temporary allocations.
+ */
+static svn_error_t *
+write_compiled_authz(const char *path,
+                     const authz_full_t *authz,
+                     apr_pool_t *scratch_pool)
+{
+  svn_stringbuf_t *buffer = svn_stringbuf_create_empty(scratch_pool);
+  svn_checksum_t *checksum;
+
+  SVN_ERR(svn_authz__serialize(svn_stream_from_stringbuf(buffer,
+                                                         scratch_pool),
+                               authz, scratch_pool));
+  SVN_ERR(svn_checksum(&checksum, COMPILED_AUTHZ_CHECKSUM, buffer->data,
+                       buffer->len, scratch_pool));
+  svn_stringbuf_appendbytes(buffer, (const char *)checksum->digest,
+                            svn_checksum_size(checksum));
+
+  /* Concurrent writers will produce the same contents, so it does not
+     matter who wins.  Readers never see partially written files. */
+  SVN_ERR(svn_io_make_dir_recursively(cache_config.cache_dir, scratch_pool));
+  return svn_error_trace(svn_io_write_atomic2(path, buffer->data,
+                                              buffer->len, NULL, FALSE,
+                                              scratch_pool));
+}
+
+/* Construct the full authz model identified by AUTHZ_ID from RULES and
+ * the optional GROUPS, just like svn_authz__parse() does.  If possible,
+ * use the on-disk cache instead of actually parsing the rules.  */
+static svn_error_t *
+parse_authz(authz_full_t **authz_p,
+            const svn_membuf_t *authz_id,
+            svn_stream_t *rules,
+            svn_stream_t *groups,
+            apr_pool_t *result_pool,
+            apr_pool_t *scratch_pool)
+{
+  const char *path = compiled_authz_path(authz_id, scratch_pool);
+
+  /* The on-disk cache is optional and any problem with it simply means
+     that we have to parse the rules. */
+  if (path)
+    {
+      svn_error_t *err = read_compiled_authz(authz_p, path, result_pool,
+                                             scratch_pool);
+      if (!err && *authz_p)
+        return SVN_NO_ERROR;
+
+      svn_error_clear(err);
+    }
+
+  SVN_ERR(svn_authz__parse(authz_p, rules, groups, result_pool,
+                           scratch_pool));
+
+  if (path)
+    svn_error_clear(write_compiled_authz(path, *authz_p, scratch_pool));
+
+  return SVN_NO_ERROR;
+}
+
 
 /*** Constructing the prefix tree. ***/
 
@@ -1586,8 +1762,8 @@ authz_read(authz_full_t **authz_p,
 
           /* Parse the configuration(s) and construct the full authz model
            * from it. */
-          err = svn_authz__parse(authz_p, rules_stream, groups_stream,
-                                item_pool, scratch_pool);
+          err = parse_authz(authz_p, *authz_id, rules_stream, groups_stream,
+                            item_pool, scratch_pool);
           if (err != SVN_NO_ERROR)
             {
               /* That pool would otherwise never get destroyed. */
@@ -1611,9 +1787,9 @@ authz_read(authz_full_t **authz_p,
     {
       /* Parse the configuration(s) and construct the full authz model from
        * it. */
-      err = svn_error_quick_wrapf(svn_authz__parse(authz_p, rules_stream,
-                                                   groups_stream,
-                                                   result_pool, scratch_pool),
+      err = svn_error_quick_wrapf(parse_authz(authz_p, *authz_id,
+                                              rules_stream, groups_stream,
+                                              result_pool, scratch_pool),
                                   "Error while parsing authz file: '%s':",
                                   path);
     }
@@ -1727,3 +1903,179 @@ svn_repos_authz_check_access(svn_authz_t *authz, const char *repos_name,
 
   return SVN_NO_ERROR;
 }
+
+/* An element of the sorted path list in svn_repos__authz_check_access_many.
+ */
+typedef struct indexed_path_t
+{
+  /* The path to check. */
+  const char *path;
+
+  /* Index of PATH in the caller-provided list. */
+  int idx;
+} indexed_path_t;
+
+/* Implements the comparison function for svn_sort__array, ordering
+ * indexed_path_t elements by path such that all sub-paths of a directory
+ * are adjacent and follow the directory itself.  NULL paths come first.
+ */
+static int
+compare_indexed_paths(const void *lhs,
+                      const void *rhs)
+{
+  const indexed_path_t *lhs_path = lhs;
+  const indexed_path_t *rhs_path = rhs;
+
+  if (lhs_path->path == NULL || rhs_path->path == NULL)
+    return (lhs_path->path != NULL) - (rhs_path->path != NULL);
+
+  return svn_path_compare_paths(lhs_path->path, rhs_path->path);
+}
+
+svn_error_t *
+svn_repos__authz_check_access_many(svn_authz_t *authz,
+                                   const char *repos_name,
+                                   const apr_array_header_t *paths,
+                                   const char *user,
+                                   svn_repos_authz_access_t required_access,
+                                   svn_boolean_t *access_granted,
+                                   apr_pool_t *scratch_pool)
+{
+  const authz_access_t required =
+    ((required_access & svn_authz_read ? authz_access_read_flag : 0)
+     | (required_access & svn_authz_write ? authz_access_write_flag : 0));
+  const svn_boolean_t recursive = !!(required_access & svn_authz_recursive);
+  authz_user_rules_t *rules;
+  apr_array_header_t *sorted;
+  int i;
+
+  if (paths->nelts == 0)
+    return SVN_NO_ERROR;
+
+  /* Pick or create the suitable pre-filtered path rule tree. */
+  rules = get_user_rules(authz,
+                         (repos_name ? repos_name : AUTHZ_ANY_REPOSITORY),
+                         user);
+
+  /* Blanket access or no access at all decides for all paths alike. */
+  if (   ((rules->global_rights.min_access & required) == required)
+      || ((rules->global_rights.max_access & required) != required))
+    {
+      const svn_boolean_t granted
+        = ((rules->global_rights.min_access & required) == required);
+
+      for (i = 0; i < paths->nelts; ++i)
+        access_granted[i] = granted;
+
+      return SVN_NO_ERROR;
+    }
+
+  /* Did we already filter the data model? */
+  if (!rules->root)
+    SVN_ERR(filter_tree(authz, scratch_pool));
+
+  /* Sort the paths so that consecutive lookups can continue from the
+   * common parent of the previous one. */
+  sorted = apr_array_make(scratch_pool, paths->nelts, sizeof(indexed_path_t));
+  for (i = 0; i < paths->nelts; ++i)
+    {
+      indexed_path_t *entry = apr_array_push(sorted);
+      entry->path = APR_ARRAY_IDX(paths, i, const char *);
+      entry->idx = i;
+    }
+
+  svn_sort__array(sorted, compare_indexed_paths);
+
+  for (i = 0; i < sorted->nelts; ++i)
+    {
+      const indexed_path_t *entry = &APR_ARRAY_IDX(sorted, i, indexed_path_t);
+      const char *path = entry->path;
+
+      /* No specific path given, i.e. looking for anywhere in the tree?
+       * We only get here if the user has REQUIRED access somewhere. */
+      if (!path)
+        {
+          access_granted[entry->idx] = TRUE;
+          continue;
+        }
+
+      /* Re-use the lookup of the previous path, if possible. */
+      path = init_lockup_state(rules->lookup_state, rules->root, path);
+
+      /* Sanity check. */
+      SVN_ERR_ASSERT(path[0] == '/');
+
+      access_granted[entry->idx] = lookup(rules->lookup_state, path,
+                                          required, recursive, scratch_pool);
+    }
+
+  return SVN_NO_ERROR;
+}
+
+
+
+/*** Batch authz callbacks. ***/
+
+svn_error_t *
+svn_repos__authz_batch_read_func(svn_boolean_t *allowed,
+                                 svn_fs_root_t *root,
+                                 const char *path,
+                                 void *baton,
+                                 apr_pool_t *pool)
+{
+  svn_repos__authz_batch_baton_t *batch_baton = baton;
+
+  return svn_error_trace(batch_baton->read_func(allowed, root, path, baton,
+                                                pool));
+}
+
+svn_boolean_t
+svn_repos__authz_read_is_batched(svn_repos_authz_func_t authz_read_func)
+{
+  return authz_read_func == svn_repos__authz_batch_read_func;
+}
+
+svn_error_t *
+svn_repos__authz_read_many(svn_boolean_t *allowed,
+                           svn_fs_root_t *root,
+                           const apr_array_header_t *paths,
+                           svn_repos_authz_func_t authz_read_func,
+                           void *authz_read_baton,
+                           apr_pool_t *scratch_pool)
+{
+  apr_pool_t *iterpool;
+  int i;
+
+  /* No authz at all? */
+  if (!authz_read_func)
+    {
+      for (i = 0; i < paths->nelts; ++i)
+        allowed[i] = TRUE;
+
+      return SVN_NO_ERROR;
+    }
+
+  /* Let batch-capable servers handle all paths at once. */
+  if (svn_repos__authz_read_is_batched(authz_read_func))
+    {
+      svn_repos__authz_batch_baton_t *batch_baton = authz_read_baton;
+      if (batch_baton->batch_func)
+        return svn_error_trace(batch_baton->batch_func(allowed, root, paths,
+                                                       authz_read_baton,
+                                                       scratch_pool));
+    }
+
+  /* Check one path at a time. */
+  iterpool = svn_pool_create(scratch_pool);
+  for (i = 0; i < paths->nelts; ++i)
+    {
+      svn_pool_clear(iterpool);
+      SVN_ERR(authz_read_func(&allowed[i], root,
+                              APR_ARRAY_IDX(paths, i, const char *),
+                              authz_read_baton, iterpool));
+    }
+
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
@@ -316,6 +316,26 @@ svn_authz__parse(authz_full_t **authz,
                  apr_pool_t *scratch_pool);
 
 
+/* Write a compact binary representation of AUTHZ to STREAM.
+ * Use SCRATCH_POOL for temporary allocations.
+ */
+svn_error_t *
+svn_authz__serialize(svn_stream_t *stream,
+                     const authz_full_t *authz,
+                     apr_pool_t *scratch_pool);
+
+/* Read an authz model written by svn_authz__serialize() from STREAM and
+ * return it in *AUTHZ, allocated in RESULT_POOL.  Return
+ * SVN_ERR_AUTHZ_INVALID_CONFIG if the data is not in the expected format.
+ * Use SCRATCH_POOL for temporary allocations.
+ */
+svn_error_t *
+svn_authz__deserialize(authz_full_t **authz,
+                       svn_stream_t *stream,
+                       apr_pool_t *result_pool,
+                       apr_pool_t *scratch_pool);
+
+
 /* Reverse a STRING of length LEN in place. */
 void
 svn_authz__reverse_string(char *string, apr_size_t len);
@@ -0,0 +1,512 @@
+/* authz_serialize.c : Storing parsed authz models in a compact binary form
+ *
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ */
+
+#include <string.h>
+
+#include <apr_strings.h>
+
+#include "svn_hash.h"
+#include "svn_pools.h"
+
+#include "private/svn_packed_data.h"
+#include "private/svn_subr_private.h"
+
+#include "svn_private_config.h"
+
+#include "authz.h"
+
+
+/* Bump this whenever the serialized representation or the structure of
+ * authz_full_t changes.  Data of any other format will be rejected. */
+#define AUTHZ_SERIALIZATION_FORMAT 1
+
+/* All numbers go into a single int stream and all strings into a single
+ * byte stream.  Strings are interned: the first reference to a given
+ * string puts it into the byte stream, all later references use the
+ * number of that string.  Group membership hashes get shared the same
+ * way.  That way, the loaded model gets the same string identities that
+ * the authz parser guarantees. */
+
+/* Context used while serializing an authz model. */
+typedef struct write_context_t
+{
+  svn_packed__int_stream_t *ints;
+  svn_packed__byte_stream_t *bytes;
+
+  /* Maps the contents of strings written so far to their 1-based ref.
+   * Values are apr_size_t *. */
+  apr_hash_t *strings;
+
+  /* Maps group membership hash pointers to their 1-based ref. */
+  apr_hash_t *members;
+
+  apr_pool_t *pool;
+} write_context_t;
+
+/* Context used while deserializing an authz model. */
+typedef struct read_context_t
+{
+  svn_packed__int_stream_t *ints;
+  svn_packed__byte_stream_t *bytes;
+
+  /* All strings read so far, in the order they were written. */
+  apr_array_header_t *strings;
+
+  /* All group membership hashes read so far. */
+  apr_array_header_t *members;
+
+  apr_pool_t *result_pool;
+} read_context_t;
+
+/* Return an error indicating that the serialized data is unusable. */
+static svn_error_t *
+corrupt_data(void)
+{
+  return svn_error_create(SVN_ERR_AUTHZ_INVALID_CONFIG, NULL,
+                          _("Corrupt serialized authz data"));
+}
+
+/* Write a reference to STR, which may be NULL, to CTX. */
+static void
+write_string(write_context_t *ctx,
+             const char *str)
+{
+  apr_size_t len;
+  apr_size_t *ref;
+
+  if (!str)
+    {
+      svn_packed__add_uint(ctx->ints, 0);
+      return;
+    }
+
+  len = strlen(str);
+  ref = apr_hash_get(ctx->strings, str, len);
+  if (!ref)
+    {
+      ref = apr_palloc(ctx->pool, sizeof(*ref));
+      *ref = apr_hash_count(ctx->strings) + 1;
+      apr_hash_set(ctx->strings, str, len, ref);
+      svn_packed__add_bytes(ctx->bytes, str, len);
+    }
+
+  svn_packed__add_uint(ctx->ints, *ref);
+}
+
+/* Read a string reference from CTX and return the string in *STR. */
+static svn_error_t *
+read_string(const char **str,
+            read_context_t *ctx)
+{
+  apr_uint64_t ref = svn_packed__get_uint(ctx->ints);
+
+  if (ref == 0)
+    {
+      *str = NULL;
+    }
+  else if (ref <= (apr_uint64_t)ctx->strings->nelts)
+    {
+      *str = APR_ARRAY_IDX(ctx->strings, ref - 1, const char *);
+    }
+  else if (ref == (apr_uint64_t)ctx->strings->nelts + 1)
+    {
+      apr_size_t len;
+      const char *data = svn_packed__get_bytes(ctx->bytes, &len);
+
+      *str = apr_pstrmemdup(ctx->result_pool, data, len);
+      APR_ARRAY_PUSH(ctx->strings, const char *) = *str;
+    }
+  else
+    {
+      return svn_error_trace(corrupt_data());
+    }
+
+  return SVN_NO_ERROR;
+}
+
+/* Write RIGHTS to CTX. */
+static void
+write_rights(write_context_t *ctx,
+             const authz_rights_t *rights)
+{
+  svn_packed__add_uint(ctx->ints, rights->min_access);
+  svn_packed__add_uint(ctx->ints, rights->max_access);
+}
+
+/* Read *RIGHTS from CTX. */
+static void
+read_rights(authz_rights_t *rights,
+            read_context_t *ctx)
+{
+  rights->min_access = (authz_access_t)svn_packed__get_uint(ctx->ints);
+  rights->max_access = (authz_access_t)svn_packed__get_uint(ctx->ints);
+}
+
+/* Write the global RIGHTS to CTX. */
+static void
+write_global_rights(write_context_t *ctx,
+                    const authz_global_rights_t *rights,
+                    apr_pool_t *scratch_pool)
+{
+  apr_hash_index_t *hi;
+
+  write_string(ctx, rights->user);
+  write_rights(ctx, &rights->any_repos_rights);
+  write_rights(ctx, &rights->all_repos_rights);
+
+  svn_packed__add_uint(ctx->ints, apr_hash_count(rights->per_repos_rights));
+  for (hi = apr_hash_first(scratch_pool, rights->per_repos_rights);
+       hi;
+       hi = apr_hash_next(hi))
+    {
+      write_string(ctx, apr_hash_this_key(hi));
+      write_rights(ctx, apr_hash_this_val(hi));
+    }
+}
+
+/* Read the global *RIGHTS from CTX. */
+static svn_error_t *
+read_global_rights(authz_global_rights_t *rights,
+                   read_context_t *ctx)
+{
+  apr_uint64_t count;
+
+  SVN_ERR(read_string(&rights->user, ctx));
+  read_rights(&rights->any_repos_rights, ctx);
+  read_rights(&rights->all_repos_rights, ctx);
+
+  rights->per_repos_rights = svn_hash__make(ctx->result_pool);
+  for (count = svn_packed__get_uint(ctx->ints); count > 0; --count)
+    {
+      const char *repos;
+      authz_rights_t *repos_rights = apr_palloc(ctx->result_pool,
+                                                sizeof(*repos_rights));
+
+      SVN_ERR(read_string(&repos, ctx));
+      if (!repos)
+        return svn_error_trace(corrupt_data());
+
+      read_rights(repos_rights, ctx);
+      svn_hash_sets(rights->per_repos_rights, repos, repos_rights);
+    }
+
+  return SVN_NO_ERROR;
+}
+
+/* Write a reference to the group MEMBERS hash, which may be NULL, to CTX. */
+static void
+write_members(write_context_t *ctx,
+              apr_hash_t *members,
+              apr_pool_t *scratch_pool)
+{
+  apr_size_t *ref;
+  apr_hash_index_t *hi;
+
+  if (!members)
+    {
+      svn_packed__add_uint(ctx->ints, 0);
+      return;
+    }
+
+  ref = apr_hash_get(ctx->members, &members, sizeof(members));
+  if (ref)
+    {
+      svn_packed__add_uint(ctx->ints, *ref);
+      return;
+    }
+
+  ref = apr_palloc(ctx->pool, sizeof(*ref));
+  *ref = apr_hash_count(ctx->members) + 1;
+  apr_hash_set(ctx->members, apr_pmemdup(ctx->pool, &members,
+                                         sizeof(members)),
+               sizeof(members), ref);
+
+  svn_packed__add_uint(ctx->ints, *ref);
+  svn_packed__add_uint(ctx->ints, apr_hash_count(members));
+  for (hi = apr_hash_first(scratch_pool, members); hi; hi = apr_hash_next(hi))
+    write_string(ctx, apr_hash_this_key(hi));
+}
+
+/* Read a group membership hash reference from CTX and return the hash
+ * in *MEMBERS. */
+static svn_error_t *
+read_members(apr_hash_t **members,
+             read_context_t *ctx)
+{
+  apr_uint64_t ref = svn_packed__get_uint(ctx->ints);
+  apr_uint64_t count;
+
+  if (ref == 0)
+    {
+      *members = NULL;
+      return SVN_NO_ERROR;
+    }
+
+  if (ref <= (apr_uint64_t)ctx->members->nelts)
+    {
+      *members = APR_ARRAY_IDX(ctx->members, ref - 1, apr_hash_t *);
+      return SVN_NO_ERROR;
+    }
+
+  if (ref != (apr_uint64_t)ctx->members->nelts + 1)
+    return svn_error_trace(corrupt_data());
+
+  *members = svn_hash__make(ctx->result_pool);
+  APR_ARRAY_PUSH(ctx->members, apr_hash_t *) = *members;
+
+  for (count = svn_packed__get_uint(ctx->ints); count > 0; --count)
+    {
+      const char *user;
+
+      SVN_ERR(read_string(&user, ctx));
+      if (!user)
+        return svn_error_trace(corrupt_data());
+
+      /* Same as the parser does it. */
+      svn_hash_sets(*members, user, "");
+    }
+
+  return SVN_NO_ERROR;
+}
+
+/* Write ACL to CTX. */
+static void
+write_acl(write_context_t *ctx,
+          const authz_acl_t *acl,
+          apr_pool_t *scratch_pool)
+{
+  int i;
+
+  svn_packed__add_uint(ctx->ints, acl->sequence_number);
+
+  write_string(ctx, acl->rule.repos);
+  svn_packed__add_uint(ctx->ints, acl->rule.len);
+  for (i = 0; i < acl->rule.len; ++i)
+    {
+      svn_packed__add_uint(ctx->ints, acl->rule.path[i].kind);
+      write_string(ctx, acl->rule.path[i].pattern.data);
+    }
+
+  svn_packed__add_uint(ctx->ints, acl->has_anon_access);
+  svn_packed__add_uint(ctx->ints, acl->anon_access);
+  svn_packed__add_uint(ctx->ints, acl->has_authn_access);
+  svn_packed__add_uint(ctx->ints, acl->authn_access);
+  svn_packed__add_uint(ctx->ints, acl->has_neg_access);
+  svn_packed__add_uint(ctx->ints, acl->neg_access);
+
+  /* Distinguish between NULL and empty USER_ACCESS arrays. */
+  if (!acl->user_access)
+    {
+      svn_packed__add_uint(ctx->ints, 0);
+      return;
+    }
+
+  svn_packed__add_uint(ctx->ints, acl->user_access->nelts + 1);
+  for (i = 0; i < acl->user_access->nelts; ++i)
+    {
+      const authz_ace_t *ace = &APR_ARRAY_IDX(acl->user_access, i,
+                                              authz_ace_t);
+
+      write_string(ctx, ace->name);
+      write_members(ctx, ace->members, scratch_pool);
+      svn_packed__add_uint(ctx->ints, ace->inverted);
+      svn_packed__add_uint(ctx->ints, ace->access);
+    }
+}
+
+/* Read *ACL from CTX. */
+static svn_error_t *
+read_acl(authz_acl_t *acl,
+         read_context_t *ctx)
+{
+  apr_uint64_t count;
+  int i;
+
+  acl->sequence_number = (int)svn_packed__get_uint(ctx->ints);
+
+  SVN_ERR(read_string(&acl->rule.repos, ctx));
+  if (!acl->rule.repos)
+    return svn_error_trace(corrupt_data());
+
+  acl->rule.len = (int)svn_packed__get_uint(ctx->ints);
+  acl->rule.path = NULL;
+  if (acl->rule.len > 0)
+    acl->rule.path = apr_palloc(ctx->result_pool,
+                                acl->rule.len * sizeof(*acl->rule.path));
+
+  for (i = 0; i < acl->rule.len; ++i)
+    {
+      authz_rule_segment_t *segment = &acl->rule.path[i];
+
+      segment->kind = (int)svn_packed__get_uint(ctx->ints);
+      SVN_ERR(read_string(&segment->pattern.data, ctx));
+      if (!segment->pattern.data)
+        return svn_error_trace(corrupt_data());
+
+      segment->pattern.len = strlen(segment->pattern.data);
+    }
+
+  acl->has_anon_access = (svn_boolean_t)svn_packed__get_uint(ctx->ints);
+  acl->anon_access = (authz_access_t)svn_packed__get_uint(ctx->ints);
+  acl->has_authn_access = (svn_boolean_t)svn_packed__get_uint(ctx->ints);
+  acl->authn_access = (authz_access_t)svn_packed__get_uint(ctx->ints);
+  acl->has_neg_access = (svn_boolean_t)svn_packed__get_uint(ctx->ints);
+  acl->neg_access = (authz_access_t)svn_packed__get_uint(ctx->ints);
+
+  count = svn_packed__get_uint(ctx->ints);
+  if (count == 0)
+    {
+      acl->user_access = NULL;
+      return SVN_NO_ERROR;
+    }
+
+  acl->user_access = apr_array_make(ctx->result_pool, (int)(count - 1),
+                                    sizeof(authz_ace_t));
+  for (--count; count > 0; --count)
+    {
+      authz_ace_t *ace = &APR_ARRAY_PUSH(acl->user_access, authz_ace_t);
+
+      SVN_ERR(read_string(&ace->name, ctx));
+      if (!ace->name)
+        return svn_error_trace(corrupt_data());
+
+      SVN_ERR(read_members(&ace->members, ctx));
+      ace->inverted = (svn_boolean_t)svn_packed__get_uint(ctx->ints);
+      ace->access = (authz_access_t)svn_packed__get_uint(ctx->ints);
+    }
+
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_authz__serialize(svn_stream_t *stream,
+                     const authz_full_t *authz,
+                     apr_pool_t *scratch_pool)
+{
+  svn_packed__data_root_t *root = svn_packed__data_create_root(scratch_pool);
+  apr_pool_t *iterpool = svn_pool_create(scratch_pool);
+  write_context_t ctx;
+  apr_hash_index_t *hi;
+  int i;
+
+  ctx.ints = svn_packed__create_int_stream(root, FALSE, FALSE);
+  ctx.bytes = svn_packed__create_bytes_stream(root);
+  ctx.strings = svn_hash__make(scratch_pool);
+  ctx.members = apr_hash_make(scratch_pool);
+  ctx.pool = scratch_pool;
+
+  svn_packed__add_uint(ctx.ints, AUTHZ_SERIALIZATION_FORMAT);
+
+  svn_packed__add_uint(ctx.ints, authz->acls->nelts);
+  for (i = 0; i < authz->acls->nelts; ++i)
+    {
+      svn_pool_clear(iterpool);
+      write_acl(&ctx, &APR_ARRAY_IDX(authz->acls, i, authz_acl_t), iterpool);
+    }
+
+  svn_packed__add_uint(ctx.ints, authz->has_anon_rights);
+  write_global_rights(&ctx, &authz->anon_rights, iterpool);
+  svn_packed__add_uint(ctx.ints, authz->has_authn_rights);
+  write_global_rights(&ctx, &authz->authn_rights, iterpool);
+  svn_packed__add_uint(ctx.ints, authz->has_neg_rights);
+  write_global_rights(&ctx, &authz->neg_rights, iterpool);
+
+  svn_packed__add_uint(ctx.ints, apr_hash_count(authz->user_rights));
+  for (hi = apr_hash_first(scratch_pool, authz->user_rights);
+       hi;
+       hi = apr_hash_next(hi))
+    {
+      svn_pool_clear(iterpool);
+      write_global_rights(&ctx, apr_hash_this_val(hi), iterpool);
+    }
+
+  /* Allows us to detect truncated data. */
+  svn_packed__add_uint(ctx.ints, AUTHZ_SERIALIZATION_FORMAT);
+
+  svn_pool_destroy(iterpool);
+
+  return svn_error_trace(svn_packed__data_write(stream, root, scratch_pool));
+}
+
+svn_error_t *
+svn_authz__deserialize(authz_full_t **authz_p,
+                       svn_stream_t *stream,
+                       apr_pool_t *result_pool,
+                       apr_pool_t *scratch_pool)
+{
+  svn_packed__data_root_t *root;
+  authz_full_t *authz;
+  read_context_t ctx;
+  apr_uint64_t count;
+
+  SVN_ERR(svn_packed__data_read(&root, stream, scratch_pool, scratch_pool));
+
+  ctx.ints = svn_packed__first_int_stream(root);
+  ctx.bytes = svn_packed__first_byte_stream(root);
+  if (!ctx.ints || !ctx.bytes)
+    return svn_error_trace(corrupt_data());
+
+  ctx.strings = apr_array_make(scratch_pool, 256, sizeof(const char *));
+  ctx.members = apr_array_make(scratch_pool, 16, sizeof(apr_hash_t *));
+  ctx.result_pool = result_pool;
+
+  if (svn_packed__get_uint(ctx.ints) != AUTHZ_SERIALIZATION_FORMAT)
+    return svn_error_trace(corrupt_data());
+
+  authz = apr_pcalloc(result_pool, sizeof(*authz));
+  authz->pool = result_pool;
+
+  /* Each ACL takes up at least 9 numbers in the stream. */
+  count = svn_packed__get_uint(ctx.ints);
+  if (count > svn_packed__int_count(ctx.ints) / 9)
+    return svn_error_trace(corrupt_data());
+
+  authz->acls = apr_array_make(result_pool, (int)count, sizeof(authz_acl_t));
+  for (; count > 0; --count)
+    SVN_ERR(read_acl(&APR_ARRAY_PUSH(authz->acls, authz_acl_t), &ctx));
+
+  authz->has_anon_rights = (svn_boolean_t)svn_packed__get_uint(ctx.ints);
+  SVN_ERR(read_global_rights(&authz->anon_rights, &ctx));
+  authz->has_authn_rights = (svn_boolean_t)svn_packed__get_uint(ctx.ints);
+  SVN_ERR(read_global_rights(&authz->authn_rights, &ctx));
+  authz->has_neg_rights = (svn_boolean_t)svn_packed__get_uint(ctx.ints);
+  SVN_ERR(read_global_rights(&authz->neg_rights, &ctx));
+
+  authz->user_rights = svn_hash__make(result_pool);
+  for (count = svn_packed__get_uint(ctx.ints); count > 0; --count)
+    {
+      authz_global_rights_t *rights = apr_palloc(result_pool,
+                                                 sizeof(*rights));
+
+      SVN_ERR(read_global_rights(rights, &ctx));
+      if (!rights->user)
+        return svn_error_trace(corrupt_data());
+
+      svn_hash_sets(authz->user_rights, rights->user, rights);
+    }
+
+  if (svn_packed__get_uint(ctx.ints) != AUTHZ_SERIALIZATION_FORMAT)
+    return svn_error_trace(corrupt_data());
+
+  *authz_p = authz;
+  return SVN_NO_ERROR;
+}
@@ -0,0 +1,212 @@
+/* blame.c : reconstructing the fulltexts to blame within the repository
+ *
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ */
+
+#include <apr_pools.h>
+
+#include "svn_pools.h"
+#include "svn_error.h"
+#include "svn_io.h"
+#include "svn_repos.h"
+
+#include "private/svn_repos_private.h"
+#include "svn_private_config.h"
+
+#include "repos.h"
+
+
+/* Baton used with file_rev_handler.  Lives for the whole operation. */
+typedef struct fulltexts_baton_t
+{
+  /* Revisions older than this one are not reported as such. */
+  svn_revnum_t start;
+
+  svn_repos__fulltext_func_t fulltext_func;
+  void *fulltext_baton;
+
+  /* Name of the file containing the last fulltext with content changes. */
+  const char *last_filename;
+
+  /* LAST_FILENAME lives in LASTPOOL, the current fulltext in CURRPOOL.
+     Both are subpools of the result pool. */
+  apr_pool_t *lastpool;
+  apr_pool_t *currpool;
+
+  svn_cancel_func_t cancel_func;
+  void *cancel_baton;
+} fulltexts_baton_t;
+
+/* Baton used by window_handler.  Allocated per revision. */
+typedef struct fulltext_delta_baton_t
+{
+  svn_txdelta_window_handler_t wrapped_handler;
+  void *wrapped_baton;
+  fulltexts_baton_t *fb;
+  svn_stream_t *source_stream;
+  const char *filename;
+  svn_revnum_t revision;
+  apr_hash_t *rev_props;
+} fulltext_delta_baton_t;
+
+
+/* Implements svn_txdelta_window_handler_t. */
+static svn_error_t *
+window_handler(svn_txdelta_window_t *window,
+               void *baton)
+{
+  fulltext_delta_baton_t *dbaton = baton;
+  fulltexts_baton_t *fb = dbaton->fb;
+  apr_pool_t *tmp_pool;
+
+  SVN_ERR(dbaton->wrapped_handler(window, dbaton->wrapped_baton));
+
+  /* We patiently wait for the NULL window marking the end. */
+  if (window)
+    return SVN_NO_ERROR;
+
+  /* Close the delta source early, so it can be removed on all platforms. */
+  if (dbaton->source_stream)
+    SVN_ERR(svn_stream_close(dbaton->source_stream));
+
+  SVN_ERR(fb->fulltext_func(fb->fulltext_baton, dbaton->revision,
+                            dbaton->rev_props, dbaton->filename,
+                            fb->currpool));
+
+  /* The current fulltext becomes the base for the next revision. */
+  fb->last_filename = dbaton->filename;
+  tmp_pool = fb->lastpool;
+  fb->lastpool = fb->currpool;
+  fb->currpool = tmp_pool;
+
+  return SVN_NO_ERROR;
+}
+
+/* Reconstruct the fulltext of each revision of the file with content
+   changes in a temporary file and pass it on.
+
+   Implements svn_file_rev_handler_t. */
+static svn_error_t *
+file_rev_handler(void *baton,
+                 const char *path,
+                 svn_revnum_t revnum,
+                 apr_hash_t *rev_props,
+                 svn_boolean_t merged_revision,
+                 svn_txdelta_window_handler_t *content_delta_handler,
+                 void **content_delta_baton,
+                 apr_array_header_t *prop_diffs,
+                 apr_pool_t *pool)
+{
+  fulltexts_baton_t *fb = baton;
+  fulltext_delta_baton_t *dbaton;
+  svn_stream_t *last_stream;
+  svn_stream_t *cur_stream;
+
+  if (fb->cancel_func)
+    SVN_ERR(fb->cancel_func(fb->cancel_baton));
+
+  /* Without content changes, the last fulltext remains valid.  Note that
+     we must not switch the pools in this case. */
+  if (!content_delta_handler)
+    return SVN_NO_ERROR;
+
+  svn_pool_clear(fb->currpool);
+  dbaton = apr_pcalloc(fb->currpool, sizeof(*dbaton));
+  dbaton->fb = fb;
+
+  if (fb->last_filename)
+    SVN_ERR(svn_stream_open_readonly(&dbaton->source_stream,
+                                     fb->last_filename,
+                                     fb->currpool, pool));
+  last_stream = svn_stream_disown(dbaton->source_stream, pool);
+
+  SVN_ERR(svn_stream_open_unique(&cur_stream, &dbaton->filename, NULL,
+                                 svn_io_file_del_on_pool_cleanup,
+                                 fb->currpool, pool));
+
+  /* The fulltext before START is only the base of what START changed. */
+  if (revnum >= fb->start)
+    {
+      dbaton->revision = revnum;
+      dbaton->rev_props = rev_props;
+    }
+  else
+    {
+      dbaton->revision = SVN_INVALID_REVNUM;
+    }
+
+  svn_txdelta_apply(last_stream, cur_stream, NULL, NULL, fb->currpool,
+                    &dbaton->wrapped_handler, &dbaton->wrapped_baton);
+  *content_delta_handler = window_handler;
+  *content_delta_baton = dbaton;
+
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_repos__get_blame_fulltexts(svn_repos_t *repos,
+                               const char *path,
+                               svn_revnum_t start,
+                               svn_revnum_t end,
+                               svn_repos_authz_func_t authz_read_func,
+                               void *authz_read_baton,
+                               svn_repos__fulltext_func_t fulltext_func,
+                               void *fulltext_baton,
+                               svn_cancel_func_t cancel_func,
+                               void *cancel_baton,
+                               apr_pool_t *result_pool,
+                               apr_pool_t *scratch_pool)
+{
+  fulltexts_baton_t fb = { 0 };
+
+  if (!SVN_IS_VALID_REVNUM(start) || !SVN_IS_VALID_REVNUM(end))
+    {
+      svn_revnum_t youngest_rev;
+      SVN_ERR(svn_fs_youngest_rev(&youngest_rev, repos->fs, scratch_pool));
+
+      if (!SVN_IS_VALID_REVNUM(start))
+        start = youngest_rev;
+      if (!SVN_IS_VALID_REVNUM(end))
+        end = youngest_rev;
+    }
+
+  if (start > end)
+    return svn_error_create(SVN_ERR_UNSUPPORTED_FEATURE, NULL,
+                            _("Reverse blame is not supported by the "
+                              "repository"));
+
+  fb.start = start;
+  fb.fulltext_func = fulltext_func;
+  fb.fulltext_baton = fulltext_baton;
+  fb.lastpool = svn_pool_create(result_pool);
+  fb.currpool = svn_pool_create(result_pool);
+  fb.cancel_func = cancel_func;
+  fb.cancel_baton = cancel_baton;
+
+  /* Start one revision early, so we know what START actually changed. */
+  SVN_ERR(svn_repos_get_file_revs2(repos, path, MAX(0, start - 1), end,
+                                   FALSE, authz_read_func, authz_read_baton,
+                                   file_rev_handler, &fb, scratch_pool));
+
+  /* Only the last fulltext, now in LASTPOOL, needs to stay around. */
+  svn_pool_destroy(fb.currpool);
+
+  return SVN_NO_ERROR;
+}
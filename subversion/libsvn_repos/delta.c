@@ -825,6 +825,55 @@ absent_file_or_dir(struct context *c,
 }
 
 
+/* Let the filesystems prefetch the nodes that delta_dirs() is going to
+   look at in context C: the entries of T_ENTRIES in TARGET_PATH that
+   differ from their counterparts in S_ENTRIES of SOURCE_PATH, as well as
+   those counterparts.  Directory listings are only worth fetching if we
+   are going to recurse, i.e. DEPTH is svn_depth_infinity.  Use POOL for
+   temporary allocations.  */
+static svn_error_t *
+prefetch_entries(struct context *c,
+                 svn_depth_t depth,
+                 const char *source_path,
+                 apr_hash_t *s_entries,
+                 const char *target_path,
+                 apr_hash_t *t_entries,
+                 apr_pool_t *pool)
+{
+  apr_array_header_t *s_paths
+    = apr_array_make(pool, apr_hash_count(t_entries), sizeof(const char *));
+  apr_array_header_t *t_paths
+    = apr_array_make(pool, apr_hash_count(t_entries), sizeof(const char *));
+  apr_hash_index_t *hi;
+
+  for (hi = apr_hash_first(pool, t_entries); hi; hi = apr_hash_next(hi))
+    {
+      const svn_fs_dirent_t *t_entry = apr_hash_this_val(hi);
+      const svn_fs_dirent_t *s_entry
+        = s_entries ? svn_hash_gets(s_entries, t_entry->name) : NULL;
+
+      /* Unchanged entries will not be looked at. */
+      if (s_entry && svn_fs_compare_ids(s_entry->id, t_entry->id) == 0)
+        continue;
+
+      APR_ARRAY_PUSH(t_paths, const char *)
+        = svn_relpath_join(target_path, t_entry->name, pool);
+      if (s_entry && s_entry->kind == t_entry->kind)
+        APR_ARRAY_PUSH(s_paths, const char *)
+          = svn_relpath_join(source_path, s_entry->name, pool);
+    }
+
+  if (t_paths->nelts > 1)
+    SVN_ERR(svn_fs_prefetch_nodes(c->target_root, t_paths,
+                                  depth == svn_depth_infinity, TRUE, pool));
+  if (s_paths->nelts > 1)
+    SVN_ERR(svn_fs_prefetch_nodes(c->source_root, s_paths,
+                                  depth == svn_depth_infinity, TRUE, pool));
+
+  return SVN_NO_ERROR;
+}
+
+
 /* Emit deltas to turn SOURCE_PATH into TARGET_PATH.  Assume that
    DIR_BATON represents the directory we're constructing to the editor
    in the context C.  */
@@ -857,6 +906,10 @@ delta_dirs(struct context *c,
   /* Make a subpool for local allocations. */
   subpool = svn_pool_create(pool);
 
+  /* Read the nodes to compare in one go rather than one by one. */
+  SVN_ERR(prefetch_entries(c, depth, source_path, s_entries, target_path,
+                           t_entries, subpool));
+
   /* Loop over the hash of entries in the target, searching for its
      partner in the source.  If we find the matching partner entry,
      use editor calls to replace the one in target with a new version
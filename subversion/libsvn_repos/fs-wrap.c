@@ -111,6 +111,13 @@ svn_repos_fs_commit_txn(const char **conflict_p,
       return err;
     }
 
+  /* Update the log index, if the repository has one.  Failing to do so
+     is not fatal; the index catches up the next time it gets used.  Don't
+     make this commit pay for a long backlog, though. */
+  svn_error_clear(svn_repos__log_index_sync(repos->fs, FALSE,
+                                            SVN_REPOS__LOG_INDEX_MAX_CATCHUP,
+                                            NULL, NULL, pool));
+
   /* Run post-commit hooks. */
   if ((err2 = svn_repos__hooks_post_commit(repos, hooks_env,
                                            *new_rev, txn_name, pool)))
@@ -948,6 +955,7 @@ svn_repos_fs_get_mergeinfo2(svn_repos_t *repos,
    * without first allocating a new array. */
   apr_array_header_t *readable_paths = (apr_array_header_t *) paths;
   svn_fs_root_t *root;
+  svn_repos__log_index_t *log_index = NULL;
   apr_pool_t *iterpool = svn_pool_create(scratch_pool);
 
   if (!SVN_IS_VALID_REVNUM(rev))
@@ -989,7 +997,35 @@ svn_repos_fs_get_mergeinfo2(svn_repos_t *repos,
      us to protect the name of where a change was merged from, but not
      the change itself. */
   /* ### TODO(reint): ... but how about descendant merged-to paths? */
-  if (readable_paths->nelts > 0)
+  if (readable_paths->nelts > 0 && include_descendants)
+    SVN_ERR(svn_repos__log_index_open(&log_index, repos->fs, rev,
+                                      scratch_pool, scratch_pool));
+
+  if (log_index)
+    {
+      int i;
+
+      /* The index knows the explicit mergeinfo of all descendants, so
+         we only need to ask the filesystem about the paths themselves. */
+      for (i = 0; i < readable_paths->nelts; i++)
+        {
+          const char *path = APR_ARRAY_IDX(readable_paths, i, const char *);
+          apr_array_header_t *single_path;
+
+          svn_pool_clear(iterpool);
+          single_path = apr_array_make(iterpool, 1, sizeof(const char *));
+          APR_ARRAY_PUSH(single_path, const char *) = path;
+
+          SVN_ERR(svn_fs_get_mergeinfo3(root, single_path, inherit,
+                                        FALSE, TRUE,
+                                        receiver, receiver_baton,
+                                        iterpool));
+          SVN_ERR(svn_repos__log_index_get_descendant_mergeinfo(
+                    log_index, path, rev, receiver, receiver_baton,
+                    iterpool));
+        }
+    }
+  else if (readable_paths->nelts > 0)
     SVN_ERR(svn_fs_get_mergeinfo3(root, readable_paths, inherit,
                                   include_descendants, TRUE,
                                   receiver, receiver_baton,
@@ -184,6 +184,8 @@ do_list(svn_fs_root_t *root,
   apr_pool_t *iterpool = svn_pool_create(scratch_pool);
   apr_hash_index_t *hi;
   apr_array_header_t *sorted;
+  apr_array_header_t *sub_paths;
+  svn_boolean_t *has_access;
   int i;
 
   /* Fetch all directory entries, filter and sort them.
@@ -219,6 +221,23 @@ do_list(svn_fs_root_t *root,
 
   svn_sort__array(sorted, compare_filtered_dirent);
 
+  /* Authorize all remaining entries at once, so that batch-capable authz
+   * implementations don't have to walk down to PATH for every entry. */
+  sub_paths = apr_array_make(scratch_pool, sorted->nelts,
+                             sizeof(const char *));
+  for (i = 0; i < sorted->nelts; ++i)
+    {
+      filtered_dirent_t *filtered = &APR_ARRAY_IDX(sorted, i,
+                                                   filtered_dirent_t);
+      APR_ARRAY_PUSH(sub_paths, const char *)
+        = svn_dirent_join(path, filtered->dirent->name, scratch_pool);
+    }
+
+  has_access = apr_palloc(scratch_pool, sorted->nelts * sizeof(*has_access));
+  SVN_ERR(svn_repos__authz_read_many(has_access, root, sub_paths,
+                                     authz_read_func, authz_read_baton,
+                                     scratch_pool));
+
   /* Iterate over all remaining directory entries and report them.
    * Recurse into sub-directories if requested. */
   for (i = 0; i < sorted->nelts; ++i)
@@ -233,15 +252,10 @@ do_list(svn_fs_root_t *root,
       dirent = filtered->dirent;
 
       /* Skip paths that we don't have access to? */
-      sub_path = svn_dirent_join(path, dirent->name, iterpool);
-      if (authz_read_func)
-        {
-          svn_boolean_t has_access;
-          SVN_ERR(authz_read_func(&has_access, root, sub_path,
-                                  authz_read_baton, iterpool));
-          if (!has_access)
-            continue;
-        }
+      if (!has_access[i])
+        continue;
+
+      sub_path = APR_ARRAY_IDX(sub_paths, i, const char *);
 
       /* Report entry, if it passed the filter. */
       if (filtered->is_match)
@@ -0,0 +1,165 @@
+/* log-index-db.sql -- schema of the repository log index
+ *   This is intended for use with SQLite 3
+ *
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ */
+
+-- STMT_CREATE_SCHEMA
+/* The changed paths of every indexed revision.  PATH is the repository
+   relpath of the changed node, ACTION is one of 'A'dded, 'D'eleted,
+   'R'eplaced or 'M'odified.  COPYFROM_PATH (a relpath) and COPYFROM_REV
+   are only set for copies. */
+CREATE TABLE changed_paths (
+  path TEXT NOT NULL,
+  revision INTEGER NOT NULL,
+  action TEXT NOT NULL,
+  copyfrom_path TEXT,
+  copyfrom_rev INTEGER,
+  PRIMARY KEY (path, revision)
+  );
+
+CREATE INDEX I_CHANGED_PATHS_REVISION ON changed_paths (revision);
+
+/* Single row describing the state of the index.  UUID is the uuid of the
+   repository the index was built for and YOUNGEST the youngest revision
+   whose changes are in CHANGED_PATHS. */
+CREATE TABLE log_index_info (
+  id INTEGER NOT NULL PRIMARY KEY,
+  uuid TEXT NOT NULL,
+  youngest INTEGER NOT NULL
+  );
+
+/* The svn:mergeinfo changes of every indexed revision, as determined by
+   svn_repos__get_mergeinfo_changes().  PATH is a repository relpath. */
+CREATE TABLE mergeinfo_changes (
+  revision INTEGER NOT NULL,
+  path TEXT NOT NULL,
+  prev_mergeinfo TEXT,
+  mergeinfo TEXT,
+  PRIMARY KEY (revision, path)
+  );
+
+/* The explicit svn:mergeinfo MERGEINFO of the repository relpath PATH,
+   valid from REVISION up to but not including END_REVISION.  END_REVISION
+   is NULL while the value is current. */
+CREATE TABLE explicit_mergeinfo (
+  path TEXT NOT NULL,
+  revision INTEGER NOT NULL,
+  end_revision INTEGER,
+  mergeinfo TEXT NOT NULL,
+  PRIMARY KEY (path, revision)
+  );
+
+PRAGMA USER_VERSION = 2;
+
+-- STMT_DROP_SCHEMA
+/* Indexes of older formats are simply rebuilt from scratch. */
+DROP TABLE IF EXISTS changed_paths;
+DROP TABLE IF EXISTS log_index_info;
+DROP TABLE IF EXISTS mergeinfo_changes;
+DROP TABLE IF EXISTS explicit_mergeinfo;
+
+-- STMT_GET_INFO
+SELECT uuid, youngest
+FROM log_index_info
+WHERE id = 0
+
+-- STMT_SET_INFO
+INSERT OR REPLACE INTO log_index_info (id, uuid, youngest)
+VALUES (0, ?1, ?2)
+
+-- STMT_INSERT_CHANGE
+INSERT OR REPLACE INTO changed_paths (path, revision, action,
+                                      copyfrom_path, copyfrom_rev)
+VALUES (?1, ?2, ?3, ?4, ?5)
+
+-- STMT_DELETE_ALL_CHANGES
+DELETE FROM changed_paths;
+DELETE FROM mergeinfo_changes;
+DELETE FROM explicit_mergeinfo;
+
+-- STMT_SELECT_ADD_AT
+/* The addition or replacement of ?1 in exactly revision ?2. */
+SELECT copyfrom_path, copyfrom_rev
+FROM changed_paths
+WHERE path = ?1 AND revision = ?2 AND action IN ('A', 'R')
+
+-- STMT_SELECT_YOUNGEST_ADD
+/* The youngest addition or replacement of ?1 at or before revision ?2. */
+SELECT MAX(revision)
+FROM changed_paths
+WHERE path = ?1 AND revision <= ?2 AND action IN ('A', 'R')
+
+-- STMT_SELECT_YOUNGEST_CHANGE
+/* The youngest change to ?1 or any of its descendants at or before
+   revision ?2. */
+SELECT MAX(revision)
+FROM changed_paths
+WHERE (path = ?1 OR IS_STRICT_DESCENDANT_OF(path, ?1))
+  AND revision <= ?2
+
+-- STMT_INSERT_MERGEINFO_CHANGE
+INSERT OR REPLACE INTO mergeinfo_changes (revision, path,
+                                          prev_mergeinfo, mergeinfo)
+VALUES (?1, ?2, ?3, ?4)
+
+-- STMT_SELECT_MERGEINFO_CHANGES
+SELECT path, prev_mergeinfo, mergeinfo
+FROM mergeinfo_changes
+WHERE revision = ?1
+
+-- STMT_INSERT_EXPLICIT_MERGEINFO
+INSERT OR REPLACE INTO explicit_mergeinfo (path, revision, end_revision,
+                                           mergeinfo)
+VALUES (?1, ?2, NULL, ?3)
+
+-- STMT_CLOSE_EXPLICIT_MERGEINFO
+/* Mark the current explicit mergeinfo of ?1 as ending in revision ?2. */
+UPDATE explicit_mergeinfo SET end_revision = ?2
+WHERE path = ?1 AND end_revision IS NULL
+
+-- STMT_CLOSE_EXPLICIT_MERGEINFO_RECURSIVE
+/* Like STMT_CLOSE_EXPLICIT_MERGEINFO, but for ?1 and all its descendants. */
+UPDATE explicit_mergeinfo SET end_revision = ?2
+WHERE (path = ?1 OR IS_STRICT_DESCENDANT_OF(path, ?1))
+  AND end_revision IS NULL
+
+-- STMT_COPY_EXPLICIT_MERGEINFO
+/* Copy the explicit mergeinfo of ?1 and its descendants as of revision ?2
+   to ?3, starting in revision ?4. */
+INSERT OR REPLACE INTO explicit_mergeinfo (path, revision, end_revision,
+                                           mergeinfo)
+SELECT CASE WHEN path = ?1 THEN ?3
+            WHEN ?1 = '' THEN ?3 || '/' || path
+            ELSE ?3 || SUBSTR(path, LENGTH(?1) + 1) END,
+       ?4, NULL, mergeinfo
+FROM explicit_mergeinfo
+WHERE (path = ?1 OR IS_STRICT_DESCENDANT_OF(path, ?1))
+  AND revision <= ?2
+  AND (end_revision IS NULL OR end_revision > ?2)
+
+-- STMT_SELECT_DESCENDANT_EXPLICIT_MERGEINFO
+/* The explicit mergeinfo of all strict descendants of ?1 in revision ?2. */
+SELECT path, mergeinfo
+FROM explicit_mergeinfo
+WHERE IS_STRICT_DESCENDANT_OF(path, ?1)
+  AND revision <= ?2
+  AND (end_revision IS NULL OR end_revision > ?2)
+ORDER BY path
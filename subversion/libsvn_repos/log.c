@@ -56,6 +56,9 @@ typedef struct log_callbacks_t
   void *revision_receiver_baton;
   svn_repos_authz_func_t authz_read_func;
   void *authz_read_baton;
+
+  /* The repository's log index, if it has a usable one.  May be NULL. */
+  svn_repos__log_index_t *log_index;
 } log_callbacks_t;
 
 
@@ -110,6 +113,120 @@ svn_repos_log_entry_dup(const svn_repos_log_entry_t *log_entry,
   return new_entry;
 }
 
+/* Iterates over the changed paths of a revision together with their
+ * readability.  Batch-capable authz callbacks get to check all changed
+ * paths at once, which requires the list of changes to be read up-front.
+ * Other callbacks get invoked once per change while iterating.
+ */
+typedef struct change_reader_t
+{
+  /* Root of the revision whose changes we report. */
+  svn_fs_root_t *root;
+
+  /* Source of the changes. */
+  svn_fs_path_change_iterator_t *iterator;
+
+  /* Changes (svn_fs_path_change3_t *) and their readability, if they
+   * have been read up-front.  NULL otherwise. */
+  apr_array_header_t *changes;
+  svn_boolean_t *readable;
+
+  /* Index of the next element in CHANGES to return. */
+  int next;
+
+  /* Optional authz callback and baton. */
+  svn_repos_authz_func_t authz_read_func;
+  void *authz_read_baton;
+} change_reader_t;
+
+/* Set *READER to a new change reader for the changes in ROOT, checking
+ * their readability with the optional AUTHZ_READ_FUNC and AUTHZ_READ_BATON.
+ * Allocate the result in RESULT_POOL and use SCRATCH_POOL for temporaries.
+ */
+static svn_error_t *
+open_change_reader(change_reader_t **reader,
+                   svn_fs_root_t *root,
+                   svn_repos_authz_func_t authz_read_func,
+                   void *authz_read_baton,
+                   apr_pool_t *result_pool,
+                   apr_pool_t *scratch_pool)
+{
+  change_reader_t *result = apr_pcalloc(result_pool, sizeof(*result));
+  result->root = root;
+  result->authz_read_func = authz_read_func;
+  result->authz_read_baton = authz_read_baton;
+
+  SVN_ERR(svn_fs_paths_changed3(&result->iterator, root, result_pool,
+                                scratch_pool));
+
+  if (svn_repos__authz_read_is_batched(authz_read_func))
+    {
+      apr_array_header_t *paths = apr_array_make(scratch_pool, 16,
+                                                 sizeof(const char *));
+      svn_fs_path_change3_t *change;
+
+      result->changes = apr_array_make(result_pool, 16,
+                                       sizeof(svn_fs_path_change3_t *));
+
+      SVN_ERR(svn_fs_path_change_get(&change, result->iterator));
+      while (change)
+        {
+          change = svn_fs_path_change3_dup(change, result_pool);
+          APR_ARRAY_PUSH(result->changes, svn_fs_path_change3_t *) = change;
+          APR_ARRAY_PUSH(paths, const char *) = change->path.data;
+
+          SVN_ERR(svn_fs_path_change_get(&change, result->iterator));
+        }
+
+      result->readable = apr_palloc(result_pool,
+                                    paths->nelts * sizeof(*result->readable));
+      SVN_ERR(svn_repos__authz_read_many(result->readable, root, paths,
+                                         authz_read_func, authz_read_baton,
+                                         scratch_pool));
+    }
+
+  *reader = result;
+  return SVN_NO_ERROR;
+}
+
+/* Set *CHANGE to the next change provided by READER and *READABLE to
+ * whether its path is readable.  Set *CHANGE to NULL at the end of the
+ * list.  Use SCRATCH_POOL for temporary allocations.
+ */
+static svn_error_t *
+read_change(svn_fs_path_change3_t **change,
+            svn_boolean_t *readable,
+            change_reader_t *reader,
+            apr_pool_t *scratch_pool)
+{
+  if (reader->changes)
+    {
+      if (reader->next < reader->changes->nelts)
+        {
+          *change = APR_ARRAY_IDX(reader->changes, reader->next,
+                                  svn_fs_path_change3_t *);
+          *readable = reader->readable[reader->next];
+          ++reader->next;
+        }
+      else
+        {
+          *change = NULL;
+        }
+
+      return SVN_NO_ERROR;
+    }
+
+  SVN_ERR(svn_fs_path_change_get(change, reader->iterator));
+
+  *readable = TRUE;
+  if (*change && reader->authz_read_func)
+    SVN_ERR(reader->authz_read_func(readable, reader->root,
+                                    (*change)->path.data,
+                                    reader->authz_read_baton, scratch_pool));
+
+  return SVN_NO_ERROR;
+}
+
 svn_error_t *
 svn_repos_check_revision_access(svn_repos_revision_access_level_t *access_level,
                                 svn_repos_t *repos,
@@ -120,8 +237,9 @@ svn_repos_check_revision_access(svn_repos_revision_access_level_t *access_level,
 {
   svn_fs_t *fs = svn_repos_fs(repos);
   svn_fs_root_t *rev_root;
-  svn_fs_path_change_iterator_t *iterator;
+  change_reader_t *reader;
   svn_fs_path_change3_t *change;
+  svn_boolean_t readable;
   svn_boolean_t found_readable = FALSE;
   svn_boolean_t found_unreadable = FALSE;
   apr_pool_t *iterpool;
@@ -135,8 +253,9 @@ svn_repos_check_revision_access(svn_repos_revision_access_level_t *access_level,
 
   /* Fetch the changes associated with REVISION. */
   SVN_ERR(svn_fs_revision_root(&rev_root, fs, revision, pool));
-  SVN_ERR(svn_fs_paths_changed3(&iterator, rev_root, pool, pool));
-  SVN_ERR(svn_fs_path_change_get(&change, iterator));
+  SVN_ERR(open_change_reader(&reader, rev_root, authz_read_func,
+                             authz_read_baton, pool, pool));
+  SVN_ERR(read_change(&change, &readable, reader, pool));
 
   /* No changed paths?  We're done.
 
@@ -150,12 +269,8 @@ svn_repos_check_revision_access(svn_repos_revision_access_level_t *access_level,
   iterpool = svn_pool_create(pool);
   while (change)
     {
-      svn_boolean_t readable;
-
       svn_pool_clear(iterpool);
 
-      SVN_ERR(authz_read_func(&readable, rev_root, change->path.data,
-                              authz_read_baton, iterpool));
       if (! readable)
         found_unreadable = TRUE;
       else
@@ -202,7 +317,7 @@ svn_repos_check_revision_access(svn_repos_revision_access_level_t *access_level,
           break;
         }
 
-      SVN_ERR(svn_fs_path_change_get(&change, iterator));
+      SVN_ERR(read_change(&change, &readable, reader, iterpool));
     }
 
  decision:
@@ -251,15 +366,18 @@ detect_changed(svn_repos_revision_access_level_t *access_level,
                const log_callbacks_t *callbacks,
                apr_pool_t *scratch_pool)
 {
-  svn_fs_path_change_iterator_t *iterator;
+  change_reader_t *reader;
   svn_fs_path_change3_t *change;
+  svn_boolean_t readable;
   apr_pool_t *iterpool;
   svn_boolean_t found_readable = FALSE;
   svn_boolean_t found_unreadable = FALSE;
 
   /* Retrieve the first change in the list. */
-  SVN_ERR(svn_fs_paths_changed3(&iterator, root, scratch_pool, scratch_pool));
-  SVN_ERR(svn_fs_path_change_get(&change, iterator));
+  SVN_ERR(open_change_reader(&reader, root, callbacks->authz_read_func,
+                             callbacks->authz_read_baton, scratch_pool,
+                             scratch_pool));
+  SVN_ERR(read_change(&change, &readable, reader, scratch_pool));
 
   if (!change)
     {
@@ -279,18 +397,11 @@ detect_changed(svn_repos_revision_access_level_t *access_level,
       svn_pool_clear(iterpool);
 
       /* Skip path if unreadable. */
-      if (callbacks->authz_read_func)
+      if (! readable)
         {
-          svn_boolean_t readable;
-          SVN_ERR(callbacks->authz_read_func(&readable, root, path,
-                                             callbacks->authz_read_baton,
-                                             iterpool));
-          if (! readable)
-            {
-              found_unreadable = TRUE;
-              SVN_ERR(svn_fs_path_change_get(&change, iterator));
-              continue;
-            }
+          found_unreadable = TRUE;
+          SVN_ERR(read_change(&change, &readable, reader, iterpool));
+          continue;
         }
 
       /* At least one changed-path was readable. */
@@ -384,7 +495,7 @@ detect_changed(svn_repos_revision_access_level_t *access_level,
                                      iterpool));
 
       /* Next changed path. */
-      SVN_ERR(svn_fs_path_change_get(&change, iterator));
+      SVN_ERR(read_change(&change, &readable, reader, iterpool));
     }
 
   svn_pool_destroy(iterpool);
@@ -421,6 +532,10 @@ struct path_info
   svn_boolean_t done;
   svn_boolean_t first_time;
 
+  /* If not NULL, we look up the history in this index instead of asking
+     the filesystem, and HIST, NEWPOOL and OLDPOOL below will be NULL. */
+  svn_repos__log_index_t *log_index;
+
   /* If possible, we like to keep open the history object for each path,
      since it avoids needed to open and close it many times as we walk
      backwards in time.  To do so we need two pools, so that we can clear
@@ -433,8 +548,9 @@ struct path_info
 
 /* Advance to the next history for the path.
  *
- * If INFO->HIST is not NULL we do this using that existing history object,
- * otherwise we open a new one.
+ * If INFO->LOG_INDEX is not NULL we look the history up in that index.
+ * Otherwise, if INFO->HIST is not NULL we do this using that existing
+ * history object, otherwise we open a new one.
  *
  * If no more history is available or the history revision is less
  * (earlier) than START, or the history is not available due
@@ -462,6 +578,53 @@ get_history(struct path_info *info,
   apr_pool_t *subpool;
   const char *path;
 
+  if (info->log_index)
+    {
+      if (info->first_time)
+        {
+          /* The index does not know whether the path exists at all.  Let
+             the filesystem tell us in the usual way. */
+          SVN_ERR(svn_fs_revision_root(&history_root, fs, info->history_rev,
+                                       scratch_pool));
+          SVN_ERR(svn_fs_node_history2(&hist, history_root, info->path->data,
+                                       scratch_pool, scratch_pool));
+        }
+
+      SVN_ERR(svn_repos__log_index_history_prev(&path, &info->history_rev,
+                                                info->log_index,
+                                                info->path->data,
+                                                info->history_rev,
+                                                info->first_time, ! strict,
+                                                scratch_pool, scratch_pool));
+      info->first_time = FALSE;
+
+      /* Stop if there is no more history or if it predates START. */
+      if (! path || info->history_rev < start)
+        {
+          info->done = TRUE;
+          return SVN_NO_ERROR;
+        }
+
+      svn_stringbuf_set(info->path, path);
+
+      /* Is the history item readable?  If not, done with path. */
+      if (authz_read_func)
+        {
+          svn_boolean_t readable;
+          SVN_ERR(svn_fs_revision_root(&history_root, fs,
+                                       info->history_rev,
+                                       scratch_pool));
+          SVN_ERR(authz_read_func(&readable, history_root,
+                                  info->path->data,
+                                  authz_read_baton,
+                                  scratch_pool));
+          if (! readable)
+            info->done = TRUE;
+        }
+
+      return SVN_NO_ERROR;
+    }
+
   if (info->hist)
     {
       subpool = info->newpool;
@@ -609,18 +772,12 @@ next_history_rev(const apr_array_header_t *histories)
   return next_rev;
 }
 
-/* Set *DELETED_MERGEINFO_CATALOG and *ADDED_MERGEINFO_CATALOG to
-   catalogs describing how mergeinfo values on paths (which are the
-   keys of those catalogs) were changed in REV. */
-/* ### TODO: This would make a *great*, useful public function,
-   ### svn_repos_fs_mergeinfo_changed()!  -- cmpilato  */
-static svn_error_t *
-fs_mergeinfo_changed(svn_mergeinfo_catalog_t *deleted_mergeinfo_catalog,
-                     svn_mergeinfo_catalog_t *added_mergeinfo_catalog,
-                     svn_fs_t *fs,
-                     svn_revnum_t rev,
-                     apr_pool_t *result_pool,
-                     apr_pool_t *scratch_pool)
+svn_error_t *
+svn_repos__get_mergeinfo_changes(apr_array_header_t **changes,
+                                 svn_fs_t *fs,
+                                 svn_revnum_t rev,
+                                 apr_pool_t *result_pool,
+                                 apr_pool_t *scratch_pool)
 {
   svn_fs_root_t *root;
   apr_pool_t *iterpool, *iterator_pool;
@@ -629,9 +786,9 @@ fs_mergeinfo_changed(svn_mergeinfo_catalog_t *deleted_mergeinfo_catalog,
   svn_boolean_t any_mergeinfo = FALSE;
   svn_boolean_t any_copy = FALSE;
 
-  /* Initialize return variables. */
-  *deleted_mergeinfo_catalog = svn_hash__make(result_pool);
-  *added_mergeinfo_catalog = svn_hash__make(result_pool);
+  /* Initialize return variable. */
+  *changes = apr_array_make(result_pool, 0,
+                            sizeof(svn_repos__mergeinfo_change_t *));
 
   /* Revision 0 has no mergeinfo and no mergeinfo changes. */
   if (rev == 0)
@@ -843,28 +1000,23 @@ fs_mergeinfo_changed(svn_mergeinfo_catalog_t *deleted_mergeinfo_catalog,
 
       /* Old and new mergeinfo probably differ in some way (we already
          checked for textual equality further up). Store the before and
-         after mergeinfo values in our return hashes.  They may still be
+         after mergeinfo values in our return array.  They may still be
          equal as manual intervention may have only changed the formatting
          but not the relevant contents. */
         {
-          svn_mergeinfo_t prev_mergeinfo = NULL, mergeinfo = NULL;
-          svn_mergeinfo_t deleted, added;
-          const char *hash_path;
+          svn_repos__mergeinfo_change_t *mergeinfo_change
+            = apr_pcalloc(result_pool, sizeof(*mergeinfo_change));
 
-          if (mergeinfo_value)
-            SVN_ERR(svn_mergeinfo_parse(&mergeinfo,
-                                        mergeinfo_value->data, iterpool));
+          mergeinfo_change->path = apr_pstrdup(result_pool, changed_path);
           if (prev_mergeinfo_value)
-            SVN_ERR(svn_mergeinfo_parse(&prev_mergeinfo,
-                                        prev_mergeinfo_value->data, iterpool));
-          SVN_ERR(svn_mergeinfo_diff2(&deleted, &added, prev_mergeinfo,
-                                      mergeinfo, FALSE, result_pool,
-                                      iterpool));
-
-          /* Toss interesting stuff into our return catalogs. */
-          hash_path = apr_pstrdup(result_pool, changed_path);
-          svn_hash_sets(*deleted_mergeinfo_catalog, hash_path, deleted);
-          svn_hash_sets(*added_mergeinfo_catalog, hash_path, added);
+            mergeinfo_change->prev_mergeinfo
+              = svn_string_dup(prev_mergeinfo_value, result_pool);
+          if (mergeinfo_value)
+            mergeinfo_change->mergeinfo
+              = svn_string_dup(mergeinfo_value, result_pool);
+
+          APR_ARRAY_PUSH(*changes, svn_repos__mergeinfo_change_t *)
+            = mergeinfo_change;
         }
     }
 
@@ -874,14 +1026,78 @@ fs_mergeinfo_changed(svn_mergeinfo_catalog_t *deleted_mergeinfo_catalog,
   return SVN_NO_ERROR;
 }
 
+/* Set *DELETED_MERGEINFO_CATALOG and *ADDED_MERGEINFO_CATALOG to
+   catalogs describing how mergeinfo values on paths (which are the
+   keys of those catalogs) were changed in REV.  Look the changes up in
+   LOG_INDEX, unless that is NULL. */
+/* ### TODO: This would make a *great*, useful public function,
+   ### svn_repos_fs_mergeinfo_changed()!  -- cmpilato  */
+static svn_error_t *
+fs_mergeinfo_changed(svn_mergeinfo_catalog_t *deleted_mergeinfo_catalog,
+                     svn_mergeinfo_catalog_t *added_mergeinfo_catalog,
+                     svn_fs_t *fs,
+                     svn_repos__log_index_t *log_index,
+                     svn_revnum_t rev,
+                     apr_pool_t *result_pool,
+                     apr_pool_t *scratch_pool)
+{
+  apr_array_header_t *changes;
+  apr_pool_t *iterpool;
+  int i;
+
+  /* Initialize return variables. */
+  *deleted_mergeinfo_catalog = svn_hash__make(result_pool);
+  *added_mergeinfo_catalog = svn_hash__make(result_pool);
+
+  if (log_index)
+    SVN_ERR(svn_repos__log_index_get_mergeinfo_changes(&changes, log_index,
+                                                       rev, scratch_pool,
+                                                       scratch_pool));
+  else
+    SVN_ERR(svn_repos__get_mergeinfo_changes(&changes, fs, rev,
+                                             scratch_pool, scratch_pool));
+
+  iterpool = svn_pool_create(scratch_pool);
+  for (i = 0; i < changes->nelts; i++)
+    {
+      svn_repos__mergeinfo_change_t *change
+        = APR_ARRAY_IDX(changes, i, svn_repos__mergeinfo_change_t *);
+      svn_mergeinfo_t prev_mergeinfo = NULL, mergeinfo = NULL;
+      svn_mergeinfo_t deleted, added;
+      const char *hash_path;
+
+      svn_pool_clear(iterpool);
+
+      if (change->mergeinfo)
+        SVN_ERR(svn_mergeinfo_parse(&mergeinfo,
+                                    change->mergeinfo->data, iterpool));
+      if (change->prev_mergeinfo)
+        SVN_ERR(svn_mergeinfo_parse(&prev_mergeinfo,
+                                    change->prev_mergeinfo->data, iterpool));
+      SVN_ERR(svn_mergeinfo_diff2(&deleted, &added, prev_mergeinfo,
+                                  mergeinfo, FALSE, result_pool,
+                                  iterpool));
+
+      /* Toss interesting stuff into our return catalogs. */
+      hash_path = apr_pstrdup(result_pool, change->path);
+      svn_hash_sets(*deleted_mergeinfo_catalog, hash_path, deleted);
+      svn_hash_sets(*added_mergeinfo_catalog, hash_path, added);
+    }
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
+
 
 /* Determine what (if any) mergeinfo for PATHS was modified in
    revision REV, returning the differences for added mergeinfo in
-   *ADDED_MERGEINFO and deleted mergeinfo in *DELETED_MERGEINFO. */
+   *ADDED_MERGEINFO and deleted mergeinfo in *DELETED_MERGEINFO.
+   Use LOG_INDEX, if not NULL, to find the changes. */
 static svn_error_t *
 get_combined_mergeinfo_changes(svn_mergeinfo_t *added_mergeinfo,
                                svn_mergeinfo_t *deleted_mergeinfo,
                                svn_fs_t *fs,
+                               svn_repos__log_index_t *log_index,
                                const apr_array_header_t *paths,
                                svn_revnum_t rev,
                                apr_pool_t *result_pool,
@@ -909,7 +1125,7 @@ get_combined_mergeinfo_changes(svn_mergeinfo_t *added_mergeinfo,
   /* Fetch the mergeinfo changes for REV. */
   err = fs_mergeinfo_changed(&deleted_mergeinfo_catalog,
                              &added_mergeinfo_catalog,
-                             fs, rev,
+                             fs, log_index, rev,
                              scratch_pool, scratch_pool);
   if (err)
     {
@@ -1390,7 +1606,9 @@ send_log(svn_revnum_t rev,
 /* Get the histories for PATHS, and store them in *HISTORIES.
 
    If IGNORE_MISSING_LOCATIONS is set, don't treat requests for bogus
-   repository locations as fatal -- just ignore them.  */
+   repository locations as fatal -- just ignore them.
+
+   If LOG_INDEX is not NULL, walk the histories using that index.  */
 static svn_error_t *
 get_path_histories(apr_array_header_t **histories,
                    svn_fs_t *fs,
@@ -1401,6 +1619,7 @@ get_path_histories(apr_array_header_t **histories,
                    svn_boolean_t ignore_missing_locations,
                    svn_repos_authz_func_t authz_read_func,
                    void *authz_read_baton,
+                   svn_repos__log_index_t *log_index,
                    apr_pool_t *pool)
 {
   svn_fs_root_t *root;
@@ -1442,8 +1661,9 @@ get_path_histories(apr_array_header_t **histories,
       info->done = FALSE;
       info->history_rev = hist_end;
       info->first_time = TRUE;
+      info->log_index = log_index;
 
-      if (i < MAX_OPEN_HISTORIES)
+      if (i < MAX_OPEN_HISTORIES && ! log_index)
         {
           err = svn_fs_node_history2(&info->hist, root, this_path, pool,
                                      iterpool);
@@ -2015,7 +2235,8 @@ do_logs(svn_fs_t *fs,
   SVN_ERR(get_path_histories(&histories, fs, paths, hist_start, hist_end,
                              strict_node_history, ignore_missing_locations,
                              callbacks->authz_read_func,
-                             callbacks->authz_read_baton, pool));
+                             callbacks->authz_read_baton,
+                             callbacks->log_index, pool));
 
   /* Loop through all the revisions in the range and add any
      where a path was changed to the array, or if they wanted
@@ -2075,7 +2296,9 @@ do_logs(svn_fs_t *fs,
                 }
               SVN_ERR(get_combined_mergeinfo_changes(&added_mergeinfo,
                                                      &deleted_mergeinfo,
-                                                     fs, cur_paths,
+                                                     fs,
+                                                     callbacks->log_index,
+                                                     cur_paths,
                                                      current,
                                                      iterpool, iterpool));
               has_children = (apr_hash_count(added_mergeinfo) > 0
@@ -2332,6 +2555,7 @@ svn_repos_get_logs5(svn_repos_t *repos,
   callbacks.revision_receiver_baton = revision_receiver_baton;
   callbacks.authz_read_func = authz_read_func;
   callbacks.authz_read_baton = authz_read_baton;
+  callbacks.log_index = NULL;
 
   if (revprops)
     {
@@ -2443,6 +2667,10 @@ svn_repos_get_logs5(svn_repos_t *repos,
       return SVN_NO_ERROR;
     }
 
+  /* Walk the paths' histories using the log index, if there is one. */
+  SVN_ERR(svn_repos__log_index_open(&callbacks.log_index, fs, end,
+                                    scratch_pool, scratch_pool));
+
   /* If we are including merged revisions, then create mergeinfo that
      represents all of PATHS' history between START and END.  We will use
      this later to squelch duplicate log revisions that might exist in
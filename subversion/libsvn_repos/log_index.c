@@ -0,0 +1,845 @@
+/* log_index.c --- the repository log index
+ *
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ */
+
+/* The log index records the changed paths of every revision in an SQLite
+ * database next to the filesystem.  That allows us to find the previous
+ * interesting revision of a node with a few indexed lookups instead of
+ * walking the node-revision chain through the filesystem, which is what
+ * makes path-restricted 'svn log' and 'svnlook history' slow on large
+ * repositories.
+ *
+ * Alongside, it keeps the svn:mergeinfo changes of every revision for
+ * 'svn log -g' and the lifetime of every explicit svn:mergeinfo value,
+ * so that the mergeinfo of a whole subtree can be found without crawling
+ * that subtree.
+ *
+ * The index is optional.  It only exists after it has been created with
+ * svn_repos__log_index_sync(), e.g. by 'svnadmin build-log-index'.  From
+ * then on, it is updated after each commit and, should that ever fail,
+ * brought up to date the next time it is being used.
+ */
+
+#include <string.h>
+
+#include "svn_pools.h"
+#include "svn_dirent_uri.h"
+#include "svn_fs.h"
+#include "svn_io.h"
+#include "svn_path.h"
+#include "svn_props.h"
+#include "svn_mergeinfo.h"
+#include "svn_sorts.h"
+
+#include "private/svn_fspath.h"
+#include "private/svn_repos_private.h"
+#include "private/svn_sorts_private.h"
+#include "private/svn_sqlite.h"
+
+#include "svn_private_config.h"
+
+#include "repos.h"
+#include "log-index-db.h"
+
+LOG_INDEX_DB_SQL_DECLARE_STATEMENTS(statements);
+
+/* Name of the log index database within the filesystem directory. */
+#define LOG_INDEX_DB_NAME "log-index.db"
+
+/* The current schema version, see PRAGMA USER_VERSION in
+ * log-index-db.sql. */
+#define LOG_INDEX_SCHEMA_FORMAT 2
+
+/* Maximum number of revisions to index within a single SQLite
+ * transaction.  This keeps the write lock short while building the index
+ * for a large repository. */
+#define REVISIONS_PER_TXN 1000
+
+struct svn_repos__log_index_t
+{
+  svn_sqlite__db_t *sdb;
+};
+
+
+/** Helper functions. **/
+
+/* Create the schema of SDB unless it is current.  Drop any tables of an
+ * older schema.  Must be called within an SQLite transaction. */
+static svn_error_t *
+create_schema(svn_sqlite__db_t *sdb,
+              apr_pool_t *scratch_pool)
+{
+  int version;
+
+  /* Another process may have done it before we got the lock. */
+  SVN_ERR(svn_sqlite__read_schema_version(&version, sdb, scratch_pool));
+  if (version >= LOG_INDEX_SCHEMA_FORMAT)
+    return SVN_NO_ERROR;
+
+  if (version > 0)
+    SVN_ERR(svn_sqlite__exec_statements(sdb, STMT_DROP_SCHEMA));
+
+  return svn_error_trace(svn_sqlite__exec_statements(sdb,
+                                                     STMT_CREATE_SCHEMA));
+}
+
+/* Open the log index database of FS in *SDB, allocated in RESULT_POOL.
+ * If the database does not exist, create it if CREATE is set, otherwise
+ * set *SDB to NULL. */
+static svn_error_t *
+open_db(svn_sqlite__db_t **sdb,
+        svn_fs_t *fs,
+        svn_boolean_t create,
+        apr_pool_t *result_pool,
+        apr_pool_t *scratch_pool)
+{
+  const char *db_path = svn_dirent_join(svn_fs_path(fs, scratch_pool),
+                                        LOG_INDEX_DB_NAME, scratch_pool);
+  int version;
+
+  if (! create)
+    {
+      svn_node_kind_t kind;
+
+      SVN_ERR(svn_io_check_path(db_path, &kind, scratch_pool));
+      if (kind != svn_node_file)
+        {
+          *sdb = NULL;
+          return SVN_NO_ERROR;
+        }
+    }
+
+  SVN_ERR(svn_sqlite__open(sdb, db_path, svn_sqlite__mode_rwcreate,
+                           statements, 0, NULL, 0,
+                           result_pool, scratch_pool));
+
+  SVN_SQLITE__ERR_CLOSE(svn_sqlite__read_schema_version(&version, *sdb,
+                                                        scratch_pool),
+                        *sdb);
+
+  /* If we have an uninitialized or outdated database, go ahead and
+     create the schema. */
+  if (version < LOG_INDEX_SCHEMA_FORMAT)
+    {
+      svn_error_t *err;
+
+      err = svn_sqlite__begin_immediate_transaction(*sdb);
+      if (!err)
+        err = svn_sqlite__finish_transaction(*sdb, create_schema(*sdb,
+                                                                 scratch_pool));
+      SVN_SQLITE__ERR_CLOSE(err, *sdb);
+    }
+
+  return SVN_NO_ERROR;
+}
+
+/* Set *UUID and *YOUNGEST to the repository uuid and the youngest revision
+ * recorded in SDB.  If the index is still empty, set *UUID to NULL and
+ * *YOUNGEST to 0. */
+static svn_error_t *
+get_info(const char **uuid,
+         svn_revnum_t *youngest,
+         svn_sqlite__db_t *sdb,
+         apr_pool_t *result_pool)
+{
+  svn_sqlite__stmt_t *stmt;
+  svn_boolean_t have_row;
+
+  SVN_ERR(svn_sqlite__get_statement(&stmt, sdb, STMT_GET_INFO));
+  SVN_ERR(svn_sqlite__step(&have_row, stmt));
+  if (have_row)
+    {
+      *uuid = svn_sqlite__column_text(stmt, 0, result_pool);
+      *youngest = svn_sqlite__column_revnum(stmt, 1);
+    }
+  else
+    {
+      *uuid = NULL;
+      *youngest = 0;
+    }
+
+  return svn_error_trace(svn_sqlite__reset(stmt));
+}
+
+/* Sort svn_fs_path_change3_t * by path, parents before their children. */
+static int
+compare_changes(const void *a,
+                const void *b)
+{
+  const svn_fs_path_change3_t *change_a = *(svn_fs_path_change3_t *const *)a;
+  const svn_fs_path_change3_t *change_b = *(svn_fs_path_change3_t *const *)b;
+
+  return strcmp(change_a->path.data, change_b->path.data);
+}
+
+/* Update the explicit mergeinfo in SDB for CHANGE, which happened in
+ * REVISION under ROOT.  If CHANGE is a copy, COPYFROM_RELPATH and
+ * COPYFROM_REV describe its source.  Changes to parents must have been
+ * recorded before those to their children. */
+static svn_error_t *
+index_explicit_mergeinfo(svn_sqlite__db_t *sdb,
+                         svn_fs_root_t *root,
+                         svn_revnum_t revision,
+                         const svn_fs_path_change3_t *change,
+                         const char *relpath,
+                         const char *copyfrom_relpath,
+                         svn_revnum_t copyfrom_rev,
+                         apr_pool_t *scratch_pool)
+{
+  svn_sqlite__stmt_t *stmt;
+
+  /* Whatever had mergeinfo at or below a deleted or replaced path is
+     gone now. */
+  if (   change->change_kind == svn_fs_path_change_delete
+      || change->change_kind == svn_fs_path_change_replace)
+    {
+      SVN_ERR(svn_sqlite__get_statement(&stmt, sdb,
+                                        STMT_CLOSE_EXPLICIT_MERGEINFO_RECURSIVE));
+      SVN_ERR(svn_sqlite__bindf(stmt, "sr", relpath, revision));
+      SVN_ERR(svn_sqlite__update(NULL, stmt));
+    }
+
+  /* Copies bring the explicit mergeinfo of the whole source tree along. */
+  if (copyfrom_relpath)
+    {
+      SVN_ERR(svn_sqlite__get_statement(&stmt, sdb,
+                                        STMT_COPY_EXPLICIT_MERGEINFO));
+      SVN_ERR(svn_sqlite__bindf(stmt, "srsr", copyfrom_relpath, copyfrom_rev,
+                                relpath, revision));
+      SVN_ERR(svn_sqlite__insert(NULL, stmt));
+    }
+
+  /* Finally, the node's own svn:mergeinfo may have been changed. */
+  if (   change->change_kind != svn_fs_path_change_delete
+      && change->prop_mod
+      && change->mergeinfo_mod != svn_tristate_false)
+    {
+      svn_string_t *mergeinfo;
+
+      SVN_ERR(svn_fs_node_prop(&mergeinfo, root, change->path.data,
+                               SVN_PROP_MERGEINFO, scratch_pool));
+
+      SVN_ERR(svn_sqlite__get_statement(&stmt, sdb,
+                                        STMT_CLOSE_EXPLICIT_MERGEINFO));
+      SVN_ERR(svn_sqlite__bindf(stmt, "sr", relpath, revision));
+      SVN_ERR(svn_sqlite__update(NULL, stmt));
+
+      if (mergeinfo)
+        {
+          SVN_ERR(svn_sqlite__get_statement(&stmt, sdb,
+                                            STMT_INSERT_EXPLICIT_MERGEINFO));
+          SVN_ERR(svn_sqlite__bindf(stmt, "srs", relpath, revision,
+                                    mergeinfo->data));
+          SVN_ERR(svn_sqlite__insert(NULL, stmt));
+        }
+    }
+
+  return SVN_NO_ERROR;
+}
+
+/* Add the mergeinfo changes of REVISION in FS to SDB. */
+static svn_error_t *
+index_mergeinfo_changes(svn_sqlite__db_t *sdb,
+                        svn_fs_t *fs,
+                        svn_revnum_t revision,
+                        apr_pool_t *scratch_pool)
+{
+  apr_array_header_t *changes;
+  svn_error_t *err;
+  int i;
+
+  err = svn_repos__get_mergeinfo_changes(&changes, fs, revision,
+                                         scratch_pool, scratch_pool);
+
+  /* Issue #3896: log treats revisions with invalid mergeinfo as if they
+     had no mergeinfo changes.  Record them just like that. */
+  if (err && err->apr_err == SVN_ERR_MERGEINFO_PARSE_ERROR)
+    {
+      svn_error_clear(err);
+      return SVN_NO_ERROR;
+    }
+  SVN_ERR(err);
+
+  for (i = 0; i < changes->nelts; i++)
+    {
+      const svn_repos__mergeinfo_change_t *change
+        = APR_ARRAY_IDX(changes, i, const svn_repos__mergeinfo_change_t *);
+      svn_sqlite__stmt_t *stmt;
+
+      SVN_ERR(svn_sqlite__get_statement(&stmt, sdb,
+                                        STMT_INSERT_MERGEINFO_CHANGE));
+      SVN_ERR(svn_sqlite__bindf(stmt, "rs", revision,
+                                svn_fspath__skip_ancestor("/", change->path)));
+      if (change->prev_mergeinfo)
+        SVN_ERR(svn_sqlite__bind_text(stmt, 3, change->prev_mergeinfo->data));
+      if (change->mergeinfo)
+        SVN_ERR(svn_sqlite__bind_text(stmt, 4, change->mergeinfo->data));
+      SVN_ERR(svn_sqlite__insert(NULL, stmt));
+    }
+
+  return SVN_NO_ERROR;
+}
+
+/* Add the changed paths and mergeinfo of REVISION in FS to SDB. */
+static svn_error_t *
+index_revision(svn_sqlite__db_t *sdb,
+               svn_fs_t *fs,
+               svn_revnum_t revision,
+               apr_pool_t *scratch_pool)
+{
+  svn_fs_root_t *root;
+  svn_fs_path_change_iterator_t *iterator;
+  svn_fs_path_change3_t *change;
+  svn_sqlite__stmt_t *stmt;
+  apr_array_header_t *changes;
+  apr_pool_t *iterpool = svn_pool_create(scratch_pool);
+  int i;
+
+  SVN_ERR(svn_fs_revision_root(&root, fs, revision, scratch_pool));
+  SVN_ERR(svn_fs_paths_changed3(&iterator, root, scratch_pool, scratch_pool));
+
+  /* The explicit mergeinfo must be updated parent-first, so collect and
+     sort all changes before we process them. */
+  changes = apr_array_make(scratch_pool, 16, sizeof(change));
+  SVN_ERR(svn_fs_path_change_get(&change, iterator));
+  while (change)
+    {
+      APR_ARRAY_PUSH(changes, svn_fs_path_change3_t *)
+        = svn_fs_path_change3_dup(change, scratch_pool);
+      SVN_ERR(svn_fs_path_change_get(&change, iterator));
+    }
+  svn_sort__array(changes, compare_changes);
+
+  for (i = 0; i < changes->nelts; i++)
+    {
+      const char *action;
+      const char *relpath;
+      const char *copyfrom_path = NULL;
+      const char *copyfrom_relpath = NULL;
+      svn_revnum_t copyfrom_rev = SVN_INVALID_REVNUM;
+
+      svn_pool_clear(iterpool);
+      change = APR_ARRAY_IDX(changes, i, svn_fs_path_change3_t *);
+
+      switch (change->change_kind)
+        {
+          case svn_fs_path_change_add:
+            action = "A";
+            break;
+          case svn_fs_path_change_delete:
+            action = "D";
+            break;
+          case svn_fs_path_change_replace:
+            action = "R";
+            break;
+          case svn_fs_path_change_modify:
+            action = "M";
+            break;
+          default:
+            continue;
+        }
+
+      if (*action == 'A' || *action == 'R')
+        {
+          if (change->copyfrom_known)
+            {
+              copyfrom_rev = change->copyfrom_rev;
+              copyfrom_path = change->copyfrom_path;
+            }
+          else
+            {
+              SVN_ERR(svn_fs_copied_from(&copyfrom_rev, &copyfrom_path,
+                                         root, change->path.data, iterpool));
+            }
+
+          if (copyfrom_path && SVN_IS_VALID_REVNUM(copyfrom_rev))
+            copyfrom_relpath = svn_fspath__skip_ancestor("/", copyfrom_path);
+        }
+
+      relpath = svn_fspath__skip_ancestor("/", change->path.data);
+
+      SVN_ERR(svn_sqlite__get_statement(&stmt, sdb, STMT_INSERT_CHANGE));
+      SVN_ERR(svn_sqlite__bindf(stmt, "srs", relpath, revision, action));
+      if (copyfrom_relpath)
+        SVN_ERR(svn_sqlite__bindf(stmt, "nnnsr", copyfrom_relpath,
+                                  copyfrom_rev));
+      SVN_ERR(svn_sqlite__insert(NULL, stmt));
+
+      SVN_ERR(index_explicit_mergeinfo(sdb, root, revision, change, relpath,
+                                       copyfrom_relpath, copyfrom_rev,
+                                       iterpool));
+    }
+
+  svn_pool_destroy(iterpool);
+
+  return svn_error_trace(index_mergeinfo_changes(sdb, fs, revision,
+                                                 scratch_pool));
+}
+
+/* Index at most MAX_REVISIONS revisions of FS that are not yet in SDB
+ * and set *INDEXED_REV to the youngest revision covered by SDB afterwards.
+ * Start over if SDB was built for a different repository or covers more
+ * revisions than FS has.  Must be called within an SQLite transaction. */
+static svn_error_t *
+index_revisions(svn_revnum_t *indexed_rev,
+                svn_sqlite__db_t *sdb,
+                svn_fs_t *fs,
+                const char *fs_uuid,
+                svn_revnum_t fs_youngest,
+                int max_revisions,
+                svn_cancel_func_t cancel_func,
+                void *cancel_baton,
+                apr_pool_t *scratch_pool)
+{
+  apr_pool_t *iterpool = svn_pool_create(scratch_pool);
+  const char *uuid;
+  svn_revnum_t youngest;
+  svn_revnum_t rev;
+  svn_sqlite__stmt_t *stmt;
+
+  /* Another process may have updated the index before we got the lock,
+     so re-read its state here. */
+  SVN_ERR(get_info(&uuid, &youngest, sdb, scratch_pool));
+
+  if ((uuid && strcmp(uuid, fs_uuid) != 0) || youngest > fs_youngest)
+    {
+      SVN_ERR(svn_sqlite__exec_statements(sdb, STMT_DELETE_ALL_CHANGES));
+      youngest = 0;
+    }
+
+  for (rev = youngest + 1;
+       rev <= fs_youngest && rev <= youngest + max_revisions;
+       ++rev)
+    {
+      svn_pool_clear(iterpool);
+
+      if (cancel_func)
+        SVN_ERR(cancel_func(cancel_baton));
+
+      SVN_ERR(index_revision(sdb, fs, rev, iterpool));
+    }
+  svn_pool_destroy(iterpool);
+
+  *indexed_rev = rev - 1;
+
+  SVN_ERR(svn_sqlite__get_statement(&stmt, sdb, STMT_SET_INFO));
+  SVN_ERR(svn_sqlite__bindf(stmt, "sr", fs_uuid, *indexed_rev));
+  SVN_ERR(svn_sqlite__step_done(stmt));
+
+  return SVN_NO_ERROR;
+}
+
+/* Bring SDB up to date with all revisions in FS, but index no more than
+ * MAX_REVISIONS revisions in the process unless that is 0. */
+static svn_error_t *
+sync_db(svn_sqlite__db_t *sdb,
+        svn_fs_t *fs,
+        int max_revisions,
+        svn_cancel_func_t cancel_func,
+        void *cancel_baton,
+        apr_pool_t *scratch_pool)
+{
+  const char *fs_uuid;
+  const char *uuid;
+  svn_revnum_t fs_youngest;
+  svn_revnum_t indexed_rev;
+  svn_revnum_t start_rev;
+
+  SVN_ERR(svn_fs_get_uuid(fs, &fs_uuid, scratch_pool));
+  SVN_ERR(svn_fs_youngest_rev(&fs_youngest, fs, scratch_pool));
+
+  /* Don't take out a write lock if there is nothing to do. */
+  SVN_ERR(get_info(&uuid, &indexed_rev, sdb, scratch_pool));
+  if (uuid && strcmp(uuid, fs_uuid) == 0 && indexed_rev == fs_youngest)
+    return SVN_NO_ERROR;
+
+  /* An index for another repository gets rebuilt from scratch. */
+  if (! uuid || strcmp(uuid, fs_uuid) != 0 || indexed_rev > fs_youngest)
+    indexed_rev = 0;
+  start_rev = indexed_rev;
+
+  do
+    {
+      int batch = REVISIONS_PER_TXN;
+
+      if (max_revisions > 0)
+        {
+          /* Our budget is counted from where we started; someone else
+             may have moved the index along in the meantime. */
+          if (indexed_rev >= start_rev + max_revisions)
+            break;
+
+          batch = (int)MIN(batch, start_rev + max_revisions - indexed_rev);
+        }
+
+      SVN_SQLITE__WITH_IMMEDIATE_TXN(
+        index_revisions(&indexed_rev, sdb, fs, fs_uuid, fs_youngest,
+                        batch, cancel_func, cancel_baton, scratch_pool),
+        sdb);
+    }
+  while (indexed_rev < fs_youngest);
+
+  return SVN_NO_ERROR;
+}
+
+/* Set *ADDED if RELPATH or one of its parents was added or replaced in
+ * REVISION in the index SDB.  If so, and that happened through a copy, set
+ * *COPYFROM_RELPATH and *COPYFROM_REV to the location RELPATH was copied
+ * from.  Otherwise set them to NULL and SVN_INVALID_REVNUM, respectively.
+ */
+static svn_error_t *
+find_add(svn_boolean_t *added,
+         const char **copyfrom_relpath,
+         svn_revnum_t *copyfrom_rev,
+         svn_sqlite__db_t *sdb,
+         const char *relpath,
+         svn_revnum_t revision,
+         apr_pool_t *result_pool,
+         apr_pool_t *scratch_pool)
+{
+  const char *ancestor;
+
+  *added = FALSE;
+  *copyfrom_relpath = NULL;
+  *copyfrom_rev = SVN_INVALID_REVNUM;
+
+  /* The deepest copy wins, so walk up from RELPATH. */
+  for (ancestor = relpath;
+       *ancestor;
+       ancestor = svn_relpath_dirname(ancestor, scratch_pool))
+    {
+      svn_sqlite__stmt_t *stmt;
+      svn_boolean_t have_row;
+
+      SVN_ERR(svn_sqlite__get_statement(&stmt, sdb, STMT_SELECT_ADD_AT));
+      SVN_ERR(svn_sqlite__bindf(stmt, "sr", ancestor, revision));
+      SVN_ERR(svn_sqlite__step(&have_row, stmt));
+      if (have_row)
+        {
+          *added = TRUE;
+          if (! svn_sqlite__column_is_null(stmt, 0))
+            {
+              *copyfrom_relpath
+                = svn_relpath_join(svn_sqlite__column_text(stmt, 0, NULL),
+                                   svn_relpath_skip_ancestor(ancestor,
+                                                             relpath),
+                                   result_pool);
+              *copyfrom_rev = svn_sqlite__column_revnum(stmt, 1);
+            }
+
+          return svn_error_trace(svn_sqlite__reset(stmt));
+        }
+
+      SVN_ERR(svn_sqlite__reset(stmt));
+    }
+
+  return SVN_NO_ERROR;
+}
+
+/* Return the youngest revision not younger than REVISION in which the
+ * node at RELPATH@REVISION changed, according to SDB, in *YOUNGEST.
+ * Set it to SVN_INVALID_REVNUM if there is no such revision. */
+static svn_error_t *
+find_youngest_change(svn_revnum_t *youngest,
+                     svn_sqlite__db_t *sdb,
+                     const char *relpath,
+                     svn_revnum_t revision,
+                     apr_pool_t *scratch_pool)
+{
+  svn_sqlite__stmt_t *stmt;
+  svn_boolean_t have_row;
+  const char *ancestor;
+
+  *youngest = SVN_INVALID_REVNUM;
+
+  /* A change to the node itself or to anything below it. */
+  SVN_ERR(svn_sqlite__get_statement(&stmt, sdb, STMT_SELECT_YOUNGEST_CHANGE));
+  SVN_ERR(svn_sqlite__bindf(stmt, "sr", relpath, revision));
+  SVN_ERR(svn_sqlite__step(&have_row, stmt));
+  if (have_row)
+    *youngest = svn_sqlite__column_revnum(stmt, 0);
+  SVN_ERR(svn_sqlite__reset(stmt));
+
+  /* The node appearing at RELPATH, possibly because a parent got copied. */
+  for (ancestor = relpath;
+       *ancestor;
+       ancestor = svn_relpath_dirname(ancestor, scratch_pool))
+    {
+      svn_revnum_t added_rev = SVN_INVALID_REVNUM;
+
+      SVN_ERR(svn_sqlite__get_statement(&stmt, sdb,
+                                        STMT_SELECT_YOUNGEST_ADD));
+      SVN_ERR(svn_sqlite__bindf(stmt, "sr", ancestor, revision));
+      SVN_ERR(svn_sqlite__step(&have_row, stmt));
+      if (have_row)
+        added_rev = svn_sqlite__column_revnum(stmt, 0);
+      SVN_ERR(svn_sqlite__reset(stmt));
+
+      if (SVN_IS_VALID_REVNUM(added_rev)
+          && (! SVN_IS_VALID_REVNUM(*youngest) || added_rev > *youngest))
+        *youngest = added_rev;
+    }
+
+  return SVN_NO_ERROR;
+}
+
+
+/** Library-private API's. **/
+
+svn_error_t *
+svn_repos__log_index_sync(svn_fs_t *fs,
+                          svn_boolean_t create,
+                          int max_revisions,
+                          svn_cancel_func_t cancel_func,
+                          void *cancel_baton,
+                          apr_pool_t *scratch_pool)
+{
+  svn_sqlite__db_t *sdb;
+  svn_error_t *err;
+
+  SVN_ERR(open_db(&sdb, fs, create, scratch_pool, scratch_pool));
+  if (! sdb)
+    return SVN_NO_ERROR;
+
+  err = sync_db(sdb, fs, max_revisions, cancel_func, cancel_baton,
+                scratch_pool);
+
+  return svn_error_compose_create(err, svn_sqlite__close(sdb));
+}
+
+svn_error_t *
+svn_repos__log_index_open(svn_repos__log_index_t **index,
+                          svn_fs_t *fs,
+                          svn_revnum_t revision,
+                          apr_pool_t *result_pool,
+                          apr_pool_t *scratch_pool)
+{
+  svn_sqlite__db_t *sdb;
+  const char *fs_uuid;
+  const char *uuid;
+  svn_revnum_t indexed_rev;
+
+  *index = NULL;
+
+  SVN_ERR(open_db(&sdb, fs, FALSE, result_pool, scratch_pool));
+  if (! sdb)
+    return SVN_NO_ERROR;
+
+  /* Catch up with commits that failed to update the index.  We may not
+     be allowed to write to the index, though, in which case we will only
+     use it if it already covers REVISION.  We are serving some read
+     request here, so don't let it pay for indexing a long backlog; it
+     will simply do without the index until that has been dealt with. */
+  svn_error_clear(sync_db(sdb, fs, SVN_REPOS__LOG_INDEX_MAX_CATCHUP,
+                          NULL, NULL, scratch_pool));
+
+  SVN_ERR(svn_fs_get_uuid(fs, &fs_uuid, scratch_pool));
+  SVN_SQLITE__ERR_CLOSE(get_info(&uuid, &indexed_rev, sdb, scratch_pool),
+                        sdb);
+  if (! uuid || strcmp(uuid, fs_uuid) != 0 || indexed_rev < revision)
+    return svn_error_trace(svn_sqlite__close(sdb));
+
+  *index = apr_pcalloc(result_pool, sizeof(**index));
+  (*index)->sdb = sdb;
+
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_repos__log_index_history_prev(const char **prev_path,
+                                  svn_revnum_t *prev_rev,
+                                  svn_repos__log_index_t *index,
+                                  const char *path,
+                                  svn_revnum_t revision,
+                                  svn_boolean_t inclusive,
+                                  svn_boolean_t cross_copies,
+                                  apr_pool_t *result_pool,
+                                  apr_pool_t *scratch_pool)
+{
+  const char *relpath
+    = svn_fspath__skip_ancestor("/", svn_fspath__canonicalize(path,
+                                                              scratch_pool));
+
+  *prev_path = NULL;
+  *prev_rev = SVN_INVALID_REVNUM;
+
+  /* Every revision changes the root, including empty ones which we have
+     no rows for. */
+  if (! *relpath)
+    {
+      if (! inclusive)
+        --revision;
+
+      if (revision >= 0)
+        {
+          *prev_path = "/";
+          *prev_rev = revision;
+        }
+
+      return SVN_NO_ERROR;
+    }
+
+  /* If we already reported REVISION, continue at the copy source if the
+     node came into being in REVISION, and right before REVISION if not. */
+  if (! inclusive)
+    {
+      svn_boolean_t added;
+      const char *copyfrom_relpath;
+      svn_revnum_t copyfrom_rev;
+
+      SVN_ERR(find_add(&added, &copyfrom_relpath, &copyfrom_rev,
+                       index->sdb, relpath, revision,
+                       scratch_pool, scratch_pool));
+      if (added)
+        {
+          if (! copyfrom_relpath || ! cross_copies)
+            return SVN_NO_ERROR;
+
+          relpath = copyfrom_relpath;
+          revision = copyfrom_rev;
+
+          if (! *relpath)
+            {
+              *prev_path = "/";
+              *prev_rev = revision;
+              return SVN_NO_ERROR;
+            }
+        }
+      else
+        {
+          --revision;
+        }
+    }
+
+  SVN_ERR(find_youngest_change(prev_rev, index->sdb, relpath, revision,
+                               scratch_pool));
+  if (SVN_IS_VALID_REVNUM(*prev_rev))
+    *prev_path = svn_fspath__canonicalize(relpath, result_pool);
+
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_repos__log_index_get_mergeinfo_changes(apr_array_header_t **changes,
+                                           svn_repos__log_index_t *index,
+                                           svn_revnum_t revision,
+                                           apr_pool_t *result_pool,
+                                           apr_pool_t *scratch_pool)
+{
+  svn_sqlite__stmt_t *stmt;
+  svn_boolean_t have_row;
+
+  *changes = apr_array_make(result_pool, 0,
+                            sizeof(svn_repos__mergeinfo_change_t *));
+
+  SVN_ERR(svn_sqlite__get_statement(&stmt, index->sdb,
+                                    STMT_SELECT_MERGEINFO_CHANGES));
+  SVN_ERR(svn_sqlite__bindf(stmt, "r", revision));
+  SVN_ERR(svn_sqlite__step(&have_row, stmt));
+  while (have_row)
+    {
+      svn_repos__mergeinfo_change_t *change
+        = apr_pcalloc(result_pool, sizeof(*change));
+
+      change->path
+        = svn_fspath__canonicalize(svn_sqlite__column_text(stmt, 0, NULL),
+                                   result_pool);
+      if (! svn_sqlite__column_is_null(stmt, 1))
+        change->prev_mergeinfo
+          = svn_string_create(svn_sqlite__column_text(stmt, 1, NULL),
+                              result_pool);
+      if (! svn_sqlite__column_is_null(stmt, 2))
+        change->mergeinfo
+          = svn_string_create(svn_sqlite__column_text(stmt, 2, NULL),
+                              result_pool);
+
+      APR_ARRAY_PUSH(*changes, svn_repos__mergeinfo_change_t *) = change;
+      SVN_ERR(svn_sqlite__step(&have_row, stmt));
+    }
+
+  return svn_error_trace(svn_sqlite__reset(stmt));
+}
+
+svn_error_t *
+svn_repos__log_index_get_descendant_mergeinfo(
+  svn_repos__log_index_t *index,
+  const char *path,
+  svn_revnum_t revision,
+  svn_fs_mergeinfo_receiver_t receiver,
+  void *baton,
+  apr_pool_t *scratch_pool)
+{
+  svn_sqlite__stmt_t *stmt;
+  svn_boolean_t have_row;
+  apr_array_header_t *paths = apr_array_make(scratch_pool, 0,
+                                             sizeof(const char *));
+  apr_array_header_t *values = apr_array_make(scratch_pool, 0,
+                                              sizeof(const char *));
+  apr_pool_t *iterpool;
+  int i;
+
+  /* Fetch everything first; RECEIVER may take its time. */
+  SVN_ERR(svn_sqlite__get_statement(&stmt, index->sdb,
+                                    STMT_SELECT_DESCENDANT_EXPLICIT_MERGEINFO));
+  SVN_ERR(svn_sqlite__bindf(stmt, "sr",
+                            svn_fspath__skip_ancestor(
+                              "/", svn_fspath__canonicalize(path,
+                                                            scratch_pool)),
+                            revision));
+  SVN_ERR(svn_sqlite__step(&have_row, stmt));
+  while (have_row)
+    {
+      APR_ARRAY_PUSH(paths, const char *)
+        = svn_fspath__canonicalize(svn_sqlite__column_text(stmt, 0, NULL),
+                                   scratch_pool);
+      APR_ARRAY_PUSH(values, const char *)
+        = svn_sqlite__column_text(stmt, 1, scratch_pool);
+      SVN_ERR(svn_sqlite__step(&have_row, stmt));
+    }
+  SVN_ERR(svn_sqlite__reset(stmt));
+
+  iterpool = svn_pool_create(scratch_pool);
+  for (i = 0; i < paths->nelts; i++)
+    {
+      svn_mergeinfo_t mergeinfo;
+      svn_error_t *err;
+
+      svn_pool_clear(iterpool);
+
+      /* Issue #3896: Treat syntactically invalid mergeinfo as if no
+         mergeinfo was present, just like the filesystem does. */
+      err = svn_mergeinfo_parse(&mergeinfo,
+                                APR_ARRAY_IDX(values, i, const char *),
+                                iterpool);
+      if (err && err->apr_err == SVN_ERR_MERGEINFO_PARSE_ERROR)
+        {
+          svn_error_clear(err);
+          continue;
+        }
+      SVN_ERR(err);
+
+      SVN_ERR(receiver(APR_ARRAY_IDX(paths, i, const char *), mergeinfo,
+                       baton, iterpool));
+    }
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
@@ -196,6 +196,22 @@ add_subdir(svn_fs_root_t *source_root,
      path_driver_cb_func, not add_subdir (in order to preserve history). */
   SVN_ERR(svn_fs_dir_entries(&dirents, source_root, source_fspath, pool));
 
+  /* The copied entries share their nodes with the source, so reading
+     them in one go helps with whatever root we access them through. */
+  if (apr_hash_count(dirents) > 1)
+    {
+      apr_array_header_t *paths
+        = apr_array_make(subpool, apr_hash_count(dirents),
+                         sizeof(const char *));
+
+      for (hi = apr_hash_first(subpool, dirents); hi; hi = apr_hash_next(hi))
+        APR_ARRAY_PUSH(paths, const char *)
+          = svn_fspath__join(source_fspath, apr_hash_this_key(hi), subpool);
+
+      SVN_ERR(svn_fs_prefetch_nodes(source_root, paths, TRUE, TRUE,
+                                    subpool));
+    }
+
   for (hi = apr_hash_first(pool, dirents); hi; hi = apr_hash_next(hi))
     {
       svn_fs_path_change3_t *change;
@@ -980,6 +996,13 @@ svn_repos_replay2(svn_fs_root_t *root,
   cb_baton.copies = apr_array_make(pool, 4, sizeof(struct copy_info *));
   cb_baton.pool = pool;
 
+  /* Read the changed nodes in storage order instead of one by one as the
+     path driver reaches them.  Deleted paths will simply be skipped. */
+  SVN_ERR(svn_fs_prefetch_nodes(root, paths, FALSE, TRUE, pool));
+  if (cb_baton.compare_root)
+    SVN_ERR(svn_fs_prefetch_nodes(cb_baton.compare_root, paths, FALSE, TRUE,
+                                  pool));
+
   /* Determine the revision to use throughout the edit, and call
      EDITOR's set_target_revision() function.  */
   if (svn_fs_is_revision_root(root))
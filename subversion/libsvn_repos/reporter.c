@@ -21,6 +21,9 @@
  * ====================================================================
  */
 
+#include <apr_thread_pool.h>
+#include <apr_thread_cond.h>
+
 #include "svn_dirent_uri.h"
 #include "svn_hash.h"
 #include "svn_path.h"
@@ -31,11 +34,15 @@
 #include "svn_repos.h"
 #include "svn_pools.h"
 #include "svn_props.h"
+#include "svn_sorts.h"
 #include "repos.h"
 #include "svn_private_config.h"
 
+#include "private/svn_atomic.h"
 #include "private/svn_dep_compat.h"
 #include "private/svn_fspath.h"
+#include "private/svn_mutex.h"
+#include "private/svn_repos_private.h"
 #include "private/svn_subr_private.h"
 #include "private/svn_string_private.h"
 
@@ -128,6 +135,17 @@ typedef struct report_baton_t
   svn_repos_authz_func_t authz_read_func;
   void *authz_read_baton;
 
+  /* Readability of the target entries of the directory currently being
+     processed by delta_dirs(), if they got checked in a single batch.
+     Maps const char * fspaths to const svn_boolean_t *.  May be NULL. */
+  apr_hash_t *authz_prefetched;
+
+  /* Number of worker threads to prefetch file deltas with, as set by
+     svn_repos__report_set_delta_threads(), and the prefetcher using
+     them.  PREFETCHER is NULL if deltas are calculated inline only. */
+  int delta_threads;
+  struct delta_prefetcher_t *prefetcher;
+
   /* The spill-buffer holding the report. */
   svn_spillbuf_reader_t *reader;
 
@@ -163,6 +181,10 @@ static svn_error_t *delta_dirs(report_baton_t *b, svn_revnum_t s_rev,
                                svn_depth_t requested_depth,
                                apr_pool_t *pool);
 
+static svn_boolean_t is_depth_upgrade(svn_depth_t wc_depth,
+                                      svn_depth_t requested_depth,
+                                      svn_node_kind_t kind);
+
 /* --- READING PREVIOUSLY STORED REPORT INFORMATION --- */
 
 static svn_error_t *
@@ -615,6 +637,696 @@ delta_proplists(report_baton_t *b, svn_revnum_t s_rev, const char *s_path,
   return SVN_NO_ERROR;
 }
 
+/* --- PREFETCHING FILE DELTAS --- */
+
+/* When enabled through svn_repos__report_set_delta_threads(), the text
+   deltas of the files that the editor drive is about to reach are
+   computed by worker threads while the main thread is still busy with
+   the entries before them.  The editor itself only ever gets called from
+   the main thread and in the usual order; delta_files() simply replays
+   the windows computed ahead of time instead of reading the delta stream
+   itself.
+
+   svn_fs_t objects must not be used by more than one thread at a time,
+   so the workers open FS instances of their own on the same repository
+   and share them through an idle list.
+
+   Files become prefetch candidates when delta_dirs() starts to process
+   the target entries of a directory.  The candidates of a sub-directory
+   get queued in front of the remaining ones of its parent, which keeps
+   the queue in editor drive order.  Only a bounded number of candidates
+   get handed to the workers at any time.
+
+   Reports without text deltas ("skeltas") are followed by the client
+   fetching the fulltexts of those files.  In that case, the workers read
+   the target fulltexts instead, so that the FS caches can serve them. */
+
+/* Never buffer more delta window data than this for a single file.
+   Larger deltas get computed inline once the editor reaches them. */
+#define MAX_PREFETCHED_DELTA_SIZE (512 * 1024)
+
+/* Don't read fulltexts larger than this into the FS caches. */
+#define MAX_PREFETCHED_FULLTEXT_SIZE (16 * 1024 * 1024)
+
+/* Upper limit for the number of worker threads of all reports in this
+   process.  Every worker may keep an FS instance open, so this also
+   limits the number of additional FS instances. */
+#define MAX_DELTA_THREADS_TOTAL 64
+
+/* Number of worker threads currently reserved by all reports.  Only to
+   be modified through svn_atomic_cas(). */
+static volatile svn_atomic_t delta_threads_in_use = 0;
+
+/* A file whose delta may get prefetched. */
+typedef struct delta_candidate_t
+{
+  /* Source of the delta.  S_PATH is NULL for deltas against the empty
+     file. */
+  svn_revnum_t s_rev;
+  const char *s_path;
+
+  /* Target node within the report's target revision. */
+  const char *t_path;
+
+  /* Nesting level of the delta_dirs() call that scheduled the file. */
+  int depth;
+
+  struct delta_candidate_t *next;
+} delta_candidate_t;
+
+/* A delta calculation that has been handed to a worker thread. */
+typedef struct delta_job_t
+{
+  /* What to calculate.  Allocated in POOL. */
+  delta_candidate_t candidate;
+
+  /* Copies of all delta windows (svn_txdelta_window_t *) except for the
+     final NULL one, or NULL if the delta could not be prefetched. */
+  apr_array_header_t *windows;
+
+  /* Set once WINDOWS is valid.  Protected by the prefetcher's MUTEX. */
+  svn_boolean_t done;
+
+  /* Root pool owning this job, safe to use from any thread. */
+  apr_pool_t *pool;
+
+  struct delta_prefetcher_t *prefetcher;
+} delta_job_t;
+
+/* An FS instance to be used by one worker at a time. */
+typedef struct fs_instance_t
+{
+  svn_fs_t *fs;
+  svn_fs_root_t *t_root;
+
+  /* Root pool owning this instance. */
+  apr_pool_t *pool;
+
+  struct fs_instance_t *next;
+} fs_instance_t;
+
+typedef struct delta_prefetcher_t
+{
+#if APR_HAS_THREADS
+  /* Runs the delta calculations.  Allocated in THREAD_POOL_POOL. */
+  apr_thread_pool_t *thread_pool;
+  apr_pool_t *thread_pool_pool;
+
+  /* Synchronize the DONE flags of all jobs and IDLE_FS. */
+  svn_mutex__t *mutex;
+  apr_thread_cond_t *cond;
+#endif
+
+  /* Number of worker threads reserved from DELTA_THREADS_IN_USE. */
+  int threads;
+
+  /* Whether to calculate text deltas or to only read the fulltexts. */
+  svn_boolean_t text_deltas;
+
+  /* Used to open additional FS instances on the report's repository. */
+  const char *fs_path;
+  apr_hash_t *fs_config;
+  svn_revnum_t t_rev;
+
+  /* FS instances not used by any worker right now. */
+  fs_instance_t *idle_fs;
+
+  /* Files that have not been handed to the workers yet, in the order
+     in which the editor drive is expected to reach them. */
+  delta_candidate_t *candidates;
+
+  /* Jobs handed to the workers and not claimed yet, keyed by t_path. */
+  apr_hash_t *submitted;
+
+  /* Number of jobs in SUBMITTED and the limit for it. */
+  int pending;
+  int max_pending;
+
+  /* Nesting level of the delta_dirs() call being processed. */
+  int depth;
+} delta_prefetcher_t;
+
+#if APR_HAS_THREADS
+
+/* Reserve up to WANTED worker threads within MAX_DELTA_THREADS_TOTAL and
+   return the number of threads actually reserved. */
+static int
+reserve_delta_threads(int wanted)
+{
+  svn_atomic_t in_use;
+  svn_atomic_t granted;
+
+  do
+    {
+      in_use = delta_threads_in_use;
+      if (in_use >= MAX_DELTA_THREADS_TOTAL)
+        return 0;
+
+      granted = MIN((svn_atomic_t)wanted, MAX_DELTA_THREADS_TOTAL - in_use);
+    }
+  while (svn_atomic_cas(&delta_threads_in_use, in_use + granted, in_use)
+         != in_use);
+
+  return (int)granted;
+}
+
+/* Return THREADS worker threads reserved by reserve_delta_threads(). */
+static void
+release_delta_threads(int threads)
+{
+  svn_atomic_t in_use;
+
+  do
+    in_use = delta_threads_in_use;
+  while (svn_atomic_cas(&delta_threads_in_use, in_use - threads, in_use)
+         != in_use);
+}
+
+/* Read the fulltext of JOB's target using the FS instance INSTANCE, so
+   that the FS caches will have it when the client asks for it.  Use
+   SCRATCH_POOL for temporaries. */
+static svn_error_t *
+read_fulltext(delta_job_t *job,
+              fs_instance_t *instance,
+              apr_pool_t *scratch_pool)
+{
+  svn_filesize_t length;
+  svn_stream_t *contents;
+
+  SVN_ERR(svn_fs_file_length(&length, instance->t_root,
+                             job->candidate.t_path, scratch_pool));
+  if (length > MAX_PREFETCHED_FULLTEXT_SIZE)
+    return SVN_NO_ERROR;
+
+  SVN_ERR(svn_fs_file_contents(&contents, instance->t_root,
+                               job->candidate.t_path, scratch_pool));
+  return svn_error_trace(svn_stream_copy3(contents,
+                                          svn_stream_empty(scratch_pool),
+                                          NULL, NULL, scratch_pool));
+}
+
+/* Calculate the delta for JOB using the FS instance INSTANCE and set
+   JOB->WINDOWS accordingly.  Use SCRATCH_POOL for temporaries. */
+static svn_error_t *
+calculate_delta(delta_job_t *job,
+                fs_instance_t *instance,
+                apr_pool_t *scratch_pool)
+{
+  delta_prefetcher_t *prefetcher = job->prefetcher;
+  svn_fs_root_t *s_root = NULL;
+  svn_txdelta_stream_t *dstream;
+  apr_array_header_t *windows;
+  apr_size_t size = 0;
+
+  if (!instance->t_root)
+    SVN_ERR(svn_fs_revision_root(&instance->t_root, instance->fs,
+                                 prefetcher->t_rev, instance->pool));
+  if (!prefetcher->text_deltas)
+    return svn_error_trace(read_fulltext(job, instance, scratch_pool));
+
+  if (job->candidate.s_path)
+    SVN_ERR(svn_fs_revision_root(&s_root, instance->fs, job->candidate.s_rev,
+                                 scratch_pool));
+
+  SVN_ERR(svn_fs_get_file_delta_stream(&dstream, s_root,
+                                       job->candidate.s_path,
+                                       instance->t_root,
+                                       job->candidate.t_path,
+                                       scratch_pool));
+
+  windows = apr_array_make(job->pool, 16, sizeof(svn_txdelta_window_t *));
+  while (TRUE)
+    {
+      svn_txdelta_window_t *window;
+
+      SVN_ERR(svn_txdelta_next_window(&window, dstream, scratch_pool));
+      if (!window)
+        break;
+
+      /* Leave large deltas to the editor drive.  The memory already used
+         will be released together with the job. */
+      size += window->tview_len + (window->new_data
+                                   ? window->new_data->len : 0);
+      if (size > MAX_PREFETCHED_DELTA_SIZE)
+        return SVN_NO_ERROR;
+
+      APR_ARRAY_PUSH(windows, svn_txdelta_window_t *)
+        = svn_txdelta_window_dup(window, job->pool);
+    }
+
+  job->windows = windows;
+  return SVN_NO_ERROR;
+}
+
+/* Thread-pool task calculating the delta for the delta_job_t given as
+   DATA. */
+static void * APR_THREAD_FUNC
+delta_task(apr_thread_t *tid,
+           void *data)
+{
+  delta_job_t *job = data;
+  delta_prefetcher_t *prefetcher = job->prefetcher;
+  fs_instance_t *instance = NULL;
+  svn_error_t *err;
+
+  /* Grab an idle FS instance or open a new one. */
+  err = svn_mutex__lock(prefetcher->mutex);
+  if (!err)
+    {
+      instance = prefetcher->idle_fs;
+      if (instance)
+        prefetcher->idle_fs = instance->next;
+      err = svn_mutex__unlock(prefetcher->mutex, SVN_NO_ERROR);
+    }
+
+  if (!err && !instance)
+    {
+      apr_pool_t *instance_pool = svn_pool_create(NULL);
+
+      instance = apr_pcalloc(instance_pool, sizeof(*instance));
+      instance->pool = instance_pool;
+      err = svn_fs_open2(&instance->fs, prefetcher->fs_path,
+                         prefetcher->fs_config, instance_pool,
+                         instance_pool);
+      if (err)
+        {
+          svn_pool_destroy(instance_pool);
+          instance = NULL;
+        }
+    }
+
+  if (!err)
+    {
+      apr_pool_t *scratch_pool = svn_pool_create(instance->pool);
+
+      err = calculate_delta(job, instance, scratch_pool);
+      svn_pool_destroy(scratch_pool);
+    }
+
+  /* Failures are not fatal here.  The editor drive will simply calculate
+     the delta itself and report any problem from there. */
+  if (err)
+    job->windows = NULL;
+  svn_error_clear(err);
+
+  /* Return the FS instance and tell the main thread that we are done.
+     There is no way to report errors in the synchronization itself, but
+     those would make the main thread fail when waiting for us anyway. */
+  err = svn_mutex__lock(prefetcher->mutex);
+  if (!err)
+    {
+      if (instance)
+        {
+          instance->next = prefetcher->idle_fs;
+          prefetcher->idle_fs = instance;
+        }
+
+      job->done = TRUE;
+      apr_thread_cond_broadcast(prefetcher->cond);
+      err = svn_mutex__unlock(prefetcher->mutex, SVN_NO_ERROR);
+    }
+  svn_error_clear(err);
+
+  return NULL;
+}
+
+/* Pool pre-cleanup for the delta_prefetcher_t given as DATA.  Waits for
+   all running tasks before releasing the jobs and FS instances. */
+static apr_status_t
+prefetcher_cleanup(void *data)
+{
+  delta_prefetcher_t *prefetcher = data;
+  apr_hash_index_t *hi;
+  apr_status_t status;
+
+  status = apr_thread_pool_destroy(prefetcher->thread_pool);
+  svn_pool_destroy(prefetcher->thread_pool_pool);
+  release_delta_threads(prefetcher->threads);
+
+  for (hi = apr_hash_first(NULL, prefetcher->submitted);
+       hi;
+       hi = apr_hash_next(hi))
+    {
+      delta_job_t *job = apr_hash_this_val(hi);
+      svn_pool_destroy(job->pool);
+    }
+
+  while (prefetcher->idle_fs)
+    {
+      fs_instance_t *instance = prefetcher->idle_fs;
+
+      prefetcher->idle_fs = instance->next;
+      svn_pool_destroy(instance->pool);
+    }
+
+  return status;
+}
+
+/* Pool cleanup destroying the job pool given as DATA. */
+static apr_status_t
+job_pool_cleanup(void *data)
+{
+  svn_pool_destroy(data);
+  return APR_SUCCESS;
+}
+
+/* Hand candidates from PREFETCHER to the workers until the limit of
+   pending jobs has been reached. */
+static svn_error_t *
+submit_candidates(delta_prefetcher_t *prefetcher)
+{
+  while (prefetcher->candidates
+         && prefetcher->pending < prefetcher->max_pending)
+    {
+      delta_candidate_t *candidate = prefetcher->candidates;
+      apr_pool_t *job_pool;
+      delta_job_t *job;
+      apr_status_t status;
+
+      prefetcher->candidates = candidate->next;
+
+      /* Another report entry may lead us to the same target path,
+         e.g. via link_path.  Don't bother prefetching it twice. */
+      if (svn_hash_gets(prefetcher->submitted, candidate->t_path))
+        continue;
+
+      /* Workers need a pool of their own that is safe to use from any
+         thread. */
+      job_pool = svn_pool_create(NULL);
+      job = apr_pcalloc(job_pool, sizeof(*job));
+      job->candidate.s_rev = candidate->s_rev;
+      job->candidate.s_path = candidate->s_path
+                            ? apr_pstrdup(job_pool, candidate->s_path)
+                            : NULL;
+      job->candidate.t_path = apr_pstrdup(job_pool, candidate->t_path);
+      job->candidate.depth = candidate->depth;
+      job->pool = job_pool;
+      job->prefetcher = prefetcher;
+
+      status = apr_thread_pool_push(prefetcher->thread_pool, delta_task, job,
+                                    0, NULL);
+      if (status)
+        {
+          svn_pool_destroy(job_pool);
+          return svn_error_wrap_apr(status, _("Can't push task"));
+        }
+
+      svn_hash_sets(prefetcher->submitted, job->candidate.t_path, job);
+      prefetcher->pending++;
+    }
+
+  return SVN_NO_ERROR;
+}
+
+/* Wait until the worker processing JOB is done with it. */
+static svn_error_t *
+wait_for_job(delta_job_t *job)
+{
+  delta_prefetcher_t *prefetcher = job->prefetcher;
+
+  SVN_ERR(svn_mutex__lock(prefetcher->mutex));
+  while (!job->done)
+    {
+      apr_status_t status
+        = apr_thread_cond_wait(prefetcher->cond,
+                               svn_mutex__get(prefetcher->mutex));
+      if (status)
+        return svn_error_trace(
+                 svn_mutex__unlock(prefetcher->mutex,
+                                   svn_error_wrap_apr(status,
+                                        _("Can't wait for delta task"))));
+    }
+
+  return svn_error_trace(svn_mutex__unlock(prefetcher->mutex,
+                                           SVN_NO_ERROR));
+}
+
+/* Wait for JOB to finish, remove it from the jobs pending in its
+   prefetcher and submit the next candidate in its place.  The caller
+   takes over the ownership of JOB->POOL.  If waiting fails, JOB stays
+   with the prefetcher, which will release it once all workers are gone.
+ */
+static svn_error_t *
+retire_job(delta_job_t *job)
+{
+  delta_prefetcher_t *prefetcher = job->prefetcher;
+
+  SVN_ERR(wait_for_job(job));
+
+  svn_hash_sets(prefetcher->submitted, job->candidate.t_path, NULL);
+  prefetcher->pending--;
+
+  return svn_error_trace(submit_candidates(prefetcher));
+}
+
+#endif
+
+/* Set *PREFETCHER to a new delta prefetcher for report B using up to
+   THREADS worker threads, or to NULL if deltas should be calculated
+   inline only.  Allocate it in B->POOL; the workers get stopped when
+   that pool gets cleaned up. */
+static svn_error_t *
+prefetcher_create(delta_prefetcher_t **prefetcher,
+                  report_baton_t *b,
+                  int threads)
+{
+#if APR_HAS_THREADS
+  apr_pool_t *pool = b->pool;
+  apr_status_t status;
+  svn_error_t *err;
+
+  /* Share the threads available to the whole process.  A single thread
+     would not get ahead of the editor drive. */
+  threads = MIN(threads, SVN_REPOS__MAX_DELTA_THREADS);
+  if (threads > 1)
+    {
+      threads = reserve_delta_threads(threads);
+      if (threads < 2)
+        {
+          release_delta_threads(threads);
+          threads = 0;
+        }
+    }
+
+  if (threads > 1)
+    {
+      *prefetcher = apr_pcalloc(pool, sizeof(**prefetcher));
+      (*prefetcher)->threads = threads;
+      (*prefetcher)->text_deltas = b->text_deltas;
+      (*prefetcher)->fs_path = svn_fs_path(b->repos->fs, pool);
+      (*prefetcher)->fs_config = svn_fs_config(b->repos->fs, pool);
+      (*prefetcher)->t_rev = b->t_rev;
+      (*prefetcher)->submitted = apr_hash_make(pool);
+
+      /* Keep every worker busy without letting deltas pile up in
+         memory. */
+      (*prefetcher)->max_pending = 4 * threads;
+
+      err = svn_mutex__init(&(*prefetcher)->mutex, TRUE, pool);
+      if (err)
+        {
+          release_delta_threads(threads);
+          return svn_error_trace(err);
+        }
+
+      status = apr_thread_cond_create(&(*prefetcher)->cond, pool);
+      if (!status)
+        {
+          /* The thread-pool must be allocated from a thread-safe pool. */
+          (*prefetcher)->thread_pool_pool = svn_pool_create(NULL);
+          status = apr_thread_pool_create(&(*prefetcher)->thread_pool, 0,
+                                          threads,
+                                          (*prefetcher)->thread_pool_pool);
+          if (status)
+            svn_pool_destroy((*prefetcher)->thread_pool_pool);
+        }
+
+      if (status)
+        {
+          release_delta_threads(threads);
+          return svn_error_wrap_apr(status,
+                                    _("Can't create delta thread pool"));
+        }
+
+      apr_pool_pre_cleanup_register(pool, *prefetcher, prefetcher_cleanup);
+      return SVN_NO_ERROR;
+    }
+#endif
+
+  *prefetcher = NULL;
+  return SVN_NO_ERROR;
+}
+
+/* Queue the files among the T_ORDERED_ENTRIES of directory T_PATH for
+   delta prefetching, in front of all other candidates.  S_REV, S_PATH,
+   S_ENTRIES, WC_DEPTH and REQUESTED_DEPTH are as in delta_dirs(), whose
+   target entry loop selects the entries to process in exactly the same
+   way.  Allocate the candidates in POOL, which must live until
+   release_prefetched_deltas() has been called for this level. */
+static svn_error_t *
+prefetch_deltas(report_baton_t *b,
+                svn_revnum_t s_rev,
+                const char *s_path,
+                apr_hash_t *s_entries,
+                const char *t_path,
+                apr_array_header_t *t_ordered_entries,
+                svn_depth_t wc_depth,
+                svn_depth_t requested_depth,
+                apr_pool_t *pool)
+{
+#if APR_HAS_THREADS
+  delta_prefetcher_t *prefetcher = b->prefetcher;
+  delta_candidate_t *first = NULL, *last = NULL;
+  int i;
+
+  for (i = 0; i < t_ordered_entries->nelts; ++i)
+    {
+      const svn_fs_dirent_t *t_entry
+        = APR_ARRAY_IDX(t_ordered_entries, i, svn_fs_dirent_t *);
+      const svn_fs_dirent_t *s_entry = NULL;
+      delta_candidate_t *candidate;
+
+      if (t_entry->kind != svn_node_file)
+        continue;
+
+      if (!is_depth_upgrade(wc_depth, requested_depth, t_entry->kind))
+        {
+          if (requested_depth == svn_depth_unknown
+              && wc_depth < svn_depth_files)
+            continue;
+
+          s_entry = s_entries ? svn_hash_gets(s_entries, t_entry->name)
+                              : NULL;
+        }
+
+      /* Unchanged files don't need a delta. */
+      if (s_entry && svn_fs_compare_ids(s_entry->id, t_entry->id) == 0)
+        continue;
+
+      candidate = apr_pcalloc(pool, sizeof(*candidate));
+      candidate->t_path = svn_fspath__join(t_path, t_entry->name, pool);
+      candidate->depth = prefetcher->depth;
+
+      /* Unrelated sources get replaced, i.e. the file will be sent as
+         a delta against the empty file. */
+      if (s_entry && s_entry->kind == svn_node_file
+          && (b->ignore_ancestry
+              || svn_fs_compare_ids(s_entry->id, t_entry->id) != -1))
+        {
+          candidate->s_rev = s_rev;
+          candidate->s_path = svn_fspath__join(s_path, t_entry->name, pool);
+        }
+      else
+        {
+          candidate->s_rev = SVN_INVALID_REVNUM;
+          candidate->s_path = NULL;
+        }
+
+      /* Don't waste any work on files the user cannot read anyway. */
+      if (b->authz_prefetched)
+        {
+          const svn_boolean_t *allowed
+            = svn_hash_gets(b->authz_prefetched, candidate->t_path);
+          if (allowed && !*allowed)
+            continue;
+        }
+
+      if (last)
+        last->next = candidate;
+      else
+        first = candidate;
+      last = candidate;
+    }
+
+  if (first)
+    {
+      last->next = prefetcher->candidates;
+      prefetcher->candidates = first;
+    }
+
+  return svn_error_trace(submit_candidates(prefetcher));
+#else
+  return SVN_NO_ERROR;
+#endif
+}
+
+/* Drop all candidates and prefetched deltas of the current delta_dirs()
+   level of B's prefetcher that the editor drive did not use. */
+static svn_error_t *
+release_prefetched_deltas(report_baton_t *b)
+{
+#if APR_HAS_THREADS
+  delta_prefetcher_t *prefetcher = b->prefetcher;
+  apr_hash_index_t *hi;
+
+  while (prefetcher->candidates
+         && prefetcher->candidates->depth >= prefetcher->depth)
+    prefetcher->candidates = prefetcher->candidates->next;
+
+  for (hi = apr_hash_first(NULL, prefetcher->submitted);
+       hi;
+       hi = apr_hash_next(hi))
+    {
+      delta_job_t *job = apr_hash_this_val(hi);
+      if (job->candidate.depth >= prefetcher->depth)
+        {
+          /* If we can't wait for the worker, leave the job to
+             prefetcher_cleanup(), which waits for all workers. */
+          SVN_ERR(wait_for_job(job));
+
+          /* Removing the current entry while iterating is fine. */
+          svn_hash_sets(prefetcher->submitted, job->candidate.t_path, NULL);
+          prefetcher->pending--;
+          svn_pool_destroy(job->pool);
+        }
+    }
+
+  return svn_error_trace(submit_candidates(prefetcher));
+#else
+  return SVN_NO_ERROR;
+#endif
+}
+
+/* Set *WINDOWS to the prefetched delta windows from S_REV/S_PATH to
+   B->t_root/T_PATH, or to NULL if that delta has not been prefetched.
+   The windows remain valid until POOL gets cleared. */
+static svn_error_t *
+get_prefetched_delta(apr_array_header_t **windows,
+                     report_baton_t *b,
+                     svn_revnum_t s_rev,
+                     const char *s_path,
+                     const char *t_path,
+                     apr_pool_t *pool)
+{
+#if APR_HAS_THREADS
+  delta_job_t *job;
+
+  *windows = NULL;
+  if (!b->prefetcher)
+    return SVN_NO_ERROR;
+
+  job = svn_hash_gets(b->prefetcher->submitted, t_path);
+  if (!job)
+    return SVN_NO_ERROR;
+
+  SVN_ERR(retire_job(job));
+  apr_pool_cleanup_register(pool, job->pool, job_pool_cleanup,
+                            apr_pool_cleanup_null);
+
+  /* The report may have told us to use a different source. */
+  if (s_path
+      ? (job->candidate.s_path
+         && job->candidate.s_rev == s_rev
+         && strcmp(job->candidate.s_path, s_path) == 0)
+      : !job->candidate.s_path)
+    *windows = job->windows;
+#else
+  *windows = NULL;
+#endif
+
+  return SVN_NO_ERROR;
+}
+
 /* Baton type to be passed into send_zero_copy_delta.
  */
 typedef struct zero_copy_baton_t
@@ -677,6 +1389,12 @@ delta_files(report_baton_t *b, void *file_baton, svn_revnum_t s_rev,
   const char *s_hex_digest = NULL;
   svn_txdelta_window_handler_t dhandler;
   void *dbaton;
+  apr_array_header_t *prefetched;
+
+  /* Claim any prefetched delta first, so that the workers may move on
+     even if we don't need it after all. */
+  SVN_ERR(get_prefetched_delta(&prefetched, b, s_rev, s_path, t_path,
+                               pool));
 
   /* Compare the files' property lists.  */
   SVN_ERR(delta_proplists(b, s_rev, s_path, t_path, lock_token,
@@ -710,6 +1428,19 @@ delta_files(report_baton_t *b, void *file_baton, svn_revnum_t s_rev,
     {
       if (b->text_deltas)
         {
+          /* Replay the delta calculated ahead of time, if any. */
+          if (prefetched)
+            {
+              int i;
+
+              for (i = 0; i < prefetched->nelts; i++)
+                SVN_ERR(dhandler(APR_ARRAY_IDX(prefetched, i,
+                                               svn_txdelta_window_t *),
+                                 dbaton));
+
+              return svn_error_trace(dhandler(NULL, dbaton));
+            }
+
           /* if we send deltas against empty streams, we may use our
              zero-copy code. */
           if (b->zero_copy_limit > 0 && s_path == NULL)
@@ -748,6 +1479,17 @@ static svn_error_t *
 check_auth(report_baton_t *b, svn_boolean_t *allowed, const char *path,
            apr_pool_t *pool)
 {
+  if (b->authz_prefetched)
+    {
+      const svn_boolean_t *prefetched = svn_hash_gets(b->authz_prefetched,
+                                                      path);
+      if (prefetched)
+        {
+          *allowed = *prefetched;
+          return SVN_NO_ERROR;
+        }
+    }
+
   if (b->authz_read_func)
     return svn_error_trace(b->authz_read_func(allowed, b->t_root, path,
                                               b->authz_read_baton, pool));
@@ -755,6 +1497,36 @@ check_auth(report_baton_t *b, svn_boolean_t *allowed, const char *path,
   return SVN_NO_ERROR;
 }
 
+/* Check the readability of all entries in T_ENTRIES of the directory
+   B->t_root/T_PATH with a single call to B's authz callback and make
+   check_auth() use the results.  Allocate them in POOL. */
+static svn_error_t *
+prefetch_auth(report_baton_t *b, const char *t_path, apr_hash_t *t_entries,
+              apr_pool_t *pool)
+{
+  apr_array_header_t *paths = apr_array_make(pool, apr_hash_count(t_entries),
+                                             sizeof(const char *));
+  svn_boolean_t *allowed;
+  apr_hash_index_t *hi;
+  int i;
+
+  for (hi = apr_hash_first(pool, t_entries); hi; hi = apr_hash_next(hi))
+    APR_ARRAY_PUSH(paths, const char *)
+      = svn_fspath__join(t_path, apr_hash_this_key(hi), pool);
+
+  allowed = apr_palloc(pool, paths->nelts * sizeof(*allowed));
+  SVN_ERR(svn_repos__authz_read_many(allowed, b->t_root, paths,
+                                     b->authz_read_func, b->authz_read_baton,
+                                     pool));
+
+  b->authz_prefetched = apr_hash_make(pool);
+  for (i = 0; i < paths->nelts; ++i)
+    svn_hash_sets(b->authz_prefetched, APR_ARRAY_IDX(paths, i, const char *),
+                  &allowed[i]);
+
+  return SVN_NO_ERROR;
+}
+
 /* Create a dirent in *ENTRY for the given ROOT and PATH.  We use this to
    replace the source or target dirent when a report pathinfo tells us to
    change paths or revisions. */
@@ -1178,6 +1950,7 @@ delta_dirs(report_baton_t *b, svn_revnum_t s_rev, const char *s_path,
       || requested_depth == svn_depth_unknown)
     {
       apr_pool_t *iterpool;
+      apr_hash_t *outer_prefetched;
 
       /* Get the list of entries in each of source and target. */
       if (s_path && !start_empty)
@@ -1301,9 +2074,27 @@ delta_dirs(report_baton_t *b, svn_revnum_t s_rev, const char *s_path,
             }
         }
 
+      /* Batch-capable authz implementations check all remaining target
+         entries at once.  Sub-directories install their own results
+         while being processed, so restore ours afterwards. */
+      outer_prefetched = b->authz_prefetched;
+      if (svn_repos__authz_read_is_batched(b->authz_read_func)
+          && apr_hash_count(t_entries))
+        SVN_ERR(prefetch_auth(b, t_path, t_entries, subpool));
+
       /* Loop over the dirents in the target. */
       SVN_ERR(svn_fs_dir_optimal_order(&t_ordered_entries, b->t_root,
                                        t_entries, subpool, iterpool));
+
+      /* Let the workers start on the file deltas that we will need. */
+      if (b->prefetcher)
+        {
+          b->prefetcher->depth++;
+          SVN_ERR(prefetch_deltas(b, s_rev, s_path, s_entries, t_path,
+                                  t_ordered_entries, wc_depth,
+                                  requested_depth, subpool));
+        }
+
       for (i = 0; i < t_ordered_entries->nelts; ++i)
         {
           const svn_fs_dirent_t *t_entry
@@ -1350,6 +2141,13 @@ delta_dirs(report_baton_t *b, svn_revnum_t s_rev, const char *s_path,
                                iterpool));
         }
 
+      b->authz_prefetched = outer_prefetched;
+      if (b->prefetcher)
+        {
+          SVN_ERR(release_prefetched_deltas(b));
+          b->prefetcher->depth--;
+        }
+
       /* iterpool is destroyed by destroying its parent (subpool) below */
     }
 
@@ -1471,6 +2269,8 @@ finish_report(report_baton_t *b, apr_pool_t *pool)
   for (i = 0; i < NUM_CACHED_SOURCE_ROOTS; i++)
     b->s_roots[i] = NULL;
 
+  SVN_ERR(prefetcher_create(&b->prefetcher, b, b->delta_threads));
+
   {
     svn_error_t *err = svn_error_trace(drive(b, s_rev, info, pool));
 
@@ -1628,6 +2428,9 @@ svn_repos_begin_report3(void **report_baton,
   b->edit_baton = edit_baton;
   b->authz_read_func = authz_read_func;
   b->authz_read_baton = authz_read_baton;
+  b->authz_prefetched = NULL;
+  b->delta_threads = 0;
+  b->prefetcher = NULL;
   b->revision_infos = apr_hash_make(pool);
   b->pool = pool;
   b->reader = svn_spillbuf__reader_create(1000 /* blocksize */,
@@ -1639,3 +2442,11 @@ svn_repos_begin_report3(void **report_baton,
   *report_baton = b;
   return SVN_NO_ERROR;
 }
+
+void
+svn_repos__report_set_delta_threads(void *report_baton,
+                                    int threads)
+{
+  report_baton_t *b = report_baton;
+  b->delta_threads = threads;
+}
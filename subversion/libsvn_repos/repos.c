@@ -878,6 +878,11 @@ create_conf(svn_repos_t *repos, apr_pool_t *pool)
 "### Unless you specify an absolute path, the file's location is relative"   NL
 "### to the directory containing this file."                                 NL
 "# hooks-env = " SVN_REPOS__CONF_HOOKS_ENV                                   NL
+"### The allow-blame option controls whether svnserve calculates the"        NL
+"### blame information for 'svn blame' itself, so clients don't have to"     NL
+"### download every revision of the file.  Set it to false if that is too"   NL
+"### expensive for your server; clients then fall back to doing the work."   NL
+"# allow-blame = true"                                                       NL
 ""                                                                           NL
 "[sasl]"                                                                     NL
 "### This option specifies whether you want to use the Cyrus SASL"           NL
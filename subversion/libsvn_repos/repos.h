@@ -362,9 +362,122 @@ svn_repos__hooks_post_unlock(svn_repos_t *repos,
                              const char *username,
                              apr_pool_t *pool);
 
+
+/*** Log Index ***/
+
+/* An open log index, see svn_repos__log_index_sync(). */
+typedef struct svn_repos__log_index_t svn_repos__log_index_t;
+
+/* The maximum number of revisions that commits and read operations add
+   to a log index which fell behind.  Anything beyond that is left to
+   later operations or to 'svnadmin build-log-index'. */
+#define SVN_REPOS__LOG_INDEX_MAX_CATCHUP 100
+
+/* Set *INDEX to the log index of FS, if FS has one that covers all
+   revisions up to and including REVISION.  Otherwise, set *INDEX to NULL.
+   An index that is behind the youngest revision of FS will be updated
+   first, if possible, but by no more than SVN_REPOS__LOG_INDEX_MAX_CATCHUP
+   revisions.
+
+   Allocate *INDEX in RESULT_POOL; it will be closed when that pool gets
+   cleared.  Use SCRATCH_POOL for temporary allocations. */
+svn_error_t *
+svn_repos__log_index_open(svn_repos__log_index_t **index,
+                          svn_fs_t *fs,
+                          svn_revnum_t revision,
+                          apr_pool_t *result_pool,
+                          apr_pool_t *scratch_pool);
+
+/* Using INDEX, find the next interesting location in the history of the
+   node at PATH@REVISION, the way svn_fs_history_prev2() with CROSS_COPIES
+   would.  If INCLUSIVE is set, REVISION itself is a candidate; otherwise,
+   REVISION has already been reported and we look further back in time.
+
+   Set *PREV_PATH and *PREV_REV to that location, or to NULL and
+   SVN_INVALID_REVNUM if there is no further history.  PREV_PATH will be
+   allocated in RESULT_POOL.  Use SCRATCH_POOL for temporary allocations.
+ */
+svn_error_t *
+svn_repos__log_index_history_prev(const char **prev_path,
+                                  svn_revnum_t *prev_rev,
+                                  svn_repos__log_index_t *index,
+                                  const char *path,
+                                  svn_revnum_t revision,
+                                  svn_boolean_t inclusive,
+                                  svn_boolean_t cross_copies,
+                                  apr_pool_t *result_pool,
+                                  apr_pool_t *scratch_pool);
+
+/* Set *CHANGES to the mergeinfo changes of revision REVISION as recorded
+   in INDEX, in the same form as svn_repos__get_mergeinfo_changes() does.
+   Allocate *CHANGES in RESULT_POOL.  Use SCRATCH_POOL for temporary
+   allocations. */
+svn_error_t *
+svn_repos__log_index_get_mergeinfo_changes(apr_array_header_t **changes,
+                                           svn_repos__log_index_t *index,
+                                           svn_revnum_t revision,
+                                           apr_pool_t *result_pool,
+                                           apr_pool_t *scratch_pool);
+
+/* Using INDEX, invoke RECEIVER with BATON for every strict descendant of
+   PATH that has explicit, valid mergeinfo in REVISION, just like
+   svn_fs_get_mergeinfo3() does with INCLUDE_DESCENDANTS set.
+   Use SCRATCH_POOL for temporary allocations. */
+svn_error_t *
+svn_repos__log_index_get_descendant_mergeinfo(
+  svn_repos__log_index_t *index,
+  const char *path,
+  svn_revnum_t revision,
+  svn_fs_mergeinfo_receiver_t receiver,
+  void *baton,
+  apr_pool_t *scratch_pool);
+
 
 /*** Utility Functions ***/
 
+/* Return TRUE iff AUTHZ_READ_FUNC can check multiple paths in a single
+   call, i.e. if svn_repos__authz_read_many() is cheaper than checking
+   the paths individually. */
+svn_boolean_t
+svn_repos__authz_read_is_batched(svn_repos_authz_func_t authz_read_func);
+
+/* For all const char * PATHS in ROOT, set ALLOWED[i] to TRUE iff the i-th
+   path is readable according to AUTHZ_READ_FUNC and AUTHZ_READ_BATON.
+   ALLOWED must provide room for PATHS->NELTS elements.  AUTHZ_READ_FUNC
+   may be NULL, granting access to all paths.  Batch-capable callbacks
+   (see svn_repos__authz_batch_baton_t) get invoked only once.
+   Use SCRATCH_POOL for temporary allocations. */
+svn_error_t *
+svn_repos__authz_read_many(svn_boolean_t *allowed,
+                           svn_fs_root_t *root,
+                           const apr_array_header_t *paths,
+                           svn_repos_authz_func_t authz_read_func,
+                           void *authz_read_baton,
+                           apr_pool_t *scratch_pool);
+
+/* How the svn:mergeinfo of a path changed in a revision. */
+typedef struct svn_repos__mergeinfo_change_t
+{
+  /* The changed path (an fspath). */
+  const char *path;
+
+  /* The mergeinfo before and after the change, either explicit or
+     inherited.  Either may be NULL, but not both. */
+  svn_string_t *prev_mergeinfo;
+  svn_string_t *mergeinfo;
+} svn_repos__mergeinfo_change_t;
+
+/* Set *CHANGES to an array of svn_repos__mergeinfo_change_t * describing
+   the paths in revision REV of FS whose mergeinfo might have changed.
+   Allocate *CHANGES in RESULT_POOL.  Use SCRATCH_POOL for temporary
+   allocations. */
+svn_error_t *
+svn_repos__get_mergeinfo_changes(apr_array_header_t **changes,
+                                 svn_fs_t *fs,
+                                 svn_revnum_t rev,
+                                 apr_pool_t *result_pool,
+                                 apr_pool_t *scratch_pool);
+
 /* Set *PREV_PATH and *PREV_REV to the path and revision which
    represent the location at which PATH in FS was located immediately
    prior to REVISION iff there was a copy operation (to PATH or one of
@@ -202,6 +202,8 @@ svn_repos_history2(svn_fs_t *fs,
   const char *history_path;
   svn_revnum_t history_rev;
   svn_fs_root_t *root;
+  svn_repos__log_index_t *log_index;
+  svn_boolean_t first_time = TRUE;
 
   /* Validate the revisions. */
   if (! SVN_IS_VALID_REVNUM(start))
@@ -235,6 +237,12 @@ svn_repos_history2(svn_fs_t *fs,
 
   SVN_ERR(svn_fs_node_history2(&history, root, path, oldpool, oldpool));
 
+  /* If the repository has a log index, use it instead of the history
+     object, which we opened only to make sure that PATH exists. */
+  SVN_ERR(svn_repos__log_index_open(&log_index, fs, end, pool, pool));
+  history_path = path;
+  history_rev = end;
+
   /* Now, we loop over the history items, calling svn_fs_history_prev(). */
   do
     {
@@ -244,16 +252,32 @@ svn_repos_history2(svn_fs_t *fs,
       apr_pool_t *tmppool;
       svn_error_t *err;
 
-      SVN_ERR(svn_fs_history_prev2(&history, history, cross_copies, newpool,
-                                   oldpool));
+      if (log_index)
+        {
+          SVN_ERR(svn_repos__log_index_history_prev(&history_path,
+                                                    &history_rev, log_index,
+                                                    history_path, history_rev,
+                                                    first_time, cross_copies,
+                                                    newpool, oldpool));
+          first_time = FALSE;
+
+          /* Only continue if there is further history to deal with. */
+          if (! history_path)
+            break;
+        }
+      else
+        {
+          SVN_ERR(svn_fs_history_prev2(&history, history, cross_copies,
+                                       newpool, oldpool));
 
-      /* Only continue if there is further history to deal with. */
-      if (! history)
-        break;
+          /* Only continue if there is further history to deal with. */
+          if (! history)
+            break;
 
-      /* Fetch the location information for this history step. */
-      SVN_ERR(svn_fs_history_location(&history_path, &history_rev,
-                                      history, newpool));
+          /* Fetch the location information for this history step. */
+          SVN_ERR(svn_fs_history_location(&history_path, &history_rev,
+                                          history, newpool));
+        }
 
       /* If this history item predates our START revision, quit
          here. */
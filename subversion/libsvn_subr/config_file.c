@@ -1155,6 +1155,22 @@ svn_config_ensure(const char *config_dir, apr_pool_t *pool)
         "###                              HTTP operation."                   NL
         "###   http-chunked-requests      Whether to use chunked transfer"   NL
         "###                              encoding for HTTP requests body."  NL
+        "###   http-protocol              HTTP protocol version to use:"     NL
+        "###                              'http/1.1' (default) or 'h2'. With"NL
+        "###                              'h2', https connections offer"     NL
+        "###                              HTTP/2 and fall back to HTTP/1.1"  NL
+        "###                              if the server declines; http"      NL
+        "###                              connections always use HTTP/2."    NL
+        "###   http-content-cache         Directory in which to cache file"  NL
+        "###                              contents fetched over http(s),"    NL
+        "###                              keyed by their SHA-1 checksum, to" NL
+        "###                              share between checkouts, exports"  NL
+        "###                              and updates. Unset by default (no" NL
+        "###                              cache)."                           NL
+        "###   http-content-cache-size    Size in megabytes beyond which"    NL
+        "###                              least recently used entries are"   NL
+        "###                              removed from http-content-cache;"  NL
+        "###                              0 means no limit. Default: 1024."  NL
         "###   http-auth-types            List of HTTP authentication types."NL
         "###   ssl-authority-files        List of files, each of a trusted CA"
                                                                              NL
@@ -1169,6 +1185,11 @@ svn_config_ensure(const char *config_dir, apr_pool_t *pool)
         "###   http-bulk-updates          Whether to request bulk update"    NL
         "###                              responses or to fetch each file"   NL
         "###                              in an individual request. "        NL
+        "###   svn-max-connections        Maximum number of parallel server" NL
+        "###                              connections used to fetch file"    NL
+        "###                              contents during svn:// updates."   NL
+        "###                              Defaults to 1 (no extra"           NL
+        "###                              connections)."                     NL
         "###   store-passwords            Specifies whether passwords used"  NL
         "###                              to authenticate against a"         NL
         "###                              Subversion server may be cached"   NL
@@ -1511,6 +1532,18 @@ svn_config_ensure(const char *config_dir, apr_pool_t *pool)
         "### to show meaningful differences for binary file formats.  [New"  NL
         "### in 1.9]"                                                        NL
         "# diff-ignore-content-type = no"                                    NL
+        "### Set blame-diff-threads to the number of threads that 'svn"      NL
+        "### blame' may use to compare subsequent file revisions while"      NL
+        "### later revisions are still being fetched.  [New in 1.12]"        NL
+        "# blame-diff-threads = 1"                                           NL
+        "### Set blame-cache to 'yes' to keep the results of 'svn blame'"    NL
+        "### in the configuration area, so that blaming the same file again" NL
+        "### only needs to process revisions added since.  [New in 1.12]"    NL
+        "# blame-cache = no"                                                 NL
+        "### Set server-side-blame to 'no' to always calculate the blame"    NL
+        "### of a file locally.  Capable servers are only asked to do it if" NL
+        "### blame-diff-threads and blame-cache are not set.  [New in 1.12]" NL
+        "# server-side-blame = yes"                                          NL
         ""                                                                   NL
         "### Section for configuring automatic properties."                  NL
         "[auto-props]"                                                       NL
@@ -25,6 +25,7 @@
 
 
 #include <assert.h>
+#include <stdlib.h>
 
 #include "svn_error.h"
 #include "svn_hash.h"
@@ -57,6 +58,10 @@ typedef struct object_ref_t
 
   /* Number of references to this data struct */
   volatile svn_atomic_t ref_count;
+
+  /* Value of OBJECT_POOL->USE_COUNTER when this entry got last handed
+   * out.  Used to find the least recently used entries. */
+  apr_uint64_t last_use;
 } object_ref_t;
 
 
@@ -83,6 +88,14 @@ struct svn_object_pool__t
      Hence we must not strictly depend on it. */
   volatile svn_atomic_t unused_count;
 
+  /* If not 0, keep up to this many unused entries around, evicting the
+   * least recently used ones first.  If 0, remove all unused entries as
+   * soon as they make up about half of all entries. */
+  apr_size_t max_unused;
+
+  /* Incremented every time an entry gets handed out. */
+  apr_uint64_t use_counter;
+
   /* the root pool owning this structure */
   apr_pool_t *pool;
 };
@@ -135,6 +148,64 @@ remove_unused_objects(svn_object_pool__t *object_pool)
   svn_pool_destroy(subpool);
 }
 
+/* Sort object_ref_t * by their LAST_USE, least recent ones first. */
+static int
+compare_last_use(const void *lhs,
+                 const void *rhs)
+{
+  const object_ref_t *lhs_ref = *(const object_ref_t *const *)lhs;
+  const object_ref_t *rhs_ref = *(const object_ref_t *const *)rhs;
+
+  if (lhs_ref->last_use == rhs_ref->last_use)
+    return 0;
+
+  return lhs_ref->last_use < rhs_ref->last_use ? -1 : 1;
+}
+
+/* Remove the least recently used entries from OBJECTS in OBJECT_POOL that
+ * have a ref-count of 0 until only 3/4 of OBJECT_POOL->MAX_UNUSED unused
+ * entries are left.  Evicting more than strictly necessary means that we
+ * don't need to do this for every single insertion.
+ *
+ * Requires external serialization on OBJECT_POOL.
+ */
+static void
+remove_lru_objects(svn_object_pool__t *object_pool)
+{
+  apr_pool_t *subpool = svn_pool_create(object_pool->pool);
+  apr_array_header_t *unused
+    = apr_array_make(subpool, apr_hash_count(object_pool->objects),
+                     sizeof(object_ref_t *));
+  apr_size_t to_keep = object_pool->max_unused - object_pool->max_unused / 4;
+  apr_hash_index_t *hi;
+  int i;
+
+  for (hi = apr_hash_first(subpool, object_pool->objects);
+       hi != NULL;
+       hi = apr_hash_next(hi))
+    {
+      object_ref_t *object_ref = apr_hash_this_val(hi);
+      if (svn_atomic_read(&object_ref->ref_count) == 0)
+        APR_ARRAY_PUSH(unused, object_ref_t *) = object_ref;
+    }
+
+  qsort(unused->elts, unused->nelts, unused->elt_size, compare_last_use);
+
+  for (i = 0; i + to_keep < (apr_size_t)unused->nelts; ++i)
+    {
+      object_ref_t *object_ref = APR_ARRAY_IDX(unused, i, object_ref_t *);
+
+      apr_hash_set(object_pool->objects, object_ref->key.data,
+                   object_ref->key.size, NULL);
+      svn_atomic_dec(&object_pool->object_count);
+      svn_atomic_dec(&object_pool->unused_count);
+
+      svn_pool_destroy(object_ref->pool);
+    }
+
+  svn_pool_destroy(subpool);
+}
+
 /* Cleanup function called when an object_ref_t gets released.
  */
 static apr_status_t
@@ -167,6 +238,9 @@ static void
 add_object_ref(object_ref_t *object_ref,
               apr_pool_t *pool)
 {
+  /* Remember when this entry has been used last. */
+  object_ref->last_use = ++object_ref->object_pool->use_counter;
+
   /* Update ref counter.
      Note that this is racy with object_ref_cleanup; see comment there. */
   if (svn_atomic_inc(&object_ref->ref_count) == 0)
@@ -253,8 +327,14 @@ insert(void **object,
   add_object_ref(object_ref, result_pool);
 
   /* limit memory usage */
-  if (svn_atomic_read(&object_pool->unused_count) * 2
-      > apr_hash_count(object_pool->objects) + 2)
+  if (object_pool->max_unused)
+    {
+      if (svn_atomic_read(&object_pool->unused_count)
+          > object_pool->max_unused)
+        remove_lru_objects(object_pool);
+    }
+  else if (svn_atomic_read(&object_pool->unused_count) * 2
+           > apr_hash_count(object_pool->objects) + 2)
     remove_unused_objects(object_pool);
 
   return SVN_NO_ERROR;
@@ -267,6 +347,16 @@ svn_error_t *
 svn_object_pool__create(svn_object_pool__t **object_pool,
                         svn_boolean_t thread_safe,
                         apr_pool_t *pool)
+{
+  return svn_error_trace(svn_object_pool__create2(object_pool, thread_safe,
+                                                  0, pool));
+}
+
+svn_error_t *
+svn_object_pool__create2(svn_object_pool__t **object_pool,
+                         svn_boolean_t thread_safe,
+                         apr_size_t max_unused,
+                         apr_pool_t *pool)
 {
   svn_object_pool__t *result;
 
@@ -278,6 +368,7 @@ svn_object_pool__create(svn_object_pool__t **object_pool,
 
   result->pool = pool;
   result->objects = svn_hash__make(result->pool);
+  result->max_unused = max_unused;
 
   /* make sure we clean up nicely.
    * We need two cleanup functions of which exactly one will be run
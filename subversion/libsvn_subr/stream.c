@@ -1521,6 +1521,182 @@ svn_stream_checksummed2(svn_stream_t *stream,
   return s;
 }
 
+/* Multi-digest checksummed stream support */
+
+struct multi_checksum_stream_baton
+{
+  /* One context per requested checksum and the locations to store the
+     final results in. */
+  int count;
+  svn_checksum_ctx_t **ctxs;
+  svn_checksum_t ***checksums;  /* Output values. */
+
+  /* Number of bytes passed through so far.  Optional output value. */
+  svn_filesize_t bytes;
+  svn_filesize_t *size;
+
+  svn_stream_t *proxy;
+
+  /* True if more data should be read when closing the stream. */
+  svn_boolean_t read_more;
+
+  /* Pool to allocate read buffer and output values from. */
+  apr_pool_t *pool;
+};
+
+/* Feed LEN bytes at DATA into all checksum contexts of BTN. */
+static svn_error_t *
+multi_checksum_update(struct multi_checksum_stream_baton *btn,
+                      const char *data,
+                      apr_size_t len)
+{
+  int i;
+
+  if (len == 0)
+    return SVN_NO_ERROR;
+
+  for (i = 0; i < btn->count; ++i)
+    SVN_ERR(svn_checksum_update(btn->ctxs[i], data, len));
+
+  btn->bytes += len;
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+read_handler_multi_checksum(void *baton, char *buffer, apr_size_t *len)
+{
+  struct multi_checksum_stream_baton *btn = baton;
+
+  SVN_ERR(svn_stream_read2(btn->proxy, buffer, len));
+
+  return svn_error_trace(multi_checksum_update(btn, buffer, *len));
+}
+
+static svn_error_t *
+read_full_handler_multi_checksum(void *baton, char *buffer, apr_size_t *len)
+{
+  struct multi_checksum_stream_baton *btn = baton;
+  apr_size_t saved_len = *len;
+
+  SVN_ERR(svn_stream_read_full(btn->proxy, buffer, len));
+  SVN_ERR(multi_checksum_update(btn, buffer, *len));
+
+  if (saved_len != *len)
+    btn->read_more = FALSE;
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+write_handler_multi_checksum(void *baton, const char *buffer, apr_size_t *len)
+{
+  struct multi_checksum_stream_baton *btn = baton;
+
+  SVN_ERR(multi_checksum_update(btn, buffer, *len));
+
+  return svn_error_trace(svn_stream_write(btn->proxy, buffer, len));
+}
+
+static svn_error_t *
+data_available_handler_multi_checksum(void *baton,
+                                      svn_boolean_t *data_available)
+{
+  struct multi_checksum_stream_baton *btn = baton;
+
+  return svn_error_trace(svn_stream_data_available(btn->proxy,
+                                                   data_available));
+}
+
+static svn_error_t *
+close_handler_multi_checksum(void *baton)
+{
+  struct multi_checksum_stream_baton *btn = baton;
+  int i;
+
+  /* If we're supposed to drain the stream, do so before finalizing the
+     checksums. */
+  if (btn->read_more)
+    {
+      char *buf = apr_palloc(btn->pool, SVN__STREAM_CHUNK_SIZE);
+      apr_size_t len = SVN__STREAM_CHUNK_SIZE;
+
+      do
+        {
+          SVN_ERR(read_full_handler_multi_checksum(baton, buf, &len));
+        }
+      while (btn->read_more);
+    }
+
+  for (i = 0; i < btn->count; ++i)
+    SVN_ERR(svn_checksum_final(btn->checksums[i], btn->ctxs[i], btn->pool));
+
+  if (btn->size)
+    *btn->size = btn->bytes;
+
+  return svn_error_trace(svn_stream_close(btn->proxy));
+}
+
+static svn_error_t *
+seek_handler_multi_checksum(void *baton, const svn_stream_mark_t *mark)
+{
+  struct multi_checksum_stream_baton *btn = baton;
+  int i;
+
+  /* Only reset support. */
+  if (mark)
+    return svn_error_create(SVN_ERR_STREAM_SEEK_NOT_SUPPORTED, NULL, NULL);
+
+  for (i = 0; i < btn->count; ++i)
+    SVN_ERR(svn_checksum_ctx_reset(btn->ctxs[i]));
+
+  btn->bytes = 0;
+
+  return svn_error_trace(svn_stream_reset(btn->proxy));
+}
+
+svn_stream_t *
+svn_stream__checksummed(svn_stream_t *stream,
+                        svn_checksum_t **checksums[],
+                        const svn_checksum_kind_t kinds[],
+                        int count,
+                        svn_filesize_t *size,
+                        svn_boolean_t read_all,
+                        apr_pool_t *pool)
+{
+  svn_stream_t *s;
+  struct multi_checksum_stream_baton *baton;
+  int i;
+
+  if (count == 0 && size == NULL)
+    return stream;
+
+  baton = apr_pcalloc(pool, sizeof(*baton));
+  baton->count = count;
+  baton->ctxs = apr_palloc(pool, count * sizeof(*baton->ctxs));
+  baton->checksums = apr_palloc(pool, count * sizeof(*baton->checksums));
+  for (i = 0; i < count; ++i)
+    {
+      baton->ctxs[i] = svn_checksum_ctx_create(kinds[i], pool);
+      baton->checksums[i] = checksums[i];
+    }
+
+  baton->size = size;
+  baton->proxy = stream;
+  baton->read_more = read_all;
+  baton->pool = pool;
+
+  s = svn_stream_create(baton, pool);
+  svn_stream_set_read2(s, read_handler_multi_checksum,
+                       read_full_handler_multi_checksum);
+  svn_stream_set_write(s, write_handler_multi_checksum);
+  svn_stream_set_data_available(s, data_available_handler_multi_checksum);
+  svn_stream_set_close(s, close_handler_multi_checksum);
+  if (svn_stream_supports_reset(stream))
+    svn_stream_set_seek(s, seek_handler_multi_checksum);
+  return s;
+}
+
 /* Helper for svn_stream_contents_checksum() to compute checksum of
  * KIND of STREAM. This function doesn't close source stream. */
 static svn_error_t *
@@ -40,6 +40,7 @@
 #include "token-map.h"
 
 #include "svn_private_config.h"
+#include "private/svn_io_private.h"
 #include "private/svn_wc_private.h"
 #include "private/svn_sqlite.h"
 #include "private/svn_token.h"
@@ -1041,9 +1042,12 @@ migrate_text_bases(apr_hash_t **text_bases_info,
         const char *text_base_path;
         const char *temp_path;
         svn_sqlite__stmt_t *stmt;
-        apr_finfo_t finfo;
+        svn_filesize_t size;
         svn_stream_t *read_stream;
         svn_stream_t *result_stream;
+        svn_checksum_t **checksums[2];
+        const svn_checksum_kind_t kinds[2] = { svn_checksum_md5,
+                                               svn_checksum_sha1 };
 
         text_base_path = svn_dirent_join(text_base_dir, text_base_basename,
                                          iterpool);
@@ -1057,26 +1061,23 @@ migrate_text_bases(apr_hash_t **text_bases_info,
         SVN_ERR(svn_stream_open_readonly(&read_stream, text_base_path,
                                            iterpool, iterpool));
 
-        read_stream = svn_stream_checksummed2(read_stream, &md5_checksum,
-                                              NULL, svn_checksum_md5,
-                                              TRUE, iterpool);
+        checksums[0] = &md5_checksum;
+        checksums[1] = &sha1_checksum;
 
-        read_stream = svn_stream_checksummed2(read_stream, &sha1_checksum,
-                                              NULL, svn_checksum_sha1,
-                                              TRUE, iterpool);
+        read_stream = svn_stream__checksummed(read_stream, checksums, kinds,
+                                              2, &size, TRUE, iterpool);
 
-        /* This calculates the hash, creates a copy and closes the stream */
+        /* This calculates the hashes and the size, creates a copy and
+           closes the stream */
         SVN_ERR(svn_stream_copy3(read_stream, result_stream,
                                  NULL, NULL, iterpool));
 
-        SVN_ERR(svn_io_stat(&finfo, text_base_path, APR_FINFO_SIZE, iterpool));
-
         /* Insert a row into the pristine table. */
         SVN_ERR(svn_sqlite__get_statement(&stmt, sdb,
                                           STMT_INSERT_OR_IGNORE_PRISTINE));
         SVN_ERR(svn_sqlite__bind_checksum(stmt, 1, sha1_checksum, iterpool));
         SVN_ERR(svn_sqlite__bind_checksum(stmt, 2, md5_checksum, iterpool));
-        SVN_ERR(svn_sqlite__bind_int64(stmt, 3, finfo.size));
+        SVN_ERR(svn_sqlite__bind_int64(stmt, 3, size));
         SVN_ERR(svn_sqlite__insert(NULL, stmt));
 
         SVN_ERR(svn_wc__db_pristine_get_future_path(&pristine_path,
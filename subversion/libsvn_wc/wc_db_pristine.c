@@ -369,6 +369,9 @@ svn_wc__db_pristine_prepare_install(svn_stream_t **stream,
   svn_wc__db_wcroot_t *wcroot;
   const char *local_relpath;
   const char *temp_dir_abspath;
+  svn_checksum_t **checksums[2];
+  svn_checksum_kind_t kinds[2];
+  int count = 0;
 
   SVN_ERR_ASSERT(svn_dirent_is_absolute(wri_abspath));
 
@@ -388,12 +391,20 @@ svn_wc__db_pristine_prepare_install(svn_stream_t **stream,
 
   (*install_data)->inner_stream = *stream;
 
+  /* Calculate all requested digests in a single pass. */
   if (md5_checksum)
-    *stream = svn_stream_checksummed2(*stream, NULL, md5_checksum,
-                                      svn_checksum_md5, FALSE, result_pool);
+    {
+      kinds[count] = svn_checksum_md5;
+      checksums[count++] = md5_checksum;
+    }
   if (sha1_checksum)
-    *stream = svn_stream_checksummed2(*stream, NULL, sha1_checksum,
-                                      svn_checksum_sha1, FALSE, result_pool);
+    {
+      kinds[count] = svn_checksum_sha1;
+      checksums[count++] = sha1_checksum;
+    }
+
+  *stream = svn_stream__checksummed(*stream, checksums, kinds, count, NULL,
+                                    FALSE, result_pool);
 
   return SVN_NO_ERROR;
 }
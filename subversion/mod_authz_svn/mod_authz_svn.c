@@ -47,6 +47,7 @@
 #include "svn_pools.h"
 #include "svn_dirent_uri.h"
 #include "private/svn_fspath.h"
+#include "private/svn_repos_private.h"
 
 /* The apache headers define these and they conflict with our definitions. */
 #ifdef PACKAGE_BUGREPORT
@@ -872,6 +873,81 @@ subreq_bypass(request_rec *r,
   return status;
 }
 
+/*
+ * Implementation of subreq_bypass_batch with scratch_pool parameter.
+ */
+static int
+subreq_bypass_batch2(request_rec *r,
+                     const apr_array_header_t *repos_paths,
+                     const char *repos_name,
+                     svn_boolean_t *allowed,
+                     apr_pool_t *scratch_pool)
+{
+  svn_error_t *svn_err = NULL;
+  svn_authz_t *access_conf = NULL;
+  authz_svn_config_rec *conf = NULL;
+  const char *username_to_authorize;
+  int i;
+
+  conf = ap_get_module_config(r->per_dir_config,
+                              &authz_svn_module);
+  username_to_authorize = get_username_to_authorize(r, conf, scratch_pool);
+
+  /* If configured properly, this should never be true, but just in case. */
+  if (!conf->anonymous
+      || (! (conf->access_file || conf->repo_relative_access_file)))
+    return HTTP_FORBIDDEN;
+
+  /* Retrieve authorization file */
+  access_conf = get_access_conf(r, conf, scratch_pool);
+  if (access_conf == NULL)
+    return HTTP_FORBIDDEN;
+
+  /* Perform authz access control for all paths in one go.
+   * See similarly labeled comment in req_check_access.
+   */
+  svn_err = svn_repos__authz_check_access_many(access_conf, repos_name,
+                                               repos_paths,
+                                               username_to_authorize,
+                                               svn_authz_none|svn_authz_read,
+                                               allowed, scratch_pool);
+  if (svn_err)
+    {
+      log_svn_error(APLOG_MARK, r,
+                    "Failed to perform access control:",
+                    svn_err, scratch_pool);
+      return HTTP_FORBIDDEN;
+    }
+
+  for (i = 0; i < repos_paths->nelts; ++i)
+    log_access_verdict(APLOG_MARK, r, allowed[i], TRUE,
+                       APR_ARRAY_IDX(repos_paths, i, const char *), NULL);
+
+  return OK;
+}
+
+/*
+ * This function is used as a provider to allow mod_dav_svn to check
+ * GET access to multiple paths at once without generating apache
+ * requests.  See subreq_bypass.
+ */
+static int
+subreq_bypass_batch(request_rec *r,
+                    const apr_array_header_t *repos_paths,
+                    const char *repos_name,
+                    svn_boolean_t *allowed)
+{
+  int status;
+  apr_pool_t *scratch_pool;
+
+  scratch_pool = svn_pool_create(r->pool);
+  status = subreq_bypass_batch2(r, repos_paths, repos_name, allowed,
+                                scratch_pool);
+  svn_pool_destroy(scratch_pool);
+
+  return status;
+}
+
 /*
  * Hooks
  */
@@ -1102,6 +1178,11 @@ register_hooks(apr_pool_t *p)
                        AUTHZ_SVN__SUBREQ_BYPASS_PROV_NAME,
                        AUTHZ_SVN__SUBREQ_BYPASS_PROV_VER,
                        (void*)subreq_bypass);
+  ap_register_provider(p,
+                       AUTHZ_SVN__SUBREQ_BYPASS_PROV_GRP,
+                       AUTHZ_SVN__SUBREQ_BYPASS_BATCH_PROV_NAME,
+                       AUTHZ_SVN__SUBREQ_BYPASS_BATCH_PROV_VER,
+                       (void*)subreq_bypass_batch);
 }
 
 module AP_MODULE_DECLARE_DATA authz_svn_module =
@@ -98,6 +98,69 @@ dav_svn__allow_read(request_rec *r,
 }
 
 
+void
+dav_svn__allow_read_many(svn_boolean_t *allowed,
+                         request_rec *r,
+                         const dav_svn_repos *repos,
+                         const apr_array_header_t *paths,
+                         svn_revnum_t rev,
+                         apr_pool_t *pool)
+{
+  authz_svn__subreq_bypass_batch_func_t allow_read_bypass_batch = NULL;
+  apr_pool_t *iterpool;
+  int i;
+
+  /* Easy out:  if the admin has explicitly set 'SVNPathAuthz Off',
+     then this whole callback does nothing. */
+  if (! dav_svn__get_pathauthz_flag(r))
+    {
+      for (i = 0; i < paths->nelts; ++i)
+        allowed[i] = TRUE;
+
+      return;
+    }
+
+  /* With the bypass, let authz check all paths in a single go. */
+  allow_read_bypass_batch = dav_svn__get_pathauthz_bypass_batch(r);
+  if (allow_read_bypass_batch != NULL)
+    {
+      apr_array_header_t *abs_paths
+        = apr_array_make(pool, paths->nelts, sizeof(const char *));
+
+      /* See dav_svn__allow_read() for why we need to do this. */
+      for (i = 0; i < paths->nelts; ++i)
+        {
+          const char *path = APR_ARRAY_IDX(paths, i, const char *);
+          if (path && path[0] != '/')
+            path = apr_pstrcat(pool, "/", path, SVN_VA_NULL);
+
+          APR_ARRAY_PUSH(abs_paths, const char *) = path;
+        }
+
+      if (allow_read_bypass_batch(r, abs_paths, repos->repo_basename,
+                                  allowed) != OK)
+        {
+          for (i = 0; i < paths->nelts; ++i)
+            allowed[i] = FALSE;
+        }
+
+      return;
+    }
+
+  /* Fall back to checking one path at a time. */
+  iterpool = svn_pool_create(pool);
+  for (i = 0; i < paths->nelts; ++i)
+    {
+      svn_pool_clear(iterpool);
+      allowed[i] = dav_svn__allow_read(r, repos,
+                                       APR_ARRAY_IDX(paths, i, const char *),
+                                       rev, iterpool);
+    }
+
+  svn_pool_destroy(iterpool);
+}
+
+
 svn_boolean_t
 dav_svn__allow_list_repos(request_rec *r,
                           const char *repos_name,
@@ -222,6 +285,46 @@ authz_read(svn_boolean_t *allowed,
   return SVN_NO_ERROR;
 }
 
+/* This function implements 'svn_repos__authz_batch_func_t', specifically
+   for read authorization.  Like authz_read() but for all PATHS at once.
+
+   BATON must be a pointer to a dav_svn__authz_read_baton.
+   Use POOL for for any temporary allocation.
+*/
+static svn_error_t *
+authz_read_batch(svn_boolean_t *allowed,
+                 svn_fs_root_t *root,
+                 const apr_array_header_t *paths,
+                 void *baton,
+                 apr_pool_t *pool)
+{
+  dav_svn__authz_read_baton *arb = baton;
+  apr_pool_t *iterpool;
+  int i;
+
+  /* Paths in revision roots map directly to (rev, path) pairs. */
+  if (! svn_fs_is_txn_root(root))
+    {
+      dav_svn__allow_read_many(allowed, arb->r, arb->repos, paths,
+                               svn_fs_revision_root_revision(root), pool);
+      return SVN_NO_ERROR;
+    }
+
+  /* Transaction paths need to be mapped individually. */
+  iterpool = svn_pool_create(pool);
+  for (i = 0; i < paths->nelts; ++i)
+    {
+      svn_pool_clear(iterpool);
+      SVN_ERR(authz_read(&allowed[i], root,
+                         APR_ARRAY_IDX(paths, i, const char *), baton,
+                         iterpool));
+    }
+
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
+
 
 svn_repos_authz_func_t
 dav_svn__authz_read_func(dav_svn__authz_read_baton *baton)
@@ -231,7 +334,11 @@ dav_svn__authz_read_func(dav_svn__authz_read_baton *baton)
   if (! dav_svn__get_pathauthz_flag(baton->r))
     return NULL;
 
-  return authz_read;
+  /* Allow libsvn_repos to check multiple paths at once. */
+  baton->batch.read_func = authz_read;
+  baton->batch.batch_func = authz_read_batch;
+
+  return svn_repos__authz_batch_read_func;
 }
 
 
@@ -37,6 +37,7 @@
 #include "svn_path.h"
 #include "svn_xml.h"
 #include "private/svn_dav_protocol.h"
+#include "private/svn_repos_private.h"
 #include "private/svn_skel.h"
 #include "mod_authz_svn.h"
 
@@ -349,10 +350,21 @@ svn_boolean_t dav_svn__get_block_read_flag(request_rec *r);
  */
 authz_svn__subreq_bypass_func_t dav_svn__get_pathauthz_bypass(request_rec *r);
 
+/* for the repository referred to by this request, are subrequests bypassed
+ * and can multiple paths be checked at once?
+ * A function pointer if yes, NULL if not.
+ */
+authz_svn__subreq_bypass_batch_func_t
+dav_svn__get_pathauthz_bypass_batch(request_rec *r);
+
 /* for the repository referred to by this request, is a GET of
    SVNParentPath allowed? */
 svn_boolean_t dav_svn__get_list_parentpath_flag(request_rec *r);
 
+/* for the repository referred to by this request, may clients ask us to
+   calculate blame information (SVNAllowBlame)? */
+svn_boolean_t dav_svn__get_allow_blame_flag(request_rec *r);
+
 /* For the repository referred to by this request, should HTTPv2
    protocol support be advertised?  Note that this also takes into
    account the support level expected of based on the specified
@@ -413,6 +425,17 @@ const char *dav_svn__get_master_uri(request_rec *r);
    Comes from the <SVNMasterVersion> directive. */
 svn_version_t *dav_svn__get_master_version(request_rec *r);
 
+/* Return whether a mirror should replay new revisions from its master
+   after proxying a commit, iff a master URI is in place for this
+   location.  Comes from the <SVNMasterReplay> directive. */
+svn_boolean_t dav_svn__get_master_replay_flag(request_rec *r);
+
+/* Return the user that replays commits into the mirror, and its password
+   at the master (or NULL if none was given).  Come from the
+   <SVNMasterReplayUser> directive. */
+const char *dav_svn__get_master_replay_user(request_rec *r);
+const char *dav_svn__get_master_replay_password(request_rec *r);
+
 /* Return the disk path to the activities db.
    Comes from the <SVNActivitiesDB> directive. */
 const char *dav_svn__get_activities_db(request_rec *r);
@@ -425,6 +448,10 @@ const char *dav_svn__get_root_dir(request_rec *r);
 /* Return the data compression level to be used over the wire. */
 int dav_svn__get_compression_level(request_rec *r);
 
+/* Return the number of threads per update report that calculate file
+   deltas ahead of the editor drive.  Comes from SVNUpdateDeltaThreads. */
+int dav_svn__get_update_delta_threads(request_rec *r);
+
 /* Return the hook script environment parsed from the configuration. */
 const char *dav_svn__get_hooks_env(request_rec *r);
 
@@ -702,6 +729,7 @@ static const dav_report_elem dav_svn__reports_list[] = {
   { SVN_XML_NAMESPACE, SVN_DAV__MERGEINFO_REPORT },
   { SVN_XML_NAMESPACE, SVN_DAV__INHERITED_PROPS_REPORT },
   { SVN_XML_NAMESPACE, "list-report" },
+  { SVN_XML_NAMESPACE, "blame-report" },
   { NULL, NULL },
 };
 
@@ -759,6 +787,11 @@ dav_svn__list_report(const dav_resource *resource,
                      const apr_xml_doc *doc,
                      dav_svn__output *output);
 
+dav_error *
+dav_svn__blame_report(const dav_resource *resource,
+                      const apr_xml_doc *doc,
+                      dav_svn__output *output);
+
 /*** posts/ ***/
 
 /* The various POST handlers, defined in posts/, and used by repos.c.  */
@@ -776,6 +809,10 @@ dav_svn__post_create_txn_with_props(const dav_resource *resource,
 /* A baton needed by dav_svn__authz_read_func(). */
 typedef struct dav_svn__authz_read_baton
 {
+  /* Batch lookup support, initialized by dav_svn__authz_read_func().
+     Must be the first member. */
+  svn_repos__authz_batch_baton_t batch;
+
   /* The original request, needed to generate a subrequest. */
   request_rec *r;
 
@@ -799,6 +836,19 @@ dav_svn__allow_read(request_rec *r,
                     svn_revnum_t rev,
                     apr_pool_t *pool);
 
+/* Like dav_svn__allow_read() but check all PATHS (an array of const
+   char *) in REPOS at REV at once and set ALLOWED[i] to TRUE iff the
+   i-th path is readable.  ALLOWED must provide room for PATHS->NELTS
+   elements.  Use POOL for any temporary allocation.
+*/
+void
+dav_svn__allow_read_many(svn_boolean_t *allowed,
+                         request_rec *r,
+                         const dav_svn_repos *repos,
+                         const apr_array_header_t *paths,
+                         svn_revnum_t rev,
+                         apr_pool_t *pool);
+
 /* Return TRUE iff the current user (as determined by Apache's
    authentication system) has permission to read RESOURCE in REV
    (where an invalid REV means "HEAD").  This will invoke any authz
@@ -827,7 +877,8 @@ dav_svn__allow_list_repos(request_rec *r,
                           apr_pool_t *pool);
 
 /* If authz is enabled in the specified BATON, return a read authorization
-   function. Otherwise, return NULL. */
+   function to be used with BATON. Otherwise, return NULL.  BATON->R and
+   BATON->REPOS must already be set. */
 svn_repos_authz_func_t
 dav_svn__authz_read_func(dav_svn__authz_read_baton *baton);
 
@@ -1153,6 +1204,29 @@ apr_status_t dav_svn__location_header_filter(ap_filter_t *f,
 apr_status_t dav_svn__location_body_filter(ap_filter_t *f,
                                            apr_bucket_brigade *bb);
 
+/* An Apache output filter F for proxied MERGE responses which passes the
+ * response in BB on, and then has the mirror replay the new revisions
+ * from its master. */
+apr_status_t dav_svn__mirror_replay_filter(ap_filter_t *f,
+                                           apr_bucket_brigade *bb);
+
+
+/*** mirror_replay.c ***/
+
+/* Set up the replay of proxied commits in the child process with the
+ * pool PCHILD.  Implements the child_init hook. */
+void
+dav_svn__mirror_replay_child_init(apr_pool_t *pchild,
+                                  server_rec *s);
+
+/* Queue the copy of the revisions that the master of the mirror R has
+ * and the mirror doesn't yet into the mirror's repository, the way
+ * svnsync does.  The copy runs in the background and doesn't hold up
+ * the response to R.
+ */
+svn_error_t *
+dav_svn__mirror_schedule_replay(request_rec *r);
+
 
 #ifdef __cplusplus
 }
@@ -27,6 +27,7 @@
 
 #include <httpd.h>
 #include <http_core.h>
+#include <http_log.h>
 
 #include "private/svn_fspath.h"
 
@@ -72,6 +73,16 @@ static int proxy_request_fixup(request_rec *r,
     ap_add_output_filter("LocationRewrite", NULL, r, r->connection);
     ap_add_output_filter("ReposRewrite", NULL, r, r->connection);
     ap_add_input_filter("IncomingRewrite", NULL, r, r->connection);
+
+    /* Let the client read its own commit from us soon. */
+    if (r->method_number == M_MERGE && dav_svn__get_master_replay_flag(r)) {
+        if (dav_svn__get_master_replay_user(r))
+            ap_add_output_filter("MasterReplay", NULL, r, r->connection);
+        else
+            ap_log_rerror(APLOG_MARK, APLOG_ERR, SVN_ERR_BAD_CONFIG_VALUE, r,
+                          "SVNMasterReplay requires SVNMasterReplayUser");
+    }
+
     return OK;
 }
 
@@ -340,3 +351,30 @@ apr_status_t dav_svn__location_body_filter(ap_filter_t *f,
     }
     return ap_pass_brigade(f->next, bb);
 }
+
+apr_status_t dav_svn__mirror_replay_filter(ap_filter_t *f,
+                                           apr_bucket_brigade *bb)
+{
+    request_rec *r = f->r;
+    svn_error_t *serr;
+
+    if (APR_BRIGADE_EMPTY(bb) || !APR_BUCKET_IS_EOS(APR_BRIGADE_LAST(bb)))
+        return ap_pass_brigade(f->next, bb);
+
+    /* The commit succeeded; have it copied over in the background.  If
+       that fails, svnsync will still deliver it later. */
+    if (r->status == HTTP_OK) {
+        serr = dav_svn__mirror_schedule_replay(r);
+        if (serr) {
+            char buf[256];
+
+            ap_log_rerror(APLOG_MARK, APLOG_WARNING, serr->apr_err, r,
+                          "Could not replay commit from master: %s",
+                          svn_err_best_message(serr, buf, sizeof(buf)));
+            svn_error_clear(serr);
+        }
+    }
+
+    ap_remove_output_filter(f);
+    return ap_pass_brigade(f->next, bb);
+}
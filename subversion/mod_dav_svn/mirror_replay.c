@@ -0,0 +1,848 @@
+/*
+ * mirror_replay.c: bring a mirror up to date with its master right
+ *                  after a proxied commit.
+ *
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ */
+
+/* A mirror (a location with SVNMasterURI) is normally kept up to date
+ * by svnsync, run from the master's post-commit hook.  Until that has
+ * finished, clients that just committed through the mirror can't see
+ * their own revision there.
+ *
+ * With SVNMasterReplay, the mirror replays the new revisions from the
+ * master into its own repository itself, as soon as it has passed the
+ * master's MERGE response on to the client.  The copy runs on a
+ * background thread of the httpd child process.  It follows svnsync's
+ * protocol: it takes the svn:sync-lock on revision 0, copies revisions
+ * the same way svnsync does and updates svn:sync-last-merged-rev, so a
+ * subsequent svnsync run finds nothing left to do.  All changes go
+ * through the repository's hooks as the SVNMasterReplayUser, like those
+ * of an svnsync run by that user.  If someone else holds the lock, they
+ * are already copying, and we leave it to them.
+ */
+
+#include <apr_network_io.h>
+#include <apr_strings.h>
+
+#if APR_HAS_THREADS
+#include <apr_thread_pool.h>
+#endif
+
+#include <httpd.h>
+#include <http_log.h>
+#include <mod_dav.h>
+
+#include "svn_auth.h"
+#include "svn_delta.h"
+#include "svn_dirent_uri.h"
+#include "svn_error.h"
+#include "svn_fs.h"
+#include "svn_hash.h"
+#include "svn_path.h"
+#include "svn_pools.h"
+#include "svn_props.h"
+#include "svn_ra.h"
+#include "svn_repos.h"
+
+#include "mod_dav_svn.h"
+#include "dav_svn.h"
+
+/* The maximum number of revisions copied by a single replay.  Mirrors
+   that are further behind are left to svnsync. */
+#define MAX_REPLAY_REVISIONS 16
+
+/* The maximum number of replays waiting for the replay thread of a
+   child process.  Each of them copies what the master has by the time
+   it runs, so we drop further requests. */
+#define MAX_QUEUED_REPLAYS 4
+
+
+/*** Editor that adapts replayed changes to a local commit editor ***/
+
+typedef struct edit_baton_t
+{
+  const svn_delta_editor_t *wrapped_editor;
+  void *wrapped_edit_baton;
+
+  /* URL of the local repository, used to turn copyfrom paths into URLs. */
+  const char *repos_url;
+
+  /* The revision the commit is based on. */
+  svn_revnum_t base_revision;
+
+  svn_boolean_t called_open_root;
+} edit_baton_t;
+
+typedef struct node_baton_t
+{
+  edit_baton_t *edit_baton;
+  void *wrapped_node_baton;
+} node_baton_t;
+
+static node_baton_t *
+make_node_baton(edit_baton_t *eb, apr_pool_t *pool)
+{
+  node_baton_t *nb = apr_palloc(pool, sizeof(*nb));
+
+  nb->edit_baton = eb;
+  nb->wrapped_node_baton = NULL;
+
+  return nb;
+}
+
+/* The replay gives us copyfrom paths relative to the repository root;
+   the commit editor wants URLs. */
+static const char *
+copyfrom_url(edit_baton_t *eb, const char *copyfrom_path, apr_pool_t *pool)
+{
+  if (copyfrom_path && copyfrom_path[0] == '/')
+    return svn_path_url_add_component2(eb->repos_url, copyfrom_path + 1,
+                                       pool);
+
+  return copyfrom_path;
+}
+
+static svn_error_t *
+set_target_revision(void *edit_baton,
+                    svn_revnum_t target_revision,
+                    apr_pool_t *pool)
+{
+  edit_baton_t *eb = edit_baton;
+  return eb->wrapped_editor->set_target_revision(eb->wrapped_edit_baton,
+                                                 target_revision, pool);
+}
+
+static svn_error_t *
+open_root(void *edit_baton,
+          svn_revnum_t base_revision,
+          apr_pool_t *pool,
+          void **root_baton)
+{
+  edit_baton_t *eb = edit_baton;
+  node_baton_t *db = make_node_baton(eb, pool);
+
+  SVN_ERR(eb->wrapped_editor->open_root(eb->wrapped_edit_baton,
+                                        base_revision, pool,
+                                        &db->wrapped_node_baton));
+
+  eb->called_open_root = TRUE;
+  *root_baton = db;
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+delete_entry(const char *path,
+             svn_revnum_t base_revision,
+             void *parent_baton,
+             apr_pool_t *pool)
+{
+  node_baton_t *pb = parent_baton;
+  edit_baton_t *eb = pb->edit_baton;
+
+  return eb->wrapped_editor->delete_entry(path, base_revision,
+                                          pb->wrapped_node_baton, pool);
+}
+
+static svn_error_t *
+add_directory(const char *path,
+              void *parent_baton,
+              const char *copyfrom_path,
+              svn_revnum_t copyfrom_rev,
+              apr_pool_t *pool,
+              void **child_baton)
+{
+  node_baton_t *pb = parent_baton;
+  edit_baton_t *eb = pb->edit_baton;
+  node_baton_t *db = make_node_baton(eb, pool);
+
+  SVN_ERR(eb->wrapped_editor->add_directory(path, pb->wrapped_node_baton,
+                                            copyfrom_url(eb, copyfrom_path,
+                                                         pool),
+                                            copyfrom_rev, pool,
+                                            &db->wrapped_node_baton));
+
+  *child_baton = db;
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+open_directory(const char *path,
+               void *parent_baton,
+               svn_revnum_t base_revision,
+               apr_pool_t *pool,
+               void **child_baton)
+{
+  node_baton_t *pb = parent_baton;
+  edit_baton_t *eb = pb->edit_baton;
+  node_baton_t *db = make_node_baton(eb, pool);
+
+  SVN_ERR(eb->wrapped_editor->open_directory(path, pb->wrapped_node_baton,
+                                             base_revision, pool,
+                                             &db->wrapped_node_baton));
+
+  *child_baton = db;
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+change_dir_prop(void *dir_baton,
+                const char *name,
+                const svn_string_t *value,
+                apr_pool_t *pool)
+{
+  node_baton_t *db = dir_baton;
+  edit_baton_t *eb = db->edit_baton;
+
+  /* Entry and working copy props don't go into the repository. */
+  if (svn_property_kind2(name) != svn_prop_regular_kind)
+    return SVN_NO_ERROR;
+
+  return eb->wrapped_editor->change_dir_prop(db->wrapped_node_baton,
+                                             name, value, pool);
+}
+
+static svn_error_t *
+close_directory(void *dir_baton,
+                apr_pool_t *pool)
+{
+  node_baton_t *db = dir_baton;
+  edit_baton_t *eb = db->edit_baton;
+
+  return eb->wrapped_editor->close_directory(db->wrapped_node_baton, pool);
+}
+
+static svn_error_t *
+absent_directory(const char *path,
+                 void *parent_baton,
+                 apr_pool_t *pool)
+{
+  node_baton_t *pb = parent_baton;
+  edit_baton_t *eb = pb->edit_baton;
+
+  return eb->wrapped_editor->absent_directory(path, pb->wrapped_node_baton,
+                                              pool);
+}
+
+static svn_error_t *
+add_file(const char *path,
+         void *parent_baton,
+         const char *copyfrom_path,
+         svn_revnum_t copyfrom_rev,
+         apr_pool_t *pool,
+         void **file_baton)
+{
+  node_baton_t *pb = parent_baton;
+  edit_baton_t *eb = pb->edit_baton;
+  node_baton_t *fb = make_node_baton(eb, pool);
+
+  SVN_ERR(eb->wrapped_editor->add_file(path, pb->wrapped_node_baton,
+                                       copyfrom_url(eb, copyfrom_path, pool),
+                                       copyfrom_rev, pool,
+                                       &fb->wrapped_node_baton));
+
+  *file_baton = fb;
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+open_file(const char *path,
+          void *parent_baton,
+          svn_revnum_t base_revision,
+          apr_pool_t *pool,
+          void **file_baton)
+{
+  node_baton_t *pb = parent_baton;
+  edit_baton_t *eb = pb->edit_baton;
+  node_baton_t *fb = make_node_baton(eb, pool);
+
+  SVN_ERR(eb->wrapped_editor->open_file(path, pb->wrapped_node_baton,
+                                        base_revision, pool,
+                                        &fb->wrapped_node_baton));
+
+  *file_baton = fb;
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+apply_textdelta(void *file_baton,
+                const char *base_checksum,
+                apr_pool_t *pool,
+                svn_txdelta_window_handler_t *handler,
+                void **handler_baton)
+{
+  node_baton_t *fb = file_baton;
+  edit_baton_t *eb = fb->edit_baton;
+
+  return eb->wrapped_editor->apply_textdelta(fb->wrapped_node_baton,
+                                             base_checksum, pool,
+                                             handler, handler_baton);
+}
+
+static svn_error_t *
+change_file_prop(void *file_baton,
+                 const char *name,
+                 const svn_string_t *value,
+                 apr_pool_t *pool)
+{
+  node_baton_t *fb = file_baton;
+  edit_baton_t *eb = fb->edit_baton;
+
+  /* Entry and working copy props don't go into the repository. */
+  if (svn_property_kind2(name) != svn_prop_regular_kind)
+    return SVN_NO_ERROR;
+
+  return eb->wrapped_editor->change_file_prop(fb->wrapped_node_baton,
+                                              name, value, pool);
+}
+
+static svn_error_t *
+close_file(void *file_baton,
+           const char *text_checksum,
+           apr_pool_t *pool)
+{
+  node_baton_t *fb = file_baton;
+  edit_baton_t *eb = fb->edit_baton;
+
+  return eb->wrapped_editor->close_file(fb->wrapped_node_baton,
+                                        text_checksum, pool);
+}
+
+static svn_error_t *
+absent_file(const char *path,
+            void *parent_baton,
+            apr_pool_t *pool)
+{
+  node_baton_t *pb = parent_baton;
+  edit_baton_t *eb = pb->edit_baton;
+
+  return eb->wrapped_editor->absent_file(path, pb->wrapped_node_baton,
+                                         pool);
+}
+
+static svn_error_t *
+close_edit(void *edit_baton,
+           apr_pool_t *pool)
+{
+  edit_baton_t *eb = edit_baton;
+
+  /* An empty revision still needs a root to commit. */
+  if (! eb->called_open_root)
+    {
+      void *baton;
+
+      SVN_ERR(eb->wrapped_editor->open_root(eb->wrapped_edit_baton,
+                                            eb->base_revision, pool,
+                                            &baton));
+      SVN_ERR(eb->wrapped_editor->close_directory(baton, pool));
+    }
+
+  return eb->wrapped_editor->close_edit(eb->wrapped_edit_baton, pool);
+}
+
+static svn_error_t *
+abort_edit(void *edit_baton,
+           apr_pool_t *pool)
+{
+  edit_baton_t *eb = edit_baton;
+  return eb->wrapped_editor->abort_edit(eb->wrapped_edit_baton, pool);
+}
+
+/* Set *EDITOR and *EDIT_BATON to an editor that forwards the replay of
+   a revision to WRAPPED_EDITOR / WRAPPED_EDIT_BATON, a commit editor
+   for the repository at REPOS_URL based on BASE_REVISION. */
+static void
+get_replay_editor(const svn_delta_editor_t **editor,
+                  void **edit_baton,
+                  const svn_delta_editor_t *wrapped_editor,
+                  void *wrapped_edit_baton,
+                  const char *repos_url,
+                  svn_revnum_t base_revision,
+                  apr_pool_t *pool)
+{
+  svn_delta_editor_t *tree_editor = svn_delta_default_editor(pool);
+  edit_baton_t *eb = apr_pcalloc(pool, sizeof(*eb));
+
+  tree_editor->set_target_revision = set_target_revision;
+  tree_editor->open_root = open_root;
+  tree_editor->delete_entry = delete_entry;
+  tree_editor->add_directory = add_directory;
+  tree_editor->open_directory = open_directory;
+  tree_editor->change_dir_prop = change_dir_prop;
+  tree_editor->close_directory = close_directory;
+  tree_editor->absent_directory = absent_directory;
+  tree_editor->add_file = add_file;
+  tree_editor->open_file = open_file;
+  tree_editor->apply_textdelta = apply_textdelta;
+  tree_editor->change_file_prop = change_file_prop;
+  tree_editor->close_file = close_file;
+  tree_editor->absent_file = absent_file;
+  tree_editor->close_edit = close_edit;
+  tree_editor->abort_edit = abort_edit;
+
+  eb->wrapped_editor = wrapped_editor;
+  eb->wrapped_edit_baton = wrapped_edit_baton;
+  eb->repos_url = repos_url;
+  eb->base_revision = base_revision;
+
+  *editor = tree_editor;
+  *edit_baton = eb;
+}
+
+
+/*** Copying revisions ***/
+
+/* A queued replay.  Everything is allocated in POOL, which belongs to
+   the replay. */
+typedef struct replay_task_t
+{
+  apr_pool_t *pool;
+
+  /* The server the request that queued us belongs to, for logging. */
+  server_rec *server;
+
+  /* The mirror's repository, and its hooks environment file. */
+  const char *repos_path;
+  const char *hooks_env;
+
+  const char *master_uri;
+
+  /* The SVNMasterReplayUser, and its password at the master (or NULL). */
+  const char *user;
+  const char *password;
+} replay_task_t;
+
+typedef struct replay_baton_t
+{
+  svn_repos_t *repos;
+
+  /* The user we commit as. */
+  const char *user;
+
+  /* URL of REPOS, and the same, URI-decoded. */
+  const char *repos_url;
+  const char *repos_url_decoded;
+
+  /* The revision created by the last commit. */
+  svn_revnum_t committed_rev;
+} replay_baton_t;
+
+/* Implements svn_commit_callback2_t. */
+static svn_error_t *
+commit_callback(const svn_commit_info_t *commit_info,
+                void *baton,
+                apr_pool_t *pool)
+{
+  replay_baton_t *rb = baton;
+
+  rb->committed_rev = commit_info->revision;
+  return SVN_NO_ERROR;
+}
+
+/* Return TRUE if the revision property NAME is set only after the
+   revision has been committed.  Like svnsync, we don't let svn:author
+   and svn:date go through the commit, so that hooks see the commit the
+   same way as one made by svnsync. */
+static svn_boolean_t
+set_after_commit(const char *name)
+{
+  return strcmp(name, SVN_PROP_REVISION_AUTHOR) == 0
+         || strcmp(name, SVN_PROP_REVISION_DATE) == 0;
+}
+
+/* Change the revision property NAME of REVISION in RB->REPOS to VALUE,
+   or delete it if VALUE is NULL, as RB->USER.  Do that only if the
+   current value is *OLD_VALUE_P, unless OLD_VALUE_P is NULL.  The
+   revprop change hooks get to see the change. */
+static svn_error_t *
+change_rev_prop(replay_baton_t *rb,
+                svn_revnum_t revision,
+                const char *name,
+                const svn_string_t *const *old_value_p,
+                const svn_string_t *value,
+                apr_pool_t *pool)
+{
+  return svn_error_trace(svn_repos_fs_change_rev_prop4(rb->repos, revision,
+                                                       rb->user, name,
+                                                       old_value_p, value,
+                                                       TRUE, TRUE,
+                                                       NULL, NULL, pool));
+}
+
+/* Implements svn_ra_replay_revstart_callback_t. */
+static svn_error_t *
+replay_rev_started(svn_revnum_t revision,
+                   void *replay_baton,
+                   const svn_delta_editor_t **editor,
+                   void **edit_baton,
+                   apr_hash_t *rev_props,
+                   apr_pool_t *pool)
+{
+  replay_baton_t *rb = replay_baton;
+  apr_hash_t *commit_props = apr_hash_make(pool);
+  const svn_delta_editor_t *commit_editor;
+  void *commit_baton;
+  apr_hash_index_t *hi;
+
+  /* Tell svnsync which revision an interrupted copy was about. */
+  SVN_ERR(change_rev_prop(rb, 0, SVNSYNC_PROP_CURRENTLY_COPYING, NULL,
+                          svn_string_createf(pool, "%ld", revision),
+                          pool));
+
+  for (hi = apr_hash_first(pool, rev_props); hi; hi = apr_hash_next(hi))
+    {
+      const char *name = apr_hash_this_key(hi);
+
+      if (!set_after_commit(name))
+        svn_hash_sets(commit_props, name, apr_hash_this_val(hi));
+    }
+
+  /* The commit editor requires a log message. */
+  if (! svn_hash_gets(commit_props, SVN_PROP_REVISION_LOG))
+    svn_hash_sets(commit_props, SVN_PROP_REVISION_LOG,
+                  svn_string_create_empty(pool));
+
+  /* We commit as the sync user, like svnsync does. */
+  svn_hash_sets(commit_props, SVN_PROP_REVISION_AUTHOR,
+                svn_string_create(rb->user, pool));
+
+  SVN_ERR(svn_repos_get_commit_editor5(&commit_editor, &commit_baton,
+                                       rb->repos, NULL,
+                                       rb->repos_url_decoded, "/",
+                                       commit_props,
+                                       commit_callback, rb,
+                                       NULL, NULL, pool));
+
+  get_replay_editor(editor, edit_baton, commit_editor, commit_baton,
+                    rb->repos_url, revision - 1, pool);
+
+  return SVN_NO_ERROR;
+}
+
+/* Implements svn_ra_replay_revfinish_callback_t. */
+static svn_error_t *
+replay_rev_finished(svn_revnum_t revision,
+                    void *replay_baton,
+                    const svn_delta_editor_t *editor,
+                    void *edit_baton,
+                    apr_hash_t *rev_props,
+                    apr_pool_t *pool)
+{
+  replay_baton_t *rb = replay_baton;
+  const svn_string_t *rev_str = svn_string_createf(pool, "%ld", revision);
+
+  SVN_ERR(editor->close_edit(edit_baton, pool));
+
+  if (rb->committed_rev != revision)
+    return svn_error_createf(SVN_ERR_FS_GENERAL, NULL,
+                             "Commit created r%ld but should have "
+                             "created r%ld",
+                             rb->committed_rev, revision);
+
+  /* Copy the revprops the commit left out.  The commit itself set
+     svn:author and svn:date, which we replace, or remove if the master
+     has none. */
+  SVN_ERR(change_rev_prop(rb, revision, SVN_PROP_REVISION_AUTHOR, NULL,
+                          svn_hash_gets(rev_props, SVN_PROP_REVISION_AUTHOR),
+                          pool));
+  SVN_ERR(change_rev_prop(rb, revision, SVN_PROP_REVISION_DATE, NULL,
+                          svn_hash_gets(rev_props, SVN_PROP_REVISION_DATE),
+                          pool));
+
+  SVN_ERR(change_rev_prop(rb, 0, SVNSYNC_PROP_LAST_MERGED_REV, NULL,
+                          rev_str, pool));
+  SVN_ERR(change_rev_prop(rb, 0, SVNSYNC_PROP_CURRENTLY_COPYING, &rev_str,
+                          NULL, pool));
+
+  return SVN_NO_ERROR;
+}
+
+/* Copy revisions up to HEAD, but no more than MAX_REPLAY_REVISIONS,
+   from the master at SESSION into REPOS, which is an svnsync mirror of
+   it, as USER.  The caller holds the sync lock. */
+static svn_error_t *
+copy_revisions(svn_repos_t *repos,
+               const char *repos_path,
+               const char *user,
+               svn_ra_session_t *session,
+               svn_revnum_t head,
+               apr_pool_t *pool)
+{
+  svn_fs_t *fs = svn_repos_fs(repos);
+  svn_string_t *last_merged_str;
+  svn_string_t *copying;
+  svn_revnum_t last_merged;
+  svn_revnum_t youngest;
+  replay_baton_t rb = { 0 };
+
+  /* Leave mirrors in any unusual state to svnsync. */
+  SVN_ERR(svn_fs_revision_prop2(&copying, fs, 0,
+                                SVNSYNC_PROP_CURRENTLY_COPYING,
+                                TRUE, pool, pool));
+  SVN_ERR(svn_fs_revision_prop2(&last_merged_str, fs, 0,
+                                SVNSYNC_PROP_LAST_MERGED_REV,
+                                FALSE, pool, pool));
+  if (copying || !last_merged_str)
+    return svn_error_create(SVN_ERR_FS_GENERAL, NULL,
+                            "The mirror is in the middle of an svnsync "
+                            "operation");
+
+  SVN_ERR(svn_revnum_parse(&last_merged, last_merged_str->data, NULL));
+  SVN_ERR(svn_fs_youngest_rev(&youngest, fs, pool));
+  if (youngest != last_merged)
+    return svn_error_createf(SVN_ERR_FS_GENERAL, NULL,
+                             "The mirror's HEAD (r%ld) is not its last "
+                             "merged revision (r%ld)",
+                             youngest, last_merged);
+
+  if (youngest >= head)
+    return SVN_NO_ERROR;
+
+  if (head - youngest > MAX_REPLAY_REVISIONS)
+    head = youngest + MAX_REPLAY_REVISIONS;
+
+  rb.repos = repos;
+  rb.user = user;
+  SVN_ERR(svn_uri_get_file_url_from_dirent(&rb.repos_url, repos_path,
+                                           pool));
+  rb.repos_url_decoded = svn_path_uri_decode(rb.repos_url, pool);
+  rb.committed_rev = SVN_INVALID_REVNUM;
+
+  return svn_error_trace(svn_ra_replay_range(session, youngest + 1, head,
+                                             0, TRUE,
+                                             replay_rev_started,
+                                             replay_rev_finished,
+                                             &rb, pool));
+}
+
+/* Implements svn_auth_simple_prompt_func_t.  Answer with the
+   credentials of the replay TASK in BATON. */
+static svn_error_t *
+simple_prompt(svn_auth_cred_simple_t **cred,
+              void *baton,
+              const char *realm,
+              const char *username,
+              svn_boolean_t may_save,
+              apr_pool_t *pool)
+{
+  replay_task_t *task = baton;
+
+  *cred = apr_pcalloc(pool, sizeof(**cred));
+  (*cred)->username = apr_pstrdup(pool, task->user);
+  (*cred)->password = apr_pstrdup(pool, task->password ? task->password : "");
+  (*cred)->may_save = FALSE;
+
+  return SVN_NO_ERROR;
+}
+
+/* Open an RA session to the master of TASK.  We authenticate with the
+   configured credentials only; neither the configuration area nor the
+   credential cache of the user httpd runs as are used. */
+static svn_error_t *
+open_master_session(svn_ra_session_t **session,
+                    replay_task_t *task,
+                    apr_pool_t *pool)
+{
+  apr_array_header_t *providers;
+  svn_auth_provider_object_t *provider;
+  svn_ra_callbacks2_t *callbacks;
+  svn_auth_baton_t *auth_baton;
+
+  providers = apr_array_make(pool, 1, sizeof(svn_auth_provider_object_t *));
+  svn_auth_get_simple_prompt_provider(&provider, simple_prompt, task, 0,
+                                      pool);
+  APR_ARRAY_PUSH(providers, svn_auth_provider_object_t *) = provider;
+  svn_auth_open(&auth_baton, providers, pool);
+  svn_auth_set_parameter(auth_baton, SVN_AUTH_PARAM_NO_AUTH_CACHE, "");
+
+  SVN_ERR(svn_ra_create_callbacks(&callbacks, pool));
+  callbacks->auth_baton = auth_baton;
+
+  return svn_error_trace(svn_ra_open4(session, NULL, task->master_uri, NULL,
+                                      callbacks, NULL, NULL, pool));
+}
+
+/* Copy the revisions that the master of TASK has and the mirror doesn't
+   yet into the mirror.  Use POOL for all allocations. */
+static svn_error_t *
+catch_up(replay_task_t *task,
+         apr_pool_t *pool)
+{
+  svn_repos_t *repos;
+  svn_fs_t *fs;
+  svn_ra_session_t *session;
+  svn_revnum_t head;
+  svn_revnum_t youngest;
+  const char *master_uuid;
+  svn_string_t *from_uuid;
+  const svn_string_t *lock_value;
+  const svn_string_t *no_value = NULL;
+  char hostname[APRMAXHOSTLEN + 1];
+  svn_error_t *err;
+
+  SVN_ERR(svn_repos_open3(&repos, task->repos_path, NULL, pool, pool));
+  SVN_ERR(svn_repos_hooks_setenv(repos, task->hooks_env, pool));
+  fs = svn_repos_fs(repos);
+
+  SVN_ERR(open_master_session(&session, task, pool));
+  SVN_ERR(svn_ra_get_latest_revnum(session, &head, pool));
+  SVN_ERR(svn_fs_youngest_rev(&youngest, fs, pool));
+  if (youngest >= head)
+    return SVN_NO_ERROR;
+
+  /* Only copy into a mirror of this very master. */
+  SVN_ERR(svn_ra_get_uuid2(session, &master_uuid, pool));
+  SVN_ERR(svn_fs_revision_prop2(&from_uuid, fs, 0, SVNSYNC_PROP_FROM_UUID,
+                                FALSE, pool, pool));
+  if (!from_uuid || strcmp(from_uuid->data, master_uuid) != 0)
+    return svn_error_createf(SVN_ERR_BAD_CONFIG_VALUE, NULL,
+                             "The repository at '%s' is not an svnsync "
+                             "mirror of the master",
+                             svn_dirent_local_style(task->repos_path, pool));
+
+  /* Take svnsync's lock.  If somebody else holds it, they are already
+     copying the new revisions. */
+  if (apr_gethostname(hostname, sizeof(hostname), pool) != APR_SUCCESS)
+    hostname[0] = '\0';
+  lock_value = svn_string_createf(pool, "%s:%s", hostname,
+                                  svn_uuid_generate(pool));
+  err = svn_repos_fs_change_rev_prop4(repos, 0, task->user, SVNSYNC_PROP_LOCK,
+                                      &no_value, lock_value, TRUE, TRUE,
+                                      NULL, NULL, pool);
+  if (err && err->apr_err == SVN_ERR_FS_PROP_BASEVALUE_MISMATCH)
+    {
+      svn_error_clear(err);
+      return SVN_NO_ERROR;
+    }
+  SVN_ERR(err);
+
+  err = copy_revisions(repos, task->repos_path, task->user, session, head,
+                       pool);
+
+  return svn_error_compose_create(
+           err,
+           svn_repos_fs_change_rev_prop4(repos, 0, task->user,
+                                         SVNSYNC_PROP_LOCK, &lock_value,
+                                         NULL, TRUE, TRUE, NULL, NULL,
+                                         pool));
+}
+
+
+/*** Running replays in the background ***/
+
+#if APR_HAS_THREADS
+
+/* The thread that replays commits in this child process, or NULL if we
+   could not create it. */
+static apr_thread_pool_t *replay_threads = NULL;
+
+/* Run the replay task in DATA, and dispose of it.  Implements
+   apr_thread_start_t. */
+static void * APR_THREAD_FUNC
+replay_thread(apr_thread_t *tid,
+              void *data)
+{
+  replay_task_t *task = data;
+  svn_error_t *err;
+
+  err = catch_up(task, task->pool);
+  if (err)
+    {
+      char buf[256];
+
+      ap_log_error(APLOG_MARK, APLOG_WARNING, err->apr_err, task->server,
+                   "Could not replay commits from master into '%s': %s",
+                   task->repos_path,
+                   svn_err_best_message(err, buf, sizeof(buf)));
+      svn_error_clear(err);
+    }
+
+  svn_pool_destroy(task->pool);
+  return NULL;
+}
+
+#endif
+
+void
+dav_svn__mirror_replay_child_init(apr_pool_t *pchild,
+                                  server_rec *s)
+{
+#if APR_HAS_THREADS
+  apr_status_t status;
+
+  /* The thread only gets started once there is something to replay. */
+  status = apr_thread_pool_create(&replay_threads, 0, 1, pchild);
+  if (status)
+    {
+      ap_log_error(APLOG_MARK, APLOG_ERR, status, s,
+                   "Could not create the thread pool for SVNMasterReplay");
+      replay_threads = NULL;
+    }
+#endif
+}
+
+svn_error_t *
+dav_svn__mirror_schedule_replay(request_rec *r)
+{
+#if APR_HAS_THREADS
+  replay_task_t *task;
+  apr_pool_t *pool;
+  const char *repos_path;
+  dav_error *derr;
+  apr_status_t status;
+
+  if (!replay_threads)
+    return svn_error_create(SVN_ERR_UNSUPPORTED_FEATURE, NULL,
+                            "The replay thread pool is not available");
+
+  if (apr_thread_pool_tasks_count(replay_threads) >= MAX_QUEUED_REPLAYS)
+    return SVN_NO_ERROR;
+
+  derr = dav_svn_get_repos_path2(r, dav_svn__get_root_dir(r), &repos_path,
+                                 r->pool);
+  if (derr)
+    return svn_error_create(SVN_ERR_BAD_CONFIG_VALUE, NULL, derr->desc);
+
+  /* The task outlives R; it gets a root pool of its own, which the
+     replay thread destroys when it is done. */
+  pool = apr_allocator_owner_get(svn_pool_create_allocator(FALSE));
+  task = apr_pcalloc(pool, sizeof(*task));
+  task->pool = pool;
+  task->server = r->server;
+  task->repos_path = apr_pstrdup(pool, repos_path);
+  task->hooks_env = apr_pstrdup(pool, dav_svn__get_hooks_env(r));
+  task->master_uri = apr_pstrdup(pool, dav_svn__get_master_uri(r));
+  task->user = apr_pstrdup(pool, dav_svn__get_master_replay_user(r));
+  task->password = apr_pstrdup(pool, dav_svn__get_master_replay_password(r));
+
+  status = apr_thread_pool_push(replay_threads, replay_thread, task,
+                                APR_THREAD_TASK_PRIORITY_NORMAL, NULL);
+  if (status)
+    {
+      svn_pool_destroy(pool);
+      return svn_error_wrap_apr(status, "Could not queue the replay");
+    }
+
+  return SVN_NO_ERROR;
+#else
+  return svn_error_create(SVN_ERR_UNSUPPORTED_FEATURE, NULL,
+                          "SVNMasterReplay requires thread support");
+#endif
+}
@@ -43,6 +43,7 @@
 #include "mod_dav_svn.h"
 
 #include "private/svn_fspath.h"
+#include "private/svn_repos_private.h"
 #include "private/svn_subr_private.h"
 
 #include "dav_svn.h"
@@ -67,6 +68,14 @@ typedef struct server_conf_t {
      compression level. */
   int compression_level;
 
+  /* Number of threads per update report to calculate file deltas with
+   * ahead of the editor drive.  0 if not configured. */
+  int delta_threads;
+
+  /* Directory for compiled authz rules, or NULL.  Only the global setting
+   * is used because the authz caches are shared by the whole process. */
+  const char *authz_cache_dir;
+
 } server_conf_t;
 
 
@@ -98,9 +107,13 @@ typedef struct dir_conf_t {
   enum conf_flag v2_protocol;        /* whether HTTP v2 is advertised */
   enum path_authz_conf path_authz_method; /* how GET subrequests are handled */
   enum conf_flag list_parentpath;    /* whether to allow GET of parentpath */
+  enum conf_flag allow_blame;        /* whether to answer blame REPORTs */
   const char *root_dir;              /* our top-level directory */
   const char *master_uri;            /* URI to the master SVN repos */
   svn_version_t *master_version;     /* version of master server */
+  enum conf_flag master_replay;      /* whether to replay commits from master */
+  const char *master_replay_user;    /* user to replay commits as */
+  const char *master_replay_password; /* password of that user at master */
   const char *activities_db;         /* path to activities database(s) */
   enum conf_flag txdelta_cache;      /* whether to enable txdelta caching */
   enum conf_flag fulltext_cache;     /* whether to enable fulltext caching */
@@ -120,11 +133,16 @@ extern module AP_MODULE_DECLARE_DATA dav_svn_module;
 /* The authz_svn provider for bypassing path authz. */
 static authz_svn__subreq_bypass_func_t pathauthz_bypass_func = NULL;
 
+/* The authz_svn provider for bypassing path authz for multiple paths. */
+static authz_svn__subreq_bypass_batch_func_t pathauthz_bypass_batch_func
+  = NULL;
+
 static int
 init(apr_pool_t *p, apr_pool_t *plog, apr_pool_t *ptemp, server_rec *s)
 {
   svn_error_t *serr;
   server_conf_t *conf;
+  svn_repos__authz_cache_config_t authz_cache_config = { NULL, 0 };
 
   ap_add_version_component(p, "SVN/" SVN_VER_NUMBER);
 
@@ -137,6 +155,13 @@ init(apr_pool_t *p, apr_pool_t *plog, apr_pool_t *ptemp, server_rec *s)
       return HTTP_INTERNAL_SERVER_ERROR;
     }
 
+  /* The authz cache settings must be in place before the caches get
+     created.  Set them on every (re-)start, so that the directory name
+     lives exactly as long as the configuration it came from. */
+  conf = ap_get_module_config(s->module_config, &dav_svn_module);
+  authz_cache_config.cache_dir = conf->authz_cache_dir;
+  svn_repos__authz_cache_config_set(&authz_cache_config);
+
   serr = svn_repos_authz_initialize(p);
   if (serr)
     {
@@ -147,7 +172,6 @@ init(apr_pool_t *p, apr_pool_t *plog, apr_pool_t *ptemp, server_rec *s)
     }
 
   /* This returns void, so we can't check for error. */
-  conf = ap_get_module_config(s->module_config, &dav_svn_module);
   svn_utf_initialize2(conf->use_utf8, p);
 
   return OK;
@@ -231,6 +255,8 @@ merge_server_config(apr_pool_t *p, void *base, void *overrides)
       newconf->compression_level = child->compression_level;
     }
 
+  newconf->delta_threads = INHERIT_VALUE(parent, child, delta_threads);
+  newconf->authz_cache_dir = INHERIT_VALUE(parent, child, authz_cache_dir);
   newconf->use_utf8 = INHERIT_VALUE(parent, child, use_utf8);                 
   svn_utf_initialize2(newconf->use_utf8, p); 
 
@@ -272,6 +298,11 @@ merge_dir_config(apr_pool_t *p, void *base, void *overrides)
   newconf->fs_path = INHERIT_VALUE(parent, child, fs_path);
   newconf->master_uri = INHERIT_VALUE(parent, child, master_uri);
   newconf->master_version = INHERIT_VALUE(parent, child, master_version);
+  newconf->master_replay = INHERIT_VALUE(parent, child, master_replay);
+  newconf->master_replay_user = INHERIT_VALUE(parent, child,
+                                              master_replay_user);
+  newconf->master_replay_password = INHERIT_VALUE(parent, child,
+                                                  master_replay_password);
   newconf->activities_db = INHERIT_VALUE(parent, child, activities_db);
   newconf->repo_name = INHERIT_VALUE(parent, child, repo_name);
   newconf->xslt_uri = INHERIT_VALUE(parent, child, xslt_uri);
@@ -281,6 +312,7 @@ merge_dir_config(apr_pool_t *p, void *base, void *overrides)
   newconf->v2_protocol = INHERIT_VALUE(parent, child, v2_protocol);
   newconf->path_authz_method = INHERIT_VALUE(parent, child, path_authz_method);
   newconf->list_parentpath = INHERIT_VALUE(parent, child, list_parentpath);
+  newconf->allow_blame = INHERIT_VALUE(parent, child, allow_blame);
   newconf->txdelta_cache = INHERIT_VALUE(parent, child, txdelta_cache);
   newconf->fulltext_cache = INHERIT_VALUE(parent, child, fulltext_cache);
   newconf->revprop_cache = INHERIT_VALUE(parent, child, revprop_cache);
@@ -360,6 +392,33 @@ SVNMasterVersion_cmd(cmd_parms *cmd, void *config, const char *arg1)
 }
 
 
+static const char *
+SVNMasterReplay_cmd(cmd_parms *cmd, void *config, int arg)
+{
+  dir_conf_t *conf = config;
+
+  if (arg)
+    conf->master_replay = CONF_FLAG_ON;
+  else
+    conf->master_replay = CONF_FLAG_OFF;
+
+  return NULL;
+}
+
+
+static const char *
+SVNMasterReplayUser_cmd(cmd_parms *cmd, void *config, const char *arg1,
+                        const char *arg2)
+{
+  dir_conf_t *conf = config;
+
+  conf->master_replay_user = apr_pstrdup(cmd->pool, arg1);
+  conf->master_replay_password = arg2 ? apr_pstrdup(cmd->pool, arg2) : NULL;
+
+  return NULL;
+}
+
+
 static const char *
 SVNActivitiesDB_cmd(cmd_parms *cmd, void *config, const char *arg1)
 {
@@ -455,6 +514,13 @@ SVNPathAuthz_cmd(cmd_parms *cmd, void *config, const char *arg1)
                                AUTHZ_SVN__SUBREQ_BYPASS_PROV_NAME,
                                AUTHZ_SVN__SUBREQ_BYPASS_PROV_VER);
         }
+      if (pathauthz_bypass_batch_func == NULL)
+        {
+          pathauthz_bypass_batch_func =
+            ap_lookup_provider(AUTHZ_SVN__SUBREQ_BYPASS_PROV_GRP,
+                               AUTHZ_SVN__SUBREQ_BYPASS_BATCH_PROV_NAME,
+                               AUTHZ_SVN__SUBREQ_BYPASS_BATCH_PROV_VER);
+        }
     }
   else if (apr_strnatcasecmp("on", arg1) == 0)
     {
@@ -483,6 +549,20 @@ SVNListParentPath_cmd(cmd_parms *cmd, void *config, int arg)
 }
 
 
+static const char *
+SVNAllowBlame_cmd(cmd_parms *cmd, void *config, int arg)
+{
+  dir_conf_t *conf = config;
+
+  if (arg)
+    conf->allow_blame = CONF_FLAG_ON;
+  else
+    conf->allow_blame = CONF_FLAG_OFF;
+
+  return NULL;
+}
+
+
 static const char *
 SVNPath_cmd(cmd_parms *cmd, void *config, const char *arg1)
 {
@@ -627,6 +707,23 @@ SVNInMemoryCacheSize_cmd(cmd_parms *cmd, void *config, const char *arg1)
   return NULL;
 }
 
+static const char *
+SVNAuthzCacheDir_cmd(cmd_parms *cmd, void *config, const char *arg1)
+{
+  server_conf_t *conf;
+  const char *err = ap_check_cmd_context(cmd, GLOBAL_ONLY);
+  if (err)
+    return err;
+
+  conf = ap_get_module_config(cmd->server->module_config,
+                              &dav_svn_module);
+  conf->authz_cache_dir = svn_dirent_internal_style(
+                            ap_server_root_relative(cmd->pool, arg1),
+                            cmd->pool);
+
+  return NULL;
+}
+
 static const char *
 SVNCompressionLevel_cmd(cmd_parms *cmd, void *config, const char *arg1)
 {
@@ -655,6 +752,31 @@ SVNCompressionLevel_cmd(cmd_parms *cmd, void *config, const char *arg1)
   return NULL;
 }
 
+static const char *
+SVNUpdateDeltaThreads_cmd(cmd_parms *cmd, void *config, const char *arg1)
+{
+  server_conf_t *conf;
+  int value = 0;
+  svn_error_t *err = svn_cstring_atoi(&value, arg1);
+  if (err)
+    {
+      svn_error_clear(err);
+      return "Invalid decimal number for the number of update delta threads.";
+    }
+
+  if (value < 0 || value > SVN_REPOS__MAX_DELTA_THREADS)
+    return apr_psprintf(cmd->pool,
+                        "%d is not a valid number of update delta threads. "
+                        "The valid range is 0 .. %d.",
+                        value, SVN_REPOS__MAX_DELTA_THREADS);
+
+  conf = ap_get_module_config(cmd->server->module_config,
+                              &dav_svn_module);
+  conf->delta_threads = value;
+
+  return NULL;
+}
+
 static const char *
 SVNUseUTF8_cmd(cmd_parms *cmd, void *config, int arg)
 {
@@ -803,6 +925,36 @@ dav_svn__get_master_version(request_rec *r)
 }
 
 
+svn_boolean_t
+dav_svn__get_master_replay_flag(request_rec *r)
+{
+  dir_conf_t *conf;
+
+  conf = ap_get_module_config(r->per_dir_config, &dav_svn_module);
+  return conf->master_uri && conf->master_replay == CONF_FLAG_ON;
+}
+
+
+const char *
+dav_svn__get_master_replay_user(request_rec *r)
+{
+  dir_conf_t *conf;
+
+  conf = ap_get_module_config(r->per_dir_config, &dav_svn_module);
+  return conf->master_replay_user;
+}
+
+
+const char *
+dav_svn__get_master_replay_password(request_rec *r)
+{
+  dir_conf_t *conf;
+
+  conf = ap_get_module_config(r->per_dir_config, &dav_svn_module);
+  return conf->master_replay_password;
+}
+
+
 const char *
 dav_svn__get_xslt_uri(request_rec *r)
 {
@@ -952,6 +1104,20 @@ dav_svn__get_pathauthz_bypass(request_rec *r)
   return NULL;
 }
 
+/* Function pointer if we should use the batch bypass directly to
+ * mod_authz_svn.  NULL otherwise. */
+authz_svn__subreq_bypass_batch_func_t
+dav_svn__get_pathauthz_bypass_batch(request_rec *r)
+{
+  dir_conf_t *conf;
+
+  conf = ap_get_module_config(r->per_dir_config, &dav_svn_module);
+
+  if (conf->path_authz_method == CONF_PATHAUTHZ_BYPASS)
+    return pathauthz_bypass_batch_func;
+  return NULL;
+}
+
 
 svn_boolean_t
 dav_svn__get_list_parentpath_flag(request_rec *r)
@@ -963,6 +1129,18 @@ dav_svn__get_list_parentpath_flag(request_rec *r)
 }
 
 
+svn_boolean_t
+dav_svn__get_allow_blame_flag(request_rec *r)
+{
+  dir_conf_t *conf;
+
+  conf = ap_get_module_config(r->per_dir_config, &dav_svn_module);
+
+  /* Blaming on the server is enabled by default. */
+  return get_conf_flag(conf->allow_blame, TRUE);
+}
+
+
 const char *
 dav_svn__get_activities_db(request_rec *r)
 {
@@ -1048,6 +1226,17 @@ dav_svn__get_compression_level(request_rec *r)
     }
 }
 
+int
+dav_svn__get_update_delta_threads(request_rec *r)
+{
+  server_conf_t *conf;
+
+  conf = ap_get_module_config(r->server->module_config,
+                              &dav_svn_module);
+
+  return conf->delta_threads;
+}
+
 const char *
 dav_svn__get_hooks_env(request_rec *r)
 {
@@ -1321,6 +1510,13 @@ static const command_rec cmds[] =
   AP_INIT_FLAG("SVNListParentPath", SVNListParentPath_cmd, NULL,
                ACCESS_CONF|RSRC_CONF, "allow GET of SVNParentPath."),
 
+  /* per directory/location */
+  AP_INIT_FLAG("SVNAllowBlame", SVNAllowBlame_cmd, NULL,
+               ACCESS_CONF|RSRC_CONF,
+               "enables calculating blame information on the server, so "
+               "that clients don't have to fetch every file revision "
+               "(default is On)."),
+
   /* per directory/location */
   AP_INIT_TAKE1("SVNMasterURI", SVNMasterURI_cmd, NULL, ACCESS_CONF,
                 "specifies a URI to access a master Subversion repository"),
@@ -1330,6 +1526,17 @@ static const command_rec cmds[] =
                 "specifies the Subversion release version of a master "
                 "Subversion server "),
 
+  /* per directory/location */
+  AP_INIT_FLAG("SVNMasterReplay", SVNMasterReplay_cmd, NULL, ACCESS_CONF,
+               "replay commits proxied to the master into this mirror "
+               "right after answering them (default is Off)"),
+
+  /* per directory/location */
+  AP_INIT_TAKE12("SVNMasterReplayUser", SVNMasterReplayUser_cmd, NULL,
+                 ACCESS_CONF,
+                 "specifies the user that replays commits into this mirror, "
+                 "and optionally its password at the master"),
+
   /* per directory/location */
   AP_INIT_TAKE1("SVNActivitiesDB", SVNActivitiesDB_cmd, NULL, ACCESS_CONF,
                 "specifies the location in the filesystem in which the "
@@ -1392,12 +1599,25 @@ static const command_rec cmds[] =
                 "in-memory object cache (default value is 16384; 0 switches "
                 "to dynamically sized caches)."),
   /* per server */
+  AP_INIT_TAKE1("SVNAuthzCacheDir", SVNAuthzCacheDir_cmd, NULL,
+                RSRC_CONF,
+                "specifies a directory in which compiled authz rules are "
+                "kept, so that other server processes don't need to parse "
+                "them again (default is to not keep them)."),
+  /* per server */
   AP_INIT_TAKE1("SVNCompressionLevel", SVNCompressionLevel_cmd, NULL,
                 RSRC_CONF,
                 "specifies the compression level used before sending file "
                 "content over the network (0 for no compression, 9 for "
                 "maximum, 5 is default)."),
 
+  /* per server */
+  AP_INIT_TAKE1("SVNUpdateDeltaThreads", SVNUpdateDeltaThreads_cmd, NULL,
+                RSRC_CONF,
+                "specifies the number of threads per update request that "
+                "calculate file deltas ahead of sending them to the client "
+                "(default is 0, i.e. deltas are calculated inline)."),
+
   /* per server */
   AP_INIT_FLAG("SVNUseUTF8",
                SVNUseUTF8_cmd, NULL,
@@ -1432,6 +1652,8 @@ register_hooks(apr_pool_t *pconf)
 {
   ap_hook_pre_config(init_dso, NULL, NULL, APR_HOOK_REALLY_FIRST);
   ap_hook_post_config(init, NULL, NULL, APR_HOOK_MIDDLE);
+  ap_hook_child_init(dav_svn__mirror_replay_child_init, NULL, NULL,
+                     APR_HOOK_MIDDLE);
 
   /* our provider */
   dav_register_provider(pconf, "svn", &provider);
@@ -1463,6 +1685,8 @@ register_hooks(apr_pool_t *pconf)
                             NULL, AP_FTYPE_CONTENT_SET);
   ap_register_input_filter("IncomingRewrite", dav_svn__location_in_filter,
                            NULL, AP_FTYPE_CONTENT_SET);
+  ap_register_output_filter("MasterReplay", dav_svn__mirror_replay_filter,
+                            NULL, AP_FTYPE_CONTENT_SET);
   ap_hook_fixups(dav_svn__proxy_request_fixup, NULL, NULL, APR_HOOK_MIDDLE);
   /* translate_name hook is LAST so that it doesn't interfere with modules
    * like mod_alias that are MIDDLE. */
@@ -25,6 +25,7 @@
 #include <apr_strings.h>
 #include <apr_xml.h>
 
+#include <http_protocol.h>
 #include <http_request.h>
 #include <http_log.h>
 #include <mod_dav.h>
@@ -42,6 +43,7 @@
 
 #include "private/svn_log.h"
 #include "private/svn_fspath.h"
+#include "private/svn_dav_protocol.h"
 
 #include "../dav_svn.h"
 
@@ -86,6 +88,11 @@ typedef struct update_ctx_t {
      inline.  (This is implied when "send_all" is set.)  */
   svn_boolean_t include_props;
 
+  /* True iff the client asked for svndiff data to be sent as binary
+     frames instead of base64-encoded cdata (only honored in "send_all"
+     mode).  */
+  svn_boolean_t binary_txdelta;
+
   /* SVNDIFF version to send to client.  */
   int svndiff_version;
 
@@ -749,10 +756,65 @@ upd_open_file(const char *path,
 }
 
 
+/* Baton for binary_frame_write_fn(). */
+struct binary_frame_baton
+{
+  apr_bucket_brigade *bb;
+  dav_svn__output *output;
+};
+
+
+/* Write DATA to the report as one or more binary frames, see
+   SVN_DAV__BINARY_FRAME_MARKER.  This implements 'svn_write_fn_t'. */
+static svn_error_t *
+binary_frame_write_fn(void *baton, const char *data, apr_size_t *len)
+{
+  struct binary_frame_baton *fb = baton;
+  apr_size_t remaining = *len;
+
+  while (remaining > 0)
+    {
+      char header[SVN_DAV__BINARY_FRAME_HEADER_LEN];
+      apr_uint32_t frame_len = (remaining > APR_INT32_MAX)
+                                 ? APR_INT32_MAX : (apr_uint32_t)remaining;
+
+      header[0] = SVN_DAV__BINARY_FRAME_MARKER;
+      header[1] = (char)((frame_len >> 24) & 0xff);
+      header[2] = (char)((frame_len >> 16) & 0xff);
+      header[3] = (char)((frame_len >> 8) & 0xff);
+      header[4] = (char)(frame_len & 0xff);
+
+      SVN_ERR(dav_svn__brigade_write(fb->bb, fb->output,
+                                     header, sizeof(header)));
+      SVN_ERR(dav_svn__brigade_write(fb->bb, fb->output, data, frame_len));
+
+      data += frame_len;
+      remaining -= frame_len;
+    }
+
+  return SVN_NO_ERROR;
+}
+
+
+/* Return a stream that sends svndiff data for UC as binary frames. */
+static svn_stream_t *
+make_binary_frame_stream(update_ctx_t *uc, apr_pool_t *pool)
+{
+  struct binary_frame_baton *fb = apr_palloc(pool, sizeof(*fb));
+  svn_stream_t *stream = svn_stream_create(fb, pool);
+
+  fb->bb = uc->bb;
+  fb->output = uc->output;
+  svn_stream_set_write(stream, binary_frame_write_fn);
+
+  return stream;
+}
+
+
 /* We have our own window handler and baton as a simple wrapper around
    the real handler (which converts txdelta windows to base64-encoded
-   svndiff data).  The wrapper is responsible for sending the opening
-   and closing XML tags around the svndiff data. */
+   or binary-framed svndiff data).  The wrapper is responsible for sending
+   the opening and closing XML tags around the svndiff data. */
 struct window_handler_baton
 {
   svn_boolean_t seen_first_window;  /* False until first window seen. */
@@ -805,7 +867,7 @@ upd_apply_textdelta(void *file_baton,
 {
   item_baton_t *file = file_baton;
   struct window_handler_baton *wb;
-  svn_stream_t *base64_stream;
+  svn_stream_t *svndiff_stream;
 
   /* Store the base checksum and the fact the file's text changed. */
   file->base_checksum = apr_pstrdup(file->pool, base_checksum);
@@ -824,12 +886,15 @@ upd_apply_textdelta(void *file_baton,
   wb->seen_first_window = FALSE;
   wb->uc = file->uc;
   wb->base_checksum = file->base_checksum;
-  base64_stream = dav_svn__make_base64_output_stream(wb->uc->bb,
-                                                     wb->uc->output,
-                                                     file->pool);
+  if (wb->uc->binary_txdelta)
+    svndiff_stream = make_binary_frame_stream(wb->uc, file->pool);
+  else
+    svndiff_stream = dav_svn__make_base64_output_stream(wb->uc->bb,
+                                                        wb->uc->output,
+                                                        file->pool);
 
   svn_txdelta_to_svndiff3(&(wb->handler), &(wb->handler_baton),
-                          base64_stream, file->uc->svndiff_version,
+                          svndiff_stream, file->uc->svndiff_version,
                           file->uc->compression_level, file->pool);
 
   *handler = window_handler;
@@ -1164,6 +1229,15 @@ dav_svn__update_report(const dav_resource *resource,
           if (strcmp(cdata, "no") != 0)
             uc.include_props = TRUE;
         }
+      if (child->ns == ns
+          && strcmp(child->name, SVN_DAV__BINARY_TXDELTA) == 0)
+        {
+          cdata = dav_xml_get_cdata(child, resource->pool, 1);
+          if (! *cdata)
+            return malformed_element_error(child->name, resource->pool);
+          if (strcmp(cdata, "no") != 0)
+            uc.binary_txdelta = TRUE;
+        }
     }
 
   /* If a target revision wasn't requested, or the requested target
@@ -1246,7 +1320,16 @@ dav_svn__update_report(const dav_resource *resource,
      sending only a "skelta" of the difference, which will not need to
      contain actual text deltas. */
   if (! uc.send_all)
-    text_deltas = FALSE;
+    {
+      text_deltas = FALSE;
+      uc.binary_txdelta = FALSE;
+    }
+
+  /* Binary frames make the response invalid XML; tell the client by
+     sending it with its own content type instead of text/xml.  Nothing
+     has been written yet, so we can still change the headers. */
+  if (uc.binary_txdelta)
+    ap_set_content_type(resource->info->r, SVN_DAV__FRAMED_REPORT_MIME_TYPE);
 
   /* When we call svn_repos_finish_report, it will ultimately run
      dir_delta() between REPOS_PATH/TARGET and TARGET_PATH.  In the
@@ -1287,6 +1370,8 @@ dav_svn__update_report(const dav_resource *resource,
                                   "created.",
                                   resource->pool);
     }
+  svn_repos__report_set_delta_threads(
+    rbaton, dav_svn__get_update_delta_threads(resource->info->r));
 
   /* scan the XML doc for state information */
   for (child = doc->root->first_child; child != NULL; child = child->next)
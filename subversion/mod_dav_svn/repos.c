@@ -54,6 +54,7 @@
 #include "svn_ra.h"  /* for SVN_RA_CAPABILITY_* */
 #include "svn_dirent_uri.h"
 #include "private/svn_log.h"
+#include "private/svn_fs_private.h"
 #include "private/svn_fspath.h"
 #include "private/svn_repos_private.h"
 #include "private/svn_sorts_private.h"
@@ -2393,7 +2394,13 @@ get_resource(request_rec *r,
       }
   }
 
-  /* Retrieve/cache open repository */
+  /* Retrieve/cache open repository.
+
+     Under mod_http2, R->CONNECTION is the secondary connection that
+     processes just this request's stream, not the client's TCP connection.
+     The streams of one client run concurrently in different threads, so
+     they must not share the (not thread-safe) repository object; caching
+     it per secondary connection gives each of them their own. */
   repos_key = apr_pstrcat(r->pool, "mod_dav_svn:", fs_path, SVN_VA_NULL);
   apr_pool_userdata_get(&userdata, repos_key, r->connection->pool);
   repos->repos = userdata;
@@ -3223,6 +3230,11 @@ set_headers(request_rec *r, const dav_resource *resource)
           apr_table_setn(r->headers_out, "Vary", SVN_DAV_DELTA_BASE_HEADER);
           apr_table_setn(r->headers_out, SVN_DAV_DELTA_BASE_HEADER,
                          resource->info->delta_base);
+
+          /* svndiff1 and svndiff2 are compressed already; don't let
+             mod_deflate spend time compressing them again. */
+          if (resource->info->svndiff_version > 0)
+            apr_table_setn(r->subprocess_env, "no-gzip", "1");
         }
       svn_error_clear(serr);
     }
@@ -3581,6 +3593,68 @@ emit_collection_tail(const dav_resource *resource,
 }
 
 
+/* If the GET request for the file RESOURCE of LENGTH bytes asks for a
+   single satisfiable byte range that still applies (per If-Range), set
+   *START and *RANGE_LEN to it and return TRUE.  Otherwise return FALSE
+   and leave the Range header, if any, to httpd's byterange filter. */
+static svn_boolean_t
+get_single_byte_range(apr_off_t *start,
+                      apr_off_t *range_len,
+                      const dav_resource *resource,
+                      svn_filesize_t length)
+{
+  request_rec *r = resource->info->r;
+  const char *range = apr_table_get(r->headers_in, "Range");
+  const char *if_range = apr_table_get(r->headers_in, "If-Range");
+  const char *dash;
+  char *endp;
+  apr_off_t first, last;
+
+  if (!range || strncmp(range, "bytes=", 6) != 0
+      || strchr(range, ',') != NULL || length <= 0)
+    return FALSE;
+  range += 6;
+
+  /* The representation changed: send it all. */
+  if (if_range
+      && strcmp(if_range, dav_svn__getetag(resource, resource->pool)) != 0)
+    return FALSE;
+
+  dash = strchr(range, '-');
+  if (!dash)
+    return FALSE;
+
+  if (dash == range)
+    {
+      /* "-N": the last N bytes */
+      if (apr_strtoff(&last, dash + 1, &endp, 10) || *endp || last <= 0)
+        return FALSE;
+      first = (last >= length) ? 0 : length - last;
+      last = length - 1;
+    }
+  else
+    {
+      if (apr_strtoff(&first, range, &endp, 10) || endp != dash)
+        return FALSE;
+
+      if (dash[1] == '\0')
+        last = length - 1;
+      else if (apr_strtoff(&last, dash + 1, &endp, 10) || *endp)
+        return FALSE;
+
+      if (last >= length)
+        last = length - 1;
+    }
+
+  if (first < 0 || first > last)
+    return FALSE;
+
+  *start = first;
+  *range_len = last - first + 1;
+  return TRUE;
+}
+
+
 static dav_error *
 deliver(const dav_resource *resource, ap_filter_t *unused)
 {
@@ -3608,6 +3682,7 @@ deliver(const dav_resource *resource, ap_filter_t *unused)
       apr_hash_t *entries;
       apr_pool_t *iterpool;
       apr_array_header_t *sorted;
+      svn_boolean_t *allowed = NULL;
       svn_revnum_t dir_rev = SVN_INVALID_REVNUM;
       int i;
 
@@ -3705,6 +3780,29 @@ deliver(const dav_resource *resource, ap_filter_t *unused)
       sorted = svn_sort__hash(entries, svn_sort_compare_items_as_paths,
                               resource->pool);
 
+      /* authorize all entries of a versioned directory at once */
+      if (SVN_IS_VALID_REVNUM(dir_rev))
+        {
+          apr_array_header_t *paths
+            = apr_array_make(resource->pool, sorted->nelts,
+                             sizeof(const char *));
+
+          for (i = 0; i < sorted->nelts; ++i)
+            {
+              const svn_sort__item_t *item
+                = &APR_ARRAY_IDX(sorted, i, const svn_sort__item_t);
+              APR_ARRAY_PUSH(paths, const char *)
+                = svn_fspath__join(resource->info->repos_path, item->key,
+                                   resource->pool);
+            }
+
+          allowed = apr_palloc(resource->pool,
+                               sorted->nelts * sizeof(*allowed));
+          dav_svn__allow_read_many(allowed, resource->info->r,
+                                   resource->info->repos, paths, dir_rev,
+                                   resource->pool);
+        }
+
       iterpool = svn_pool_create(resource->pool);
 
       for (i = 0; i < sorted->nelts; ++i)
@@ -3712,8 +3810,6 @@ deliver(const dav_resource *resource, ap_filter_t *unused)
           const svn_sort__item_t *item = &APR_ARRAY_IDX(sorted, i,
                                                         const svn_sort__item_t);
           const svn_fs_dirent_t *entry = item->value;
-          const char *name = item->key;
-          const char *repos_relpath = NULL;
 
           svn_pool_clear(iterpool);
 
@@ -3722,13 +3818,7 @@ deliver(const dav_resource *resource, ap_filter_t *unused)
              looking at a parent-path listing. */
           if (SVN_IS_VALID_REVNUM(dir_rev))
             {
-              repos_relpath = svn_fspath__join(resource->info->repos_path,
-                                               name, iterpool);
-              if (! dav_svn__allow_read(resource->info->r,
-                                        resource->info->repos,
-                                        repos_relpath,
-                                        dir_rev,
-                                        iterpool))
+              if (! allowed[i])
                 continue;
             }
           else
@@ -3780,6 +3870,10 @@ deliver(const dav_resource *resource, ap_filter_t *unused)
       svn_txdelta_window_handler_t handler;
       void * h_baton;
       diff_ctx_t dc = { 0 };
+      apr_file_t *stored_file;
+      apr_off_t stored_offset;
+      svn_filesize_t stored_length;
+      int stored_version;
 
       /* First order of business is to parse it. */
       serr = dav_svn__simple_parse_uri(&info, resource,
@@ -3813,6 +3907,46 @@ deliver(const dav_resource *resource, ap_filter_t *unused)
                                       "to a file in revision %ld",
                                       info.repos_path, info.rev));
 
+          /* If the repository already stores the target as a delta
+             against the base, in a format the client accepts, send that
+             svndiff data as it is instead of decoding and re-encoding it.
+             Don't trade a compressed format for an uncompressed one,
+             though. */
+          serr = svn_fs__open_stored_delta(&stored_file, &stored_offset,
+                                           &stored_length,
+                                           &stored_version,
+                                           root, info.repos_path,
+                                           resource->info->root.root,
+                                           resource->info->repos_path,
+                                           resource->pool, resource->pool);
+          if (serr != NULL)
+            return dav_svn__convert_err(serr, HTTP_INTERNAL_SERVER_ERROR,
+                                        "could not look up the stored delta",
+                                        resource->pool);
+
+          if (stored_file
+              && stored_version <= resource->info->svndiff_version
+              && (stored_version > 0
+                  || resource->info->svndiff_version == 0))
+            {
+              bb = apr_brigade_create(resource->pool,
+                                      dav_svn__output_get_bucket_alloc(output));
+              apr_brigade_insert_file(bb, stored_file, stored_offset,
+                                      stored_length, resource->pool);
+              bkt = apr_bucket_eos_create(
+                      dav_svn__output_get_bucket_alloc(output));
+              APR_BRIGADE_INSERT_TAIL(bb, bkt);
+
+              serr = dav_svn__output_pass_brigade(output, bb);
+              apr_brigade_destroy(bb);
+              if (serr != NULL)
+                return dav_svn__convert_err(serr, HTTP_INTERNAL_SERVER_ERROR,
+                                            "could not deliver the stored "
+                                            "delta", resource->pool);
+
+              return NULL;
+            }
+
           /* Okay. Let's open up a delta stream for the client to read. */
           serr = svn_fs_get_file_delta_stream(&txd_stream,
                                               root, info.repos_path,
@@ -3866,6 +4000,7 @@ deliver(const dav_resource *resource, ap_filter_t *unused)
     {
       svn_stream_t *stream;
       char *block;
+      apr_off_t remaining = -1; /* unlimited */
 
       serr = svn_fs_file_contents(&stream,
                                   resource->info->root.root,
@@ -3949,6 +4084,53 @@ deliver(const dav_resource *resource, ap_filter_t *unused)
             }
         }
 
+      /* A single byte range (e.g. resuming an interrupted download) is
+         served directly, seeking in the FS stream.  Anything else is left
+         to httpd's byterange filter, which would otherwise read through
+         the complete fulltext to cut out the range. */
+      if (! resource->info->keyword_subst)
+        {
+          svn_filesize_t length;
+          apr_off_t start;
+
+          serr = svn_fs_file_length(&length,
+                                    resource->info->root.root,
+                                    resource->info->repos_path,
+                                    resource->pool);
+          if (serr != NULL)
+            return dav_svn__convert_err(serr, HTTP_INTERNAL_SERVER_ERROR,
+                                        "could not fetch the resource length",
+                                        resource->pool);
+
+          if (get_single_byte_range(&start, &remaining, resource, length))
+            {
+              request_rec *r = resource->info->r;
+
+              r->status = HTTP_PARTIAL_CONTENT;
+              apr_table_setn(r->headers_out, "Content-Range",
+                             apr_psprintf(resource->pool,
+                                          "bytes %" APR_OFF_T_FMT
+                                          "-%" APR_OFF_T_FMT
+                                          "/%" SVN_FILESIZE_T_FMT,
+                                          start, start + remaining - 1,
+                                          length));
+              ap_set_content_length(r, remaining);
+
+              while (start > 0 && serr == NULL)
+                {
+                  apr_size_t skip = ((apr_uint64_t)start > APR_SIZE_MAX)
+                                      ? APR_SIZE_MAX : (apr_size_t)start;
+
+                  serr = svn_stream_skip(stream, skip);
+                  start -= skip;
+                }
+              if (serr != NULL)
+                return dav_svn__convert_err(serr, HTTP_INTERNAL_SERVER_ERROR,
+                                            "could not seek in the file "
+                                            "contents", resource->pool);
+            }
+        }
+
       /* ### one day in the future, we can create a custom bucket type
          ### which will read from the FS stream on demand */
 
@@ -3956,9 +4138,12 @@ deliver(const dav_resource *resource, ap_filter_t *unused)
       bb = apr_brigade_create(resource->pool,
                               dav_svn__output_get_bucket_alloc(output));
 
-      while (1) {
+      while (remaining != 0) {
         apr_size_t bufsize = SVN__STREAM_CHUNK_SIZE;
 
+        if (remaining > 0 && remaining < (apr_off_t)bufsize)
+          bufsize = (apr_size_t)remaining;
+
         /* read from the FS ... */
         serr = svn_stream_read_full(stream, block, &bufsize);
         if (serr != NULL)
@@ -3970,6 +4155,8 @@ deliver(const dav_resource *resource, ap_filter_t *unused)
           }
         if (bufsize == 0)
           break;
+        if (remaining > 0)
+          remaining -= bufsize;
 
         /* write to the filter ... */
         bkt = apr_bucket_transient_create(
@@ -4415,7 +4602,9 @@ do_walk(walker_ctx_t *ctx,
   apr_size_t uri_len;
   apr_size_t repos_len;
   apr_hash_t *children;
+  svn_boolean_t *allowed = NULL;
   apr_pool_t *iterpool;
+  int i;
 
   /* The current resource is a collection (possibly here thru recursion)
      and this is the invocation for the collection. Alternatively, this is
@@ -4490,9 +4679,36 @@ do_walk(walker_ctx_t *ctx,
                                 "could not fetch collection members",
                                 params->pool);
 
+  /* authorize access to all children at once, if applicable.  The
+     hash iteration order below matches the one used here. */
+  if (params->walk_type & DAV_WALKTYPE_AUTH)
+    {
+      const char *parent_path = apr_pstrmemdup(scratch_pool,
+                                               ctx->repos_path->data,
+                                               ctx->repos_path->len);
+      apr_array_header_t *child_paths
+        = apr_array_make(scratch_pool, apr_hash_count(children),
+                         sizeof(const char *));
+
+      for (hi = apr_hash_first(scratch_pool, children);
+           hi;
+           hi = apr_hash_next(hi))
+        APR_ARRAY_PUSH(child_paths, const char *)
+          = apr_pstrcat(scratch_pool, parent_path, apr_hash_this_key(hi),
+                        SVN_VA_NULL);
+
+      allowed = apr_palloc(scratch_pool,
+                           child_paths->nelts * sizeof(*allowed));
+      dav_svn__allow_read_many(allowed, ctx->info.r, ctx->info.repos,
+                               child_paths, ctx->info.root.rev,
+                               scratch_pool);
+    }
+
   /* iterate over the children in this collection */
   iterpool = svn_pool_create(scratch_pool);
-  for (hi = apr_hash_first(scratch_pool, children); hi; hi = apr_hash_next(hi))
+  for (hi = apr_hash_first(scratch_pool, children), i = 0;
+       hi;
+       hi = apr_hash_next(hi), ++i)
     {
       const void *key;
       apr_ssize_t klen;
@@ -4501,25 +4717,14 @@ do_walk(walker_ctx_t *ctx,
 
       svn_pool_clear(iterpool);
 
+      /* skip resources we have no access to */
+      if (allowed && !allowed[i])
+        continue;
+
       /* fetch one of the children */
       apr_hash_this(hi, &key, &klen, &val);
       dirent = val;
 
-      /* authorize access to this resource, if applicable */
-      if (params->walk_type & DAV_WALKTYPE_AUTH)
-        {
-          const char *repos_relpath =
-            apr_pstrcat(iterpool,
-                        apr_pstrmemdup(iterpool,
-                                       ctx->repos_path->data,
-                                       ctx->repos_path->len),
-                        key, SVN_VA_NULL);
-          if (! dav_svn__allow_read(ctx->info.r, ctx->info.repos,
-                                    repos_relpath, ctx->info.root.rev,
-                                    iterpool))
-            continue;
-        }
-
       /* append this child to our buffers */
       svn_stringbuf_appendbytes(ctx->info.uri_path, key, klen);
       svn_stringbuf_appendbytes(ctx->uri, key, klen);
@@ -262,6 +262,10 @@ get_option(const dav_resource *resource,
         }
     }
 
+  /* Blaming on the server can be disabled per location. */
+  if (dav_svn__get_allow_blame_flag(r))
+    apr_table_addn(r->headers_out, "DAV", SVN_DAV_NS_DAV_SVN_BLAME);
+
   if (resource->info->repos->repos)
     {
         svn_error_t *serr;
@@ -1180,6 +1184,10 @@ deliver_report(request_rec *r,
         {
           return dav_svn__list_report(resource, doc, output);
         }
+      else if (strcmp(doc->root->name, "blame-report") == 0)
+        {
+          return dav_svn__blame_report(resource, doc, output);
+        }
       /* NOTE: if you add a report, don't forget to add it to the
        *       dav_svn__reports_list[] array.
        */
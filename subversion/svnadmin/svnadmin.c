@@ -49,6 +49,7 @@
 #include "private/svn_subr_private.h"
 #include "private/svn_cmdline_private.h"
 #include "private/svn_fspath.h"
+#include "private/svn_repos_private.h"
 
 #include "svn_private_config.h"
 
@@ -95,6 +96,7 @@ check_lib_versions(void)
 /** Subcommands. **/
 
 static svn_opt_subcommand_t
+  subcommand_build_log_index,
   subcommand_crashtest,
   subcommand_create,
   subcommand_delrevprop,
@@ -303,6 +305,16 @@ static const apr_getopt_option_t options_table[] =
  */
 static const svn_opt_subcommand_desc3_t cmd_table[] =
 {
+  {"build-log-index", subcommand_build_log_index, {0}, {N_(
+    "usage: svnadmin build-log-index REPOS_PATH\n"
+    "\n"), N_(
+    "Create or update the log index of the repository at REPOS_PATH.\n"
+    "The index speeds up 'svn log' and 'svnlook history' for paths\n"
+    "other than the repository root.  Once created, it is kept up to\n"
+    "date by every commit.  It is not copied by 'hotcopy'.\n"
+   )},
+   {'M'} },
+
   {"crashtest", subcommand_crashtest, {0}, {N_(
     "usage: svnadmin crashtest REPOS_PATH\n"
     "\n"), N_(
@@ -796,6 +808,23 @@ crashtest_malfunction_handler(svn_boolean_t can_return,
   return SVN_NO_ERROR; /* Not reached. */
 }
 
+/* This implements `svn_opt_subcommand_t'. */
+static svn_error_t *
+subcommand_build_log_index(apr_getopt_t *os, void *baton, apr_pool_t *pool)
+{
+  struct svnadmin_opt_state *opt_state = baton;
+  svn_repos_t *repos;
+
+  /* Expect no more arguments. */
+  SVN_ERR(parse_args(NULL, os, 0, 0, pool));
+
+  SVN_ERR(open_repos(&repos, opt_state->repository_path, opt_state, pool));
+
+  return svn_error_trace(svn_repos__log_index_sync(svn_repos_fs(repos), TRUE,
+                                                   0, check_cancel, NULL,
+                                                   pool));
+}
+
 /* This implements `svn_opt_subcommand_t'. */
 static svn_error_t *
 subcommand_crashtest(apr_getopt_t *os, void *baton, apr_pool_t *pool)
@@ -43,6 +43,7 @@
 #include "svn_ra.h"              /* for SVN_RA_CAPABILITY_* */
 #include "svn_ra_svn.h"
 #include "svn_repos.h"
+#include "svn_diff.h"
 #include "svn_dirent_uri.h"
 #include "svn_path.h"
 #include "svn_time.h"
@@ -54,6 +55,7 @@
 #include "private/svn_log.h"
 #include "private/svn_mergeinfo_private.h"
 #include "private/svn_ra_svn_private.h"
+#include "private/svn_repos_private.h"
 #include "private/svn_fspath.h"
 
 #ifdef HAVE_UNISTD_H
@@ -103,6 +105,8 @@ typedef struct fs_warning_baton_t {
 } fs_warning_baton_t;
 
 typedef struct authz_baton_t {
+  /* Must be the first member; see authz_check_access_cb_func(). */
+  svn_repos__authz_batch_baton_t batch;
   server_baton_t *server;
   svn_ra_svn_conn_t *conn;
 } authz_baton_t;
@@ -416,6 +420,31 @@ static void convert_case(char *text, svn_boolean_t to_uppercase)
     }
 }
 
+/* Return the user name to use for authz checks in B, i.e. the client's
+   user name after any case normalization requested by the repository
+   configuration.  NULL for anonymous users. */
+static const char *get_authz_user(server_baton_t *b)
+{
+  repository_t *repository = b->repository;
+  client_info_t *client_info = b->client_info;
+
+  /* If we have a username, and we've not yet used it + any username
+     case normalization that might be requested to determine "the
+     username we used for authz purposes", do so now. */
+  if (client_info->user && (! client_info->authz_user))
+    {
+      char *authz_user = apr_pstrdup(b->pool, client_info->user);
+      if (repository->username_case == CASE_FORCE_UPPER)
+        convert_case(authz_user, TRUE);
+      else if (repository->username_case == CASE_FORCE_LOWER)
+        convert_case(authz_user, FALSE);
+
+      client_info->authz_user = authz_user;
+    }
+
+  return client_info->authz_user;
+}
+
 /* Set *ALLOWED to TRUE if PATH is accessible in the REQUIRED mode to
    the user described in BATON according to the authz rules in BATON.
    Use POOL for temporary allocations only.  If no authz rules are
@@ -427,7 +456,6 @@ static svn_error_t *authz_check_access(svn_boolean_t *allowed,
                                        apr_pool_t *pool)
 {
   repository_t *repository = b->repository;
-  client_info_t *client_info = b->client_info;
 
   /* If authz cannot be performed, grant access.  This is NOT the same
      as the default policy when authz is performed on a path with no
@@ -448,23 +476,9 @@ static svn_error_t *authz_check_access(svn_boolean_t *allowed,
   if (path && *path != '/')
     path = svn_fspath__canonicalize(path, pool);
 
-  /* If we have a username, and we've not yet used it + any username
-     case normalization that might be requested to determine "the
-     username we used for authz purposes", do so now. */
-  if (client_info->user && (! client_info->authz_user))
-    {
-      char *authz_user = apr_pstrdup(b->pool, client_info->user);
-      if (repository->username_case == CASE_FORCE_UPPER)
-        convert_case(authz_user, TRUE);
-      else if (repository->username_case == CASE_FORCE_LOWER)
-        convert_case(authz_user, FALSE);
-
-      client_info->authz_user = authz_user;
-    }
-
   SVN_ERR(svn_repos_authz_check_access(repository->authzdb,
                                        repository->authz_repos_name,
-                                       path, client_info->authz_user,
+                                       path, get_authz_user(b),
                                        required, allowed, pool));
   if (!*allowed)
     SVN_ERR(log_authz_denied(path, required, b, pool));
@@ -472,6 +486,53 @@ static svn_error_t *authz_check_access(svn_boolean_t *allowed,
   return SVN_NO_ERROR;
 }
 
+/* Like authz_check_access() but check read access to all PATHS at once
+   and set ALLOWED[i] for the i-th element of PATHS. */
+static svn_error_t *
+authz_check_read_access_many(svn_boolean_t *allowed,
+                             const apr_array_header_t *paths,
+                             server_baton_t *b,
+                             apr_pool_t *pool)
+{
+  repository_t *repository = b->repository;
+  apr_array_header_t *canonical_paths;
+  int i;
+
+  /* No authz, no restrictions. */
+  if (!repository->authzdb)
+    {
+      for (i = 0; i < paths->nelts; ++i)
+        allowed[i] = TRUE;
+
+      return SVN_NO_ERROR;
+    }
+
+  /* See authz_check_access() for why we canonicalize here. */
+  canonical_paths = apr_array_make(pool, paths->nelts, sizeof(const char *));
+  for (i = 0; i < paths->nelts; ++i)
+    {
+      const char *path = APR_ARRAY_IDX(paths, i, const char *);
+      if (path && *path != '/')
+        path = svn_fspath__canonicalize(path, pool);
+
+      APR_ARRAY_PUSH(canonical_paths, const char *) = path;
+    }
+
+  SVN_ERR(svn_repos__authz_check_access_many(repository->authzdb,
+                                             repository->authz_repos_name,
+                                             canonical_paths,
+                                             get_authz_user(b),
+                                             svn_authz_read, allowed, pool));
+
+  for (i = 0; i < paths->nelts; ++i)
+    if (!allowed[i])
+      SVN_ERR(log_authz_denied(APR_ARRAY_IDX(canonical_paths, i,
+                                             const char *),
+                               svn_authz_read, b, pool));
+
+  return SVN_NO_ERROR;
+}
+
 /* Set *ALLOWED to TRUE if PATH is readable by the user described in
  * BATON.  Use POOL for temporary allocations only.  ROOT is not used.
  * Implements the svn_repos_authz_func_t interface.
@@ -488,13 +549,36 @@ static svn_error_t *authz_check_access_cb(svn_boolean_t *allowed,
                             sb->server, pool);
 }
 
-/* If authz is enabled in the specified BATON, return a read authorization
-   function. Otherwise, return NULL. */
-static svn_repos_authz_func_t authz_check_access_cb_func(server_baton_t *baton)
+/* Set ALLOWED[i] to TRUE if the i-th element of PATHS is readable by the
+ * user described in BATON.  Use POOL for temporary allocations only.
+ * ROOT is not used.  Implements the svn_repos__authz_batch_func_t
+ * interface.
+ */
+static svn_error_t *
+authz_check_access_batch_cb(svn_boolean_t *allowed,
+                            svn_fs_root_t *root,
+                            const apr_array_header_t *paths,
+                            void *baton,
+                            apr_pool_t *pool)
+{
+  authz_baton_t *sb = baton;
+
+  return authz_check_read_access_many(allowed, paths, sb->server, pool);
+}
+
+/* If authz is enabled for the server in the specified BATON, return a read
+   authorization function to be used with BATON.  Otherwise, return NULL.
+   BATON->SERVER must already be set. */
+static svn_repos_authz_func_t authz_check_access_cb_func(authz_baton_t *baton)
 {
-  if (baton->repository->authzdb)
-     return authz_check_access_cb;
-  return NULL;
+  if (!baton->server->repository->authzdb)
+    return NULL;
+
+  /* Allow libsvn_repos to check multiple paths at once. */
+  baton->batch.read_func = authz_check_access_cb;
+  baton->batch.batch_func = authz_check_access_batch_cb;
+
+  return svn_repos__authz_batch_read_func;
 }
 
 /* Set *ALLOWED to TRUE if the REQUIRED access to PATH is granted,
@@ -985,9 +1069,10 @@ static svn_error_t *accept_report(svn_boolean_t *only_empty_entry,
                                       tgt_path, text_deltas, depth,
                                       ignore_ancestry, send_copyfrom_args,
                                       editor, edit_baton,
-                                      authz_check_access_cb_func(b),
+                                      authz_check_access_cb_func(&ab),
                                       &ab, svn_ra_svn_zero_copy_limit(conn),
                                       pool));
+  svn_repos__report_set_delta_threads(report_baton, b->delta_threads);
 
   rb.sb = b;
   rb.repos_url = svn_path_uri_decode(b->repository->repos_url, pool);
@@ -1097,7 +1182,7 @@ get_props(apr_hash_t **props,
     {
       SVN_ERR(svn_repos_fs_get_inherited_props(
                 iprops, root, path, NULL,
-                authz_check_access_cb_func(b->server),
+                authz_check_access_cb_func(b),
                 b, pool, pool));
     }
 
@@ -1186,8 +1271,8 @@ static svn_error_t *do_change_rev_prop(svn_ra_svn_conn_t *conn,
                                             b->client_info->user,
                                             name, old_value_p, value,
                                             TRUE, TRUE,
-                                            authz_check_access_cb_func(b), &ab,
-                                            pool));
+                                            authz_check_access_cb_func(&ab),
+                                            &ab, pool));
   SVN_ERR(svn_ra_svn__write_cmd_response(conn, pool, ""));
 
   return SVN_NO_ERROR;
@@ -1273,7 +1358,7 @@ rev_proplist(svn_ra_svn_conn_t *conn,
   SVN_ERR(trivial_auth_request(conn, pool, b));
   SVN_CMD_ERR(svn_repos_fs_revision_proplist(&props, b->repository->repos,
                                              rev,
-                                             authz_check_access_cb_func(b),
+                                             authz_check_access_cb_func(&ab),
                                              &ab, pool));
   SVN_ERR(svn_ra_svn__write_tuple(conn, pool, "w((!", "success"));
   SVN_ERR(svn_ra_svn__write_proplist(conn, pool, props));
@@ -1302,7 +1387,7 @@ rev_prop(svn_ra_svn_conn_t *conn,
 
   SVN_ERR(trivial_auth_request(conn, pool, b));
   SVN_CMD_ERR(svn_repos_fs_revision_prop(&value, b->repository->repos, rev,
-                                         name, authz_check_access_cb_func(b),
+                                         name, authz_check_access_cb_func(&ab),
                                          &ab, pool));
   SVN_ERR(svn_ra_svn__write_cmd_response(conn, pool, "(?s)", value));
   return SVN_NO_ERROR;
@@ -1551,6 +1636,46 @@ commit(svn_ra_svn_conn_t *conn,
   return SVN_NO_ERROR;
 }
 
+/* Baton for write_cached_contents(). */
+typedef struct cached_contents_baton_t
+{
+  svn_ra_svn_conn_t *conn;
+
+  /* Only contents up to this size will be sent from the cache. */
+  apr_size_t zero_copy_limit;
+
+  /* Set if the contents have been sent. */
+  svn_boolean_t sent;
+} cached_contents_baton_t;
+
+/* Implement svn_fs_process_contents_func_t.  If LEN does not exceed the
+ * limit given in BATON, send CONTENTS as a single string over the
+ * connection in BATON and set its SENT flag.  Otherwise, leave it to the
+ * caller to stream the contents.
+ */
+static svn_error_t *
+write_cached_contents(const unsigned char *contents,
+                      apr_size_t len,
+                      void *baton,
+                      apr_pool_t *pool)
+{
+  cached_contents_baton_t *b = baton;
+  svn_string_t write_str;
+
+  if (len > b->zero_copy_limit)
+    return SVN_NO_ERROR;
+
+  /* Large strings bypass the connection buffer and go straight from the
+     cache to the network. */
+  write_str.data = (const char *)contents;
+  write_str.len = len;
+  if (len > 0)
+    SVN_ERR(svn_ra_svn__write_string(b->conn, pool, &write_str));
+
+  b->sent = TRUE;
+  return SVN_NO_ERROR;
+}
+
 static svn_error_t *
 get_file(svn_ra_svn_conn_t *conn,
          apr_pool_t *pool,
@@ -1646,8 +1771,27 @@ get_file(svn_ra_svn_conn_t *conn,
   /* Now send the file's contents. */
   if (want_contents)
     {
+      svn_boolean_t done = FALSE;
+
       err = SVN_NO_ERROR;
-      while (1)
+      if (svn_ra_svn_zero_copy_limit(conn) > 0)
+        {
+          /* Fulltexts found in the cache can be sent without copying
+             them through BUF. */
+          cached_contents_baton_t cached;
+
+          cached.conn = conn;
+          cached.zero_copy_limit = svn_ra_svn_zero_copy_limit(conn);
+          cached.sent = FALSE;
+          err = svn_fs_try_process_file_contents(&done, root, full_path,
+                                                 write_cached_contents,
+                                                 &cached, pool);
+          done = done && cached.sent;
+          if (!err && done)
+            err = svn_stream_close(contents);
+        }
+
+      while (!err && !done)
         {
           len = sizeof(buf);
           err = svn_stream_read_full(contents, buf, &len);
@@ -1921,15 +2065,17 @@ update(svn_ra_svn_conn_t *conn,
   svn_boolean_t recurse;
   svn_tristate_t send_copyfrom_args; /* Optional; default FALSE */
   svn_tristate_t ignore_ancestry; /* Optional; default FALSE */
+  svn_tristate_t text_deltas; /* Optional; default TRUE */
   /* Default to unknown.  Old clients won't send depth, but we'll
      handle that by converting recurse if necessary. */
   svn_depth_t depth = svn_depth_unknown;
   svn_boolean_t is_checkout;
 
   /* Parse the arguments. */
-  SVN_ERR(svn_ra_svn__parse_tuple(params, "(?r)cb?w3?3", &rev, &target,
+  SVN_ERR(svn_ra_svn__parse_tuple(params, "(?r)cb?w3?33", &rev, &target,
                                   &recurse, &depth_word,
-                                  &send_copyfrom_args, &ignore_ancestry));
+                                  &send_copyfrom_args, &ignore_ancestry,
+                                  &text_deltas));
   target = svn_relpath_canonicalize(target, pool);
 
   if (depth_word)
@@ -1945,7 +2091,8 @@ update(svn_ra_svn_conn_t *conn,
     SVN_CMD_ERR(svn_fs_youngest_rev(&rev, b->repository->fs, pool));
 
   SVN_ERR(accept_report(&is_checkout, NULL,
-                        conn, pool, b, rev, target, NULL, TRUE,
+                        conn, pool, b, rev, target, NULL,
+                        (text_deltas != svn_tristate_false),
                         depth,
                         (send_copyfrom_args == svn_tristate_true),
                         (ignore_ancestry == svn_tristate_true)));
@@ -2237,7 +2384,7 @@ get_mergeinfo(svn_ra_svn_conn_t *conn,
                                           canonical_paths, rev,
                                           inherit,
                                           include_descendants,
-                                          authz_check_access_cb_func(b), &ab,
+                                          authz_check_access_cb_func(&ab), &ab,
                                           mergeinfo_receiver,
                                           &mergeinfo_baton,
                                           pool));
@@ -2469,7 +2616,7 @@ log_cmd(svn_ra_svn_conn_t *conn,
   err = svn_repos_get_logs5(b->repository->repos, full_paths, start_rev,
                             end_rev, (int) limit,
                             strict_node, include_merged_revisions,
-                            revprops, authz_check_access_cb_func(b), &ab,
+                            revprops, authz_check_access_cb_func(&ab), &ab,
                             send_changed_paths ? path_change_receiver : NULL,
                             send_changed_paths ? &lb : NULL,
                             revision_receiver, &lb, pool);
@@ -2625,7 +2772,7 @@ get_locations(svn_ra_svn_conn_t *conn,
   err = svn_repos_trace_node_locations(b->repository->fs, &fs_locations,
                                        abs_path, peg_revision,
                                        location_revisions,
-                                       authz_check_access_cb_func(b), &ab,
+                                       authz_check_access_cb_func(&ab), &ab,
                                        pool);
 
   /* Now, write the results to the connection. */
@@ -2755,7 +2902,7 @@ get_location_segments(svn_ra_svn_conn_t *conn,
   err = svn_repos_node_location_segments(b->repository->repos, abs_path,
                                          peg_revision, start_rev, end_rev,
                                          gls_receiver, (void *)conn,
-                                         authz_check_access_cb_func(b), &ab,
+                                         authz_check_access_cb_func(&ab), &ab,
                                          pool);
   write_err = svn_ra_svn__write_word(conn, pool, "done");
   if (write_err)
@@ -2873,7 +3020,7 @@ get_file_revs(svn_ra_svn_conn_t *conn,
 
   err = svn_repos_get_file_revs2(b->repository->repos, full_path, start_rev,
                                  end_rev, include_merged_revisions,
-                                 authz_check_access_cb_func(b), &ab,
+                                 authz_check_access_cb_func(&ab), &ab,
                                  file_rev_handler, &frb, pool);
   write_err = svn_ra_svn__write_word(conn, pool, "done");
   if (write_err)
@@ -3365,7 +3512,7 @@ get_locks(svn_ra_svn_conn_t *conn,
                       svn_path_uri_encode(full_path, pool)));
   SVN_CMD_ERR(svn_repos_fs_get_locks2(&locks, b->repository->repos,
                                       full_path, depth,
-                                      authz_check_access_cb_func(b), &ab,
+                                      authz_check_access_cb_func(&ab), &ab,
                                       pool));
 
   SVN_ERR(svn_ra_svn__write_tuple(conn, pool, "w((!", "success"));
@@ -3407,7 +3554,7 @@ static svn_error_t *replay_one_revision(svn_ra_svn_conn_t *conn,
   if (! err)
     err = svn_repos_replay2(root, b->repository->fs_path->data,
                             low_water_mark, send_deltas, editor, edit_baton,
-                            authz_check_access_cb_func(b), &ab, pool);
+                            authz_check_access_cb_func(&ab), &ab, pool);
 
   if (err)
     svn_error_clear(editor->abort_edit(edit_baton, pool));
@@ -3467,11 +3614,10 @@ replay_range(svn_ra_svn_conn_t *conn,
 
       svn_pool_clear(iterpool);
 
-      SVN_CMD_ERR(svn_repos_fs_revision_proplist(&props,
-                                                 b->repository->repos, rev,
-                                                 authz_check_access_cb_func(b),
-                                                 &ab,
-                                                 iterpool));
+      SVN_CMD_ERR(svn_repos_fs_revision_proplist(
+                                        &props, b->repository->repos, rev,
+                                        authz_check_access_cb_func(&ab), &ab,
+                                        iterpool));
       SVN_ERR(svn_ra_svn__write_tuple(conn, iterpool, "w(!", "revprops"));
       SVN_ERR(svn_ra_svn__write_proplist(conn, iterpool, props));
       SVN_ERR(svn_ra_svn__write_tuple(conn, iterpool, "!)"));
@@ -3670,7 +3816,7 @@ list(svn_ra_svn_conn_t *conn,
   /* Fetch the directory entries if requested and send them immediately. */
   path_info_only = (rb.dirent_fields & ~SVN_DIRENT_KIND) == 0;
   err = svn_repos_list(root, full_path, patterns, depth, path_info_only,
-                       authz_check_access_cb_func(b), &ab, list_receiver,
+                       authz_check_access_cb_func(&ab), &ab, list_receiver,
                        &rb, NULL, NULL, pool);
 
 
@@ -3686,6 +3832,119 @@ list(svn_ra_svn_conn_t *conn,
   return svn_error_trace(svn_ra_svn__write_cmd_response(conn, pool, ""));
 }
 
+/* Baton type to be used with blame_receiver. */
+typedef struct blame_receiver_baton_t
+{
+  /* Send the data through this connection. */
+  svn_ra_svn_conn_t *conn;
+
+  /* Set of revisions (svn_revnum_t) whose revprops have been sent. */
+  apr_hash_t *sent_revs;
+} blame_receiver_baton_t;
+
+/* Implements svn_diff__blame_line_func_t, sending LINE and REVISION to
+ * the client.  The REV_PROPS are only sent for the first line blamed
+ * on REVISION.  BATON must be a blame_receiver_baton_t. */
+static svn_error_t *
+blame_receiver(void *baton,
+               apr_int64_t line_no,
+               svn_revnum_t revision,
+               apr_hash_t *rev_props,
+               const char *line,
+               apr_pool_t *pool)
+{
+  blame_receiver_baton_t *b = baton;
+  svn_boolean_t send_props = FALSE;
+
+  if (SVN_IS_VALID_REVNUM(revision)
+      && !apr_hash_get(b->sent_revs, &revision, sizeof(revision)))
+    {
+      apr_pool_t *hash_pool = apr_hash_pool_get(b->sent_revs);
+      svn_revnum_t *key = apr_pmemdup(hash_pool, &revision,
+                                      sizeof(revision));
+
+      apr_hash_set(b->sent_revs, key, sizeof(*key), key);
+      send_props = TRUE;
+    }
+
+  SVN_ERR(svn_ra_svn__write_tuple(b->conn, pool, "c(?r)(!", line,
+                                  revision));
+  if (send_props)
+    SVN_ERR(svn_ra_svn__write_proplist(b->conn, pool, rev_props));
+
+  return svn_error_trace(svn_ra_svn__write_tuple(b->conn, pool, "!)"));
+}
+
+static svn_error_t *
+blame(svn_ra_svn_conn_t *conn,
+      apr_pool_t *pool,
+      svn_ra_svn__list_t *params,
+      void *baton)
+{
+  server_baton_t *b = baton;
+  svn_error_t *err, *write_err;
+  blame_receiver_baton_t rb;
+  svn_revnum_t start_rev, end_rev;
+  const char *path;
+  const char *full_path;
+  const char *ignore_space_word;
+  svn_boolean_t ignore_eol_style;
+  svn_diff_file_options_t *diff_options;
+  svn_diff__file_blame_t *file_blame;
+  authz_baton_t ab;
+
+  ab.server = b;
+  ab.conn = conn;
+
+  /* Parse arguments. */
+  SVN_ERR(svn_ra_svn__parse_tuple(params, "c(?r)(?r)wb", &path,
+                                  &start_rev, &end_rev, &ignore_space_word,
+                                  &ignore_eol_style));
+  path = svn_relpath_canonicalize(path, pool);
+  SVN_ERR(trivial_auth_request(conn, pool, b));
+
+  /* We did not advertise the capability in that case. */
+  if (!b->repository->allow_blame)
+    SVN_CMD_ERR(svn_error_create(SVN_ERR_UNSUPPORTED_FEATURE, NULL,
+                                 "Blame is disabled for this repository"));
+
+  full_path = svn_fspath__join(b->repository->fs_path->data, path, pool);
+
+  diff_options = svn_diff_file_options_create(pool);
+  diff_options->ignore_eol_style = ignore_eol_style;
+  if (strcmp(ignore_space_word, "change") == 0)
+    diff_options->ignore_space = svn_diff_file_ignore_space_change;
+  else if (strcmp(ignore_space_word, "all") == 0)
+    diff_options->ignore_space = svn_diff_file_ignore_space_all;
+
+  SVN_ERR(log_command(b, conn, pool, "%s",
+                      svn_log__blame(full_path, start_rev, end_rev, pool)));
+
+  rb.conn = conn;
+  rb.sent_revs = apr_hash_make(pool);
+
+  /* The repository layer reconstructs the fulltexts and libsvn_diff
+     attributes their lines. */
+  SVN_ERR(svn_diff__file_blame_create(&file_blame, diff_options, NULL, NULL,
+                                      pool));
+  err = svn_repos__get_blame_fulltexts(b->repository->repos, full_path,
+                                       start_rev, end_rev,
+                                       authz_check_access_cb_func(&ab), &ab,
+                                       svn_diff__file_blame_add, file_blame,
+                                       NULL, NULL, pool, pool);
+  if (!err)
+    err = svn_diff__file_blame_report(file_blame, blame_receiver, &rb, pool);
+  write_err = svn_ra_svn__write_word(conn, pool, "done");
+  if (write_err)
+    {
+      svn_error_clear(err);
+      return write_err;
+    }
+  SVN_CMD_ERR(err);
+
+  return svn_error_trace(svn_ra_svn__write_cmd_response(conn, pool, ""));
+}
+
 static const svn_ra_svn__cmd_entry_t main_commands[] = {
   { "reparent",        reparent },
   { "get-latest-rev",  get_latest_rev },
@@ -3719,6 +3978,7 @@ static const svn_ra_svn__cmd_entry_t main_commands[] = {
   { "get-deleted-rev", get_deleted_rev },
   { "get-iprops",      get_inherited_props },
   { "list",            list },
+  { "blame",           blame },
   { NULL }
 };
 
@@ -3731,6 +3991,8 @@ static const char *skip_scheme_part(const char *url)
   url += 3;
   if (*url == '+')
     url += strcspn(url, ":");
+  else if (*url == 's')
+    url++;
   if (strncmp(url, "://", 3) != 0)
     return NULL;
   return url + 3;
@@ -3924,6 +4186,12 @@ find_repos(const char *url,
   SVN_ERR(svn_repos_hooks_setenv(repository->repos, hooks_env, scratch_pool));
   repository->hooks_env = apr_pstrdup(result_pool, hooks_env);
 
+  /* Calculating blame information may be too expensive for some
+     servers. */
+  SVN_ERR(svn_config_get_bool(cfg, &repository->allow_blame,
+                              SVN_CONFIG_SECTION_GENERAL,
+                              SVN_CONFIG_OPTION_ALLOW_BLAME, TRUE));
+
   return SVN_NO_ERROR;
 }
 
@@ -4110,6 +4378,10 @@ construct_server_baton(server_baton_t **baton,
   fs_warning_baton_t *warn_baton;
   svn_stringbuf_t *cap_log = svn_stringbuf_create_empty(scratch_pool);
 
+  /* The TLS handshake precedes the greeting. */
+  if (params->tls)
+    SVN_ERR(svn_ra_svn__tls_accept(conn, params->tls, scratch_pool));
+
   b->repository = apr_pcalloc(conn_pool, sizeof(*b->repository));
   b->repository->username_case = params->username_case;
   b->repository->base = params->base;
@@ -4121,6 +4393,7 @@ construct_server_baton(server_baton_t **baton,
   b->read_only = params->read_only;
   b->pool = conn_pool;
   b->vhost = params->vhost;
+  b->delta_threads = params->delta_threads;
 
   b->logger = params->logger;
   b->client_info = get_client_info(conn, params, conn_pool);
@@ -4129,7 +4402,7 @@ construct_server_baton(server_baton_t **baton,
    * send an empty mechlist. */
   if (params->compression_level > 0)
     SVN_ERR(svn_ra_svn__write_cmd_response(conn, scratch_pool,
-                                           "nn()(wwwwwwwwwwwww)",
+                                           "nn()(wwwwwwwwwwwwww)",
                                            (apr_uint64_t) 2, (apr_uint64_t) 2,
                                            SVN_RA_SVN_CAP_EDIT_PIPELINE,
                                            SVN_RA_SVN_CAP_SVNDIFF1,
@@ -4143,11 +4416,12 @@ construct_server_baton(server_baton_t **baton,
                                            SVN_RA_SVN_CAP_INHERITED_PROPS,
                                            SVN_RA_SVN_CAP_EPHEMERAL_TXNPROPS,
                                            SVN_RA_SVN_CAP_GET_FILE_REVS_REVERSE,
-                                           SVN_RA_SVN_CAP_LIST
+                                           SVN_RA_SVN_CAP_LIST,
+                                           SVN_RA_SVN_CAP_SKELTA
                                            ));
   else
     SVN_ERR(svn_ra_svn__write_cmd_response(conn, scratch_pool,
-                                           "nn()(wwwwwwwwwww)",
+                                           "nn()(wwwwwwwwwwww)",
                                            (apr_uint64_t) 2, (apr_uint64_t) 2,
                                            SVN_RA_SVN_CAP_EDIT_PIPELINE,
                                            SVN_RA_SVN_CAP_ABSENT_ENTRIES,
@@ -4159,7 +4433,8 @@ construct_server_baton(server_baton_t **baton,
                                            SVN_RA_SVN_CAP_INHERITED_PROPS,
                                            SVN_RA_SVN_CAP_EPHEMERAL_TXNPROPS,
                                            SVN_RA_SVN_CAP_GET_FILE_REVS_REVERSE,
-                                           SVN_RA_SVN_CAP_LIST
+                                           SVN_RA_SVN_CAP_LIST,
+                                           SVN_RA_SVN_CAP_SKELTA
                                            ));
 
   /* Read client response, which we assume to be in version 2 format:
@@ -4268,6 +4543,10 @@ construct_server_baton(server_baton_t **baton,
     if (supports_mergeinfo)
       SVN_ERR(svn_ra_svn__write_word(conn, scratch_pool,
                                      SVN_RA_SVN_CAP_MERGEINFO));
+    /* Blaming on the server can be turned off per repository. */
+    if (b->repository->allow_blame)
+      SVN_ERR(svn_ra_svn__write_word(conn, scratch_pool,
+                                     SVN_RA_SVN_CAP_BLAME));
     SVN_ERR(svn_ra_svn__write_tuple(conn, scratch_pool, "!))"));
     SVN_ERR(svn_ra_svn__flush(conn, scratch_pool));
   }
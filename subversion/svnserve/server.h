@@ -38,6 +38,7 @@ extern "C" {
 
 #include "private/svn_atomic.h"
 #include "private/svn_mutex.h"
+#include "private/svn_ra_svn_private.h"
 #include "private/svn_repos_private.h"
 #include "private/svn_subr_private.h"
 
@@ -65,6 +66,7 @@ typedef struct repository_t {
   enum username_case_type username_case; /* Case-normalize the username? */
   svn_boolean_t use_sasl;  /* Use Cyrus SASL for authentication;
                               always false if SVN_HAVE_SASL not defined */
+  svn_boolean_t allow_blame; /* Calculate blame information for clients */
 #ifdef SVN_HAVE_SASL
   unsigned min_ssf;        /* min-encryption SASL parameter */
   unsigned max_ssf;        /* max-encryption SASL parameter */
@@ -90,6 +92,7 @@ typedef struct server_baton_t {
                               May be NULL even if log_file is not. */
   svn_boolean_t read_only; /* Disallow write access (global flag) */
   svn_boolean_t vhost;     /* Use virtual-host-based path to repo. */
+  int delta_threads;       /* Threads to prefetch update deltas with. */
   apr_pool_t *pool;
 } server_baton_t;
 
@@ -159,6 +162,15 @@ typedef struct serve_params_t {
 
   /* Use virtual-host-based path to repo. */
   svn_boolean_t vhost;
+
+  /* Number of worker threads per update report to calculate file
+     deltas with ahead of the editor drive.  Values below 2 disable
+     that. */
+  int delta_threads;
+
+  /* If not NULL, accept only TLS encrypted connections, using the
+     certificate and key of this server context. */
+  svn_ra_svn__tls_server_t *tls;
 } serve_params_t;
 
 /* This structure contains all data that describes a client / server
@@ -178,6 +190,10 @@ typedef struct connection_t
   /* buffered connection object used by the marshaller */
   svn_ra_svn_conn_t *conn;
 
+  /* poll descriptor for USOCK, used to park the connection while it is
+     idle in event mode.  NULL in all other modes. */
+  struct apr_pollfd_t *pollfd;
+
   /* memory pool for objects with connection lifetime */
   apr_pool_t *pool;
 
@@ -56,10 +56,12 @@
 #include "private/svn_cmdline_private.h"
 #include "private/svn_atomic.h"
 #include "private/svn_mutex.h"
+#include "private/svn_ra_svn_private.h"
 #include "private/svn_subr_private.h"
 
 #if APR_HAS_THREADS
 #    include <apr_thread_pool.h>
+#    include <apr_poll.h>
 #endif
 
 #include "winservice.h"
@@ -76,6 +78,8 @@
 enum connection_handling_mode {
   connection_mode_fork,   /* Create a process per connection */
   connection_mode_thread, /* Create a thread per connection */
+  connection_mode_event,  /* Park idle connections, serve commands on
+                             worker threads */
   connection_mode_single  /* One connection at a time in this process */
 };
 
@@ -222,6 +226,11 @@ void winservice_notify_stop(void)
 #define SVNSERVE_OPT_MAX_REQUEST     274
 #define SVNSERVE_OPT_MAX_RESPONSE    275
 #define SVNSERVE_OPT_CACHE_NODEPROPS 276
+#define SVNSERVE_OPT_AUTHZ_CACHE_DIR 277
+#define SVNSERVE_OPT_DELTA_THREADS   278
+#define SVNSERVE_OPT_EVENT_LOOP      279
+#define SVNSERVE_OPT_TLS_CERT_FILE   280
+#define SVNSERVE_OPT_TLS_KEY_FILE    281
 
 /* Text macro because we can't use #ifdef sections inside a N_("...")
    macro expansion. */
@@ -325,6 +334,12 @@ static const apr_getopt_option_t svnserve__options[] =
         "Default is yes.\n"
         "                             "
         "[used for FSFS repositories only]")},
+    {"authz-cache-dir", SVNSERVE_OPT_AUTHZ_CACHE_DIR, 1,
+     N_("keep compiled authz rules in directory ARG, so\n"
+        "                             "
+        "they don't need to be parsed again by other\n"
+        "                             "
+        "server processes.")},
     {"client-speed", SVNSERVE_OPT_CLIENT_SPEED, 1,
      N_("Optimize network handling based on the assumption\n"
         "                             "
@@ -362,6 +377,25 @@ static const apr_getopt_option_t svnserve__options[] =
         "                             "
         "Default is " APR_STRINGIFY(THREADPOOL_MAX_SIZE) "."
         ONLY_AVAILABLE_WITH_THEADS)},
+    {"event-loop",       SVNSERVE_OPT_EVENT_LOOP, 0,
+     N_("serve commands on worker threads but don't\n"
+        "                             "
+        "occupy any thread while a connection is idle\n"
+        "                             "
+        "[mode: daemon]"
+        ONLY_AVAILABLE_WITH_THEADS)},
+    {"update-delta-threads", SVNSERVE_OPT_DELTA_THREADS, 1,
+     N_("Calculate file deltas for updates and checkouts\n"
+        "                             "
+        "on up to ARG threads per request, ahead of sending\n"
+        "                             "
+        "them to the client.\n"
+        "                             "
+        "Default is 0 (deltas are calculated inline),\n"
+        "                             "
+        "maximum is "
+        APR_STRINGIFY(SVN_REPOS__MAX_DELTA_THREADS) "."
+        ONLY_AVAILABLE_WITH_THEADS)},
 #endif
     {"max-request-size", SVNSERVE_OPT_MAX_REQUEST, 1,
      N_("Maximum acceptable size of a client request in MB.\n"
@@ -415,6 +449,14 @@ static const apr_getopt_option_t svnserve__options[] =
      N_("virtual host mode (look for repo in directory\n"
         "                             "
         "of provided hostname)")},
+    {"tls-cert-file",    SVNSERVE_OPT_TLS_CERT_FILE, 1,
+     N_("accept only TLS encrypted connections (svns://),\n"
+        "                             "
+        "presenting the PEM certificate chain in file ARG\n"
+        "                             "
+        "[mode: daemon, inetd, listen-once]")},
+    {"tls-key-file",     SVNSERVE_OPT_TLS_KEY_FILE, 1,
+     N_("PEM private key file for --tls-cert-file")},
     {"version",           SVNSERVE_OPT_VERSION, 0,
      N_("show program version information")},
     {"quiet",            'q', 0,
@@ -656,6 +698,160 @@ static void * APR_THREAD_FUNC serve_thread(apr_thread_t *tid, void *data)
   return NULL;
 }
 
+/* In event mode, idle connections are not served by any thread.  Instead,
+   they get parked in this pollset together with the listening socket.
+   Whenever a client sends a new command, the main thread removes the
+   connection from the pollset and hands it to a worker thread.
+   NULL in all other modes. */
+static apr_pollset_t *idle_connections;
+
+/* Number of events to fetch from IDLE_CONNECTIONS in a single call. */
+#define EVENT_LOOP_BATCH_SIZE 1024
+
+/* Load determination callback for serve_interruptable in event mode:
+   Never wait for the next command on a worker thread. */
+static svn_boolean_t
+is_always_busy(connection_t *connection)
+{
+  return TRUE;
+}
+
+/* Serve the connection given by DATA in event mode, i.e. execute all
+   commands that have already been received and then park the connection
+   in IDLE_CONNECTIONS. */
+static void * APR_THREAD_FUNC serve_event_thread(apr_thread_t *tid,
+                                                 void *data)
+{
+  svn_boolean_t done = FALSE;
+  svn_boolean_t has_command = TRUE;
+  connection_t *connection = data;
+  svn_error_t *err = SVN_NO_ERROR;
+  apr_status_t status;
+
+  apr_pool_t *pool = svn_root_pools__acquire_pool(connection_pools);
+
+  /* The client may have sent several commands back-to-back, which may
+     already sit in our receive buffer where the pollset won't see them. */
+  while (!err && !done && has_command)
+    {
+      err = serve_interruptable(&done, connection, is_always_busy, pool);
+      if (!err && !done)
+        err = svn_ra_svn__has_command(&has_command, &done, connection->conn,
+                                      pool);
+    }
+
+  if (err)
+    {
+      logger__log_error(connection->params->logger, err, NULL,
+                        get_client_info(connection->conn, connection->params,
+                                        pool));
+      svn_error_clear(err);
+      done = TRUE;
+    }
+  svn_root_pools__release_pool(pool, connection_pools);
+
+  /* Close or park connection.  Once it is back in the pollset, it may get
+     picked up by another thread at any time, so don't touch it anymore. */
+  if (!done)
+    {
+      status = apr_pollset_add(idle_connections, connection->pollfd);
+      if (status)
+        {
+          err = svn_error_wrap_apr(status, _("Can't park connection"));
+          logger__log_error(connection->params->logger, err, NULL, NULL);
+          svn_error_clear(err);
+          done = TRUE;
+        }
+    }
+
+  if (done)
+    close_connection(connection);
+
+  return NULL;
+}
+
+/* Run the event loop of the event mode:  Accept new connections from
+   SOCK and dispatch commands coming in on idle connections to the
+   worker THREADS.  Connections get initialized with PARAMS.  Use POOL
+   for all allocations.  This function does not return unless an error
+   occurred. */
+static svn_error_t *
+serve_event_loop(apr_socket_t *sock,
+                 serve_params_t *params,
+                 apr_pool_t *pool)
+{
+  apr_pollfd_t listener = { 0 };
+  apr_status_t status;
+
+  /* Worker threads park their connections concurrently to our polling. */
+  status = apr_pollset_create(&idle_connections, EVENT_LOOP_BATCH_SIZE,
+                              pool, APR_POLLSET_THREADSAFE);
+  if (status)
+    return svn_error_wrap_apr(status,
+                              _("Can't create pollset for event mode"));
+
+  listener.p = pool;
+  listener.desc_type = APR_POLL_SOCKET;
+  listener.reqevents = APR_POLLIN;
+  listener.desc.s = sock;
+  listener.client_data = NULL;
+
+  status = apr_pollset_add(idle_connections, &listener);
+  if (status)
+    return svn_error_wrap_apr(status, _("Can't poll listening socket"));
+
+  while (1)
+    {
+      const apr_pollfd_t *ready;
+      apr_int32_t count;
+      int i;
+
+      status = apr_pollset_poll(idle_connections, -1, &count, &ready);
+      if (APR_STATUS_IS_EINTR(status))
+        continue;
+      if (status)
+        return svn_error_wrap_apr(status, _("Can't poll connections"));
+
+      for (i = 0; i < count; ++i)
+        {
+          connection_t *connection = ready[i].client_data;
+
+          if (connection)
+            {
+              /* A command (or the end of the session) arrived.  Keep the
+                 pollset from reporting it again while a worker is busy. */
+              status = apr_pollset_remove(idle_connections,
+                                          connection->pollfd);
+              if (status)
+                return svn_error_wrap_apr(status,
+                                          _("Can't unpark connection"));
+            }
+          else
+            {
+              SVN_ERR(accept_connection(&connection, sock, params,
+                                        connection_mode_event, pool));
+
+              connection->pollfd = apr_pcalloc(connection->pool,
+                                               sizeof(*connection->pollfd));
+              connection->pollfd->p = connection->pool;
+              connection->pollfd->desc_type = APR_POLL_SOCKET;
+              connection->pollfd->reqevents = APR_POLLIN;
+              connection->pollfd->desc.s = connection->usock;
+              connection->pollfd->client_data = connection;
+            }
+
+          /* The reference of the initial accept() travels with the
+             connection from task to task until the session ends. */
+          status = apr_thread_pool_push(threads, serve_event_thread,
+                                        connection, 0, NULL);
+          if (status)
+            return svn_error_wrap_apr(status, _("Can't push task"));
+        }
+    }
+
+  /* NOTREACHED */
+}
+
 #endif
 
 /* Write the PID of the current process as a decimal number, followed by a
@@ -737,8 +933,11 @@ sub_main(int *exit_code, int argc, const char *argv[], apr_pool_t *pool)
   int mode_opt_count = 0;
   int handling_opt_count = 0;
   const char *config_filename = NULL;
+  svn_repos__authz_cache_config_t authz_cache_config = { NULL, 0 };
   const char *pid_filename = NULL;
   const char *log_filename = NULL;
+  const char *tls_cert_filename = NULL;
+  const char *tls_key_filename = NULL;
   svn_node_kind_t kind;
   apr_size_t min_thread_count = THREADPOOL_MIN_SIZE;
   apr_size_t max_thread_count = THREADPOOL_MAX_SIZE;
@@ -752,9 +951,6 @@ sub_main(int *exit_code, int argc, const char *argv[], apr_pool_t *pool)
   /* Initialize the FS library. */
   SVN_ERR(svn_fs_initialize(pool));
 
-  /* Initialize the efficient Authz support. */
-  SVN_ERR(svn_repos_authz_initialize(pool));
-
   SVN_ERR(svn_cmdline__getopt_init(&os, argc, argv, pool));
 
   params.root = "/";
@@ -768,6 +964,8 @@ sub_main(int *exit_code, int argc, const char *argv[], apr_pool_t *pool)
   params.config_pool = NULL;
   params.fs_config = NULL;
   params.vhost = FALSE;
+  params.delta_threads = 0;
+  params.tls = NULL;
   params.username_case = CASE_ASIS;
   params.memory_cache_size = (apr_uint64_t)-1;
   params.zero_copy_limit = 0;
@@ -962,6 +1160,24 @@ sub_main(int *exit_code, int argc, const char *argv[], apr_pool_t *pool)
           max_thread_count = (apr_size_t)apr_strtoi64(arg, NULL, 0);
           break;
 
+        case SVNSERVE_OPT_EVENT_LOOP:
+          handling_mode = connection_mode_event;
+          handling_opt_count++;
+          break;
+
+        case SVNSERVE_OPT_DELTA_THREADS:
+          err = svn_cstring_atoi(&params.delta_threads, arg);
+          if (!err && (params.delta_threads < 0
+                       || params.delta_threads > SVN_REPOS__MAX_DELTA_THREADS))
+            err = svn_error_createf(SVN_ERR_OUT_OF_RANGE, NULL,
+                                    _("Value must be between 0 and %d"),
+                                    SVN_REPOS__MAX_DELTA_THREADS);
+          if (err)
+            return svn_error_createf(SVN_ERR_CL_ARG_PARSING_ERROR, err,
+                                     _("Invalid number of update delta "
+                                       "threads '%s'"), arg);
+          break;
+
 #ifdef WIN32
         case SVNSERVE_OPT_SERVICE:
           if (run_mode != run_mode_service)
@@ -995,6 +1211,32 @@ sub_main(int *exit_code, int argc, const char *argv[], apr_pool_t *pool)
           SVN_ERR(svn_dirent_get_absolute(&log_filename, log_filename, pool));
           break;
 
+        case SVNSERVE_OPT_TLS_CERT_FILE:
+          SVN_ERR(svn_utf_cstring_to_utf8(&tls_cert_filename, arg, pool));
+          tls_cert_filename = svn_dirent_internal_style(tls_cert_filename,
+                                                        pool);
+          SVN_ERR(svn_dirent_get_absolute(&tls_cert_filename,
+                                          tls_cert_filename, pool));
+          break;
+
+        case SVNSERVE_OPT_TLS_KEY_FILE:
+          SVN_ERR(svn_utf_cstring_to_utf8(&tls_key_filename, arg, pool));
+          tls_key_filename = svn_dirent_internal_style(tls_key_filename,
+                                                       pool);
+          SVN_ERR(svn_dirent_get_absolute(&tls_key_filename,
+                                          tls_key_filename, pool));
+          break;
+
+        case SVNSERVE_OPT_AUTHZ_CACHE_DIR:
+          SVN_ERR(svn_utf_cstring_to_utf8(&authz_cache_config.cache_dir, arg,
+                                          pool));
+          authz_cache_config.cache_dir
+            = svn_dirent_internal_style(authz_cache_config.cache_dir, pool);
+          SVN_ERR(svn_dirent_get_absolute(&authz_cache_config.cache_dir,
+                                          authz_cache_config.cache_dir,
+                                          pool));
+          break;
+
         }
     }
 
@@ -1004,6 +1246,10 @@ sub_main(int *exit_code, int argc, const char *argv[], apr_pool_t *pool)
       return SVN_NO_ERROR;
     }
 
+  /* Initialize the efficient Authz support. */
+  svn_repos__authz_cache_config_set(&authz_cache_config);
+  SVN_ERR(svn_repos_authz_initialize(pool));
+
   if (os->ind != argc)
     {
       usage(argv[0], pool);
@@ -1029,7 +1275,8 @@ sub_main(int *exit_code, int argc, const char *argv[], apr_pool_t *pool)
   if (handling_opt_count > 1)
     {
       svn_error_clear(svn_cmdline_fputs(
-                      _("You may only specify one of -T or --single-thread\n"),
+                      _("You may only specify one of -T, --event-loop or "
+                        "--single-thread\n"),
                       stderr, pool));
       usage(argv[0], pool);
       *exit_code = EXIT_FAILURE;
@@ -1037,7 +1284,8 @@ sub_main(int *exit_code, int argc, const char *argv[], apr_pool_t *pool)
     }
 
   /* construct object pools */
-  is_multi_threaded = handling_mode == connection_mode_thread;
+  is_multi_threaded = handling_mode == connection_mode_thread
+                   || handling_mode == connection_mode_event;
   params.fs_config = apr_hash_make(pool);
   svn_hash_sets(params.fs_config, SVN_FS_CONFIG_FSFS_CACHE_DELTAS,
                 cache_txdeltas ? "1" :"0");
@@ -1079,6 +1327,24 @@ sub_main(int *exit_code, int argc, const char *argv[], apr_pool_t *pool)
                _("Option --tunnel-user is only valid in tunnel mode"));
     }
 
+  if (tls_cert_filename || tls_key_filename)
+    {
+      if (!tls_cert_filename || !tls_key_filename)
+        return svn_error_create(SVN_ERR_CL_ARG_PARSING_ERROR, NULL,
+                 _("Options --tls-cert-file and --tls-key-file must be "
+                   "used together"));
+
+      /* The tunnel agent already provides a secure channel. */
+      if (run_mode == run_mode_tunnel)
+        return svn_error_create(SVN_ERR_CL_ARG_PARSING_ERROR, NULL,
+                 _("Option --tls-cert-file is not valid in tunnel mode"));
+
+      /* Create the context before forking any connection handlers, so
+         that all of them will accept each other's session tickets. */
+      SVN_ERR(svn_ra_svn__tls_server_create(&params.tls, tls_cert_filename,
+                                            tls_key_filename, pool));
+    }
+
   if (run_mode == run_mode_inetd || run_mode == run_mode_tunnel)
     {
       apr_pool_t *connection_pool;
@@ -1280,7 +1546,7 @@ sub_main(int *exit_code, int argc, const char *argv[], apr_pool_t *pool)
       settings.cache_size = params.memory_cache_size;
 
     settings.single_threaded = TRUE;
-    if (handling_mode == connection_mode_thread)
+    if (is_multi_threaded)
       {
 #if APR_HAS_THREADS
         settings.single_threaded = FALSE;
@@ -1300,7 +1566,7 @@ sub_main(int *exit_code, int argc, const char *argv[], apr_pool_t *pool)
 #if APR_HAS_THREADS
   SVN_ERR(svn_root_pools__create(&connection_pools));
 
-  if (handling_mode == connection_mode_thread)
+  if (is_multi_threaded)
     {
       /* create the thread pool with a valid range of threads */
       if (max_thread_count < 1)
@@ -1328,6 +1594,10 @@ sub_main(int *exit_code, int argc, const char *argv[], apr_pool_t *pool)
     {
       threads = NULL;
     }
+
+  if (handling_mode == connection_mode_event
+      && run_mode != run_mode_listen_once)
+    return svn_error_trace(serve_event_loop(sock, &params, pool));
 #endif
 
   while (1)
@@ -1382,6 +1652,10 @@ sub_main(int *exit_code, int argc, const char *argv[], apr_pool_t *pool)
 #endif
           break;
 
+        case connection_mode_event:
+          /* Only reachable in listen-once mode, see above. */
+          break;
+
         case connection_mode_single:
           /* Serve one connection at a time. */
           /* serve_socket() logs any error it returns, so ignore it. */
@@ -0,0 +1,1048 @@
+/*
+ * prefetch.c :  Fetch the replay of upcoming revisions while the current
+ *               one is being committed.
+ *
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ */
+
+#include <apr_thread_proc.h>
+#include <apr_thread_cond.h>
+
+#include "svn_pools.h"
+#include "svn_delta.h"
+#include "svn_props.h"
+#include "svn_ra.h"
+#include "svn_sorts.h"
+
+#include "private/svn_mutex.h"
+#include "private/svn_ra_private.h"
+#include "private/svn_subr_private.h"
+
+#include "sync.h"
+
+#include "svn_private_config.h"
+
+/* The replay of a revision is recorded by a background thread into a
+   list of editor operations plus a spill buffer holding the svndiff
+   data of all its text deltas.  The calling thread then plays each
+   recording back into the editor returned by the caller's revstart
+   callback.  While it commits one revision, the background thread keeps
+   fetching the next ones, until a given number of them is waiting or
+   the waiting ones take up too much memory. */
+
+/* Keep at most this much svndiff data of a single revision in memory.
+   The rest goes to a temporary file. */
+#define MAX_DELTA_MEMORY (1024 * 1024)
+
+/* Don't queue further revisions while the queued ones hold more than
+   this in memory.  A single revision gets queued regardless of its
+   size. */
+#define MAX_PREFETCH_MEMORY (16 * 1024 * 1024)
+
+#if APR_HAS_THREADS
+
+/* The kinds of editor operations that we record. */
+typedef enum edit_op_kind_t
+{
+  op_set_target_revision,
+  op_open_root,
+  op_delete_entry,
+  op_add_directory,
+  op_open_directory,
+  op_change_dir_prop,
+  op_close_directory,
+  op_absent_directory,
+  op_add_file,
+  op_open_file,
+  op_apply_textdelta,
+  op_change_file_prop,
+  op_close_file,
+  op_absent_file
+} edit_op_kind_t;
+
+/* A recorded editor operation.  Directory and file batons are identified
+   by the number of the operation that opened them, counting only the
+   operations that open a node (the root being 0). */
+typedef struct edit_op_t
+{
+  edit_op_kind_t kind;
+
+  /* The baton the operation applies to; for operations that open or
+     remove a child, the parent's baton. */
+  int node;
+
+  /* Arguments, as far as the operation has them. */
+  const char *path;
+  const char *copyfrom_path;
+  svn_revnum_t revision;
+  const char *name;
+  const svn_string_t *value;
+  const char *checksum;
+
+  /* Number of bytes of svndiff data for op_apply_textdelta. */
+  svn_filesize_t delta_len;
+} edit_op_t;
+
+/* The recorded replay of a single revision. */
+typedef struct prefetched_rev_t
+{
+  svn_revnum_t revision;
+  apr_hash_t *rev_props;
+
+  /* All editor operations (edit_op_t) in drive order. */
+  apr_array_header_t *ops;
+
+  /* The svndiff data of all text deltas, in drive order. */
+  svn_spillbuf_reader_t *deltas;
+
+  /* Approximate number of bytes that the recording holds in memory,
+     not counting DELTAS, and the total length of DELTAS. */
+  apr_size_t memory;
+  svn_filesize_t delta_len;
+
+  /* Root pool owning this recording.  It may be destroyed from any
+     thread. */
+  apr_pool_t *pool;
+
+  struct prefetched_rev_t *next;
+} prefetched_rev_t;
+
+typedef struct prefetcher_t
+{
+  /* Session used exclusively by the background thread. */
+  svn_ra_session_t *session;
+
+  /* Parameters for svn_ra_replay_range(). */
+  svn_revnum_t start_revision;
+  svn_revnum_t end_revision;
+  svn_revnum_t low_water_mark;
+  svn_boolean_t send_deltas;
+
+  svn_cancel_func_t cancel_func;
+  void *cancel_baton;
+
+  /* Revision being recorded by the background thread, if any. */
+  prefetched_rev_t *current;
+
+  /* Protect and signal changes to all members below. */
+  svn_mutex__t *mutex;
+  apr_thread_cond_t *cond;
+
+  /* Recorded revisions not played back yet, oldest first. */
+  prefetched_rev_t *head;
+  prefetched_rev_t *tail;
+  int queued;
+  int max_ahead;
+
+  /* Sum of rev_memory() of the queued revisions. */
+  apr_size_t queued_memory;
+
+  /* Set by the background thread when it is done, together with the
+     error it encountered, if any. */
+  svn_boolean_t finished;
+  svn_error_t *err;
+
+  /* Set by the calling thread to make the background thread give up. */
+  svn_boolean_t stop;
+
+  /* Root pool owning this structure and SESSION. */
+  apr_pool_t *pool;
+} prefetcher_t;
+
+/* Edit baton of the recording editor. */
+typedef struct record_edit_baton_t
+{
+  prefetched_rev_t *rev;
+
+  /* Identifier for the next node to get opened. */
+  int next_node;
+} record_edit_baton_t;
+
+/* Directory and file baton of the recording editor. */
+typedef struct record_node_baton_t
+{
+  record_edit_baton_t *eb;
+  int node;
+} record_node_baton_t;
+
+/* Baton for the stream receiving the svndiff data of a text delta. */
+typedef struct record_delta_baton_t
+{
+  prefetched_rev_t *rev;
+
+  /* Index of the op_apply_textdelta operation in REV->OPS. */
+  int op_index;
+
+  apr_pool_t *scratch_pool;
+} record_delta_baton_t;
+
+
+/*** The recording editor ***/
+
+/* Return the approximate number of bytes that REV holds in memory. */
+static apr_size_t
+rev_memory(const prefetched_rev_t *rev)
+{
+  return rev->memory + (apr_size_t)MIN(rev->delta_len, MAX_DELTA_MEMORY);
+}
+
+/* Append a new operation of KIND applying to NODE to the recording in EB
+   and return it. */
+static edit_op_t *
+push_op(record_edit_baton_t *eb,
+        edit_op_kind_t kind,
+        int node)
+{
+  edit_op_t *op = apr_array_push(eb->rev->ops);
+
+  op->kind = kind;
+  op->node = node;
+  op->revision = SVN_INVALID_REVNUM;
+  eb->rev->memory += sizeof(*op);
+
+  return op;
+}
+
+/* Return a new node baton for EB, allocated in RESULT_POOL. */
+static record_node_baton_t *
+make_node_baton(record_edit_baton_t *eb,
+                apr_pool_t *result_pool)
+{
+  record_node_baton_t *nb = apr_pcalloc(result_pool, sizeof(*nb));
+
+  nb->eb = eb;
+  nb->node = eb->next_node++;
+
+  return nb;
+}
+
+/* Return a copy of STR allocated in EB's recording, or NULL. */
+static const char *
+dup_cstring(record_edit_baton_t *eb,
+            const char *str)
+{
+  if (!str)
+    return NULL;
+
+  eb->rev->memory += strlen(str) + 1;
+  return apr_pstrdup(eb->rev->pool, str);
+}
+
+static svn_error_t *
+record_set_target_revision(void *edit_baton,
+                           svn_revnum_t target_revision,
+                           apr_pool_t *scratch_pool)
+{
+  record_edit_baton_t *eb = edit_baton;
+  edit_op_t *op = push_op(eb, op_set_target_revision, 0);
+
+  op->revision = target_revision;
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+record_open_root(void *edit_baton,
+                 svn_revnum_t base_revision,
+                 apr_pool_t *result_pool,
+                 void **root_baton)
+{
+  record_edit_baton_t *eb = edit_baton;
+  record_node_baton_t *nb = make_node_baton(eb, result_pool);
+  edit_op_t *op = push_op(eb, op_open_root, nb->node);
+
+  op->revision = base_revision;
+  *root_baton = nb;
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+record_delete_entry(const char *path,
+                    svn_revnum_t revision,
+                    void *parent_baton,
+                    apr_pool_t *scratch_pool)
+{
+  record_node_baton_t *pb = parent_baton;
+  edit_op_t *op = push_op(pb->eb, op_delete_entry, pb->node);
+
+  op->path = dup_cstring(pb->eb, path);
+  op->revision = revision;
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+record_add_directory(const char *path,
+                     void *parent_baton,
+                     const char *copyfrom_path,
+                     svn_revnum_t copyfrom_revision,
+                     apr_pool_t *result_pool,
+                     void **child_baton)
+{
+  record_node_baton_t *pb = parent_baton;
+  edit_op_t *op = push_op(pb->eb, op_add_directory, pb->node);
+
+  op->path = dup_cstring(pb->eb, path);
+  op->copyfrom_path = dup_cstring(pb->eb, copyfrom_path);
+  op->revision = copyfrom_revision;
+  *child_baton = make_node_baton(pb->eb, result_pool);
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+record_open_directory(const char *path,
+                      void *parent_baton,
+                      svn_revnum_t base_revision,
+                      apr_pool_t *result_pool,
+                      void **child_baton)
+{
+  record_node_baton_t *pb = parent_baton;
+  edit_op_t *op = push_op(pb->eb, op_open_directory, pb->node);
+
+  op->path = dup_cstring(pb->eb, path);
+  op->revision = base_revision;
+  *child_baton = make_node_baton(pb->eb, result_pool);
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+record_change_prop(edit_op_kind_t kind,
+                   void *node_baton,
+                   const char *name,
+                   const svn_string_t *value)
+{
+  record_node_baton_t *nb = node_baton;
+  edit_op_t *op = push_op(nb->eb, kind, nb->node);
+
+  op->name = dup_cstring(nb->eb, name);
+  if (value)
+    {
+      op->value = svn_string_dup(value, nb->eb->rev->pool);
+      nb->eb->rev->memory += value->len + 1;
+    }
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+record_change_dir_prop(void *dir_baton,
+                       const char *name,
+                       const svn_string_t *value,
+                       apr_pool_t *scratch_pool)
+{
+  return record_change_prop(op_change_dir_prop, dir_baton, name, value);
+}
+
+static svn_error_t *
+record_close_directory(void *dir_baton,
+                       apr_pool_t *scratch_pool)
+{
+  record_node_baton_t *db = dir_baton;
+
+  push_op(db->eb, op_close_directory, db->node);
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+record_absent_directory(const char *path,
+                        void *parent_baton,
+                        apr_pool_t *scratch_pool)
+{
+  record_node_baton_t *pb = parent_baton;
+  edit_op_t *op = push_op(pb->eb, op_absent_directory, pb->node);
+
+  op->path = dup_cstring(pb->eb, path);
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+record_add_file(const char *path,
+                void *parent_baton,
+                const char *copyfrom_path,
+                svn_revnum_t copyfrom_revision,
+                apr_pool_t *result_pool,
+                void **file_baton)
+{
+  record_node_baton_t *pb = parent_baton;
+  edit_op_t *op = push_op(pb->eb, op_add_file, pb->node);
+
+  op->path = dup_cstring(pb->eb, path);
+  op->copyfrom_path = dup_cstring(pb->eb, copyfrom_path);
+  op->revision = copyfrom_revision;
+  *file_baton = make_node_baton(pb->eb, result_pool);
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+record_open_file(const char *path,
+                 void *parent_baton,
+                 svn_revnum_t base_revision,
+                 apr_pool_t *result_pool,
+                 void **file_baton)
+{
+  record_node_baton_t *pb = parent_baton;
+  edit_op_t *op = push_op(pb->eb, op_open_file, pb->node);
+
+  op->path = dup_cstring(pb->eb, path);
+  op->revision = base_revision;
+  *file_baton = make_node_baton(pb->eb, result_pool);
+  return SVN_NO_ERROR;
+}
+
+/* Implements svn_write_fn_t, appending svndiff data to the spill buffer
+   of the recording. */
+static svn_error_t *
+record_delta_write(void *baton,
+                   const char *data,
+                   apr_size_t *len)
+{
+  record_delta_baton_t *db = baton;
+
+  svn_pool_clear(db->scratch_pool);
+  SVN_ERR(svn_spillbuf__reader_write(db->rev->deltas, data, *len,
+                                     db->scratch_pool));
+  APR_ARRAY_IDX(db->rev->ops, db->op_index, edit_op_t).delta_len += *len;
+  db->rev->delta_len += *len;
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+record_apply_textdelta(void *file_baton,
+                       const char *base_checksum,
+                       apr_pool_t *result_pool,
+                       svn_txdelta_window_handler_t *handler,
+                       void **handler_baton)
+{
+  record_node_baton_t *fb = file_baton;
+  record_delta_baton_t *db = apr_pcalloc(result_pool, sizeof(*db));
+  edit_op_t *op = push_op(fb->eb, op_apply_textdelta, fb->node);
+  svn_stream_t *stream;
+
+  op->checksum = dup_cstring(fb->eb, base_checksum);
+
+  db->rev = fb->eb->rev;
+  db->op_index = db->rev->ops->nelts - 1;
+  db->scratch_pool = svn_pool_create(result_pool);
+
+  stream = svn_stream_create(db, result_pool);
+  svn_stream_set_write(stream, record_delta_write);
+
+  /* The data never leaves this process, so don't waste time on
+     compressing it. */
+  svn_txdelta_to_svndiff3(handler, handler_baton, stream, 0,
+                          SVN_DELTA_COMPRESSION_LEVEL_NONE, result_pool);
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+record_change_file_prop(void *file_baton,
+                        const char *name,
+                        const svn_string_t *value,
+                        apr_pool_t *scratch_pool)
+{
+  return record_change_prop(op_change_file_prop, file_baton, name, value);
+}
+
+static svn_error_t *
+record_close_file(void *file_baton,
+                  const char *text_checksum,
+                  apr_pool_t *scratch_pool)
+{
+  record_node_baton_t *fb = file_baton;
+  edit_op_t *op = push_op(fb->eb, op_close_file, fb->node);
+
+  op->checksum = dup_cstring(fb->eb, text_checksum);
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+record_absent_file(const char *path,
+                   void *parent_baton,
+                   apr_pool_t *scratch_pool)
+{
+  record_node_baton_t *pb = parent_baton;
+  edit_op_t *op = push_op(pb->eb, op_absent_file, pb->node);
+
+  op->path = dup_cstring(pb->eb, path);
+  return SVN_NO_ERROR;
+}
+
+/* Set *EDITOR and *EDIT_BATON to an editor recording the drive into REV.
+   Allocate the editor in RESULT_POOL. */
+static void
+get_record_editor(const svn_delta_editor_t **editor,
+                  void **edit_baton,
+                  prefetched_rev_t *rev,
+                  apr_pool_t *result_pool)
+{
+  svn_delta_editor_t *record_editor = svn_delta_default_editor(result_pool);
+  record_edit_baton_t *eb = apr_pcalloc(result_pool, sizeof(*eb));
+
+  eb->rev = rev;
+
+  record_editor->set_target_revision = record_set_target_revision;
+  record_editor->open_root = record_open_root;
+  record_editor->delete_entry = record_delete_entry;
+  record_editor->add_directory = record_add_directory;
+  record_editor->open_directory = record_open_directory;
+  record_editor->change_dir_prop = record_change_dir_prop;
+  record_editor->close_directory = record_close_directory;
+  record_editor->absent_directory = record_absent_directory;
+  record_editor->add_file = record_add_file;
+  record_editor->open_file = record_open_file;
+  record_editor->apply_textdelta = record_apply_textdelta;
+  record_editor->change_file_prop = record_change_file_prop;
+  record_editor->close_file = record_close_file;
+  record_editor->absent_file = record_absent_file;
+
+  *editor = record_editor;
+  *edit_baton = eb;
+}
+
+
+/*** Playing recordings back ***/
+
+/* Feed the svndiff data of OP from REV into EDITOR's apply_textdelta for
+   FILE_BATON.  Allocate the window handler in RESULT_POOL. */
+static svn_error_t *
+replay_textdelta(const svn_delta_editor_t *editor,
+                 void *file_baton,
+                 const edit_op_t *op,
+                 prefetched_rev_t *rev,
+                 apr_pool_t *result_pool,
+                 apr_pool_t *scratch_pool)
+{
+  svn_txdelta_window_handler_t handler;
+  void *handler_baton;
+  svn_stream_t *stream;
+  svn_filesize_t remaining = op->delta_len;
+  char *buffer = apr_palloc(scratch_pool, SVN__STREAM_CHUNK_SIZE);
+
+  SVN_ERR(editor->apply_textdelta(file_baton, op->checksum, result_pool,
+                                  &handler, &handler_baton));
+  stream = svn_txdelta_parse_svndiff(handler, handler_baton, TRUE,
+                                     result_pool);
+
+  while (remaining > 0)
+    {
+      apr_size_t len = (apr_size_t)MIN(remaining, SVN__STREAM_CHUNK_SIZE);
+
+      SVN_ERR(svn_spillbuf__reader_read(&len, rev->deltas, buffer, len,
+                                        scratch_pool));
+      if (len == 0)
+        return svn_error_createf(SVN_ERR_STREAM_UNEXPECTED_EOF, NULL,
+                                 _("Buffered delta data for r%ld ended "
+                                   "unexpectedly"), rev->revision);
+
+      SVN_ERR(svn_stream_write(stream, buffer, &len));
+      remaining -= len;
+    }
+
+  return svn_error_trace(svn_stream_close(stream));
+}
+
+/* Drive EDITOR / EDIT_BATON with the operations recorded in REV.  Use
+   RESULT_POOL for the batons, which need to live until the edit is
+   closed. */
+static svn_error_t *
+replay_ops(const svn_delta_editor_t *editor,
+           void *edit_baton,
+           prefetched_rev_t *rev,
+           apr_pool_t *result_pool,
+           apr_pool_t *scratch_pool)
+{
+  apr_array_header_t *batons = apr_array_make(result_pool, 16,
+                                              sizeof(void *));
+  apr_pool_t *iterpool = svn_pool_create(scratch_pool);
+  int i;
+
+  for (i = 0; i < rev->ops->nelts; i++)
+    {
+      const edit_op_t *op = &APR_ARRAY_IDX(rev->ops, i, edit_op_t);
+      void *node_baton = NULL;
+      void *child_baton;
+
+      svn_pool_clear(iterpool);
+
+      if (op->kind != op_set_target_revision && op->kind != op_open_root)
+        node_baton = APR_ARRAY_IDX(batons, op->node, void *);
+
+      switch (op->kind)
+        {
+          case op_set_target_revision:
+            SVN_ERR(editor->set_target_revision(edit_baton, op->revision,
+                                                iterpool));
+            break;
+
+          case op_open_root:
+            SVN_ERR(editor->open_root(edit_baton, op->revision, result_pool,
+                                      &child_baton));
+            APR_ARRAY_PUSH(batons, void *) = child_baton;
+            break;
+
+          case op_delete_entry:
+            SVN_ERR(editor->delete_entry(op->path, op->revision, node_baton,
+                                         iterpool));
+            break;
+
+          case op_add_directory:
+            SVN_ERR(editor->add_directory(op->path, node_baton,
+                                          op->copyfrom_path, op->revision,
+                                          result_pool, &child_baton));
+            APR_ARRAY_PUSH(batons, void *) = child_baton;
+            break;
+
+          case op_open_directory:
+            SVN_ERR(editor->open_directory(op->path, node_baton,
+                                           op->revision, result_pool,
+                                           &child_baton));
+            APR_ARRAY_PUSH(batons, void *) = child_baton;
+            break;
+
+          case op_change_dir_prop:
+            SVN_ERR(editor->change_dir_prop(node_baton, op->name, op->value,
+                                            iterpool));
+            break;
+
+          case op_close_directory:
+            SVN_ERR(editor->close_directory(node_baton, iterpool));
+            break;
+
+          case op_absent_directory:
+            SVN_ERR(editor->absent_directory(op->path, node_baton,
+                                             iterpool));
+            break;
+
+          case op_add_file:
+            SVN_ERR(editor->add_file(op->path, node_baton,
+                                     op->copyfrom_path, op->revision,
+                                     result_pool, &child_baton));
+            APR_ARRAY_PUSH(batons, void *) = child_baton;
+            break;
+
+          case op_open_file:
+            SVN_ERR(editor->open_file(op->path, node_baton, op->revision,
+                                      result_pool, &child_baton));
+            APR_ARRAY_PUSH(batons, void *) = child_baton;
+            break;
+
+          case op_apply_textdelta:
+            SVN_ERR(replay_textdelta(editor, node_baton, op, rev,
+                                     result_pool, iterpool));
+            break;
+
+          case op_change_file_prop:
+            SVN_ERR(editor->change_file_prop(node_baton, op->name,
+                                             op->value, iterpool));
+            break;
+
+          case op_close_file:
+            SVN_ERR(editor->close_file(node_baton, op->checksum, iterpool));
+            break;
+
+          case op_absent_file:
+            SVN_ERR(editor->absent_file(op->path, node_baton, iterpool));
+            break;
+
+          default:
+            SVN_ERR_MALFUNCTION();
+        }
+    }
+
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
+
+/* Play REV back through the REVSTART_FUNC / REVFINISH_FUNC callbacks
+   and the editor they provide, as svn_ra_replay_range() would. */
+static svn_error_t *
+replay_revision(prefetched_rev_t *rev,
+                svn_ra_replay_revstart_callback_t revstart_func,
+                svn_ra_replay_revfinish_callback_t revfinish_func,
+                void *replay_baton,
+                apr_pool_t *scratch_pool)
+{
+  const svn_delta_editor_t *editor;
+  void *edit_baton;
+
+  SVN_ERR(revstart_func(rev->revision, replay_baton, &editor, &edit_baton,
+                        rev->rev_props, scratch_pool));
+  SVN_ERR(replay_ops(editor, edit_baton, rev, scratch_pool, scratch_pool));
+  SVN_ERR(revfinish_func(rev->revision, replay_baton, editor, edit_baton,
+                         rev->rev_props, scratch_pool));
+
+  return SVN_NO_ERROR;
+}
+
+
+/*** The background thread ***/
+
+/* Implements svn_ra_replay_revstart_callback_t for the background
+   thread.  REPLAY_BATON is the prefetcher_t. */
+static svn_error_t *
+fetch_rev_started(svn_revnum_t revision,
+                  void *replay_baton,
+                  const svn_delta_editor_t **editor,
+                  void **edit_baton,
+                  apr_hash_t *rev_props,
+                  apr_pool_t *pool)
+{
+  prefetcher_t *prefetcher = replay_baton;
+  const svn_delta_editor_t *record_editor;
+  void *record_baton;
+  apr_pool_t *rev_pool;
+  prefetched_rev_t *rev;
+  apr_hash_index_t *hi;
+
+  /* The recording may be released by the other thread, so it needs a
+     pool of its own that is safe to use from any thread. */
+  rev_pool = svn_pool_create(NULL);
+  rev = apr_pcalloc(rev_pool, sizeof(*rev));
+  rev->revision = revision;
+  rev->rev_props = rev_props ? svn_prop_hash_dup(rev_props, rev_pool)
+                             : apr_hash_make(rev_pool);
+  rev->ops = apr_array_make(rev_pool, 64, sizeof(edit_op_t));
+  rev->deltas = svn_spillbuf__reader_create(SVN__STREAM_CHUNK_SIZE,
+                                            MAX_DELTA_MEMORY, rev_pool);
+  rev->pool = rev_pool;
+  prefetcher->current = rev;
+
+  for (hi = apr_hash_first(pool, rev->rev_props); hi; hi = apr_hash_next(hi))
+    {
+      const char *name = apr_hash_this_key(hi);
+      const svn_string_t *value = apr_hash_this_val(hi);
+
+      rev->memory += strlen(name) + value->len + 2;
+    }
+
+  get_record_editor(&record_editor, &record_baton, rev, pool);
+  SVN_ERR(svn_delta_get_cancellation_editor(prefetcher->cancel_func,
+                                            prefetcher->cancel_baton,
+                                            record_editor, record_baton,
+                                            editor, edit_baton, pool));
+
+  return SVN_NO_ERROR;
+}
+
+/* Implements svn_ra_replay_revfinish_callback_t for the background
+   thread.  Queue the revision just recorded, waiting for room in the
+   queue first.  There is room as long as the queue has fewer than
+   MAX_AHEAD entries and holds at most MAX_PREFETCH_MEMORY bytes
+   including this revision, or if it is empty.  REPLAY_BATON is the
+   prefetcher_t. */
+static svn_error_t *
+fetch_rev_finished(svn_revnum_t revision,
+                   void *replay_baton,
+                   const svn_delta_editor_t *editor,
+                   void *edit_baton,
+                   apr_hash_t *rev_props,
+                   apr_pool_t *pool)
+{
+  prefetcher_t *prefetcher = replay_baton;
+  prefetched_rev_t *rev = prefetcher->current;
+  apr_size_t memory;
+  svn_boolean_t stop;
+
+  SVN_ERR(editor->close_edit(edit_baton, pool));
+  memory = rev_memory(rev);
+
+  SVN_ERR(svn_mutex__lock(prefetcher->mutex));
+  while (!prefetcher->stop
+         && (prefetcher->queued >= prefetcher->max_ahead
+             || (prefetcher->queued > 0
+                 && prefetcher->queued_memory + memory
+                      > MAX_PREFETCH_MEMORY)))
+    {
+      apr_status_t status
+        = apr_thread_cond_wait(prefetcher->cond,
+                               svn_mutex__get(prefetcher->mutex));
+      if (status)
+        return svn_error_trace(
+                 svn_mutex__unlock(prefetcher->mutex,
+                                   svn_error_wrap_apr(status,
+                                        _("Can't wait for replay queue"))));
+    }
+
+  stop = prefetcher->stop;
+  if (!stop)
+    {
+      if (prefetcher->tail)
+        prefetcher->tail->next = rev;
+      else
+        prefetcher->head = rev;
+      prefetcher->tail = rev;
+      prefetcher->queued++;
+      prefetcher->queued_memory += memory;
+      prefetcher->current = NULL;
+
+      apr_thread_cond_broadcast(prefetcher->cond);
+    }
+
+  SVN_ERR(svn_mutex__unlock(prefetcher->mutex, SVN_NO_ERROR));
+
+  /* The calling thread gave up; no need to fetch any further. */
+  if (stop)
+    return svn_error_create(SVN_ERR_CANCELLED, NULL, NULL);
+
+  return SVN_NO_ERROR;
+}
+
+/* Thread function running the replay for the prefetcher_t given as
+   DATA. */
+static void * APR_THREAD_FUNC
+prefetch_thread(apr_thread_t *tid,
+                void *data)
+{
+  prefetcher_t *prefetcher = data;
+  apr_pool_t *scratch_pool = svn_pool_create(prefetcher->pool);
+  svn_error_t *err;
+  svn_error_t *lock_err;
+
+  err = svn_ra_replay_range(prefetcher->session,
+                            prefetcher->start_revision,
+                            prefetcher->end_revision,
+                            prefetcher->low_water_mark,
+                            prefetcher->send_deltas,
+                            fetch_rev_started, fetch_rev_finished,
+                            prefetcher, scratch_pool);
+
+  /* Drop the recording of a revision we did not finish. */
+  if (prefetcher->current)
+    {
+      svn_pool_destroy(prefetcher->current->pool);
+      prefetcher->current = NULL;
+    }
+  svn_pool_destroy(scratch_pool);
+
+  /* Tell the calling thread that we are done.  There is no way to report
+     errors in the synchronization itself, but those would make the
+     calling thread fail when waiting for us anyway. */
+  lock_err = svn_mutex__lock(prefetcher->mutex);
+  if (!lock_err)
+    {
+      prefetcher->err = err;
+      prefetcher->finished = TRUE;
+      apr_thread_cond_broadcast(prefetcher->cond);
+      lock_err = svn_mutex__unlock(prefetcher->mutex, SVN_NO_ERROR);
+    }
+  else
+    svn_error_clear(err);
+  svn_error_clear(lock_err);
+
+  return NULL;
+}
+
+/* Set *REV_P to the next revision recorded by PREFETCHER, waiting for it
+   if necessary.  The caller takes over the recording. */
+static svn_error_t *
+next_revision(prefetched_rev_t **rev_p,
+              prefetcher_t *prefetcher)
+{
+  svn_error_t *err;
+
+  SVN_ERR(svn_mutex__lock(prefetcher->mutex));
+  while (!prefetcher->head && !prefetcher->finished)
+    {
+      apr_status_t status
+        = apr_thread_cond_wait(prefetcher->cond,
+                               svn_mutex__get(prefetcher->mutex));
+      if (status)
+        return svn_error_trace(
+                 svn_mutex__unlock(prefetcher->mutex,
+                                   svn_error_wrap_apr(status,
+                                        _("Can't wait for replay queue"))));
+    }
+
+  *rev_p = prefetcher->head;
+  if (*rev_p)
+    {
+      prefetcher->head = (*rev_p)->next;
+      if (!prefetcher->head)
+        prefetcher->tail = NULL;
+      prefetcher->queued--;
+      prefetcher->queued_memory -= rev_memory(*rev_p);
+
+      apr_thread_cond_broadcast(prefetcher->cond);
+      err = SVN_NO_ERROR;
+    }
+  else
+    {
+      /* The background thread is done but did not deliver this
+         revision; it will have told us why. */
+      err = prefetcher->err;
+      prefetcher->err = NULL;
+      if (!err)
+        err = svn_error_create(APR_EINVAL, NULL,
+                               _("Replay ended before all revisions "
+                                 "were received"));
+    }
+
+  return svn_error_trace(svn_mutex__unlock(prefetcher->mutex, err));
+}
+
+/* Implement svnsync_replay_range_prefetch() with a background thread. */
+static svn_error_t *
+replay_range_threaded(svn_ra_session_t *session,
+                      svn_revnum_t start_revision,
+                      svn_revnum_t end_revision,
+                      svn_revnum_t low_water_mark,
+                      svn_boolean_t send_deltas,
+                      int max_ahead,
+                      svn_ra_replay_revstart_callback_t revstart_func,
+                      svn_ra_replay_revfinish_callback_t revfinish_func,
+                      void *replay_baton,
+                      svn_cancel_func_t cancel_func,
+                      void *cancel_baton,
+                      apr_pool_t *pool)
+{
+  apr_pool_t *prefetch_pool = svn_pool_create(NULL);
+  apr_pool_t *iterpool;
+  prefetcher_t *prefetcher;
+  apr_thread_t *thread;
+  apr_status_t status, thread_status;
+  svn_revnum_t revision;
+  svn_error_t *err;
+  svn_error_t *lock_err;
+
+  prefetcher = apr_pcalloc(prefetch_pool, sizeof(*prefetcher));
+  prefetcher->start_revision = start_revision;
+  prefetcher->end_revision = end_revision;
+  prefetcher->low_water_mark = low_water_mark;
+  prefetcher->send_deltas = send_deltas;
+  prefetcher->cancel_func = cancel_func;
+  prefetcher->cancel_baton = cancel_baton;
+  prefetcher->max_ahead = max_ahead;
+  prefetcher->pool = prefetch_pool;
+
+  /* RA sessions must not be used by more than one thread at a time, and
+     SESSION's pool is not safe to use from another thread.  Give the
+     background thread a session of its own. */
+  err = svn_ra__dup_session(&prefetcher->session, session, NULL,
+                            prefetch_pool, pool);
+  if (!err)
+    err = svn_mutex__init(&prefetcher->mutex, TRUE, prefetch_pool);
+  if (!err)
+    {
+      status = apr_thread_cond_create(&prefetcher->cond, prefetch_pool);
+      if (status)
+        err = svn_error_wrap_apr(status, _("Can't create condition variable"));
+    }
+  if (!err)
+    {
+      status = apr_thread_create(&thread, NULL, prefetch_thread, prefetcher,
+                                 prefetch_pool);
+      if (status)
+        err = svn_error_wrap_apr(status, _("Can't create thread"));
+    }
+  if (err)
+    {
+      svn_pool_destroy(prefetch_pool);
+      return svn_error_trace(err);
+    }
+
+  /* Commit the revisions in order as they come in. */
+  iterpool = svn_pool_create(pool);
+  for (revision = start_revision; !err && revision <= end_revision;
+       revision++)
+    {
+      prefetched_rev_t *rev;
+
+      svn_pool_clear(iterpool);
+
+      err = next_revision(&rev, prefetcher);
+      if (!err)
+        {
+          err = replay_revision(rev, revstart_func, revfinish_func,
+                                replay_baton, iterpool);
+          svn_pool_destroy(rev->pool);
+        }
+    }
+  svn_pool_destroy(iterpool);
+
+  /* Make the background thread give up if we stopped early, and wait
+     for it in any case. */
+  lock_err = svn_mutex__lock(prefetcher->mutex);
+  if (!lock_err)
+    {
+      prefetcher->stop = TRUE;
+      apr_thread_cond_broadcast(prefetcher->cond);
+      lock_err = svn_mutex__unlock(prefetcher->mutex, SVN_NO_ERROR);
+    }
+  err = svn_error_compose_create(err, lock_err);
+
+  status = apr_thread_join(&thread_status, thread);
+  if (status && !err)
+    err = svn_error_wrap_apr(status, _("Can't join thread"));
+
+  /* An error of the background thread only matters if we did not fail
+     ourselves; it is most likely a consequence of our failure. */
+  if (err)
+    svn_error_clear(prefetcher->err);
+  else
+    err = prefetcher->err;
+
+  while (prefetcher->head)
+    {
+      prefetched_rev_t *rev = prefetcher->head;
+
+      prefetcher->head = rev->next;
+      svn_pool_destroy(rev->pool);
+    }
+  svn_pool_destroy(prefetch_pool);
+
+  return svn_error_trace(err);
+}
+
+#endif /* APR_HAS_THREADS */
+
+
+svn_error_t *
+svnsync_replay_range_prefetch(svn_ra_session_t *session,
+                              svn_revnum_t start_revision,
+                              svn_revnum_t end_revision,
+                              svn_revnum_t low_water_mark,
+                              svn_boolean_t send_deltas,
+                              int max_ahead,
+                              svn_ra_replay_revstart_callback_t revstart_func,
+                              svn_ra_replay_revfinish_callback_t revfinish_func,
+                              void *replay_baton,
+                              svn_cancel_func_t cancel_func,
+                              void *cancel_baton,
+                              apr_pool_t *pool)
+{
+#if APR_HAS_THREADS
+  if (max_ahead > 0)
+    return svn_error_trace(replay_range_threaded(session, start_revision,
+                                                 end_revision,
+                                                 low_water_mark,
+                                                 send_deltas, max_ahead,
+                                                 revstart_func,
+                                                 revfinish_func,
+                                                 replay_baton,
+                                                 cancel_func, cancel_baton,
+                                                 pool));
+#endif
+
+  return svn_error_trace(svn_ra_replay_range(session, start_revision,
+                                             end_revision, low_water_mark,
+                                             send_deltas, revstart_func,
+                                             revfinish_func, replay_baton,
+                                             pool));
+}
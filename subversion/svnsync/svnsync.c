@@ -71,9 +71,14 @@ enum svnsync__opt {
   svnsync_opt_trust_server_cert_failures_dst,
   svnsync_opt_allow_non_empty,
   svnsync_opt_skip_unchanged,
-  svnsync_opt_steal_lock
+  svnsync_opt_steal_lock,
+  svnsync_opt_prefetch
 };
 
+/* Number of revisions 'svnsync synchronize' fetches ahead of the one
+   being committed, unless told otherwise with --prefetch. */
+#define DEFAULT_PREFETCH 4
+
 #define SVNSYNC_OPTS_DEFAULT svnsync_opt_non_interactive, \
                              svnsync_opt_force_interactive, \
                              svnsync_opt_no_auth_cache, \
@@ -131,7 +136,8 @@ static const svn_opt_subcommand_desc3_t svnsync_cmd_table[] =
          "DEST_URL repository.\n"
       )},
       { SVNSYNC_OPTS_DEFAULT, svnsync_opt_source_prop_encoding, 'q',
-        svnsync_opt_disable_locking, svnsync_opt_steal_lock, 'M' } },
+        svnsync_opt_disable_locking, svnsync_opt_steal_lock,
+        svnsync_opt_prefetch, 'M' } },
     { "copy-revprops", copy_revprops_cmd, { 0 }, {N_(
          "usage:\n"
          "\n"), N_(
@@ -279,6 +285,12 @@ static const apr_getopt_option_t svnsync_options[] =
                           "and is not being concurrently accessed by another\n"
                           "                             "
                           "svnsync instance.")},
+    {"prefetch",       svnsync_opt_prefetch, 1,
+                       N_("fetch up to ARG revisions from the source while\n"
+                          "                             "
+                          "committing an earlier one (default 4;\n"
+                          "                             "
+                          "0 fetches each revision only when needed)")},
     {"memory-cache-size", 'M', 1,
                        N_("size of the extra in-memory cache in MB used to\n"
                           "                             "
@@ -316,6 +328,7 @@ typedef struct opt_baton_t {
   svn_boolean_t quiet;
   svn_boolean_t allow_non_empty;
   svn_boolean_t skip_unchanged;
+  int prefetch;
   svn_boolean_t version;
   svn_boolean_t help;
   svn_opt_revision_t start_rev;
@@ -425,6 +438,7 @@ typedef struct subcommand_baton_t {
 
   /* synchronize only */
   svn_revnum_t committed_rev;
+  int prefetch;
 
   /* copy-revprops only */
   svn_revnum_t start_rev;
@@ -683,6 +697,9 @@ log_properties_normalized(int normalized_rev_props_count,
  * with RA session FROM_SESSION, to the repository associated with RA
  * session TO_SESSION.
  *
+ * If SOURCE_PROPS is not NULL, it holds the revision properties of REV
+ * in the source repository, which are then not fetched again.
+ *
  * If SYNC is TRUE, then properties on the destination revision that
  * do not exist on the source revision will be removed.
  *
@@ -701,6 +718,7 @@ static svn_error_t *
 copy_revprops(svn_ra_session_t *from_session,
               svn_ra_session_t *to_session,
               svn_revnum_t rev,
+              apr_hash_t *source_props,
               svn_boolean_t sync,
               svn_boolean_t skip_unchanged,
               svn_boolean_t quiet,
@@ -720,7 +738,10 @@ copy_revprops(svn_ra_session_t *from_session,
     existing_props = NULL;
 
   /* Get the list of revision properties on REV of SOURCE. */
-  SVN_ERR(svn_ra_rev_proplist(from_session, rev, &rev_props, subpool));
+  if (source_props)
+    rev_props = svn_prop_hash_dup(source_props, subpool);
+  else
+    SVN_ERR(svn_ra_rev_proplist(from_session, rev, &rev_props, subpool));
 
   /* If necessary, normalize encoding and line ending style and return the count
      of EOL-normalized properties in int *NORMALIZED_COUNT. */
@@ -766,6 +787,7 @@ make_subcommand_baton(opt_baton_t *opt_baton,
   b->sync_callbacks.auth_baton = opt_baton->sync_auth_baton;
   b->quiet = opt_baton->quiet;
   b->skip_unchanged = opt_baton->skip_unchanged;
+  b->prefetch = opt_baton->prefetch;
   b->allow_non_empty = opt_baton->allow_non_empty;
   b->to_url = to_url;
   b->source_prop_encoding = opt_baton->source_prop_encoding;
@@ -875,7 +897,7 @@ do_initialize(svn_ra_session_t *to_session,
      LATEST is not 0, this really serves merely aesthetic and
      informational purposes, keeping the output of this command
      consistent while allowing folks to see what the latest revision is.  */
-  SVN_ERR(copy_revprops(from_session, to_session, latest, FALSE, FALSE,
+  SVN_ERR(copy_revprops(from_session, to_session, latest, NULL, FALSE, FALSE,
                         baton->quiet, baton->source_prop_encoding,
                         &normalized_rev_props_count, pool));
 
@@ -1493,7 +1515,8 @@ do_synchronize(svn_ra_session_t *to_session,
         {
           if (copying > last_merged)
             {
-              SVN_ERR(copy_revprops(from_session, to_session, to_latest, TRUE,
+              SVN_ERR(copy_revprops(from_session, to_session, to_latest,
+                                    NULL, TRUE,
                                     baton->skip_unchanged, baton->quiet,
                                     baton->source_prop_encoding,
                                     &normalized_rev_props_count, pool));
@@ -1556,9 +1579,11 @@ do_synchronize(svn_ra_session_t *to_session,
 
   SVN_ERR(check_cancel(NULL));
 
-  SVN_ERR(svn_ra_replay_range(from_session, start_revision, end_revision,
-                              0, TRUE, replay_rev_started,
-                              replay_rev_finished, rb, pool));
+  SVN_ERR(svnsync_replay_range_prefetch(from_session, start_revision,
+                                        end_revision, 0, TRUE,
+                                        baton->prefetch, replay_rev_started,
+                                        replay_rev_finished, rb,
+                                        check_cancel, NULL, pool));
 
   SVN_ERR(log_properties_normalized(rb->normalized_rev_props_count
                                       + normalized_rev_props_count,
@@ -1621,6 +1646,92 @@ synchronize_cmd(apr_getopt_t *os, void *b, apr_pool_t *pool)
 
 /*** `svnsync copy-revprops' ***/
 
+/* Number of revisions whose revision properties do_copy_revprops()
+   requests from the source at once. */
+#define REVPROPS_BATCH_SIZE 1000
+
+/* Baton for fetch_revprops_receiver(). */
+typedef struct fetch_revprops_baton_t {
+  /* Maps svn_revnum_t * to the revision properties (apr_hash_t *). */
+  apr_hash_t *revprops;
+  apr_pool_t *pool;
+} fetch_revprops_baton_t;
+
+/* Implements `svn_log_entry_receiver_t' interface. */
+static svn_error_t *
+fetch_revprops_receiver(void *baton,
+                        svn_log_entry_t *log_entry,
+                        apr_pool_t *pool)
+{
+  fetch_revprops_baton_t *b = baton;
+  svn_revnum_t *rev;
+
+  if (! SVN_IS_VALID_REVNUM(log_entry->revision))
+    return SVN_NO_ERROR;
+
+  rev = apr_palloc(b->pool, sizeof(*rev));
+  *rev = log_entry->revision;
+  apr_hash_set(b->revprops, rev, sizeof(*rev),
+               log_entry->revprops
+                 ? svn_prop_hash_dup(log_entry->revprops, b->pool)
+                 : apr_hash_make(b->pool));
+
+  return SVN_NO_ERROR;
+}
+
+/* Set *REVPROPS to a hash mapping svn_revnum_t * to the revision
+ * properties (apr_hash_t *) of revisions START through END in the
+ * source repository, fetched with a single log request over the RA
+ * session *LOG_SESSION, which must not be used for anything else.
+ *
+ * The log only reports revisions that changed something below the
+ * session URL, so other revisions will be missing.  If the request
+ * fails for any reason other than cancellation, e.g. because the
+ * session URL no longer exists in END, set *REVPROPS to an empty hash.
+ * The failed request may have left the rest of its response unread, so
+ * also set *LOG_SESSION to NULL; if it is NULL already, just return an
+ * empty hash.  The caller has to fetch the properties one by one then.
+ */
+static svn_error_t *
+fetch_revprops_batch(apr_hash_t **revprops,
+                     svn_ra_session_t **log_session,
+                     svn_revnum_t start,
+                     svn_revnum_t end,
+                     apr_pool_t *result_pool,
+                     apr_pool_t *scratch_pool)
+{
+  apr_array_header_t *paths;
+  fetch_revprops_baton_t b;
+  svn_error_t *err;
+
+  b.revprops = apr_hash_make(result_pool);
+  b.pool = result_pool;
+
+  if (! *log_session)
+    {
+      *revprops = b.revprops;
+      return SVN_NO_ERROR;
+    }
+
+  paths = apr_array_make(scratch_pool, 1, sizeof(const char *));
+  APR_ARRAY_PUSH(paths, const char *) = "";
+
+  err = svn_ra_get_log2(*log_session, paths, start, end, 0,
+                        FALSE, FALSE, FALSE, NULL,
+                        fetch_revprops_receiver, &b, scratch_pool);
+  if (err && err->apr_err != SVN_ERR_CANCELLED)
+    {
+      svn_error_clear(err);
+      *log_session = NULL;
+      b.revprops = apr_hash_make(result_pool);
+    }
+  else
+    SVN_ERR(err);
+
+  *revprops = b.revprops;
+  return SVN_NO_ERROR;
+}
+
 /* Copy revision properties to the repository associated with RA
  * session TO_SESSION, using information found in BATON.
  *
@@ -1632,10 +1743,15 @@ do_copy_revprops(svn_ra_session_t *to_session,
                  subcommand_baton_t *baton, apr_pool_t *pool)
 {
   svn_ra_session_t *from_session;
+  svn_ra_session_t *log_session = NULL;
+  svn_boolean_t has_log_revprops;
   svn_string_t *last_merged_rev;
   svn_revnum_t i;
   svn_revnum_t step = 1;
   int normalized_rev_props_count = 0;
+  apr_pool_t *batch_pool = svn_pool_create(pool);
+  apr_hash_t *batch = NULL;
+  svn_revnum_t batch_end = SVN_INVALID_REVNUM;
 
   SVN_ERR(open_source_session(&from_session, &last_merged_rev,
                               baton->from_url, to_session,
@@ -1660,19 +1776,46 @@ do_copy_revprops(svn_ra_session_t *to_session,
        _("Cannot copy revprops for a revision (%ld) that has not "
          "been synchronized yet"), baton->end_rev);
 
+  /* Fetch the source properties in batches instead of making a round
+     trip for every single revision, if the server can send all of them
+     with the log.  The log requests get a session of their own, so that
+     a failed one can't disturb FROM_SESSION, which we still need to
+     fetch the properties one by one then. */
+  SVN_ERR(svn_ra_has_capability(from_session, &has_log_revprops,
+                                SVN_RA_CAPABILITY_LOG_REVPROPS, pool));
+  if (has_log_revprops)
+    SVN_ERR(svn_ra__dup_session(&log_session, from_session, NULL,
+                                pool, pool));
+
   /* Now, copy all the requested revisions, in the requested order. */
   step = (baton->start_rev > baton->end_rev) ? -1 : 1;
   for (i = baton->start_rev; i != baton->end_rev + step; i = i + step)
     {
       int normalized_count;
+
       SVN_ERR(check_cancel(NULL));
-      SVN_ERR(copy_revprops(from_session, to_session, i, TRUE,
+
+      if (! batch || i == batch_end + step)
+        {
+          batch_end = i + step * (REVPROPS_BATCH_SIZE - 1);
+          if (step * (batch_end - baton->end_rev) > 0)
+            batch_end = baton->end_rev;
+
+          svn_pool_clear(batch_pool);
+          SVN_ERR(fetch_revprops_batch(&batch, &log_session, i, batch_end,
+                                       batch_pool, batch_pool));
+        }
+
+      SVN_ERR(copy_revprops(from_session, to_session, i,
+                            apr_hash_get(batch, &i, sizeof(i)), TRUE,
                             baton->skip_unchanged, baton->quiet,
                             baton->source_prop_encoding, &normalized_count,
                             pool));
       normalized_rev_props_count += normalized_count;
     }
 
+  svn_pool_destroy(batch_pool);
+
   /* Notify about normalized props, if any. */
   SVN_ERR(log_properties_normalized(normalized_rev_props_count, 0, pool));
 
@@ -1987,6 +2130,7 @@ sub_main(int *exit_code, int argc, const char *argv[], apr_pool_t *pool)
   /* Initialize the option baton. */
   memset(&opt_baton, 0, sizeof(opt_baton));
   opt_baton.start_rev.kind = svn_opt_revision_unspecified;
+  opt_baton.prefetch = DEFAULT_PREFETCH;
   opt_baton.end_rev.kind = svn_opt_revision_unspecified;
 
   received_opts = apr_array_make(pool, SVN_OPT_MAX_OPTIONS, sizeof(int));
@@ -2130,6 +2274,16 @@ sub_main(int *exit_code, int argc, const char *argv[], apr_pool_t *pool)
             opt_baton.skip_unchanged = TRUE;
             break;
 
+          case svnsync_opt_prefetch:
+            {
+              apr_int64_t prefetch;
+
+              opt_err = svn_cstring_strtoi64(&prefetch, opt_arg, 0, 1024, 10);
+              if (!opt_err)
+                opt_baton.prefetch = (int)prefetch;
+            }
+            break;
+
           case 'q':
             opt_baton.quiet = TRUE;
             break;
@@ -31,6 +31,7 @@ extern "C" {
 
 #include "svn_types.h"
 #include "svn_delta.h"
+#include "svn_ra.h"
 
 
 /* Normalize the encoding and line ending style of the values of properties
@@ -78,6 +79,36 @@ svnsync_get_sync_editor(const svn_delta_editor_t *wrapped_editor,
                         apr_pool_t *pool);
 
 
+/* Like svn_ra_replay_range(), but fetch the replays of up to MAX_AHEAD
+ * revisions on a background thread while REVSTART_FUNC, the editor it
+ * returns and REVFINISH_FUNC are still busy with an earlier revision.
+ * The callbacks are invoked from the calling thread only, in the usual
+ * order.  The replays are buffered in memory, with text deltas going to
+ * temporary files once they get large.
+ *
+ * The background thread uses a duplicate of SESSION.  SESSION itself
+ * stays available to the callbacks.  CANCEL_FUNC / CANCEL_BATON are
+ * checked by the background thread while fetching and must be safe to
+ * call from any thread.
+ *
+ * If MAX_AHEAD is 0 or threads are not supported, this is the same as
+ * svn_ra_replay_range().
+ */
+svn_error_t *
+svnsync_replay_range_prefetch(svn_ra_session_t *session,
+                              svn_revnum_t start_revision,
+                              svn_revnum_t end_revision,
+                              svn_revnum_t low_water_mark,
+                              svn_boolean_t send_deltas,
+                              int max_ahead,
+                              svn_ra_replay_revstart_callback_t revstart_func,
+                              svn_ra_replay_revfinish_callback_t revfinish_func,
+                              void *replay_baton,
+                              svn_cancel_func_t cancel_func,
+                              void *cancel_baton,
+                              apr_pool_t *pool);
+
+
 #ifdef __cplusplus
 }
 #endif /* __cplusplus */
@@ -3242,6 +3242,52 @@ def filtered_ls_top_level_path(sbox):
     exit_code, output, error = svntest.actions.run_and_verify_svn(
       [], [], 'ls', f_path, '--search=*/*', *extra_opts)
 
+@SkipUnless(svntest.main.is_ra_type_svns)
+def svns_server_cert_verification(sbox):
+  "svns:// server certificate verification"
+
+  sbox.build(create_wc=False)
+
+  # A config dir without the trust entry written for the test suite
+  config_dir_path = sbox.get_tempname(prefix="config-dir")
+  os.mkdir(config_dir_path)
+  open(os.path.join(config_dir_path, "config"), "w").close()
+  open(os.path.join(config_dir_path, "servers"), "w").close()
+
+  # The self-signed test certificate must be rejected...
+  svntest.actions.run_and_verify_svn(
+    None, '.*Server TLS certificate verification failed.*',
+    'info', sbox.repo_url, '--config-dir', config_dir_path,
+    '--non-interactive')
+
+  # ...unless the client was told to trust it.
+  svntest.actions.run_and_verify_svn(
+    None, [],
+    'info', sbox.repo_url, '--config-dir', config_dir_path,
+    '--non-interactive', '--trust-server-cert-failures', 'unknown-ca')
+
+@SkipUnless(svntest.main.is_ra_type_dav_serf)
+def http_protocol_option(sbox):
+  "http-protocol servers option"
+
+  sbox.build(create_wc=False)
+
+  # Unknown protocol versions are rejected.
+  svntest.actions.run_and_verify_svn(
+    None, ".*Invalid config: unknown http-protocol 'h3'.*",
+    'info', sbox.repo_url,
+    '--config-option', 'servers:global:http-protocol=h3')
+
+  # HTTP/1.1 still works with a server that "make davautocheck USE_HTTP2=1"
+  # set up for the other tests to run over HTTP/2.
+  expected_output = svntest.main.greek_state.copy()
+  expected_output.wc_dir = sbox.wc_dir
+  expected_output.tweak(contents=None, status='A ')
+  expected_disk = svntest.main.greek_state.copy()
+  svntest.actions.run_and_verify_checkout(
+    sbox.repo_url, sbox.wc_dir, expected_output, expected_disk, [],
+    '--config-option', 'servers:global:http-protocol=http/1.1')
+
 
 ########################################################################
 # Run the tests
@@ -3318,6 +3364,8 @@ test_list = [ None,
               null_update_last_changed_revision,
               null_prop_update_last_changed_revision,
               filtered_ls_top_level_path,
+              svns_server_cert_verification,
+              http_protocol_option,
              ]
 
 if __name__ == '__main__':
@@ -1059,6 +1059,62 @@ def blame_reverse_no_change(sbox):
   svntest.actions.run_and_verify_svn(expected_output, [],
                                      'blame', '-r5:3', sbox.ospath('iota'))
 
+def blame_cache_and_threads(sbox):
+  "blame with cached results and diff threads"
+
+  sbox.build()
+
+  iota = sbox.ospath('iota')
+  cache_opts = ['--config-option', 'config:miscellany:blame-cache=yes',
+                '--config-option', 'config:miscellany:blame-diff-threads=4']
+
+  for i in range(2, 6):
+    sbox.simple_append('iota', 'line %d\n' % i)
+    sbox.simple_commit() #r2 .. r5
+
+  expected_output = [
+    '     1    jrandom This is the file \'iota\'.\n',
+    '     2    jrandom line 2\n',
+    '     3    jrandom line 3\n',
+    '     4    jrandom line 4\n',
+    '     5    jrandom line 5\n',
+  ]
+  svntest.actions.run_and_verify_svn(expected_output, [],
+                                     'blame', '-r1:5', iota, *cache_opts)
+
+  # Change history after the cached revision.  Only r6 needs to be
+  # processed, but the result must be the same as without cache.
+  sbox.simple_append('iota', 'This is the file \'iota\'.\n'
+                             'line 2\n'
+                             'line 6\n'
+                             'line 5\n', truncate=True)
+  sbox.simple_commit() #r6
+
+  expected_output = [
+    '     1    jrandom This is the file \'iota\'.\n',
+    '     2    jrandom line 2\n',
+    '     6    jrandom line 6\n',
+    '     5    jrandom line 5\n',
+  ]
+  svntest.actions.run_and_verify_svn(expected_output, [],
+                                     'blame', iota, *cache_opts)
+  svntest.actions.run_and_verify_svn(expected_output, [],
+                                     'blame', iota)
+
+  # Replace the file.  The cached blame must not be used for it.
+  sbox.simple_rm('iota')
+  sbox.simple_commit() #r7
+  svntest.main.file_write(iota, 'new iota\n')
+  sbox.simple_add('iota')
+  sbox.simple_commit() #r8
+
+  expected_output = [
+    '     8    jrandom new iota\n',
+  ]
+  svntest.actions.run_and_verify_svn(expected_output, [],
+                                     'blame', iota, *cache_opts)
+
+
 
 ########################################################################
 # Run the tests
@@ -1085,6 +1141,7 @@ test_list = [ None,
               blame_eol_handling,
               blame_youngest_to_oldest,
               blame_reverse_no_change,
+              blame_cache_and_threads,
              ]
 
 if __name__ == '__main__':
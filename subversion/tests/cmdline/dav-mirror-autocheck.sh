@@ -125,7 +125,7 @@ Group               $(id -gn)
 __EOF__
 else
 HTTPD_LOCK="$HTTPD_ROOT/lock"
-mkdir "$HTTPD_LOCK" \
+[ -d "$HTTPD_LOCK" ] || mkdir "$HTTPD_LOCK" \
   || fail "couldn't create lock directory '$HTTPD_LOCK'"
   cat >> "$1" <<__EOF__
 # worker and prefork MUST have a mpm-accept lockfile in 2.3.0+
@@ -182,6 +182,8 @@ CustomLog           "${HTTPD_ROOT}/ops" "%t %u %{SVN-REPOS-NAME}e %{SVN-ACTION}e
     DAV               svn
     SVNPath           "${SLAVE_REPOS}"
     SVNMasterURI      "${MASTER_URL}"
+    SVNMasterReplay   ${MASTER_REPLAY}
+    SVNMasterReplayUser svnsync svnsync
     AuthType          Basic
     AuthName          "Subversion Repository"
     AuthUserFile      ${HTTPD_ROOT}/users
@@ -375,6 +377,9 @@ MASTER_LOCATION="repo"
 SLAVE_LOCATION="repo"
 SYNC_LOCATION="sync"
 
+# whether the slave replays commits from the master itself
+MASTER_REPLAY=Off
+
 MASTER_URL="http://${MASTER_HOST}:${TEST_PORT}/${MASTER_LOCATION}"
 SLAVE_URL="http://${SLAVE_HOST}:${TEST_PORT}/${SLAVE_LOCATION}"
 SYNC_URL="http://${SLAVE_HOST}:${TEST_PORT}/${SYNC_LOCATION}"
@@ -408,14 +413,18 @@ read SLAVE_UUID < "$SLAVE_REPOS/db/uuid"
 echo "#!/bin/sh" > "$SLAVE_REPOS/hooks/pre-revprop-change"
 echo "#!/bin/sh" > "$MASTER_REPOS/hooks/post-revprop-change"
 echo "#!/bin/sh" > "$MASTER_REPOS/hooks/post-commit"
+echo "#!/bin/sh" > "$SLAVE_REPOS/hooks/post-commit"
 echo "$SVNSYNC --non-interactive sync '$SYNC_URL' --username=svnsync --password=svnsync" \
     >> "$MASTER_REPOS/hooks/post-revprop-change"
 echo "$SVNSYNC --non-interactive sync '$SYNC_URL' --username=svnsync --password=svnsync" \
     >> "$MASTER_REPOS/hooks/post-commit"
+echo "$SVNLOOK author -r \"\$2\" \"\$1\" >> '$HTTPD_ROOT/slave_commit_authors'" \
+    >> "$SLAVE_REPOS/hooks/post-commit"
 
 chmod 0755 "$SLAVE_REPOS/hooks/pre-revprop-change"
 chmod 0755 "$MASTER_REPOS/hooks/post-revprop-change"
 chmod 0755 "$MASTER_REPOS/hooks/post-commit"
+chmod 0755 "$SLAVE_REPOS/hooks/post-commit"
 
 say "created master and slave repositories"
 
@@ -534,6 +543,41 @@ say "Re-activating the post-commit hook on the master repo: $MASTER_REPOS."
 mv "$MASTER_REPOS/hooks/post-commit_" "$MASTER_REPOS/hooks/post-commit"
 say "Syncing slave with master."
 $SVNSYNC --non-interactive sync "$SYNC_URL" --username=svnsync --password=svnsync
+
+# Test case for SVNMasterReplay: without the master's post-commit hook,
+# the slave copies commits made through it by itself, as the sync user.
+say "Test case for SVNMasterReplay"
+mv "$MASTER_REPOS/hooks/post-commit" "$MASTER_REPOS/hooks/post-commit_"
+MASTER_REPLAY=On
+setup_config $HTTPD_CONFIG
+$HTTPD -f $HTTPD_CONFIG -k graceful || fail "httpd graceful restart failed"
+sleep 2
+: > "$HTTPD_ROOT/slave_commit_authors"
+
+echo "Change replayed to the slave" > $HTTPD_ROOT/wc/branch/newfile
+$svn ci -m "Commit replayed by the slave"
+
+MASTER_HEAD=`$SVNLOOK youngest "$MASTER_REPOS"`
+WAITED=0
+while [ "`$SVNLOOK youngest "$SLAVE_REPOS"`" != "$MASTER_HEAD" ] \
+      && [ $WAITED -lt 20 ]; do
+  sleep 1
+  WAITED=$(($WAITED+1))
+done
+SLAVE_HEAD=`$SVNLOOK youngest "$SLAVE_REPOS"`
+SLAVE_AUTHOR=`$SVNLOOK author -r "$SLAVE_HEAD" "$SLAVE_REPOS"`
+COMMIT_AUTHORS=`cat "$HTTPD_ROOT/slave_commit_authors"`
+
+if [ "$SLAVE_HEAD" = "$MASTER_HEAD" ] && [ "$SLAVE_AUTHOR" = "jrandom" ] \
+   && [ "$COMMIT_AUTHORS" = "svnsync" ]; then
+  say "PASS: the slave replayed r$MASTER_HEAD from the master"
+else
+  say "FAIL: the slave is at r$SLAVE_HEAD by '$SLAVE_AUTHOR', committed" \
+      "by '$COMMIT_AUTHORS'; expected r$MASTER_HEAD by 'jrandom'," \
+      "committed by 'svnsync'"
+fi
+mv "$MASTER_REPOS/hooks/post-commit_" "$MASTER_REPOS/hooks/post-commit"
+
 # shut it down
 echo -n "${SCRIPT}: stopping httpd: "
 $HTTPD -f $HTTPD_CONFIG -k stop
@@ -76,6 +76,9 @@
 #
 #  make davautocheck USE_HTTPV1=1           # sets SVNAdvertiseV2Protocol off
 #
+#  make davautocheck USE_HTTP2=1            # run over HTTP/2 (h2/h2c); needs
+#                                           # mod_http2 and a threaded MPM
+#
 #  make davautocheck APACHE_MPM=event       # specifies the 2.4 MPM
 #
 #  make davautocheck SVN_PATH_AUTHZ=short_circuit  # SVNPathAuthz short_circuit
@@ -330,6 +333,12 @@ if [ ${USE_SSL:+set} ]; then
     LOAD_MOD_SSL=$(get_loadmodule_config mod_ssl) \
       || fail "SSL module not found"
 fi
+if [ ${USE_HTTP2:+set} ]; then
+    LOAD_MOD_HTTP2=$(get_loadmodule_config mod_http2) \
+      || fail "HTTP/2 module not found"
+    HTTP2_MAKE_VAR="HTTP_PROTOCOL=h2"
+    HTTP2_TEST_ARG="--http-protocol=h2"
+fi
 
 # Stop any previous instances, os we can re-use the port.
 if [ -x $STOPSCRIPT ]; then $STOPSCRIPT ; sleep 1; fi
@@ -445,6 +454,7 @@ __EOF__
 cat > "$HTTPD_CFG" <<__EOF__
 $LOAD_MOD_MPM
 $LOAD_MOD_SSL
+$LOAD_MOD_HTTP2
 $LOAD_MOD_LOG_CONFIG
 $LOAD_MOD_MIME
 $LOAD_MOD_ALIAS
@@ -501,6 +511,15 @@ SSLCertificateKeyFile $SSL_CERTIFICATE_KEY_FILE
 __EOF__
 fi
 
+if [ ${USE_HTTP2:+set} ]; then
+# Over https, the client negotiates h2 via ALPN; over http, it talks h2c
+# with prior knowledge.
+cat >> "$HTTPD_CFG" <<__EOF__
+Protocols h2 h2c http/1.1
+H2Direct on
+__EOF__
+fi
+
 cat >> "$HTTPD_CFG" <<__EOF__
 Listen              $HTTPD_PORT
 ServerName          localhost
@@ -791,13 +810,13 @@ else
 fi
 
 if [ $# = 0 ]; then
-  TIME_CMD "$MAKE" check "BASE_URL=$BASE_URL" "HTTPD_VERSION=$HTTPD_VERSION" $SSL_MAKE_VAR
+  TIME_CMD "$MAKE" check "BASE_URL=$BASE_URL" "HTTPD_VERSION=$HTTPD_VERSION" $SSL_MAKE_VAR $HTTP2_MAKE_VAR
   r=$?
 else
   (cd "$ABS_BUILDDIR/subversion/tests/cmdline/"
   TEST="$1"
   shift
-  TIME_CMD "$ABS_SRCDIR/subversion/tests/cmdline/${TEST}_tests.py" "--url=$BASE_URL" "--httpd-version=$HTTPD_VERSION" $SSL_TEST_ARG "$@")
+  TIME_CMD "$ABS_SRCDIR/subversion/tests/cmdline/${TEST}_tests.py" "--url=$BASE_URL" "--httpd-version=$HTTPD_VERSION" $SSL_TEST_ARG $HTTP2_TEST_ARG "$@")
   r=$?
 fi
 
@@ -51,7 +51,7 @@ Item = svntest.wc.StateItem
 
 
 def run_sync(url, source_url=None,
-             source_prop_encoding=None,
+             source_prop_encoding=None, prefetch=None,
              expected_output=AnyOutput, expected_error=[]):
   "Synchronize the mirror repository with the master"
   if source_url is not None:
@@ -61,6 +61,9 @@ def run_sync(url, source_url=None,
   if source_prop_encoding:
     args.append("--source-prop-encoding")
     args.append(source_prop_encoding)
+  if prefetch is not None:
+    args.append("--prefetch")
+    args.append(str(prefetch))
 
   # Normal expected output is of the form:
   #            ['Transmitting file data .......\n',  # optional
@@ -105,8 +108,9 @@ def run_info(url, expected_output=AnyOutput, expected_error=[]):
 
 def setup_and_sync(sbox, dump_file_contents, subdir=None,
                    bypass_prop_validation=False, source_prop_encoding=None,
-                   is_src_ra_local=None, is_dest_ra_local=None):
-  """Create a repository for SBOX, load it with DUMP_FILE_CONTENTS, then create a mirror repository and sync it with SBOX. If is_src_ra_local or is_dest_ra_local is True, then run_init, run_sync, and run_copy_revprops will use the file:// scheme for the source and destination URLs.  Return the mirror sandbox."""
+                   is_src_ra_local=None, is_dest_ra_local=None,
+                   prefetch=None):
+  """Create a repository for SBOX, load it with DUMP_FILE_CONTENTS, then create a mirror repository and sync it with SBOX. If is_src_ra_local or is_dest_ra_local is True, then run_init, run_sync, and run_copy_revprops will use the file:// scheme for the source and destination URLs.  If PREFETCH is not None, pass it to run_sync as the --prefetch option.  Return the mirror sandbox."""
 
   # Create the empty master repository.
   sbox.build(create_wc=False, empty=True)
@@ -142,7 +146,7 @@ def setup_and_sync(sbox, dump_file_contents, subdir=None,
   run_init(dest_repo_url, repo_url, source_prop_encoding)
 
   run_sync(dest_repo_url, repo_url,
-           source_prop_encoding=source_prop_encoding)
+           source_prop_encoding=source_prop_encoding, prefetch=prefetch)
   run_copy_revprops(dest_repo_url, repo_url,
                     source_prop_encoding=source_prop_encoding)
 
@@ -171,7 +175,8 @@ def verify_mirror(dest_sbox, exp_dump_file_contents):
 
 def run_test(sbox, dump_file_name, subdir=None, exp_dump_file_name=None,
              bypass_prop_validation=False, source_prop_encoding=None,
-             is_src_ra_local=None, is_dest_ra_local=None):
+             is_src_ra_local=None, is_dest_ra_local=None,
+             prefetch=None):
 
   """Load a dump file, sync repositories, and compare contents with the original
 or another dump file."""
@@ -187,7 +192,7 @@ or another dump file."""
 
   dest_sbox = setup_and_sync(sbox, master_dumpfile_contents, subdir,
                              bypass_prop_validation, source_prop_encoding,
-                             is_src_ra_local, is_dest_ra_local)
+                             is_src_ra_local, is_dest_ra_local, prefetch)
 
   # Compare the dump produced by the mirror repository with either the original
   # dump file (used to create the master repository) or another specified dump
@@ -587,6 +592,66 @@ def up_to_date_sync(sbox):
   svntest.actions.run_and_verify_svnsync([], [],
                                          "synchronize", dest_sbox.repo_url)
 
+def sync_without_prefetch(sbox):
+  "sync fetching each revision when needed"
+  run_test(sbox, "largemods.dump", prefetch=0)
+
+def sync_prefetch_one(sbox):
+  "sync fetching one revision ahead"
+  run_test(sbox, "largemods.dump", prefetch=1)
+
+@SkipUnless(server_has_partial_replay)
+def copy_revprops_subdir(sbox):
+  "copy-revprops of revisions outside a subdir"
+
+  # r2 and r4 change the synchronized subdir, r3 doesn't, so a log of
+  # the subdir won't report the revision properties of r0 and r3.
+  sbox.build(create_wc=False)
+  for path in ('A/B/X', 'A/C/Y', 'A/B/Z'):
+    svntest.actions.run_and_verify_svn(None, [],
+                                       'mkdir', '-m', 'log msg',
+                                       sbox.repo_url + '/' + path)
+
+  dest_sbox = sbox.clone_dependent()
+  dest_sbox.build(create_wc=False, empty=True)
+  svntest.actions.enable_revprop_changes(dest_sbox.repo_dir)
+  run_init(dest_sbox.repo_url, sbox.repo_url + '/A/B')
+  run_sync(dest_sbox.repo_url)
+
+  def set_revprops(revs, value):
+    for rev in revs:
+      svntest.actions.run_and_verify_svn(None, [],
+                                         'propset', '--revprop',
+                                         '-r', str(rev), 'batch-test',
+                                         value % rev, sbox.repo_url)
+
+  def verify_revprops(revs, value):
+    for rev in revs:
+      svntest.actions.run_and_verify_svn([value % rev + '\n'], [],
+                                         'propget', '--revprop',
+                                         '-r', str(rev), 'batch-test',
+                                         dest_sbox.repo_url)
+
+  svntest.actions.enable_revprop_changes(sbox.repo_dir)
+
+  # Copy all revisions, in ascending order.
+  set_revprops(range(0, 5), 'rev %d')
+  expected_output = ['Copied properties for revision %d.\n' % rev
+                     for rev in range(0, 5)]
+  run_copy_revprops(dest_sbox.repo_url, sbox.repo_url,
+                    expected_output=expected_output)
+  verify_revprops(range(0, 5), 'rev %d')
+
+  # Copy some of them again, in descending order.
+  set_revprops(range(2, 5), 'changed rev %d')
+  expected_output = ['Copied properties for revision %d.\n' % rev
+                     for rev in range(4, 1, -1)]
+  svntest.actions.run_and_verify_svnsync(expected_output, [],
+                                         'copy-revprops', '-r', '4:2',
+                                         dest_sbox.repo_url, sbox.repo_url)
+  verify_revprops(range(2, 5), 'changed rev %d')
+  verify_revprops(range(0, 2), 'rev %d')
+
 
 ########################################################################
 # Run the tests
@@ -625,6 +690,9 @@ test_list = [ None,
               fd_leak_sync_from_serf_to_local, # calls setrlimit
               mergeinfo_contains_r0,
               up_to_date_sync,
+              sync_without_prefetch,
+              sync_prefetch_one,
+              copy_revprops_subdir,
              ]
 
 if __name__ == '__main__':
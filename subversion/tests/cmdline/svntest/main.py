@@ -702,6 +702,9 @@ exclusive-locking = true
     http_library_str = ""
     if options.http_library:
       http_library_str = "http-library=%s" % (options.http_library)
+    http_protocol_str = ""
+    if options.http_protocol:
+      http_protocol_str = "http-protocol=%s" % (options.http_protocol)
     http_proxy_str = ""
     http_proxy_username_str = ""
     http_proxy_password_str = ""
@@ -723,10 +726,11 @@ exclusive-locking = true
 %s
 %s
 %s
+%s
 store-plaintext-passwords=yes
 store-passwords=yes
-""" % (http_library_str, http_proxy_str, http_proxy_username_str,
-       http_proxy_password_str)
+""" % (http_library_str, http_protocol_str, http_proxy_str,
+       http_proxy_username_str, http_proxy_password_str)
 
   file_write(cfgfile_cfg, config_contents)
   file_write(cfgfile_srv, server_contents)
@@ -1597,6 +1601,10 @@ def is_ra_type_svn():
   """Return True iff running tests over RA-svn."""
   return options.test_area_url.startswith('svn')
 
+def is_ra_type_svns():
+  """Return True iff running tests over RA-svn with TLS."""
+  return options.test_area_url.startswith('svns')
+
 def is_ra_type_file():
   """Return True iff running tests over RA-local."""
   return options.test_area_url.startswith('file')
@@ -1767,6 +1775,8 @@ class TestSpawningThread(threading.Thread):
       args.append('--enable-sasl')
     if options.http_library:
       args.append('--http-library=' + options.http_library)
+    if options.http_protocol:
+      args.append('--http-protocol=' + options.http_protocol)
     if options.server_minor_version:
       args.append('--server-minor-version=' + str(options.server_minor_version))
     if options.mode_filter:
@@ -2166,6 +2176,9 @@ def _create_parser(usage=None):
                     help="Make svn use this DAV library (neon or serf) if " +
                          "it supports both, else assume it's using this " +
                          "one; the default is " + _default_http_library)
+  parser.add_option('--http-protocol', action='store',
+                    help="Make svn talk this HTTP protocol version " +
+                         "(http/1.1 or h2) to the server")
   parser.add_option('--server-minor-version', type='int', action='store',
                     help="Set the minor version for the server ('3'..'%d')."
                     % SVN_VER_MINOR)
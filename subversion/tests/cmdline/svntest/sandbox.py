@@ -601,6 +601,7 @@ def is_url(target):
           or target.startswith('http://')
           or target.startswith('https://')
           or target.startswith('svn://')
+          or target.startswith('svns://')
           or target.startswith('svn+ssh://'))
 
 
@@ -864,6 +864,7 @@ def is_absolute_url(target):
           or target.startswith('http://')
           or target.startswith('https://')
           or target.startswith('svn://')
+          or target.startswith('svns://')
           or target.startswith('svn+ssh://'))
 
 def make_diff_header(path, old_tag, new_tag, src_label=None, dst_label=None):
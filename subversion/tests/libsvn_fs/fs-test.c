@@ -7441,6 +7441,228 @@ test_closest_copy_file_replaced_with_dir(const svn_test_opts_t *opts,
   return SVN_NO_ERROR;
 }
 
+static svn_error_t *
+test_prefetch_nodes(const svn_test_opts_t *opts,
+                    apr_pool_t *pool)
+{
+  svn_fs_t *fs;
+  svn_fs_txn_t *txn;
+  svn_fs_root_t *txn_root, *root;
+  svn_revnum_t rev;
+  apr_array_header_t *paths;
+  apr_hash_t *entries;
+  svn_string_t *value;
+
+  /* Create a new repo and the greek tree in rev 1, with some props. */
+  SVN_ERR(svn_test__create_fs(&fs, "test-repo-prefetch-nodes",
+                              opts, pool));
+
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, 0, pool));
+  SVN_ERR(svn_fs_txn_root(&txn_root, txn, pool));
+  SVN_ERR(svn_test__create_greek_tree(txn_root, pool));
+  SVN_ERR(svn_fs_change_node_prop(txn_root, "A/mu", "name",
+                                  svn_string_create("mu", pool), pool));
+  SVN_ERR(svn_fs_change_node_prop(txn_root, "A/D", "name",
+                                  svn_string_create("D", pool), pool));
+  SVN_ERR(test_commit_txn(&rev, txn, NULL, pool));
+
+  SVN_ERR(svn_fs_revision_root(&root, fs, rev, pool));
+
+  /* Mix existing nodes with missing ones and ones below files. */
+  paths = apr_array_make(pool, 8, sizeof(const char *));
+  APR_ARRAY_PUSH(paths, const char *) = "/";
+  APR_ARRAY_PUSH(paths, const char *) = "A/mu";
+  APR_ARRAY_PUSH(paths, const char *) = "/A/D";
+  APR_ARRAY_PUSH(paths, const char *) = "/A/B/E/alpha";
+  APR_ARRAY_PUSH(paths, const char *) = "/A/missing";
+  APR_ARRAY_PUSH(paths, const char *) = "/A/missing/child";
+  APR_ARRAY_PUSH(paths, const char *) = "/iota/child";
+
+  SVN_ERR(svn_fs_prefetch_nodes(root, paths, TRUE, TRUE, pool));
+  SVN_ERR(svn_fs_prefetch_nodes(root, paths, FALSE, FALSE, pool));
+
+  /* The prefetch must not alter the data. */
+  SVN_ERR(svn_fs_node_prop(&value, root, "A/mu", "name", pool));
+  SVN_TEST_STRING_ASSERT(value->data, "mu");
+  SVN_ERR(svn_fs_node_prop(&value, root, "A/D", "name", pool));
+  SVN_TEST_STRING_ASSERT(value->data, "D");
+  SVN_ERR(svn_fs_dir_entries(&entries, root, "A/D", pool));
+  SVN_TEST_INT_ASSERT(apr_hash_count(entries), 3);
+
+  /* Transaction roots are fine, too. */
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, rev, pool));
+  SVN_ERR(svn_fs_txn_root(&txn_root, txn, pool));
+  SVN_ERR(svn_fs_make_file(txn_root, "A/new", pool));
+  APR_ARRAY_PUSH(paths, const char *) = "A/new";
+  SVN_ERR(svn_fs_prefetch_nodes(txn_root, paths, TRUE, TRUE, pool));
+  SVN_ERR(svn_fs_abort_txn(txn, pool));
+
+  return SVN_NO_ERROR;
+}
+
+/* Verify that skipping the first SKIP bytes of PATH in ROOT and reading
+   the rest yields the tail of EXPECTED. */
+static svn_error_t *
+check_skipped_contents(svn_fs_root_t *root,
+                       const char *path,
+                       const svn_stringbuf_t *expected,
+                       apr_size_t skip,
+                       apr_pool_t *pool)
+{
+  svn_stream_t *stream;
+  svn_stringbuf_t *actual;
+
+  SVN_ERR(svn_fs_file_contents(&stream, root, path, pool));
+  SVN_ERR(svn_stream_skip(stream, skip));
+  SVN_ERR(svn_stringbuf_from_stream(&actual, stream, 0, pool));
+  SVN_ERR(svn_stream_close(stream));
+
+  if (skip > expected->len)
+    skip = expected->len;
+  SVN_TEST_INT_ASSERT(actual->len, expected->len - skip);
+  SVN_TEST_ASSERT(memcmp(actual->data, expected->data + skip,
+                         actual->len) == 0);
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+test_file_contents_skip(const svn_test_opts_t *opts,
+                        apr_pool_t *pool)
+{
+  svn_fs_t *fs;
+  svn_fs_txn_t *txn;
+  svn_fs_root_t *txn_root, *root;
+  svn_revnum_t rev;
+  svn_stringbuf_t *contents = svn_stringbuf_create_empty(pool);
+  int i;
+
+  for (i = 0; i < 20000; i++)
+    svn_stringbuf_appendcstr(contents, apr_psprintf(pool, "line %d\n", i));
+
+  SVN_ERR(svn_test__create_fs(&fs, "test-repo-file-contents-skip",
+                              opts, pool));
+
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, 0, pool));
+  SVN_ERR(svn_fs_txn_root(&txn_root, txn, pool));
+  SVN_ERR(svn_fs_make_file(txn_root, "file", pool));
+  SVN_ERR(svn_test__set_file_contents(txn_root, "file", contents->data,
+                                      pool));
+  SVN_ERR(test_commit_txn(&rev, txn, NULL, pool));
+
+  /* A second revision that is stored as a delta. */
+  svn_stringbuf_insert(contents, 1000, "changed\n", 8);
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, rev, pool));
+  SVN_ERR(svn_fs_txn_root(&txn_root, txn, pool));
+  SVN_ERR(svn_test__set_file_contents(txn_root, "file", contents->data,
+                                      pool));
+  SVN_ERR(test_commit_txn(&rev, txn, NULL, pool));
+
+  SVN_ERR(svn_fs_revision_root(&root, fs, rev, pool));
+
+  /* Before and after the contents made it into any cache. */
+  SVN_ERR(check_skipped_contents(root, "file", contents, 70000, pool));
+  SVN_ERR(check_skipped_contents(root, "file", contents, 0, pool));
+  SVN_ERR(check_skipped_contents(root, "file", contents, 70000, pool));
+  SVN_ERR(check_skipped_contents(root, "file", contents, 1, pool));
+  SVN_ERR(check_skipped_contents(root, "file", contents, contents->len,
+                                 pool));
+  SVN_ERR(check_skipped_contents(root, "file", contents,
+                                 contents->len + 100, pool));
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+test_open_stored_delta(const svn_test_opts_t *opts,
+                       apr_pool_t *pool)
+{
+  svn_fs_t *fs;
+  svn_fs_txn_t *txn;
+  svn_fs_root_t *txn_root, *root1, *root2;
+  svn_revnum_t rev1, rev2;
+  svn_stringbuf_t *contents1 = svn_stringbuf_create_empty(pool);
+  svn_stringbuf_t *contents2;
+  svn_stringbuf_t *svndiff;
+  svn_stringbuf_t *actual = svn_stringbuf_create_empty(pool);
+  svn_txdelta_window_handler_t handler;
+  void *handler_baton;
+  svn_stream_t *stream;
+  apr_file_t *file;
+  apr_off_t offset;
+  svn_filesize_t length;
+  int svndiff_version;
+  int i;
+
+  for (i = 0; i < 10000; i++)
+    svn_stringbuf_appendcstr(contents1, apr_psprintf(pool, "line %d\n", i));
+  contents2 = svn_stringbuf_dup(contents1, pool);
+  svn_stringbuf_insert(contents2, 500, "changed\n", 8);
+
+  SVN_ERR(svn_test__create_fs(&fs, "test-repo-open-stored-delta",
+                              opts, pool));
+
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, 0, pool));
+  SVN_ERR(svn_fs_txn_root(&txn_root, txn, pool));
+  SVN_ERR(svn_fs_make_file(txn_root, "file", pool));
+  SVN_ERR(svn_test__set_file_contents(txn_root, "file", contents1->data,
+                                      pool));
+  SVN_ERR(test_commit_txn(&rev1, txn, NULL, pool));
+
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, rev1, pool));
+  SVN_ERR(svn_fs_txn_root(&txn_root, txn, pool));
+  SVN_ERR(svn_test__set_file_contents(txn_root, "file", contents2->data,
+                                      pool));
+
+  /* Transaction contents are never handed out. */
+  SVN_ERR(svn_fs_revision_root(&root1, fs, rev1, pool));
+  SVN_ERR(svn_fs__open_stored_delta(&file, &offset, &length,
+                                    &svndiff_version, root1, "file",
+                                    txn_root, "file", pool, pool));
+  SVN_TEST_ASSERT(file == NULL);
+
+  SVN_ERR(test_commit_txn(&rev2, txn, NULL, pool));
+  SVN_ERR(svn_fs_revision_root(&root2, fs, rev2, pool));
+
+  /* There is no delta against a later revision. */
+  SVN_ERR(svn_fs__open_stored_delta(&file, &offset, &length,
+                                    &svndiff_version, root2, "file",
+                                    root1, "file", pool, pool));
+  SVN_TEST_ASSERT(file == NULL);
+
+  SVN_ERR(svn_fs__open_stored_delta(&file, &offset, &length,
+                                    &svndiff_version, root1, "file",
+                                    root2, "file", pool, pool));
+
+  /* Only FSFS hands out its deltas. */
+  if (strcmp(opts->fs_type, SVN_FS_TYPE_FSFS) != 0)
+    {
+      SVN_TEST_ASSERT(file == NULL);
+      return SVN_NO_ERROR;
+    }
+
+  SVN_TEST_ASSERT(file != NULL);
+  SVN_TEST_ASSERT(svndiff_version >= 0 && svndiff_version <= 2);
+
+  /* Applying the stored delta to r1 must give r2. */
+  svndiff = svn_stringbuf_create_ensure((apr_size_t)length, pool);
+  SVN_ERR(svn_io_file_seek(file, APR_SET, &offset, pool));
+  SVN_ERR(svn_io_file_read_full2(file, svndiff->data, (apr_size_t)length,
+                                 NULL, NULL, pool));
+  svndiff->len = (apr_size_t)length;
+
+  svn_txdelta_apply(svn_stream_from_stringbuf(contents1, pool),
+                    svn_stream_from_stringbuf(actual, pool),
+                    NULL, NULL, pool, &handler, &handler_baton);
+  stream = svn_txdelta_parse_svndiff(handler, handler_baton, TRUE, pool);
+  SVN_ERR(svn_stream_write(stream, svndiff->data, &svndiff->len));
+  SVN_ERR(svn_stream_close(stream));
+
+  SVN_TEST_STRING_ASSERT(actual->data, contents2->data);
+
+  return SVN_NO_ERROR;
+}
+
 /* ------------------------------------------------------------------------ */
 
 /* The test table.  */
@@ -7587,6 +7809,12 @@ static struct svn_test_descriptor_t test_funcs[] =
                        "test issue SVN-4677 regression"),
     SVN_TEST_OPTS_PASS(test_closest_copy_file_replaced_with_dir,
                        "svn_fs_closest_copy after replacing file with dir"),
+    SVN_TEST_OPTS_PASS(test_prefetch_nodes,
+                       "test svn_fs_prefetch_nodes"),
+    SVN_TEST_OPTS_PASS(test_file_contents_skip,
+                       "test skipping in file contents streams"),
+    SVN_TEST_OPTS_PASS(test_open_stored_delta,
+                       "test svn_fs__open_stored_delta"),
     SVN_TEST_NULL
   };
 
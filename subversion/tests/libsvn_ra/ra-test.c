@@ -26,6 +26,7 @@
 #include <apr_general.h>
 #include <apr_pools.h>
 #include <apr_file_io.h>
+#include <apr_strings.h>
 #include <assert.h>
 
 #include "svn_error.h"
@@ -34,8 +35,13 @@
 #include "svn_time.h"
 #include "svn_pools.h"
 #include "svn_cmdline.h"
+#include "svn_config.h"
 #include "svn_dirent_uri.h"
 #include "svn_hash.h"
+#include "svn_ra_svn.h"
+
+#include "private/svn_ra_private.h"
+#include "private/svn_ra_svn_private.h"
 
 #include "../svn_test.h"
 #include "../svn_test_fs.h"
@@ -260,6 +266,104 @@ close_tunnel(void *tunnel_context, void *tunnel_baton)
     }
 }
 
+/* Create the repository REPOS_NAME and open an ra_svn session to it in
+   *SESSION, tunneled through svnserve with tunnel baton *B and using
+   CONFIG.  Allocate everything in POOL. */
+static svn_error_t *
+make_and_open_tunnel_repos(svn_ra_session_t **session,
+                           tunnel_baton_t **b,
+                           const char *repos_name,
+                           apr_hash_t *config,
+                           const svn_test_opts_t *opts,
+                           apr_pool_t *pool)
+{
+  apr_pool_t *scratch_pool = svn_pool_create(pool);
+  const char *url;
+  svn_ra_callbacks2_t *cbtable;
+
+  *b = apr_pcalloc(pool, sizeof(**b));
+  (*b)->magic = TUNNEL_MAGIC;
+
+  SVN_ERR(svn_test__create_repos(NULL, repos_name, opts, scratch_pool));
+
+  /* Immediately close the repository to avoid race condition with svnserve
+  (and then the cleanup code) with BDB when our pool is cleared. */
+  svn_pool_destroy(scratch_pool);
+
+  url = apr_pstrcat(pool, "svn+test://localhost/", repos_name, SVN_VA_NULL);
+  SVN_ERR(svn_ra_create_callbacks(&cbtable, pool));
+  cbtable->check_tunnel_func = check_tunnel;
+  cbtable->open_tunnel_func = open_tunnel;
+  cbtable->tunnel_baton = *b;
+  SVN_ERR(svn_cmdline_create_auth_baton2(&cbtable->auth_baton,
+    TRUE  /* non_interactive */,
+    "jrandom", "rayjandom",
+    NULL,
+    TRUE  /* no_auth_cache */,
+    FALSE /* trust_server_cert */,
+    FALSE, FALSE, FALSE, FALSE,
+    NULL, NULL, NULL, pool));
+
+  SVN_ERR(svn_ra_open4(session, NULL, url, NULL, cbtable, NULL, config,
+                       pool));
+
+  return SVN_NO_ERROR;
+}
+
+/* Commit the file PATH with CONTENTS and the property PROPNAME set to
+   PROPVAL, if not NULL, through SESSION. */
+static svn_error_t *
+commit_file(svn_ra_session_t *session,
+            const char *path,
+            const svn_string_t *contents,
+            const char *propname,
+            const svn_string_t *propval,
+            apr_pool_t *pool)
+{
+  const svn_delta_editor_t *editor;
+  void *edit_baton;
+  void *root_baton, *file_baton;
+  svn_txdelta_window_handler_t handler;
+  void *handler_baton;
+
+  SVN_ERR(svn_ra_get_commit_editor3(session, &editor, &edit_baton,
+                                    apr_hash_make(pool),
+                                    NULL, NULL, NULL, TRUE, pool));
+  SVN_ERR(editor->open_root(edit_baton, SVN_INVALID_REVNUM,
+                            pool, &root_baton));
+  SVN_ERR(editor->add_file(path, root_baton, NULL, SVN_INVALID_REVNUM,
+                           pool, &file_baton));
+  SVN_ERR(editor->apply_textdelta(file_baton, NULL, pool,
+                                  &handler, &handler_baton));
+  SVN_ERR(svn_txdelta_send_string(contents, handler, handler_baton, pool));
+  if (propname)
+    SVN_ERR(editor->change_file_prop(file_baton, propname, propval, pool));
+  SVN_ERR(editor->close_file(file_baton, NULL, pool));
+  SVN_ERR(editor->close_directory(root_baton, pool));
+  SVN_ERR(editor->close_edit(edit_baton, pool));
+
+  return SVN_NO_ERROR;
+}
+
+/* Return a string of SIZE bytes with non-repeating lines, allocated in
+   POOL. */
+static svn_string_t *
+make_big_text(apr_size_t size,
+              apr_pool_t *pool)
+{
+  svn_stringbuf_t *text = svn_stringbuf_create_ensure(size, pool);
+  char line[32];
+  int i;
+
+  for (i = 0; text->len < size; i++)
+    svn_stringbuf_appendbytes(text, line,
+                              apr_snprintf(line, sizeof(line),
+                                           "line %d\n", i));
+  svn_stringbuf_chop(text, text->len - size);
+
+  return svn_string_create_from_buf(text, pool);
+}
+
 
 
 
@@ -1576,6 +1680,601 @@ tunnel_run_checkout(const svn_test_opts_t *opts,
   return SVN_NO_ERROR;
 }
 
+/* Return a request for PATH of KIND, allocated in POOL. */
+static svn_ra__node_request_t *
+node_request(const char *path,
+             svn_node_kind_t kind,
+             apr_pool_t *pool)
+{
+  svn_ra__node_request_t *request = apr_pcalloc(pool, sizeof(*request));
+
+  request->path = path;
+  request->kind = kind;
+  return request;
+}
+
+/* Test svn_ra__get_nodes() on a pipelining ra_svn session. */
+
+static svn_error_t *
+tunnel_get_nodes(const svn_test_opts_t *opts,
+                 apr_pool_t *pool)
+{
+  tunnel_baton_t *b = apr_pcalloc(pool, sizeof(*b));
+  apr_pool_t *scratch_pool = svn_pool_create(pool);
+  const char *url;
+  svn_ra_callbacks2_t *cbtable;
+  svn_ra_session_t *session;
+  const char tunnel_repos_name[] = "test-get-nodes";
+  apr_array_header_t *requests;
+  svn_ra__node_request_t *request;
+  int i;
+
+  b->magic = TUNNEL_MAGIC;
+
+  SVN_ERR(svn_test__create_repos(NULL, tunnel_repos_name, opts, scratch_pool));
+
+  /* Immediately close the repository to avoid race condition with svnserve
+  (and then the cleanup code) with BDB when our pool is cleared. */
+  svn_pool_clear(scratch_pool);
+
+  url = apr_pstrcat(pool, "svn+test://localhost/", tunnel_repos_name,
+    SVN_VA_NULL);
+  SVN_ERR(svn_ra_create_callbacks(&cbtable, pool));
+  cbtable->check_tunnel_func = check_tunnel;
+  cbtable->open_tunnel_func = open_tunnel;
+  cbtable->tunnel_baton = b;
+  SVN_ERR(svn_cmdline_create_auth_baton2(&cbtable->auth_baton,
+    TRUE  /* non_interactive */,
+    "jrandom", "rayjandom",
+    NULL,
+    TRUE  /* no_auth_cache */,
+    FALSE /* trust_server_cert */,
+    FALSE, FALSE, FALSE, FALSE,
+    NULL, NULL, NULL, pool));
+
+  SVN_ERR(svn_ra_open4(&session, NULL, url, NULL, cbtable, NULL, NULL,
+                       scratch_pool));
+  SVN_ERR(commit_tree(session, pool));
+
+  /* More requests than fit into the pipeline, with a failing one in the
+     middle that must not disturb the ones queued behind it. */
+  requests = apr_array_make(pool, 40, sizeof(svn_ra__node_request_t *));
+  for (i = 0; i < 20; i++)
+    {
+      APR_ARRAY_PUSH(requests, svn_ra__node_request_t *)
+        = node_request(i % 2 ? "A/B" : "A/BB", svn_node_dir, pool);
+      APR_ARRAY_PUSH(requests, svn_ra__node_request_t *)
+        = node_request(i == 10 ? "A/missing" : "A/B/f",
+                       svn_node_file, pool);
+    }
+
+  SVN_TEST_ASSERT_ERROR(svn_ra__get_nodes(session, requests, 1, TRUE, TRUE,
+                                          SVN_DIRENT_KIND, pool, pool),
+                        SVN_ERR_FS_NOT_FOUND);
+
+  for (i = 0; i < requests->nelts; i++)
+    {
+      request = APR_ARRAY_IDX(requests, i, svn_ra__node_request_t *);
+
+      if (i == 21)
+        {
+          SVN_TEST_ASSERT(request->props == NULL);
+          continue;
+        }
+
+      SVN_TEST_ASSERT(request->props != NULL);
+      if (request->kind == svn_node_dir)
+        {
+          SVN_TEST_ASSERT(request->dirents != NULL);
+          SVN_TEST_INT_ASSERT(apr_hash_count(request->dirents), 2);
+          SVN_TEST_ASSERT(svn_hash_gets(request->dirents, "g") != NULL);
+        }
+      else
+        SVN_TEST_ASSERT(request->dirents == NULL);
+    }
+
+  /* The session is still usable. */
+  requests->nelts = 1;
+  SVN_ERR(svn_ra__get_nodes(session, requests, 1, TRUE, FALSE,
+                            SVN_DIRENT_KIND, pool, pool));
+  request = APR_ARRAY_IDX(requests, 0, svn_ra__node_request_t *);
+  SVN_TEST_ASSERT(request->dirents != NULL && request->props == NULL);
+
+  return SVN_NO_ERROR;
+}
+
+/* Test that an ra_svn session stays in sync after svn_ra__get_nodes()
+   reported the failure of some of its requests. */
+
+static svn_error_t *
+tunnel_get_nodes_reuse(const svn_test_opts_t *opts,
+                       apr_pool_t *pool)
+{
+  tunnel_baton_t *b;
+  svn_ra_session_t *session;
+  apr_array_header_t *requests;
+  svn_ra__node_request_t *request;
+  apr_hash_t *dirents;
+  svn_revnum_t fetched_rev;
+  int i;
+
+  SVN_ERR(make_and_open_tunnel_repos(&session, &b, "test-get-nodes-reuse",
+                                     NULL, opts, pool));
+  SVN_ERR(commit_tree(session, pool));
+
+  /* Failing requests at the start, in the middle and at the end. */
+  requests = apr_array_make(pool, 5, sizeof(svn_ra__node_request_t *));
+  APR_ARRAY_PUSH(requests, svn_ra__node_request_t *)
+    = node_request("A/missing", svn_node_file, pool);
+  APR_ARRAY_PUSH(requests, svn_ra__node_request_t *)
+    = node_request("A/B", svn_node_dir, pool);
+  APR_ARRAY_PUSH(requests, svn_ra__node_request_t *)
+    = node_request("A/B/missing", svn_node_file, pool);
+  APR_ARRAY_PUSH(requests, svn_ra__node_request_t *)
+    = node_request("A/BB/f", svn_node_file, pool);
+  APR_ARRAY_PUSH(requests, svn_ra__node_request_t *)
+    = node_request("A/BB/missing", svn_node_dir, pool);
+
+  SVN_TEST_ASSERT_ERROR(svn_ra__get_nodes(session, requests, 1, TRUE, TRUE,
+                                          SVN_DIRENT_KIND, pool, pool),
+                        SVN_ERR_FS_NOT_FOUND);
+
+  for (i = 0; i < requests->nelts; i++)
+    {
+      request = APR_ARRAY_IDX(requests, i, svn_ra__node_request_t *);
+      if (i == 1 || i == 3)
+        SVN_TEST_ASSERT(request->props != NULL);
+      else
+        SVN_TEST_ASSERT(request->props == NULL && request->dirents == NULL);
+    }
+  request = APR_ARRAY_IDX(requests, 1, svn_ra__node_request_t *);
+  SVN_TEST_ASSERT(svn_hash_gets(request->dirents, "g") != NULL);
+
+  /* Plain requests on the same connection must get their own responses,
+     not ones left over from the batch. */
+  SVN_ERR(svn_ra_get_dir2(session, &dirents, &fetched_rev, NULL, "A", 1,
+                          SVN_DIRENT_KIND, pool));
+  SVN_TEST_INT_ASSERT(fetched_rev, 1);
+  SVN_TEST_INT_ASSERT(apr_hash_count(dirents), 2);
+  SVN_TEST_ASSERT(svn_hash_gets(dirents, "BB") != NULL);
+
+  SVN_TEST_ASSERT_ERROR(svn_ra_get_file(session, "A/missing", 1, NULL,
+                                        NULL, NULL, pool),
+                        SVN_ERR_FS_NOT_FOUND);
+
+  SVN_ERR(svn_ra_get_dir2(session, &dirents, NULL, NULL, "A/BB", 1,
+                          SVN_DIRENT_KIND, pool));
+  SVN_TEST_INT_ASSERT(apr_hash_count(dirents), 2);
+  SVN_TEST_ASSERT(svn_hash_gets(dirents, "f") != NULL);
+
+  SVN_ERR(svn_ra_get_latest_revnum(session, &fetched_rev, pool));
+  SVN_TEST_INT_ASSERT(fetched_rev, 1);
+
+  return SVN_NO_ERROR;
+}
+
+/* Baton for the file collecting editor used by tunnel_parallel_update. */
+typedef struct collect_baton_t
+{
+  /* Maps paths to the svn_stringbuf_t contents received for them. */
+  apr_hash_t *contents;
+  apr_pool_t *pool;
+} collect_baton_t;
+
+/* Baton for files received by the collecting editor. */
+typedef struct collect_file_baton_t
+{
+  collect_baton_t *cb;
+  const char *path;
+  svn_stringbuf_t *contents;
+} collect_file_baton_t;
+
+static svn_error_t *
+collect_open_root(void *edit_baton,
+                  svn_revnum_t base_revision,
+                  apr_pool_t *dir_pool,
+                  void **root_baton)
+{
+  *root_baton = edit_baton;
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+collect_add_directory(const char *path,
+                      void *parent_baton,
+                      const char *copyfrom_path,
+                      svn_revnum_t copyfrom_revision,
+                      apr_pool_t *dir_pool,
+                      void **child_baton)
+{
+  *child_baton = parent_baton;
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+collect_add_file(const char *path,
+                 void *parent_baton,
+                 const char *copyfrom_path,
+                 svn_revnum_t copyfrom_revision,
+                 apr_pool_t *file_pool,
+                 void **file_baton)
+{
+  collect_baton_t *cb = parent_baton;
+  collect_file_baton_t *fb = apr_pcalloc(cb->pool, sizeof(*fb));
+
+  fb->cb = cb;
+  fb->path = apr_pstrdup(cb->pool, path);
+  fb->contents = svn_stringbuf_create_empty(cb->pool);
+  *file_baton = fb;
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+collect_apply_textdelta(void *file_baton,
+                        const char *base_checksum,
+                        apr_pool_t *pool,
+                        svn_txdelta_window_handler_t *handler,
+                        void **handler_baton)
+{
+  collect_file_baton_t *fb = file_baton;
+
+  svn_txdelta_apply(svn_stream_empty(pool),
+                    svn_stream_from_stringbuf(fb->contents, pool),
+                    NULL, fb->path, pool, handler, handler_baton);
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+collect_close_file(void *file_baton,
+                   const char *text_checksum,
+                   apr_pool_t *pool)
+{
+  collect_file_baton_t *fb = file_baton;
+
+  svn_hash_sets(fb->cb->contents, fb->path, fb->contents);
+  return SVN_NO_ERROR;
+}
+
+/* Test an ra_svn update that fetches file contents over additional
+   connections. */
+
+static svn_error_t *
+tunnel_parallel_update(const svn_test_opts_t *opts,
+                       apr_pool_t *pool)
+{
+  tunnel_baton_t *b = apr_pcalloc(pool, sizeof(*b));
+  apr_pool_t *scratch_pool = svn_pool_create(pool);
+  apr_pool_t *report_pool;
+  const char *url;
+  svn_ra_callbacks2_t *cbtable;
+  svn_ra_session_t *session;
+  const char tunnel_repos_name[] = "test-parallel-update";
+  const svn_ra_reporter3_t *reporter;
+  void *report_baton;
+  apr_hash_t *config;
+  svn_config_t *servers;
+  const svn_delta_editor_t *editor;
+  void *edit_baton;
+  void *root_baton, *dir_baton, *file_baton;
+  svn_delta_editor_t *collect_editor;
+  collect_baton_t cb;
+  int i;
+
+  b->magic = TUNNEL_MAGIC;
+
+  SVN_ERR(svn_test__create_repos(NULL, tunnel_repos_name, opts, scratch_pool));
+
+  /* Immediately close the repository to avoid race condition with svnserve
+  (and then the cleanup code) with BDB when our pool is cleared. */
+  svn_pool_clear(scratch_pool);
+
+  url = apr_pstrcat(pool, "svn+test://localhost/", tunnel_repos_name,
+    SVN_VA_NULL);
+  SVN_ERR(svn_ra_create_callbacks(&cbtable, pool));
+  cbtable->check_tunnel_func = check_tunnel;
+  cbtable->open_tunnel_func = open_tunnel;
+  cbtable->tunnel_baton = b;
+  SVN_ERR(svn_cmdline_create_auth_baton2(&cbtable->auth_baton,
+    TRUE  /* non_interactive */,
+    "jrandom", "rayjandom",
+    NULL,
+    TRUE  /* no_auth_cache */,
+    FALSE /* trust_server_cert */,
+    FALSE, FALSE, FALSE, FALSE,
+    NULL, NULL, NULL, pool));
+
+  config = apr_hash_make(pool);
+  SVN_ERR(svn_config_create2(&servers, FALSE, FALSE, pool));
+  svn_config_set(servers, SVN_CONFIG_SECTION_GLOBAL,
+                 SVN_CONFIG_OPTION_SVN_MAX_CONNECTIONS, "3");
+  svn_hash_sets(config, SVN_CONFIG_CATEGORY_SERVERS, servers);
+
+  SVN_ERR(svn_ra_open4(&session, NULL, url, NULL, cbtable, NULL, config,
+                       pool));
+
+  /* Enough files to have several fetches pending at once. */
+  SVN_ERR(svn_ra_get_commit_editor3(session, &editor, &edit_baton,
+                                    apr_hash_make(pool),
+                                    NULL, NULL, NULL, TRUE, pool));
+  SVN_ERR(editor->open_root(edit_baton, SVN_INVALID_REVNUM,
+                            pool, &root_baton));
+  SVN_ERR(editor->add_directory("A", root_baton, NULL, SVN_INVALID_REVNUM,
+                                pool, &dir_baton));
+  for (i = 0; i < 30; i++)
+    {
+      svn_txdelta_window_handler_t handler;
+      void *handler_baton;
+      const char *name = apr_psprintf(pool, "A/f%d", i);
+      svn_string_t *text = svn_string_createf(pool, "contents of %s\n",
+                                              name);
+
+      SVN_ERR(editor->add_file(name, dir_baton, NULL, SVN_INVALID_REVNUM,
+                               pool, &file_baton));
+      SVN_ERR(editor->apply_textdelta(file_baton, NULL, pool,
+                                      &handler, &handler_baton));
+      SVN_ERR(svn_txdelta_send_string(text, handler, handler_baton, pool));
+      SVN_ERR(editor->close_file(file_baton, NULL, pool));
+    }
+  SVN_ERR(editor->close_directory(dir_baton, pool));
+  SVN_ERR(editor->close_directory(root_baton, pool));
+  SVN_ERR(editor->close_edit(edit_baton, pool));
+
+  cb.contents = apr_hash_make(pool);
+  cb.pool = pool;
+  collect_editor = svn_delta_default_editor(pool);
+  collect_editor->open_root = collect_open_root;
+  collect_editor->add_directory = collect_add_directory;
+  collect_editor->add_file = collect_add_file;
+  collect_editor->apply_textdelta = collect_apply_textdelta;
+  collect_editor->close_file = collect_close_file;
+
+  report_pool = svn_pool_create(pool);
+  SVN_ERR(svn_ra_do_update3(session,
+                            &reporter, &report_baton,
+                            1, "",
+                            svn_depth_infinity, FALSE, FALSE,
+                            collect_editor, &cb,
+                            report_pool, report_pool));
+  SVN_ERR(reporter->set_path(report_baton, "", 0, svn_depth_infinity, TRUE,
+                             NULL, report_pool));
+  SVN_ERR(reporter->finish_report(report_baton, report_pool));
+
+  /* The main session plus two fetch sessions. */
+  SVN_TEST_INT_ASSERT(b->open_count, 3);
+  svn_pool_destroy(report_pool);
+
+  SVN_TEST_INT_ASSERT(apr_hash_count(cb.contents), 30);
+  for (i = 0; i < 30; i++)
+    {
+      const char *name = apr_psprintf(pool, "A/f%d", i);
+      svn_stringbuf_t *text = svn_hash_gets(cb.contents, name);
+
+      SVN_TEST_ASSERT(text != NULL);
+      SVN_TEST_STRING_ASSERT(text->data,
+                             apr_psprintf(pool, "contents of %s\n", name));
+    }
+
+  return SVN_NO_ERROR;
+}
+
+/* Test that svnserve delivers large file contents intact, both when
+   reading them from the repository and from its caches. */
+
+static svn_error_t *
+tunnel_get_file(const svn_test_opts_t *opts,
+                apr_pool_t *pool)
+{
+  tunnel_baton_t *b;
+  svn_ra_session_t *session;
+  svn_string_t *text;
+  int i;
+
+  SVN_ERR(make_and_open_tunnel_repos(&session, &b, "test-get-file", NULL,
+                                     opts, pool));
+
+  /* Several protocol strings' worth of data. */
+  text = make_big_text(3 * 1024 * 1024 + 17, pool);
+  SVN_ERR(commit_file(session, "big", text, "prop",
+                      svn_string_create("value", pool), pool));
+
+  for (i = 0; i < 2; i++)
+    {
+      svn_stringbuf_t *fetched = svn_stringbuf_create_empty(pool);
+      svn_revnum_t fetched_rev;
+      apr_hash_t *props;
+      svn_string_t *value;
+
+      SVN_ERR(svn_ra_get_file(session, "big", SVN_INVALID_REVNUM,
+                              svn_stream_from_stringbuf(fetched, pool),
+                              &fetched_rev, &props, pool));
+      SVN_TEST_INT_ASSERT(fetched_rev, 1);
+      SVN_TEST_INT_ASSERT(fetched->len, text->len);
+      SVN_TEST_ASSERT(memcmp(fetched->data, text->data, text->len) == 0);
+
+      value = svn_hash_gets(props, "prop");
+      SVN_TEST_ASSERT(value);
+      SVN_TEST_STRING_ASSERT(value->data, "value");
+    }
+
+  return SVN_NO_ERROR;
+}
+
+/* Return an ra_svn connection reading from IN and writing to OUT. */
+static svn_ra_svn_conn_t *
+make_stream_conn(svn_stream_t *in,
+                 svn_stream_t *out,
+                 apr_pool_t *pool)
+{
+  return svn_ra_svn_create_conn5(NULL, in, out,
+                                 SVN_DELTA_COMPRESSION_LEVEL_NONE,
+                                 0, 0, 0, 0, pool);
+}
+
+/* Test that large strings written to an ra_svn connection go out after
+   and in order with the data buffered before them. */
+
+static svn_error_t *
+ra_svn_large_writes(const svn_test_opts_t *opts,
+                    apr_pool_t *pool)
+{
+  svn_stringbuf_t *out = svn_stringbuf_create_empty(pool);
+  svn_ra_svn_conn_t *conn;
+  svn_string_t *text = make_big_text(100000, pool);
+  svn_string_t *small = svn_string_create("small", pool);
+  svn_string_t *read_text, *read_small;
+  const char *word;
+  svn_stringbuf_t *expected;
+
+  conn = make_stream_conn(svn_stream_empty(pool),
+                          svn_stream_from_stringbuf(out, pool), pool);
+  SVN_ERR(svn_ra_svn__write_tuple(conn, pool, "w(ss)", "cmd", small, text));
+  SVN_ERR(svn_ra_svn__write_tuple(conn, pool, "w(ss)", "cmd2", text, small));
+  SVN_ERR(svn_ra_svn__flush(conn, pool));
+
+  expected = svn_stringbuf_create("( cmd ( 5:small 100000:", pool);
+  svn_stringbuf_appendbytes(expected, text->data, text->len);
+  svn_stringbuf_appendcstr(expected, " ) ) ( cmd2 ( 100000:");
+  svn_stringbuf_appendbytes(expected, text->data, text->len);
+  svn_stringbuf_appendcstr(expected, " 5:small ) ) ");
+  SVN_TEST_INT_ASSERT(out->len, expected->len);
+  SVN_TEST_ASSERT(memcmp(out->data, expected->data, out->len) == 0);
+
+  /* Read it back. */
+  conn = make_stream_conn(svn_stream_from_stringbuf(out, pool),
+                          svn_stream_empty(pool), pool);
+  SVN_ERR(svn_ra_svn__read_tuple_transient(conn, pool, "w(ss)", &word,
+                                           &read_small, &read_text));
+  SVN_TEST_STRING_ASSERT(word, "cmd");
+  SVN_TEST_ASSERT(svn_string_compare(read_small, small));
+  SVN_TEST_ASSERT(svn_string_compare(read_text, text));
+  SVN_ERR(svn_ra_svn__read_tuple(conn, pool, "w(ss)", &word,
+                                 &read_text, &read_small));
+  SVN_TEST_STRING_ASSERT(word, "cmd2");
+  SVN_TEST_ASSERT(svn_string_compare(read_small, small));
+  SVN_TEST_ASSERT(svn_string_compare(read_text, text));
+
+  return SVN_NO_ERROR;
+}
+
+/* Test svn_ra_svn__read_tuple_transient() with tuples that are fully
+   buffered, that cross read buffer refills and that exceed the buffer. */
+
+static svn_error_t *
+ra_svn_transient_tuples(const svn_test_opts_t *opts,
+                        apr_pool_t *pool)
+{
+  apr_pool_t *iterpool = svn_pool_create(pool);
+  svn_stringbuf_t *in = svn_stringbuf_create_empty(pool);
+  svn_ra_svn_conn_t *conn;
+  svn_string_t *text = make_big_text(3000, pool);
+  int i;
+
+  /* Strings of varying lengths, so that tuples end up straddling the
+     read buffer boundaries at different places. */
+  for (i = 0; i < 500; i++)
+    svn_stringbuf_appendcstr(in,
+                             apr_psprintf(pool, "( cmd%d ( %d:%.*s 0: ) ) ",
+                                          i, i * 7 % 3000,
+                                          i * 7 % 3000, text->data));
+  svn_stringbuf_appendcstr(in, "( last ( 3000:");
+  svn_stringbuf_appendbytes(in, text->data, text->len);
+  svn_stringbuf_appendcstr(in, " ) ) ");
+
+  conn = make_stream_conn(svn_stream_from_stringbuf(in, pool),
+                          svn_stream_empty(pool), pool);
+  for (i = 0; i < 500; i++)
+    {
+      const char *word;
+      const char *value;
+      svn_string_t *empty;
+
+      svn_pool_clear(iterpool);
+      SVN_ERR(svn_ra_svn__read_tuple_transient(conn, iterpool, "w(cs)",
+                                               &word, &value, &empty));
+      SVN_TEST_STRING_ASSERT(word, apr_psprintf(iterpool, "cmd%d", i));
+      SVN_TEST_STRING_ASSERT(value,
+                             apr_pstrndup(iterpool, text->data,
+                                          i * 7 % 3000));
+      SVN_TEST_INT_ASSERT(empty->len, 0);
+      SVN_TEST_STRING_ASSERT(empty->data, "");
+    }
+  svn_pool_destroy(iterpool);
+
+  /* A tuple larger than the read buffer. */
+  {
+    const char *word;
+    svn_string_t *value;
+
+    SVN_ERR(svn_ra_svn__read_tuple_transient(conn, pool, "w(s)",
+                                             &word, &value));
+    SVN_TEST_STRING_ASSERT(word, "last");
+    SVN_TEST_ASSERT(svn_string_compare(value, text));
+  }
+
+  return SVN_NO_ERROR;
+}
+
+/* Test that file contents and properties written by the editor drivers on
+   both sides of a tunnel arrive intact. */
+
+static svn_error_t *
+tunnel_large_editor_data(const svn_test_opts_t *opts,
+                         apr_pool_t *pool)
+{
+  tunnel_baton_t *b;
+  svn_ra_session_t *session;
+  svn_string_t *text = make_big_text(200000, pool);
+  svn_string_t *propval = make_big_text(50000, pool);
+  svn_stringbuf_t *fetched = svn_stringbuf_create_empty(pool);
+  const svn_ra_reporter3_t *reporter;
+  void *report_baton;
+  svn_delta_editor_t *collect_editor;
+  collect_baton_t cb;
+  apr_hash_t *props;
+  svn_string_t *value;
+
+  SVN_ERR(make_and_open_tunnel_repos(&session, &b, "test-large-editor-data",
+                                     NULL, opts, pool));
+
+  /* svnserve receives this through its commit editor driver. */
+  SVN_ERR(commit_file(session, "f", text, "big", propval, pool));
+
+  SVN_ERR(svn_ra_get_file(session, "f", 1,
+                          svn_stream_from_stringbuf(fetched, pool),
+                          NULL, &props, pool));
+  SVN_TEST_ASSERT(svn_string_compare(svn_string_create_from_buf(fetched,
+                                                                pool),
+                                     text));
+  value = svn_hash_gets(props, "big");
+  SVN_TEST_ASSERT(value && svn_string_compare(value, propval));
+
+  /* The client receives it through its update editor driver. */
+  cb.contents = apr_hash_make(pool);
+  cb.pool = pool;
+  collect_editor = svn_delta_default_editor(pool);
+  collect_editor->open_root = collect_open_root;
+  collect_editor->add_file = collect_add_file;
+  collect_editor->apply_textdelta = collect_apply_textdelta;
+  collect_editor->close_file = collect_close_file;
+
+  SVN_ERR(svn_ra_do_update3(session, &reporter, &report_baton,
+                            1, "", svn_depth_infinity, FALSE, FALSE,
+                            collect_editor, &cb, pool, pool));
+  SVN_ERR(reporter->set_path(report_baton, "", 0, svn_depth_infinity, TRUE,
+                             NULL, pool));
+  SVN_ERR(reporter->finish_report(report_baton, pool));
+
+  fetched = svn_hash_gets(cb.contents, "f");
+  SVN_TEST_ASSERT(fetched);
+  SVN_TEST_ASSERT(svn_string_compare(svn_string_create_from_buf(fetched,
+                                                                pool),
+                                     text));
+
+  return SVN_NO_ERROR;
+}
+
 /* Implements svn_log_entry_receiver_t for commit_empty_last_change */
 static svn_error_t *
 AA_receiver(void *baton,
@@ -1820,6 +2519,20 @@ static struct svn_test_descriptor_t test_funcs[] =
                        "check how last change applies to empty commit"),
     SVN_TEST_OPTS_PASS(commit_locked_file,
                        "check commit editor for a locked file"),
+    SVN_TEST_OPTS_PASS(tunnel_get_nodes,
+                       "fetch nodes through a pipelined tunnel"),
+    SVN_TEST_OPTS_PASS(tunnel_get_nodes_reuse,
+                       "reuse a tunnel after failed pipelined requests"),
+    SVN_TEST_OPTS_PASS(tunnel_parallel_update,
+                       "update over parallel tunnel connections"),
+    SVN_TEST_OPTS_PASS(tunnel_get_file,
+                       "fetch large file contents through a tunnel"),
+    SVN_TEST_OPTS_PASS(ra_svn_large_writes,
+                       "write large strings to an ra_svn connection"),
+    SVN_TEST_OPTS_PASS(ra_svn_transient_tuples,
+                       "parse ra_svn tuples without copying strings"),
+    SVN_TEST_OPTS_PASS(tunnel_large_editor_data,
+                       "send large editor data through a tunnel"),
     SVN_TEST_NULL
   };
 
@@ -0,0 +1,1103 @@
+/* ra-serf-test.c --- tests for the internals of libsvn_ra_serf
+ *
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ */
+
+#include <string.h>
+
+#include <apr_pools.h>
+#include <apr_strings.h>
+#include <apr_time.h>
+
+#include "../svn_test.h"
+
+#include "svn_checksum.h"
+#include "svn_dirent_uri.h"
+#include "svn_hash.h"
+#include "svn_io.h"
+#include "svn_pools.h"
+#include "svn_sorts.h"
+#include "svn_string.h"
+
+#include "private/svn_dav_protocol.h"
+
+#include "../../libsvn_ra_serf/ra_serf.h"
+#include "../../libsvn_ra_serf/binframe.h"
+#include "../../libsvn_ra_serf/blncache.h"
+#include "../../libsvn_ra_serf/contentcache.h"
+#include "../../libsvn_ra_serf/scheduler.h"
+
+
+
+/* Utility functions */
+
+/* Add an unconnected connection to SESS. */
+static svn_ra_serf__connection_t *
+add_connection(svn_ra_serf__session_t *sess)
+{
+  svn_ra_serf__connection_t *conn = apr_pcalloc(sess->pool, sizeof(*conn));
+
+  conn->session = sess;
+  sess->conns[sess->num_conns++] = conn;
+
+  return conn;
+}
+
+/* Return a session without network context that has NUM_CONNS
+   connections and may use up to MAX_CONNECTIONS.  Allocate it in POOL. */
+static svn_ra_serf__session_t *
+create_session(int num_conns,
+               int max_connections,
+               apr_pool_t *pool)
+{
+  svn_ra_serf__session_t *sess = apr_pcalloc(pool, sizeof(*sess));
+  int i;
+
+  sess->pool = pool;
+  sess->max_connections = max_connections;
+  for (i = 0; i < num_conns; i++)
+    add_connection(sess);
+
+  return sess;
+}
+
+/* Let the connections of SESS receive BYTES each. */
+static void
+receive(svn_ra_serf__session_t *sess,
+        apr_uint64_t bytes)
+{
+  int i;
+
+  for (i = 0; i < sess->num_conns; i++)
+    sess->conns[i]->bytes_received += bytes;
+}
+
+/* Advance *NOW by a quarter of a second, i.e. one throughput sample, and
+   let SCHED adapt to OUTSTANDING requests at that time.  Open a
+   connection in SESS if SCHED asks for it. */
+static void
+next_sample(svn_ra_serf__scheduler_t *sched,
+            svn_ra_serf__session_t *sess,
+            unsigned int outstanding,
+            apr_time_t *now)
+{
+  *now += apr_time_from_msec(250);
+  svn_ra_serf__scheduler_adapt(sched, sess, outstanding, *now);
+
+  if (sched->active_conns > sess->num_conns)
+    add_connection(sess);
+}
+
+/* Append a binary frame holding the LEN bytes of PAYLOAD to WIRE, the way
+   mod_dav_svn sends svndiff data in a framed update report. */
+static void
+append_frame(svn_stringbuf_t *wire,
+             const char *payload,
+             apr_size_t len)
+{
+  char header[SVN_DAV__BINARY_FRAME_HEADER_LEN];
+
+  header[0] = SVN_DAV__BINARY_FRAME_MARKER;
+  header[1] = (char)((len >> 24) & 0xff);
+  header[2] = (char)((len >> 16) & 0xff);
+  header[3] = (char)((len >> 8) & 0xff);
+  header[4] = (char)(len & 0xff);
+
+  svn_stringbuf_appendbytes(wire, header, sizeof(header));
+  svn_stringbuf_appendbytes(wire, payload, len);
+}
+
+/* Where collect_data() puts what the frame parser found. */
+typedef struct collect_baton_t
+{
+  svn_stringbuf_t *xml;
+  svn_stringbuf_t *payload;
+  int xml_calls;
+  int payload_calls;
+} collect_baton_t;
+
+/* Implements svn_ra_serf__binframe_data_t for the XML text. */
+static svn_error_t *
+collect_xml(void *baton,
+            const char *data,
+            apr_size_t len)
+{
+  collect_baton_t *cb = baton;
+
+  SVN_TEST_ASSERT(len > 0);
+  svn_stringbuf_appendbytes(cb->xml, data, len);
+  cb->xml_calls++;
+
+  return SVN_NO_ERROR;
+}
+
+/* Implements svn_ra_serf__binframe_data_t for the frame payloads. */
+static svn_error_t *
+collect_payload(void *baton,
+                const char *data,
+                apr_size_t len)
+{
+  collect_baton_t *cb = baton;
+
+  SVN_TEST_ASSERT(len > 0);
+  svn_stringbuf_appendbytes(cb->payload, data, len);
+  cb->payload_calls++;
+
+  return SVN_NO_ERROR;
+}
+
+/* Feed WIRE to a new frame parser in pieces of at most PIECE bytes and
+   return what it found in *CB, allocated in POOL.  Don't finish the
+   parse. */
+static svn_error_t *
+parse_wire(collect_baton_t *cb,
+           svn_ra_serf__binframe_parser_t **parser_p,
+           const svn_stringbuf_t *wire,
+           apr_size_t piece,
+           apr_pool_t *pool)
+{
+  svn_ra_serf__binframe_parser_t *parser;
+  apr_size_t offset;
+
+  cb->xml = svn_stringbuf_create_empty(pool);
+  cb->payload = svn_stringbuf_create_empty(pool);
+  cb->xml_calls = 0;
+  cb->payload_calls = 0;
+
+  parser = svn_ra_serf__binframe_parser_create(collect_xml, collect_payload,
+                                               cb, pool);
+
+  for (offset = 0; offset < wire->len; offset += piece)
+    SVN_ERR(svn_ra_serf__binframe_parse(parser, wire->data + offset,
+                                        MIN(piece, wire->len - offset)));
+
+  *parser_p = parser;
+  return SVN_NO_ERROR;
+}
+
+
+/* States of the XML parser tests. */
+enum
+{
+  ROOT = XML_STATE_INITIAL + 1,
+  ITEM,
+  NEST,
+  OTHER  /* No transitions leave this state. */
+};
+
+#define T_ "svn:test"
+static const svn_ra_serf__xml_transition_t test_ttable[] = {
+  { XML_STATE_INITIAL, T_, "root", ROOT,
+    FALSE, { NULL }, TRUE },
+
+  { ROOT, T_, "item", ITEM,
+    TRUE, { "name", "?opt", NULL }, TRUE },
+
+  { ROOT, T_, "*", OTHER,
+    FALSE, { NULL }, FALSE },
+
+  { ITEM, T_, "nest", NEST,
+    FALSE, { "depth", NULL }, TRUE },
+
+  { NEST, T_, "nest", NEST,
+    FALSE, { "depth", NULL }, TRUE },
+
+  { 0 }
+};
+
+/* Implements svn_ra_serf__xml_opened_t, logging elements that have no
+   close callback to the svn_stringbuf_t in BATON. */
+static svn_error_t *
+test_xml_opened(svn_ra_serf__xml_estate_t *xes,
+                void *baton,
+                int entered_state,
+                const svn_ra_serf__dav_props_t *tag,
+                apr_pool_t *scratch_pool)
+{
+  svn_stringbuf_t *log = baton;
+
+  if (entered_state == OTHER)
+    svn_stringbuf_appendcstr(log, apr_psprintf(scratch_pool,
+                                               "other {%s}%s\n",
+                                               tag->xmlns, tag->name));
+
+  return SVN_NO_ERROR;
+}
+
+/* Implements svn_ra_serf__xml_closed_t, logging what the parser collected
+   to the svn_stringbuf_t in BATON. */
+static svn_error_t *
+test_xml_closed(svn_ra_serf__xml_estate_t *xes,
+                void *baton,
+                int leaving_state,
+                const svn_string_t *cdata,
+                apr_hash_t *attrs,
+                apr_pool_t *scratch_pool)
+{
+  svn_stringbuf_t *log = baton;
+  const char *line;
+
+  if (leaving_state == ROOT)
+    {
+      line = "root\n";
+    }
+  else if (leaving_state == ITEM)
+    {
+      const char *opt = svn_hash_gets(attrs, "opt");
+      const char *max_depth = svn_hash_gets(attrs, "max-depth");
+
+      line = apr_psprintf(scratch_pool, "item %s %s [%s] %s\n",
+                          (const char *)svn_hash_gets(attrs, "name"),
+                          opt ? opt : "-", cdata->data,
+                          max_depth ? max_depth : "-");
+    }
+  else
+    {
+      apr_hash_t *gathered = svn_ra_serf__xml_gather_since(xes, ITEM);
+      const char *depth = svn_hash_gets(attrs, "depth");
+
+      /* The innermost element closes first. */
+      if (!svn_hash_gets(gathered, "max-depth"))
+        svn_ra_serf__xml_note(xes, ITEM, "max-depth", depth);
+
+      line = apr_psprintf(scratch_pool, "nest %s in %s\n", depth,
+                          (const char *)svn_hash_gets(gathered, "name"));
+    }
+
+  svn_stringbuf_appendcstr(log, line);
+  return SVN_NO_ERROR;
+}
+
+/* Parse the XML document TEXT with the transitions of TEST_TTABLE as if
+   it arrived as a response body in pieces of at most PIECE bytes.  Set
+   *LOG to what the callbacks saw, allocated in POOL. */
+static svn_error_t *
+parse_test_xml(svn_stringbuf_t **log,
+               const char *text,
+               apr_size_t piece,
+               apr_pool_t *pool)
+{
+  svn_ra_serf__session_t *sess = create_session(1, 1, pool);
+  serf_bucket_alloc_t *alloc = serf_bucket_allocator_create(pool, NULL,
+                                                            NULL);
+  svn_ra_serf__xml_context_t *xmlctx;
+  svn_ra_serf__handler_t *handler;
+  apr_size_t len = strlen(text);
+  apr_size_t offset = 0;
+
+  *log = svn_stringbuf_create_empty(pool);
+  xmlctx = svn_ra_serf__xml_context_create(test_ttable, test_xml_opened,
+                                           test_xml_closed, NULL, *log,
+                                           pool);
+  handler = svn_ra_serf__create_expat_handler(sess, xmlctx, NULL, pool);
+  handler->sline.code = 200;
+
+  while (1)
+    {
+      apr_size_t n = MIN(piece, len - offset);
+      svn_boolean_t at_eof = (offset + n == len);
+      serf_bucket_t *bucket;
+      svn_error_t *err;
+
+      if (at_eof)
+        bucket = serf_bucket_simple_create(text + offset, n, NULL, NULL,
+                                           alloc);
+      else
+        bucket = svn_ra_serf__create_bucket_with_eagain(text + offset, n,
+                                                        alloc);
+
+      err = handler->response_handler(NULL, bucket, handler->response_baton,
+                                      pool);
+      serf_bucket_destroy(bucket);
+
+      /* Once the handler has consumed the body, it passes on the status
+         of the bucket. */
+      if (err && err->apr_err == (at_eof ? APR_EOF : APR_EAGAIN))
+        svn_error_clear(err);
+      else if (err)
+        return svn_error_trace(err);
+
+      if (at_eof)
+        return SVN_NO_ERROR;
+
+      offset += n;
+    }
+}
+
+
+/* Add DATA to CACHE under its SHA-1 checksum, and return that in
+   *SHA1_P. */
+static svn_error_t *
+add_to_cache(svn_checksum_t **sha1_p,
+             svn_ra_serf__content_cache_t *cache,
+             const char *data,
+             apr_pool_t *pool)
+{
+  svn_stream_t *stream;
+  apr_size_t len = strlen(data);
+
+  SVN_ERR(svn_checksum(sha1_p, svn_checksum_sha1, data, len, pool));
+  SVN_ERR(svn_ra_serf__content_cache_put(&stream, cache, *sha1_p,
+                                         pool, pool));
+  SVN_ERR(svn_stream_write(stream, data, &len));
+  return svn_error_trace(svn_stream_close(stream));
+}
+
+/* Set *DATA_P to the cached fulltext SHA1 of CACHE, or to NULL if it is
+   not cached. */
+static svn_error_t *
+read_from_cache(const char **data_p,
+                svn_ra_serf__content_cache_t *cache,
+                const svn_checksum_t *sha1,
+                apr_pool_t *pool)
+{
+  svn_stream_t *contents;
+  svn_stringbuf_t *buf;
+
+  SVN_ERR(svn_ra_serf__content_cache_get(&contents, cache, sha1,
+                                         pool, pool));
+  if (!contents)
+    {
+      *data_p = NULL;
+      return SVN_NO_ERROR;
+    }
+
+  SVN_ERR(svn_stringbuf_from_stream(&buf, contents, 0, pool));
+  SVN_ERR(svn_stream_close(contents));
+
+  *data_p = buf->data;
+  return SVN_NO_ERROR;
+}
+
+/* Return a fulltext of 300 times C, allocated in POOL. */
+static const char *
+make_fulltext(char c,
+              apr_pool_t *pool)
+{
+  char *data = apr_palloc(pool, 301);
+
+  memset(data, c, 300);
+  data[300] = '\0';
+
+  return data;
+}
+
+/* Return the path of the cache entry for SHA1 in CACHE_DIR. */
+static const char *
+cache_entry_path(const char *cache_dir,
+                 const svn_checksum_t *sha1,
+                 apr_pool_t *pool)
+{
+  const char *hex = svn_checksum_to_cstring_display(sha1, pool);
+
+  return svn_dirent_join_many(pool, cache_dir, apr_pstrmemdup(pool, hex, 2),
+                              hex, SVN_VA_NULL);
+}
+
+
+
+/* Tests */
+
+static svn_error_t *
+pipeline_depth(apr_pool_t *pool)
+{
+  svn_ra_serf__session_t *sess = create_session(2, 4, pool);
+  svn_ra_serf__connection_t *conn = sess->conns[1];
+  svn_ra_serf__scheduler_t sched;
+
+  svn_ra_serf__scheduler_init(&sched, sess, apr_time_now());
+
+  /* Without measurements, we use a default depth. */
+  SVN_TEST_ASSERT(svn_ra_serf__scheduler_pipeline_depth(&sched, sess, conn)
+                  == 8);
+
+  /* 10 bytes/usec with 10ms latency and 10000 bytes per response:
+     10 responses are in transit, plus the one we receive. */
+  svn_ra_serf__scheduler_fetch_started(&sched, 1, TRUE);
+  svn_ra_serf__scheduler_fetch_done(&sched, conn, 1, TRUE, 10000, 1000);
+  conn->srtt = 10000;
+  SVN_TEST_ASSERT(svn_ra_serf__scheduler_pipeline_depth(&sched, sess, conn)
+                  == 11);
+
+  /* The depth grows with the latency. */
+  conn->srtt = 20000;
+  SVN_TEST_ASSERT(svn_ra_serf__scheduler_pipeline_depth(&sched, sess, conn)
+                  == 21);
+
+  /* Before the connection measured its own latency, the session's
+     initial measurement is used. */
+  conn->srtt = 0;
+  sess->conn_latency = 10000;
+  SVN_TEST_ASSERT(svn_ra_serf__scheduler_pipeline_depth(&sched, sess, conn)
+                  == 11);
+
+  /* Smaller responses need more of them in flight. */
+  svn_ra_serf__scheduler_fetch_started(&sched, 1, FALSE);
+  svn_ra_serf__scheduler_fetch_done(&sched, sess->conns[0], 1, FALSE,
+                                    0, 0);
+  SVN_TEST_ASSERT(svn_ra_serf__scheduler_pipeline_depth(&sched, sess, conn)
+                  == 21);
+
+  /* The depth is limited in both directions. */
+  conn->srtt = apr_time_from_sec(10);
+  SVN_TEST_ASSERT(svn_ra_serf__scheduler_pipeline_depth(&sched, sess, conn)
+                  == 32);
+  conn->srtt = 1;
+  SVN_TEST_ASSERT(svn_ra_serf__scheduler_pipeline_depth(&sched, sess, conn)
+                  == 2);
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+adapt_connections(apr_pool_t *pool)
+{
+  svn_ra_serf__session_t *sess = create_session(2, 4, pool);
+  svn_ra_serf__scheduler_t sched;
+  apr_time_t now = apr_time_now();
+  int samples;
+
+  svn_ra_serf__scheduler_init(&sched, sess, now);
+  SVN_TEST_ASSERT(sched.active_conns == 2);
+  SVN_TEST_ASSERT(sched.resume_count == 40);
+
+  /* Nothing happens before the first sample is complete. */
+  svn_ra_serf__scheduler_adapt(&sched, sess, 100, now);
+  SVN_TEST_ASSERT(sched.active_conns == 2);
+  SVN_TEST_ASSERT(sess->num_conns == 2);
+
+  /* With enough requests to keep it busy, we try another connection
+     once we know what the first ones achieve. */
+  receive(sess, 100000);
+  next_sample(&sched, sess, 100, &now);
+  SVN_TEST_ASSERT(sched.best_conns == 2);
+  SVN_TEST_ASSERT(sched.active_conns == 3);
+  SVN_TEST_ASSERT(sess->num_conns == 3);
+
+  /* The third connection made the transfer faster.  Try a fourth. */
+  receive(sess, 100000);
+  next_sample(&sched, sess, 100, &now);
+  SVN_TEST_ASSERT(sched.best_conns == 3);
+  SVN_TEST_ASSERT(sched.active_conns == 4);
+  SVN_TEST_ASSERT(sess->num_conns == 4);
+
+  /* ... and the resume limit keeps three pipelines busy. */
+  SVN_TEST_ASSERT(sched.resume_count == 2 * 2 * 8);
+
+  /* The fourth one split the bandwidth without adding to it.  It gets
+     retired, but stays open to finish its requests. */
+  receive(sess, 300000 / 4);
+  next_sample(&sched, sess, 100, &now);
+  SVN_TEST_ASSERT(sched.best_conns == 3);
+  SVN_TEST_ASSERT(sched.active_conns == 3);
+  SVN_TEST_ASSERT(sess->num_conns == 4);
+
+  /* We only try again after a while and then reuse the open one. */
+  for (samples = 1; sched.active_conns == 3; samples++)
+    {
+      SVN_TEST_ASSERT(samples <= 8);
+
+      receive(sess, 300000 / 4);
+      next_sample(&sched, sess, 100, &now);
+    }
+  SVN_TEST_ASSERT(samples == 8);
+  SVN_TEST_ASSERT(sched.active_conns == 4);
+  SVN_TEST_ASSERT(sess->num_conns == 4);
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+adapt_connections_idle(apr_pool_t *pool)
+{
+  svn_ra_serf__session_t *sess = create_session(2, 4, pool);
+  svn_ra_serf__scheduler_t sched;
+  apr_time_t now = apr_time_now();
+
+  svn_ra_serf__scheduler_init(&sched, sess, now);
+
+  /* Our one auxiliary connection could use 8 requests.  With fewer
+     outstanding, neither the sample counts nor do we add connections. */
+  receive(sess, 100000);
+  next_sample(&sched, sess, 4, &now);
+  SVN_TEST_ASSERT(sched.best_conns == 0);
+  SVN_TEST_ASSERT(sched.active_conns == 2);
+  SVN_TEST_ASSERT(sched.resume_count == 16);
+
+  receive(sess, 100000);
+  next_sample(&sched, sess, 8, &now);
+  SVN_TEST_ASSERT(sched.best_conns == 2);
+  SVN_TEST_ASSERT(sched.active_conns == 2);
+
+  /* We never exceed the configured number of connections. */
+  sess->max_connections = 2;
+  receive(sess, 100000);
+  next_sample(&sched, sess, 100, &now);
+  SVN_TEST_ASSERT(sched.active_conns == 2);
+  SVN_TEST_ASSERT(sess->num_conns == 2);
+
+  /* With http/2, the first connection is all we need. */
+  sess->http20 = TRUE;
+  sess->max_connections = 4;
+  svn_ra_serf__scheduler_init(&sched, sess, now);
+  SVN_TEST_ASSERT(sched.active_conns == 1);
+  receive(sess, 100000);
+  next_sample(&sched, sess, 1000, &now);
+  SVN_TEST_ASSERT(sched.active_conns == 1);
+  SVN_TEST_ASSERT(sched.resume_count == 256);
+  SVN_TEST_ASSERT(svn_ra_serf__scheduler_pick(&sched, sess, NULL, 1, TRUE)
+                  == 0);
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+bulk_pending(apr_pool_t *pool)
+{
+  svn_ra_serf__session_t *sess = create_session(3, 4, pool);
+  svn_ra_serf__scheduler_t sched;
+  unsigned int pending[3] = { 0, 2, 2 };
+
+  svn_ra_serf__scheduler_init(&sched, sess, apr_time_now());
+
+  /* A fulltext on the first auxiliary connection... */
+  SVN_TEST_ASSERT(svn_ra_serf__scheduler_pick(&sched, sess, pending, 1, TRUE)
+                  == 1);
+  svn_ra_serf__scheduler_fetch_started(&sched, 1, TRUE);
+  SVN_TEST_ASSERT(sched.bulk_pending[1] == 1);
+
+  /* ... keeps small requests away, even if it has fewer requests queued,
+     but not other fulltexts. */
+  pending[2] = 3;
+  SVN_TEST_ASSERT(svn_ra_serf__scheduler_pick(&sched, sess, pending, 1, FALSE)
+                  == 2);
+  SVN_TEST_ASSERT(svn_ra_serf__scheduler_pick(&sched, sess, pending, 1, TRUE)
+                  == 1);
+
+  /* The same applies if we only cycle through the connections. */
+  sched.cur_conn = 1;
+  SVN_TEST_ASSERT(svn_ra_serf__scheduler_pick(&sched, sess, NULL, 1, FALSE)
+                  == 2);
+  sched.cur_conn = 1;
+  SVN_TEST_ASSERT(svn_ra_serf__scheduler_pick(&sched, sess, NULL, 1, TRUE)
+                  == 1);
+
+  /* Once the fulltext arrived, the connection is fine again. */
+  svn_ra_serf__scheduler_fetch_done(&sched, sess->conns[1], 1, TRUE,
+                                    1000, 100);
+  SVN_TEST_ASSERT(sched.bulk_pending[1] == 0);
+  SVN_TEST_ASSERT(sched.bytes_fetched == 1000);
+  SVN_TEST_ASSERT(sched.fetches_done == 1);
+  SVN_TEST_ASSERT(sess->conns[1]->bytes_received == 1000);
+  SVN_TEST_ASSERT(sess->conns[1]->transfer_time == 100);
+  SVN_TEST_ASSERT(svn_ra_serf__scheduler_pick(&sched, sess, pending, 1, FALSE)
+                  == 1);
+
+  /* Deltas are not counted as fulltexts. */
+  svn_ra_serf__scheduler_fetch_started(&sched, 2, FALSE);
+  SVN_TEST_ASSERT(sched.bulk_pending[2] == 0);
+  svn_ra_serf__scheduler_fetch_done(&sched, sess->conns[2], 2, FALSE,
+                                    10, 1);
+  SVN_TEST_ASSERT(sched.bulk_pending[2] == 0);
+
+  /* The first connection is used once the caller allows it. */
+  pending[1] = 1;
+  SVN_TEST_ASSERT(svn_ra_serf__scheduler_pick(&sched, sess, pending, 0, FALSE)
+                  == 0);
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+xml_transitions(apr_pool_t *pool)
+{
+  const char *doc =
+    "<?xml version=\"1.0\" encoding=\"utf-8\"?>\n"
+    "<T:root xmlns:T=\"" T_ "\" xmlns:O=\"other:ns\">\n"
+    " <T:item name=\"a\" opt=\"x\">one</T:item>\n"
+    " <O:item name=\"z\">skipped<T:item name=\"y\"/></O:item>\n"
+    " <T:misc><T:item name=\"w\">skipped</T:item></T:misc>\n"
+    " <T:item name=\"b\">two<T:junk>skipped<T:nest/></T:junk>!</T:item>\n"
+    " <item xmlns=\"" T_ "\" name=\"c\">&lt;three&gt;</item>\n"
+    "</T:root>\n";
+  const char *expected =
+    "item a x [one] -\n"
+    "other {other:ns}item\n"
+    "other {" T_ "}misc\n"
+    "item b - [two!] -\n"
+    "item c - [<three>] -\n"
+    "root\n";
+  apr_pool_t *iterpool = svn_pool_create(pool);
+  apr_size_t piece;
+
+  /* Transitions are taken in table order, so the wildcard only catches
+     what the specific transition before it doesn't; elements without a
+     transition are skipped with everything inside them. */
+  for (piece = 1; piece <= strlen(doc); piece++)
+    {
+      svn_stringbuf_t *log;
+
+      svn_pool_clear(iterpool);
+
+      SVN_ERR(parse_test_xml(&log, doc, piece, iterpool));
+      SVN_TEST_STRING_ASSERT(log->data, expected);
+    }
+
+  svn_pool_destroy(iterpool);
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+xml_state_pools(apr_pool_t *pool)
+{
+  svn_stringbuf_t *doc = svn_stringbuf_create(
+                           "<T:root xmlns:T=\"" T_ "\">", pool);
+  svn_stringbuf_t *expected = svn_stringbuf_create_empty(pool);
+  apr_pool_t *iterpool = svn_pool_create(pool);
+  int i, j;
+
+  /* Use more state pools at once, and more pools in a row, than the
+     parser keeps around for reuse.  Data that outer states collected
+     must survive the inner states and their pools. */
+  for (i = 0; i < 40; i++)
+    {
+      svn_stringbuf_appendcstr(doc, apr_psprintf(pool,
+                                                 "<T:item name=\"i%d\">", i));
+      for (j = 1; j <= i; j++)
+        svn_stringbuf_appendcstr(doc, apr_psprintf(pool,
+                                                   "<T:nest depth=\"%d\">",
+                                                   j));
+      svn_stringbuf_appendcstr(doc, apr_psprintf(pool, "c%d", i));
+      for (j = i; j >= 1; j--)
+        {
+          svn_stringbuf_appendcstr(doc, "</T:nest>");
+          svn_stringbuf_appendcstr(expected,
+                                   apr_psprintf(pool, "nest %d in i%d\n",
+                                                j, i));
+        }
+      svn_stringbuf_appendcstr(doc, "</T:item>");
+
+      if (i > 0)
+        svn_stringbuf_appendcstr(expected,
+                                 apr_psprintf(pool, "item i%d - [c%d] %d\n",
+                                              i, i, i));
+      else
+        svn_stringbuf_appendcstr(expected, "item i0 - [c0] -\n");
+    }
+  svn_stringbuf_appendcstr(doc, "</T:root>");
+  svn_stringbuf_appendcstr(expected, "root\n");
+
+  for (i = 1; i <= 101; i += 50)
+    {
+      svn_stringbuf_t *log;
+
+      svn_pool_clear(iterpool);
+
+      SVN_ERR(parse_test_xml(&log, doc->data, i, iterpool));
+      SVN_TEST_STRING_ASSERT(log->data, expected->data);
+    }
+
+  svn_pool_destroy(iterpool);
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+xml_errors(apr_pool_t *pool)
+{
+  svn_stringbuf_t *log;
+
+  SVN_TEST_ASSERT_ERROR(
+    parse_test_xml(&log, "<T:wrong xmlns:T=\"" T_ "\"/>", 100, pool),
+    SVN_ERR_XML_UNEXPECTED_ELEMENT);
+
+  SVN_TEST_ASSERT_ERROR(
+    parse_test_xml(&log, "<T:root xmlns:T=\"" T_ "\"><T:item opt=\"x\"/>"
+                         "</T:root>", 100, pool),
+    SVN_ERR_XML_ATTRIB_NOT_FOUND);
+
+  SVN_TEST_ASSERT_ERROR(
+    parse_test_xml(&log, "<T:root xmlns:T=\"" T_ "\"><T:item name=\"a\">",
+                   5, pool),
+    SVN_ERR_RA_DAV_MALFORMED_DATA);
+
+  SVN_TEST_ASSERT_ERROR(
+    parse_test_xml(&log, "<T:root xmlns:T=\"" T_ "\"></T:item></T:root>",
+                   5, pool),
+    SVN_ERR_RA_DAV_MALFORMED_DATA);
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+content_cache_verify(apr_pool_t *pool)
+{
+  const char *cache_dir;
+  svn_ra_serf__content_cache_t *cache;
+  svn_checksum_t *sha1;
+  svn_checksum_t *wrong_sha1;
+  svn_stream_t *stream;
+  const char *data;
+  svn_node_kind_t kind;
+  apr_size_t len;
+
+  SVN_ERR(svn_test_make_sandbox_dir(&cache_dir, "ra-serf-content-cache",
+                                    pool));
+  svn_ra_serf__content_cache_create(&cache, cache_dir, 0, pool);
+
+  SVN_ERR(add_to_cache(&sha1, cache, "alpha\n", pool));
+  SVN_ERR(read_from_cache(&data, cache, sha1, pool));
+  SVN_TEST_STRING_ASSERT(data, "alpha\n");
+
+  /* Data that doesn't match its key is not added. */
+  SVN_ERR(svn_checksum(&wrong_sha1, svn_checksum_sha1, "beta\n", 5, pool));
+  SVN_ERR(svn_ra_serf__content_cache_put(&stream, cache, wrong_sha1,
+                                         pool, pool));
+  len = 6;
+  SVN_ERR(svn_stream_write(stream, "gamma\n", &len));
+  SVN_ERR(svn_stream_close(stream));
+  SVN_ERR(read_from_cache(&data, cache, wrong_sha1, pool));
+  SVN_TEST_ASSERT(data == NULL);
+
+  /* An entry damaged on disk is a miss, and gets removed... */
+  SVN_ERR(svn_io_remove_file2(cache_entry_path(cache_dir, sha1, pool),
+                              FALSE, pool));
+  SVN_ERR(svn_io_file_create(cache_entry_path(cache_dir, sha1, pool),
+                             "alphx\n", pool));
+  SVN_ERR(read_from_cache(&data, cache, sha1, pool));
+  SVN_TEST_ASSERT(data == NULL);
+  SVN_ERR(svn_io_check_path(cache_entry_path(cache_dir, sha1, pool),
+                            &kind, pool));
+  SVN_TEST_ASSERT(kind == svn_node_none);
+
+  /* ... so that the refetched fulltext can take its place. */
+  SVN_ERR(add_to_cache(&sha1, cache, "alpha\n", pool));
+  SVN_ERR(read_from_cache(&data, cache, sha1, pool));
+  SVN_TEST_STRING_ASSERT(data, "alpha\n");
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+content_cache_trim(apr_pool_t *pool)
+{
+  const char *cache_dir;
+  svn_ra_serf__content_cache_t *cache;
+  svn_checksum_t *sha1[4];
+  const char *data;
+  apr_time_t then = apr_time_now() - apr_time_from_sec(3600);
+  int i;
+
+  SVN_ERR(svn_test_make_sandbox_dir(&cache_dir, "ra-serf-content-trim",
+                                    pool));
+  svn_ra_serf__content_cache_create(&cache, cache_dir, 1000, pool);
+
+  /* Three entries of 300 bytes fit.  Pretend that they were last used
+     an hour ago, one second after the other, and use the first one
+     again now. */
+  for (i = 0; i < 3; i++)
+    {
+      SVN_ERR(add_to_cache(&sha1[i], cache, make_fulltext('a' + i, pool),
+                           pool));
+      SVN_ERR(svn_io_set_file_affected_time(
+                then + apr_time_from_sec(i),
+                cache_entry_path(cache_dir, sha1[i], pool), pool));
+    }
+
+  SVN_ERR(read_from_cache(&data, cache, sha1[0], pool));
+  SVN_TEST_STRING_ASSERT(data, make_fulltext('a', pool));
+
+  /* A fourth one pushes the cache over its limit.  The least recently
+     used entries go, until the cache is at three quarters of it. */
+  SVN_ERR(add_to_cache(&sha1[3], cache, make_fulltext('d', pool), pool));
+
+  SVN_ERR(read_from_cache(&data, cache, sha1[0], pool));
+  SVN_TEST_ASSERT(data != NULL);
+  SVN_ERR(read_from_cache(&data, cache, sha1[1], pool));
+  SVN_TEST_ASSERT(data == NULL);
+  SVN_ERR(read_from_cache(&data, cache, sha1[2], pool));
+  SVN_TEST_ASSERT(data == NULL);
+  SVN_ERR(read_from_cache(&data, cache, sha1[3], pool));
+  SVN_TEST_ASSERT(data != NULL);
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+binframe_wire_format(apr_pool_t *pool)
+{
+  svn_stringbuf_t *wire = svn_stringbuf_create_empty(pool);
+  svn_stringbuf_t *big = svn_stringbuf_create_empty(pool);
+  svn_stringbuf_t *expected_payload = svn_stringbuf_create_empty(pool);
+  const char *expected_xml;
+  apr_pool_t *iterpool = svn_pool_create(pool);
+  apr_size_t piece;
+  int i;
+
+  /* A payload that needs more than one length byte and contains the
+     marker byte itself. */
+  for (i = 0; i < 300; i++)
+    svn_stringbuf_appendbyte(big, (char)i);
+
+  /* The length is big-endian and follows the marker byte. */
+  svn_stringbuf_appendcstr(wire, "<S:txdelta>");
+  svn_stringbuf_appendbytes(wire, "\0\0\0\0\4SVN\1", 9);
+  append_frame(wire, big->data, big->len);
+  append_frame(wire, "", 0);
+  svn_stringbuf_appendcstr(wire, "</S:txdelta><S:txdelta>");
+  append_frame(wire, "SVN\0", 4);
+  svn_stringbuf_appendcstr(wire, "</S:txdelta>");
+
+  expected_xml = "<S:txdelta></S:txdelta><S:txdelta></S:txdelta>";
+  svn_stringbuf_appendbytes(expected_payload, "SVN\1", 4);
+  svn_stringbuf_appendstr(expected_payload, big);
+  svn_stringbuf_appendbytes(expected_payload, "SVN\0", 4);
+
+  /* Frames and headers may be split anywhere by the network. */
+  for (piece = 1; piece <= wire->len; piece++)
+    {
+      collect_baton_t cb;
+      svn_ra_serf__binframe_parser_t *parser;
+
+      svn_pool_clear(iterpool);
+
+      SVN_ERR(parse_wire(&cb, &parser, wire, piece, iterpool));
+      SVN_ERR(svn_ra_serf__binframe_finish(parser));
+
+      SVN_TEST_STRING_ASSERT(cb.xml->data, expected_xml);
+      SVN_TEST_ASSERT(svn_stringbuf_compare(cb.payload, expected_payload));
+    }
+
+  /* In one piece, each run of XML and each frame is passed on in one
+     call. */
+  {
+    collect_baton_t cb;
+    svn_ra_serf__binframe_parser_t *parser;
+
+    SVN_ERR(parse_wire(&cb, &parser, wire, wire->len, iterpool));
+    SVN_TEST_INT_ASSERT(cb.xml_calls, 3);
+    SVN_TEST_INT_ASSERT(cb.payload_calls, 3);
+  }
+
+  svn_pool_destroy(iterpool);
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+binframe_truncated(apr_pool_t *pool)
+{
+  svn_stringbuf_t *wire = svn_stringbuf_create("<S:txdelta>", pool);
+  collect_baton_t cb;
+  svn_ra_serf__binframe_parser_t *parser;
+
+  append_frame(wire, "SVN\1", 4);
+
+  /* Within the frame header ... */
+  SVN_ERR(parse_wire(&cb, &parser,
+                     svn_stringbuf_ncreate(wire->data, 14, pool), 4, pool));
+  SVN_TEST_ASSERT_ERROR(svn_ra_serf__binframe_finish(parser),
+                        SVN_ERR_RA_DAV_MALFORMED_DATA);
+
+  /* ... within the payload ... */
+  SVN_ERR(parse_wire(&cb, &parser,
+                     svn_stringbuf_ncreate(wire->data, wire->len - 1, pool),
+                     4, pool));
+  SVN_TEST_ASSERT_ERROR(svn_ra_serf__binframe_finish(parser),
+                        SVN_ERR_RA_DAV_MALFORMED_DATA);
+  SVN_TEST_STRING_ASSERT(cb.xml->data, "<S:txdelta>");
+  SVN_TEST_INT_ASSERT(cb.payload->len, 3);
+
+  /* ... but not right after it. */
+  SVN_ERR(parse_wire(&cb, &parser, wire, 4, pool));
+  SVN_ERR(svn_ra_serf__binframe_finish(parser));
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+binframe_content_type(apr_pool_t *pool)
+{
+  SVN_TEST_ASSERT(svn_ra_serf__binframe_content_type_p(
+                    SVN_DAV__FRAMED_REPORT_MIME_TYPE));
+  SVN_TEST_ASSERT(svn_ra_serf__binframe_content_type_p(
+                    "Application/VND.svn-framed-report"));
+  SVN_TEST_ASSERT(svn_ra_serf__binframe_content_type_p(
+                    SVN_DAV__FRAMED_REPORT_MIME_TYPE "; charset=utf-8"));
+
+  /* A server that doesn't support binary txdeltas sends plain XML. */
+  SVN_TEST_ASSERT(!svn_ra_serf__binframe_content_type_p(NULL));
+  SVN_TEST_ASSERT(!svn_ra_serf__binframe_content_type_p(""));
+  SVN_TEST_ASSERT(!svn_ra_serf__binframe_content_type_p(
+                    "text/xml; charset=\"utf-8\""));
+  SVN_TEST_ASSERT(!svn_ra_serf__binframe_content_type_p(
+                    "application/vnd.svn-framed"));
+  SVN_TEST_ASSERT(!svn_ra_serf__binframe_content_type_p(
+                    SVN_DAV__FRAMED_REPORT_MIME_TYPE "+xml"));
+
+  return SVN_NO_ERROR;
+}
+
+
+static svn_error_t *
+blncache_persist(apr_pool_t *pool)
+{
+  const char *cache_dir;
+  const char *path;
+  svn_ra_serf__blncache_t *cache1;
+  svn_ra_serf__blncache_t *cache2;
+  const char *bc_url;
+  svn_revnum_t revision;
+  svn_stringbuf_t *contents;
+
+  SVN_ERR(svn_test_make_sandbox_dir(&cache_dir, "ra-serf-blncache", pool));
+  path = svn_dirent_join_many(pool, cache_dir, "sub", "cache", SVN_VA_NULL);
+
+  SVN_ERR(svn_ra_serf__blncache_create(&cache1, pool));
+  SVN_ERR(svn_ra_serf__blncache_persist(cache1, path, pool));
+  SVN_ERR(svn_ra_serf__blncache_set(cache1, "/repo/!svn/bln/5", 5,
+                                    "/repo/!svn/bc/5", pool));
+  SVN_ERR(svn_ra_serf__blncache_set(cache1, NULL, 3,
+                                    "/repo/!svn/bc/3", pool));
+
+  /* Each new entry is appended, known ones are not written again. */
+  SVN_ERR(svn_ra_serf__blncache_set(cache1, NULL, 5,
+                                    "/repo/!svn/bc/5", pool));
+  SVN_ERR(svn_stringbuf_from_file2(&contents, path, pool));
+  SVN_TEST_STRING_ASSERT(contents->data,
+                         "5 /repo/!svn/bc/5 /repo/!svn/bln/5\n"
+                         "3 /repo/!svn/bc/3\n");
+
+  /* Another session finds them. */
+  SVN_ERR(svn_ra_serf__blncache_create(&cache2, pool));
+  SVN_ERR(svn_ra_serf__blncache_persist(cache2, path, pool));
+  SVN_ERR(svn_ra_serf__blncache_get_bc_url(&bc_url, cache2, 3, pool));
+  SVN_TEST_STRING_ASSERT(bc_url, "/repo/!svn/bc/3");
+  SVN_ERR(svn_ra_serf__blncache_get_baseline_info(&bc_url, &revision, cache2,
+                                                  "/repo/!svn/bln/5", pool));
+  SVN_TEST_STRING_ASSERT(bc_url, "/repo/!svn/bc/5");
+  SVN_TEST_INT_ASSERT(revision, 5);
+
+  /* Entries added by one session are seen by sessions started later. */
+  SVN_ERR(svn_ra_serf__blncache_set(cache2, NULL, 7,
+                                    "/repo/!svn/bc/7", pool));
+  SVN_ERR(svn_ra_serf__blncache_create(&cache1, pool));
+  SVN_ERR(svn_ra_serf__blncache_persist(cache1, path, pool));
+  SVN_ERR(svn_ra_serf__blncache_get_bc_url(&bc_url, cache1, 7, pool));
+  SVN_TEST_STRING_ASSERT(bc_url, "/repo/!svn/bc/7");
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+blncache_damaged(apr_pool_t *pool)
+{
+  const char *cache_dir;
+  const char *path;
+  svn_ra_serf__blncache_t *cache;
+  const char *bc_url;
+  svn_revnum_t revision;
+  svn_stringbuf_t *contents;
+  svn_node_kind_t kind;
+  int i;
+
+  SVN_ERR(svn_test_make_sandbox_dir(&cache_dir, "ra-serf-blncache-damaged",
+                                    pool));
+  path = svn_dirent_join(cache_dir, "cache", pool);
+
+  /* Lines we can't parse, like one cut short, are skipped. */
+  SVN_ERR(svn_io_file_create(path,
+                             "junk\n"
+                             "4 /repo/!svn/bc/4\n"
+                             "-1 /repo/!svn/bc/x\n"
+                             "6 /repo/!svn/bc/6 /repo/!svn/bln/6\n"
+                             "8", pool));
+  SVN_ERR(svn_ra_serf__blncache_create(&cache, pool));
+  SVN_ERR(svn_ra_serf__blncache_persist(cache, path, pool));
+  SVN_ERR(svn_ra_serf__blncache_get_bc_url(&bc_url, cache, 4, pool));
+  SVN_TEST_STRING_ASSERT(bc_url, "/repo/!svn/bc/4");
+  SVN_ERR(svn_ra_serf__blncache_get_baseline_info(&bc_url, &revision, cache,
+                                                  "/repo/!svn/bln/6", pool));
+  SVN_TEST_STRING_ASSERT(bc_url, "/repo/!svn/bc/6");
+  SVN_ERR(svn_ra_serf__blncache_get_bc_url(&bc_url, cache, 8, pool));
+  SVN_TEST_ASSERT(bc_url == NULL);
+
+  /* A file with more lines than the cache holds is started over. */
+  contents = svn_stringbuf_create_empty(pool);
+  for (i = 1; i <= 1001; i++)
+    svn_stringbuf_appendcstr(contents,
+                             apr_psprintf(pool, "%d /repo/!svn/bc/%d\n",
+                                          i, i));
+  SVN_ERR(svn_io_remove_file2(path, FALSE, pool));
+  SVN_ERR(svn_io_file_create(path, contents->data, pool));
+
+  SVN_ERR(svn_ra_serf__blncache_create(&cache, pool));
+  SVN_ERR(svn_ra_serf__blncache_persist(cache, path, pool));
+  SVN_ERR(svn_ra_serf__blncache_get_bc_url(&bc_url, cache, 1, pool));
+  SVN_TEST_ASSERT(bc_url == NULL);
+  SVN_ERR(svn_io_check_path(path, &kind, pool));
+  SVN_TEST_ASSERT(kind == svn_node_none);
+
+  SVN_ERR(svn_ra_serf__blncache_set(cache, NULL, 2, "/repo/!svn/bc/2",
+                                    pool));
+  SVN_ERR(svn_stringbuf_from_file2(&contents, path, pool));
+  SVN_TEST_STRING_ASSERT(contents->data, "2 /repo/!svn/bc/2\n");
+
+  return SVN_NO_ERROR;
+}
+
+
+/* The test table.  */
+
+static int max_threads = 1;
+
+static struct svn_test_descriptor_t test_funcs[] =
+  {
+    SVN_TEST_NULL,
+    SVN_TEST_PASS2(pipeline_depth,
+                   "size pipelines by bandwidth-delay product"),
+    SVN_TEST_PASS2(adapt_connections,
+                   "add connections while they gain throughput"),
+    SVN_TEST_PASS2(adapt_connections_idle,
+                   "don't add connections without enough work"),
+    SVN_TEST_PASS2(bulk_pending,
+                   "steer small requests around fulltexts"),
+    SVN_TEST_PASS2(xml_transitions,
+                   "dispatch XML elements by transition table"),
+    SVN_TEST_PASS2(xml_state_pools,
+                   "keep XML state data across reused pools"),
+    SVN_TEST_PASS2(xml_errors,
+                   "reject unexpected XML"),
+    SVN_TEST_PASS2(content_cache_verify,
+                   "verify content cache entries"),
+    SVN_TEST_PASS2(content_cache_trim,
+                   "trim the content cache to its size limit"),
+    SVN_TEST_PASS2(binframe_wire_format,
+                   "split binary txdelta frames from the XML"),
+    SVN_TEST_PASS2(binframe_truncated,
+                   "detect truncated binary txdelta frames"),
+    SVN_TEST_PASS2(binframe_content_type,
+                   "recognize framed update reports"),
+    SVN_TEST_PASS2(blncache_persist,
+                   "share baseline information between sessions"),
+    SVN_TEST_PASS2(blncache_damaged,
+                   "skip damaged baseline cache entries"),
+    SVN_TEST_NULL
+  };
+
+SVN_TEST_MAIN
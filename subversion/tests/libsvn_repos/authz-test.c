@@ -23,8 +23,11 @@
 #include <apr_fnmatch.h>
 
 #include "svn_pools.h"
+#include "svn_dirent_uri.h"
+#include "svn_io.h"
 #include "svn_iter.h"
 #include "svn_hash.h"
+#include "private/svn_repos_private.h"
 #include "private/svn_subr_private.h"
 
 #include "../../libsvn_repos/authz.h"
@@ -511,6 +514,258 @@ reposful_reposless_stanzas_inherit(apr_pool_t *pool)
    return SVN_NO_ERROR;
 }
 
+static svn_error_t *
+test_authz_serialize(apr_pool_t *pool)
+{
+  const char rules[] =
+    "[aliases]"                              NL
+    "x = luser"                              NL
+    ""                                       NL
+    "[groups]"                               NL
+    "g1 = &x, userA"                         NL
+    "g2 = userB, @g1"                        NL
+    ""                                       NL
+    "[/]"                                    NL
+    "* = r"                                  NL
+    "~@g2 = "                                NL
+    ""                                       NL
+    "[repo:/trunk]"                          NL
+    "@g1 = rw"                               NL
+    "$anonymous ="                           NL
+    ""                                       NL
+    "[:glob:/**/sec*]"                       NL
+    "@g2 ="                                  NL
+    "userB = r"                              NL
+    ""                                       NL
+    "[:glob:repo:/branches/*/*.c]"           NL
+    "$authenticated = rw"                    NL;
+
+  const char *users[] = { NULL, "luser", "userA", "userB", "userC", "" };
+  const char *repos[] = { "repo", "other", NULL };
+  const char *paths[] = { "/", "/trunk", "/trunk/secret", "/branches/b/x.c",
+                          "/branches/b/x.h", "/tags/sec", NULL };
+  const svn_repos_authz_access_t accesses[] =
+    { svn_authz_read, svn_authz_write,
+      svn_authz_read | svn_authz_recursive,
+      svn_authz_write | svn_authz_recursive };
+
+  svn_stringbuf_t *buf = svn_stringbuf_create(rules, pool);
+  svn_stringbuf_t *serialized = svn_stringbuf_create_empty(pool);
+  svn_authz_t *authz;
+  svn_authz_t *loaded = apr_pcalloc(pool, sizeof(*loaded));
+  apr_size_t u, r, p, a;
+
+  SVN_ERR(svn_repos_authz_parse(&authz, svn_stream_from_stringbuf(buf, pool),
+                                NULL, pool));
+
+  SVN_ERR(svn_authz__serialize(svn_stream_from_stringbuf(serialized, pool),
+                               authz->full, pool));
+  loaded->pool = pool;
+  SVN_ERR(svn_authz__deserialize(&loaded->full,
+                                 svn_stream_from_stringbuf(serialized, pool),
+                                 pool, pool));
+  SVN_TEST_ASSERT(loaded->full->acls->nelts == authz->full->acls->nelts);
+
+  /* The loaded model must make the same decisions as the parsed one. */
+  for (u = 0; u < sizeof(users) / sizeof(users[0]); ++u)
+    for (r = 0; r < sizeof(repos) / sizeof(repos[0]); ++r)
+      for (p = 0; paths[p]; ++p)
+        for (a = 0; a < sizeof(accesses) / sizeof(accesses[0]); ++a)
+          {
+            svn_boolean_t expected, actual;
+
+            SVN_ERR(svn_repos_authz_check_access(authz, repos[r], paths[p],
+                                                 users[u], accesses[a],
+                                                 &expected, pool));
+            SVN_ERR(svn_repos_authz_check_access(loaded, repos[r], paths[p],
+                                                 users[u], accesses[a],
+                                                 &actual, pool));
+            if (expected != actual)
+              return svn_error_createf(SVN_ERR_TEST_FAILED, NULL,
+                                       "Access %d to %s:%s for user %s "
+                                       "differs after deserialization",
+                                       (int)accesses[a],
+                                       repos[r] ? repos[r] : "(none)",
+                                       paths[p],
+                                       users[u] ? users[u] : "(anonymous)");
+          }
+
+  /* Truncated data must be rejected. */
+  serialized->len /= 2;
+  SVN_TEST_ASSERT_ANY_ERROR(svn_authz__deserialize(
+                              &loaded->full,
+                              svn_stream_from_stringbuf(serialized, pool),
+                              pool, pool));
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+test_authz_cache_dir(apr_pool_t *pool)
+{
+  const char rules[] =
+    "[/]"                                    NL
+    "* = r"                                  NL
+    ""                                       NL
+    "[/secret]"                              NL
+    "* ="                                    NL
+    "userA = rw"                             NL;
+
+  svn_repos__authz_cache_config_t cache_config = { NULL, 0 };
+  const char *sandbox, *authz_path;
+  apr_hash_t *dirents;
+  const char *cache_file;
+  svn_stringbuf_t *cached, *damaged;
+  svn_authz_t *authz;
+  svn_boolean_t access_granted;
+  svn_error_t *err;
+
+  SVN_ERR(svn_test_make_sandbox_dir(&sandbox, "authz-cache-dir", pool));
+  authz_path = svn_dirent_join(sandbox, "authz", pool);
+  SVN_ERR(svn_io_file_create(authz_path, rules, pool));
+
+  cache_config.cache_dir = svn_dirent_join(sandbox, "cache", pool);
+  svn_repos__authz_cache_config_set(&cache_config);
+
+  /* Reading the rules stores exactly one compiled model. */
+  err = svn_repos_authz_read3(&authz, authz_path, NULL, TRUE, NULL,
+                              pool, pool);
+  if (!err)
+    err = svn_io_get_dirents3(&dirents, cache_config.cache_dir, TRUE,
+                              pool, pool);
+  if (!err && apr_hash_count(dirents) != 1)
+    err = svn_error_create(SVN_ERR_TEST_FAILED, NULL,
+                           "Expected exactly one cached authz model");
+  if (err)
+    {
+      cache_config.cache_dir = NULL;
+      svn_repos__authz_cache_config_set(&cache_config);
+      return svn_error_trace(err);
+    }
+
+  cache_file = svn_dirent_join(cache_config.cache_dir,
+                               apr_hash_this_key(apr_hash_first(pool,
+                                                                dirents)),
+                               pool);
+  SVN_ERR(svn_stringbuf_from_file2(&cached, cache_file, pool));
+
+  /* Damage the cached model.  It must be detected, and the rules be parsed
+     and cached again. */
+  damaged = svn_stringbuf_dup(cached, pool);
+  damaged->data[damaged->len / 2] ^= 0x55;
+  SVN_ERR(svn_io_write_atomic2(cache_file, damaged->data, damaged->len,
+                               NULL, FALSE, pool));
+
+  err = svn_repos_authz_read3(&authz, authz_path, NULL, TRUE, NULL,
+                              pool, pool);
+  cache_config.cache_dir = NULL;
+  svn_repos__authz_cache_config_set(&cache_config);
+  SVN_ERR(err);
+
+  SVN_ERR(svn_repos_authz_check_access(authz, NULL, "/secret", "userB",
+                                       svn_authz_read, &access_granted,
+                                       pool));
+  SVN_TEST_ASSERT(!access_granted);
+  SVN_ERR(svn_repos_authz_check_access(authz, NULL, "/secret", "userA",
+                                       svn_authz_write, &access_granted,
+                                       pool));
+  SVN_TEST_ASSERT(access_granted);
+
+  SVN_ERR(svn_stringbuf_from_file2(&damaged, cache_file, pool));
+  SVN_TEST_ASSERT(svn_stringbuf_compare(damaged, cached));
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+test_authz_check_access_many(apr_pool_t *pool)
+{
+  const char rules[] =
+    "[groups]"                               NL
+    "devs = userA, userB"                    NL
+    ""                                       NL
+    "[/]"                                    NL
+    "* = r"                                  NL
+    ""                                       NL
+    "[repo:/trunk]"                          NL
+    "@devs = rw"                             NL
+    ""                                       NL
+    "[repo:/trunk/secret]"                   NL
+    "* ="                                    NL
+    "userB = rw"                             NL
+    ""                                       NL
+    "[repo:/trunk/secret/open]"              NL
+    "* = r"                                  NL
+    ""                                       NL
+    "[:glob:repo:/trunk/*.key]"              NL
+    "* ="                                    NL;
+
+  const char *users[] = { NULL, "userA", "userB", "userC" };
+  const char *repos[] = { "repo", "other" };
+  const svn_repos_authz_access_t accesses[] =
+    { svn_authz_read, svn_authz_write,
+      svn_authz_read | svn_authz_recursive };
+
+  /* Deliberately unsorted, with siblings, nested paths and duplicates. */
+  const char *path_list[] = { "/trunk/secret/open/x", "/trunk/b.key",
+                              "/trunk/a", "/", "/trunk/secret",
+                              "/trunk/secret/closed", "/trunk-1",
+                              "/trunk/a", "/trunk/secret/open",
+                              "/trunk/a.key", "/branches/x", NULL };
+  const int path_count = sizeof(path_list) / sizeof(path_list[0]);
+
+  svn_authz_t *authz, *batch_authz;
+  apr_array_header_t *paths = apr_array_make(pool, path_count,
+                                             sizeof(const char *));
+  svn_boolean_t *granted = apr_palloc(pool, path_count * sizeof(*granted));
+  apr_size_t u, r, a;
+  int i;
+
+  SVN_ERR(svn_repos_authz_parse(&authz,
+                                svn_stream_from_string(
+                                  svn_string_create(rules, pool), pool),
+                                NULL, pool));
+  SVN_ERR(svn_repos_authz_parse(&batch_authz,
+                                svn_stream_from_string(
+                                  svn_string_create(rules, pool), pool),
+                                NULL, pool));
+
+  for (i = 0; i < path_count; ++i)
+    APR_ARRAY_PUSH(paths, const char *) = path_list[i];
+
+  /* Batch lookups must make the same decisions as individual ones. */
+  for (u = 0; u < sizeof(users) / sizeof(users[0]); ++u)
+    for (r = 0; r < sizeof(repos) / sizeof(repos[0]); ++r)
+      for (a = 0; a < sizeof(accesses) / sizeof(accesses[0]); ++a)
+        {
+          SVN_ERR(svn_repos__authz_check_access_many(batch_authz, repos[r],
+                                                     paths, users[u],
+                                                     accesses[a], granted,
+                                                     pool));
+
+          for (i = 0; i < path_count; ++i)
+            {
+              svn_boolean_t expected;
+
+              SVN_ERR(svn_repos_authz_check_access(authz, repos[r],
+                                                   path_list[i], users[u],
+                                                   accesses[a], &expected,
+                                                   pool));
+              if (expected != granted[i])
+                return svn_error_createf(SVN_ERR_TEST_FAILED, NULL,
+                                         "Batch access %d to %s:%s for "
+                                         "user %s is %d instead of %d",
+                                         (int)accesses[a], repos[r],
+                                         path_list[i] ? path_list[i]
+                                                      : "(any)",
+                                         users[u] ? users[u] : "(anonymous)",
+                                         granted[i], expected);
+            }
+        }
+
+  return SVN_NO_ERROR;
+}
+
 static int max_threads = 4;
 
 static struct svn_test_descriptor_t test_funcs[] =
@@ -524,6 +779,12 @@ static struct svn_test_descriptor_t test_funcs[] =
                    "issue 4741 groups"),
     SVN_TEST_XFAIL2(reposful_reposless_stanzas_inherit,
                     "[foo:/] inherits [/]"),
+    SVN_TEST_PASS2(test_authz_serialize,
+                   "test svn_authz__serialize"),
+    SVN_TEST_PASS2(test_authz_cache_dir,
+                   "test the on-disk authz cache"),
+    SVN_TEST_PASS2(test_authz_check_access_many,
+                   "test svn_repos__authz_check_access_many"),
     SVN_TEST_NULL
   };
 
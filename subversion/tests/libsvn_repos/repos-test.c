@@ -39,7 +39,10 @@
 #include "svn_props.h"
 #include "svn_sorts.h"
 #include "svn_version.h"
+#include "svn_mergeinfo.h"
+#include "private/svn_diff_private.h"
 #include "private/svn_repos_private.h"
+#include "private/svn_sorts_private.h"
 #include "private/svn_dep_compat.h"
 
 /* be able to look into svn_config_t */
@@ -4430,6 +4433,104 @@ list_callback(const char *path,
 }
 
 
+static svn_error_t *
+test_update_delta_threads(const svn_test_opts_t *opts,
+                          apr_pool_t *pool)
+{
+  svn_repos_t *repos;
+  svn_fs_t *fs;
+  svn_fs_txn_t *txn;
+  svn_fs_root_t *txn_root;
+  svn_revnum_t youngest_rev;
+  const svn_delta_editor_t *editor;
+  void *edit_baton, *report_baton;
+  static svn_test__tree_entry_t expected_entries[] = {
+    { "iota",        "Changed file 'iota'.\n" },
+    { "A",           0 },
+    { "A/mu",        "This is the file 'mu'.\n" },
+    { "A/B",         0 },
+    { "A/B/lambda",  "Changed file 'lambda'.\n" },
+    { "A/B/E",       0 },
+    { "A/B/E/alpha", "This is the file 'alpha'.\n" },
+    { "A/B/E/beta",  "Changed file 'beta'.\n" },
+    { "A/B/F",       0 },
+    { "A/B/F/new",   "New file 'new'.\n" },
+    { "A/C",         0 },
+    { "A/D",         0 },
+    { "A/D/gamma",   "This is the file 'gamma'.\n" },
+    { "A/D/G",       0 },
+    { "A/D/G/pi",    "Changed file 'pi'.\n" },
+    { "A/D/G/rho",   "This is the file 'rho'.\n" },
+    { "A/D/G/tau",   "Changed file 'tau'.\n" },
+    { "A/D/H",       0 },
+    { "A/D/H/chi",   "This is the file 'chi'.\n" },
+    { "A/D/H/psi",   "This is the file 'psi'.\n" },
+    { "A/D/H/omega", "This is the file 'omega'.\n" }
+  };
+
+  SVN_ERR(svn_test__create_repos(&repos, "test-repo-update-delta-threads",
+                                 opts, pool));
+  fs = svn_repos_fs(repos);
+
+  /* r1: the greek tree. */
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, 0, pool));
+  SVN_ERR(svn_fs_txn_root(&txn_root, txn, pool));
+  SVN_ERR(svn_test__create_greek_tree(txn_root, pool));
+  SVN_ERR(svn_repos_fs_commit_txn(NULL, repos, &youngest_rev, txn, pool));
+
+  /* r2: change files at various depths and add one. */
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, youngest_rev, pool));
+  SVN_ERR(svn_fs_txn_root(&txn_root, txn, pool));
+  SVN_ERR(svn_test__set_file_contents(txn_root, "iota",
+                                      "Changed file 'iota'.\n", pool));
+  SVN_ERR(svn_test__set_file_contents(txn_root, "A/B/lambda",
+                                      "Changed file 'lambda'.\n", pool));
+  SVN_ERR(svn_test__set_file_contents(txn_root, "A/B/E/beta",
+                                      "Changed file 'beta'.\n", pool));
+  SVN_ERR(svn_fs_make_file(txn_root, "A/B/F/new", pool));
+  SVN_ERR(svn_test__set_file_contents(txn_root, "A/B/F/new",
+                                      "New file 'new'.\n", pool));
+  SVN_ERR(svn_test__set_file_contents(txn_root, "A/D/G/pi",
+                                      "Changed file 'pi'.\n", pool));
+  SVN_ERR(svn_test__set_file_contents(txn_root, "A/D/G/tau",
+                                      "Changed file 'tau'.\n", pool));
+  SVN_ERR(svn_repos_fs_commit_txn(NULL, repos, &youngest_rev, txn, pool));
+
+  /* Update from r1 to r2 with prefetched deltas.  Record the editor
+     commands in a txn based on r1, which must then match r2. */
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, 1, pool));
+  SVN_ERR(svn_fs_txn_root(&txn_root, txn, pool));
+  SVN_ERR(dir_delta_get_editor(&editor, &edit_baton, fs, txn_root, "",
+                               pool));
+
+  SVN_ERR(svn_repos_begin_report3(&report_baton, 2, repos, "/", "", NULL,
+                                  TRUE, svn_depth_infinity, FALSE, FALSE,
+                                  editor, edit_baton, NULL, NULL, 0, pool));
+  svn_repos__report_set_delta_threads(report_baton, 4);
+  SVN_ERR(svn_repos_set_path3(report_baton, "", 1, svn_depth_infinity,
+                              FALSE, NULL, pool));
+  SVN_ERR(svn_repos_finish_report(report_baton, pool));
+
+  SVN_ERR(svn_test__validate_tree(txn_root, expected_entries,
+                                  sizeof(expected_entries)
+                                    / sizeof(expected_entries[0]),
+                                  pool));
+  SVN_ERR(svn_fs_abort_txn(txn, pool));
+
+  /* A checkout without text deltas has the workers read the fulltexts
+     instead.  That must not disturb the editor drive either. */
+  SVN_ERR(svn_repos_begin_report3(&report_baton, 2, repos, "/", "", NULL,
+                                  FALSE, svn_depth_infinity, FALSE, FALSE,
+                                  svn_delta_default_editor(pool), NULL,
+                                  NULL, NULL, 0, pool));
+  svn_repos__report_set_delta_threads(report_baton, 4);
+  SVN_ERR(svn_repos_set_path3(report_baton, "", 0, svn_depth_infinity,
+                              TRUE, NULL, pool));
+  SVN_ERR(svn_repos_finish_report(report_baton, pool));
+
+  return SVN_NO_ERROR;
+}
+
 static svn_error_t *
 test_list(const svn_test_opts_t *opts,
           apr_pool_t *pool)
@@ -4466,6 +4567,452 @@ test_list(const svn_test_opts_t *opts,
   return SVN_NO_ERROR;
 }
 
+/* Implements svn_diff__blame_line_func_t.  Appends "REV:LINE" to the
+   array of strings BATON. */
+static svn_error_t *
+blame_callback(void *baton,
+               apr_int64_t line_no,
+               svn_revnum_t revision,
+               apr_hash_t *rev_props,
+               const char *line,
+               apr_pool_t *scratch_pool)
+{
+  apr_array_header_t *lines = baton;
+
+  SVN_TEST_ASSERT(line_no == lines->nelts);
+  SVN_TEST_ASSERT(SVN_IS_VALID_REVNUM(revision) == (rev_props != NULL));
+  APR_ARRAY_PUSH(lines, const char *)
+    = apr_psprintf(lines->pool, "%ld:%s", revision, line);
+
+  return SVN_NO_ERROR;
+}
+
+/* Blame "/iota" in REPOS from START to END and compare the result
+   with the EXPECTED "REV:LINE" strings. */
+static svn_error_t *
+check_blame(svn_repos_t *repos,
+            svn_revnum_t start,
+            svn_revnum_t end,
+            const char *expected[],
+            apr_pool_t *pool)
+{
+  apr_array_header_t *lines = apr_array_make(pool, 3, sizeof(const char *));
+  svn_diff__file_blame_t *blame;
+  int i;
+
+  SVN_ERR(svn_diff__file_blame_create(&blame, NULL, NULL, NULL, pool));
+  SVN_ERR(svn_repos__get_blame_fulltexts(repos, "/iota", start, end,
+                                         NULL, NULL,
+                                         svn_diff__file_blame_add, blame,
+                                         NULL, NULL, pool, pool));
+  SVN_ERR(svn_diff__file_blame_report(blame, blame_callback, lines, pool));
+
+  for (i = 0; expected[i]; i++)
+    {
+      SVN_TEST_ASSERT(i < lines->nelts);
+      SVN_TEST_STRING_ASSERT(APR_ARRAY_IDX(lines, i, const char *),
+                             expected[i]);
+    }
+  SVN_TEST_ASSERT(i == lines->nelts);
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+test_blame(const svn_test_opts_t *opts,
+           apr_pool_t *pool)
+{
+  svn_repos_t *repos;
+  svn_fs_t *fs;
+  svn_fs_txn_t *txn;
+  svn_fs_root_t *txn_root;
+  svn_revnum_t youngest_rev;
+  const char *blame_1_3[] = { "3:changed", "2:line 2", "3:line 3", NULL };
+  const char *blame_3_3[] = { "3:changed", "-1:line 2", "3:line 3", NULL };
+  const char *blame_1_2[] = { "1:This is the file 'iota'.", "2:line 2",
+                              NULL };
+
+  /* Create yet another greek tree repository. */
+  SVN_ERR(svn_test__create_repos(&repos, "test-repo-blame", opts, pool));
+  fs = svn_repos_fs(repos);
+
+  /* r1: the greek tree. */
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, 0, pool));
+  SVN_ERR(svn_fs_txn_root(&txn_root, txn, pool));
+  SVN_ERR(svn_test__create_greek_tree(txn_root, pool));
+  SVN_ERR(svn_repos_fs_commit_txn(NULL, repos, &youngest_rev, txn, pool));
+  SVN_TEST_ASSERT(SVN_IS_VALID_REVNUM(youngest_rev));
+
+  /* r2: append a line to iota. */
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, youngest_rev, pool));
+  SVN_ERR(svn_fs_txn_root(&txn_root, txn, pool));
+  SVN_ERR(svn_test__set_file_contents(txn_root, "iota",
+                                      "This is the file 'iota'.\n"
+                                      "line 2\n", pool));
+  SVN_ERR(svn_repos_fs_commit_txn(NULL, repos, &youngest_rev, txn, pool));
+
+  /* r3: replace the first line and append another one. */
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, youngest_rev, pool));
+  SVN_ERR(svn_fs_txn_root(&txn_root, txn, pool));
+  SVN_ERR(svn_test__set_file_contents(txn_root, "iota",
+                                      "changed\n"
+                                      "line 2\n"
+                                      "line 3\n", pool));
+  SVN_ERR(svn_repos_fs_commit_txn(NULL, repos, &youngest_rev, txn, pool));
+  SVN_TEST_ASSERT(youngest_rev == 3);
+
+  SVN_ERR(check_blame(repos, 1, 3, blame_1_3, pool));
+  SVN_ERR(check_blame(repos, 3, 3, blame_3_3, pool));
+  SVN_ERR(check_blame(repos, 1, 2, blame_1_2, pool));
+
+  /* Reverse blames are not supported. */
+  SVN_TEST_ASSERT_ERROR(check_blame(repos, 3, 1, blame_1_3, pool),
+                        SVN_ERR_UNSUPPORTED_FEATURE);
+
+  return SVN_NO_ERROR;
+}
+
+/* Implements svn_repos_history_func_t, appending " PATH@REVISION" to
+   the svn_stringbuf_t BATON. */
+static svn_error_t *
+history_to_string(void *baton,
+                  const char *path,
+                  svn_revnum_t revision,
+                  apr_pool_t *pool)
+{
+  svn_stringbuf_t *buf = baton;
+
+  svn_stringbuf_appendcstr(buf, apr_psprintf(pool, " %s@%ld",
+                                             path, revision));
+  return SVN_NO_ERROR;
+}
+
+/* Implements svn_log_entry_receiver_t, appending " rREVISION" to the
+   svn_stringbuf_t BATON. */
+static svn_error_t *
+log_to_string(void *baton,
+              svn_log_entry_t *log_entry,
+              apr_pool_t *pool)
+{
+  svn_stringbuf_t *buf = baton;
+
+  svn_stringbuf_appendcstr(buf, apr_psprintf(pool, " r%ld",
+                                             log_entry->revision));
+  return SVN_NO_ERROR;
+}
+
+/* Set *DESCRIPTION to a string listing the history of each of the
+   NULL-terminated PATHS in REPOS, as reported by svn_repos_history2() and
+   by the log functions, both with and without following copies. */
+static svn_error_t *
+describe_histories(const char **description,
+                   svn_repos_t *repos,
+                   const char *paths[],
+                   apr_pool_t *pool)
+{
+  svn_stringbuf_t *buf = svn_stringbuf_create_empty(pool);
+  svn_revnum_t youngest_rev;
+  int i, strict;
+
+  SVN_ERR(svn_fs_youngest_rev(&youngest_rev, svn_repos_fs(repos), pool));
+
+  for (i = 0; paths[i]; i++)
+    for (strict = 0; strict < 2; strict++)
+      {
+        apr_array_header_t *targets = apr_array_make(pool, 1,
+                                                     sizeof(const char *));
+
+        APR_ARRAY_PUSH(targets, const char *) = paths[i];
+        svn_stringbuf_appendcstr(buf, apr_psprintf(pool, "\n%s%s:", paths[i],
+                                                   strict ? " (strict)"
+                                                          : ""));
+        SVN_ERR(svn_repos_history2(svn_repos_fs(repos), paths[i],
+                                   history_to_string, buf, NULL, NULL,
+                                   0, youngest_rev, !strict, pool));
+        svn_stringbuf_appendcstr(buf, " |");
+        SVN_ERR(svn_repos__get_logs_compat(repos, targets, youngest_rev, 0,
+                                           0, FALSE, strict, FALSE, NULL,
+                                           NULL, NULL, log_to_string, buf,
+                                           pool));
+      }
+  svn_stringbuf_appendcstr(buf, "\n");
+
+  *description = buf->data;
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+test_log_index(const svn_test_opts_t *opts,
+               apr_pool_t *pool)
+{
+  svn_repos_t *repos;
+  svn_fs_t *fs;
+  svn_fs_txn_t *txn;
+  svn_fs_root_t *txn_root, *rev_root;
+  svn_revnum_t youngest_rev;
+  const char *without_index, *with_index;
+  const char *paths[] = { "/iota", "/A", "/A/B/lambda", "/A/D/gamma",
+                          "/A2", "/A2/B", "/A2/B/lambda", "/A2/B/new",
+                          "/A2/D/G/pi", NULL };
+
+  /* Create yet another greek tree repository. */
+  SVN_ERR(svn_test__create_repos(&repos, "test-repo-log-index", opts, pool));
+  fs = svn_repos_fs(repos);
+
+  /* r1: the greek tree. */
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, 0, pool));
+  SVN_ERR(svn_fs_txn_root(&txn_root, txn, pool));
+  SVN_ERR(svn_test__create_greek_tree(txn_root, pool));
+  SVN_ERR(svn_repos_fs_commit_txn(NULL, repos, &youngest_rev, txn, pool));
+  SVN_TEST_ASSERT(SVN_IS_VALID_REVNUM(youngest_rev));
+
+  /* r2: modify A/B/lambda. */
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, youngest_rev, pool));
+  SVN_ERR(svn_fs_txn_root(&txn_root, txn, pool));
+  SVN_ERR(svn_test__set_file_contents(txn_root, "A/B/lambda",
+                                      "changed in r2\n", pool));
+  SVN_ERR(svn_repos_fs_commit_txn(NULL, repos, &youngest_rev, txn, pool));
+
+  /* r3: copy A to A2. */
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, youngest_rev, pool));
+  SVN_ERR(svn_fs_txn_root(&txn_root, txn, pool));
+  SVN_ERR(svn_fs_revision_root(&rev_root, fs, youngest_rev, pool));
+  SVN_ERR(svn_fs_copy(rev_root, "A", txn_root, "A2", pool));
+  SVN_ERR(svn_repos_fs_commit_txn(NULL, repos, &youngest_rev, txn, pool));
+
+  /* r4: modify A2/B/lambda and A/D/gamma. */
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, youngest_rev, pool));
+  SVN_ERR(svn_fs_txn_root(&txn_root, txn, pool));
+  SVN_ERR(svn_test__set_file_contents(txn_root, "A2/B/lambda",
+                                      "changed in r4\n", pool));
+  SVN_ERR(svn_test__set_file_contents(txn_root, "A/D/gamma",
+                                      "changed in r4\n", pool));
+  SVN_ERR(svn_repos_fs_commit_txn(NULL, repos, &youngest_rev, txn, pool));
+
+  /* r5: delete A2/B/E and add A2/B/new. */
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, youngest_rev, pool));
+  SVN_ERR(svn_fs_txn_root(&txn_root, txn, pool));
+  SVN_ERR(svn_fs_delete(txn_root, "A2/B/E", pool));
+  SVN_ERR(svn_fs_make_file(txn_root, "A2/B/new", pool));
+  SVN_ERR(svn_repos_fs_commit_txn(NULL, repos, &youngest_rev, txn, pool));
+
+  /* r6: replace A2/B/lambda with a copy of iota. */
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, youngest_rev, pool));
+  SVN_ERR(svn_fs_txn_root(&txn_root, txn, pool));
+  SVN_ERR(svn_fs_revision_root(&rev_root, fs, youngest_rev, pool));
+  SVN_ERR(svn_fs_delete(txn_root, "A2/B/lambda", pool));
+  SVN_ERR(svn_fs_copy(rev_root, "iota", txn_root, "A2/B/lambda", pool));
+  SVN_ERR(svn_repos_fs_commit_txn(NULL, repos, &youngest_rev, txn, pool));
+
+  /* r7: modify A2/B/lambda again. */
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, youngest_rev, pool));
+  SVN_ERR(svn_fs_txn_root(&txn_root, txn, pool));
+  SVN_ERR(svn_test__set_file_contents(txn_root, "A2/B/lambda",
+                                      "changed in r7\n", pool));
+  SVN_ERR(svn_repos_fs_commit_txn(NULL, repos, &youngest_rev, txn, pool));
+  SVN_TEST_ASSERT(youngest_rev == 7);
+
+  /* The index must not change what we report. */
+  SVN_ERR(describe_histories(&without_index, repos, paths, pool));
+  SVN_ERR(svn_repos__log_index_sync(fs, TRUE, 0, NULL, NULL, pool));
+  SVN_ERR(describe_histories(&with_index, repos, paths, pool));
+  SVN_TEST_STRING_ASSERT(with_index, without_index);
+  SVN_TEST_ASSERT(strstr(with_index,
+                         "\n/A2/B/lambda (strict): /A2/B/lambda@7"
+                         " /A2/B/lambda@6 | r7 r6\n"));
+
+  /* r8: modify A2/D/G/pi.  The commit updates the index. */
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, youngest_rev, pool));
+  SVN_ERR(svn_fs_txn_root(&txn_root, txn, pool));
+  SVN_ERR(svn_test__set_file_contents(txn_root, "A2/D/G/pi",
+                                      "changed in r8\n", pool));
+  SVN_ERR(svn_repos_fs_commit_txn(NULL, repos, &youngest_rev, txn, pool));
+
+  SVN_ERR(describe_histories(&with_index, repos, paths, pool));
+  SVN_TEST_ASSERT(strstr(with_index,
+                         "\n/A2/D/G/pi: /A2/D/G/pi@8 /A2/D/G/pi@3"
+                         " /A/D/G/pi@1 | r8 r3 r1\n"));
+
+  /* r9 and r10: modify iota behind the index's back. */
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, youngest_rev, pool));
+  SVN_ERR(svn_fs_txn_root(&txn_root, txn, pool));
+  SVN_ERR(svn_test__set_file_contents(txn_root, "iota",
+                                      "changed in r9\n", pool));
+  SVN_ERR(svn_fs_commit_txn(NULL, &youngest_rev, txn, pool));
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, youngest_rev, pool));
+  SVN_ERR(svn_fs_txn_root(&txn_root, txn, pool));
+  SVN_ERR(svn_test__set_file_contents(txn_root, "iota",
+                                      "changed in r10\n", pool));
+  SVN_ERR(svn_fs_commit_txn(NULL, &youngest_rev, txn, pool));
+  SVN_TEST_ASSERT(youngest_rev == 10);
+
+  /* Catching up in bounded steps leaves a consistent index. */
+  SVN_ERR(svn_repos__log_index_sync(fs, FALSE, 1, NULL, NULL, pool));
+  SVN_ERR(describe_histories(&with_index, repos, paths, pool));
+  SVN_TEST_ASSERT(strstr(with_index,
+                         "\n/iota: /iota@10 /iota@9 /iota@1"
+                         " | r10 r9 r1\n"));
+
+  SVN_ERR(svn_repos__log_index_sync(fs, FALSE, 0, NULL, NULL, pool));
+  SVN_ERR(describe_histories(&without_index, repos, paths, pool));
+  SVN_TEST_STRING_ASSERT(with_index, without_index);
+
+  return SVN_NO_ERROR;
+}
+
+/* Implements svn_repos_mergeinfo_receiver_t, adding PATH and the string
+   form of MERGEINFO to the apr_hash_t BATON. */
+static svn_error_t *
+mergeinfo_to_hash(const char *path,
+                  svn_mergeinfo_t mergeinfo,
+                  void *baton,
+                  apr_pool_t *scratch_pool)
+{
+  apr_hash_t *hash = baton;
+  apr_pool_t *hash_pool = apr_hash_pool_get(hash);
+  svn_string_t *mergeinfo_str;
+
+  SVN_ERR(svn_mergeinfo_to_string(&mergeinfo_str, mergeinfo, hash_pool));
+  svn_hash_sets(hash, apr_pstrdup(hash_pool, path), mergeinfo_str->data);
+
+  return SVN_NO_ERROR;
+}
+
+/* Set *DESCRIPTION to a string listing the mergeinfo of PATH and its
+   descendants in every revision of REPOS, followed by the merge-aware log
+   of PATH. */
+static svn_error_t *
+describe_mergeinfo(const char **description,
+                   svn_repos_t *repos,
+                   const char *path,
+                   apr_pool_t *pool)
+{
+  svn_stringbuf_t *buf = svn_stringbuf_create_empty(pool);
+  apr_array_header_t *paths = apr_array_make(pool, 1, sizeof(const char *));
+  svn_revnum_t youngest_rev;
+  svn_revnum_t rev;
+
+  SVN_ERR(svn_fs_youngest_rev(&youngest_rev, svn_repos_fs(repos), pool));
+  APR_ARRAY_PUSH(paths, const char *) = path;
+
+  for (rev = 1; rev <= youngest_rev; rev++)
+    {
+      apr_hash_t *mergeinfo = apr_hash_make(pool);
+      apr_array_header_t *sorted;
+      int i;
+
+      SVN_ERR(svn_repos_fs_get_mergeinfo2(repos, paths, rev,
+                                          svn_mergeinfo_inherited, TRUE,
+                                          NULL, NULL,
+                                          mergeinfo_to_hash, mergeinfo,
+                                          pool));
+
+      svn_stringbuf_appendcstr(buf, apr_psprintf(pool, "\nr%ld:", rev));
+      sorted = svn_sort__hash(mergeinfo, svn_sort_compare_items_as_paths,
+                              pool);
+      for (i = 0; i < sorted->nelts; i++)
+        {
+          svn_sort__item_t item = APR_ARRAY_IDX(sorted, i, svn_sort__item_t);
+
+          svn_stringbuf_appendcstr(buf, apr_psprintf(pool, " %s=%s",
+                                                     (const char *)item.key,
+                                                     (const char *)item.value));
+        }
+    }
+
+  svn_stringbuf_appendcstr(buf, "\nlog -g:");
+  SVN_ERR(svn_repos__get_logs_compat(repos, paths, youngest_rev, 0,
+                                     0, FALSE, FALSE, TRUE, NULL,
+                                     NULL, NULL, log_to_string, buf,
+                                     pool));
+  svn_stringbuf_appendcstr(buf, "\n");
+
+  *description = buf->data;
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+test_mergeinfo_index(const svn_test_opts_t *opts,
+                     apr_pool_t *pool)
+{
+  svn_repos_t *repos;
+  svn_fs_t *fs;
+  svn_fs_txn_t *txn;
+  svn_fs_root_t *txn_root, *rev_root;
+  svn_revnum_t youngest_rev;
+  const char *without_index, *with_index;
+
+  /* Create yet another greek tree repository. */
+  SVN_ERR(svn_test__create_repos(&repos, "test-repo-mergeinfo-index", opts,
+                                 pool));
+  fs = svn_repos_fs(repos);
+
+  /* r1: the greek tree. */
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, 0, pool));
+  SVN_ERR(svn_fs_txn_root(&txn_root, txn, pool));
+  SVN_ERR(svn_test__create_greek_tree(txn_root, pool));
+  SVN_ERR(svn_repos_fs_commit_txn(NULL, repos, &youngest_rev, txn, pool));
+  SVN_TEST_ASSERT(SVN_IS_VALID_REVNUM(youngest_rev));
+
+  /* r2: copy A to A2. */
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, youngest_rev, pool));
+  SVN_ERR(svn_fs_txn_root(&txn_root, txn, pool));
+  SVN_ERR(svn_fs_revision_root(&rev_root, fs, youngest_rev, pool));
+  SVN_ERR(svn_fs_copy(rev_root, "A", txn_root, "A2", pool));
+  SVN_ERR(svn_repos_fs_commit_txn(NULL, repos, &youngest_rev, txn, pool));
+
+  /* r3: modify A/mu. */
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, youngest_rev, pool));
+  SVN_ERR(svn_fs_txn_root(&txn_root, txn, pool));
+  SVN_ERR(svn_test__set_file_contents(txn_root, "A/mu",
+                                      "changed in r3\n", pool));
+  SVN_ERR(svn_repos_fs_commit_txn(NULL, repos, &youngest_rev, txn, pool));
+
+  /* r4: merge r3 into A2. */
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, youngest_rev, pool));
+  SVN_ERR(svn_fs_txn_root(&txn_root, txn, pool));
+  SVN_ERR(svn_test__set_file_contents(txn_root, "A2/mu",
+                                      "changed in r3\n", pool));
+  SVN_ERR(svn_fs_change_node_prop(txn_root, "A2", SVN_PROP_MERGEINFO,
+                                  svn_string_create("/A:3", pool), pool));
+  SVN_ERR(svn_repos_fs_commit_txn(NULL, repos, &youngest_rev, txn, pool));
+
+  /* r5: give A2/B mergeinfo of its own. */
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, youngest_rev, pool));
+  SVN_ERR(svn_fs_txn_root(&txn_root, txn, pool));
+  SVN_ERR(svn_fs_change_node_prop(txn_root, "A2/B", SVN_PROP_MERGEINFO,
+                                  svn_string_create("/A/B:3", pool), pool));
+  SVN_ERR(svn_repos_fs_commit_txn(NULL, repos, &youngest_rev, txn, pool));
+
+  /* r6: copy A2 to A3, mergeinfo and all. */
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, youngest_rev, pool));
+  SVN_ERR(svn_fs_txn_root(&txn_root, txn, pool));
+  SVN_ERR(svn_fs_revision_root(&rev_root, fs, youngest_rev, pool));
+  SVN_ERR(svn_fs_copy(rev_root, "A2", txn_root, "A3", pool));
+  SVN_ERR(svn_repos_fs_commit_txn(NULL, repos, &youngest_rev, txn, pool));
+
+  /* r7: delete A3/B and drop the mergeinfo of A2. */
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, youngest_rev, pool));
+  SVN_ERR(svn_fs_txn_root(&txn_root, txn, pool));
+  SVN_ERR(svn_fs_delete(txn_root, "A3/B", pool));
+  SVN_ERR(svn_fs_change_node_prop(txn_root, "A2", SVN_PROP_MERGEINFO,
+                                  NULL, pool));
+  SVN_ERR(svn_repos_fs_commit_txn(NULL, repos, &youngest_rev, txn, pool));
+  SVN_TEST_ASSERT(youngest_rev == 7);
+
+  /* The index must not change what we report. */
+  SVN_ERR(describe_mergeinfo(&without_index, repos, "/", pool));
+  SVN_ERR(svn_repos__log_index_sync(fs, TRUE, 0, NULL, NULL, pool));
+  SVN_ERR(describe_mergeinfo(&with_index, repos, "/", pool));
+  SVN_TEST_STRING_ASSERT(with_index, without_index);
+  SVN_TEST_ASSERT(strstr(with_index,
+                         "\nr6: /A2=/A:3 /A2/B=/A/B:3 /A3=/A:3"
+                         " /A3/B=/A/B:3\n"));
+  SVN_TEST_ASSERT(strstr(with_index, "\nr7: /A3=/A:3\n"));
+
+  return SVN_NO_ERROR;
+}
+
 /* The test table.  */
 
 static int max_threads = 4;
@@ -4535,8 +5082,16 @@ static struct svn_test_descriptor_t test_funcs[] =
                    "test the different types of authz wildcards"),
     SVN_TEST_SKIP2(test_authz_wildcard_performance, TRUE,
                    "optional authz wildcard performance test"),
+    SVN_TEST_OPTS_PASS(test_update_delta_threads,
+                       "test update reports with delta threads"),
     SVN_TEST_OPTS_PASS(test_list,
                        "test svn_repos_list"),
+    SVN_TEST_OPTS_PASS(test_blame,
+                       "test blaming within the repository"),
+    SVN_TEST_OPTS_PASS(test_log_index,
+                       "test the log index"),
+    SVN_TEST_OPTS_PASS(test_mergeinfo_index,
+                       "test the mergeinfo part of the log index"),
     SVN_TEST_NULL
   };
 
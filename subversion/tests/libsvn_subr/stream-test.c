@@ -870,6 +870,55 @@ test_stream_checksum(apr_pool_t *pool)
   return SVN_NO_ERROR;
 }
 
+static svn_error_t *
+test_stream_multi_checksum(apr_pool_t *pool)
+{
+  const char *data = "The quick brown fox jumps over the lazy dog";
+  const svn_checksum_kind_t kinds[2] = { svn_checksum_md5,
+                                         svn_checksum_sha1 };
+  svn_checksum_t *md5;
+  svn_checksum_t *sha1;
+  svn_checksum_t **checksums[2];
+  svn_filesize_t size;
+  svn_stringbuf_t *buf = svn_stringbuf_create_empty(pool);
+  svn_stream_t *stream;
+  apr_size_t len;
+
+  checksums[0] = &md5;
+  checksums[1] = &sha1;
+
+  /* Write in two chunks. */
+  stream = svn_stream__checksummed(svn_stream_from_stringbuf(buf, pool),
+                                   checksums, kinds, 2, &size, FALSE, pool);
+  len = 10;
+  SVN_ERR(svn_stream_write(stream, data, &len));
+  SVN_ERR(svn_stream_puts(stream, data + 10));
+  SVN_ERR(svn_stream_close(stream));
+
+  SVN_TEST_STRING_ASSERT(buf->data, data);
+  SVN_TEST_ASSERT(size == (svn_filesize_t)strlen(data));
+  SVN_TEST_STRING_ASSERT("9e107d9d372bb6826bd81d3542a419d6",
+                         svn_checksum_to_cstring(md5, pool));
+  SVN_TEST_STRING_ASSERT("2fd4e1c67a2d28fced849ee1bb76e7391b93eb12",
+                         svn_checksum_to_cstring(sha1, pool));
+
+  /* Read, letting close drain the remaining data. */
+  md5 = sha1 = NULL;
+  stream = svn_stream__checksummed(svn_stream_from_stringbuf(buf, pool),
+                                   checksums, kinds, 2, &size, TRUE, pool);
+  len = 4;
+  SVN_ERR(svn_stream_read_full(stream, apr_palloc(pool, len), &len));
+  SVN_ERR(svn_stream_close(stream));
+
+  SVN_TEST_ASSERT(size == (svn_filesize_t)strlen(data));
+  SVN_TEST_STRING_ASSERT("9e107d9d372bb6826bd81d3542a419d6",
+                         svn_checksum_to_cstring(md5, pool));
+  SVN_TEST_STRING_ASSERT("2fd4e1c67a2d28fced849ee1bb76e7391b93eb12",
+                         svn_checksum_to_cstring(sha1, pool));
+
+  return SVN_NO_ERROR;
+}
+
 static svn_error_t *
 test_stream_readline_file(const char *testname,
                           const char *eol,
@@ -1033,6 +1082,8 @@ static struct svn_test_descriptor_t test_funcs[] =
                    "test compression for streams without partial read"),
     SVN_TEST_PASS2(test_stream_checksum,
                    "test svn_stream_contents_checksum()"),
+    SVN_TEST_PASS2(test_stream_multi_checksum,
+                   "test svn_stream__checksummed()"),
     SVN_TEST_PASS2(test_stream_readline_file_lf,
                    "test reading LF-terminated lines from file"),
     SVN_TEST_PASS2(test_stream_readline_file_crlf,
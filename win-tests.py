@@ -312,6 +312,9 @@ if fs_type == 'bdb':
 else:
   all_tests = gen_obj.test_progs + gen_obj.scripts
 
+if 'serf' in gen_obj._libraries:
+  all_tests = all_tests + gen_obj.serf_test_progs
+
 client_tests = [x for x in all_tests if x.startswith(CMDLINE_TEST_SCRIPT_PATH)]
 
 if run_httpd: